@@ -2916,6 +2916,7 @@ struct request_queue *blk_mq_init_allocated_queue(struct blk_mq_tag_set *set,
 	 * Default to classic polling
 	 */
 	q->poll_nsec = BLK_MQ_POLL_CLASSIC;
+	q->poll_hybrid_pct = CONFIG_BLK_MQ_POLL_HYBRID_PCT;
 
 	blk_mq_init_cpu_queues(q, set->nr_hw_queues);
 	blk_mq_add_queue_tag_set(set, q);
@@ -3374,24 +3375,64 @@ static unsigned long blk_mq_poll_nsecs(struct request_queue *q,
 		return 0;
 
 	/*
-	 * As an optimistic guess, use half of the mean service time
-	 * for this type of request. We can (and should) make this smarter.
-	 * For instance, if the completion latencies are tight, we can
-	 * get closer than just half the mean. This is especially
-	 * important on devices where the completion latencies are longer
-	 * than ~10 usec. We do use the stats for the relevant IO size
-	 * if available which does lead to better estimates.
+	 * Sleep for poll_hybrid_pct of the mean service time for this type
+	 * of request, less the time the hrtimer usually wakes us up late.
+	 * Both are calibrated in blk_mq_poll_hybrid_calibrate(), so tight
+	 * completion latencies let us get closer than half the mean. We do
+	 * use the stats for the relevant IO size if available which does
+	 * lead to better estimates.
 	 */
 	bucket = blk_mq_poll_stats_bkt(rq);
 	if (bucket < 0)
 		return ret;
 
-	if (q->poll_stat[bucket].nr_samples)
-		ret = (q->poll_stat[bucket].mean + 1) / 2;
+	if (q->poll_stat[bucket].nr_samples) {
+		unsigned int lat = READ_ONCE(q->poll_wake_lat_ns);
+
+		ret = div_u64(q->poll_stat[bucket].mean *
+			      READ_ONCE(q->poll_hybrid_pct), 100);
+		ret = ret > lat ? ret - lat : 0;
+	}
 
 	return ret;
 }
 
+#define BLK_MQ_POLL_HYBRID_PCT_MIN	10
+#define BLK_MQ_POLL_HYBRID_PCT_MAX	95
+#define BLK_MQ_POLL_WAKE_LAT_MAX	(50 * NSEC_PER_USEC)
+
+/*
+ * Adjust the adaptive hybrid sleep after a request has slept. The wakeup
+ * lateness of the hrtimer is averaged, and the sleep target moves down
+ * quickly when the request had already completed by the time we woke up
+ * and up slowly when we still had to spin, so that most requests are
+ * caught just before they complete.
+ */
+static void blk_mq_poll_hybrid_calibrate(struct request_queue *q,
+					 struct blk_mq_hw_ctx *hctx,
+					 struct request *rq, ktime_t expires,
+					 bool timer_fired)
+{
+	unsigned int pct = READ_ONCE(q->poll_hybrid_pct);
+	s64 late = ktime_to_ns(ktime_sub(ktime_get(), expires));
+
+	if (timer_fired && late > 0) {
+		unsigned int lat = READ_ONCE(q->poll_wake_lat_ns);
+
+		late = min_t(s64, late, BLK_MQ_POLL_WAKE_LAT_MAX);
+		WRITE_ONCE(q->poll_wake_lat_ns, (lat * 7 + late) / 8);
+	}
+
+	if (blk_mq_rq_state(rq) == MQ_RQ_IN_FLIGHT)
+		q->mq_ops->poll(hctx);
+
+	if (blk_mq_rq_state(rq) != MQ_RQ_IN_FLIGHT)
+		pct = max_t(int, pct - 4, BLK_MQ_POLL_HYBRID_PCT_MIN);
+	else
+		pct = min(pct + 1, BLK_MQ_POLL_HYBRID_PCT_MAX);
+	WRITE_ONCE(q->poll_hybrid_pct, pct);
+}
+
 static bool blk_mq_poll_hybrid_sleep(struct request_queue *q,
 				     struct blk_mq_hw_ctx *hctx,
 				     struct request *rq)
@@ -3442,6 +3483,12 @@ static bool blk_mq_poll_hybrid_sleep(struct request_queue *q,
 	} while (hs.task && !signal_pending(current));
 
 	__set_current_state(TASK_RUNNING);
+
+	if (q->poll_nsec == 0)
+		blk_mq_poll_hybrid_calibrate(q, hctx, rq,
+					     hrtimer_get_expires(&hs.timer),
+					     !hs.task);
+
 	destroy_hrtimer_on_stack(&hs.timer);
 	return true;
 }
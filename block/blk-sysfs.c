@@ -390,6 +390,32 @@ static ssize_t queue_poll_delay_store(struct request_queue *q, const char *page,
 	return count;
 }
 
+static ssize_t queue_poll_hybrid_pct_show(struct request_queue *q,
+					  char *page)
+{
+	return queue_var_show(READ_ONCE(q->poll_hybrid_pct), page);
+}
+
+static ssize_t queue_poll_hybrid_pct_store(struct request_queue *q,
+					   const char *page, size_t count)
+{
+	unsigned long val;
+	ssize_t ret;
+
+	if (!q->mq_ops || !q->mq_ops->poll)
+		return -EINVAL;
+
+	ret = queue_var_store(&val, page, count);
+	if (ret < 0)
+		return ret;
+
+	if (val < 10 || val > 95)
+		return -EINVAL;
+
+	WRITE_ONCE(q->poll_hybrid_pct, val);
+	return ret;
+}
+
 static ssize_t queue_poll_show(struct request_queue *q, char *page)
 {
 	return queue_var_show(test_bit(QUEUE_FLAG_POLL, &q->queue_flags), page);
@@ -691,6 +717,12 @@ static struct queue_sysfs_entry queue_poll_delay_entry = {
 	.store = queue_poll_delay_store,
 };
 
+static struct queue_sysfs_entry queue_poll_hybrid_pct_entry = {
+	.attr = {.name = "io_poll_hybrid_pct", .mode = 0644 },
+	.show = queue_poll_hybrid_pct_show,
+	.store = queue_poll_hybrid_pct_store,
+};
+
 static struct queue_sysfs_entry queue_wc_entry = {
 	.attr = {.name = "write_cache", .mode = 0644 },
 	.show = queue_wc_show,
@@ -762,6 +794,7 @@ static struct attribute *queue_attrs[] = {
 	&queue_dax_entry.attr,
 	&queue_wb_lat_entry.attr,
 	&queue_poll_delay_entry.attr,
+	&queue_poll_hybrid_pct_entry.attr,
 	&queue_io_timeout_entry.attr,
 #ifdef CONFIG_BLK_DEV_THROTTLING_LOW
 	&throtl_sample_time_entry.attr,
@@ -25,6 +25,18 @@
 #define AHCI_VEND_PAXIC 0xC0
 #define AHCI_VEND_PTC   0xC8
 
+/* Command Completion Coalescing registers */
+#define AHCI_CCC_CTL	0x14
+#define AHCI_CCC_PORTS	0x18
+
+#define CCC_CTL_EN		BIT(0)
+#define CCC_CTL_INT_SHIFT	3
+#define CCC_CTL_INT_MASK	(0x1F << CCC_CTL_INT_SHIFT)
+#define CCC_CTL_CC(c)		((c) << 8)
+#define CCC_CTL_TV(t)		((t) << 16)
+#define CCC_CC_MAX		0xFF
+#define CCC_TV_MAX		0xFFFF
+
 /* Vendor Specific Register bit definitions */
 #define PAXIC_ADBW_BW64 0x1
 #define PAXIC_MAWID(i)	(((i) * 2) << 4)
@@ -85,8 +97,13 @@ struct ceva_ahci_priv {
 	u32 pp5c[NR_PORTS];
 	/* Axi Cache Control Register */
 	u32 axicc;
+	bool has_axicc;
 	bool is_cci_enabled;
 	int flags;
+	/* Command Completion Coalescing */
+	u32 ccc_irq;
+	u32 ccc_count;
+	u32 ccc_timeout;
 };
 
 static unsigned int ceva_ahci_read_id(struct ata_device *dev,
@@ -106,6 +123,154 @@ static unsigned int ceva_ahci_read_id(struct ata_device *dev,
 	return 0;
 }
 
+/*
+ * The ports in the Command Completion Coalescing set don't raise their bit of
+ * the interrupt status, the HBA raises the CCC one once enough commands
+ * completed or the CCC timeout expired. Handle all the ports then.
+ */
+static irqreturn_t ceva_ahci_irq_intr(int irq, void *dev_instance)
+{
+	struct ata_host *host = dev_instance;
+	struct ahci_host_priv *hpriv = host->private_data;
+	struct ceva_ahci_priv *cevapriv = hpriv->plat_data;
+	void __iomem *mmio = hpriv->mmio;
+	u32 irq_stat, irq_masked;
+	unsigned int rc;
+
+	irq_stat = readl(mmio + HOST_IRQ_STAT);
+	if (!irq_stat)
+		return IRQ_NONE;
+
+	irq_masked = irq_stat & hpriv->port_map;
+
+	spin_lock(&host->lock);
+
+	if (irq_stat & cevapriv->ccc_irq)
+		irq_masked = hpriv->port_map;
+
+	rc = ahci_handle_port_intr(host, irq_masked);
+
+	/* Clear the latch after the port events, see libahci */
+	writel(irq_stat, mmio + HOST_IRQ_STAT);
+
+	spin_unlock(&host->lock);
+
+	return IRQ_RETVAL(rc);
+}
+
+/**
+ * ceva_ahci_set_ccc - Program the Command Completion Coalescing
+ * @hpriv: AHCI host private data
+ *
+ * Coalescing is off when ccc_count is 0. An HBA reset clears the CCC
+ * registers, so this is called again once the host is reset. Called with
+ * the host lock held.
+ */
+static void ceva_ahci_set_ccc(struct ahci_host_priv *hpriv)
+{
+	struct ceva_ahci_priv *cevapriv = hpriv->plat_data;
+	void __iomem *mmio = hpriv->mmio;
+	u32 ctl;
+
+	/* The count and timeout can only be changed with CCC disabled */
+	ctl = readl(mmio + AHCI_CCC_CTL) & CCC_CTL_INT_MASK;
+	writel(ctl, mmio + AHCI_CCC_CTL);
+
+	if (!cevapriv->ccc_count) {
+		cevapriv->ccc_irq = 0;
+		return;
+	}
+
+	cevapriv->ccc_irq = BIT(ctl >> CCC_CTL_INT_SHIFT);
+
+	writel(hpriv->port_map, mmio + AHCI_CCC_PORTS);
+	ctl |= CCC_CTL_TV(cevapriv->ccc_timeout) |
+	       CCC_CTL_CC(cevapriv->ccc_count) | CCC_CTL_EN;
+	writel(ctl, mmio + AHCI_CCC_CTL);
+}
+
+static ssize_t ceva_ahci_ccc_store(struct device *dev, const char *buf,
+				   size_t count, u32 *param, u32 min, u32 max)
+{
+	struct ata_host *host = dev_get_drvdata(dev);
+	struct ahci_host_priv *hpriv = host->private_data;
+	unsigned long flags;
+	u32 val;
+	int ret;
+
+	ret = kstrtou32(buf, 0, &val);
+	if (ret)
+		return ret;
+
+	if (val < min || val > max)
+		return -EINVAL;
+
+	spin_lock_irqsave(&host->lock, flags);
+	*param = val;
+	ceva_ahci_set_ccc(hpriv);
+	spin_unlock_irqrestore(&host->lock, flags);
+
+	return count;
+}
+
+static ssize_t ccc_count_show(struct device *dev,
+			      struct device_attribute *attr, char *buf)
+{
+	struct ata_host *host = dev_get_drvdata(dev);
+	struct ahci_host_priv *hpriv = host->private_data;
+	struct ceva_ahci_priv *cevapriv = hpriv->plat_data;
+
+	return sprintf(buf, "%u\n", cevapriv->ccc_count);
+}
+
+static ssize_t ccc_count_store(struct device *dev,
+			       struct device_attribute *attr,
+			       const char *buf, size_t count)
+{
+	struct ata_host *host = dev_get_drvdata(dev);
+	struct ahci_host_priv *hpriv = host->private_data;
+	struct ceva_ahci_priv *cevapriv = hpriv->plat_data;
+
+	/* A count of 0 turns coalescing off */
+	return ceva_ahci_ccc_store(dev, buf, count, &cevapriv->ccc_count,
+				   0, CCC_CC_MAX);
+}
+static DEVICE_ATTR_RW(ccc_count);
+
+static ssize_t ccc_timeout_ms_show(struct device *dev,
+				   struct device_attribute *attr, char *buf)
+{
+	struct ata_host *host = dev_get_drvdata(dev);
+	struct ahci_host_priv *hpriv = host->private_data;
+	struct ceva_ahci_priv *cevapriv = hpriv->plat_data;
+
+	return sprintf(buf, "%u\n", cevapriv->ccc_timeout);
+}
+
+static ssize_t ccc_timeout_ms_store(struct device *dev,
+				    struct device_attribute *attr,
+				    const char *buf, size_t count)
+{
+	struct ata_host *host = dev_get_drvdata(dev);
+	struct ahci_host_priv *hpriv = host->private_data;
+	struct ceva_ahci_priv *cevapriv = hpriv->plat_data;
+
+	/* A timeout of 0 is reserved */
+	return ceva_ahci_ccc_store(dev, buf, count, &cevapriv->ccc_timeout,
+				   1, CCC_TV_MAX);
+}
+static DEVICE_ATTR_RW(ccc_timeout_ms);
+
+static struct attribute *ceva_ahci_ccc_attrs[] = {
+	&dev_attr_ccc_count.attr,
+	&dev_attr_ccc_timeout_ms.attr,
+	NULL,
+};
+
+static const struct attribute_group ceva_ahci_ccc_group = {
+	.attrs = ceva_ahci_ccc_attrs,
+};
+
 static struct ata_port_operations ahci_ceva_ops = {
 	.inherits = &ahci_platform_ops,
 	.read_id = ceva_ahci_read_id,
@@ -145,8 +310,13 @@ static void ahci_ceva_setup(struct ahci_host_priv *hpriv)
 			PAXIC_MAWID(i) | PAXIC_MARID(i) | PAXIC_OTL;
 		writel(tmp, mmio + AHCI_VEND_PAXIC);
 
-		/* Set AXI cache control register if CCi is enabled */
-		if (cevapriv->is_cci_enabled) {
+		/*
+		 * Set AXI cache control register from the device tree if
+		 * given, else if CCI is enabled
+		 */
+		if (cevapriv->has_axicc) {
+			writel(cevapriv->axicc, mmio + AHCI_VEND_AXICC);
+		} else if (cevapriv->is_cci_enabled) {
 			tmp = readl(mmio + AHCI_VEND_AXICC);
 			tmp |= AXICC_ARCA_VAL | AXICC_ARCF_VAL |
 				AXICC_ARCH_VAL | AXICC_ARCP_VAL |
@@ -213,6 +383,14 @@ static int ceva_ahci_probe(struct platform_device *pdev)
 	if (of_property_read_bool(np, "ceva,broken-gen2"))
 		cevapriv->flags = CEVA_FLAG_BROKEN_GEN2;
 
+	/* FIS-based switching for port multipliers, not reported by CAP */
+	if (of_property_read_bool(np, "ceva,fbs"))
+		hpriv->flags |= AHCI_HFLAG_YES_FBS;
+
+	/* AXI cache attributes of the data and non-data transfers */
+	if (!of_property_read_u32(np, "ceva,axicc", &cevapriv->axicc))
+		cevapriv->has_axicc = true;
+
 	/* Read OOB timing value for COMINIT from device-tree */
 	if (of_property_read_u8_array(np, "ceva,p0-cominit-params",
 					(u8 *)&cevapriv->pp2c[0], 4) < 0) {
@@ -273,6 +451,8 @@ static int ceva_ahci_probe(struct platform_device *pdev)
 	cevapriv->is_cci_enabled = (attr == DEV_DMA_COHERENT);
 
 	hpriv->plat_data = cevapriv;
+	hpriv->irq_handler = ceva_ahci_irq_intr;
+	cevapriv->ccc_timeout = 1;
 
 	/* CEVA specific initialization */
 	ahci_ceva_setup(hpriv);
@@ -282,6 +462,12 @@ static int ceva_ahci_probe(struct platform_device *pdev)
 	if (rc)
 		goto disable_resources;
 
+	if (hpriv->cap & HOST_CAP_CCC) {
+		rc = devm_device_add_group(dev, &ceva_ahci_ccc_group);
+		if (rc)
+			dev_warn(dev, "failed to create CCC attributes\n");
+	}
+
 	return 0;
 
 disable_resources:
@@ -311,6 +497,10 @@ static int __maybe_unused ceva_ahci_resume(struct device *dev)
 	if (rc)
 		goto disable_resources;
 
+	spin_lock_irq(&host->lock);
+	ceva_ahci_set_ccc(hpriv);
+	spin_unlock_irq(&host->lock);
+
 	/* We resumed so update PM runtime state */
 	pm_runtime_disable(dev);
 	pm_runtime_set_active(dev);
@@ -319,7 +319,12 @@ int fifo_icap_get_configuration(struct hwicap_drvdata *drvdata,
 		fifo_icap_start_readback(drvdata);
 
 		while (words_to_read > 0) {
-			/* Wait until we have some data in the fifo. */
+			/*
+			 * Wait until we have some data in the fifo. Only
+			 * count the polls without any progress, so that
+			 * long readbacks don't run out of retries.
+			 */
+			retries = 0;
 			while (read_fifo_occupancy == 0) {
 				read_fifo_occupancy =
 					fifo_icap_read_fifo_occupancy(drvdata);
@@ -86,6 +86,7 @@
 #include <linux/cdev.h>
 #include <linux/platform_device.h>
 #include <linux/slab.h>
+#include <linux/mm.h>
 #include <linux/io.h>
 #include <linux/uaccess.h>
 
@@ -108,6 +109,13 @@
 #define XHWICAP_MINOR 0
 #define HWICAP_DEVICES 1
 
+/*
+ * Maximum number of bytes read from the ICAP in one read() call. Each ICAP
+ * readback is a full sync/read/desync command sequence, so large chunks
+ * keep the protocol overhead low for full device readbacks.
+ */
+#define HWICAP_READ_SIZE (16 * PAGE_SIZE)
+
 /* An array, which is set to true when the device is registered. */
 static DEFINE_MUTEX(hwicap_mutex);
 static bool probed_devices[HWICAP_DEVICES];
@@ -385,7 +393,8 @@ hwicap_read(struct file *file, char __user *buf, size_t count, loff_t *ppos)
 		       4 - bytes_to_read);
 	} else {
 		/* Get new data from the ICAP, and return was was requested. */
-		kbuf = (u32 *) get_zeroed_page(GFP_KERNEL);
+		kbuf = kvzalloc(min_t(size_t, round_up(count, 4),
+				      HWICAP_READ_SIZE), GFP_KERNEL);
 		if (!kbuf) {
 			status = -ENOMEM;
 			goto error;
@@ -402,8 +411,8 @@ hwicap_read(struct file *file, char __user *buf, size_t count, loff_t *ppos)
 		words = ((count + 3) >> 2);
 		bytes_to_read = words << 2;
 
-		if (bytes_to_read > PAGE_SIZE)
-			bytes_to_read = PAGE_SIZE;
+		if (bytes_to_read > HWICAP_READ_SIZE)
+			bytes_to_read = HWICAP_READ_SIZE;
 
 		/* Ensure we only read a complete number of words. */
 		bytes_remaining = bytes_to_read & 3;
@@ -415,13 +424,13 @@ hwicap_read(struct file *file, char __user *buf, size_t count, loff_t *ppos)
 
 		/* If we didn't read correctly, then bail out. */
 		if (status) {
-			free_page((unsigned long)kbuf);
+			kvfree(kbuf);
 			goto error;
 		}
 
 		/* If we fail to return the data to the user, then bail out. */
 		if (copy_to_user(buf, kbuf, bytes_to_read)) {
-			free_page((unsigned long)kbuf);
+			kvfree(kbuf);
 			status = -EFAULT;
 			goto error;
 		}
@@ -429,7 +438,7 @@ hwicap_read(struct file *file, char __user *buf, size_t count, loff_t *ppos)
 		       kbuf,
 		       bytes_remaining);
 		drvdata->read_buffer_in_use = bytes_remaining;
-		free_page((unsigned long)kbuf);
+		kvfree(kbuf);
 	}
 	status = bytes_to_read;
  error:
@@ -12,6 +12,7 @@
 #include <linux/clk-provider.h>
 #include <linux/slab.h>
 #include <linux/io.h>
+#include <linux/iopoll.h>
 #include <linux/of.h>
 #include <linux/module.h>
 #include <linux/err.h>
@@ -38,7 +39,7 @@
 #define WZRD_CLKOUT_FRAC_MASK		0x3ff
 
 #define WZRD_DR_MAX_INT_DIV_VALUE	32767
-#define WZRD_DR_NUM_RETRIES		10000
+#define WZRD_DR_LOCK_TIMEOUT_US		10000
 #define WZRD_DR_STATUS_REG_OFFSET	0x04
 #define WZRD_DR_LOCK_BIT_MASK		0x00000001
 #define WZRD_DR_INIT_REG_OFFSET		0x14
@@ -134,11 +135,19 @@ static unsigned long clk_wzrd_recalc_rate(struct clk_hw *hw,
 	return  DIV_ROUND_UP_ULL((u64)parent_rate, div);
 }
 
+static int clk_wzrd_wait_lock(void __iomem *base)
+{
+	u32 val;
+
+	return readl_poll_timeout_atomic(base + WZRD_DR_STATUS_REG_OFFSET, val,
+					 val & WZRD_DR_LOCK_BIT_MASK, 1,
+					 WZRD_DR_LOCK_TIMEOUT_US);
+}
+
 static int clk_wzrd_dynamic_reconfig(struct clk_hw *hw, unsigned long rate,
 				     unsigned long parent_rate)
 {
 	int err = 0;
-	u16 retries;
 	u32 value;
 	unsigned long flags = 0;
 	u32 regh, edged;
@@ -155,7 +164,6 @@ static int clk_wzrd_dynamic_reconfig(struct clk_hw *hw, unsigned long rate,
 	value = DIV_ROUND_CLOSEST(parent_rate, rate);
 	regh = (value / 4);
 	regh = regh * 2;
-	regval = regh | (regh << 8);
 	regval1 = readl(div_addr);
 	regval1 = regval1 &  ~(BIT(8) | BIT(13) | BIT(15));
 	if (value % 4 > 1) {
@@ -165,38 +173,26 @@ static int clk_wzrd_dynamic_reconfig(struct clk_hw *hw, unsigned long rate,
 	p5fedge = value % 2;
 	p5en = value % 2;
 	regval1 = regval1 | p5en << 13 | p5fedge << 15;
-	writel(regval1, div_addr);
 	regval = regh | regh << 8;
+
+	/* Skip the lock cycle when the divider is already programmed */
+	if (readl(div_addr) == regval1 && readl(div_addr + 4) == regval)
+		goto err_reconfig;
+
+	writel(regval1, div_addr);
 	writel(regval, div_addr + 4);
-	/* Check status register */
-	retries = WZRD_DR_NUM_RETRIES;
-	while (retries--) {
-		if (readl(divider->base + WZRD_DR_STATUS_REG_OFFSET) &
-							WZRD_DR_LOCK_BIT_MASK)
-			break;
-	}
 
-	if (retries == 0) {
-		err = -ETIMEDOUT;
+	err = clk_wzrd_wait_lock(divider->base);
+	if (err)
 		goto err_reconfig;
-	}
 
 	/* Initiate reconfiguration */
 	writel(WZRD_DR_BEGIN_DYNA_RECONF,
 	       divider->base + WZRD_DR_INIT_REG_OFFSET);
 
-	/* Check status register */
-	retries = WZRD_DR_NUM_RETRIES;
-	while (retries--) {
-		if (readl(divider->base + WZRD_DR_STATUS_REG_OFFSET) &
-							WZRD_DR_LOCK_BIT_MASK)
-			break;
-	}
-
-	if (retries == 0) {
+	err = clk_wzrd_wait_lock(divider->base);
+	if (err)
 		pr_err("NOT LOCKED\n");
-		err = -ETIMEDOUT;
-	}
 
 err_reconfig:
 	if (divider->lock)
@@ -210,13 +206,14 @@ static int clk_wzrd_dynamic_reconfig(struct clk_hw *hw, unsigned long rate,
 static long clk_wzrd_round_rate(struct clk_hw *hw, unsigned long rate,
 				unsigned long *prate)
 {
-	u8 div;
+	u32 div;
 
 	/*
 	 * since we donot change parent rate we just round rate to closest
 	 * achievable
 	 */
 	div = DIV_ROUND_CLOSEST(*prate, rate);
+	div = clamp_t(u32, div, 1, WZRD_DR_MAX_INT_DIV_VALUE);
 
 	return (*prate / div);
 }
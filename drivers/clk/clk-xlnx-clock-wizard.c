@@ -12,6 +12,7 @@
 #include <linux/clk-provider.h>
 #include <linux/slab.h>
 #include <linux/io.h>
+#include <linux/iopoll.h>
 #include <linux/of.h>
 #include <linux/module.h>
 #include <linux/err.h>
@@ -37,7 +38,7 @@
 #define WZRD_CLKOUT_FRAC_MASK		0x3ff
 
 #define WZRD_DR_MAX_INT_DIV_VALUE	255
-#define WZRD_DR_NUM_RETRIES		10000
+#define WZRD_DR_LOCK_TIMEOUT_US		10000
 #define WZRD_DR_STATUS_REG_OFFSET	0x04
 #define WZRD_DR_LOCK_BIT_MASK		0x00000001
 #define WZRD_DR_INIT_REG_OFFSET		0x25C
@@ -52,6 +53,20 @@
 #define DIVCLK_DIVIDE_MIN		1U
 #define DIVCLK_DIVIDE_MAX		106U
 
+/* Output divider limits, from UG572 Table 3-4 for Ultrascale+ */
+#define CLKOUT_DIVIDE_MIN		1U
+#define CLKOUT_DIVIDE_MAX		128U
+#define CLKOUT0_DIVIDE_F_MIN		2000U
+
+/* PFD and VCO limits, from DS925 for Ultrascale+ */
+#define WZRD_PFD_MIN			10000000UL
+#define WZRD_PFD_MAX			450000000UL
+#define WZRD_VCO_MIN			800000000UL
+#define WZRD_VCO_MAX			1600000000UL
+
+/* Number of M/D/O settings remembered for a single output */
+#define WZRD_NUM_CFGS			8
+
 /* Get the mask from width */
 #define div_mask(width)			((1 << (width)) - 1)
 
@@ -85,6 +100,33 @@
  *         | (int divide)   |
  *         +----------------+
  *
+ * The VCO clocks only stage their settings in the configuration registers.
+ * The common clock framework always calls set_rate on the outputs after
+ * their parent changed, so the first output to be updated starts the one
+ * reconfiguration that applies all the staged settings at once, and the
+ * outputs whose divider is unchanged do not wait for another lock.
+ */
+
+/**
+ * struct clk_wzrd_cfg - MMCM settings solved for a single output rate
+ *
+ * @fin:	Rate of clk_in1 the settings were solved for
+ * @rate:	Requested output rate
+ * @vco:	VCO rate of the settings
+ * @divclk:	DIVCLK_DIVIDE value
+ * @mult:	CLKFBOUT_MULT_F value x1000
+ * @div:	CLKOUT0_DIVIDE_F value x1000
+ */
+struct clk_wzrd_cfg {
+	unsigned long fin;
+	unsigned long rate;
+	unsigned long vco;
+	u32 divclk;
+	u32 mult;
+	u32 div;
+};
+
+/**
  * struct clk_wzrd - Clock wizard private data structure
  *
  * @clk_data:		Clock data
@@ -95,8 +137,11 @@
  * @clkout:		Output clocks
  * @speed_grade:	Speed grade of the device
  * @suspended:		Flag indicating power state of the device
+ * @reconfig_pending:	Flag indicating settings are staged but not applied
  * @lock		lock pointer
  * @vco_clk:		hw Voltage Controlled Oscilator clock
+ * @cfgs:		Table of the settings solved for the single output
+ * @next_cfg:		Next entry of @cfgs to be replaced
  */
 struct clk_wzrd {
 	struct clk_onecell_data clk_data;
@@ -107,9 +152,12 @@ struct clk_wzrd {
 	struct clk *clkout[WZRD_NUM_OUTPUTS];
 	unsigned int speed_grade;
 	bool suspended;
+	bool reconfig_pending;
 	spinlock_t *lock;
 	struct clk_hw vco_clk_div_hw;
 	struct clk_hw vco_clk_mul_hw;
+	struct clk_wzrd_cfg cfgs[WZRD_NUM_CFGS];
+	unsigned int next_cfg;
 };
 
 /**
@@ -123,6 +171,7 @@ struct clk_wzrd {
  * @flags:	clk_wzrd divider flags
  * @table:	array of value/divider pairs, last entry should have div = 0
  * @lock:	register lock
+ * @clk_wzrd:	clock wizard the divider belongs to
  */
 struct clk_wzrd_divider {
 	struct clk_hw hw;
@@ -133,6 +182,7 @@ struct clk_wzrd_divider {
 	u8 flags;
 	const struct clk_div_table *table;
 	spinlock_t *lock;  /* divider lock */
+	struct clk_wzrd *clk_wzrd;
 };
 
 #define to_clk_wzrd(_nb) container_of(_nb, struct clk_wzrd, nb)
@@ -147,6 +197,173 @@ static const unsigned long clk_wzrd_max_freq[] = {
 /* spin lock variable for clk_wzrd */
 static DEFINE_SPINLOCK(clkwzrd_lock);
 
+static int clk_wzrd_wait_lock(void __iomem *base)
+{
+	u32 val;
+
+	return readl_poll_timeout_atomic(base + WZRD_DR_STATUS_REG_OFFSET, val,
+					 val & WZRD_DR_LOCK_BIT_MASK, 1,
+					 WZRD_DR_LOCK_TIMEOUT_US);
+}
+
+/*
+ * Apply all the staged settings with a single reconfiguration.
+ * Called with the register lock held.
+ */
+static int clk_wzrd_reconfig(struct clk_wzrd *clk_wzrd)
+{
+	int err;
+
+	if (!clk_wzrd->reconfig_pending)
+		return 0;
+
+	err = clk_wzrd_wait_lock(clk_wzrd->base);
+	if (err)
+		return err;
+
+	/* Initiate reconfiguration */
+	writel(WZRD_DR_BEGIN_DYNA_RECONF,
+	       clk_wzrd->base + WZRD_DR_INIT_REG_OFFSET);
+
+	err = clk_wzrd_wait_lock(clk_wzrd->base);
+	if (!err)
+		clk_wzrd->reconfig_pending = false;
+
+	return err;
+}
+
+/* Stage the divider of an output and clear its phase offset */
+static void clk_wzrd_stage_div(struct clk_wzrd_divider *divider, u32 value)
+{
+	void __iomem *div_addr = divider->base + divider->offset;
+
+	if (readl(div_addr) == value &&
+	    !readl(div_addr + WZRD_DR_DIV_TO_PHASE_OFFSET))
+		return;
+
+	writel(value, div_addr);
+	writel(0x00, div_addr + WZRD_DR_DIV_TO_PHASE_OFFSET);
+	divider->clk_wzrd->reconfig_pending = true;
+}
+
+/* Stage the VCO settings, applied by the next output update */
+static void clk_wzrd_stage_vco(struct clk_wzrd *clk_wzrd, u32 value)
+{
+	if (readl(clk_wzrd->base + WZRD_CLK_CFG_REG(0)) == value)
+		return;
+
+	writel(value, clk_wzrd->base + WZRD_CLK_CFG_REG(0));
+	clk_wzrd->reconfig_pending = true;
+}
+
+/* CLKOUT0_DIVIDE_F x1000 closest to a rate, in steps of 1/8 */
+static u32 clk_wzrd_get_div_f(unsigned long rate, unsigned long parent_rate)
+{
+	u32 div;
+
+	div = DIV_ROUND_CLOSEST_ULL((u64)parent_rate * 8, rate) * 125;
+
+	/* Fractional values are only allowed from 2.000 */
+	if (div < CLKOUT0_DIVIDE_F_MIN)
+		div = DIV_ROUND_CLOSEST(div, 1000) * 1000;
+
+	return clamp(div, CLKOUT_DIVIDE_MIN * 1000, CLKOUT_DIVIDE_MAX * 1000);
+}
+
+/* CLKFBOUT_MULT_F x1000 closest to a rate, in steps of 1/8 */
+static u32 clk_wzrd_get_mult(unsigned long rate, unsigned long parent_rate)
+{
+	u32 mult;
+
+	mult = DIV_ROUND_CLOSEST_ULL((u64)rate * 8, parent_rate) * 125;
+
+	return clamp(mult, CLKFBOUT_MULT_F_MIN, CLKFBOUT_MULT_F_MAX);
+}
+
+static unsigned long clk_wzrd_get_fin(struct clk_wzrd *clk_wzrd)
+{
+	return clk_hw_get_rate(clk_hw_get_parent(&clk_wzrd->vco_clk_div_hw));
+}
+
+/**
+ * clk_wzrd_get_cfg - Get the MMCM settings closest to a single output rate
+ * @clk_wzrd:	clock wizard private data
+ * @rate:	requested output rate
+ *
+ * Video mode changes switch between a handful of pixel clocks, so the
+ * settings are first looked up in the table of the rates solved before.
+ * Otherwise every DIVCLK_DIVIDE keeping the PFD in range is tried with
+ * the integer CLKOUT0_DIVIDE values landing the VCO in range, and the
+ * solution replaces the oldest table entry. Called with the clk prepare
+ * lock held.
+ *
+ * Return: the settings, or NULL if the rate cannot be reached
+ */
+static const struct clk_wzrd_cfg *clk_wzrd_get_cfg(struct clk_wzrd *clk_wzrd,
+						   unsigned long rate)
+{
+	struct clk_wzrd_cfg *cfg, best = { 0 };
+	unsigned long fin, vco, out, err, best_err = ULONG_MAX;
+	u32 divclk, div, div_min, div_max, mult;
+	int i;
+
+	fin = clk_wzrd_get_fin(clk_wzrd);
+	if (!fin || !rate)
+		return NULL;
+
+	for (i = 0; i < WZRD_NUM_CFGS; i++) {
+		cfg = &clk_wzrd->cfgs[i];
+		if (cfg->fin == fin && cfg->rate == rate)
+			return cfg;
+	}
+
+	div_min = max_t(unsigned long, DIV_ROUND_UP(WZRD_VCO_MIN, rate),
+			CLKOUT_DIVIDE_MIN);
+	div_max = min_t(unsigned long, WZRD_VCO_MAX / rate, CLKOUT_DIVIDE_MAX);
+
+	for (divclk = DIVCLK_DIVIDE_MIN;
+	     divclk <= DIVCLK_DIVIDE_MAX && best_err; divclk++) {
+		if (fin / divclk < WZRD_PFD_MIN)
+			break;
+		if (fin / divclk > WZRD_PFD_MAX)
+			continue;
+
+		for (div = div_min; div <= div_max && best_err; div++) {
+			mult = DIV_ROUND_CLOSEST_ULL((u64)rate * div * divclk * 8,
+						     fin) * 125;
+			if (mult < CLKFBOUT_MULT_F_MIN ||
+			    mult > CLKFBOUT_MULT_F_MAX)
+				continue;
+
+			vco = div_u64((u64)fin * mult, divclk * 1000);
+			if (vco < WZRD_VCO_MIN || vco > WZRD_VCO_MAX)
+				continue;
+
+			out = vco / div;
+			err = out > rate ? out - rate : rate - out;
+			if (err < best_err) {
+				best_err = err;
+				best.vco = vco;
+				best.divclk = divclk;
+				best.mult = mult;
+				best.div = div * 1000;
+			}
+		}
+	}
+
+	if (best_err == ULONG_MAX)
+		return NULL;
+
+	best.fin = fin;
+	best.rate = rate;
+
+	cfg = &clk_wzrd->cfgs[clk_wzrd->next_cfg];
+	*cfg = best;
+	clk_wzrd->next_cfg = (clk_wzrd->next_cfg + 1) % WZRD_NUM_CFGS;
+
+	return cfg;
+}
+
 static unsigned long clk_wzrd_recalc_rate(struct clk_hw *hw,
 					  unsigned long parent_rate)
 {
@@ -165,58 +382,24 @@ static unsigned long clk_wzrd_recalc_rate(struct clk_hw *hw,
 static int clk_wzrd_dynamic_reconfig(struct clk_hw *hw, unsigned long rate,
 				     unsigned long parent_rate)
 {
-	int err = 0;
-	u16 retries;
+	int err;
 	u32 value;
 	unsigned long flags = 0;
 	struct clk_wzrd_divider *divider = to_clk_wzrd_divider(hw);
-	void __iomem *div_addr =
-			(void __iomem *)(divider->base + divider->offset);
-
-	if (divider->lock)
-		spin_lock_irqsave(divider->lock, flags);
-	else
-		__acquire(divider->lock);
 
 	value = DIV_ROUND_CLOSEST(parent_rate, rate);
 
 	/* Cap the value to max */
-	if (value > WZRD_DR_MAX_INT_DIV_VALUE)
-		value = WZRD_DR_MAX_INT_DIV_VALUE;
-
-	/* Set divisor and clear phase offset */
-	writel(value, div_addr);
-	writel(0x00, div_addr + WZRD_DR_DIV_TO_PHASE_OFFSET);
-
-	/* Check status register */
-	retries = WZRD_DR_NUM_RETRIES;
-	while (retries--) {
-		if (readl(divider->base + WZRD_DR_STATUS_REG_OFFSET) &
-							WZRD_DR_LOCK_BIT_MASK)
-			break;
-	}
-
-	if (retries == 0) {
-		err = -ETIMEDOUT;
-		goto err_reconfig;
-	}
-
-	/* Initiate reconfiguration */
-	writel(WZRD_DR_BEGIN_DYNA_RECONF,
-	       divider->base + WZRD_DR_INIT_REG_OFFSET);
+	value = clamp_t(u32, value, 1, WZRD_DR_MAX_INT_DIV_VALUE);
 
-	/* Check status register */
-	retries = WZRD_DR_NUM_RETRIES;
-	while (retries--) {
-		if (readl(divider->base + WZRD_DR_STATUS_REG_OFFSET) &
-							WZRD_DR_LOCK_BIT_MASK)
-			break;
-	}
+	if (divider->lock)
+		spin_lock_irqsave(divider->lock, flags);
+	else
+		__acquire(divider->lock);
 
-	if (retries == 0)
-		err = -ETIMEDOUT;
+	clk_wzrd_stage_div(divider, value);
+	err = clk_wzrd_reconfig(divider->clk_wzrd);
 
-err_reconfig:
 	if (divider->lock)
 		spin_unlock_irqrestore(divider->lock, flags);
 	else
@@ -228,13 +411,14 @@ static int clk_wzrd_dynamic_reconfig(struct clk_hw *hw, unsigned long rate,
 static long clk_wzrd_round_rate(struct clk_hw *hw, unsigned long rate,
 				unsigned long *prate)
 {
-	u8 div;
+	u32 div;
 
 	/*
 	 * since we donot change parent rate we just round rate to closest
 	 * achievable
 	 */
 	div = DIV_ROUND_CLOSEST(*prate, rate);
+	div = clamp_t(u32, div, 1, WZRD_DR_MAX_INT_DIV_VALUE);
 
 	return (*prate / div);
 }
@@ -264,63 +448,22 @@ static unsigned long clk_wzrd_recalc_ratef(struct clk_hw *hw,
 static int clk_wzrd_dynamic_reconfig_f(struct clk_hw *hw, unsigned long rate,
 				       unsigned long parent_rate)
 {
-	int err = 0;
-	u16 retries;
-	u32 value, pre;
+	int err;
+	u32 value, div;
 	unsigned long flags = 0;
-	unsigned long rate_div, f, clockout0_div;
 	struct clk_wzrd_divider *divider = to_clk_wzrd_divider(hw);
-	void __iomem *div_addr =
-			(void __iomem *)((u64)divider->base + divider->offset);
+
+	div = clk_wzrd_get_div_f(rate, parent_rate);
+	value = ((div % 1000) << WZRD_CLKOUT_FRAC_SHIFT) | (div / 1000);
 
 	if (divider->lock)
 		spin_lock_irqsave(divider->lock, flags);
 	else
 		__acquire(divider->lock);
 
-	rate_div = ((parent_rate * 1000) / rate);
-	clockout0_div = rate_div / 1000;
-
-	pre = DIV_ROUND_CLOSEST((parent_rate * 1000), rate);
-	f = (u32)(pre - (clockout0_div * 1000));
-	f = f & WZRD_CLKOUT_FRAC_MASK;
-
-	value = ((f << WZRD_CLKOUT_DIVIDE_WIDTH) | (clockout0_div &
-			WZRD_CLKOUT_DIVIDE_MASK));
-
-	/* Set divisor and clear phase offset */
-	writel(value, div_addr);
-	writel(0x0, div_addr + WZRD_DR_DIV_TO_PHASE_OFFSET);
-
-	/* Check status register */
-	retries = WZRD_DR_NUM_RETRIES;
-	while (retries--) {
-		if (readl(divider->base + WZRD_DR_STATUS_REG_OFFSET) &
-							WZRD_DR_LOCK_BIT_MASK)
-			break;
-	}
-
-	if (!retries) {
-		err = -ETIMEDOUT;
-		goto err_reconfig;
-	}
-
-	/* Initiate reconfiguration */
-	writel(WZRD_DR_BEGIN_DYNA_RECONF,
-	       divider->base + WZRD_DR_INIT_REG_OFFSET);
-
-	/* Check status register */
-	retries = WZRD_DR_NUM_RETRIES;
-	while (retries--) {
-		if (readl(divider->base + WZRD_DR_STATUS_REG_OFFSET) &
-							WZRD_DR_LOCK_BIT_MASK)
-			break;
-	}
-
-	if (!retries)
-		err = -ETIMEDOUT;
+	clk_wzrd_stage_div(divider, value);
+	err = clk_wzrd_reconfig(divider->clk_wzrd);
 
-err_reconfig:
 	if (divider->lock)
 		spin_unlock_irqrestore(divider->lock, flags);
 	else
@@ -332,7 +475,19 @@ static int clk_wzrd_dynamic_reconfig_f(struct clk_hw *hw, unsigned long rate,
 static long clk_wzrd_round_rate_f(struct clk_hw *hw, unsigned long rate,
 				  unsigned long *prate)
 {
-	return rate;
+	struct clk_wzrd_divider *divider = to_clk_wzrd_divider(hw);
+	const struct clk_wzrd_cfg *cfg;
+
+	/* A single output retunes the VCO along with its divider */
+	if (clk_hw_get_flags(hw) & CLK_SET_RATE_PARENT) {
+		cfg = clk_wzrd_get_cfg(divider->clk_wzrd, rate);
+		if (cfg) {
+			*prate = cfg->vco;
+			return div_u64((u64)cfg->vco * 1000, cfg->div);
+		}
+	}
+
+	return div_u64((u64)*prate * 1000, clk_wzrd_get_div_f(rate, *prate));
 }
 
 static const struct clk_ops clk_wzrd_clk_divider_ops_f = {
@@ -369,8 +524,6 @@ static int clk_wzrd_vco_mul_dynamic_reconfig_f(struct clk_hw *hw,
 					   unsigned long rate,
 					   unsigned long parent_rate)
 {
-	int err = 0;
-	u16 retries;
 	unsigned long flags = 0;
 	u32 clk_cfg_reg0, value;
 	u32 divclk_divide, clkfbout_mult, clkfbout_frac;
@@ -380,13 +533,16 @@ static int clk_wzrd_vco_mul_dynamic_reconfig_f(struct clk_hw *hw,
 						 struct clk_wzrd,
 						 vco_clk_mul_hw);
 
-	/* The 8*125 give the x1000 that is needed */
-	new_mult = (rate * 8 / parent_rate) * 125;
-	new_mult = clamp(new_mult, CLKFBOUT_MULT_F_MIN, CLKFBOUT_MULT_F_MAX);
+	new_mult = clk_wzrd_get_mult(rate, parent_rate);
 
 	clkfbout_mult = new_mult / 1000;
 	clkfbout_frac = new_mult % 1000;
 
+	if (clk_wzrd->lock)
+		spin_lock_irqsave(clk_wzrd->lock, flags);
+	else
+		__acquire(clk_wzrd->lock);
+
 	/* Read divclk_divide so it can be left unchanged */
 	clk_cfg_reg0 = readl(clk_wzrd->base + WZRD_CLK_CFG_REG(0));
 	divclk_divide = (clk_cfg_reg0 & WZRD_DIVCLK_DIVIDE_MASK) >>
@@ -396,55 +552,40 @@ static int clk_wzrd_vco_mul_dynamic_reconfig_f(struct clk_hw *hw,
 		 clkfbout_mult << WZRD_CLKFBOUT_MULT_SHIFT |
 		 divclk_divide << WZRD_DIVCLK_DIVIDE_SHIFT;
 
-	if (clk_wzrd->lock)
-		spin_lock_irqsave(clk_wzrd->lock, flags);
-	else
-		__acquire(clk_wzrd->lock);
-
-	/* Write the configuration out */
-	writel(value, clk_wzrd->base + WZRD_CLK_CFG_REG(0));
-
-	/* Check status register */
-	retries = WZRD_DR_NUM_RETRIES;
-	while (retries--) {
-		if (readl(clk_wzrd->base + WZRD_DR_STATUS_REG_OFFSET) &
-							WZRD_DR_LOCK_BIT_MASK)
-			break;
-	}
-
-	if (!retries) {
-		err = -ETIMEDOUT;
-		goto err_reconfig;
-	}
+	/* Applied by the outputs, which are always updated next */
+	clk_wzrd_stage_vco(clk_wzrd, value);
 
-	/* Initiate reconfiguration */
-	writel(WZRD_DR_BEGIN_DYNA_RECONF,
-	       clk_wzrd->base + WZRD_DR_INIT_REG_OFFSET);
-
-	/* Check status register */
-	retries = WZRD_DR_NUM_RETRIES;
-	while (retries--) {
-		if (readl(clk_wzrd->base + WZRD_DR_STATUS_REG_OFFSET) &
-							WZRD_DR_LOCK_BIT_MASK)
-			break;
-	}
-
-	if (!retries)
-		err = -ETIMEDOUT;
-
-err_reconfig:
 	if (clk_wzrd->lock)
 		spin_unlock_irqrestore(clk_wzrd->lock, flags);
 	else
 		__release(clk_wzrd->lock);
 
-	return err;
+	return 0;
 }
 
 static long clk_wzrd_vco_mul_round_rate_f(struct clk_hw *hw, unsigned long rate,
 				      unsigned long *prate)
 {
-	return rate;
+	struct clk_wzrd *clk_wzrd = container_of(hw,
+						 struct clk_wzrd,
+						 vco_clk_mul_hw);
+	const struct clk_wzrd_cfg *cfg;
+	unsigned long fin;
+	int i;
+
+	/* Retune the PFD too when the VCO rate was solved for the output */
+	if (clk_hw_get_flags(hw) & CLK_SET_RATE_PARENT) {
+		fin = clk_wzrd_get_fin(clk_wzrd);
+		for (i = 0; i < WZRD_NUM_CFGS; i++) {
+			cfg = &clk_wzrd->cfgs[i];
+			if (cfg->fin == fin && cfg->vco == rate) {
+				*prate = fin / cfg->divclk;
+				return rate;
+			}
+		}
+	}
+
+	return div_u64((u64)*prate * clk_wzrd_get_mult(rate, *prate), 1000);
 }
 
 static const struct clk_ops clk_wzrd_vco_mul_ops_f = {
@@ -477,8 +618,6 @@ static int clk_wzrd_vco_div_dynamic_reconfig(struct clk_hw *hw,
 					   unsigned long rate,
 					   unsigned long parent_rate)
 {
-	int err = 0;
-	u16 retries;
 	unsigned long flags = 0;
 	u32 clk_cfg_reg0, value;
 	u32 divclk_divide, clkfbout_mult, clkfbout_frac;
@@ -493,6 +632,11 @@ static int clk_wzrd_vco_div_dynamic_reconfig(struct clk_hw *hw,
 			      DIVCLK_DIVIDE_MIN,
 			      DIVCLK_DIVIDE_MAX);
 
+	if (clk_wzrd->lock)
+		spin_lock_irqsave(clk_wzrd->lock, flags);
+	else
+		__acquire(clk_wzrd->lock);
+
 	/*
 	 * Read clkfbout_mult and clkfbout_frac
 	 * so they can be left unchanged
@@ -507,55 +651,28 @@ static int clk_wzrd_vco_div_dynamic_reconfig(struct clk_hw *hw,
 		 clkfbout_mult << WZRD_CLKFBOUT_MULT_SHIFT |
 		 divclk_divide << WZRD_DIVCLK_DIVIDE_SHIFT;
 
-	if (clk_wzrd->lock)
-		spin_lock_irqsave(clk_wzrd->lock, flags);
-	else
-		__acquire(clk_wzrd->lock);
+	/* Applied by the outputs, which are always updated next */
+	clk_wzrd_stage_vco(clk_wzrd, value);
 
-	/* Write the configuration out */
-	writel(value, clk_wzrd->base + WZRD_CLK_CFG_REG(0));
-
-	/* Check status register */
-	retries = WZRD_DR_NUM_RETRIES;
-	while (retries--) {
-		if (readl(clk_wzrd->base + WZRD_DR_STATUS_REG_OFFSET) &
-							WZRD_DR_LOCK_BIT_MASK)
-			break;
-	}
-
-	if (!retries) {
-		err = -ETIMEDOUT;
-		goto err_reconfig;
-	}
-
-	/* Initiate reconfiguration */
-	writel(WZRD_DR_BEGIN_DYNA_RECONF,
-	       clk_wzrd->base + WZRD_DR_INIT_REG_OFFSET);
-
-	/* Check status register */
-	retries = WZRD_DR_NUM_RETRIES;
-	while (retries--) {
-		if (readl(clk_wzrd->base + WZRD_DR_STATUS_REG_OFFSET) &
-							WZRD_DR_LOCK_BIT_MASK)
-			break;
-	}
-
-	if (!retries)
-		err = -ETIMEDOUT;
-
-err_reconfig:
 	if (clk_wzrd->lock)
 		spin_unlock_irqrestore(clk_wzrd->lock, flags);
 	else
 		__release(clk_wzrd->lock);
 
-	return err;
+	return 0;
 }
 
 static long clk_wzrd_vco_div_round_rate(struct clk_hw *hw, unsigned long rate,
 				      unsigned long *prate)
 {
-	return rate;
+	u32 divclk_divide;
+
+	divclk_divide = DIV_ROUND_CLOSEST(*prate, rate);
+	divclk_divide = clamp(divclk_divide,
+			      DIVCLK_DIVIDE_MIN,
+			      DIVCLK_DIVIDE_MAX);
+
+	return *prate / divclk_divide;
 }
 
 static const struct clk_ops clk_wzrd_vco_div_ops = {
@@ -572,7 +689,8 @@ static struct clk *clk_wzrd_register_divf(struct device *dev,
 					  u8 shift, u8 width,
 					  u8 clk_divider_flags,
 					  const struct clk_div_table *table,
-					  spinlock_t *lock)
+					  spinlock_t *lock,
+					  struct clk_wzrd *clk_wzrd)
 {
 	struct clk_wzrd_divider *div;
 	struct clk_hw *hw;
@@ -609,6 +727,7 @@ static struct clk *clk_wzrd_register_divf(struct device *dev,
 	div->width = width;
 	div->flags = clk_divider_flags;
 	div->lock = lock;
+	div->clk_wzrd = clk_wzrd;
 	div->hw.init = &init;
 	div->table = table;
 
@@ -631,7 +750,8 @@ static struct clk *clk_wzrd_register_divider(struct device *dev,
 					     u8 shift, u8 width,
 					     u8 clk_divider_flags,
 					     const struct clk_div_table *table,
-					     spinlock_t *lock)
+					     spinlock_t *lock,
+					     struct clk_wzrd *clk_wzrd)
 {
 	struct clk_wzrd_divider *div;
 	struct clk_hw *hw;
@@ -666,6 +786,7 @@ static struct clk *clk_wzrd_register_divider(struct device *dev,
 	div->width = width;
 	div->flags = clk_divider_flags;
 	div->lock = lock;
+	div->clk_wzrd = clk_wzrd;
 	div->hw.init = &init;
 	div->table = table;
 
@@ -874,7 +995,7 @@ static int clk_wzrd_probe(struct platform_device *pdev)
 				WZRD_CLKOUT_DIVIDE_SHIFT,
 				WZRD_CLKOUT_DIVIDE_WIDTH,
 				CLK_DIVIDER_ONE_BASED | CLK_DIVIDER_ALLOW_ZERO,
-				NULL, &clkwzrd_lock);
+				NULL, &clkwzrd_lock, clk_wzrd);
 		else
 			clk_wzrd->clkout[i] = clk_wzrd_register_divider
 				(&pdev->dev, clkout_name,
@@ -883,7 +1004,7 @@ static int clk_wzrd_probe(struct platform_device *pdev)
 				WZRD_CLKOUT_DIVIDE_SHIFT,
 				WZRD_CLKOUT_DIVIDE_WIDTH,
 				CLK_DIVIDER_ONE_BASED | CLK_DIVIDER_ALLOW_ZERO,
-				NULL, &clkwzrd_lock);
+				NULL, &clkwzrd_lock, clk_wzrd);
 		if (IS_ERR(clk_wzrd->clkout[i])) {
 			int j;
 
@@ -16,11 +16,13 @@
  * @hw:		handle between common and hardware-specific interfaces
  * @flags:	hardware-specific flags
  * @clk_id:	Id of clock
+ * @state:	Cached gate state, 1 if enabled, 0 if disabled, -1 if unknown
  */
 struct zynqmp_clk_gate {
 	struct clk_hw hw;
 	u8 flags;
 	u32 clk_id;
+	int state;
 };
 
 #define to_zynqmp_clk_gate(_hw) container_of(_hw, struct zynqmp_clk_gate, hw)
@@ -41,9 +43,13 @@ static int zynqmp_clk_gate_enable(struct clk_hw *hw)
 
 	ret = eemi_ops->clock_enable(clk_id);
 
-	if (ret)
+	if (ret) {
 		pr_warn_once("%s() clock enabled failed for %s, ret = %d\n",
 			     __func__, clk_name, ret);
+		gate->state = -1;
+	} else {
+		gate->state = 1;
+	}
 
 	return ret;
 }
@@ -62,15 +68,22 @@ static void zynqmp_clk_gate_disable(struct clk_hw *hw)
 
 	ret = eemi_ops->clock_disable(clk_id);
 
-	if (ret)
+	if (ret) {
 		pr_warn_once("%s() clock disable failed for %s, ret = %d\n",
 			     __func__, clk_name, ret);
+		gate->state = -1;
+	} else {
+		gate->state = 0;
+	}
 }
 
 /**
  * zynqmp_clk_gate_is_enable() - Check clock state
  * @hw:		handle between common and hardware-specific interfaces
  *
+ * The state is only read from the firmware until it is known, after that it
+ * is tracked by enable and disable.
+ *
  * Return: 1 if enabled, 0 if disabled else error code
  */
 static int zynqmp_clk_gate_is_enabled(struct clk_hw *hw)
@@ -81,6 +94,9 @@ static int zynqmp_clk_gate_is_enabled(struct clk_hw *hw)
 	int state, ret;
 	const struct zynqmp_eemi_ops *eemi_ops = zynqmp_pm_get_eemi_ops();
 
+	if (gate->state >= 0)
+		return gate->state;
+
 	ret = eemi_ops->clock_getstate(clk_id, &state);
 	if (ret) {
 		pr_warn_once("%s() clock get state failed for %s, ret = %d\n",
@@ -88,7 +104,9 @@ static int zynqmp_clk_gate_is_enabled(struct clk_hw *hw)
 		return -EIO;
 	}
 
-	return state ? 1 : 0;
+	gate->state = state ? 1 : 0;
+
+	return gate->state;
 }
 
 static const struct clk_ops zynqmp_clk_gate_ops = {
@@ -132,6 +150,7 @@ struct clk_hw *zynqmp_clk_register_gate(const char *name, u32 clk_id,
 	gate->flags = nodes->type_flag;
 	gate->hw.init = &init;
 	gate->clk_id = clk_id;
+	gate->state = -1;
 
 	hw = &gate->hw;
 	ret = clk_hw_register(NULL, hw);
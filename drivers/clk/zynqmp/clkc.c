@@ -11,6 +11,7 @@
 #include <linux/clk.h>
 #include <linux/clk-provider.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
 #include <linux/of_platform.h>
 #include <linux/slab.h>
 #include <linux/string.h>
@@ -63,9 +64,12 @@ struct clock_parent {
  * @type:		Clock type (Output/External)
  * @node:		Clock topology nodes
  * @num_nodes:		Number of nodes present in topology
- * @parent:		Parent of clock
- * @num_parents:	Number of parents of clock
  * @clk_id:		Clock id
+ * @registered:		Registration of the clock has been attempted
+ *
+ * The topology and the parents of a clock are only queried from firmware
+ * when the clock is registered. The parents are not kept afterwards, the
+ * clock framework has its own copy of their names.
  */
 struct zynqmp_clock {
 	char clk_name[MAX_NAME_LEN];
@@ -73,9 +77,8 @@ struct zynqmp_clock {
 	enum clk_type type;
 	struct clock_topology node[MAX_NODES];
 	u32 num_nodes;
-	struct clock_parent parent[MAX_PARENT];
-	u32 num_parents;
 	u32 clk_id;
+	bool registered;
 };
 
 struct name_resp {
@@ -136,6 +139,9 @@ static struct zynqmp_clock *clock;
 static struct clk_hw_onecell_data *zynqmp_data;
 static unsigned int clock_max_idx;
 static const struct zynqmp_eemi_ops *eemi_ops;
+static struct device_node *zynqmp_clk_np;
+/* Serializes the on demand registration of clocks */
+static DEFINE_MUTEX(zynqmp_clk_lock);
 
 /**
  * zynqmp_is_valid_clock() - Check whether clock is valid or not
@@ -531,21 +537,22 @@ static int zynqmp_clock_get_parents(u32 clk_id, struct clock_parent *parents,
  * zynqmp_get_parent_list() - Create list of parents name
  * @np:			Device node
  * @clk_id:		Clock index
+ * @parents:		Parents of the clock
+ * @total_parents:	Number of entries in @parents
  * @parent_list:	List of parent's name
  * @num_parents:	Total number of parents
  *
  * Return: 0 on success else error+reason
  */
 static int zynqmp_get_parent_list(struct device_node *np, u32 clk_id,
+				  struct clock_parent *parents,
+				  u32 total_parents,
 				  const char **parent_list, u32 *num_parents)
 {
 	int i = 0, ret;
-	u32 total_parents = clock[clk_id].num_parents;
 	struct clock_topology *clk_nodes;
-	struct clock_parent *parents;
 
 	clk_nodes = clock[clk_id].node;
-	parents = clock[clk_id].parent;
 
 	for (i = 0; i < total_parents; i++) {
 		if (!parents[i].flag) {
@@ -625,52 +632,161 @@ static struct clk_hw *zynqmp_register_clk_topology(int clk_id, char *clk_name,
 }
 
 /**
- * zynqmp_register_clocks() - Register clocks
+ * zynqmp_register_clock() - Register a clock and the clocks it derives from
  * @np:		Device node
+ * @clk_id:	Clock index
  *
- * Return: 0 on success else error code
+ * The topology and the parents of the clock are queried from firmware, and
+ * the output clocks among its parents are registered first, so that its rate
+ * is known as soon as it is registered. A clock is registered at most once.
+ * Called with zynqmp_clk_lock held.
  */
-static int zynqmp_register_clocks(struct device_node *np)
+static void zynqmp_register_clock(struct device_node *np, u32 clk_id)
 {
+	char clk_name[MAX_NAME_LEN];
+	struct clock_parent *parents;
+	const char **parent_names;
+	u32 i, total_parents = 0, num_parents = 0, type = 0;
 	int ret;
-	u32 i, total_parents = 0, type = 0;
-	const char *parent_names[MAX_PARENT];
 
-	for (i = 0; i < clock_max_idx; i++) {
-		char clk_name[MAX_NAME_LEN];
+	/* get clock name, skip the clock if name not found */
+	if (zynqmp_get_clock_name(clk_id, clk_name))
+		return;
+
+	/* Check if clock is valid and output clock.
+	 * Do not register invalid or external clock.
+	 */
+	ret = zynqmp_get_clock_type(clk_id, &type);
+	if (ret || type != CLK_TYPE_OUTPUT || clock[clk_id].registered)
+		return;
+
+	clock[clk_id].registered = true;
+
+	parents = kcalloc(MAX_PARENT, sizeof(*parents), GFP_KERNEL);
+	parent_names = kcalloc(MAX_PARENT, sizeof(*parent_names), GFP_KERNEL);
+	if (!parents || !parent_names)
+		goto out;
+
+	ret = zynqmp_clock_get_topology(clk_id, clock[clk_id].node,
+					&clock[clk_id].num_nodes);
+	if (!ret)
+		zynqmp_clock_get_parents(clk_id, parents, &total_parents);
+
+	for (i = 0; i < total_parents; i++)
+		if (parents[i].flag == PARENT_CLK_SELF)
+			zynqmp_register_clock(np, parents[i].id);
+
+	/* Get parents of clock*/
+	if (zynqmp_get_parent_list(np, clk_id, parents, total_parents,
+				   parent_names, &num_parents)) {
+		WARN_ONCE(1, "No parents found for %s\n",
+			  clock[clk_id].clk_name);
+		goto out;
+	}
 
-		/* get clock name, continue to next clock if name not found */
-		if (zynqmp_get_clock_name(i, clk_name))
-			continue;
+	zynqmp_data->hws[clk_id] =
+		zynqmp_register_clk_topology(clk_id, clk_name, num_parents,
+					     parent_names);
+	if (IS_ERR(zynqmp_data->hws[clk_id])) {
+		pr_err("Zynq Ultrascale+ MPSoC clk %s: register failed with %ld\n",
+		       clock[clk_id].clk_name,
+		       PTR_ERR(zynqmp_data->hws[clk_id]));
+		WARN_ON(1);
+	}
 
-		/* Check if clock is valid and output clock.
-		 * Do not register invalid or external clock.
-		 */
-		ret = zynqmp_get_clock_type(i, &type);
-		if (ret || type != CLK_TYPE_OUTPUT)
-			continue;
+out:
+	kfree(parent_names);
+	kfree(parents);
+}
 
-		/* Get parents of clock*/
-		if (zynqmp_get_parent_list(np, i, parent_names,
-					   &total_parents)) {
-			WARN_ONCE(1, "No parents found for %s\n",
-				  clock[i].clk_name);
-			continue;
+/**
+ * zynqmp_register_consumed_clocks() - Register the clocks used by a node
+ * @np:		Clock controller device node
+ * @consumer:	Device node which may use clocks of the controller
+ */
+static void zynqmp_register_consumed_clocks(struct device_node *np,
+					    struct device_node *consumer)
+{
+	static const char * const props[] = {
+		"clocks", "assigned-clocks", "assigned-clock-parents",
+	};
+	struct of_phandle_args clkspec;
+	int i, j;
+
+	for (i = 0; i < ARRAY_SIZE(props); i++) {
+		for (j = 0; !of_parse_phandle_with_args(consumer, props[i],
+							"#clock-cells", j,
+							&clkspec); j++) {
+			if (clkspec.np == np && clkspec.args_count == 1)
+				zynqmp_register_clock(np, clkspec.args[0]);
+			of_node_put(clkspec.np);
 		}
+	}
+}
 
-		zynqmp_data->hws[i] =
-			zynqmp_register_clk_topology(i, clk_name,
-						     total_parents,
-						     parent_names);
+/**
+ * zynqmp_clk_of_notify() - Register the clocks used by new device nodes
+ * @nb:		Notifier block
+ * @action:	Device tree change
+ * @arg:	Device tree change data
+ *
+ * With CONFIG_COMMON_CLK_ZYNQMP_LAZY, the nodes added at runtime, e.g. by
+ * an overlay describing the PL, get their clocks registered before their
+ * devices are created.
+ *
+ * Return: NOTIFY_OK
+ */
+static int zynqmp_clk_of_notify(struct notifier_block *nb,
+				unsigned long action, void *arg)
+{
+	struct of_reconfig_data *rd = arg;
+
+	switch (action) {
+	case OF_RECONFIG_ATTACH_NODE:
+	case OF_RECONFIG_ADD_PROPERTY:
+	case OF_RECONFIG_UPDATE_PROPERTY:
+		mutex_lock(&zynqmp_clk_lock);
+		zynqmp_register_consumed_clocks(zynqmp_clk_np, rd->dn);
+		mutex_unlock(&zynqmp_clk_lock);
+		break;
+	default:
+		break;
 	}
 
-	for (i = 0; i < clock_max_idx; i++) {
-		if (IS_ERR(zynqmp_data->hws[i])) {
-			pr_err("Zynq Ultrascale+ MPSoC clk %s: register failed with %ld\n",
-			       clock[i].clk_name, PTR_ERR(zynqmp_data->hws[i]));
-			WARN_ON(1);
-		}
+	return NOTIFY_OK;
+}
+
+static struct notifier_block zynqmp_clk_of_nb = {
+	.notifier_call = zynqmp_clk_of_notify,
+};
+
+/**
+ * zynqmp_register_clocks() - Register clocks
+ * @np:		Device node
+ *
+ * With CONFIG_COMMON_CLK_ZYNQMP_LAZY, only the clocks used by the device
+ * tree, and the clocks they derive from, are registered. The others are
+ * never queried from firmware.
+ *
+ * Return: 0 on success else error code
+ */
+static int zynqmp_register_clocks(struct device_node *np)
+{
+	struct device_node *consumer;
+	u32 i;
+
+	mutex_lock(&zynqmp_clk_lock);
+	if (IS_ENABLED(CONFIG_COMMON_CLK_ZYNQMP_LAZY)) {
+		for (i = 0; i < clock_max_idx; i++)
+			zynqmp_data->hws[i] = ERR_PTR(-ENOENT);
+		for_each_of_allnodes(consumer)
+			zynqmp_register_consumed_clocks(np, consumer);
+	} else {
+		for (i = 0; i < clock_max_idx; i++)
+			zynqmp_register_clock(np, i);
 	}
+	mutex_unlock(&zynqmp_clk_lock);
+
 	return 0;
 }
 
@@ -680,7 +796,6 @@ static int zynqmp_register_clocks(struct device_node *np)
 static void zynqmp_get_clock_info(void)
 {
 	int i, ret;
-	u32 type = 0;
 	u32 nodetype, subclass, class;
 	struct attr_resp attr;
 	struct name_resp name;
@@ -714,23 +829,6 @@ static void zynqmp_get_clock_info(void)
 			continue;
 		strncpy(clock[i].clk_name, name.name, MAX_NAME_LEN);
 	}
-
-	/* Get topology of all clock */
-	for (i = 0; i < clock_max_idx; i++) {
-		ret = zynqmp_get_clock_type(i, &type);
-		if (ret || type != CLK_TYPE_OUTPUT)
-			continue;
-
-		ret = zynqmp_clock_get_topology(i, clock[i].node,
-						&clock[i].num_nodes);
-		if (ret)
-			continue;
-
-		ret = zynqmp_clock_get_parents(i, clock[i].parent,
-					       &clock[i].num_parents);
-		if (ret)
-			continue;
-	}
 }
 
 /**
@@ -758,11 +856,20 @@ static int zynqmp_clk_setup(struct device_node *np)
 		return -ENOMEM;
 	}
 
+	zynqmp_clk_np = np;
 	zynqmp_get_clock_info();
 	zynqmp_register_clocks(np);
 
 	zynqmp_data->num = clock_max_idx;
-	return of_clk_add_hw_provider(np, of_clk_hw_onecell_get, zynqmp_data);
+	ret = of_clk_add_hw_provider(np, of_clk_hw_onecell_get, zynqmp_data);
+	if (ret)
+		return ret;
+
+	if (IS_ENABLED(CONFIG_COMMON_CLK_ZYNQMP_LAZY) &&
+	    IS_ENABLED(CONFIG_OF_DYNAMIC))
+		WARN_ON(of_reconfig_notifier_register(&zynqmp_clk_of_nb));
+
+	return 0;
 }
 
 static int zynqmp_clock_probe(struct platform_device *pdev)
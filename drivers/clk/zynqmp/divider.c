@@ -9,6 +9,9 @@
 
 #include <linux/clk.h>
 #include <linux/clk-provider.h>
+#include <linux/clk/zynqmp.h>
+#include <linux/list.h>
+#include <linux/mutex.h>
 #include <linux/slab.h>
 #include "clk-zynqmp.h"
 
@@ -36,6 +39,9 @@
  * @clk_id:	Id of clock
  * @div_type:	divisor type (TYPE_DIV1 or TYPE_DIV2)
  * @max_div:	Maximum divisor value allowed
+ * @div:	Cached divisor value, valid if @div_valid is set
+ * @div_valid:	The divisor has been read from or written to the firmware
+ * @node:	Entry in zynqmp_clk_dividers
  */
 struct zynqmp_clk_divider {
 	struct clk_hw hw;
@@ -44,8 +50,15 @@ struct zynqmp_clk_divider {
 	u32 clk_id;
 	u32 div_type;
 	u16 max_div;
+	u32 div;
+	bool div_valid;
+	struct list_head node;
 };
 
+/* The registered dividers, for zynqmp_clk_get_divider() */
+static LIST_HEAD(zynqmp_clk_dividers);
+static DEFINE_MUTEX(zynqmp_clk_dividers_lock);
+
 static inline int zynqmp_divider_get_val(unsigned long parent_rate,
 					 unsigned long rate, u16 flags)
 {
@@ -69,6 +82,49 @@ static inline int zynqmp_divider_get_val(unsigned long parent_rate,
 	}
 }
 
+/**
+ * zynqmp_clk_divider_get_div() - Get the divisor value of a divider clock
+ * @divider:	Divider clock
+ * @value:	Divisor value
+ *
+ * The divisor is only read from the firmware once and then tracked by
+ * set_rate, as the clock framework recalculates the rates of whole
+ * subtrees on every reparenting and rate change, which would otherwise
+ * issue one firmware call per divider each time.
+ *
+ * Return: 0 on success else error+reason
+ */
+static int zynqmp_clk_divider_get_div(struct zynqmp_clk_divider *divider,
+				      u32 *value)
+{
+	const struct zynqmp_eemi_ops *eemi_ops = zynqmp_pm_get_eemi_ops();
+	u32 div;
+	int ret;
+
+	if (divider->div_valid) {
+		*value = divider->div;
+		return 0;
+	}
+
+	ret = eemi_ops->clock_getdivider(divider->clk_id, &div);
+	if (ret)
+		return ret;
+
+	if (divider->div_type == TYPE_DIV1)
+		div = div & 0xFFFF;
+	else
+		div = div >> 16;
+
+	if (divider->flags & CLK_DIVIDER_POWER_OF_TWO)
+		div = 1 << div;
+
+	divider->div = div;
+	divider->div_valid = true;
+	*value = div;
+
+	return 0;
+}
+
 /**
  * zynqmp_clk_divider_recalc_rate() - Recalc rate of divider clock
  * @hw:			handle between common and hardware-specific interfaces
@@ -81,26 +137,14 @@ static unsigned long zynqmp_clk_divider_recalc_rate(struct clk_hw *hw,
 {
 	struct zynqmp_clk_divider *divider = to_zynqmp_clk_divider(hw);
 	const char *clk_name = clk_hw_get_name(hw);
-	u32 clk_id = divider->clk_id;
-	u32 div_type = divider->div_type;
-	u32 div, value;
+	u32 value = 0;
 	int ret;
-	const struct zynqmp_eemi_ops *eemi_ops = zynqmp_pm_get_eemi_ops();
-
-	ret = eemi_ops->clock_getdivider(clk_id, &div);
 
+	ret = zynqmp_clk_divider_get_div(divider, &value);
 	if (ret)
 		pr_warn_once("%s() get divider failed for %s, ret = %d\n",
 			     __func__, clk_name, ret);
 
-	if (div_type == TYPE_DIV1)
-		value = div & 0xFFFF;
-	else
-		value = div >> 16;
-
-	if (divider->flags & CLK_DIVIDER_POWER_OF_TWO)
-		value = 1 << value;
-
 	if (!value) {
 		WARN(!(divider->flags & CLK_DIVIDER_ALLOW_ZERO),
 		     "%s: Zero divisor and CLK_DIVIDER_ALLOW_ZERO not set\n",
@@ -171,26 +215,16 @@ static long zynqmp_clk_divider_round_rate(struct clk_hw *hw,
 {
 	struct zynqmp_clk_divider *divider = to_zynqmp_clk_divider(hw);
 	const char *clk_name = clk_hw_get_name(hw);
-	u32 clk_id = divider->clk_id;
 	u32 div_type = divider->div_type;
 	u32 bestdiv;
 	int ret;
-	const struct zynqmp_eemi_ops *eemi_ops = zynqmp_pm_get_eemi_ops();
 
 	/* if read only, just return current value */
 	if (divider->flags & CLK_DIVIDER_READ_ONLY) {
-		ret = eemi_ops->clock_getdivider(clk_id, &bestdiv);
-
+		ret = zynqmp_clk_divider_get_div(divider, &bestdiv);
 		if (ret)
 			pr_warn_once("%s() get divider failed for %s, ret = %d\n",
 				     __func__, clk_name, ret);
-		if (div_type == TYPE_DIV1)
-			bestdiv = bestdiv & 0xFFFF;
-		else
-			bestdiv  = bestdiv >> 16;
-
-		if (divider->flags & CLK_DIVIDER_POWER_OF_TWO)
-			bestdiv = 1 << bestdiv;
 
 		return DIV_ROUND_UP_ULL((u64)*prate, bestdiv);
 	}
@@ -216,6 +250,32 @@ static long zynqmp_clk_divider_round_rate(struct clk_hw *hw,
 	return rate;
 }
 
+/**
+ * zynqmp_clk_divider_encode() - Encode a divisor for the firmware
+ * @divider:	Divider clock
+ * @value:	Divisor value
+ *
+ * Return: Divisor argument of the set divider firmware call
+ */
+static u32 zynqmp_clk_divider_encode(struct zynqmp_clk_divider *divider,
+				     u32 value)
+{
+	u32 div;
+
+	if (divider->div_type == TYPE_DIV1) {
+		div = value & 0xFFFF;
+		div |= 0xffff << 16;
+	} else {
+		div = 0xffff;
+		div |= value << 16;
+	}
+
+	if (divider->flags & CLK_DIVIDER_POWER_OF_TWO)
+		div = __ffs(div);
+
+	return div;
+}
+
 /**
  * zynqmp_clk_divider_set_rate() - Set rate of divider clock
  * @hw:			handle between common and hardware-specific interfaces
@@ -230,28 +290,32 @@ static int zynqmp_clk_divider_set_rate(struct clk_hw *hw, unsigned long rate,
 	struct zynqmp_clk_divider *divider = to_zynqmp_clk_divider(hw);
 	const char *clk_name = clk_hw_get_name(hw);
 	u32 clk_id = divider->clk_id;
-	u32 div_type = divider->div_type;
-	u32 value, div;
+	u32 value;
 	int ret;
 	const struct zynqmp_eemi_ops *eemi_ops = zynqmp_pm_get_eemi_ops();
 
 	value = zynqmp_divider_get_val(parent_rate, rate, divider->flags);
-	if (div_type == TYPE_DIV1) {
-		div = value & 0xFFFF;
-		div |= 0xffff << 16;
-	} else {
-		div = 0xffff;
-		div |= value << 16;
-	}
 
-	if (divider->flags & CLK_DIVIDER_POWER_OF_TWO)
-		div = __ffs(div);
+	/*
+	 * The clock framework calls set_rate for all the clocks below the
+	 * one whose rate changes, skip the firmware call if the divisor
+	 * stays the same.
+	 */
+	if (divider->div_valid && divider->div == value)
+		return 0;
 
-	ret = eemi_ops->clock_setdivider(clk_id, div);
+	ret = eemi_ops->clock_setdivider(clk_id,
+					 zynqmp_clk_divider_encode(divider,
+								   value));
 
-	if (ret)
+	if (ret) {
 		pr_warn_once("%s() set divider failed for %s, ret = %d\n",
 			     __func__, clk_name, ret);
+		divider->div_valid = false;
+	} else {
+		divider->div = value;
+		divider->div_valid = true;
+	}
 
 	return ret;
 }
@@ -267,6 +331,107 @@ static const struct clk_ops zynqmp_clk_divider_ro_ops = {
 	.round_rate = zynqmp_clk_divider_round_rate,
 };
 
+/**
+ * zynqmp_clk_get_divider() - Get the divider setting the rate of a clock
+ * @clk:	Clock
+ *
+ * The divider is @clk itself, or the first divider above it through clocks
+ * which keep the rate of their parent, such as gates.
+ *
+ * Return: the divider clock hardware, ERR_PTR(-ENOENT) if there is none or
+ *	   ERR_PTR(-EPERM) if it is read only
+ */
+struct clk_hw *zynqmp_clk_get_divider(struct clk *clk)
+{
+	struct clk_hw *hw = __clk_get_hw(clk), *parent;
+	struct zynqmp_clk_divider *divider;
+
+	mutex_lock(&zynqmp_clk_dividers_lock);
+	while (hw) {
+		list_for_each_entry(divider, &zynqmp_clk_dividers, node) {
+			if (&divider->hw != hw)
+				continue;
+
+			mutex_unlock(&zynqmp_clk_dividers_lock);
+			if (divider->flags & CLK_DIVIDER_READ_ONLY)
+				return ERR_PTR(-EPERM);
+			return hw;
+		}
+
+		parent = clk_hw_get_parent(hw);
+		if (!parent || clk_hw_get_rate(parent) != clk_hw_get_rate(hw))
+			break;
+		hw = parent;
+	}
+	mutex_unlock(&zynqmp_clk_dividers_lock);
+
+	return ERR_PTR(-ENOENT);
+}
+EXPORT_SYMBOL_GPL(zynqmp_clk_get_divider);
+
+/**
+ * zynqmp_clk_divider_round_fast() - Get the divisor for a rate
+ * @hw:		Divider from zynqmp_clk_get_divider()
+ * @rate:	Requested rate
+ * @div:	Divisor giving the closest rate
+ *
+ * The rate of the parent of the divider is assumed not to change, so the
+ * divisor can be computed once and set later by
+ * zynqmp_clk_divider_set_fast().
+ *
+ * Return: rate given by @div
+ */
+unsigned long zynqmp_clk_divider_round_fast(struct clk_hw *hw,
+					    unsigned long rate, u32 *div)
+{
+	struct zynqmp_clk_divider *divider = to_zynqmp_clk_divider(hw);
+	unsigned long parent_rate = clk_hw_get_rate(clk_hw_get_parent(hw));
+	u32 value;
+
+	value = zynqmp_divider_get_val(parent_rate, rate, divider->flags);
+	value = clamp_t(u32, value, 1, divider->max_div);
+	*div = value;
+
+	return DIV_ROUND_UP_ULL((u64)parent_rate, value);
+}
+EXPORT_SYMBOL_GPL(zynqmp_clk_divider_round_fast);
+
+/**
+ * zynqmp_clk_divider_set_fast() - Set a divisor without the clock framework
+ * @hw:		Divider from zynqmp_clk_get_divider()
+ * @div:	Divisor from zynqmp_clk_divider_round_fast()
+ *
+ * This is a single firmware call and takes no sleeping lock, so it can be
+ * used from scheduler context, e.g. for cpufreq fast switching. The caller
+ * must own the clock: the rate the clock framework has for the divider
+ * and the clocks below it is not updated.
+ *
+ * Return: 0 on success else error+reason
+ */
+int zynqmp_clk_divider_set_fast(struct clk_hw *hw, u32 div)
+{
+	const struct zynqmp_eemi_ops *eemi_ops = zynqmp_pm_get_eemi_ops();
+	struct zynqmp_clk_divider *divider = to_zynqmp_clk_divider(hw);
+	int ret;
+
+	if (divider->div_valid && divider->div == div)
+		return 0;
+
+	ret = eemi_ops->clock_setdivider(divider->clk_id,
+					 zynqmp_clk_divider_encode(divider,
+								   div));
+	if (ret) {
+		divider->div_valid = false;
+		return ret;
+	}
+
+	divider->div = div;
+	divider->div_valid = true;
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(zynqmp_clk_divider_set_fast);
+
 /**
  * zynqmp_clk_get_max_divisor() - Get maximum supported divisor from firmware.
  * @clk_id:		Id of clock
@@ -364,8 +529,12 @@ struct clk_hw *zynqmp_clk_register_divider(const char *name,
 	ret = clk_hw_register(NULL, hw);
 	if (ret) {
 		kfree(div);
-		hw = ERR_PTR(ret);
+		return ERR_PTR(ret);
 	}
 
+	mutex_lock(&zynqmp_clk_dividers_lock);
+	list_add_tail(&div->node, &zynqmp_clk_dividers);
+	mutex_unlock(&zynqmp_clk_dividers_lock);
+
 	return hw;
 }
@@ -91,7 +91,9 @@ static const struct of_device_id whitelist[] __initconst = {
 	{ .compatible = "ti,omap5", },
 
 	{ .compatible = "xlnx,zynq-7000", },
+#if !IS_ENABLED(CONFIG_ARM_ZYNQMP_CPUFREQ)
 	{ .compatible = "xlnx,zynqmp", },
+#endif
 
 	{ }
 };
@@ -138,6 +140,10 @@ static const struct of_device_id blacklist[] __initconst = {
 	{ .compatible = "ti,am43", },
 	{ .compatible = "ti,dra7", },
 
+#if IS_ENABLED(CONFIG_ARM_ZYNQMP_CPUFREQ)
+	{ .compatible = "xlnx,zynqmp", },
+#endif
+
 	{ }
 };
 
@@ -0,0 +1,301 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Zynq UltraScale+ MPSoC APU cpufreq driver
+ *
+ * Copyright (C) 2020 Xilinx
+ *
+ * The APU clock is divided from a PLL whose rate does not change, so an
+ * APU frequency change is a single write of the divisor. The divisor of
+ * every OPP is computed once, and written with one firmware call instead of
+ * a clk_set_rate() walking the clock tree under the clock framework mutex.
+ * That does not sleep, so schedutil switches the frequency directly from
+ * the scheduler (fast switch) instead of waking its kthread.
+ *
+ * The driver owns the APU clock divider: the rate the clock framework has
+ * for the APU clock is the one it had when the driver was loaded.
+ */
+
+#include <linux/clk.h>
+#include <linux/clk/zynqmp.h>
+#include <linux/cpu.h>
+#include <linux/cpufreq.h>
+#include <linux/err.h>
+#include <linux/jiffies.h>
+#include <linux/module.h>
+#include <linux/of.h>
+#include <linux/platform_device.h>
+#include <linux/pm_opp.h>
+#include <linux/slab.h>
+
+/**
+ * struct zynqmp_cpufreq_data - APU cpufreq policy data
+ * @cpu_dev:	Device of the policy CPU
+ * @clk:	APU clock
+ * @div_hw:	Divider of the APU clock
+ * @cur:	Current frequency in kHz
+ */
+struct zynqmp_cpufreq_data {
+	struct device *cpu_dev;
+	struct clk *clk;
+	struct clk_hw *div_hw;
+	unsigned int cur;
+};
+
+static struct platform_device *zynqmp_cpufreq_pdev;
+
+/**
+ * zynqmp_cpufreq_set - Switch the APU to a frequency of the table
+ * @policy:	cpufreq policy
+ * @index:	Index of the frequency in the table
+ *
+ * Return: 0 on success else error code
+ */
+static int zynqmp_cpufreq_set(struct cpufreq_policy *policy,
+			      unsigned int index)
+{
+	struct zynqmp_cpufreq_data *data = policy->driver_data;
+	struct cpufreq_frequency_table *pos = &policy->freq_table[index];
+	int ret;
+
+	ret = zynqmp_clk_divider_set_fast(data->div_hw, pos->driver_data);
+	if (ret)
+		return ret;
+
+	WRITE_ONCE(data->cur, pos->frequency);
+	arch_set_freq_scale(policy->related_cpus, pos->frequency,
+			    policy->cpuinfo.max_freq);
+
+	return 0;
+}
+
+static int zynqmp_cpufreq_target_index(struct cpufreq_policy *policy,
+				       unsigned int index)
+{
+	return zynqmp_cpufreq_set(policy, index);
+}
+
+static unsigned int zynqmp_cpufreq_fast_switch(struct cpufreq_policy *policy,
+					       unsigned int target_freq)
+{
+	int index = cpufreq_table_find_index_dl(policy, target_freq);
+
+	if (zynqmp_cpufreq_set(policy, index))
+		return 0;
+
+	return policy->freq_table[index].frequency;
+}
+
+static unsigned int zynqmp_cpufreq_get(unsigned int cpu)
+{
+	struct cpufreq_policy *policy = cpufreq_cpu_get_raw(cpu);
+	struct zynqmp_cpufreq_data *data;
+
+	if (!policy)
+		return 0;
+
+	data = policy->driver_data;
+
+	return READ_ONCE(data->cur);
+}
+
+/**
+ * zynqmp_cpufreq_init_table - Cache the divisors of the OPPs
+ * @policy:	cpufreq policy
+ *
+ * The frequencies of the table become the ones the divisors give.
+ *
+ * Return: Index of the frequency closest to the current APU clock rate
+ */
+static unsigned int zynqmp_cpufreq_init_table(struct cpufreq_policy *policy)
+{
+	struct zynqmp_cpufreq_data *data = policy->driver_data;
+	unsigned long cur = clk_get_rate(data->clk) / 1000;
+	struct cpufreq_frequency_table *pos;
+	unsigned long rate, diff, best = ULONG_MAX;
+	unsigned int index = 0;
+	u32 div;
+
+	cpufreq_for_each_valid_entry(pos, policy->freq_table) {
+		rate = zynqmp_clk_divider_round_fast(data->div_hw,
+						     pos->frequency * 1000UL,
+						     &div);
+		pos->driver_data = div;
+		pos->frequency = rate / 1000;
+
+		diff = max_t(unsigned long, pos->frequency, cur) -
+		       min_t(unsigned long, pos->frequency, cur);
+		if (diff < best) {
+			best = diff;
+			index = pos - policy->freq_table;
+		}
+	}
+
+	return index;
+}
+
+static int zynqmp_cpufreq_init(struct cpufreq_policy *policy)
+{
+	struct cpufreq_frequency_table *freq_table;
+	struct zynqmp_cpufreq_data *data;
+	struct device *cpu_dev;
+	unsigned int latency;
+	int ret;
+
+	cpu_dev = get_cpu_device(policy->cpu);
+	if (!cpu_dev)
+		return -ENODEV;
+
+	data = kzalloc(sizeof(*data), GFP_KERNEL);
+	if (!data)
+		return -ENOMEM;
+
+	data->cpu_dev = cpu_dev;
+	data->clk = clk_get(cpu_dev, NULL);
+	if (IS_ERR(data->clk)) {
+		ret = PTR_ERR(data->clk);
+		goto err_free;
+	}
+
+	data->div_hw = zynqmp_clk_get_divider(data->clk);
+	if (IS_ERR(data->div_hw)) {
+		ret = PTR_ERR(data->div_hw);
+		dev_err(cpu_dev, "no divider for the APU clock: %d\n", ret);
+		goto err_clk;
+	}
+
+	/* All the APU cores run from the APU clock */
+	cpumask_copy(policy->cpus, cpu_possible_mask);
+
+	ret = dev_pm_opp_of_cpumask_add_table(policy->cpus);
+	if (ret) {
+		dev_err(cpu_dev, "no OPP table: %d\n", ret);
+		goto err_clk;
+	}
+
+	ret = dev_pm_opp_init_cpufreq_table(cpu_dev, &freq_table);
+	if (ret) {
+		dev_err(cpu_dev, "failed to init cpufreq table: %d\n", ret);
+		goto err_opp;
+	}
+
+	policy->driver_data = data;
+	policy->freq_table = freq_table;
+
+	/* Start from a known divisor, the table ones may be rounded */
+	ret = zynqmp_cpufreq_set(policy, zynqmp_cpufreq_init_table(policy));
+	if (ret)
+		goto err_table;
+
+	latency = dev_pm_opp_get_max_clock_latency(cpu_dev);
+	policy->cpuinfo.transition_latency = latency ?: CPUFREQ_ETERNAL;
+	/*
+	 * A switch is one firmware call, let schedutil switch up to once per
+	 * tick instead of deriving a rate limit from the latency.
+	 */
+	policy->transition_delay_us = jiffies_to_usecs(1);
+	policy->fast_switch_possible = true;
+	policy->dvfs_possible_from_any_cpu = true;
+
+	return 0;
+
+err_table:
+	dev_pm_opp_free_cpufreq_table(cpu_dev, &freq_table);
+err_opp:
+	dev_pm_opp_of_cpumask_remove_table(policy->cpus);
+err_clk:
+	clk_put(data->clk);
+err_free:
+	kfree(data);
+	return ret;
+}
+
+static int zynqmp_cpufreq_exit(struct cpufreq_policy *policy)
+{
+	struct zynqmp_cpufreq_data *data = policy->driver_data;
+
+	dev_pm_opp_free_cpufreq_table(data->cpu_dev, &policy->freq_table);
+	dev_pm_opp_of_cpumask_remove_table(policy->related_cpus);
+	clk_put(data->clk);
+	kfree(data);
+
+	return 0;
+}
+
+static struct cpufreq_driver zynqmp_cpufreq_driver = {
+	.flags		= CPUFREQ_STICKY | CPUFREQ_NEED_INITIAL_FREQ_CHECK,
+	.verify		= cpufreq_generic_frequency_table_verify,
+	.target_index	= zynqmp_cpufreq_target_index,
+	.fast_switch	= zynqmp_cpufreq_fast_switch,
+	.get		= zynqmp_cpufreq_get,
+	.init		= zynqmp_cpufreq_init,
+	.exit		= zynqmp_cpufreq_exit,
+	.name		= "zynqmp-cpufreq",
+	.attr		= cpufreq_generic_attr,
+};
+
+/*
+ * The APU clock comes from the ZynqMP clock driver, which may not have
+ * probed yet, so the cpufreq driver is registered from a probe which can
+ * be deferred.
+ */
+static int zynqmp_cpufreq_probe(struct platform_device *pdev)
+{
+	struct device *cpu_dev = get_cpu_device(0);
+	struct clk *clk;
+
+	if (!cpu_dev)
+		return -ENODEV;
+
+	clk = clk_get(cpu_dev, NULL);
+	if (IS_ERR(clk))
+		return PTR_ERR(clk);
+	clk_put(clk);
+
+	return cpufreq_register_driver(&zynqmp_cpufreq_driver);
+}
+
+static int zynqmp_cpufreq_remove(struct platform_device *pdev)
+{
+	return cpufreq_unregister_driver(&zynqmp_cpufreq_driver);
+}
+
+static struct platform_driver zynqmp_cpufreq_platdrv = {
+	.driver = {
+		.name	= "zynqmp-cpufreq",
+	},
+	.probe		= zynqmp_cpufreq_probe,
+	.remove		= zynqmp_cpufreq_remove,
+};
+
+static int __init zynqmp_cpufreq_module_init(void)
+{
+	int ret;
+
+	if (!of_machine_is_compatible("xlnx,zynqmp"))
+		return -ENODEV;
+
+	ret = platform_driver_register(&zynqmp_cpufreq_platdrv);
+	if (ret)
+		return ret;
+
+	zynqmp_cpufreq_pdev = platform_device_register_simple("zynqmp-cpufreq",
+							      -1, NULL, 0);
+	if (IS_ERR(zynqmp_cpufreq_pdev)) {
+		platform_driver_unregister(&zynqmp_cpufreq_platdrv);
+		return PTR_ERR(zynqmp_cpufreq_pdev);
+	}
+
+	return 0;
+}
+module_init(zynqmp_cpufreq_module_init);
+
+static void __exit zynqmp_cpufreq_module_exit(void)
+{
+	platform_device_unregister(zynqmp_cpufreq_pdev);
+	platform_driver_unregister(&zynqmp_cpufreq_platdrv);
+}
+module_exit(zynqmp_cpufreq_module_exit);
+
+MODULE_AUTHOR("Xilinx, Inc.");
+MODULE_DESCRIPTION("Zynq UltraScale+ MPSoC APU cpufreq driver");
+MODULE_LICENSE("GPL v2");
@@ -10,32 +10,116 @@
  * to implement two idle states -
  * #1 wait-for-interrupt
  * #2 wait-for-interrupt and RAM self refresh
+ * The second state is replaced by the "arm,idle-state" nodes referenced by
+ * the cpu-idle-states property of the CPUs, if any.
+ *
+ * With debugfs, zynq_idle_stats reports per CPU and state a residency
+ * histogram in power of two microsecond buckets (<1us, <2us, <4us, ...)
+ * and the exit latency measured on timer wakeups.
  *
  * Maintainer: Michal Simek <michal.simek@xilinx.com>
  */
 
 #include <linux/init.h>
 #include <linux/cpuidle.h>
+#include <linux/debugfs.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
+#include <linux/of.h>
 #include <linux/platform_device.h>
+#include <linux/seq_file.h>
 #include <asm/cpuidle.h>
 
+#include "dt_idle_states.h"
+
 #define ZYNQ_MAX_STATES		2
 
+/* Residency histogram buckets, in powers of two microseconds */
+#define ZYNQ_HIST_BUCKETS	16
+
+/**
+ * struct zynq_idle_stats - Per CPU idle statistics
+ * @hist:	Residency histogram of each state
+ * @exit_count:	Timer wakeups the exit latency of each state was measured on
+ * @exit_total:	Sum of the measured exit latencies in ns
+ * @exit_max:	Longest measured exit latency in ns
+ */
+struct zynq_idle_stats {
+	u64 hist[CPUIDLE_STATE_MAX][ZYNQ_HIST_BUCKETS];
+	u64 exit_count[CPUIDLE_STATE_MAX];
+	u64 exit_total[CPUIDLE_STATE_MAX];
+	u64 exit_max[CPUIDLE_STATE_MAX];
+};
+
+static DEFINE_PER_CPU(struct zynq_idle_stats, zynq_idle_stats);
+
+/*
+ * The wakeup of a CPU idling until its next timer is late by the exit
+ * latency of the state, interrupts are still disabled at that point.
+ */
+static void zynq_idle_account(struct cpuidle_device *dev, int index,
+			      ktime_t start, ktime_t end)
+{
+	struct zynq_idle_stats *stats = this_cpu_ptr(&zynq_idle_stats);
+	ktime_t timer = READ_ONCE(dev->next_hrtimer);
+	s64 us = ktime_to_us(ktime_sub(end, start));
+	unsigned int bucket = 0;
+	u64 exit;
+
+	if (us > 0)
+		bucket = min(ilog2(us) + 1, ZYNQ_HIST_BUCKETS - 1);
+	stats->hist[index][bucket]++;
+
+	if (!timer || ktime_before(end, timer) || ktime_before(timer, start))
+		return;
+
+	exit = ktime_to_ns(ktime_sub(end, timer));
+	stats->exit_count[index]++;
+	stats->exit_total[index] += exit;
+	if (exit > stats->exit_max[index])
+		stats->exit_max[index] = exit;
+}
+
 /* Actual code that puts the SoC in different idle states */
 static int zynq_enter_idle(struct cpuidle_device *dev,
 			   struct cpuidle_driver *drv, int index)
 {
+	ktime_t start;
+
+	if (!IS_ENABLED(CONFIG_DEBUG_FS)) {
+		cpu_do_idle();
+		return index;
+	}
+
+	start = ktime_get();
+
 	/* Add code for DDR self refresh start */
 	cpu_do_idle();
 
+	zynq_idle_account(dev, index, start, ktime_get());
+
 	return index;
 }
 
+/* Timekeeping is suspended, nothing can be measured */
+static void zynq_enter_s2idle(struct cpuidle_device *dev,
+			      struct cpuidle_driver *drv, int index)
+{
+	cpu_do_idle();
+}
+
 static struct cpuidle_driver zynq_idle_driver = {
 	.name = "zynq_idle",
 	.owner = THIS_MODULE,
 	.states = {
-		ARM_CPUIDLE_WFI_STATE,
+		{
+			.enter			= zynq_enter_idle,
+			.exit_latency		= 1,
+			.target_residency	= 1,
+			.power_usage		= UINT_MAX,
+			.name			= "WFI",
+			.desc			= "ARM WFI",
+		},
 		{
 			.enter			= zynq_enter_idle,
 			.exit_latency		= 10,
@@ -48,12 +132,65 @@ static struct cpuidle_driver zynq_idle_driver = {
 	.state_count = ZYNQ_MAX_STATES,
 };
 
+/*
+ * Idle states described in the device tree replace the built-in RAM_SR
+ * state, so boards can use the latencies measured on them.
+ */
+static const struct of_device_id zynq_idle_state_match[] = {
+	{ .compatible = "arm,idle-state",
+	  .data = zynq_enter_idle },
+	{ },
+};
+
+static int zynq_idle_stats_show(struct seq_file *s, void *unused)
+{
+	struct cpuidle_driver *drv = &zynq_idle_driver;
+	struct zynq_idle_stats *stats;
+	int cpu, i, j;
+
+	for_each_possible_cpu(cpu) {
+		stats = per_cpu_ptr(&zynq_idle_stats, cpu);
+		seq_printf(s, "cpu%d\n", cpu);
+
+		for (i = 0; i < drv->state_count; i++) {
+			seq_printf(s, "  %-8s residency:", drv->states[i].name);
+			for (j = 0; j < ZYNQ_HIST_BUCKETS; j++)
+				seq_printf(s, " %llu", stats->hist[i][j]);
+			seq_printf(s, "\n  %-8s exit: count %llu avg %llu ns",
+				   "", stats->exit_count[i],
+				   stats->exit_count[i] ?
+				   div64_u64(stats->exit_total[i],
+					     stats->exit_count[i]) : 0);
+			seq_printf(s, " max %llu ns\n", stats->exit_max[i]);
+		}
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(zynq_idle_stats);
+
 /* Initialize CPU idle by registering the idle states */
 static int zynq_cpuidle_probe(struct platform_device *pdev)
 {
+	int i, ret;
+
 	pr_info("Xilinx Zynq CpuIdle Driver started\n");
 
-	return cpuidle_register(&zynq_idle_driver, NULL);
+	ret = dt_init_idle_driver(&zynq_idle_driver, zynq_idle_state_match, 1);
+	if (ret < 0)
+		return ret;
+
+	for (i = 1; i < zynq_idle_driver.state_count; i++)
+		zynq_idle_driver.states[i].enter_s2idle = zynq_enter_s2idle;
+
+	ret = cpuidle_register(&zynq_idle_driver, NULL);
+	if (ret)
+		return ret;
+
+	debugfs_create_file("zynq_idle_stats", 0444, NULL, NULL,
+			    &zynq_idle_stats_fops);
+
+	return 0;
 }
 
 static struct platform_driver zynq_cpuidle_driver = {
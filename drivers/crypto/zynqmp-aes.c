@@ -4,10 +4,12 @@
  * Copyright (c) 2018 Xilinx Inc.
  */
 
+#include <crypto/aead.h>
 #include <crypto/aes.h>
 #include <crypto/scatterwalk.h>
 #include <linux/kernel.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
 #include <linux/of_device.h>
 #include <linux/scatterlist.h>
 #include <linux/spinlock.h>
@@ -30,12 +32,28 @@
 
 #define ZYNQMP_AES_BLOCKSIZE			0x04
 
+/*
+ * Requests up to this size are handled by the CPU, where the firmware call
+ * overhead dominates the engine throughput.
+ */
+#define ZYNQMP_AES_FALLBACK_THRESHOLD		4096
+
+struct zynqmp_aes_data;
+
 struct zynqmp_aes_dev {
 	struct list_head list;
 	struct device *dev;
 	/* the lock protects queue and dev list */
 	spinlock_t lock;
 	struct crypto_queue queue;
+	/* the buf_lock protects the DMA buffers */
+	struct mutex buf_lock;
+	char *buf;
+	size_t buf_size;
+	dma_addr_t buf_dma;
+	struct zynqmp_aes_data *abuf;
+	dma_addr_t abuf_dma;
+	unsigned int fallback_threshold;
 };
 
 struct zynqmp_aes_op {
@@ -47,6 +65,8 @@ struct zynqmp_aes_op {
 	u8 *iv;
 	u32 keylen;
 	u32 keytype;
+	struct crypto_aead *fallback;
+	bool fallback_key;
 };
 
 struct zynqmp_aes_data {
@@ -92,6 +112,29 @@ static struct zynqmp_aes_dev *zynqmp_aes_find_dev(struct zynqmp_aes_op *ctx)
 	return aes_dd;
 }
 
+/*
+ * The data buffer is kept across requests and only reallocated when a
+ * request doesn't fit, so that the common case doesn't allocate and free
+ * coherent memory for every request. Called with buf_lock held.
+ */
+static int zynqmp_aes_get_buf(struct zynqmp_aes_dev *dd, size_t size)
+{
+	if (size <= dd->buf_size)
+		return 0;
+
+	if (dd->buf)
+		dma_free_coherent(dd->dev, dd->buf_size, dd->buf, dd->buf_dma);
+
+	dd->buf = dma_alloc_coherent(dd->dev, size, &dd->buf_dma, GFP_KERNEL);
+	if (!dd->buf) {
+		dd->buf_size = 0;
+		return -ENOMEM;
+	}
+	dd->buf_size = size;
+
+	return 0;
+}
+
 static int zynqmp_setkey_blk(struct crypto_tfm *tfm, const u8 *key,
 			     unsigned int len)
 {
@@ -100,6 +143,9 @@ static int zynqmp_setkey_blk(struct crypto_tfm *tfm, const u8 *key,
 	op->keylen = len;
 	memcpy(op->key, key, len);
 
+	op->fallback_key = op->fallback && len == ZYNQMP_AES_KEY_SIZE &&
+			   !crypto_aead_setkey(op->fallback, key, len);
+
 	return 0;
 }
 
@@ -113,6 +159,43 @@ static int zynqmp_setkeytype(struct crypto_tfm *tfm, const u8 *keytype,
 	return 0;
 }
 
+/*
+ * With a user key the engine computes AES-256-GCM without associated data,
+ * the tag following the data, which is what gcm(aes) on the CPU does too.
+ */
+static int zynqmp_aes_fallback(struct blkcipher_desc *desc,
+			       struct scatterlist *dst,
+			       struct scatterlist *src,
+			       unsigned int nbytes,
+			       unsigned int flags)
+{
+	struct zynqmp_aes_op *op = crypto_blkcipher_ctx(desc->tfm);
+	struct aead_request *req;
+	DECLARE_CRYPTO_WAIT(wait);
+	int ret;
+
+	req = aead_request_alloc(op->fallback, GFP_KERNEL);
+	if (!req)
+		return -ENOMEM;
+
+	aead_request_set_callback(req, CRYPTO_TFM_REQ_MAY_SLEEP,
+				  crypto_req_done, &wait);
+	aead_request_set_ad(req, 0);
+	if (flags == ZYNQMP_AES_ENCRYPT) {
+		aead_request_set_crypt(req, src, dst,
+				       nbytes - ZYNQMP_AES_GCM_SIZE,
+				       desc->info);
+		ret = crypto_wait_req(crypto_aead_encrypt(req), &wait);
+	} else {
+		aead_request_set_crypt(req, src, dst, nbytes, desc->info);
+		ret = crypto_wait_req(crypto_aead_decrypt(req), &wait);
+	}
+
+	aead_request_free(req);
+
+	return ret;
+}
+
 static int zynqmp_aes_xcrypt(struct blkcipher_desc *desc,
 			     struct scatterlist *dst,
 			     struct scatterlist *src,
@@ -122,13 +205,18 @@ static int zynqmp_aes_xcrypt(struct blkcipher_desc *desc,
 	struct zynqmp_aes_op *op = crypto_blkcipher_ctx(desc->tfm);
 	struct zynqmp_aes_dev *dd = zynqmp_aes_find_dev(op);
 	int err, ret, copy_bytes, src_data = 0, dst_data = 0;
-	dma_addr_t dma_addr, dma_addr_buf;
-	struct zynqmp_aes_data *abuf;
+	struct zynqmp_aes_data *abuf = dd->abuf;
 	struct blkcipher_walk walk;
+	dma_addr_t dma_addr;
 	unsigned int data_size;
 	size_t dma_size;
 	char *kbuf;
 
+	if (op->keytype == ZYNQMP_AES_KUP_KEY && op->fallback_key &&
+	    nbytes >= ZYNQMP_AES_GCM_SIZE &&
+	    nbytes <= READ_ONCE(dd->fallback_threshold))
+		return zynqmp_aes_fallback(desc, dst, src, nbytes, flags);
+
 	if (!eemi_ops->aes)
 		return -ENOTSUPP;
 
@@ -138,16 +226,14 @@ static int zynqmp_aes_xcrypt(struct blkcipher_desc *desc,
 	else
 		dma_size = nbytes + ZYNQMP_AES_IV_SIZE;
 
-	kbuf = dma_alloc_coherent(dd->dev, dma_size, &dma_addr, GFP_KERNEL);
-	if (!kbuf)
-		return -ENOMEM;
-
-	abuf = dma_alloc_coherent(dd->dev, sizeof(struct zynqmp_aes_data),
-				  &dma_addr_buf, GFP_KERNEL);
-	if (!abuf) {
-		dma_free_coherent(dd->dev, dma_size, kbuf, dma_addr);
-		return -ENOMEM;
+	mutex_lock(&dd->buf_lock);
+	err = zynqmp_aes_get_buf(dd, dma_size);
+	if (err) {
+		mutex_unlock(&dd->buf_lock);
+		return err;
 	}
+	kbuf = dd->buf;
+	dma_addr = dd->buf_dma;
 
 	data_size = nbytes;
 	blkcipher_walk_init(&walk, dst, src, data_size);
@@ -177,7 +263,7 @@ static int zynqmp_aes_xcrypt(struct blkcipher_desc *desc,
 	} else {
 		abuf->key = 0;
 	}
-	eemi_ops->aes(dma_addr_buf, &ret);
+	eemi_ops->aes(dd->abuf_dma, &ret);
 
 	if (ret != 0) {
 		switch (ret) {
@@ -214,9 +300,7 @@ static int zynqmp_aes_xcrypt(struct blkcipher_desc *desc,
 		err = blkcipher_walk_done(desc, &walk, nbytes);
 	}
 END:
-	dma_free_coherent(dd->dev, dma_size, kbuf, dma_addr);
-	dma_free_coherent(dd->dev, sizeof(struct zynqmp_aes_data),
-			  abuf, dma_addr_buf);
+	mutex_unlock(&dd->buf_lock);
 	return err;
 }
 
@@ -236,6 +320,35 @@ static int zynqmp_aes_encrypt(struct blkcipher_desc *desc,
 	return zynqmp_aes_xcrypt(desc, dst, src, nbytes, ZYNQMP_AES_ENCRYPT);
 }
 
+static int zynqmp_aes_cra_init(struct crypto_tfm *tfm)
+{
+	struct zynqmp_aes_op *op = crypto_tfm_ctx(tfm);
+	struct crypto_aead *fallback;
+
+	/* The engine is still used for every request without a fallback */
+	fallback = crypto_alloc_aead("gcm(aes)", 0, CRYPTO_ALG_ASYNC |
+				     CRYPTO_ALG_NEED_FALLBACK);
+	if (IS_ERR(fallback))
+		return 0;
+
+	if (crypto_aead_setauthsize(fallback, ZYNQMP_AES_GCM_SIZE)) {
+		crypto_free_aead(fallback);
+		return 0;
+	}
+
+	op->fallback = fallback;
+
+	return 0;
+}
+
+static void zynqmp_aes_cra_exit(struct crypto_tfm *tfm)
+{
+	struct zynqmp_aes_op *op = crypto_tfm_ctx(tfm);
+
+	if (op->fallback)
+		crypto_free_aead(op->fallback);
+}
+
 static struct crypto_alg zynqmp_alg = {
 	.cra_name		=	"xilinx-zynqmp-aes",
 	.cra_driver_name	=	"zynqmp-aes",
@@ -247,6 +360,8 @@ static struct crypto_alg zynqmp_alg = {
 	.cra_alignmask		=	15,
 	.cra_type		=	&crypto_blkcipher_type,
 	.cra_module		=	THIS_MODULE,
+	.cra_init		=	zynqmp_aes_cra_init,
+	.cra_exit		=	zynqmp_aes_cra_exit,
 	.cra_u			=	{
 	.blkcipher	=	{
 			.min_keysize	=	0,
@@ -260,6 +375,34 @@ static struct crypto_alg zynqmp_alg = {
 	}
 };
 
+static ssize_t fallback_threshold_show(struct device *dev,
+				       struct device_attribute *attr,
+				       char *buf)
+{
+	struct zynqmp_aes_dev *aes_dd = dev_get_drvdata(dev);
+
+	return snprintf(buf, PAGE_SIZE, "%u\n", aes_dd->fallback_threshold);
+}
+
+static ssize_t fallback_threshold_store(struct device *dev,
+					struct device_attribute *attr,
+					const char *buf, size_t count)
+{
+	struct zynqmp_aes_dev *aes_dd = dev_get_drvdata(dev);
+	unsigned int threshold;
+	int ret;
+
+	ret = kstrtouint(buf, 0, &threshold);
+	if (ret)
+		return ret;
+
+	WRITE_ONCE(aes_dd->fallback_threshold, threshold);
+
+	return count;
+}
+
+static DEVICE_ATTR_RW(fallback_threshold);
+
 static const struct of_device_id zynqmp_aes_dt_ids[] = {
 	{ .compatible = "xlnx,zynqmp-aes" },
 	{ /* sentinel */ }
@@ -289,10 +432,21 @@ static int zynqmp_aes_probe(struct platform_device *pdev)
 		return ret;
 	}
 
+	aes_dd->abuf = dmam_alloc_coherent(dev, sizeof(*aes_dd->abuf),
+					   &aes_dd->abuf_dma, GFP_KERNEL);
+	if (!aes_dd->abuf)
+		return -ENOMEM;
+
+	mutex_init(&aes_dd->buf_lock);
+	aes_dd->fallback_threshold = ZYNQMP_AES_FALLBACK_THRESHOLD;
 	INIT_LIST_HEAD(&aes_dd->list);
 	crypto_init_queue(&aes_dd->queue, ZYNQMP_AES_QUEUE_LENGTH);
 	list_add_tail(&aes_dd->list, &zynqmp_aes.dev_list);
 
+	ret = device_create_file(dev, &dev_attr_fallback_threshold);
+	if (ret)
+		goto err_file;
+
 	ret = crypto_register_alg(&zynqmp_alg);
 	if (ret)
 		goto err_algs;
@@ -301,6 +455,8 @@ static int zynqmp_aes_probe(struct platform_device *pdev)
 	return 0;
 
 err_algs:
+	device_remove_file(dev, &dev_attr_fallback_threshold);
+err_file:
 	list_del(&aes_dd->list);
 	dev_err(dev, "initialization failed.\n");
 
@@ -316,6 +472,10 @@ static int zynqmp_aes_remove(struct platform_device *pdev)
 		return -ENODEV;
 	list_del(&aes_dd->list);
 	crypto_unregister_alg(&zynqmp_alg);
+	device_remove_file(&pdev->dev, &dev_attr_fallback_threshold);
+	if (aes_dd->buf)
+		dma_free_coherent(aes_dd->dev, aes_dd->buf_size, aes_dd->buf,
+				  aes_dd->buf_dma);
 	return 0;
 }
 
@@ -6,6 +6,8 @@
 #include <linux/module.h>
 #include <linux/kernel.h>
 #include <linux/crypto.h>
+#include <linux/ktime.h>
+#include <linux/mutex.h>
 #include <linux/spinlock.h>
 #include <crypto/algapi.h>
 #include <crypto/aes.h>
@@ -39,6 +41,13 @@ struct zynqmp_rsa_dev {
 	/* the lock protects queue and dev list*/
 	spinlock_t              lock;
 	struct crypto_queue     queue;
+	/* the buf_lock protects the DMA buffer and the statistics */
+	struct mutex            buf_lock;
+	char                    *buf;
+	size_t                  buf_size;
+	dma_addr_t              buf_dma;
+	u64                     ops;
+	u64                     busy_ns;
 };
 
 struct zynqmp_rsa_drv {
@@ -74,6 +83,28 @@ static struct zynqmp_rsa_dev *zynqmp_rsa_find_dev(struct zynqmp_rsa_op *ctx)
 	return rsa_dd;
 }
 
+/*
+ * The data buffer is kept across operations and only reallocated when an
+ * operation doesn't fit. Called with buf_lock held.
+ */
+static int zynqmp_rsa_get_buf(struct zynqmp_rsa_dev *dd, size_t size)
+{
+	if (size <= dd->buf_size)
+		return 0;
+
+	if (dd->buf)
+		dma_free_coherent(dd->dev, dd->buf_size, dd->buf, dd->buf_dma);
+
+	dd->buf = dma_alloc_coherent(dd->dev, size, &dd->buf_dma, GFP_KERNEL);
+	if (!dd->buf) {
+		dd->buf_size = 0;
+		return -ENOMEM;
+	}
+	dd->buf_size = size;
+
+	return 0;
+}
+
 static int zynqmp_setkey_blk(struct crypto_tfm *tfm, const u8 *key,
 			     unsigned int len)
 {
@@ -90,19 +121,21 @@ static int zynqmp_rsa_xcrypt(struct blkcipher_desc *desc,
 {
 	struct zynqmp_rsa_op *op = crypto_blkcipher_ctx(desc->tfm);
 	struct zynqmp_rsa_dev *dd = zynqmp_rsa_find_dev(op);
-	int err, datasize, src_data = 0, dst_data = 0;
+	int err, ret, datasize, src_data = 0, dst_data = 0;
 	struct blkcipher_walk walk;
 	char *kbuf;
-	size_t dma_size;
-	dma_addr_t dma_addr;
+	ktime_t start;
 
 	if (!eemi_ops->rsa)
 		return -ENOTSUPP;
 
-	dma_size = nbytes + op->keylen;
-	kbuf = dma_alloc_coherent(dd->dev, dma_size, &dma_addr, GFP_KERNEL);
-	if (!kbuf)
-		return -ENOMEM;
+	mutex_lock(&dd->buf_lock);
+	err = zynqmp_rsa_get_buf(dd, nbytes + op->keylen);
+	if (err) {
+		mutex_unlock(&dd->buf_lock);
+		return err;
+	}
+	kbuf = dd->buf;
 
 	blkcipher_walk_init(&walk, dst, src, nbytes);
 	err = blkcipher_walk_virt(desc, &walk);
@@ -114,7 +147,15 @@ static int zynqmp_rsa_xcrypt(struct blkcipher_desc *desc,
 		err = blkcipher_walk_done(desc, &walk, 0);
 	}
 	memcpy(kbuf + nbytes, op->key, op->keylen);
-	eemi_ops->rsa(dma_addr, nbytes, flags);
+
+	start = ktime_get();
+	ret = eemi_ops->rsa(dd->buf_dma, nbytes, flags);
+	dd->busy_ns += ktime_to_ns(ktime_sub(ktime_get(), start));
+	dd->ops++;
+	if (ret) {
+		mutex_unlock(&dd->buf_lock);
+		return ret;
+	}
 
 	blkcipher_walk_init(&walk, dst, src, nbytes);
 	err = blkcipher_walk_virt(desc, &walk);
@@ -124,7 +165,7 @@ static int zynqmp_rsa_xcrypt(struct blkcipher_desc *desc,
 		dst_data = dst_data + datasize;
 		err = blkcipher_walk_done(desc, &walk, 0);
 	}
-	dma_free_coherent(dd->dev, dma_size, kbuf, dma_addr);
+	mutex_unlock(&dd->buf_lock);
 	return err;
 }
 
@@ -167,6 +208,47 @@ static struct crypto_alg zynqmp_alg = {
 	}
 };
 
+static ssize_t ops_show(struct device *dev, struct device_attribute *attr,
+			char *buf)
+{
+	struct zynqmp_rsa_dev *rsa_dd = dev_get_drvdata(dev);
+	u64 ops;
+
+	mutex_lock(&rsa_dd->buf_lock);
+	ops = rsa_dd->ops;
+	mutex_unlock(&rsa_dd->buf_lock);
+
+	return snprintf(buf, PAGE_SIZE, "%llu\n", ops);
+}
+
+static DEVICE_ATTR_RO(ops);
+
+static ssize_t busy_ns_show(struct device *dev, struct device_attribute *attr,
+			    char *buf)
+{
+	struct zynqmp_rsa_dev *rsa_dd = dev_get_drvdata(dev);
+	u64 busy_ns;
+
+	mutex_lock(&rsa_dd->buf_lock);
+	busy_ns = rsa_dd->busy_ns;
+	mutex_unlock(&rsa_dd->buf_lock);
+
+	return snprintf(buf, PAGE_SIZE, "%llu\n", busy_ns);
+}
+
+static DEVICE_ATTR_RO(busy_ns);
+
+static struct attribute *zynqmp_rsa_attrs[] = {
+	&dev_attr_ops.attr,
+	&dev_attr_busy_ns.attr,
+	NULL,
+};
+
+static const struct attribute_group zynqmp_rsa_attr_group = {
+	.name = "statistics",
+	.attrs = zynqmp_rsa_attrs,
+};
+
 static const struct of_device_id zynqmp_rsa_dt_ids[] = {
 	{ .compatible = "xlnx,zynqmp-rsa" },
 	{ /* sentinel */ }
@@ -197,11 +279,16 @@ static int zynqmp_rsa_probe(struct platform_device *pdev)
 
 	INIT_LIST_HEAD(&rsa_dd->list);
 	spin_lock_init(&rsa_dd->lock);
+	mutex_init(&rsa_dd->buf_lock);
 	crypto_init_queue(&rsa_dd->queue, ZYNQMP_RSA_QUEUE_LENGTH);
 	spin_lock(&zynqmp_rsa.lock);
 	list_add_tail(&rsa_dd->list, &zynqmp_rsa.dev_list);
 	spin_unlock(&zynqmp_rsa.lock);
 
+	ret = sysfs_create_group(&dev->kobj, &zynqmp_rsa_attr_group);
+	if (ret)
+		goto err_group;
+
 	ret = crypto_register_alg(&zynqmp_alg);
 	if (ret)
 		goto err_algs;
@@ -209,6 +296,8 @@ static int zynqmp_rsa_probe(struct platform_device *pdev)
 	return 0;
 
 err_algs:
+	sysfs_remove_group(&dev->kobj, &zynqmp_rsa_attr_group);
+err_group:
 	spin_lock(&zynqmp_rsa.lock);
 	list_del(&rsa_dd->list);
 	spin_unlock(&zynqmp_rsa.lock);
@@ -218,7 +307,18 @@ static int zynqmp_rsa_probe(struct platform_device *pdev)
 
 static int zynqmp_rsa_remove(struct platform_device *pdev)
 {
+	struct zynqmp_rsa_dev *rsa_dd = platform_get_drvdata(pdev);
+
 	crypto_unregister_alg(&zynqmp_alg);
+	sysfs_remove_group(&pdev->dev.kobj, &zynqmp_rsa_attr_group);
+
+	spin_lock(&zynqmp_rsa.lock);
+	list_del(&rsa_dd->list);
+	spin_unlock(&zynqmp_rsa.lock);
+
+	if (rsa_dd->buf)
+		dma_free_coherent(rsa_dd->dev, rsa_dd->buf_size, rsa_dd->buf,
+				  rsa_dd->buf_dma);
 	return 0;
 }
 
@@ -3,14 +3,15 @@
  * Copyright (C) 2017 Xilinx, Inc.
  */
 
-#include <asm/cacheflush.h>
 #include <linux/kernel.h>
 #include <linux/module.h>
 #include <linux/io.h>
+#include <linux/mutex.h>
 #include <linux/platform_device.h>
 #include <linux/device.h>
 #include <linux/init.h>
 #include <linux/scatterlist.h>
+#include <linux/sizes.h>
 #include <linux/dma-mapping.h>
 #include <linux/of_device.h>
 #include <linux/crypto.h>
@@ -27,6 +28,7 @@
 #define ZYNQMP_SHA3_FINAL	4
 
 #define ZYNQMP_SHA_QUEUE_LENGTH	1
+#define ZYNQMP_SHA_DMA_SIZE	SZ_64K
 
 static const struct zynqmp_eemi_ops *eemi_ops;
 struct zynqmp_sha_dev;
@@ -55,6 +57,11 @@ struct zynqmp_sha_dev {
 	unsigned long		flags;
 	struct crypto_queue	queue;
 	struct ahash_request	*req;
+
+	/* the buf_lock protects the bounce buffer */
+	struct mutex		buf_lock;
+	char			*buf;
+	dma_addr_t		buf_dma;
 };
 
 struct zynqmp_sha_drv {
@@ -101,13 +108,39 @@ static int zynqmp_sha_init(struct ahash_request *req)
 	return ret;
 }
 
+/*
+ * Hash the request data in place if it is mapped as a single DMA segment,
+ * which is the case for a single scatterlist entry or when an IOMMU merges
+ * the entries. Returns -EAGAIN if the data has to go through the bounce
+ * buffer.
+ */
+static int zynqmp_sha_update_sg(struct zynqmp_sha_dev *dd,
+				struct ahash_request *req)
+{
+	int nents, mapped, ret = -EAGAIN;
+
+	nents = sg_nents_for_len(req->src, req->nbytes);
+	if (nents < 0)
+		return nents;
+
+	mapped = dma_map_sg(dd->dev, req->src, nents, DMA_TO_DEVICE);
+	if (!mapped)
+		return -EAGAIN;
+
+	if (mapped == 1 && sg_dma_len(req->src) >= req->nbytes)
+		ret = eemi_ops->sha_hash(sg_dma_address(req->src),
+					 req->nbytes, ZYNQMP_SHA3_UPDATE);
+
+	dma_unmap_sg(dd->dev, req->src, nents, DMA_TO_DEVICE);
+
+	return ret;
+}
+
 static int zynqmp_sha_update(struct ahash_request *req)
 {
 	struct zynqmp_sha_ctx *tctx = crypto_tfm_ctx(req->base.tfm);
 	struct zynqmp_sha_dev *dd = tctx->dd;
-	char *kbuf;
-	size_t dma_size = req->nbytes;
-	dma_addr_t dma_addr;
+	unsigned int offset, len;
 	int ret;
 
 	if (!req->nbytes)
@@ -116,15 +149,21 @@ static int zynqmp_sha_update(struct ahash_request *req)
 	if (!eemi_ops->sha_hash)
 		return -ENOTSUPP;
 
-	kbuf = dma_alloc_coherent(dd->dev, dma_size, &dma_addr, GFP_KERNEL);
-	if (!kbuf)
-		return -ENOMEM;
-
-	scatterwalk_map_and_copy(kbuf, req->src, 0, req->nbytes, 0);
-	 __flush_cache_user_range((unsigned long)kbuf,
-				  (unsigned long)kbuf + dma_size);
-	ret = eemi_ops->sha_hash(dma_addr, req->nbytes, ZYNQMP_SHA3_UPDATE);
-	dma_free_coherent(dd->dev, dma_size, kbuf, dma_addr);
+	ret = zynqmp_sha_update_sg(dd, req);
+	if (ret != -EAGAIN)
+		return ret;
+
+	/* Feed scattered data to the engine through the bounce buffer */
+	mutex_lock(&dd->buf_lock);
+	for (offset = 0; offset < req->nbytes; offset += len) {
+		len = min_t(unsigned int, req->nbytes - offset,
+			    ZYNQMP_SHA_DMA_SIZE);
+		scatterwalk_map_and_copy(dd->buf, req->src, offset, len, 0);
+		ret = eemi_ops->sha_hash(dd->buf_dma, len, ZYNQMP_SHA3_UPDATE);
+		if (ret)
+			break;
+	}
+	mutex_unlock(&dd->buf_lock);
 
 	return ret;
 }
@@ -133,21 +172,16 @@ static int zynqmp_sha_final(struct ahash_request *req)
 {
 	struct zynqmp_sha_ctx *tctx = crypto_tfm_ctx(req->base.tfm);
 	struct zynqmp_sha_dev *dd = tctx->dd;
-	char *kbuf;
-	size_t dma_size = SHA384_DIGEST_SIZE;
-	dma_addr_t dma_addr;
 	int ret;
 
 	if (!eemi_ops->sha_hash)
 		return -ENOTSUPP;
 
-	kbuf = dma_alloc_coherent(dd->dev, dma_size, &dma_addr, GFP_KERNEL);
-	if (!kbuf)
-		return -ENOMEM;
-
-	ret = eemi_ops->sha_hash(dma_addr, dma_size, ZYNQMP_SHA3_FINAL);
-	memcpy(req->result, kbuf, 48);
-	dma_free_coherent(dd->dev, dma_size, kbuf, dma_addr);
+	mutex_lock(&dd->buf_lock);
+	ret = eemi_ops->sha_hash(dd->buf_dma, SHA384_DIGEST_SIZE,
+				 ZYNQMP_SHA3_FINAL);
+	memcpy(req->result, dd->buf, SHA384_DIGEST_SIZE);
+	mutex_unlock(&dd->buf_lock);
 
 	return ret;
 }
@@ -243,15 +277,22 @@ static int zynqmp_sha_probe(struct platform_device *pdev)
 	platform_set_drvdata(pdev, sha_dd);
 	INIT_LIST_HEAD(&sha_dd->list);
 	spin_lock_init(&sha_dd->lock);
+	mutex_init(&sha_dd->buf_lock);
 	crypto_init_queue(&sha_dd->queue, ZYNQMP_SHA_QUEUE_LENGTH);
-	spin_lock(&zynqmp_sha.lock);
-	list_add_tail(&sha_dd->list, &zynqmp_sha.dev_list);
-	spin_unlock(&zynqmp_sha.lock);
 
 	err = dma_set_mask_and_coherent(&pdev->dev, DMA_BIT_MASK(32));
 	if (err < 0)
 		dev_err(dev, "no usable DMA configuration");
 
+	sha_dd->buf = dmam_alloc_coherent(dev, ZYNQMP_SHA_DMA_SIZE,
+					  &sha_dd->buf_dma, GFP_KERNEL);
+	if (!sha_dd->buf)
+		return -ENOMEM;
+
+	spin_lock(&zynqmp_sha.lock);
+	list_add_tail(&sha_dd->list, &zynqmp_sha.dev_list);
+	spin_unlock(&zynqmp_sha.lock);
+
 	err = crypto_register_ahash(&sha3_alg);
 	if (err)
 		goto err_algs;
@@ -0,0 +1,222 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * DMABUF carveout heap exporter
+ *
+ * Exports a reserved-memory region, typically DDR attached to the
+ * programmable logic, as a dma-buf heap.
+ *
+ * Copyright (C) 2011 Google, Inc.
+ * Copyright (C) 2019 Linaro Ltd.
+ */
+
+#include <linux/dma-buf.h>
+#include <linux/dma-heap.h>
+#include <linux/err.h>
+#include <linux/genalloc.h>
+#include <linux/mm.h>
+#include <linux/module.h>
+#include <linux/of.h>
+#include <linux/of_reserved_mem.h>
+#include <linux/platform_device.h>
+#include <linux/slab.h>
+
+#include "heap-helpers.h"
+
+/**
+ * struct carveout_heap - carveout heap instance
+ * @pool: allocator for the reserved region, in units of pages
+ * @uncached: buffers are mapped write-combined and never synced
+ */
+struct carveout_heap {
+	struct gen_pool *pool;
+	bool uncached;
+};
+
+static void carveout_heap_free(struct heap_helper_buffer *buffer)
+{
+	struct carveout_heap *carveout = dma_heap_get_drvdata(buffer->heap);
+	phys_addr_t paddr = page_to_phys(buffer->priv_virt);
+
+	kfree(buffer->pages);
+	gen_pool_free(carveout->pool, paddr, buffer->pagecount << PAGE_SHIFT);
+	kfree(buffer);
+}
+
+static int carveout_heap_allocate(struct dma_heap *heap,
+				  unsigned long len,
+				  unsigned long fd_flags,
+				  unsigned long heap_flags)
+{
+	struct carveout_heap *carveout = dma_heap_get_drvdata(heap);
+	struct heap_helper_buffer *helper_buffer;
+	size_t size = PAGE_ALIGN(len);
+	struct dma_buf *dmabuf;
+	struct page *page;
+	unsigned long paddr;
+	int ret = -ENOMEM;
+	pgoff_t pg;
+
+	helper_buffer = kzalloc(sizeof(*helper_buffer), GFP_KERNEL);
+	if (!helper_buffer)
+		return -ENOMEM;
+
+	init_heap_helper_buffer(helper_buffer, carveout_heap_free);
+	helper_buffer->heap = heap;
+	helper_buffer->size = len;
+	helper_buffer->uncached = carveout->uncached;
+
+	paddr = gen_pool_alloc(carveout->pool, size);
+	if (!paddr)
+		goto free_buf;
+
+	page = pfn_to_page(PFN_DOWN(paddr));
+	heap_helper_clear_pages(page, size >> PAGE_SHIFT);
+
+	helper_buffer->pagecount = size >> PAGE_SHIFT;
+	helper_buffer->pages = kmalloc_array(helper_buffer->pagecount,
+					     sizeof(*helper_buffer->pages),
+					     GFP_KERNEL);
+	if (!helper_buffer->pages)
+		goto free_pool;
+
+	for (pg = 0; pg < helper_buffer->pagecount; pg++)
+		helper_buffer->pages[pg] = &page[pg];
+
+	dmabuf = heap_helper_export_dmabuf(helper_buffer, fd_flags);
+	if (IS_ERR(dmabuf)) {
+		ret = PTR_ERR(dmabuf);
+		goto free_pages;
+	}
+
+	helper_buffer->dmabuf = dmabuf;
+	helper_buffer->priv_virt = page;
+
+	ret = dma_buf_fd(dmabuf, fd_flags);
+	if (ret < 0) {
+		dma_buf_put(dmabuf);
+		/* just return, as put will call release and that will free */
+		return ret;
+	}
+
+	return ret;
+
+free_pages:
+	kfree(helper_buffer->pages);
+free_pool:
+	gen_pool_free(carveout->pool, paddr, size);
+free_buf:
+	kfree(helper_buffer);
+	return ret;
+}
+
+static const struct dma_heap_ops carveout_heap_ops = {
+	.allocate = carveout_heap_allocate,
+};
+
+static int carveout_heap_add(struct device *dev, struct gen_pool *pool,
+			     const char *name, bool uncached)
+{
+	struct dma_heap_export_info exp_info;
+	struct carveout_heap *carveout;
+	struct dma_heap *heap;
+
+	carveout = devm_kzalloc(dev, sizeof(*carveout), GFP_KERNEL);
+	if (!carveout)
+		return -ENOMEM;
+
+	carveout->pool = pool;
+	carveout->uncached = uncached;
+
+	exp_info.name = name;
+	exp_info.ops = &carveout_heap_ops;
+	exp_info.priv = carveout;
+
+	heap = dma_heap_add(&exp_info);
+	if (IS_ERR(heap))
+		return PTR_ERR(heap);
+
+	return 0;
+}
+
+static int carveout_heap_probe(struct platform_device *pdev)
+{
+	struct device *dev = &pdev->dev;
+	struct device_node *np;
+	struct reserved_mem *rmem;
+	struct gen_pool *pool;
+	const char *name;
+	char *uncached_name;
+	int ret;
+
+	np = of_parse_phandle(dev->of_node, "memory-region", 0);
+	if (!np) {
+		dev_err(dev, "no memory-region\n");
+		return -ENODEV;
+	}
+
+	rmem = of_reserved_mem_lookup(np);
+	if (!rmem) {
+		of_node_put(np);
+		dev_err(dev, "memory-region is not reserved memory\n");
+		return -EINVAL;
+	}
+
+	/*
+	 * The heap helpers hand out struct pages, so the region must stay in
+	 * the linear map.
+	 */
+	if (of_property_read_bool(np, "no-map") ||
+	    !pfn_valid(PFN_DOWN(rmem->base)) ||
+	    !PAGE_ALIGNED(rmem->base) || !PAGE_ALIGNED(rmem->size)) {
+		of_node_put(np);
+		dev_err(dev, "memory-region must be page aligned and mapped\n");
+		return -EINVAL;
+	}
+	of_node_put(np);
+
+	if (of_property_read_string(dev->of_node, "label", &name))
+		name = dev->of_node->name;
+
+	pool = devm_gen_pool_create(dev, PAGE_SHIFT, -1, NULL);
+	if (IS_ERR(pool))
+		return PTR_ERR(pool);
+
+	ret = gen_pool_add(pool, rmem->base, rmem->size, -1);
+	if (ret)
+		return ret;
+
+	uncached_name = devm_kasprintf(dev, GFP_KERNEL, "%s-uncached", name);
+	if (!uncached_name)
+		return -ENOMEM;
+
+	/* Heaps can't be removed, so neither can the device */
+	ret = carveout_heap_add(dev, pool, name, false);
+	if (ret)
+		return ret;
+
+	ret = carveout_heap_add(dev, pool, uncached_name, true);
+	if (ret)
+		return ret;
+
+	dev_info(dev, "%s: %pa size %pa\n", name, &rmem->base, &rmem->size);
+
+	return 0;
+}
+
+static const struct of_device_id carveout_heap_of_match[] = {
+	{ .compatible = "xlnx,dma-heap-carveout", },
+	{ /* end of table */ }
+};
+MODULE_DEVICE_TABLE(of, carveout_heap_of_match);
+
+static struct platform_driver carveout_heap_driver = {
+	.probe = carveout_heap_probe,
+	.driver = {
+		.name = "dma-heap-carveout",
+		.of_match_table = carveout_heap_of_match,
+		.suppress_bind_attrs = true,
+	},
+};
+builtin_platform_driver(carveout_heap_driver);
+MODULE_DESCRIPTION("DMA-BUF carveout heap");
+MODULE_LICENSE("GPL v2");
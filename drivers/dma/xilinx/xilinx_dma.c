@@ -40,16 +40,20 @@
 #include <linux/interrupt.h>
 #include <linux/io.h>
 #include <linux/iopoll.h>
+#include <linux/kthread.h>
+#include <linux/llist.h>
 #include <linux/module.h>
 #include <linux/of_address.h>
 #include <linux/of_dma.h>
 #include <linux/of_platform.h>
 #include <linux/of_irq.h>
+#include <linux/sched/isolation.h>
 #include <linux/slab.h>
 #include <linux/clk.h>
 #include <linux/io-64-nonatomic-lo-hi.h>
 
 #include "../dmaengine.h"
+#include "xilinx_dma_trace.h"
 
 /* Register/Descriptor Offsets */
 #define XILINX_DMA_MM2S_CTRL_OFFSET		0x0000
@@ -134,6 +138,10 @@
 		 XILINX_DMA_DMASR_DLY_CNT_IRQ | \
 		 XILINX_DMA_DMASR_ERR_IRQ)
 
+#define XILINX_DMA_DMAXR_DONE_IRQ_MASK	\
+		(XILINX_DMA_DMASR_FRM_CNT_IRQ | \
+		 XILINX_DMA_DMASR_DLY_CNT_IRQ)
+
 #define XILINX_DMA_DMASR_ALL_ERR_MASK	\
 		(XILINX_DMA_DMASR_EOL_LATE_ERR | \
 		 XILINX_DMA_DMASR_SOF_LATE_ERR | \
@@ -196,6 +204,7 @@
 #define XILINX_MCDMA_S2MM_CTRL_OFFSET		0x0500
 #define XILINX_MCDMA_CHEN_OFFSET		0x0008
 #define XILINX_MCDMA_CH_ERR_OFFSET		0x0010
+#define XILINX_MCDMA_TXWEIGHT_OFFSET(x)		(0x18 + (x) * 4)
 #define XILINX_MCDMA_RXINT_SER_OFFSET		0x0020
 #define XILINX_MCDMA_TXINT_SER_OFFSET		0x0028
 #define XILINX_MCDMA_CHAN_CR_OFFSET(x)		(0x40 + (x) * 0x40)
@@ -214,6 +223,9 @@
 #define XILINX_MCDMA_IRQ_ERR_MASK		BIT(7)
 #define XILINX_MCDMA_BD_EOP			BIT(30)
 #define XILINX_MCDMA_BD_SOP			BIT(31)
+#define XILINX_MCDMA_WEIGHT_MAX			0xF
+#define XILINX_MCDMA_WEIGHT_PER_REG		8
+#define XILINX_MCDMA_WEIGHT_SHIFT(x)		(((x) % 8) * 4)
 
 /**
  * struct xilinx_vdma_desc_hw - Hardware Descriptor
@@ -322,11 +334,13 @@ struct xilinx_vdma_tx_segment {
  * struct xilinx_axidma_tx_segment - Descriptor segment
  * @hw: Hardware descriptor
  * @node: Node in the descriptor segments list
+ * @free_node: Node in the channel free segments list
  * @phys: Physical address of segment
  */
 struct xilinx_axidma_tx_segment {
 	struct xilinx_axidma_desc_hw hw;
 	struct list_head node;
+	struct llist_node free_node;
 	dma_addr_t phys;
 } __aligned(64);
 
@@ -334,11 +348,13 @@ struct xilinx_axidma_tx_segment {
  * struct xilinx_aximcdma_tx_segment - Descriptor segment
  * @hw: Hardware descriptor
  * @node: Node in the descriptor segments list
+ * @free_node: Node in the channel free segments list
  * @phys: Physical address of segment
  */
 struct xilinx_aximcdma_tx_segment {
 	struct xilinx_aximcdma_desc_hw hw;
 	struct list_head node;
+	struct llist_node free_node;
 	dma_addr_t phys;
 } __aligned(64);
 
@@ -354,6 +370,16 @@ struct xilinx_cdma_tx_segment {
 	dma_addr_t phys;
 } __aligned(64);
 
+/**
+ * struct xilinx_dma_seg_batch - Free segments collected for a single return
+ * @first: First segment node of the batch
+ * @last: Last segment node of the batch
+ */
+struct xilinx_dma_seg_batch {
+	struct llist_node *first;
+	struct llist_node *last;
+};
+
 /**
  * struct xilinx_dma_tx_descriptor - Per Transaction structure
  * @async_tx: Async transaction descriptor
@@ -362,6 +388,7 @@ struct xilinx_cdma_tx_segment {
  * @cyclic: Check for cyclic transfers.
  * @err: Whether the descriptor has an error.
  * @residue: Residue of the completed descriptor
+ * @submit_time: Submit time, for the latency histogram
  */
 struct xilinx_dma_tx_descriptor {
 	struct dma_async_tx_descriptor async_tx;
@@ -370,6 +397,7 @@ struct xilinx_dma_tx_descriptor {
 	bool cyclic;
 	bool err;
 	u32 residue;
+	ktime_t submit_time;
 };
 
 /**
@@ -381,7 +409,9 @@ struct xilinx_dma_tx_descriptor {
  * @pending_list: Descriptors waiting
  * @active_list: Descriptors ready to submit
  * @done_list: Complete descriptors
- * @free_seg_list: Free descriptors
+ * @free_seg_list: Free descriptors, returned without taking @lock
+ * @seg_lock: Serializes the segment allocations
+ * @seg_cache: Free descriptors taken over from @free_seg_list
  * @common: DMA common channel
  * @desc_pool: Descriptors pool
  * @dev: The dma device
@@ -395,6 +425,10 @@ struct xilinx_dma_tx_descriptor {
  * @err: Channel has errors
  * @idle: Check for channel idle
  * @tasklet: Cleanup work after irq
+ * @cleanup_worker: Thread running the cleanup instead of @tasklet, if any
+ * @cleanup_work: Cleanup work queued on @cleanup_worker
+ * @cleanup_busy: Descriptor cleanup is running, bit 0
+ * @poll_mode: Completion mode of AXI DMA and CDMA channels
  * @config: Device configuration info
  * @flush_on_fsync: Flush on Frame sync
  * @desc_pendingcount: Descriptor pending count
@@ -409,6 +443,9 @@ struct xilinx_dma_tx_descriptor {
  * @stop_transfer: Differentiate b/w DMA IP's quiesce
  * @tdest: TDEST value for mcdma
  * @has_vflip: S2MM vertical flip
+ * @has_weight: MM2S WRR weight set by the client, MCDMA only
+ * @weight: MM2S WRR weight of the channel, MCDMA only
+ * @lat_hist: Submit to callback latency histogram
  */
 struct xilinx_dma_chan {
 	struct xilinx_dma_device *xdev;
@@ -418,7 +455,9 @@ struct xilinx_dma_chan {
 	struct list_head pending_list;
 	struct list_head active_list;
 	struct list_head done_list;
-	struct list_head free_seg_list;
+	struct llist_head free_seg_list;
+	spinlock_t seg_lock;
+	struct llist_node *seg_cache;
 	struct dma_chan common;
 	struct dma_pool *desc_pool;
 	struct device *dev;
@@ -432,6 +471,10 @@ struct xilinx_dma_chan {
 	bool err;
 	bool idle;
 	struct tasklet_struct tasklet;
+	struct kthread_worker *cleanup_worker;
+	struct kthread_work cleanup_work;
+	unsigned long cleanup_busy;
+	enum xilinx_dma_poll_mode poll_mode;
 	struct xilinx_vdma_config config;
 	bool flush_on_fsync;
 	u32 desc_pendingcount;
@@ -446,6 +489,9 @@ struct xilinx_dma_chan {
 	int (*stop_transfer)(struct xilinx_dma_chan *chan);
 	u16 tdest;
 	bool has_vflip;
+	bool has_weight;
+	u8 weight;
+	struct xilinx_dma_lat_hist lat_hist;
 };
 
 /**
@@ -491,6 +537,7 @@ struct xilinx_dma_config {
  * @s2mm_chan_id: DMA s2mm channel identifier
  * @mm2s_chan_id: DMA mm2s channel identifier
  * @max_buffer_len: Max buffer length
+ * @weight_lock: Serializes the MCDMA MM2S weight register updates
  */
 struct xilinx_dma_device {
 	void __iomem *regs;
@@ -509,6 +556,7 @@ struct xilinx_dma_device {
 	u32 s2mm_chan_id;
 	u32 mm2s_chan_id;
 	u32 max_buffer_len;
+	spinlock_t weight_lock;
 };
 
 /* Macros */
@@ -667,6 +715,33 @@ xilinx_cdma_alloc_tx_segment(struct xilinx_dma_chan *chan)
 	return segment;
 }
 
+/**
+ * xilinx_dma_get_free_seg - Take a segment from the free segments
+ * @chan: Driver specific DMA channel
+ *
+ * Segments are returned to @free_seg_list with lock-free llist adds, so the
+ * completion side never contends with the producers. The allocations take
+ * the whole list over into @seg_cache once it runs dry, which keeps
+ * llist_del_first() and its single consumer rule out of the picture.
+ *
+ * Return: The free segment node on success and NULL on failure.
+ */
+static struct llist_node *xilinx_dma_get_free_seg(struct xilinx_dma_chan *chan)
+{
+	struct llist_node *node;
+	unsigned long flags;
+
+	spin_lock_irqsave(&chan->seg_lock, flags);
+	if (!chan->seg_cache)
+		chan->seg_cache = llist_del_all(&chan->free_seg_list);
+	node = chan->seg_cache;
+	if (node)
+		chan->seg_cache = node->next;
+	spin_unlock_irqrestore(&chan->seg_lock, flags);
+
+	return node;
+}
+
 /**
  * xilinx_axidma_alloc_tx_segment - Allocate transaction segment
  * @chan: Driver specific DMA channel
@@ -676,22 +751,15 @@ xilinx_cdma_alloc_tx_segment(struct xilinx_dma_chan *chan)
 static struct xilinx_axidma_tx_segment *
 xilinx_axidma_alloc_tx_segment(struct xilinx_dma_chan *chan)
 {
-	struct xilinx_axidma_tx_segment *segment = NULL;
-	unsigned long flags;
-
-	spin_lock_irqsave(&chan->lock, flags);
-	if (!list_empty(&chan->free_seg_list)) {
-		segment = list_first_entry(&chan->free_seg_list,
-					   struct xilinx_axidma_tx_segment,
-					   node);
-		list_del(&segment->node);
-	}
-	spin_unlock_irqrestore(&chan->lock, flags);
+	struct llist_node *node;
 
-	if (!segment)
+	node = xilinx_dma_get_free_seg(chan);
+	if (!node) {
 		dev_dbg(chan->dev, "Could not find free tx segment\n");
+		return NULL;
+	}
 
-	return segment;
+	return llist_entry(node, struct xilinx_axidma_tx_segment, free_node);
 }
 
 /**
@@ -703,19 +771,13 @@ xilinx_axidma_alloc_tx_segment(struct xilinx_dma_chan *chan)
 static struct xilinx_aximcdma_tx_segment *
 xilinx_aximcdma_alloc_tx_segment(struct xilinx_dma_chan *chan)
 {
-	struct xilinx_aximcdma_tx_segment *segment = NULL;
-	unsigned long flags;
+	struct llist_node *node;
 
-	spin_lock_irqsave(&chan->lock, flags);
-	if (!list_empty(&chan->free_seg_list)) {
-		segment = list_first_entry(&chan->free_seg_list,
-					   struct xilinx_aximcdma_tx_segment,
-					   node);
-		list_del(&segment->node);
-	}
-	spin_unlock_irqrestore(&chan->lock, flags);
+	node = xilinx_dma_get_free_seg(chan);
+	if (!node)
+		return NULL;
 
-	return segment;
+	return llist_entry(node, struct xilinx_aximcdma_tx_segment, free_node);
 }
 
 static void xilinx_dma_clean_hw_desc(struct xilinx_axidma_desc_hw *hw)
@@ -741,30 +803,62 @@ static void xilinx_mcdma_clean_hw_desc(struct xilinx_aximcdma_desc_hw *hw)
 }
 
 /**
- * xilinx_dma_free_tx_segment - Free transaction segment
+ * xilinx_dma_seg_batch_add - Add a free segment to a batch
+ * @batch: Batch of free segments
+ * @node: Free node of the segment
+ */
+static void xilinx_dma_seg_batch_add(struct xilinx_dma_seg_batch *batch,
+				     struct llist_node *node)
+{
+	node->next = batch->first;
+	batch->first = node;
+	if (!batch->last)
+		batch->last = node;
+}
+
+/**
+ * xilinx_dma_seg_batch_flush - Return a batch to the free segments
  * @chan: Driver specific DMA channel
+ * @batch: Batch of free segments
+ *
+ * The whole batch goes back with a single lock-free llist_add_batch().
+ */
+static void xilinx_dma_seg_batch_flush(struct xilinx_dma_chan *chan,
+				       struct xilinx_dma_seg_batch *batch)
+{
+	if (!batch->first)
+		return;
+
+	llist_add_batch(batch->first, batch->last, &chan->free_seg_list);
+	batch->first = NULL;
+	batch->last = NULL;
+}
+
+/**
+ * xilinx_dma_free_tx_segment - Free transaction segment
+ * @batch: Batch the segment is returned with
  * @segment: DMA transaction segment
  */
-static void xilinx_dma_free_tx_segment(struct xilinx_dma_chan *chan,
+static void xilinx_dma_free_tx_segment(struct xilinx_dma_seg_batch *batch,
 				struct xilinx_axidma_tx_segment *segment)
 {
 	xilinx_dma_clean_hw_desc(&segment->hw);
 
-	list_add_tail(&segment->node, &chan->free_seg_list);
+	xilinx_dma_seg_batch_add(batch, &segment->free_node);
 }
 
 /**
  * xilinx_mcdma_free_tx_segment - Free transaction segment
- * @chan: Driver specific DMA channel
+ * @batch: Batch the segment is returned with
  * @segment: DMA transaction segment
  */
-static void xilinx_mcdma_free_tx_segment(struct xilinx_dma_chan *chan,
+static void xilinx_mcdma_free_tx_segment(struct xilinx_dma_seg_batch *batch,
 					 struct xilinx_aximcdma_tx_segment *
 					 segment)
 {
 	xilinx_mcdma_clean_hw_desc(&segment->hw);
 
-	list_add_tail(&segment->node, &chan->free_seg_list);
+	xilinx_dma_seg_batch_add(batch, &segment->free_node);
 }
 
 /**
@@ -810,13 +904,15 @@ xilinx_dma_alloc_tx_descriptor(struct xilinx_dma_chan *chan)
 }
 
 /**
- * xilinx_dma_free_tx_descriptor - Free transaction descriptor
+ * __xilinx_dma_free_tx_descriptor - Free transaction descriptor
  * @chan: Driver specific DMA channel
  * @desc: DMA transaction descriptor
+ * @batch: Batch the AXI DMA and MCDMA segments are collected in
  */
 static void
-xilinx_dma_free_tx_descriptor(struct xilinx_dma_chan *chan,
-			       struct xilinx_dma_tx_descriptor *desc)
+__xilinx_dma_free_tx_descriptor(struct xilinx_dma_chan *chan,
+				struct xilinx_dma_tx_descriptor *desc,
+				struct xilinx_dma_seg_batch *batch)
 {
 	struct xilinx_vdma_tx_segment *segment, *next;
 	struct xilinx_cdma_tx_segment *cdma_segment, *cdma_next;
@@ -841,19 +937,34 @@ xilinx_dma_free_tx_descriptor(struct xilinx_dma_chan *chan,
 		list_for_each_entry_safe(axidma_segment, axidma_next,
 					 &desc->segments, node) {
 			list_del(&axidma_segment->node);
-			xilinx_dma_free_tx_segment(chan, axidma_segment);
+			xilinx_dma_free_tx_segment(batch, axidma_segment);
 		}
 	} else {
 		list_for_each_entry_safe(aximcdma_segment, aximcdma_next,
 					 &desc->segments, node) {
 			list_del(&aximcdma_segment->node);
-			xilinx_mcdma_free_tx_segment(chan, aximcdma_segment);
+			xilinx_mcdma_free_tx_segment(batch, aximcdma_segment);
 		}
 	}
 
 	kfree(desc);
 }
 
+/**
+ * xilinx_dma_free_tx_descriptor - Free transaction descriptor
+ * @chan: Driver specific DMA channel
+ * @desc: DMA transaction descriptor
+ */
+static void
+xilinx_dma_free_tx_descriptor(struct xilinx_dma_chan *chan,
+			       struct xilinx_dma_tx_descriptor *desc)
+{
+	struct xilinx_dma_seg_batch batch = {};
+
+	__xilinx_dma_free_tx_descriptor(chan, desc, &batch);
+	xilinx_dma_seg_batch_flush(chan, &batch);
+}
+
 /* Required functions */
 
 /**
@@ -865,11 +976,14 @@ static void xilinx_dma_free_desc_list(struct xilinx_dma_chan *chan,
 					struct list_head *list)
 {
 	struct xilinx_dma_tx_descriptor *desc, *next;
+	struct xilinx_dma_seg_batch batch = {};
 
 	list_for_each_entry_safe(desc, next, list, node) {
 		list_del(&desc->node);
-		xilinx_dma_free_tx_descriptor(chan, desc);
+		__xilinx_dma_free_tx_descriptor(chan, desc, &batch);
 	}
+
+	xilinx_dma_seg_batch_flush(chan, &batch);
 }
 
 /**
@@ -903,9 +1017,10 @@ static void xilinx_dma_free_chan_resources(struct dma_chan *dchan)
 	xilinx_dma_free_descriptors(chan);
 
 	if (chan->xdev->dma_config->dmatype == XDMA_TYPE_AXIDMA) {
-		spin_lock_irqsave(&chan->lock, flags);
-		INIT_LIST_HEAD(&chan->free_seg_list);
-		spin_unlock_irqrestore(&chan->lock, flags);
+		spin_lock_irqsave(&chan->seg_lock, flags);
+		init_llist_head(&chan->free_seg_list);
+		chan->seg_cache = NULL;
+		spin_unlock_irqrestore(&chan->seg_lock, flags);
 
 		/* Free memory that is allocated for BD */
 		dma_free_coherent(chan->dev, sizeof(*chan->seg_v) *
@@ -918,9 +1033,10 @@ static void xilinx_dma_free_chan_resources(struct dma_chan *dchan)
 	}
 
 	if (chan->xdev->dma_config->dmatype == XDMA_TYPE_AXIMCDMA) {
-		spin_lock_irqsave(&chan->lock, flags);
-		INIT_LIST_HEAD(&chan->free_seg_list);
-		spin_unlock_irqrestore(&chan->lock, flags);
+		spin_lock_irqsave(&chan->seg_lock, flags);
+		init_llist_head(&chan->free_seg_list);
+		chan->seg_cache = NULL;
+		spin_unlock_irqrestore(&chan->seg_lock, flags);
 
 		/* Free memory that is allocated for BD */
 		dma_free_coherent(chan->dev, sizeof(*chan->seg_mv) *
@@ -1002,6 +1118,7 @@ static void xilinx_dma_chan_handle_cyclic(struct xilinx_dma_chan *chan,
 	callback = desc->async_tx.callback;
 	callback_param = desc->async_tx.callback_param;
 	if (callback) {
+		trace_xilinx_dma_callback(&chan->common, desc->async_tx.cookie);
 		spin_unlock_irqrestore(&chan->lock, *flags);
 		callback(callback_param);
 		spin_lock_irqsave(&chan->lock, *flags);
@@ -1009,19 +1126,23 @@ static void xilinx_dma_chan_handle_cyclic(struct xilinx_dma_chan *chan,
 }
 
 /**
- * xilinx_dma_chan_desc_cleanup - Clean channel descriptors
+ * __xilinx_dma_chan_desc_cleanup - Clean channel descriptors
  * @chan: Driver specific DMA channel
  */
-static void xilinx_dma_chan_desc_cleanup(struct xilinx_dma_chan *chan)
+static void __xilinx_dma_chan_desc_cleanup(struct xilinx_dma_chan *chan)
 {
-	struct xilinx_dma_tx_descriptor *desc, *next;
+	struct xilinx_dma_tx_descriptor *desc;
+	struct xilinx_dma_seg_batch batch = {};
 	unsigned long flags;
 
 	spin_lock_irqsave(&chan->lock, flags);
 
-	list_for_each_entry_safe(desc, next, &chan->done_list, node) {
+	while (!list_empty(&chan->done_list)) {
 		struct dmaengine_result result;
 
+		desc = list_first_entry(&chan->done_list,
+					struct xilinx_dma_tx_descriptor, node);
+
 		if (desc->cyclic) {
 			xilinx_dma_chan_handle_cyclic(chan, desc, &flags);
 			break;
@@ -1041,6 +1162,9 @@ static void xilinx_dma_chan_desc_cleanup(struct xilinx_dma_chan *chan)
 
 		result.residue = desc->residue;
 
+		trace_xilinx_dma_callback(&chan->common, desc->async_tx.cookie);
+		xilinx_dma_lat_hist_add(&chan->lat_hist, desc->submit_time);
+
 		/* Run the link descriptor callback function */
 		spin_unlock_irqrestore(&chan->lock, flags);
 		dmaengine_desc_get_callback_invoke(&desc->async_tx, &result);
@@ -1048,10 +1172,81 @@ static void xilinx_dma_chan_desc_cleanup(struct xilinx_dma_chan *chan)
 
 		/* Run any dependencies, then free the descriptor */
 		dma_run_dependencies(&desc->async_tx);
-		xilinx_dma_free_tx_descriptor(chan, desc);
+		__xilinx_dma_free_tx_descriptor(chan, desc, &batch);
 	}
 
 	spin_unlock_irqrestore(&chan->lock, flags);
+
+	/* Hand all the completed segments back at once */
+	xilinx_dma_seg_batch_flush(chan, &batch);
+}
+
+/**
+ * xilinx_dma_chan_desc_cleanup - Clean channel descriptors
+ * @chan: Driver specific DMA channel
+ *
+ * Runs from the tasklet and, in the polled modes, inline from
+ * xilinx_dma_tx_status(). Only one context cleans at a time so that the
+ * callbacks keep their order. A context finding the cleanup busy leaves
+ * its descriptors to the running one, which checks the done list again
+ * once it is finished.
+ */
+static void xilinx_dma_chan_desc_cleanup(struct xilinx_dma_chan *chan)
+{
+	do {
+		if (test_and_set_bit_lock(0, &chan->cleanup_busy))
+			return;
+
+		__xilinx_dma_chan_desc_cleanup(chan);
+
+		/* Order the release against the done list check below */
+		clear_bit_unlock(0, &chan->cleanup_busy);
+		smp_mb__after_atomic();
+	} while (chan->poll_mode != XILINX_DMA_POLL_NONE &&
+		 !list_empty_careful(&chan->done_list));
+}
+
+/**
+ * xilinx_dma_schedule_cleanup - Defer the completion work of a channel
+ * @chan: Driver specific DMA channel
+ *
+ * The completion callbacks run from the tasklet unless the channel has its
+ * own cleanup thread, see xilinx_dma_chan_worker_init().
+ */
+static void xilinx_dma_schedule_cleanup(struct xilinx_dma_chan *chan)
+{
+	if (chan->cleanup_worker)
+		kthread_queue_work(chan->cleanup_worker, &chan->cleanup_work);
+	else
+		tasklet_schedule(&chan->tasklet);
+}
+
+/**
+ * xilinx_dma_do_cleanup - Completion work of a channel
+ * @chan: Driver specific DMA channel
+ */
+static void xilinx_dma_do_cleanup(struct xilinx_dma_chan *chan)
+{
+	unsigned long flags;
+
+	trace_xilinx_dma_cleanup(&chan->common);
+	xilinx_dma_chan_desc_cleanup(chan);
+
+	if (chan->poll_mode != XILINX_DMA_POLL_HYBRID)
+		return;
+
+	/* Keep polling while transfers are completing back to back */
+	if (xilinx_dma_poll_status(chan)) {
+		xilinx_dma_schedule_cleanup(chan);
+		return;
+	}
+
+	/* Quiet again, a completion latched meanwhile raises the IRQ */
+	spin_lock_irqsave(&chan->lock, flags);
+	if (chan->poll_mode == XILINX_DMA_POLL_HYBRID)
+		dma_ctrl_set(chan, XILINX_DMA_REG_DMACR,
+			     XILINX_DMA_DMAXR_DONE_IRQ_MASK);
+	spin_unlock_irqrestore(&chan->lock, flags);
 }
 
 /**
@@ -1060,9 +1255,31 @@ static void xilinx_dma_chan_desc_cleanup(struct xilinx_dma_chan *chan)
  */
 static void xilinx_dma_do_tasklet(unsigned long data)
 {
-	struct xilinx_dma_chan *chan = (struct xilinx_dma_chan *)data;
+	xilinx_dma_do_cleanup((struct xilinx_dma_chan *)data);
+}
 
-	xilinx_dma_chan_desc_cleanup(chan);
+/**
+ * xilinx_dma_do_work - Completion work of the channel cleanup thread
+ * @work: Cleanup work of the channel
+ */
+static void xilinx_dma_do_work(struct kthread_work *work)
+{
+	xilinx_dma_do_cleanup(container_of(work, struct xilinx_dma_chan,
+					   cleanup_work));
+}
+
+/**
+ * xilinx_dma_irq_mask - Interrupts enabled for the completion mode
+ * @chan: Driver specific DMA channel
+ *
+ * Return: The DMACR interrupt enable bits
+ */
+static u32 xilinx_dma_irq_mask(struct xilinx_dma_chan *chan)
+{
+	if (chan->poll_mode == XILINX_DMA_POLL_ONLY)
+		return XILINX_DMA_DMASR_ERR_IRQ;
+
+	return XILINX_DMA_DMAXR_ALL_IRQ_MASK;
 }
 
 /**
@@ -1124,8 +1341,8 @@ static int xilinx_dma_alloc_chan_resources(struct dma_chan *dchan)
 				((i + 1) % XILINX_DMA_NUM_DESCS));
 			chan->seg_v[i].phys = chan->seg_p +
 				sizeof(*chan->seg_v) * i;
-			list_add_tail(&chan->seg_v[i].node,
-				      &chan->free_seg_list);
+			llist_add(&chan->seg_v[i].free_node,
+				  &chan->free_seg_list);
 		}
 	} else if (chan->xdev->dma_config->dmatype == XDMA_TYPE_AXIMCDMA) {
 		/* Allocate the buffer descriptors. */
@@ -1148,8 +1365,8 @@ static int xilinx_dma_alloc_chan_resources(struct dma_chan *dchan)
 				((i + 1) % XILINX_DMA_NUM_DESCS));
 			chan->seg_mv[i].phys = chan->seg_p +
 				sizeof(*chan->seg_mv) * i;
-			list_add_tail(&chan->seg_mv[i].node,
-				      &chan->free_seg_list);
+			llist_add(&chan->seg_mv[i].free_node,
+				  &chan->free_seg_list);
 		}
 	} else if (chan->xdev->dma_config->dmatype == XDMA_TYPE_CDMA) {
 		chan->desc_pool = dma_pool_create("xilinx_cdma_desc_pool",
@@ -1181,7 +1398,7 @@ static int xilinx_dma_alloc_chan_resources(struct dma_chan *dchan)
 		 * other channel as well so enable the interrupts here.
 		 */
 		dma_ctrl_set(chan, XILINX_DMA_REG_DMACR,
-			      XILINX_DMA_DMAXR_ALL_IRQ_MASK);
+			      xilinx_dma_irq_mask(chan));
 	}
 
 	if ((chan->xdev->dma_config->dmatype == XDMA_TYPE_CDMA) && chan->has_sg)
@@ -1219,46 +1436,6 @@ static int xilinx_dma_calc_copysize(struct xilinx_dma_chan *chan,
 	return copy;
 }
 
-/**
- * xilinx_dma_tx_status - Get DMA transaction status
- * @dchan: DMA channel
- * @cookie: Transaction identifier
- * @txstate: Transaction state
- *
- * Return: DMA transaction status
- */
-static enum dma_status xilinx_dma_tx_status(struct dma_chan *dchan,
-					dma_cookie_t cookie,
-					struct dma_tx_state *txstate)
-{
-	struct xilinx_dma_chan *chan = to_xilinx_chan(dchan);
-	struct xilinx_dma_tx_descriptor *desc;
-	enum dma_status ret;
-	unsigned long flags;
-	u32 residue = 0;
-
-	ret = dma_cookie_status(dchan, cookie, txstate);
-	if (ret == DMA_COMPLETE || !txstate)
-		return ret;
-
-	spin_lock_irqsave(&chan->lock, flags);
-	if (!list_empty(&chan->active_list)) {
-		desc = list_last_entry(&chan->active_list,
-				       struct xilinx_dma_tx_descriptor, node);
-		/*
-		 * VDMA and simple mode do not support residue reporting, so the
-		 * residue field will always be 0.
-		 */
-		if (chan->has_sg && chan->xdev->dma_config->dmatype != XDMA_TYPE_VDMA)
-			residue = xilinx_dma_get_residue(chan, desc);
-	}
-	spin_unlock_irqrestore(&chan->lock, flags);
-
-	dma_set_residue(txstate, residue);
-
-	return ret;
-}
-
 /**
  * xilinx_dma_stop_transfer - Halt DMA channel
  * @chan: Driver specific DMA channel
@@ -1292,6 +1469,24 @@ static int xilinx_cdma_stop_transfer(struct xilinx_dma_chan *chan)
 				       XILINX_DMA_LOOP_COUNT);
 }
 
+/**
+ * xilinx_dma_trace_start - Trace the descriptors handed to the hardware
+ * @chan: Driver specific DMA channel
+ *
+ * Called with the pending descriptors which are about to be moved to the
+ * active list.
+ */
+static void xilinx_dma_trace_start(struct xilinx_dma_chan *chan)
+{
+	struct xilinx_dma_tx_descriptor *desc;
+
+	if (!trace_xilinx_dma_start_enabled())
+		return;
+
+	list_for_each_entry(desc, &chan->pending_list, node)
+		trace_xilinx_dma_start(&chan->common, desc->async_tx.cookie);
+}
+
 /**
  * xilinx_dma_start - Start DMA channel
  * @chan: Driver specific DMA channel
@@ -1409,6 +1604,8 @@ static void xilinx_vdma_start_transfer(struct xilinx_dma_chan *chan)
 			last->hw.stride);
 	vdma_desc_write(chan, XILINX_DMA_REG_VSIZE, last->hw.vsize);
 
+	trace_xilinx_dma_start(&chan->common, desc->async_tx.cookie);
+
 	chan->desc_submitcount++;
 	chan->desc_pendingcount--;
 	list_del(&desc->node);
@@ -1486,6 +1683,7 @@ static void xilinx_cdma_start_transfer(struct xilinx_dma_chan *chan)
 				hw->control & chan->xdev->max_buffer_len);
 	}
 
+	xilinx_dma_trace_start(chan);
 	list_splice_tail_init(&chan->pending_list, &chan->active_list);
 	chan->desc_pendingcount = 0;
 	chan->idle = false;
@@ -1560,6 +1758,7 @@ static void xilinx_dma_start_transfer(struct xilinx_dma_chan *chan)
 			       hw->control & chan->xdev->max_buffer_len);
 	}
 
+	xilinx_dma_trace_start(chan);
 	list_splice_tail_init(&chan->pending_list, &chan->active_list);
 	chan->desc_pendingcount = 0;
 	chan->idle = false;
@@ -1630,6 +1829,7 @@ static void xilinx_mcdma_start_transfer(struct xilinx_dma_chan *chan)
 	xilinx_write(chan, XILINX_MCDMA_CHAN_TDESC_OFFSET(chan->tdest),
 		     tail_segment->phys);
 
+	xilinx_dma_trace_start(chan);
 	list_splice_tail_init(&chan->pending_list, &chan->active_list);
 	chan->desc_pendingcount = 0;
 	chan->idle = false;
@@ -1671,6 +1871,8 @@ static void xilinx_dma_complete_descriptor(struct xilinx_dma_chan *chan)
 			desc->residue = 0;
 		desc->err = chan->err;
 
+		trace_xilinx_dma_complete(&chan->common, desc->async_tx.cookie);
+
 		list_del(&desc->node);
 		if (!desc->cyclic)
 			dma_cookie_complete(&desc->async_tx);
@@ -1711,6 +1913,47 @@ static int xilinx_dma_reset(struct xilinx_dma_chan *chan)
 	return err;
 }
 
+/**
+ * xilinx_mcdma_write_weights - Program the MCDMA MM2S channel weights
+ * @xdev: Driver specific device structure
+ *
+ * Only the channels whose client set a weight are written, the others
+ * keep the weight the core came up with.
+ */
+static void xilinx_mcdma_write_weights(struct xilinx_dma_device *xdev)
+{
+	u32 mask[2] = {}, weight[2] = {};
+	struct xilinx_dma_chan *chan, *mm2s = NULL;
+	unsigned long flags;
+	u32 reg;
+	int i;
+
+	spin_lock_irqsave(&xdev->weight_lock, flags);
+	for (i = 0; i < xdev->dma_config->max_channels; i++) {
+		chan = xdev->chan[i];
+		if (!chan || chan->direction != DMA_MEM_TO_DEV ||
+		    !chan->has_weight)
+			continue;
+
+		reg = chan->tdest / XILINX_MCDMA_WEIGHT_PER_REG;
+		mask[reg] |= XILINX_MCDMA_WEIGHT_MAX <<
+			     XILINX_MCDMA_WEIGHT_SHIFT(chan->tdest);
+		weight[reg] |= chan->weight <<
+			       XILINX_MCDMA_WEIGHT_SHIFT(chan->tdest);
+		mm2s = chan;
+	}
+
+	for (i = 0; mm2s && i < ARRAY_SIZE(mask); i++) {
+		if (!mask[i])
+			continue;
+
+		reg = dma_ctrl_read(mm2s, XILINX_MCDMA_TXWEIGHT_OFFSET(i));
+		reg = (reg & ~mask[i]) | weight[i];
+		dma_ctrl_write(mm2s, XILINX_MCDMA_TXWEIGHT_OFFSET(i), reg);
+	}
+	spin_unlock_irqrestore(&xdev->weight_lock, flags);
+}
+
 /**
  * xilinx_dma_chan_reset - Reset DMA channel and enable interrupts
  * @chan: Driver specific DMA channel
@@ -1727,8 +1970,12 @@ static int xilinx_dma_chan_reset(struct xilinx_dma_chan *chan)
 		return err;
 
 	/* Enable interrupts */
-	dma_ctrl_set(chan, XILINX_DMA_REG_DMACR,
-		      XILINX_DMA_DMAXR_ALL_IRQ_MASK);
+	dma_ctrl_set(chan, XILINX_DMA_REG_DMACR, xilinx_dma_irq_mask(chan));
+
+	/* The reset may have brought the weights back to their defaults */
+	if (chan->xdev->dma_config->dmatype == XDMA_TYPE_AXIMCDMA &&
+	    chan->direction == DMA_MEM_TO_DEV)
+		xilinx_mcdma_write_weights(chan->xdev);
 
 	return 0;
 }
@@ -1767,6 +2014,8 @@ static irqreturn_t xilinx_mcdma_irq_handler(int irq, void *data)
 	if (!(status & XILINX_MCDMA_IRQ_ALL_MASK))
 		return IRQ_NONE;
 
+	trace_xilinx_dma_irq(&chan->common, status);
+
 	dma_ctrl_write(chan, XILINX_MCDMA_CHAN_SR_OFFSET(chan->tdest),
 		       status & XILINX_MCDMA_IRQ_ALL_MASK);
 
@@ -1797,26 +2046,30 @@ static irqreturn_t xilinx_mcdma_irq_handler(int irq, void *data)
 		spin_unlock(&chan->lock);
 	}
 
-	tasklet_schedule(&chan->tasklet);
+	xilinx_dma_schedule_cleanup(chan);
 	return IRQ_HANDLED;
 }
 
 /**
- * xilinx_dma_irq_handler - DMA Interrupt handler
- * @irq: IRQ number
- * @data: Pointer to the Xilinx DMA channel structure
+ * xilinx_dma_handle_status - Handle the DMA status events
+ * @chan: Driver specific DMA channel
  *
- * Return: IRQ_HANDLED/IRQ_NONE
+ * Reads and acks DMASR, then completes the active descriptors. Called with
+ * the channel lock held, both from the IRQ handler and from the polled
+ * completion, so every event is consumed exactly once.
+ *
+ * Return: true if there was an event, false otherwise
  */
-static irqreturn_t xilinx_dma_irq_handler(int irq, void *data)
+static bool xilinx_dma_handle_status(struct xilinx_dma_chan *chan)
 {
-	struct xilinx_dma_chan *chan = data;
 	u32 status;
 
 	/* Read the status and ack the interrupts. */
 	status = dma_ctrl_read(chan, XILINX_DMA_REG_DMASR);
 	if (!(status & XILINX_DMA_DMAXR_ALL_IRQ_MASK))
-		return IRQ_NONE;
+		return false;
+
+	trace_xilinx_dma_irq(&chan->common, status);
 
 	dma_ctrl_write(chan, XILINX_DMA_REG_DMASR,
 			status & XILINX_DMA_DMAXR_ALL_IRQ_MASK);
@@ -1854,17 +2107,113 @@ static irqreturn_t xilinx_dma_irq_handler(int irq, void *data)
 	}
 
 	if (status & XILINX_DMA_DMASR_FRM_CNT_IRQ) {
-		spin_lock(&chan->lock);
 		xilinx_dma_complete_descriptor(chan);
 		chan->idle = true;
 		chan->start_transfer(chan);
+	}
+
+	return true;
+}
+
+/**
+ * xilinx_dma_irq_handler - DMA Interrupt handler
+ * @irq: IRQ number
+ * @data: Pointer to the Xilinx DMA channel structure
+ *
+ * In the hybrid completion mode the completion interrupts are masked here
+ * and the cleanup polls until the channel goes quiet, as NAPI does.
+ *
+ * Return: IRQ_HANDLED/IRQ_NONE
+ */
+static irqreturn_t xilinx_dma_irq_handler(int irq, void *data)
+{
+	struct xilinx_dma_chan *chan = data;
+
+	spin_lock(&chan->lock);
+	if (!xilinx_dma_handle_status(chan)) {
 		spin_unlock(&chan->lock);
+		return IRQ_NONE;
 	}
 
-	tasklet_schedule(&chan->tasklet);
+	if (chan->poll_mode == XILINX_DMA_POLL_HYBRID)
+		dma_ctrl_clr(chan, XILINX_DMA_REG_DMACR,
+			     XILINX_DMA_DMAXR_DONE_IRQ_MASK);
+	spin_unlock(&chan->lock);
+
+	xilinx_dma_schedule_cleanup(chan);
 	return IRQ_HANDLED;
 }
 
+/**
+ * xilinx_dma_poll_status - Reap the channel events without the interrupt
+ * @chan: Driver specific DMA channel
+ *
+ * Return: true if there was an event, false otherwise
+ */
+static bool xilinx_dma_poll_status(struct xilinx_dma_chan *chan)
+{
+	unsigned long flags;
+	bool ret;
+
+	spin_lock_irqsave(&chan->lock, flags);
+	ret = xilinx_dma_handle_status(chan);
+	spin_unlock_irqrestore(&chan->lock, flags);
+
+	return ret;
+}
+
+/**
+ * xilinx_dma_tx_status - Get DMA transaction status
+ * @dchan: DMA channel
+ * @cookie: Transaction identifier
+ * @txstate: Transaction state
+ *
+ * Return: DMA transaction status
+ */
+static enum dma_status xilinx_dma_tx_status(struct dma_chan *dchan,
+					dma_cookie_t cookie,
+					struct dma_tx_state *txstate)
+{
+	struct xilinx_dma_chan *chan = to_xilinx_chan(dchan);
+	struct xilinx_dma_tx_descriptor *desc;
+	enum dma_status ret;
+	unsigned long flags;
+	u32 residue = 0;
+
+	ret = dma_cookie_status(dchan, cookie, txstate);
+
+	/*
+	 * In the polled modes complete the finished descriptors inline, the
+	 * callbacks then run in the caller context.
+	 */
+	if (ret != DMA_COMPLETE && chan->poll_mode != XILINX_DMA_POLL_NONE &&
+	    xilinx_dma_poll_status(chan)) {
+		xilinx_dma_chan_desc_cleanup(chan);
+		ret = dma_cookie_status(dchan, cookie, txstate);
+	}
+
+	if (ret == DMA_COMPLETE || !txstate)
+		return ret;
+
+	spin_lock_irqsave(&chan->lock, flags);
+	if (!list_empty(&chan->active_list)) {
+		desc = list_last_entry(&chan->active_list,
+				       struct xilinx_dma_tx_descriptor, node);
+		/*
+		 * VDMA and simple mode do not support residue reporting, so the
+		 * residue field will always be 0.
+		 */
+		if (chan->has_sg && chan->xdev->dma_config->dmatype != XDMA_TYPE_VDMA)
+			residue = xilinx_dma_get_residue(chan, desc);
+	}
+	spin_unlock_irqrestore(&chan->lock, flags);
+
+	dma_set_residue(txstate, residue);
+
+	return ret;
+}
+
+
 /**
  * append_desc_queue - Queuing descriptor
  * @chan: Driver specific dma channel
@@ -1958,6 +2307,8 @@ static dma_cookie_t xilinx_dma_tx_submit(struct dma_async_tx_descriptor *tx)
 	spin_lock_irqsave(&chan->lock, flags);
 
 	cookie = dma_cookie_assign(tx);
+	desc->submit_time = xilinx_dma_lat_stamp();
+	trace_xilinx_dma_submit(tx->chan, cookie);
 
 	/* Put this transaction onto the tail of the pending queue */
 	append_desc_queue(chan, desc);
@@ -2126,7 +2477,7 @@ static struct dma_async_tx_descriptor *xilinx_dma_prep_slave_sg(
 {
 	struct xilinx_dma_chan *chan = to_xilinx_chan(dchan);
 	struct xilinx_dma_tx_descriptor *desc;
-	struct xilinx_axidma_tx_segment *segment = NULL;
+	struct xilinx_axidma_tx_segment *segment = NULL, *prev = NULL;
 	u32 *app_w = (u32 *)context;
 	struct scatterlist *sg;
 	size_t copy;
@@ -2177,6 +2528,18 @@ static struct dma_async_tx_descriptor *xilinx_dma_prep_slave_sg(
 					       XILINX_DMA_NUM_APP_WORDS);
 			}
 
+			/*
+			 * Free segments come back in any order, so chain
+			 * them explicitly.
+			 */
+			if (prev) {
+				prev->hw.next_desc =
+					lower_32_bits(segment->phys);
+				prev->hw.next_desc_msb =
+					upper_32_bits(segment->phys);
+			}
+
+			prev = segment;
 			sg_used += copy;
 
 			/*
@@ -2333,7 +2696,7 @@ xilinx_mcdma_prep_slave_sg(struct dma_chan *dchan, struct scatterlist *sgl,
 {
 	struct xilinx_dma_chan *chan = to_xilinx_chan(dchan);
 	struct xilinx_dma_tx_descriptor *desc;
-	struct xilinx_aximcdma_tx_segment *segment = NULL;
+	struct xilinx_aximcdma_tx_segment *segment = NULL, *prev = NULL;
 	u32 *app_w = (u32 *)context;
 	struct scatterlist *sg;
 	size_t copy;
@@ -2382,6 +2745,18 @@ xilinx_mcdma_prep_slave_sg(struct dma_chan *dchan, struct scatterlist *sgl,
 				       XILINX_DMA_NUM_APP_WORDS);
 			}
 
+			/*
+			 * Free segments come back in any order, so chain
+			 * them explicitly.
+			 */
+			if (prev) {
+				prev->hw.next_desc =
+					lower_32_bits(segment->phys);
+				prev->hw.next_desc_msb =
+					upper_32_bits(segment->phys);
+			}
+
+			prev = segment;
 			sg_used += copy;
 			/*
 			 * Insert the segment into the descriptor segments
@@ -2524,6 +2899,88 @@ int xilinx_vdma_channel_set_config(struct dma_chan *dchan,
 }
 EXPORT_SYMBOL(xilinx_vdma_channel_set_config);
 
+/**
+ * xilinx_dma_channel_set_poll_mode - Select the completion mode
+ * @dchan: DMA channel
+ * @mode: Completion mode
+ *
+ * By default descriptors complete from the IRQ handler and the tasklet.
+ * XILINX_DMA_POLL_ONLY masks the completion interrupts, descriptors then
+ * only complete when the client calls dmaengine_tx_status(), with the
+ * callbacks run from that call. XILINX_DMA_POLL_HYBRID keeps the
+ * interrupt for the first completion, then masks it and polls from the
+ * tasklet while transfers keep completing. dmaengine_tx_status()
+ * completes descriptors inline in both polled modes. Only AXI DMA and CDMA
+ * channels, without cyclic transfers, support the polled modes.
+ *
+ * Return: '0' on success, -EINVAL on an unsupported channel or mode and
+ * -EBUSY while transfers are queued
+ */
+int xilinx_dma_channel_set_poll_mode(struct dma_chan *dchan,
+				     enum xilinx_dma_poll_mode mode)
+{
+	struct xilinx_dma_chan *chan = to_xilinx_chan(dchan);
+	enum xdma_ip_type dmatype = chan->xdev->dma_config->dmatype;
+	unsigned long flags;
+
+	if (mode != XILINX_DMA_POLL_NONE && mode != XILINX_DMA_POLL_ONLY &&
+	    mode != XILINX_DMA_POLL_HYBRID)
+		return -EINVAL;
+
+	if (mode != XILINX_DMA_POLL_NONE &&
+	    dmatype != XDMA_TYPE_AXIDMA && dmatype != XDMA_TYPE_CDMA)
+		return -EINVAL;
+
+	spin_lock_irqsave(&chan->lock, flags);
+
+	if (chan->cyclic || !list_empty(&chan->pending_list) ||
+	    !list_empty(&chan->active_list)) {
+		spin_unlock_irqrestore(&chan->lock, flags);
+		return -EBUSY;
+	}
+
+	chan->poll_mode = mode;
+	dma_ctrl_clr(chan, XILINX_DMA_REG_DMACR, XILINX_DMA_DMAXR_ALL_IRQ_MASK);
+	dma_ctrl_set(chan, XILINX_DMA_REG_DMACR, xilinx_dma_irq_mask(chan));
+
+	spin_unlock_irqrestore(&chan->lock, flags);
+
+	return 0;
+}
+EXPORT_SYMBOL(xilinx_dma_channel_set_poll_mode);
+
+/**
+ * xilinx_mcdma_channel_set_config - Configure the MCDMA channel scheduling
+ * @dchan: DMA channel
+ * @cfg: MCDMA channel scheduling configuration
+ *
+ * With the weighted round robin MM2S scheduler of the core, each channel
+ * gets a share of the MM2S bandwidth proportional to its weight. The
+ * strict priority scheduler and the S2MM side are fixed in the core
+ * configuration, so the weight only applies to MM2S channels.
+ *
+ * Return: '0' on success and -EINVAL on an unsupported channel or weight
+ */
+int xilinx_mcdma_channel_set_config(struct dma_chan *dchan,
+				    struct xilinx_mcdma_config *cfg)
+{
+	struct xilinx_dma_chan *chan = to_xilinx_chan(dchan);
+
+	if (chan->xdev->dma_config->dmatype != XDMA_TYPE_AXIMCDMA ||
+	    chan->direction != DMA_MEM_TO_DEV)
+		return -EINVAL;
+
+	if (cfg->weight > XILINX_MCDMA_WEIGHT_MAX)
+		return -EINVAL;
+
+	chan->weight = cfg->weight;
+	chan->has_weight = true;
+	xilinx_mcdma_write_weights(chan->xdev);
+
+	return 0;
+}
+EXPORT_SYMBOL(xilinx_mcdma_channel_set_config);
+
 /* -----------------------------------------------------------------------------
  * Probe and remove
  */
@@ -2534,14 +2991,20 @@ EXPORT_SYMBOL(xilinx_vdma_channel_set_config);
  */
 static void xilinx_dma_chan_remove(struct xilinx_dma_chan *chan)
 {
+	xilinx_dma_lat_hist_exit(&chan->lat_hist);
+
 	/* Disable all interrupts */
 	dma_ctrl_clr(chan, XILINX_DMA_REG_DMACR,
 		      XILINX_DMA_DMAXR_ALL_IRQ_MASK);
 
-	if (chan->irq > 0)
+	if (chan->irq > 0) {
+		irq_set_affinity_hint(chan->irq, NULL);
 		free_irq(chan->irq, chan);
+	}
 
 	tasklet_kill(&chan->tasklet);
+	if (chan->cleanup_worker)
+		kthread_destroy_worker(chan->cleanup_worker);
 
 	list_del(&chan->common.device_node);
 }
@@ -2744,6 +3207,57 @@ static void xdma_disable_allclks(struct xilinx_dma_device *xdev)
 	clk_disable_unprepare(xdev->axi_clk);
 }
 
+/**
+ * xilinx_dma_chan_worker_init - Set up the cleanup thread of a channel
+ * @chan: Driver specific DMA channel
+ * @node: Device node of the channel
+ *
+ * The completion callbacks run from the channel tasklet by default, that
+ * is in softirq context on whichever CPU took the interrupt, where heavy
+ * clients compete with the network Rx softirq. "xlnx,threaded-completion"
+ * moves them to a kthread of the channel whose affinity and priority can
+ * be tuned from user space, "xlnx,completion-cpu" additionally binds that
+ * thread to the given CPU. Otherwise the thread, like the interrupt and so
+ * the tasklet, stays off the CPUs isolated with isolcpus=.
+ *
+ * Return: '0' on success and failure value on error
+ */
+static int xilinx_dma_chan_worker_init(struct xilinx_dma_chan *chan,
+				       struct device_node *node)
+{
+	struct kthread_worker *worker;
+	u32 cpu;
+
+	kthread_init_work(&chan->cleanup_work, xilinx_dma_do_work);
+
+	if (!of_property_read_u32(node, "xlnx,completion-cpu", &cpu)) {
+		if (cpu >= nr_cpu_ids || !cpu_online(cpu)) {
+			dev_err(chan->dev, "invalid xlnx,completion-cpu %u\n",
+				cpu);
+			return -EINVAL;
+		}
+		worker = kthread_create_worker_on_cpu(cpu, 0, "%s/%d-%d",
+						      dev_name(chan->dev),
+						      chan->id, cpu);
+	} else if (of_property_read_bool(node, "xlnx,threaded-completion")) {
+		worker = kthread_create_worker(0, "%s/%d",
+					       dev_name(chan->dev), chan->id);
+		if (!IS_ERR(worker) && housekeeping_enabled(HK_FLAG_DOMAIN))
+			set_cpus_allowed_ptr(worker->task,
+				housekeeping_cpumask(HK_FLAG_DOMAIN));
+	} else {
+		return 0;
+	}
+
+	if (IS_ERR(worker)) {
+		dev_err(chan->dev, "failed to create cleanup thread\n");
+		return PTR_ERR(worker);
+	}
+
+	chan->cleanup_worker = worker;
+	return 0;
+}
+
 /**
  * xilinx_dma_chan_probe - Per Channel Probing
  * It get channel features from the device tree entry and
@@ -2779,10 +3293,11 @@ static int xilinx_dma_chan_probe(struct xilinx_dma_device *xdev,
 	chan->idle = true;
 
 	spin_lock_init(&chan->lock);
+	spin_lock_init(&chan->seg_lock);
 	INIT_LIST_HEAD(&chan->pending_list);
 	INIT_LIST_HEAD(&chan->done_list);
 	INIT_LIST_HEAD(&chan->active_list);
-	INIT_LIST_HEAD(&chan->free_seg_list);
+	init_llist_head(&chan->free_seg_list);
 
 	/* Retrieve the channel properties from the device tree */
 	has_dre = of_property_read_bool(node, "xlnx,include-dre");
@@ -2852,14 +3367,23 @@ static int xilinx_dma_chan_probe(struct xilinx_dma_device *xdev,
 		return -EINVAL;
 	}
 
+	err = xilinx_dma_chan_worker_init(chan, node);
+	if (err)
+		return err;
+
 	/* Request the interrupt */
 	chan->irq = irq_of_parse_and_map(node, chan->tdest);
 	err = request_irq(chan->irq, xdev->dma_config->irq_handler,
 			  IRQF_SHARED, "xilinx-dma-controller", chan);
 	if (err) {
 		dev_err(xdev->dev, "unable to request IRQ %d\n", chan->irq);
+		if (chan->cleanup_worker)
+			kthread_destroy_worker(chan->cleanup_worker);
 		return err;
 	}
+	if (housekeeping_enabled(HK_FLAG_DOMAIN))
+		irq_set_affinity_hint(chan->irq,
+				      housekeeping_cpumask(HK_FLAG_DOMAIN));
 
 	if (xdev->dma_config->dmatype == XDMA_TYPE_AXIDMA) {
 		chan->start_transfer = xilinx_dma_start_transfer;
@@ -3011,6 +3535,7 @@ static int xilinx_dma_probe(struct platform_device *pdev)
 		return -ENOMEM;
 
 	xdev->dev = &pdev->dev;
+	spin_lock_init(&xdev->weight_lock);
 	if (np) {
 		const struct of_device_id *match;
 
@@ -3135,6 +3660,11 @@ static int xilinx_dma_probe(struct platform_device *pdev)
 	/* Register the DMA engine with the core */
 	dma_async_device_register(&xdev->common);
 
+	for (i = 0; i < xdev->dma_config->max_channels; i++)
+		if (xdev->chan[i])
+			xilinx_dma_lat_hist_init(&xdev->chan[i]->lat_hist,
+						 &xdev->chan[i]->common);
+
 	err = of_dma_controller_register(node, of_dma_xilinx_xlate,
 					 xdev);
 	if (err < 0) {
@@ -3192,6 +3722,7 @@ static struct platform_driver xilinx_vdma_driver = {
 	.driver = {
 		.name = "xilinx-vdma",
 		.of_match_table = xilinx_dma_of_ids,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 	.probe = xilinx_dma_probe,
 	.remove = xilinx_dma_remove,
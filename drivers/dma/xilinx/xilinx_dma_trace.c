@@ -0,0 +1,160 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Tracepoints and latency histograms of the Xilinx DMA engines
+ *
+ * The tracepoints are shared by the AXI DMA, ZynqMP DMA, framebuffer and
+ * DPDMA drivers, so they are instantiated once here.
+ *
+ * With CONFIG_XILINX_DMA_LAT_HIST every channel gets a histogram of the
+ * time from the submission of a descriptor to its completion callback in
+ * /sys/kernel/debug/xilinx_dma/<channel>. Writing to the file clears it.
+ */
+
+#include <linux/debugfs.h>
+#include <linux/log2.h>
+#include <linux/math64.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/seq_file.h>
+
+#define CREATE_TRACE_POINTS
+#include "xilinx_dma_trace.h"
+
+EXPORT_TRACEPOINT_SYMBOL_GPL(xilinx_dma_submit);
+EXPORT_TRACEPOINT_SYMBOL_GPL(xilinx_dma_start);
+EXPORT_TRACEPOINT_SYMBOL_GPL(xilinx_dma_complete);
+EXPORT_TRACEPOINT_SYMBOL_GPL(xilinx_dma_callback);
+EXPORT_TRACEPOINT_SYMBOL_GPL(xilinx_dma_irq);
+EXPORT_TRACEPOINT_SYMBOL_GPL(xilinx_dma_cleanup);
+
+#ifdef CONFIG_XILINX_DMA_LAT_HIST
+
+static struct dentry *xilinx_dma_debugfs_root;
+static DEFINE_MUTEX(xilinx_dma_debugfs_lock);
+
+/**
+ * xilinx_dma_lat_hist_add - Account the latency of a completed descriptor
+ * @hist: Histogram of the channel
+ * @stamp: Submit time of the descriptor, from xilinx_dma_lat_stamp()
+ */
+void xilinx_dma_lat_hist_add(struct xilinx_dma_lat_hist *hist,
+			     ktime_t stamp)
+{
+	u64 ns = ktime_to_ns(ktime_sub(ktime_get(), stamp));
+	unsigned int i;
+	unsigned long flags;
+
+	i = min_t(unsigned int, fls64(div_u64(ns, NSEC_PER_USEC)),
+		  XILINX_DMA_LAT_HIST_BUCKETS - 1);
+
+	spin_lock_irqsave(&hist->lock, flags);
+	hist->bucket[i]++;
+	hist->count++;
+	hist->total_ns += ns;
+	if (ns > hist->max_ns)
+		hist->max_ns = ns;
+	spin_unlock_irqrestore(&hist->lock, flags);
+}
+EXPORT_SYMBOL_GPL(xilinx_dma_lat_hist_add);
+
+static int xilinx_dma_lat_hist_show(struct seq_file *m, void *unused)
+{
+	struct xilinx_dma_lat_hist *hist = m->private;
+	struct xilinx_dma_lat_hist snap;
+	unsigned int i;
+
+	spin_lock_irq(&hist->lock);
+	memcpy(snap.bucket, hist->bucket, sizeof(snap.bucket));
+	snap.count = hist->count;
+	snap.total_ns = hist->total_ns;
+	snap.max_ns = hist->max_ns;
+	spin_unlock_irq(&hist->lock);
+
+	seq_printf(m, "count %llu avg %llu ns max %llu ns\n", snap.count,
+		   snap.count ? div64_u64(snap.total_ns, snap.count) : 0,
+		   snap.max_ns);
+
+	seq_printf(m, "%10s - %-10lu us: %llu\n", "0", 1UL, snap.bucket[0]);
+	for (i = 1; i < XILINX_DMA_LAT_HIST_BUCKETS - 1; i++)
+		seq_printf(m, "%10lu - %-10lu us: %llu\n", 1UL << (i - 1),
+			   1UL << i, snap.bucket[i]);
+	seq_printf(m, "%10lu - %-10s us: %llu\n", 1UL << (i - 1), "",
+		   snap.bucket[i]);
+
+	return 0;
+}
+
+static int xilinx_dma_lat_hist_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, xilinx_dma_lat_hist_show, inode->i_private);
+}
+
+static ssize_t xilinx_dma_lat_hist_write(struct file *file,
+					 const char __user *buf, size_t count,
+					 loff_t *ppos)
+{
+	struct seq_file *m = file->private_data;
+	struct xilinx_dma_lat_hist *hist = m->private;
+
+	spin_lock_irq(&hist->lock);
+	memset(hist->bucket, 0, sizeof(hist->bucket));
+	hist->count = 0;
+	hist->total_ns = 0;
+	hist->max_ns = 0;
+	spin_unlock_irq(&hist->lock);
+
+	return count;
+}
+
+static const struct file_operations xilinx_dma_lat_hist_fops = {
+	.owner		= THIS_MODULE,
+	.open		= xilinx_dma_lat_hist_open,
+	.read		= seq_read,
+	.write		= xilinx_dma_lat_hist_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+/**
+ * xilinx_dma_lat_hist_init - Create the latency histogram of a channel
+ * @hist: Histogram of the channel
+ * @chan: DMA channel, already registered with the DMA engine core
+ */
+void xilinx_dma_lat_hist_init(struct xilinx_dma_lat_hist *hist,
+			      struct dma_chan *chan)
+{
+	spin_lock_init(&hist->lock);
+
+	mutex_lock(&xilinx_dma_debugfs_lock);
+	if (!xilinx_dma_debugfs_root)
+		xilinx_dma_debugfs_root = debugfs_create_dir("xilinx_dma",
+							     NULL);
+	mutex_unlock(&xilinx_dma_debugfs_lock);
+
+	hist->dentry = debugfs_create_file(dma_chan_name(chan), 0600,
+					   xilinx_dma_debugfs_root, hist,
+					   &xilinx_dma_lat_hist_fops);
+}
+EXPORT_SYMBOL_GPL(xilinx_dma_lat_hist_init);
+
+/**
+ * xilinx_dma_lat_hist_exit - Remove the latency histogram of a channel
+ * @hist: Histogram of the channel
+ */
+void xilinx_dma_lat_hist_exit(struct xilinx_dma_lat_hist *hist)
+{
+	debugfs_remove(hist->dentry);
+	hist->dentry = NULL;
+}
+EXPORT_SYMBOL_GPL(xilinx_dma_lat_hist_exit);
+
+static void __exit xilinx_dma_trace_exit(void)
+{
+	debugfs_remove_recursive(xilinx_dma_debugfs_root);
+}
+module_exit(xilinx_dma_trace_exit);
+
+#endif /* CONFIG_XILINX_DMA_LAT_HIST */
+
+MODULE_DESCRIPTION("Xilinx DMA engines tracepoints and latency histograms");
+MODULE_LICENSE("GPL v2");
@@ -0,0 +1,75 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Tracepoints and latency histograms of the Xilinx DMA engines
+ */
+
+#ifndef __XILINX_DMA_TRACE_H
+#define __XILINX_DMA_TRACE_H
+
+#include <linux/dmaengine.h>
+#include <linux/ktime.h>
+#include <linux/spinlock.h>
+
+#include <trace/events/xilinx_dma.h>
+
+/* Power of two buckets in microseconds, the last one is open ended */
+#define XILINX_DMA_LAT_HIST_BUCKETS	24
+
+/**
+ * struct xilinx_dma_lat_hist - Submit to callback latency of a channel
+ * @lock: Protects the counters
+ * @bucket: Number of descriptors per latency bucket
+ * @count: Number of descriptors
+ * @total_ns: Sum of the latencies
+ * @max_ns: Highest latency
+ * @dentry: debugfs file of the histogram
+ */
+struct xilinx_dma_lat_hist {
+#ifdef CONFIG_XILINX_DMA_LAT_HIST
+	spinlock_t lock;
+	u64 bucket[XILINX_DMA_LAT_HIST_BUCKETS];
+	u64 count;
+	u64 total_ns;
+	u64 max_ns;
+	struct dentry *dentry;
+#endif
+};
+
+#ifdef CONFIG_XILINX_DMA_LAT_HIST
+void xilinx_dma_lat_hist_init(struct xilinx_dma_lat_hist *hist,
+			      struct dma_chan *chan);
+void xilinx_dma_lat_hist_exit(struct xilinx_dma_lat_hist *hist);
+void xilinx_dma_lat_hist_add(struct xilinx_dma_lat_hist *hist,
+			     ktime_t stamp);
+
+/**
+ * xilinx_dma_lat_stamp - Timestamp a descriptor on submit
+ *
+ * Return: the current time
+ */
+static inline ktime_t xilinx_dma_lat_stamp(void)
+{
+	return ktime_get();
+}
+#else
+static inline void xilinx_dma_lat_hist_init(struct xilinx_dma_lat_hist *hist,
+					    struct dma_chan *chan)
+{
+}
+
+static inline void xilinx_dma_lat_hist_exit(struct xilinx_dma_lat_hist *hist)
+{
+}
+
+static inline void xilinx_dma_lat_hist_add(struct xilinx_dma_lat_hist *hist,
+					   ktime_t stamp)
+{
+}
+
+static inline ktime_t xilinx_dma_lat_stamp(void)
+{
+	return 0;
+}
+#endif
+
+#endif /* __XILINX_DMA_TRACE_H */
@@ -0,0 +1,698 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Xilinx DMA engine benchmark module
+ *
+ * Copyright (C) 2020 Xilinx, Inc. All rights reserved.
+ *
+ * Measures throughput, per transfer latency and CPU utilization of the
+ * ZynqMP DMA and AXI CDMA memcpy channels and of AXI DMA/MCDMA loopback
+ * channel pairs, for a sweep of transfer sizes with a configurable number
+ * of threads and descriptors in flight.  The cost of dma_map_single() and
+ * dma_map_sg() on the device of each channel is measured as well, so that
+ * configurations with and without an SMMU can be compared.
+ */
+#include <linux/delay.h>
+#include <linux/dma-mapping.h>
+#include <linux/dmaengine.h>
+#include <linux/init.h>
+#include <linux/iommu.h>
+#include <linux/kernel_stat.h>
+#include <linux/kthread.h>
+#include <linux/module.h>
+#include <linux/of_dma.h>
+#include <linux/platform_device.h>
+#include <linux/scatterlist.h>
+#include <linux/slab.h>
+#include <linux/sched/task.h>
+
+static unsigned int threads_per_chan = 1;
+module_param(threads_per_chan, uint, 0444);
+MODULE_PARM_DESC(threads_per_chan, "Threads per channel (default: 1)");
+
+static unsigned int queue_depth = 4;
+module_param(queue_depth, uint, 0444);
+MODULE_PARM_DESC(queue_depth,
+		 "Descriptors in flight per thread (default: 4)");
+
+static unsigned int min_size = 64;
+module_param(min_size, uint, 0444);
+MODULE_PARM_DESC(min_size, "Smallest transfer size of the sweep (default: 64)");
+
+static unsigned int max_size = SZ_1M;
+module_param(max_size, uint, 0444);
+MODULE_PARM_DESC(max_size,
+		 "Largest transfer size of the sweep, sizes double from min_size (default: 1M)");
+
+static unsigned int duration_ms = 1000;
+module_param(duration_ms, uint, 0444);
+MODULE_PARM_DESC(duration_ms, "Run time of each size in ms (default: 1000)");
+
+static unsigned int max_channels = 4;
+module_param(max_channels, uint, 0444);
+MODULE_PARM_DESC(max_channels,
+		 "Maximum number of memcpy channels to benchmark (default: 4, 0 disables)");
+
+static char channel[20];
+module_param_string(channel, channel, sizeof(channel), 0444);
+MODULE_PARM_DESC(channel, "Bus ID of the memcpy channel to benchmark (default: any)");
+
+static unsigned int map_iterations = 1000;
+module_param(map_iterations, uint, 0444);
+MODULE_PARM_DESC(map_iterations,
+		 "Iterations of the DMA mapping cost measurement (default: 1000, 0 disables)");
+
+#define DMABENCH_HIST_BUCKETS	16
+#define DMABENCH_TIMEOUT_MS	3000
+
+/**
+ * struct dmabench_slot - One descriptor kept in flight by a thread
+ * @src: Source buffer, the Tx buffer of a slave pair
+ * @dst: Destination buffer, the Rx buffer of a slave pair
+ * @src_dma: DMA address of @src
+ * @dst_dma: DMA address of @dst
+ * @start: Submission time
+ * @end: Completion time, set by the callback
+ * @done: Completed by the callback
+ * @cookie: Cookie of the descriptor
+ * @busy: Descriptor submitted and not waited for yet
+ */
+struct dmabench_slot {
+	void *src;
+	void *dst;
+	dma_addr_t src_dma;
+	dma_addr_t dst_dma;
+	ktime_t start;
+	ktime_t end;
+	struct completion done;
+	dma_cookie_t cookie;
+	bool busy;
+};
+
+/**
+ * struct dmabench_stats - Results of one thread for one transfer size
+ * @bytes: Bytes transferred
+ * @xfers: Transfers completed
+ * @errors: Transfers that failed to prepare, submit or complete
+ * @lat_sum_ns: Sum of the transfer latencies
+ * @lat_max_ns: Largest transfer latency
+ * @hist: Latency histogram, bucket n counts latencies in [2^(n-1), 2^n) us,
+ *	the last bucket counts all the longer ones
+ */
+struct dmabench_stats {
+	u64 bytes;
+	u64 xfers;
+	u64 errors;
+	u64 lat_sum_ns;
+	u64 lat_max_ns;
+	u64 hist[DMABENCH_HIST_BUCKETS];
+};
+
+/**
+ * struct dmabench_thread - Benchmark thread
+ * @task: Thread
+ * @tx_chan: Memcpy channel, or Tx channel of a slave pair
+ * @rx_chan: Rx channel of a slave pair, NULL for memcpy
+ * @size: Transfer size
+ * @slots: @queue_depth descriptors
+ * @stats: Results
+ */
+struct dmabench_thread {
+	struct task_struct *task;
+	struct dma_chan *tx_chan;
+	struct dma_chan *rx_chan;
+	unsigned int size;
+	struct dmabench_slot *slots;
+	struct dmabench_stats stats;
+};
+
+static struct task_struct *dmabench_memcpy_task;
+
+static struct device *dmabench_dma_dev(struct dma_chan *chan)
+{
+	return chan->device->dev;
+}
+
+static void dmabench_callback(void *arg)
+{
+	struct dmabench_slot *slot = arg;
+
+	slot->end = ktime_get();
+	complete(&slot->done);
+}
+
+static void dmabench_free_slots(struct dmabench_thread *thread)
+{
+	struct device *tx_dev = dmabench_dma_dev(thread->tx_chan);
+	struct device *rx_dev = thread->rx_chan ?
+		dmabench_dma_dev(thread->rx_chan) : tx_dev;
+	unsigned int i;
+
+	for (i = 0; i < queue_depth; i++) {
+		struct dmabench_slot *slot = &thread->slots[i];
+
+		if (slot->src)
+			dma_free_coherent(tx_dev, thread->size, slot->src,
+					  slot->src_dma);
+		if (slot->dst)
+			dma_free_coherent(rx_dev, thread->size, slot->dst,
+					  slot->dst_dma);
+	}
+	kfree(thread->slots);
+}
+
+static int dmabench_alloc_slots(struct dmabench_thread *thread)
+{
+	struct device *tx_dev = dmabench_dma_dev(thread->tx_chan);
+	struct device *rx_dev = thread->rx_chan ?
+		dmabench_dma_dev(thread->rx_chan) : tx_dev;
+	unsigned int i;
+
+	thread->slots = kcalloc(queue_depth, sizeof(*thread->slots),
+				GFP_KERNEL);
+	if (!thread->slots)
+		return -ENOMEM;
+
+	for (i = 0; i < queue_depth; i++) {
+		struct dmabench_slot *slot = &thread->slots[i];
+
+		slot->src = dma_alloc_coherent(tx_dev, thread->size,
+					       &slot->src_dma, GFP_KERNEL);
+		slot->dst = dma_alloc_coherent(rx_dev, thread->size,
+					       &slot->dst_dma, GFP_KERNEL);
+		if (!slot->src || !slot->dst) {
+			dmabench_free_slots(thread);
+			return -ENOMEM;
+		}
+		init_completion(&slot->done);
+	}
+
+	return 0;
+}
+
+static int dmabench_submit(struct dmabench_thread *thread,
+			   struct dmabench_slot *slot)
+{
+	enum dma_ctrl_flags flags = DMA_CTRL_ACK | DMA_PREP_INTERRUPT;
+	struct dma_async_tx_descriptor *txd, *rxd;
+	dma_cookie_t cookie;
+
+	reinit_completion(&slot->done);
+	slot->start = ktime_get();
+
+	if (!thread->rx_chan) {
+		txd = dmaengine_prep_dma_memcpy(thread->tx_chan, slot->dst_dma,
+						slot->src_dma, thread->size,
+						flags);
+		if (!txd)
+			return -ENOMEM;
+
+		txd->callback = dmabench_callback;
+		txd->callback_param = slot;
+		slot->cookie = dmaengine_submit(txd);
+		if (dma_submit_error(slot->cookie))
+			return -EIO;
+
+		dma_async_issue_pending(thread->tx_chan);
+		slot->busy = true;
+		return 0;
+	}
+
+	/* Loopback: the transfer is complete once the Rx side is */
+	rxd = dmaengine_prep_slave_single(thread->rx_chan, slot->dst_dma,
+					  thread->size, DMA_DEV_TO_MEM, flags);
+	txd = dmaengine_prep_slave_single(thread->tx_chan, slot->src_dma,
+					  thread->size, DMA_MEM_TO_DEV,
+					  DMA_CTRL_ACK);
+	if (!rxd || !txd)
+		return -ENOMEM;
+
+	rxd->callback = dmabench_callback;
+	rxd->callback_param = slot;
+	slot->cookie = dmaengine_submit(rxd);
+	cookie = dmaengine_submit(txd);
+	if (dma_submit_error(slot->cookie) || dma_submit_error(cookie))
+		return -EIO;
+
+	dma_async_issue_pending(thread->rx_chan);
+	dma_async_issue_pending(thread->tx_chan);
+	slot->busy = true;
+	return 0;
+}
+
+static int dmabench_wait(struct dmabench_thread *thread,
+			 struct dmabench_slot *slot)
+{
+	struct dmabench_stats *stats = &thread->stats;
+	struct dma_chan *chan = thread->rx_chan ?: thread->tx_chan;
+	unsigned long tmo = msecs_to_jiffies(DMABENCH_TIMEOUT_MS);
+	unsigned int bucket;
+	u64 lat;
+
+	slot->busy = false;
+	if (!wait_for_completion_timeout(&slot->done, tmo) ||
+	    dma_async_is_tx_complete(chan, slot->cookie, NULL, NULL) !=
+	    DMA_COMPLETE) {
+		stats->errors++;
+		return -ETIMEDOUT;
+	}
+
+	lat = ktime_to_ns(ktime_sub(slot->end, slot->start));
+	bucket = min_t(unsigned int, fls64(div_u64(lat, NSEC_PER_USEC)),
+		       DMABENCH_HIST_BUCKETS - 1);
+
+	stats->bytes += thread->size;
+	stats->xfers++;
+	stats->lat_sum_ns += lat;
+	stats->lat_max_ns = max(stats->lat_max_ns, lat);
+	stats->hist[bucket]++;
+	return 0;
+}
+
+static int dmabench_thread_func(void *data)
+{
+	struct dmabench_thread *thread = data;
+	unsigned int i = 0;
+	int ret = 0;
+
+	/* Fill the queue, then resubmit each descriptor as it completes */
+	while (!kthread_should_stop()) {
+		struct dmabench_slot *slot = &thread->slots[i];
+
+		if (slot->busy) {
+			ret = dmabench_wait(thread, slot);
+			if (ret)
+				break;
+		}
+
+		ret = dmabench_submit(thread, slot);
+		if (ret) {
+			thread->stats.errors++;
+			break;
+		}
+
+		i = (i + 1) % queue_depth;
+	}
+
+	for (i = 0; i < queue_depth; i++)
+		if (thread->slots[i].busy && dmabench_wait(thread,
+							   &thread->slots[i]))
+			ret = -ETIMEDOUT;
+
+	if (ret) {
+		dmaengine_terminate_sync(thread->tx_chan);
+		if (thread->rx_chan)
+			dmaengine_terminate_sync(thread->rx_chan);
+	}
+
+	/* Wait for kthread_stop() so that the task is still around */
+	while (!kthread_should_stop())
+		schedule_timeout_interruptible(1);
+
+	return ret;
+}
+
+static u64 dmabench_cpu_busy_ns(void)
+{
+	u64 busy = 0;
+	int cpu;
+
+	for_each_online_cpu(cpu) {
+		u64 *cpustat = kcpustat_cpu(cpu).cpustat;
+
+		busy += cpustat[CPUTIME_USER] + cpustat[CPUTIME_NICE] +
+			cpustat[CPUTIME_SYSTEM] + cpustat[CPUTIME_IRQ] +
+			cpustat[CPUTIME_SOFTIRQ];
+	}
+
+	return busy;
+}
+
+static void dmabench_report(const char *name, unsigned int size,
+			    struct dmabench_stats *total, u64 elapsed_ns,
+			    u64 busy_ns)
+{
+	u64 total_ns = elapsed_ns * num_online_cpus();
+	char hist[DMABENCH_HIST_BUCKETS * 24];
+	unsigned int i, len = 0;
+
+	pr_info("%s: size %u threads %u depth %u: %llu KB/s %llu xfers/s lat avg %llu us max %llu us cpu %llu%% errors %llu\n",
+		name, size, threads_per_chan, queue_depth,
+		div64_u64(total->bytes * NSEC_PER_SEC >> 10, elapsed_ns),
+		div64_u64(total->xfers * NSEC_PER_SEC, elapsed_ns),
+		total->xfers ? div64_u64(total->lat_sum_ns,
+					 total->xfers * NSEC_PER_USEC) : 0,
+		div_u64(total->lat_max_ns, NSEC_PER_USEC),
+		total_ns ? div64_u64(busy_ns * 100, total_ns) : 0,
+		total->errors);
+
+	for (i = 0; i < DMABENCH_HIST_BUCKETS; i++)
+		if (total->hist[i])
+			len += scnprintf(hist + len, sizeof(hist) - len,
+					 " %s%uus:%llu",
+					 i < DMABENCH_HIST_BUCKETS - 1 ? "<" : ">=",
+					 1 << min(i, DMABENCH_HIST_BUCKETS - 2U),
+					 total->hist[i]);
+	if (len)
+		pr_info("%s: size %u latency%s\n", name, size, hist);
+}
+
+static int dmabench_run_size(struct dma_chan *tx_chan,
+			     struct dma_chan *rx_chan, unsigned int size)
+{
+	const char *name = dma_chan_name(tx_chan);
+	struct dmabench_stats total = { 0 };
+	struct dmabench_thread *threads;
+	unsigned int i, j, started = 0;
+	u64 busy, elapsed;
+	ktime_t start;
+	int ret = 0;
+
+	threads = kcalloc(threads_per_chan, sizeof(*threads), GFP_KERNEL);
+	if (!threads)
+		return -ENOMEM;
+
+	for (i = 0; i < threads_per_chan; i++) {
+		threads[i].tx_chan = tx_chan;
+		threads[i].rx_chan = rx_chan;
+		threads[i].size = size;
+		ret = dmabench_alloc_slots(&threads[i]);
+		if (ret)
+			goto free_slots;
+	}
+
+	busy = dmabench_cpu_busy_ns();
+	start = ktime_get();
+	for (i = 0; i < threads_per_chan; i++) {
+		struct task_struct *task;
+
+		task = kthread_run(dmabench_thread_func, &threads[i],
+				   "dmabench-%s/%u", name, i);
+		if (IS_ERR(task)) {
+			ret = PTR_ERR(task);
+			break;
+		}
+		get_task_struct(task);
+		threads[i].task = task;
+		started++;
+	}
+
+	if (started)
+		msleep_interruptible(duration_ms);
+
+	for (i = 0; i < started; i++) {
+		kthread_stop(threads[i].task);
+		put_task_struct(threads[i].task);
+	}
+	elapsed = ktime_to_ns(ktime_sub(ktime_get(), start));
+	busy = dmabench_cpu_busy_ns() - busy;
+
+	for (i = 0; i < started; i++) {
+		struct dmabench_stats *stats = &threads[i].stats;
+
+		total.bytes += stats->bytes;
+		total.xfers += stats->xfers;
+		total.errors += stats->errors;
+		total.lat_sum_ns += stats->lat_sum_ns;
+		total.lat_max_ns = max(total.lat_max_ns, stats->lat_max_ns);
+		for (j = 0; j < DMABENCH_HIST_BUCKETS; j++)
+			total.hist[j] += stats->hist[j];
+	}
+
+	if (started && elapsed)
+		dmabench_report(name, size, &total, elapsed, busy);
+
+	i = threads_per_chan;
+free_slots:
+	while (i--)
+		dmabench_free_slots(&threads[i]);
+	kfree(threads);
+	return ret;
+}
+
+static void dmabench_run_map(struct device *dev, const char *name)
+{
+	unsigned int size, nents, i, n;
+	struct scatterlist *sgl, *sg;
+	u64 map_ns, unmap_ns, sg_map_ns, sg_unmap_ns;
+	struct page **pages;
+	dma_addr_t dma;
+	ktime_t t0, t1, t2;
+	void *buf;
+
+	if (!map_iterations)
+		return;
+
+	for (size = min_size; size && size <= max_size; size <<= 1) {
+		buf = kmalloc(size, GFP_KERNEL);
+		nents = DIV_ROUND_UP(size, PAGE_SIZE);
+		pages = kcalloc(nents, sizeof(*pages), GFP_KERNEL);
+		sgl = kmalloc_array(nents, sizeof(*sgl), GFP_KERNEL);
+		if (!buf || !pages || !sgl)
+			goto free;
+
+		/* One page per entry, as for a user buffer */
+		sg_init_table(sgl, nents);
+		for_each_sg(sgl, sg, nents, i) {
+			pages[i] = alloc_page(GFP_KERNEL);
+			if (!pages[i])
+				goto free;
+			sg_set_page(sg, pages[i], min_t(unsigned int, size,
+							PAGE_SIZE), 0);
+		}
+
+		map_ns = unmap_ns = sg_map_ns = sg_unmap_ns = 0;
+		for (n = 0; n < map_iterations; n++) {
+			t0 = ktime_get();
+			dma = dma_map_single(dev, buf, size, DMA_BIDIRECTIONAL);
+			t1 = ktime_get();
+			if (dma_mapping_error(dev, dma))
+				goto free;
+			dma_unmap_single(dev, dma, size, DMA_BIDIRECTIONAL);
+			t2 = ktime_get();
+			map_ns += ktime_to_ns(ktime_sub(t1, t0));
+			unmap_ns += ktime_to_ns(ktime_sub(t2, t1));
+
+			t0 = ktime_get();
+			if (!dma_map_sg(dev, sgl, nents, DMA_BIDIRECTIONAL))
+				goto free;
+			t1 = ktime_get();
+			dma_unmap_sg(dev, sgl, nents, DMA_BIDIRECTIONAL);
+			t2 = ktime_get();
+			sg_map_ns += ktime_to_ns(ktime_sub(t1, t0));
+			sg_unmap_ns += ktime_to_ns(ktime_sub(t2, t1));
+
+			cond_resched();
+		}
+
+		pr_info("%s: size %u %s: map_single %llu ns unmap_single %llu ns map_sg(%u) %llu ns unmap_sg %llu ns\n",
+			name, size,
+			iommu_get_domain_for_dev(dev) ? "iommu" : "direct",
+			div_u64(map_ns, map_iterations),
+			div_u64(unmap_ns, map_iterations), nents,
+			div_u64(sg_map_ns, map_iterations),
+			div_u64(sg_unmap_ns, map_iterations));
+free:
+		if (pages)
+			for (i = 0; i < nents; i++)
+				if (pages[i])
+					__free_page(pages[i]);
+		kfree(sgl);
+		kfree(pages);
+		kfree(buf);
+	}
+}
+
+static void dmabench_run(struct dma_chan *tx_chan, struct dma_chan *rx_chan)
+{
+	struct dma_device *dma_dev = tx_chan->device;
+	unsigned int size, align = dma_dev->copy_align;
+	int ret;
+
+	if (rx_chan && rx_chan->device->copy_align > align)
+		align = rx_chan->device->copy_align;
+
+	dmabench_run_map(dmabench_dma_dev(tx_chan), dma_chan_name(tx_chan));
+
+	for (size = min_size; size && size <= max_size; size <<= 1) {
+		if (kthread_should_stop())
+			break;
+		if (!IS_ALIGNED(size, 1 << align))
+			continue;
+
+		ret = dmabench_run_size(tx_chan, rx_chan, size);
+		if (ret) {
+			pr_warn("%s: size %u failed (%d)\n",
+				dma_chan_name(tx_chan), size, ret);
+			break;
+		}
+	}
+}
+
+static bool dmabench_filter(struct dma_chan *chan, void *param)
+{
+	if (channel[0] == '\0')
+		return true;
+	return strcmp(dma_chan_name(chan), channel) == 0;
+}
+
+static int dmabench_memcpy_func(void *data)
+{
+	struct dma_chan **chans;
+	dma_cap_mask_t mask;
+	unsigned int i, nr = 0;
+
+	chans = kcalloc(max_channels, sizeof(*chans), GFP_KERNEL);
+	if (!chans)
+		goto out;
+
+	dma_cap_zero(mask);
+	dma_cap_set(DMA_MEMCPY, mask);
+	while (nr < max_channels) {
+		chans[nr] = dma_request_channel(mask, dmabench_filter, NULL);
+		if (!chans[nr])
+			break;
+		nr++;
+	}
+
+	if (!nr)
+		pr_info("dmabench: no memcpy channel\n");
+
+	for (i = 0; i < nr; i++)
+		dmabench_run(chans[i], NULL);
+
+	for (i = 0; i < nr; i++)
+		dma_release_channel(chans[i]);
+	kfree(chans);
+out:
+	while (!kthread_should_stop())
+		schedule_timeout_interruptible(HZ);
+	return 0;
+}
+
+/**
+ * struct dmabench_slave - AXI DMA/MCDMA loopback benchmark of a DT node
+ * @task: Controller thread
+ * @tx_chan: Tx channel
+ * @rx_chan: Rx channel
+ */
+struct dmabench_slave {
+	struct task_struct *task;
+	struct dma_chan *tx_chan;
+	struct dma_chan *rx_chan;
+};
+
+static int dmabench_slave_func(void *data)
+{
+	struct dmabench_slave *slave = data;
+
+	dmabench_run(slave->tx_chan, slave->rx_chan);
+
+	while (!kthread_should_stop())
+		schedule_timeout_interruptible(HZ);
+	return 0;
+}
+
+static int xilinx_dmabench_probe(struct platform_device *pdev)
+{
+	struct dmabench_slave *slave;
+	int err;
+
+	slave = devm_kzalloc(&pdev->dev, sizeof(*slave), GFP_KERNEL);
+	if (!slave)
+		return -ENOMEM;
+
+	slave->tx_chan = dma_request_chan(&pdev->dev, "axidma0");
+	if (IS_ERR(slave->tx_chan)) {
+		err = PTR_ERR(slave->tx_chan);
+		if (err != -EPROBE_DEFER)
+			dev_err(&pdev->dev, "No Tx channel\n");
+		return err;
+	}
+
+	slave->rx_chan = dma_request_chan(&pdev->dev, "axidma1");
+	if (IS_ERR(slave->rx_chan)) {
+		err = PTR_ERR(slave->rx_chan);
+		if (err != -EPROBE_DEFER)
+			dev_err(&pdev->dev, "No Rx channel\n");
+		goto free_tx;
+	}
+
+	slave->task = kthread_run(dmabench_slave_func, slave, "dmabench-%s",
+				  dma_chan_name(slave->tx_chan));
+	if (IS_ERR(slave->task)) {
+		err = PTR_ERR(slave->task);
+		goto free_rx;
+	}
+
+	platform_set_drvdata(pdev, slave);
+	return 0;
+
+free_rx:
+	dma_release_channel(slave->rx_chan);
+free_tx:
+	dma_release_channel(slave->tx_chan);
+	return err;
+}
+
+static int xilinx_dmabench_remove(struct platform_device *pdev)
+{
+	struct dmabench_slave *slave = platform_get_drvdata(pdev);
+
+	kthread_stop(slave->task);
+	dma_release_channel(slave->rx_chan);
+	dma_release_channel(slave->tx_chan);
+	return 0;
+}
+
+static const struct of_device_id xilinx_dmabench_of_ids[] = {
+	{ .compatible = "xlnx,axi-dma-bench-1.00.a",},
+	{}
+};
+MODULE_DEVICE_TABLE(of, xilinx_dmabench_of_ids);
+
+static struct platform_driver xilinx_dmabench_driver = {
+	.driver = {
+		.name = "xilinx_dmabench",
+		.of_match_table = xilinx_dmabench_of_ids,
+	},
+	.probe = xilinx_dmabench_probe,
+	.remove = xilinx_dmabench_remove,
+};
+
+static int __init dmabench_init(void)
+{
+	int err;
+
+	if (!queue_depth || !threads_per_chan || !min_size ||
+	    min_size > max_size)
+		return -EINVAL;
+
+	err = platform_driver_register(&xilinx_dmabench_driver);
+	if (err)
+		return err;
+
+	if (!max_channels)
+		return 0;
+
+	dmabench_memcpy_task = kthread_run(dmabench_memcpy_func, NULL,
+					   "dmabench-memcpy");
+	if (IS_ERR(dmabench_memcpy_task)) {
+		platform_driver_unregister(&xilinx_dmabench_driver);
+		return PTR_ERR(dmabench_memcpy_task);
+	}
+
+	return 0;
+}
+late_initcall(dmabench_init);
+
+static void __exit dmabench_exit(void)
+{
+	if (!IS_ERR_OR_NULL(dmabench_memcpy_task))
+		kthread_stop(dmabench_memcpy_task);
+	platform_driver_unregister(&xilinx_dmabench_driver);
+}
+module_exit(dmabench_exit)
+
+MODULE_AUTHOR("Xilinx, Inc.");
+MODULE_DESCRIPTION("Xilinx DMA Engine Benchmark");
+MODULE_LICENSE("GPL v2");
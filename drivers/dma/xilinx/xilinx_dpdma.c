@@ -21,6 +21,8 @@
 #include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/device.h>
+#include <linux/dma-fence.h>
+#include <linux/dma/xilinx_dpdma.h>
 #include <linux/dmaengine.h>
 #include <linux/dmapool.h>
 #include <linux/gfp.h>
@@ -38,6 +40,7 @@
 #include <linux/wait.h>
 
 #include "../dmaengine.h"
+#include "xilinx_dma_trace.h"
 
 /* DPDMA registers */
 #define XILINX_DPDMA_ERR_CTRL				0x0
@@ -218,6 +221,8 @@ enum xilinx_dpdma_tx_desc_status {
  * @node: list node for transaction descriptors
  * @status: tx descriptor status
  * @done_cnt: number of complete notification to deliver
+ * @fence: fence signalled when the DPDMA has fetched the transaction once
+ * @submit_time: submit time, cleared once accounted in the latency histogram
  */
 struct xilinx_dpdma_tx_desc {
 	struct dma_async_tx_descriptor async_tx;
@@ -225,6 +230,8 @@ struct xilinx_dpdma_tx_desc {
 	struct list_head node;
 	enum xilinx_dpdma_tx_desc_status status;
 	unsigned int done_cnt;
+	struct dma_fence *fence;
+	ktime_t submit_time;
 };
 
 /**
@@ -289,6 +296,10 @@ enum xilinx_dpdma_chan_status {
  * @pending_desc: pending descriptor to be scheduled in next period
  * @active_desc: descriptor that the DPDMA channel is active on
  * @done_list: done descriptor list
+ * @fence_lock: lock protecting the descriptor fences
+ * @fence_context: fence context of the channel
+ * @fence_seqno: sequence number of the last submitted descriptor fence
+ * @lat_hist: submit to first callback latency histogram
  * @xdev: DPDMA device
  */
 struct xilinx_dpdma_chan {
@@ -312,6 +323,12 @@ struct xilinx_dpdma_chan {
 	struct xilinx_dpdma_tx_desc *active_desc;
 	struct list_head done_list;
 
+	spinlock_t fence_lock; /* lock to access the descriptor fences */
+	u64 fence_context;
+	unsigned int fence_seqno;
+
+	struct xilinx_dma_lat_hist lat_hist;
+
 	struct xilinx_dpdma_device *xdev;
 };
 
@@ -784,6 +801,22 @@ static void xilinx_dpdma_chan_dump_tx_desc(struct xilinx_dpdma_chan *chan,
 	dev_dbg(dev, "------- TX descriptor dump end -------\n");
 }
 
+static const char *xilinx_dpdma_fence_get_driver_name(struct dma_fence *fence)
+{
+	return "xilinx-dpdma";
+}
+
+static const char *
+xilinx_dpdma_fence_get_timeline_name(struct dma_fence *fence)
+{
+	return "dpdma-chan";
+}
+
+static const struct dma_fence_ops xilinx_dpdma_fence_ops = {
+	.get_driver_name = xilinx_dpdma_fence_get_driver_name,
+	.get_timeline_name = xilinx_dpdma_fence_get_timeline_name,
+};
+
 /**
  * xilinx_dpdma_chan_alloc_tx_desc - Allocate a transaction descriptor
  * @chan: DPDMA channel
@@ -801,6 +834,16 @@ xilinx_dpdma_chan_alloc_tx_desc(struct xilinx_dpdma_chan *chan)
 	if (!tx_desc)
 		return NULL;
 
+	tx_desc->fence = kzalloc(sizeof(*tx_desc->fence), GFP_ATOMIC);
+	if (!tx_desc->fence) {
+		kfree(tx_desc);
+		return NULL;
+	}
+
+	/* The seqno is assigned again when the descriptor is submitted */
+	dma_fence_init(tx_desc->fence, &xilinx_dpdma_fence_ops,
+		       &chan->fence_lock, chan->fence_context, 0);
+
 	INIT_LIST_HEAD(&tx_desc->descriptors);
 	tx_desc->status = PREPARED;
 
@@ -812,7 +855,8 @@ xilinx_dpdma_chan_alloc_tx_desc(struct xilinx_dpdma_chan *chan)
  * @chan: DPDMA channel
  * @tx_desc: tx descriptor
  *
- * Free the tx descriptor @tx_desc including its software descriptors.
+ * Free the tx descriptor @tx_desc including its software descriptors. A fence
+ * that hasn't been signalled yet is signalled with -ECANCELED.
  */
 static void
 xilinx_dpdma_chan_free_tx_desc(struct xilinx_dpdma_chan *chan,
@@ -828,6 +872,12 @@ xilinx_dpdma_chan_free_tx_desc(struct xilinx_dpdma_chan *chan,
 		xilinx_dpdma_chan_free_sw_desc(chan, sw_desc);
 	}
 
+	if (!dma_fence_is_signaled(tx_desc->fence)) {
+		dma_fence_set_error(tx_desc->fence, -ECANCELED);
+		dma_fence_signal(tx_desc->fence);
+	}
+	dma_fence_put(tx_desc->fence);
+
 	kfree(tx_desc);
 }
 
@@ -856,6 +906,9 @@ xilinx_dpdma_chan_submit_tx_desc(struct xilinx_dpdma_chan *chan,
 	}
 
 	cookie = dma_cookie_assign(&tx_desc->async_tx);
+	tx_desc->submit_time = xilinx_dma_lat_stamp();
+	trace_xilinx_dma_submit(&chan->common, cookie);
+	tx_desc->fence->seqno = ++chan->fence_seqno;
 
 	/* Assign the cookie to descriptors in this transaction */
 	/* Only 16 bit will be used, but it should be enough */
@@ -928,6 +981,24 @@ static void xilinx_dpdma_chan_free_all_desc(struct xilinx_dpdma_chan *chan)
 	spin_unlock_irqrestore(&chan->lock, flags);
 }
 
+/**
+ * xilinx_dpdma_chan_trace_callback - Account the callbacks of a descriptor
+ * @chan: DPDMA channel
+ * @desc: tx descriptor whose callbacks are about to run
+ *
+ * A descriptor is called back once per frame it's fetched for. Only the
+ * first one is accounted in the latency histogram.
+ */
+static void xilinx_dpdma_chan_trace_callback(struct xilinx_dpdma_chan *chan,
+					     struct xilinx_dpdma_tx_desc *desc)
+{
+	trace_xilinx_dma_callback(&chan->common, desc->async_tx.cookie);
+	if (desc->submit_time) {
+		xilinx_dma_lat_hist_add(&chan->lat_hist, desc->submit_time);
+		desc->submit_time = 0;
+	}
+}
+
 /**
  * xilinx_dpdma_chan_cleanup_desc - Clean up descriptors
  * @chan: DPDMA channel
@@ -954,7 +1025,8 @@ static void xilinx_dpdma_chan_cleanup_desc(struct xilinx_dpdma_chan *chan)
 		desc->done_cnt = 0;
 		callback = desc->async_tx.callback;
 		callback_param = desc->async_tx.callback_param;
-		if (callback) {
+		if (callback && cnt) {
+			xilinx_dpdma_chan_trace_callback(chan, desc);
 			spin_unlock_irqrestore(&chan->lock, flags);
 			for (i = 0; i < cnt; i++)
 				callback(callback_param);
@@ -969,7 +1041,8 @@ static void xilinx_dpdma_chan_cleanup_desc(struct xilinx_dpdma_chan *chan)
 		chan->active_desc->done_cnt = 0;
 		callback = chan->active_desc->async_tx.callback;
 		callback_param = chan->active_desc->async_tx.callback_param;
-		if (callback) {
+		if (callback && cnt) {
+			xilinx_dpdma_chan_trace_callback(chan, chan->active_desc);
 			spin_unlock_irqrestore(&chan->lock, flags);
 			for (i = 0; i < cnt; i++)
 				callback(callback_param);
@@ -1012,10 +1085,12 @@ static void xilinx_dpdma_chan_desc_active(struct xilinx_dpdma_chan *chan)
  *
  * Mark the current active descriptor @chan->active_desc as 'done'. This
  * function should be called to mark completion of the currently active
- * descriptor.
+ * descriptor. The fence of the descriptor is signalled on its first
+ * completion, which is when the previous buffer is no longer fetched.
  */
 static void xilinx_dpdma_chan_desc_done_intr(struct xilinx_dpdma_chan *chan)
 {
+	struct dma_fence *fence = NULL;
 	unsigned long flags;
 
 	spin_lock_irqsave(&chan->lock, flags);
@@ -1029,12 +1104,23 @@ static void xilinx_dpdma_chan_desc_done_intr(struct xilinx_dpdma_chan *chan)
 
 	chan->active_desc->done_cnt++;
 	if (chan->active_desc->status ==  PREPARED) {
+		trace_xilinx_dma_complete(&chan->common,
+					  chan->active_desc->async_tx.cookie);
 		dma_cookie_complete(&chan->active_desc->async_tx);
 		chan->active_desc->status = ACTIVE;
 	}
 
+	if (!dma_fence_is_signaled(chan->active_desc->fence))
+		fence = dma_fence_get(chan->active_desc->fence);
+
 out_unlock:
 	spin_unlock_irqrestore(&chan->lock, flags);
+
+	if (fence) {
+		dma_fence_signal(fence);
+		dma_fence_put(fence);
+	}
+
 	tasklet_schedule(&chan->done_task);
 }
 
@@ -1373,6 +1459,9 @@ static void xilinx_dpdma_chan_issue_pending(struct xilinx_dpdma_chan *chan)
 	chan->pending_desc = chan->submitted_desc;
 	chan->submitted_desc = NULL;
 
+	trace_xilinx_dma_start(&chan->common,
+			       chan->pending_desc->async_tx.cookie);
+
 	sw_desc = list_first_entry(&chan->pending_desc->descriptors,
 				   struct xilinx_dpdma_sw_desc, node);
 	dpdma_write(chan->reg, XILINX_DPDMA_CH_DESC_START_ADDR,
@@ -1773,6 +1862,27 @@ static dma_cookie_t xilinx_dpdma_tx_submit(struct dma_async_tx_descriptor *tx)
 	return xilinx_dpdma_chan_submit_tx_desc(chan, tx_desc);
 }
 
+/**
+ * xilinx_dpdma_get_fence - Get the completion fence of a transaction
+ * @tx: DMA async tx descriptor prepared on a DPDMA channel
+ *
+ * The fence is signalled once the DPDMA has fetched the transaction for the
+ * first time, i.e. when the buffer of the previous transaction is released.
+ * It is signalled with -ECANCELED if the transaction is terminated before.
+ * The caller owns the returned reference and drops it with dma_fence_put().
+ *
+ * Return: a fence reference, or ERR_PTR(-EINVAL) if @tx is not a DPDMA
+ * transaction.
+ */
+struct dma_fence *xilinx_dpdma_get_fence(struct dma_async_tx_descriptor *tx)
+{
+	if (!tx || tx->tx_submit != xilinx_dpdma_tx_submit)
+		return ERR_PTR(-EINVAL);
+
+	return dma_fence_get(to_dpdma_tx_desc(tx)->fence);
+}
+EXPORT_SYMBOL_GPL(xilinx_dpdma_get_fence);
+
 /* DMA channel operations */
 
 static struct dma_async_tx_descriptor *
@@ -2053,6 +2163,7 @@ static void xilinx_dpdma_chan_done_task(unsigned long data)
 {
 	struct xilinx_dpdma_chan *chan = (struct xilinx_dpdma_chan *)data;
 
+	trace_xilinx_dma_cleanup(&chan->common);
 	xilinx_dpdma_chan_cleanup_desc(chan);
 }
 
@@ -2076,8 +2187,10 @@ static irqreturn_t xilinx_dpdma_irq_handler(int irq, void *data)
 	masked = (status & XILINX_DPDMA_INTR_DESC_DONE_MASK) >>
 		 XILINX_DPDMA_INTR_DESC_DONE_SHIFT;
 	if (masked)
-		for_each_set_bit(i, &masked, XILINX_DPDMA_NUM_CHAN)
+		for_each_set_bit(i, &masked, XILINX_DPDMA_NUM_CHAN) {
+			trace_xilinx_dma_irq(&xdev->chan[i]->common, status);
 			xilinx_dpdma_chan_desc_done_intr(xdev->chan[i]);
+		}
 
 	masked = (status & XILINX_DPDMA_INTR_NO_OSTAND_MASK) >>
 		 XILINX_DPDMA_INTR_NO_OSTAND_SHIFT;
@@ -2129,6 +2242,9 @@ xilinx_dpdma_chan_probe(struct device_node *node,
 	INIT_LIST_HEAD(&chan->done_list);
 	init_waitqueue_head(&chan->wait_to_stop);
 
+	spin_lock_init(&chan->fence_lock);
+	chan->fence_context = dma_fence_context_alloc(1);
+
 	tasklet_init(&chan->done_task, xilinx_dpdma_chan_done_task,
 		     (unsigned long)chan);
 	tasklet_init(&chan->err_task, xilinx_dpdma_chan_err_task,
@@ -2145,6 +2261,7 @@ xilinx_dpdma_chan_probe(struct device_node *node,
 
 static void xilinx_dpdma_chan_remove(struct xilinx_dpdma_chan *chan)
 {
+	xilinx_dma_lat_hist_exit(&chan->lat_hist);
 	tasklet_kill(&chan->err_task);
 	tasklet_kill(&chan->done_task);
 	list_del(&chan->common.device_node);
@@ -2256,6 +2373,11 @@ static int xilinx_dpdma_probe(struct platform_device *pdev)
 		goto error_dma_async;
 	}
 
+	for (i = 0; i < XILINX_DPDMA_NUM_CHAN; i++)
+		if (xdev->chan[i])
+			xilinx_dma_lat_hist_init(&xdev->chan[i]->lat_hist,
+						 &xdev->chan[i]->common);
+
 	ret = of_dma_controller_register(xdev->dev->of_node,
 					 of_dma_xilinx_xlate, ddev);
 	if (ret) {
@@ -23,6 +23,7 @@
 #include <linux/bitops.h>
 #include <linux/clk.h>
 #include <linux/delay.h>
+#include <linux/dma-fence.h>
 #include <linux/dma/xilinx_frmbuf.h>
 #include <linux/dmapool.h>
 #include <linux/gpio/consumer.h>
@@ -41,6 +42,7 @@
 #include <drm/drm_fourcc.h>
 
 #include "../dmaengine.h"
+#include "xilinx_dma_trace.h"
 
 /* Register/Descriptor Offsets */
 #define XILINX_FRMBUF_CTRL_OFFSET		0x00
@@ -141,6 +143,8 @@ struct xilinx_frmbuf_desc_hw {
  * @node: Node in the channel descriptors list
  * @fid: Field ID of buffer
  * @earlycb: Whether the callback should be called when in staged state
+ * @fence: Fence signalled once the frame is done
+ * @submit_time: Submit time, for the latency histogram
  */
 struct xilinx_frmbuf_tx_descriptor {
 	struct dma_async_tx_descriptor async_tx;
@@ -148,6 +152,8 @@ struct xilinx_frmbuf_tx_descriptor {
 	struct list_head node;
 	u32 fid;
 	u32 earlycb;
+	struct dma_fence *fence;
+	ktime_t submit_time;
 };
 
 /**
@@ -169,6 +175,10 @@ struct xilinx_frmbuf_tx_descriptor {
  * @vid_fmt: Reference to currently assigned video format description
  * @hw_fid: FID enabled in hardware flag
  * @mode: Select operation mode
+ * @fence_lock: Lock of the frame fences
+ * @fence_context: Fence context of the channel
+ * @fence_seqno: Sequence number of the last submitted frame fence
+ * @lat_hist: Submit to callback latency histogram
  */
 struct xilinx_frmbuf_chan {
 	struct xilinx_frmbuf_device *xdev;
@@ -190,6 +200,11 @@ struct xilinx_frmbuf_chan {
 	const struct xilinx_frmbuf_format_desc *vid_fmt;
 	bool hw_fid;
 	enum operation_mode mode;
+	/* Frame fence lock */
+	spinlock_t fence_lock;
+	u64 fence_context;
+	u64 fence_seqno;
+	struct xilinx_dma_lat_hist lat_hist;
 };
 
 /**
@@ -469,6 +484,16 @@ static const struct xilinx_frmbuf_format_desc xilinx_frmbuf_formats[] = {
 	},
 };
 
+/*
+ * DRM format modifiers of the memory layouts the IP can access. The Video
+ * Framebuffer IP only accesses linear buffers, tiled or compressed layouts
+ * are to be added here for the IP versions supporting them.
+ */
+static const u64 xilinx_frmbuf_drm_modifiers[] = {
+	DRM_FORMAT_MOD_LINEAR,
+	DRM_FORMAT_MOD_INVALID,
+};
+
 /**
  * struct xilinx_frmbuf_feature - dt or IP property structure
  * @direction: dma transfer mode and direction
@@ -753,6 +778,22 @@ int xilinx_xdma_get_drm_vid_fmts(struct dma_chan *chan, u32 *fmt_cnt,
 }
 EXPORT_SYMBOL(xilinx_xdma_get_drm_vid_fmts);
 
+int xilinx_xdma_get_drm_vid_fmt_modifiers(struct dma_chan *chan,
+					  const u64 **modifiers)
+{
+	struct xilinx_frmbuf_device *xdev;
+
+	xdev = frmbuf_find_dev(chan);
+
+	if (IS_ERR(xdev))
+		return PTR_ERR(xdev);
+
+	*modifiers = xilinx_frmbuf_drm_modifiers;
+
+	return 0;
+}
+EXPORT_SYMBOL(xilinx_xdma_get_drm_vid_fmt_modifiers);
+
 int xilinx_xdma_get_v4l2_vid_fmts(struct dma_chan *chan, u32 *fmt_cnt,
 				  u32 **fmts)
 {
@@ -866,6 +907,28 @@ int xilinx_xdma_set_earlycb(struct dma_chan *chan,
 }
 EXPORT_SYMBOL(xilinx_xdma_set_earlycb);
 
+struct dma_fence *
+xilinx_xdma_get_fence(struct dma_chan *chan,
+		      struct dma_async_tx_descriptor *async_tx)
+{
+	struct xilinx_frmbuf_device *xdev;
+	struct xilinx_frmbuf_tx_descriptor *desc;
+
+	if (!async_tx)
+		return ERR_PTR(-EINVAL);
+
+	xdev = frmbuf_find_dev(chan);
+	if (IS_ERR(xdev))
+		return ERR_CAST(xdev);
+
+	desc = to_dma_tx_descriptor(async_tx);
+	if (!desc)
+		return ERR_PTR(-EINVAL);
+
+	return dma_fence_get(desc->fence);
+}
+EXPORT_SYMBOL(xilinx_xdma_get_fence);
+
 /**
  * of_dma_xilinx_xlate - Translation function
  * @dma_spec: Pointer to DMA specifier as found in the device tree
@@ -885,6 +948,22 @@ static struct dma_chan *of_dma_xilinx_xlate(struct of_phandle_args *dma_spec,
  * Descriptors alloc and free
  */
 
+static const char *xilinx_frmbuf_fence_get_driver_name(struct dma_fence *fence)
+{
+	return "xilinx-frmbuf";
+}
+
+static const char *
+xilinx_frmbuf_fence_get_timeline_name(struct dma_fence *fence)
+{
+	return "xilinx-frmbuf-frames";
+}
+
+static const struct dma_fence_ops xilinx_frmbuf_fence_ops = {
+	.get_driver_name = xilinx_frmbuf_fence_get_driver_name,
+	.get_timeline_name = xilinx_frmbuf_fence_get_timeline_name,
+};
+
 /**
  * xilinx_frmbuf_tx_descriptor - Allocate transaction descriptor
  * @chan: Driver specific dma channel
@@ -900,9 +979,41 @@ xilinx_frmbuf_alloc_tx_descriptor(struct xilinx_frmbuf_chan *chan)
 	if (!desc)
 		return NULL;
 
+	desc->fence = kzalloc(sizeof(*desc->fence), GFP_KERNEL);
+	if (!desc->fence) {
+		kfree(desc);
+		return NULL;
+	}
+
+	/* The sequence number is assigned in submission order */
+	dma_fence_init(desc->fence, &xilinx_frmbuf_fence_ops,
+		       &chan->fence_lock, chan->fence_context, 0);
+
 	return desc;
 }
 
+/**
+ * xilinx_frmbuf_free_tx_descriptor - Free transaction descriptor
+ * @desc: Transaction descriptor
+ *
+ * The fence of a frame that never completed is signalled with -ECANCELED,
+ * so no waiter is left behind. Must not be called with the channel lock
+ * held as the fence callbacks run from here.
+ */
+static void
+xilinx_frmbuf_free_tx_descriptor(struct xilinx_frmbuf_tx_descriptor *desc)
+{
+	if (!desc)
+		return;
+
+	if (!dma_fence_is_signaled(desc->fence)) {
+		dma_fence_set_error(desc->fence, -ECANCELED);
+		dma_fence_signal(desc->fence);
+	}
+	dma_fence_put(desc->fence);
+	kfree(desc);
+}
+
 /**
  * xilinx_frmbuf_free_desc_list - Free descriptors list
  * @chan: Driver specific dma channel
@@ -915,7 +1026,7 @@ static void xilinx_frmbuf_free_desc_list(struct xilinx_frmbuf_chan *chan,
 
 	list_for_each_entry_safe(desc, next, list, node) {
 		list_del(&desc->node);
-		kfree(desc);
+		xilinx_frmbuf_free_tx_descriptor(desc);
 	}
 }
 
@@ -925,21 +1036,26 @@ static void xilinx_frmbuf_free_desc_list(struct xilinx_frmbuf_chan *chan,
  */
 static void xilinx_frmbuf_free_descriptors(struct xilinx_frmbuf_chan *chan)
 {
+	struct xilinx_frmbuf_tx_descriptor *active, *staged;
 	unsigned long flags;
+	LIST_HEAD(list);
 
 	spin_lock_irqsave(&chan->lock, flags);
 
-	xilinx_frmbuf_free_desc_list(chan, &chan->pending_list);
-	xilinx_frmbuf_free_desc_list(chan, &chan->done_list);
-	kfree(chan->active_desc);
-	kfree(chan->staged_desc);
+	list_splice_tail_init(&chan->done_list, &list);
+	list_splice_tail_init(&chan->pending_list, &list);
+	active = chan->active_desc;
+	staged = chan->staged_desc;
 
 	chan->staged_desc = NULL;
 	chan->active_desc = NULL;
-	INIT_LIST_HEAD(&chan->pending_list);
-	INIT_LIST_HEAD(&chan->done_list);
 
 	spin_unlock_irqrestore(&chan->lock, flags);
+
+	/* Cancel the fences outside of the channel lock */
+	xilinx_frmbuf_free_tx_descriptor(active);
+	xilinx_frmbuf_free_tx_descriptor(staged);
+	xilinx_frmbuf_free_desc_list(chan, &list);
 }
 
 /**
@@ -953,6 +1069,18 @@ static void xilinx_frmbuf_free_chan_resources(struct dma_chan *dchan)
 	xilinx_frmbuf_free_descriptors(chan);
 }
 
+/**
+ * xilinx_frmbuf_trace_callback - Account a descriptor about to be called back
+ * @chan: Driver specific dma channel
+ * @desc: Descriptor whose callback is about to run
+ */
+static void xilinx_frmbuf_trace_callback(struct xilinx_frmbuf_chan *chan,
+					 struct xilinx_frmbuf_tx_descriptor *desc)
+{
+	trace_xilinx_dma_callback(&chan->common, desc->async_tx.cookie);
+	xilinx_dma_lat_hist_add(&chan->lat_hist, desc->submit_time);
+}
+
 /**
  * xilinx_frmbuf_chan_desc_cleanup - Clean channel descriptors
  * @chan: Driver specific dma channel
@@ -974,6 +1102,7 @@ static void xilinx_frmbuf_chan_desc_cleanup(struct xilinx_frmbuf_chan *chan)
 		callback = desc->async_tx.callback;
 		callback_param = desc->async_tx.callback_param;
 		if (callback) {
+			xilinx_frmbuf_trace_callback(chan, desc);
 			spin_unlock_irqrestore(&chan->lock, flags);
 			callback(callback_param);
 			spin_lock_irqsave(&chan->lock, flags);
@@ -981,7 +1110,9 @@ static void xilinx_frmbuf_chan_desc_cleanup(struct xilinx_frmbuf_chan *chan)
 
 		/* Run any dependencies, then free the descriptor */
 		dma_run_dependencies(&desc->async_tx);
-		kfree(desc);
+		spin_unlock_irqrestore(&chan->lock, flags);
+		xilinx_frmbuf_free_tx_descriptor(desc);
+		spin_lock_irqsave(&chan->lock, flags);
 	}
 
 	spin_unlock_irqrestore(&chan->lock, flags);
@@ -995,6 +1126,7 @@ static void xilinx_frmbuf_do_tasklet(unsigned long data)
 {
 	struct xilinx_frmbuf_chan *chan = (struct xilinx_frmbuf_chan *)data;
 
+	trace_xilinx_dma_cleanup(&chan->common);
 	xilinx_frmbuf_chan_desc_cleanup(chan);
 }
 
@@ -1056,8 +1188,12 @@ static void xilinx_frmbuf_start(struct xilinx_frmbuf_chan *chan)
  * @chan : xilinx frmbuf channel
  *
  * CONTEXT: hardirq
+ *
+ * Return: A reference to the fence of the frame, to be signalled once the
+ * channel lock is dropped
  */
-static void xilinx_frmbuf_complete_descriptor(struct xilinx_frmbuf_chan *chan)
+static struct dma_fence *
+xilinx_frmbuf_complete_descriptor(struct xilinx_frmbuf_chan *chan)
 {
 	struct xilinx_frmbuf_tx_descriptor *desc = chan->active_desc;
 
@@ -1069,8 +1205,11 @@ static void xilinx_frmbuf_complete_descriptor(struct xilinx_frmbuf_chan *chan)
 		desc->fid = frmbuf_read(chan, XILINX_FRMBUF_FID_OFFSET) &
 			    XILINX_FRMBUF_FID_MASK;
 
+	trace_xilinx_dma_complete(&chan->common, desc->async_tx.cookie);
 	dma_cookie_complete(&desc->async_tx);
 	list_add_tail(&desc->node, &chan->done_list);
+
+	return dma_fence_get(desc->fence);
 }
 
 /**
@@ -1103,6 +1242,7 @@ static void xilinx_frmbuf_start_transfer(struct xilinx_frmbuf_chan *chan)
 		callback = desc->async_tx.callback;
 		callback_param = desc->async_tx.callback_param;
 		if (callback) {
+			xilinx_frmbuf_trace_callback(chan, desc);
 			callback(callback_param);
 			desc->async_tx.callback = NULL;
 			chan->active_desc = desc;
@@ -1110,6 +1250,7 @@ static void xilinx_frmbuf_start_transfer(struct xilinx_frmbuf_chan *chan)
 	}
 
 	/* Start the transfer */
+	trace_xilinx_dma_start(&chan->common, desc->async_tx.cookie);
 	chan->write_addr(chan, XILINX_FRMBUF_ADDR_OFFSET,
 			 desc->hw.luma_plane_addr);
 	chan->write_addr(chan, XILINX_FRMBUF_ADDR2_OFFSET,
@@ -1187,11 +1328,14 @@ static irqreturn_t xilinx_frmbuf_irq_handler(int irq, void *data)
 	dma_async_tx_callback callback = NULL;
 	void *callback_param;
 	struct xilinx_frmbuf_tx_descriptor *desc;
+	struct dma_fence *fence = NULL;
 
 	status = frmbuf_read(chan, XILINX_FRMBUF_ISR_OFFSET);
 	if (!(status & XILINX_FRMBUF_ISR_ALL_IRQ_MASK))
 		return IRQ_NONE;
 
+	trace_xilinx_dma_irq(&chan->common, status);
+
 	frmbuf_write(chan, XILINX_FRMBUF_ISR_OFFSET,
 		     status & XILINX_FRMBUF_ISR_ALL_IRQ_MASK);
 
@@ -1201,6 +1345,7 @@ static irqreturn_t xilinx_frmbuf_irq_handler(int irq, void *data)
 		callback = desc->async_tx.callback;
 		callback_param = desc->async_tx.callback_param;
 		if (callback) {
+			xilinx_frmbuf_trace_callback(chan, desc);
 			callback(callback_param);
 			desc->async_tx.callback = NULL;
 		}
@@ -1209,12 +1354,23 @@ static irqreturn_t xilinx_frmbuf_irq_handler(int irq, void *data)
 	if (status & XILINX_FRMBUF_ISR_AP_DONE_IRQ) {
 		spin_lock(&chan->lock);
 		chan->idle = true;
-		if (chan->active_desc) {
-			xilinx_frmbuf_complete_descriptor(chan);
+		/*
+		 * Without a staged frame an auto restarting core runs the
+		 * active buffer once more, hold it until a new frame is staged
+		 * rather than handing out a buffer still being accessed.
+		 */
+		if (chan->active_desc &&
+		    (chan->mode != AUTO_RESTART || chan->staged_desc)) {
+			fence = xilinx_frmbuf_complete_descriptor(chan);
 			chan->active_desc = NULL;
 		}
 		xilinx_frmbuf_start_transfer(chan);
 		spin_unlock(&chan->lock);
+
+		if (fence) {
+			dma_fence_signal(fence);
+			dma_fence_put(fence);
+		}
 	}
 
 	tasklet_schedule(&chan->tasklet);
@@ -1236,6 +1392,9 @@ static dma_cookie_t xilinx_frmbuf_tx_submit(struct dma_async_tx_descriptor *tx)
 
 	spin_lock_irqsave(&chan->lock, flags);
 	cookie = dma_cookie_assign(tx);
+	desc->submit_time = xilinx_dma_lat_stamp();
+	trace_xilinx_dma_submit(tx->chan, cookie);
+	desc->fence->seqno = ++chan->fence_seqno;
 	list_add_tail(&desc->node, &chan->pending_list);
 	spin_unlock_irqrestore(&chan->lock, flags);
 
@@ -1393,6 +1552,8 @@ static void xilinx_frmbuf_chan_remove(struct xilinx_frmbuf_chan *chan)
 	frmbuf_clr(chan, XILINX_FRMBUF_IE_OFFSET,
 		   XILINX_FRMBUF_ISR_ALL_IRQ_MASK);
 
+	xilinx_dma_lat_hist_exit(&chan->lat_hist);
+
 	tasklet_kill(&chan->tasklet);
 	list_del(&chan->common.device_node);
 
@@ -1441,6 +1602,8 @@ static int xilinx_frmbuf_chan_probe(struct xilinx_frmbuf_device *xdev,
 		chan->hw_fid = of_property_read_bool(node, "xlnx,fid");
 
 	spin_lock_init(&chan->lock);
+	spin_lock_init(&chan->fence_lock);
+	chan->fence_context = dma_fence_context_alloc(1);
 	INIT_LIST_HEAD(&chan->pending_list);
 	INIT_LIST_HEAD(&chan->done_list);
 
@@ -1655,6 +1818,7 @@ static int xilinx_frmbuf_probe(struct platform_device *pdev)
 
 	/* Register the DMA engine with the core */
 	dma_async_device_register(&xdev->common);
+	xilinx_dma_lat_hist_init(&xdev->chan.lat_hist, &xdev->chan.common);
 
 	err = of_dma_controller_register(node, of_dma_xilinx_xlate, xdev);
 	if (err < 0) {
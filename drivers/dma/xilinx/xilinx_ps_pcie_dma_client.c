@@ -12,6 +12,7 @@
 #include <linux/dma-direction.h>
 #include <linux/dmaengine.h>
 #include <linux/dma-mapping.h>
+#include <linux/eventfd.h>
 #include <linux/kdev_t.h>
 #include <linux/kernel.h>
 #include <linux/module.h>
@@ -48,6 +49,8 @@
 
 #define IGET_ASYNC_TRANSFERINFO   _IO(XPS_PCIE_DMA_CLIENT_MAGIC, 0x01)
 #define ISET_ASYNC_TRANSFERINFO   _IO(XPS_PCIE_DMA_CLIENT_MAGIC, 0x02)
+/* Argument is an eventfd signalled per async completion, negative to clear */
+#define ISET_ASYNC_EVENTFD        _IO(XPS_PCIE_DMA_CLIENT_MAGIC, 0x03)
 
 #define DMA_TRANSACTION_SUCCESSFUL 1
 #define DMA_TRANSACTION_FAILURE    0
@@ -103,6 +106,7 @@ struct xlnx_ps_pcie_dma_client_channel {
 	enum dma_data_direction direction;
 	enum dma_transfer_mode mode;
 	struct xlnx_completed_info completed;
+	struct eventfd_ctx *completion_efd;
 	spinlock_t channel_lock; /* Lock to serialize transfers on channel */
 };
 
@@ -464,11 +468,36 @@ static int ps_pcie_dma_open(struct inode *in, struct file *file)
 	return 0;
 }
 
-static int ps_pcie_dma_release(struct inode *in, struct file *filp)
+static int set_completion_eventfd(struct xlnx_ps_pcie_dma_client_channel *chan,
+				  int fd)
 {
+	struct eventfd_ctx *efd = NULL;
+	struct eventfd_ctx *old;
+
+	if (fd >= 0) {
+		efd = eventfd_ctx_fdget(fd);
+		if (IS_ERR(efd))
+			return PTR_ERR(efd);
+	}
+
+	spin_lock(&chan->channel_lock);
+	old = chan->completion_efd;
+	chan->completion_efd = efd;
+	spin_unlock(&chan->channel_lock);
+
+	if (old)
+		eventfd_ctx_put(old);
+
 	return 0;
 }
 
+static int ps_pcie_dma_release(struct inode *in, struct file *filp)
+{
+	struct xlnx_ps_pcie_dma_client_channel *chan = filp->private_data;
+
+	return set_completion_eventfd(chan, -1);
+}
+
 static int update_completed_info(struct xlnx_ps_pcie_dma_client_channel *chan,
 				 struct usrbuff_info *usr_buff)
 {
@@ -523,7 +552,8 @@ static int update_completed_info(struct xlnx_ps_pcie_dma_client_channel *chan,
 /**
  * ps_pcie_dma_async_transfer_cbk - Callback handler for Asynchronous transfers.
  * Handles both S2C and C2S transfer call backs. Stores transaction information
- * in a list for a user application to poll for this information
+ * in a list for a user application to poll for this information, and signals
+ * the completion eventfd of the channel if one is set
  *
  * @data: Callback parameter
  *
@@ -551,11 +581,13 @@ static void ps_pcie_dma_async_transfer_cbk(void *data)
 	if (status == DMA_COMPLETE)
 		trans->buffer_info->buffer.status = DMA_TRANSACTION_SUCCESSFUL;
 	else
-		trans->buffer_info->buffer.status = DMA_TRANSACTION_SUCCESSFUL;
+		trans->buffer_info->buffer.status = DMA_TRANSACTION_FAILURE;
 
 	spin_lock(&trans->chan->channel_lock);
 	list_add_tail(&trans->buffer_info->clist,
 		      &trans->chan->completed.clist);
+	if (trans->chan->completion_efd)
+		eventfd_signal(trans->chan->completion_efd, 1);
 	spin_unlock(&trans->chan->channel_lock);
 	devm_kfree(trans->chan->dev, trans);
 }
@@ -818,6 +850,9 @@ static long ps_pcie_dma_ioctl(struct file *filp, unsigned int cmd,
 		retval = update_completed_info(chan,
 					       (struct usrbuff_info *)arg);
 		break;
+	case ISET_ASYNC_EVENTFD:
+		retval = set_completion_eventfd(chan, (int)arg);
+		break;
 	default:
 		pr_err("Unsupported ioctl command received\n");
 		retval = -1;
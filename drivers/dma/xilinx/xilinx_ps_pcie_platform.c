@@ -30,6 +30,12 @@
 
 #define MAX_COALESCE_COUNT     255
 
+/*
+ * Packets completed in one cleanup pass at or above which the channel keeps
+ * its interrupt masked and polls the status queues again.
+ */
+#define PS_PCIE_POLL_BUDGET    64
+
 #define DMA_CHANNEL_REGS_SIZE 0x80
 
 #define DMA_SRCQPTRLO_REG_OFFSET  (0x00) /* Source Q pointer Lo */
@@ -268,6 +274,9 @@ enum dev_channel_properties {
  * @coalesce_count: Indicates number of packet transfers before interrupts
  * @poll_timer_freq:Indicates frequency of polling for completed transactions
  * @poll_timer: Timer to poll dma buffer descriptors if coalesce count is > 0
+ * @polling: Channel interrupt is masked and completions are polled
+ * @src_completed: Packets completed by the last Src Q cleanup pass
+ * @dst_completed: Packets completed by the last Dst Q cleanup pass
  * @src_avail_descriptors: Available sgl source descriptors
  * @src_desc_lock: Lock for synchronizing src_avail_descriptors
  * @dst_avail_descriptors: Available sgl destination descriptors
@@ -357,6 +366,10 @@ struct ps_pcie_dma_chan {
 
 	struct timer_list poll_timer;
 
+	bool polling;
+	u32 src_completed;
+	u32 dst_completed;
+
 	u32 src_avail_descriptors;
 	spinlock_t src_desc_lock; /* For handling srcq available descriptors */
 
@@ -1031,12 +1044,46 @@ static void poll_completed_transactions(struct timer_list *t)
 {
 	struct ps_pcie_dma_chan *chan = from_timer(chan, t, poll_timer);
 
+	/* The primary work re-arms the timer while transfers are in flight */
 	if (chan->state == CHANNEL_AVAILABLE) {
 		queue_work(chan->primary_desc_cleanup,
 			   &chan->handle_primary_desc_cleanup);
 	}
+}
 
-	mod_timer(&chan->poll_timer, jiffies + chan->poll_timer_freq);
+/**
+ * ps_pcie_chan_is_busy - Checks if transfers are in flight on the channel
+ *
+ * @chan: Pointer to the PS PCIe DMA channel structure
+ *
+ * Return: true if some buffer descriptors are still owned by hardware
+ */
+static bool ps_pcie_chan_is_busy(struct ps_pcie_dma_chan *chan)
+{
+	if (chan->psrc_sgl_bd &&
+	    chan->src_avail_descriptors != chan->total_descriptors)
+		return true;
+
+	if (chan->pdst_sgl_bd &&
+	    chan->dst_avail_descriptors != chan->total_descriptors)
+		return true;
+
+	return false;
+}
+
+/**
+ * ps_pcie_chan_arm_poll_timer - Arms the poll timer if it is needed
+ *
+ * @chan: Pointer to the PS PCIe DMA channel structure
+ *
+ * The poll timer only catches the completions that do not reach the
+ * coalesce count, so it is not armed while the channel is idle.
+ */
+static void ps_pcie_chan_arm_poll_timer(struct ps_pcie_dma_chan *chan)
+{
+	if (chan->coalesce_count > 0 && chan->poll_timer.function &&
+	    ps_pcie_chan_is_busy(chan))
+		mod_timer(&chan->poll_timer, jiffies + chan->poll_timer_freq);
 }
 
 static bool check_descriptors_for_two_queues(struct ps_pcie_dma_chan *chan,
@@ -1249,6 +1296,9 @@ static void ps_pcie_chan_program_work(struct work_struct *work)
 		if (seg->dst_elements)
 			xlnx_ps_pcie_update_dstq(chan, seg);
 	}
+
+	if (!timer_pending(&chan->poll_timer))
+		ps_pcie_chan_arm_poll_timer(chan);
 }
 
 /**
@@ -1375,6 +1425,7 @@ static void dst_cleanup_work(struct work_struct *work)
 			mempool_free(ppkt_ctx->seg, chan->transactions_pool);
 		}
 		memset(ppkt_ctx, 0, sizeof(struct PACKET_TRANSFER_PARAMS));
+		chan->dst_completed++;
 	}
 
 	complete(&chan->dstq_work_complete);
@@ -1501,6 +1552,7 @@ static void src_cleanup_work(struct work_struct *work)
 			mempool_free(ppkt_ctx->seg, chan->transactions_pool);
 		}
 		memset(ppkt_ctx, 0, sizeof(struct PACKET_TRANSFER_PARAMS));
+		chan->src_completed++;
 	}
 
 	complete(&chan->srcq_work_complete);
@@ -1512,6 +1564,10 @@ static void src_cleanup_work(struct work_struct *work)
  * and re enables interrupts. Same work is invoked by timer if coalesce count
  * is greater than zero and interrupts are not invoked before the timeout period
  *
+ * Under high load, when a pass completes at least PS_PCIE_POLL_BUDGET
+ * packets, interrupts stay masked and the work requeues itself to poll the
+ * status queues again. Interrupts are re enabled once the load drops.
+ *
  * @work: Work associated with the task
  *
  * Return: void
@@ -1524,8 +1580,12 @@ static void ps_pcie_chan_primary_work(struct work_struct *work)
 				handle_primary_desc_cleanup);
 
 	/* Disable interrupts for Channel */
-	ps_pcie_dma_clr_mask(chan, chan->intr_control_offset,
-			     DMA_INTCNTRL_ENABLINTR_BIT);
+	if (!chan->polling)
+		ps_pcie_dma_clr_mask(chan, chan->intr_control_offset,
+				     DMA_INTCNTRL_ENABLINTR_BIT);
+
+	chan->src_completed = 0;
+	chan->dst_completed = 0;
 
 	if (chan->psrc_sgl_bd) {
 		reinit_completion(&chan->srcq_work_complete);
@@ -1545,17 +1605,25 @@ static void ps_pcie_chan_primary_work(struct work_struct *work)
 	if (chan->pdst_sgl_bd)
 		wait_for_completion_interruptible(&chan->dstq_work_complete);
 
+	chan->polling = chan->state == CHANNEL_AVAILABLE &&
+			chan->src_completed + chan->dst_completed >=
+			PS_PCIE_POLL_BUDGET;
+
 	/* Enable interrupts for channel */
-	ps_pcie_dma_set_mask(chan, chan->intr_control_offset,
-			     DMA_INTCNTRL_ENABLINTR_BIT);
+	if (!chan->polling)
+		ps_pcie_dma_set_mask(chan, chan->intr_control_offset,
+				     DMA_INTCNTRL_ENABLINTR_BIT);
 
 	if (chan->chan_programming) {
 		queue_work(chan->chan_programming,
 			   &chan->handle_chan_programming);
 	}
 
-	if (chan->coalesce_count > 0 && chan->poll_timer.function)
-		mod_timer(&chan->poll_timer, jiffies + chan->poll_timer_freq);
+	if (chan->polling)
+		queue_work(chan->primary_desc_cleanup,
+			   &chan->handle_primary_desc_cleanup);
+	else
+		ps_pcie_chan_arm_poll_timer(chan);
 }
 
 static int read_rootdma_config(struct platform_device *platform_dev,
@@ -1971,6 +2039,7 @@ static int xlnx_ps_pcie_channel_activate(struct ps_pcie_dma_chan *chan)
 
 	spin_lock(&chan->channel_lock);
 	chan->state = CHANNEL_AVAILABLE;
+	chan->polling = false;
 	spin_unlock(&chan->channel_lock);
 
 	/* Activate timer if required */
@@ -1987,7 +2056,7 @@ static void xlnx_ps_pcie_channel_quiesce(struct ps_pcie_dma_chan *chan)
 			     DMA_INTCNTRL_ENABLINTR_BIT);
 
 	/* Delete timer if it is created */
-	if (chan->coalesce_count > 0 && !chan->poll_timer.function)
+	if (chan->coalesce_count > 0 && chan->poll_timer.function)
 		xlnx_ps_pcie_free_poll_timer(chan);
 
 	/* Flush descriptor cleaning work queues */
@@ -2177,9 +2246,6 @@ static void xlnx_ps_pcie_free_poll_timer(struct ps_pcie_dma_chan *chan)
 static int xlnx_ps_pcie_alloc_poll_timer(struct ps_pcie_dma_chan *chan)
 {
 	timer_setup(&chan->poll_timer, poll_completed_transactions, 0);
-	chan->poll_timer.expires = jiffies + chan->poll_timer_freq;
-
-	add_timer(&chan->poll_timer);
 
 	return 0;
 }
@@ -11,17 +11,20 @@
 #include <linux/init.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
+#include <linux/kthread.h>
 #include <linux/module.h>
 #include <linux/of_address.h>
 #include <linux/of_dma.h>
 #include <linux/of_irq.h>
 #include <linux/of_platform.h>
+#include <linux/sched/isolation.h>
 #include <linux/slab.h>
 #include <linux/clk.h>
 #include <linux/io-64-nonatomic-lo-hi.h>
 #include <linux/pm_runtime.h>
 
 #include "../dmaengine.h"
+#include "xilinx_dma_trace.h"
 
 /* Register Offsets */
 #define ZYNQMP_DMA_ISR			0x100
@@ -40,6 +43,10 @@
 #define ZYNQMP_DMA_DST_DSCR_WRD1	0x13C
 #define ZYNQMP_DMA_DST_DSCR_WRD2	0x140
 #define ZYNQMP_DMA_DST_DSCR_WRD3	0x144
+#define ZYNQMP_DMA_WR_ONLY_WORD0	0x148
+#define ZYNQMP_DMA_WR_ONLY_WORD1	0x14C
+#define ZYNQMP_DMA_WR_ONLY_WORD2	0x150
+#define ZYNQMP_DMA_WR_ONLY_WORD3	0x154
 #define ZYNQMP_DMA_SRC_START_LSB	0x158
 #define ZYNQMP_DMA_SRC_START_MSB	0x15C
 #define ZYNQMP_DMA_DST_START_LSB	0x160
@@ -65,6 +72,8 @@
 /* Control 0 register bit field definitions */
 #define ZYNQMP_DMA_OVR_FETCH		BIT(7)
 #define ZYNQMP_DMA_POINT_TYPE_SG	BIT(6)
+#define ZYNQMP_DMA_MODE			GENMASK(5, 4)
+#define ZYNQMP_DMA_MODE_WR_ONLY		BIT(4)
 #define ZYNQMP_DMA_RATE_CTRL_EN		BIT(3)
 
 /* Control 1 register bit field definitions */
@@ -173,6 +182,9 @@ struct zynqmp_dma_desc_ll {
  * @src_p: Physical address of the src descriptor
  * @dst_v: Virtual address of the dst descriptor
  * @dst_p: Physical address of the dst descriptor
+ * @wr_only: Write only transfer, filling the destination with @pattern
+ * @pattern: Fill pattern of a write only transfer
+ * @submit_time: Submit time, for the latency histogram
  */
 struct zynqmp_dma_desc_sw {
 	u64 src;
@@ -185,6 +197,9 @@ struct zynqmp_dma_desc_sw {
 	dma_addr_t src_p;
 	struct zynqmp_dma_desc_ll *dst_v;
 	dma_addr_t dst_p;
+	bool wr_only;
+	u32 pattern;
+	ktime_t submit_time;
 };
 
 /**
@@ -205,12 +220,17 @@ struct zynqmp_dma_desc_sw {
  * @irq: Channel IRQ
  * @is_dmacoherent: Tells whether dma operations are coherent or not
  * @tasklet: Cleanup work after irq
+ * @cleanup_worker: Thread running the cleanup instead of @tasklet, if any
+ * @cleanup_work: Cleanup work queued on @cleanup_worker
  * @idle : Channel status;
  * @desc_size: Size of the low level descriptor
  * @err: Channel has errors
  * @bus_width: Bus width
  * @src_burst_len: Source burst length
  * @dst_burst_len: Dest burst length
+ * @lat_hist: Submit to callback latency histogram
+ * @pm_busy: The queue holds a runtime PM reference
+ * @powered: The clocks are on, the registers can be accessed
  */
 struct zynqmp_dma_chan {
 	struct zynqmp_dma_device *zdev;
@@ -229,12 +249,17 @@ struct zynqmp_dma_chan {
 	int irq;
 	bool is_dmacoherent;
 	struct tasklet_struct tasklet;
+	struct kthread_worker *cleanup_worker;
+	struct kthread_work cleanup_work;
 	bool idle;
 	u32 desc_size;
 	bool err;
 	u32 bus_width;
 	u32 src_burst_len;
 	u32 dst_burst_len;
+	struct xilinx_dma_lat_hist lat_hist;
+	bool pm_busy;
+	bool powered;
 };
 
 /**
@@ -244,6 +269,9 @@ struct zynqmp_dma_chan {
  * @chan: Driver specific DMA channel
  * @clk_main: Pointer to main clock
  * @clk_apb: Pointer to apb clock
+ * @busy_periods: Number of times the queue of the channel became active
+ * @resumes: Number of runtime resumes
+ * @suspends: Number of runtime suspends
  */
 struct zynqmp_dma_device {
 	struct device *dev;
@@ -251,6 +279,9 @@ struct zynqmp_dma_device {
 	struct zynqmp_dma_chan *chan;
 	struct clk *clk_main;
 	struct clk *clk_apb;
+	unsigned long busy_periods;
+	unsigned long resumes;
+	unsigned long suspends;
 };
 
 static inline void zynqmp_dma_writeq(struct zynqmp_dma_chan *chan, u32 reg,
@@ -360,6 +391,25 @@ static void zynqmp_dma_init(struct zynqmp_dma_chan *chan)
 	chan->idle = true;
 }
 
+/**
+ * zynqmp_dma_desc_chainable - Check if two transactions can run in one chain
+ * @desc: Transaction descriptor queued first
+ * @next: Transaction descriptor queued after @desc
+ *
+ * The write only mode and its pattern are channel settings, so a chain
+ * only holds transactions agreeing on them.
+ *
+ * Return: true if @next can be linked after @desc
+ */
+static bool zynqmp_dma_desc_chainable(struct zynqmp_dma_desc_sw *desc,
+				      struct zynqmp_dma_desc_sw *next)
+{
+	if (desc->wr_only != next->wr_only)
+		return false;
+
+	return !desc->wr_only || desc->pattern == next->pattern;
+}
+
 /**
  * zynqmp_dma_tx_submit - Submit DMA transaction
  * @tx: Async transaction descriptor pointer
@@ -376,10 +426,13 @@ static dma_cookie_t zynqmp_dma_tx_submit(struct dma_async_tx_descriptor *tx)
 	new = tx_to_desc(tx);
 	spin_lock_irqsave(&chan->lock, irqflags);
 	cookie = dma_cookie_assign(tx);
+	new->submit_time = xilinx_dma_lat_stamp();
+	trace_xilinx_dma_submit(tx->chan, cookie);
 
-	if (!list_empty(&chan->pending_list)) {
-		desc = list_last_entry(&chan->pending_list,
-				     struct zynqmp_dma_desc_sw, node);
+	desc = list_last_entry(&chan->pending_list,
+			       struct zynqmp_dma_desc_sw, node);
+	if (!list_empty(&chan->pending_list) &&
+	    zynqmp_dma_desc_chainable(desc, new)) {
 		if (!list_empty(&desc->tx_list))
 			desc = list_last_entry(&desc->tx_list,
 					       struct zynqmp_dma_desc_sw, node);
@@ -414,6 +467,8 @@ zynqmp_dma_get_descriptor(struct zynqmp_dma_chan *chan)
 	spin_unlock_irqrestore(&chan->lock, irqflags);
 
 	INIT_LIST_HEAD(&desc->tx_list);
+	desc->wr_only = false;
+	desc->pattern = 0;
 	/* Clear the src and dst descriptor memory */
 	memset((void *)desc->src_v, 0, ZYNQMP_DMA_DESC_SIZE(chan));
 	memset((void *)desc->dst_v, 0, ZYNQMP_DMA_DESC_SIZE(chan));
@@ -464,11 +519,7 @@ static int zynqmp_dma_alloc_chan_resources(struct dma_chan *dchan)
 {
 	struct zynqmp_dma_chan *chan = to_chan(dchan);
 	struct zynqmp_dma_desc_sw *desc;
-	int i, ret;
-
-	ret = pm_runtime_get_sync(chan->dev);
-	if (ret < 0)
-		return ret;
+	int i;
 
 	chan->sw_desc_pool = kcalloc(ZYNQMP_DMA_NUM_DESCS, sizeof(*desc),
 				     GFP_KERNEL);
@@ -533,12 +584,21 @@ static void zynqmp_dma_handle_ovfl_int(struct zynqmp_dma_chan *chan, u32 status)
 		readl(chan->regs + ZYNQMP_DMA_IRQ_SRC_ACCT);
 }
 
-static void zynqmp_dma_config(struct zynqmp_dma_chan *chan)
+static void zynqmp_dma_config(struct zynqmp_dma_chan *chan,
+			      struct zynqmp_dma_desc_sw *desc)
 {
 	u32 val;
 
 	val = readl(chan->regs + ZYNQMP_DMA_CTRL0);
 	val |= ZYNQMP_DMA_POINT_TYPE_SG;
+	val &= ~ZYNQMP_DMA_MODE;
+	if (desc->wr_only) {
+		val |= ZYNQMP_DMA_MODE_WR_ONLY;
+		writel(desc->pattern, chan->regs + ZYNQMP_DMA_WR_ONLY_WORD0);
+		writel(desc->pattern, chan->regs + ZYNQMP_DMA_WR_ONLY_WORD1);
+		writel(desc->pattern, chan->regs + ZYNQMP_DMA_WR_ONLY_WORD2);
+		writel(desc->pattern, chan->regs + ZYNQMP_DMA_WR_ONLY_WORD3);
+	}
 	writel(val, chan->regs + ZYNQMP_DMA_CTRL0);
 
 	val = readl(chan->regs + ZYNQMP_DMA_DATA_ATTR);
@@ -567,26 +627,70 @@ static int zynqmp_dma_device_config(struct dma_chan *dchan,
 	return 0;
 }
 
+/**
+ * zynqmp_dma_pm_busy - Keep the channel powered while its queue is active
+ * @chan: ZynqMP DMA channel pointer
+ *
+ * The first transfer queued on an idle channel takes a runtime PM reference,
+ * resuming the device asynchronously if it was suspended: the resume starts
+ * the queue then. Called with the channel lock held.
+ */
+static void zynqmp_dma_pm_busy(struct zynqmp_dma_chan *chan)
+{
+	if (chan->pm_busy || list_empty(&chan->pending_list))
+		return;
+
+	chan->pm_busy = true;
+	chan->zdev->busy_periods++;
+	pm_runtime_get(chan->dev);
+}
+
+/**
+ * zynqmp_dma_pm_idle - Release the channel once its queue is empty
+ * @chan: ZynqMP DMA channel pointer
+ *
+ * The device suspends after the autosuspend delay without new transfers, so
+ * back to back transfers don't go through runtime PM. Called with the
+ * channel lock held.
+ */
+static void zynqmp_dma_pm_idle(struct zynqmp_dma_chan *chan)
+{
+	if (!chan->pm_busy || !list_empty(&chan->pending_list) ||
+	    !list_empty(&chan->active_list) || !list_empty(&chan->done_list))
+		return;
+
+	chan->pm_busy = false;
+	pm_runtime_mark_last_busy(chan->dev);
+	pm_runtime_put_autosuspend(chan->dev);
+}
+
 /**
  * zynqmp_dma_start_transfer - Initiate the new transfer
  * @chan: ZynqMP DMA channel pointer
  */
 static void zynqmp_dma_start_transfer(struct zynqmp_dma_chan *chan)
 {
-	struct zynqmp_dma_desc_sw *desc;
+	struct zynqmp_dma_desc_sw *desc, *first, *next;
 
-	if (!chan->idle)
+	if (!chan->idle || !chan->powered)
 		return;
 
-	zynqmp_dma_config(chan);
-
-	desc = list_first_entry_or_null(&chan->pending_list,
-					struct zynqmp_dma_desc_sw, node);
-	if (!desc)
+	first = list_first_entry_or_null(&chan->pending_list,
+					 struct zynqmp_dma_desc_sw, node);
+	if (!first)
 		return;
 
-	list_splice_tail_init(&chan->pending_list, &chan->active_list);
-	zynqmp_dma_update_desc_to_ctrlr(chan, desc);
+	zynqmp_dma_config(chan, first);
+
+	/* Only the transactions tx_submit chained together run as one */
+	list_for_each_entry_safe(desc, next, &chan->pending_list, node) {
+		if (!zynqmp_dma_desc_chainable(first, desc))
+			break;
+		trace_xilinx_dma_start(&chan->common, desc->async_tx.cookie);
+		list_move_tail(&desc->node, &chan->active_list);
+	}
+
+	zynqmp_dma_update_desc_to_ctrlr(chan, first);
 	zynqmp_dma_start(chan);
 }
 
@@ -605,6 +709,9 @@ static void zynqmp_dma_chan_desc_cleanup(struct zynqmp_dma_chan *chan)
 
 		list_del(&desc->node);
 
+		trace_xilinx_dma_callback(&chan->common, desc->async_tx.cookie);
+		xilinx_dma_lat_hist_add(&chan->lat_hist, desc->submit_time);
+
 		callback = desc->async_tx.callback;
 		callback_param = desc->async_tx.callback_param;
 		if (callback) {
@@ -630,6 +737,7 @@ static void zynqmp_dma_complete_descriptor(struct zynqmp_dma_chan *chan)
 					struct zynqmp_dma_desc_sw, node);
 	if (!desc)
 		return;
+	trace_xilinx_dma_complete(&chan->common, desc->async_tx.cookie);
 	list_del(&desc->node);
 	dma_cookie_complete(&desc->async_tx);
 	list_add_tail(&desc->node, &chan->done_list);
@@ -645,6 +753,7 @@ static void zynqmp_dma_issue_pending(struct dma_chan *dchan)
 	unsigned long irqflags;
 
 	spin_lock_irqsave(&chan->lock, irqflags);
+	zynqmp_dma_pm_busy(chan);
 	zynqmp_dma_start_transfer(chan);
 	spin_unlock_irqrestore(&chan->lock, irqflags);
 }
@@ -671,13 +780,12 @@ static void zynqmp_dma_free_chan_resources(struct dma_chan *dchan)
 
 	spin_lock_irqsave(&chan->lock, irqflags);
 	zynqmp_dma_free_descriptors(chan);
+	zynqmp_dma_pm_idle(chan);
 	spin_unlock_irqrestore(&chan->lock, irqflags);
 	dma_free_coherent(chan->dev,
 		(2 * ZYNQMP_DMA_DESC_SIZE(chan) * ZYNQMP_DMA_NUM_DESCS),
 		chan->desc_pool_v, chan->desc_pool_p);
 	kfree(chan->sw_desc_pool);
-	pm_runtime_mark_last_busy(chan->dev);
-	pm_runtime_put_autosuspend(chan->dev);
 }
 
 /**
@@ -694,6 +802,18 @@ static void zynqmp_dma_reset(struct zynqmp_dma_chan *chan)
 	zynqmp_dma_init(chan);
 }
 
+/**
+ * zynqmp_dma_schedule_cleanup - Defer the completion work of the channel
+ * @chan: ZynqMP DMA channel pointer
+ */
+static void zynqmp_dma_schedule_cleanup(struct zynqmp_dma_chan *chan)
+{
+	if (chan->cleanup_worker)
+		kthread_queue_work(chan->cleanup_worker, &chan->cleanup_work);
+	else
+		tasklet_schedule(&chan->tasklet);
+}
+
 /**
  * zynqmp_dma_irq_handler - ZynqMP DMA Interrupt handler
  * @irq: IRQ number
@@ -711,18 +831,30 @@ static irqreturn_t zynqmp_dma_irq_handler(int irq, void *data)
 	imr = readl(chan->regs + ZYNQMP_DMA_IMR);
 	status = isr & ~imr;
 
+	trace_xilinx_dma_irq(&chan->common, status);
+
 	writel(isr, chan->regs + ZYNQMP_DMA_ISR);
 	if (status & ZYNQMP_DMA_INT_DONE) {
-		tasklet_schedule(&chan->tasklet);
+		zynqmp_dma_schedule_cleanup(chan);
 		ret = IRQ_HANDLED;
 	}
 
-	if (status & ZYNQMP_DMA_DONE)
+	if (status & ZYNQMP_DMA_DONE) {
+		spin_lock(&chan->lock);
 		chan->idle = true;
+		/*
+		 * Chain the next batch right away instead of waiting for the
+		 * cleanup, the completion accounting keeps the active list
+		 * order so the finished descriptors are still reaped later.
+		 */
+		if (!chan->err && !(status & ZYNQMP_DMA_INT_ERR))
+			zynqmp_dma_start_transfer(chan);
+		spin_unlock(&chan->lock);
+	}
 
 	if (status & ZYNQMP_DMA_INT_ERR) {
 		chan->err = true;
-		tasklet_schedule(&chan->tasklet);
+		zynqmp_dma_schedule_cleanup(chan);
 		dev_err(chan->dev, "Channel %p has errors\n", chan);
 		ret = IRQ_HANDLED;
 	}
@@ -737,17 +869,24 @@ static irqreturn_t zynqmp_dma_irq_handler(int irq, void *data)
 }
 
 /**
- * zynqmp_dma_do_tasklet - Schedule completion tasklet
- * @data: Pointer to the ZynqMP DMA channel structure
+ * zynqmp_dma_do_cleanup - Completion work of the channel
+ * @chan: ZynqMP DMA channel pointer
  */
-static void zynqmp_dma_do_tasklet(unsigned long data)
+static void zynqmp_dma_do_cleanup(struct zynqmp_dma_chan *chan)
 {
-	struct zynqmp_dma_chan *chan = (struct zynqmp_dma_chan *)data;
 	u32 count;
 	unsigned long irqflags;
 
+	trace_xilinx_dma_cleanup(&chan->common);
+
 	spin_lock_irqsave(&chan->lock, irqflags);
 
+	/* The queue was terminated and the device suspended meanwhile */
+	if (!chan->powered) {
+		chan->err = false;
+		goto unlock;
+	}
+
 	if (chan->err) {
 		zynqmp_dma_reset(chan);
 		chan->err = false;
@@ -766,9 +905,29 @@ static void zynqmp_dma_do_tasklet(unsigned long data)
 		zynqmp_dma_start_transfer(chan);
 
 unlock:
+	zynqmp_dma_pm_idle(chan);
 	spin_unlock_irqrestore(&chan->lock, irqflags);
 }
 
+/**
+ * zynqmp_dma_do_tasklet - Schedule completion tasklet
+ * @data: Pointer to the ZynqMP DMA channel structure
+ */
+static void zynqmp_dma_do_tasklet(unsigned long data)
+{
+	zynqmp_dma_do_cleanup((struct zynqmp_dma_chan *)data);
+}
+
+/**
+ * zynqmp_dma_do_work - Completion work of the channel cleanup thread
+ * @work: Cleanup work of the channel
+ */
+static void zynqmp_dma_do_work(struct kthread_work *work)
+{
+	zynqmp_dma_do_cleanup(container_of(work, struct zynqmp_dma_chan,
+					   cleanup_work));
+}
+
 /**
  * zynqmp_dma_device_terminate_all - Aborts all transfers on a channel
  * @dchan: DMA channel pointer
@@ -781,13 +940,70 @@ static int zynqmp_dma_device_terminate_all(struct dma_chan *dchan)
 	unsigned long irqflags;
 
 	spin_lock_irqsave(&chan->lock, irqflags);
-	writel(ZYNQMP_DMA_IDS_DEFAULT_MASK, chan->regs + ZYNQMP_DMA_IDS);
+	if (chan->powered)
+		writel(ZYNQMP_DMA_IDS_DEFAULT_MASK,
+		       chan->regs + ZYNQMP_DMA_IDS);
 	zynqmp_dma_free_descriptors(chan);
+	zynqmp_dma_pm_idle(chan);
 	spin_unlock_irqrestore(&chan->lock, irqflags);
 
 	return 0;
 }
 
+/**
+ * zynqmp_dma_reserve_descs - Reserve descriptors for a transaction
+ * @chan: ZynqMP DMA channel pointer
+ * @desc_cnt: Number of descriptors the transaction needs
+ *
+ * Return: true if the descriptors were reserved
+ */
+static bool zynqmp_dma_reserve_descs(struct zynqmp_dma_chan *chan,
+				     u32 desc_cnt)
+{
+	unsigned long irqflags;
+
+	spin_lock_irqsave(&chan->lock, irqflags);
+	if (desc_cnt > chan->desc_free_cnt) {
+		spin_unlock_irqrestore(&chan->lock, irqflags);
+		dev_dbg(chan->dev, "chan %p descs are not available\n", chan);
+		return false;
+	}
+	chan->desc_free_cnt = chan->desc_free_cnt - desc_cnt;
+	spin_unlock_irqrestore(&chan->lock, irqflags);
+
+	return true;
+}
+
+/**
+ * zynqmp_dma_add_ll_desc - Append a reserved descriptor to a transaction
+ * @chan: ZynqMP DMA channel pointer
+ * @first: First descriptor of the transaction, NULL for a new one
+ * @prev: Last hw descriptor of the transaction, updated to the new one
+ * @src: Source buffer address
+ * @dst: Destination buffer address
+ * @len: Transfer length
+ *
+ * Return: The first descriptor of the transaction
+ */
+static struct zynqmp_dma_desc_sw *
+zynqmp_dma_add_ll_desc(struct zynqmp_dma_chan *chan,
+		       struct zynqmp_dma_desc_sw *first,
+		       struct zynqmp_dma_desc_ll **prev,
+		       dma_addr_t src, dma_addr_t dst, size_t len)
+{
+	struct zynqmp_dma_desc_sw *new;
+
+	new = zynqmp_dma_get_descriptor(chan);
+	zynqmp_dma_config_sg_ll_desc(chan, new->src_v, src, dst, len, *prev);
+	*prev = new->src_v;
+
+	if (!first)
+		return new;
+
+	list_add_tail(&new->node, &first->tx_list);
+	return first;
+}
+
 /**
  * zynqmp_dma_prep_memcpy - prepare descriptors for memcpy transaction
  * @dchan: DMA channel
@@ -803,44 +1019,130 @@ static struct dma_async_tx_descriptor *zynqmp_dma_prep_memcpy(
 				dma_addr_t dma_src, size_t len, ulong flags)
 {
 	struct zynqmp_dma_chan *chan;
-	struct zynqmp_dma_desc_sw *new, *first = NULL;
-	void *desc = NULL, *prev = NULL;
+	struct zynqmp_dma_desc_sw *first = NULL;
+	struct zynqmp_dma_desc_ll *prev = NULL;
 	size_t copy;
 	u32 desc_cnt;
-	unsigned long irqflags;
 
 	chan = to_chan(dchan);
 
 	desc_cnt = DIV_ROUND_UP(len, ZYNQMP_DMA_MAX_TRANS_LEN);
-
-	spin_lock_irqsave(&chan->lock, irqflags);
-	if (desc_cnt > chan->desc_free_cnt) {
-		spin_unlock_irqrestore(&chan->lock, irqflags);
-		dev_dbg(chan->dev, "chan %p descs are not available\n", chan);
+	if (!zynqmp_dma_reserve_descs(chan, desc_cnt))
 		return NULL;
-	}
-	chan->desc_free_cnt = chan->desc_free_cnt - desc_cnt;
-	spin_unlock_irqrestore(&chan->lock, irqflags);
 
 	do {
 		/* Allocate and populate the descriptor */
-		new = zynqmp_dma_get_descriptor(chan);
-
 		copy = min_t(size_t, len, ZYNQMP_DMA_MAX_TRANS_LEN);
-		desc = (struct zynqmp_dma_desc_ll *)new->src_v;
-		zynqmp_dma_config_sg_ll_desc(chan, desc, dma_src,
-					     dma_dst, copy, prev);
-		prev = desc;
+		first = zynqmp_dma_add_ll_desc(chan, first, &prev, dma_src,
+					       dma_dst, copy);
 		len -= copy;
 		dma_src += copy;
 		dma_dst += copy;
-		if (!first)
-			first = new;
-		else
-			list_add_tail(&new->node, &first->tx_list);
 	} while (len);
 
-	zynqmp_dma_desc_config_eod(chan, desc);
+	zynqmp_dma_desc_config_eod(chan, prev);
+	async_tx_ack(&first->async_tx);
+	first->async_tx.flags = flags;
+	return &first->async_tx;
+}
+
+/**
+ * zynqmp_dma_prep_memset - prepare descriptors for memset transaction
+ * @dchan: DMA channel
+ * @dma_dst: Destination buffer address
+ * @value: Byte value to fill the destination with
+ * @len: Transfer length
+ * @flags: transfer ack flags
+ *
+ * The channel runs the transaction in write only mode, writing the pattern
+ * held in the WR_ONLY_WORD registers instead of reading a source buffer.
+ *
+ * Return: Async transaction descriptor on success and NULL on failure
+ */
+static struct dma_async_tx_descriptor *zynqmp_dma_prep_memset(
+				struct dma_chan *dchan, dma_addr_t dma_dst,
+				int value, size_t len, ulong flags)
+{
+	struct zynqmp_dma_chan *chan = to_chan(dchan);
+	struct zynqmp_dma_desc_sw *first = NULL;
+	struct zynqmp_dma_desc_ll *prev = NULL;
+	size_t copy;
+	u32 desc_cnt;
+
+	if (!len)
+		return NULL;
+
+	desc_cnt = DIV_ROUND_UP(len, ZYNQMP_DMA_MAX_TRANS_LEN);
+	if (!zynqmp_dma_reserve_descs(chan, desc_cnt))
+		return NULL;
+
+	do {
+		copy = min_t(size_t, len, ZYNQMP_DMA_MAX_TRANS_LEN);
+		first = zynqmp_dma_add_ll_desc(chan, first, &prev, dma_dst,
+					       dma_dst, copy);
+		len -= copy;
+		dma_dst += copy;
+	} while (len);
+
+	first->wr_only = true;
+	first->pattern = (value & 0xFF) * 0x01010101;
+
+	zynqmp_dma_desc_config_eod(chan, prev);
+	async_tx_ack(&first->async_tx);
+	first->async_tx.flags = flags;
+	return &first->async_tx;
+}
+
+/**
+ * zynqmp_dma_prep_interleaved - prepare descriptors for interleaved copy
+ * @dchan: DMA channel
+ * @xt: Interleaved transfer template
+ * @flags: transfer ack flags
+ *
+ * Each chunk of each frame takes one descriptor, so the whole template
+ * has to fit in the free descriptors of the channel.
+ *
+ * Return: Async transaction descriptor on success and NULL on failure
+ */
+static struct dma_async_tx_descriptor *zynqmp_dma_prep_interleaved(
+				struct dma_chan *dchan,
+				struct dma_interleaved_template *xt,
+				ulong flags)
+{
+	struct zynqmp_dma_chan *chan = to_chan(dchan);
+	struct zynqmp_dma_desc_sw *first = NULL;
+	struct zynqmp_dma_desc_ll *prev = NULL;
+	dma_addr_t src, dst;
+	size_t i, j;
+
+	if (xt->dir != DMA_MEM_TO_MEM || !xt->numf || !xt->frame_size ||
+	    !xt->src_inc || !xt->dst_inc)
+		return NULL;
+
+	for (j = 0; j < xt->frame_size; j++) {
+		if (!xt->sgl[j].size ||
+		    xt->sgl[j].size > ZYNQMP_DMA_MAX_TRANS_LEN)
+			return NULL;
+	}
+
+	if (xt->numf * xt->frame_size > ZYNQMP_DMA_NUM_DESCS ||
+	    !zynqmp_dma_reserve_descs(chan, xt->numf * xt->frame_size))
+		return NULL;
+
+	src = xt->src_start;
+	dst = xt->dst_start;
+	for (i = 0; i < xt->numf; i++) {
+		for (j = 0; j < xt->frame_size; j++) {
+			first = zynqmp_dma_add_ll_desc(chan, first, &prev, src,
+						       dst, xt->sgl[j].size);
+			src += xt->sgl[j].size +
+			       dmaengine_get_src_icg(xt, &xt->sgl[j]);
+			dst += xt->sgl[j].size +
+			       dmaengine_get_dst_icg(xt, &xt->sgl[j]);
+		}
+	}
+
+	zynqmp_dma_desc_config_eod(chan, prev);
 	async_tx_ack(&first->async_tx);
 	first->async_tx.flags = flags;
 	return &first->async_tx;
@@ -855,12 +1157,76 @@ static void zynqmp_dma_chan_remove(struct zynqmp_dma_chan *chan)
 	if (!chan)
 		return;
 
-	if (chan->irq)
+	xilinx_dma_lat_hist_exit(&chan->lat_hist);
+
+	if (chan->irq) {
+		irq_set_affinity_hint(chan->irq, NULL);
 		devm_free_irq(chan->zdev->dev, chan->irq, chan);
+	}
 	tasklet_kill(&chan->tasklet);
+	if (chan->cleanup_worker)
+		kthread_flush_worker(chan->cleanup_worker);
 	list_del(&chan->common.device_node);
 }
 
+/**
+ * zynqmp_dma_destroy_worker - Stop the cleanup thread of the channel
+ * @data: Cleanup thread of the channel
+ */
+static void zynqmp_dma_destroy_worker(void *data)
+{
+	kthread_destroy_worker(data);
+}
+
+/**
+ * zynqmp_dma_chan_worker_init - Set up the cleanup thread of the channel
+ * @chan: ZynqMP DMA channel pointer
+ * @node: Device node of the channel
+ *
+ * The completion callbacks run from the tasklet by default, in softirq
+ * context on whichever CPU took the interrupt. "xlnx,threaded-completion"
+ * moves them to a kthread of the channel whose affinity and priority can
+ * be tuned from user space, "xlnx,completion-cpu" additionally binds that
+ * thread to the given CPU. Otherwise the thread stays off the CPUs isolated
+ * with isolcpus=.
+ *
+ * Return: '0' on success and failure value on error
+ */
+static int zynqmp_dma_chan_worker_init(struct zynqmp_dma_chan *chan,
+				       struct device_node *node)
+{
+	struct kthread_worker *worker;
+	u32 cpu;
+
+	kthread_init_work(&chan->cleanup_work, zynqmp_dma_do_work);
+
+	if (!of_property_read_u32(node, "xlnx,completion-cpu", &cpu)) {
+		if (cpu >= nr_cpu_ids || !cpu_online(cpu)) {
+			dev_err(chan->dev, "invalid xlnx,completion-cpu %u\n",
+				cpu);
+			return -EINVAL;
+		}
+		worker = kthread_create_worker_on_cpu(cpu, 0, "%s/%d",
+						      dev_name(chan->dev), cpu);
+	} else if (of_property_read_bool(node, "xlnx,threaded-completion")) {
+		worker = kthread_create_worker(0, "%s", dev_name(chan->dev));
+		if (!IS_ERR(worker) && housekeeping_enabled(HK_FLAG_DOMAIN))
+			set_cpus_allowed_ptr(worker->task,
+				housekeeping_cpumask(HK_FLAG_DOMAIN));
+	} else {
+		return 0;
+	}
+
+	if (IS_ERR(worker)) {
+		dev_err(chan->dev, "failed to create cleanup thread\n");
+		return PTR_ERR(worker);
+	}
+
+	chan->cleanup_worker = worker;
+	return devm_add_action_or_reset(chan->dev, zynqmp_dma_destroy_worker,
+					worker);
+}
+
 /**
  * zynqmp_dma_chan_probe - Per Channel Probing
  * @zdev: Driver specific device structure
@@ -905,6 +1271,9 @@ static int zynqmp_dma_chan_probe(struct zynqmp_dma_device *zdev,
 	chan->is_dmacoherent =  of_property_read_bool(node, "dma-coherent");
 	zdev->chan = chan;
 	tasklet_init(&chan->tasklet, zynqmp_dma_do_tasklet, (ulong)chan);
+	err = zynqmp_dma_chan_worker_init(chan, node);
+	if (err)
+		return err;
 	spin_lock_init(&chan->lock);
 	INIT_LIST_HEAD(&chan->active_list);
 	INIT_LIST_HEAD(&chan->pending_list);
@@ -923,9 +1292,15 @@ static int zynqmp_dma_chan_probe(struct zynqmp_dma_device *zdev,
 			       "zynqmp-dma", chan);
 	if (err)
 		return err;
+	/* Keep the interrupt, so the tasklet, off the isolated CPUs */
+	if (housekeeping_enabled(HK_FLAG_DOMAIN))
+		irq_set_affinity_hint(chan->irq,
+				      housekeeping_cpumask(HK_FLAG_DOMAIN));
 
 	chan->desc_size = sizeof(struct zynqmp_dma_desc_ll);
 	chan->idle = true;
+	/* The probe holds the device resumed */
+	chan->powered = true;
 	return 0;
 }
 
@@ -984,7 +1359,21 @@ static int __maybe_unused zynqmp_dma_resume(struct device *dev)
 static int __maybe_unused zynqmp_dma_runtime_suspend(struct device *dev)
 {
 	struct zynqmp_dma_device *zdev = dev_get_drvdata(dev);
+	struct zynqmp_dma_chan *chan = zdev->chan;
+	unsigned long irqflags;
+
+	if (chan) {
+		spin_lock_irqsave(&chan->lock, irqflags);
+		/* A transfer was queued since the suspend was decided */
+		if (chan->pm_busy) {
+			spin_unlock_irqrestore(&chan->lock, irqflags);
+			return -EBUSY;
+		}
+		chan->powered = false;
+		spin_unlock_irqrestore(&chan->lock, irqflags);
+	}
 
+	zdev->suspends++;
 	clk_disable_unprepare(zdev->clk_main);
 	clk_disable_unprepare(zdev->clk_apb);
 
@@ -1001,6 +1390,8 @@ static int __maybe_unused zynqmp_dma_runtime_suspend(struct device *dev)
 static int __maybe_unused zynqmp_dma_runtime_resume(struct device *dev)
 {
 	struct zynqmp_dma_device *zdev = dev_get_drvdata(dev);
+	struct zynqmp_dma_chan *chan = zdev->chan;
+	unsigned long irqflags;
 	int err;
 
 	err = clk_prepare_enable(zdev->clk_main);
@@ -1016,9 +1407,62 @@ static int __maybe_unused zynqmp_dma_runtime_resume(struct device *dev)
 		return err;
 	}
 
+	zdev->resumes++;
+
+	/* Start the transfers queued while the device was suspended */
+	if (chan) {
+		spin_lock_irqsave(&chan->lock, irqflags);
+		chan->powered = true;
+		zynqmp_dma_start_transfer(chan);
+		spin_unlock_irqrestore(&chan->lock, irqflags);
+	}
+
 	return 0;
 }
 
+static ssize_t busy_periods_show(struct device *dev,
+				 struct device_attribute *attr, char *buf)
+{
+	struct zynqmp_dma_device *zdev = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%lu\n", READ_ONCE(zdev->busy_periods));
+}
+static DEVICE_ATTR_RO(busy_periods);
+
+static ssize_t resumes_show(struct device *dev,
+			    struct device_attribute *attr, char *buf)
+{
+	struct zynqmp_dma_device *zdev = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%lu\n", READ_ONCE(zdev->resumes));
+}
+static DEVICE_ATTR_RO(resumes);
+
+static ssize_t suspends_show(struct device *dev,
+			     struct device_attribute *attr, char *buf)
+{
+	struct zynqmp_dma_device *zdev = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%lu\n", READ_ONCE(zdev->suspends));
+}
+static DEVICE_ATTR_RO(suspends);
+
+/*
+ * With transfers closer than the autosuspend delay, the busy periods add up
+ * while the resumes and suspends don't move.
+ */
+static struct attribute *zynqmp_dma_pm_attrs[] = {
+	&dev_attr_busy_periods.attr,
+	&dev_attr_resumes.attr,
+	&dev_attr_suspends.attr,
+	NULL,
+};
+
+static const struct attribute_group zynqmp_dma_pm_group = {
+	.name = "pm_stats",
+	.attrs = zynqmp_dma_pm_attrs,
+};
+
 static const struct dev_pm_ops zynqmp_dma_dev_pm_ops = {
 	SET_SYSTEM_SLEEP_PM_OPS(zynqmp_dma_suspend, zynqmp_dma_resume)
 	SET_RUNTIME_PM_OPS(zynqmp_dma_runtime_suspend,
@@ -1046,9 +1490,13 @@ static int zynqmp_dma_probe(struct platform_device *pdev)
 
 	dma_set_mask(&pdev->dev, DMA_BIT_MASK(44));
 	dma_cap_set(DMA_MEMCPY, zdev->common.cap_mask);
+	dma_cap_set(DMA_MEMSET, zdev->common.cap_mask);
+	dma_cap_set(DMA_INTERLEAVE, zdev->common.cap_mask);
 
 	p = &zdev->common;
 	p->device_prep_dma_memcpy = zynqmp_dma_prep_memcpy;
+	p->device_prep_dma_memset = zynqmp_dma_prep_memset;
+	p->device_prep_interleaved_dma = zynqmp_dma_prep_interleaved;
 	p->device_terminate_all = zynqmp_dma_device_terminate_all;
 	p->device_issue_pending = zynqmp_dma_issue_pending;
 	p->device_alloc_chan_resources = zynqmp_dma_alloc_chan_resources;
@@ -1088,8 +1536,11 @@ static int zynqmp_dma_probe(struct platform_device *pdev)
 
 	p->dst_addr_widths = BIT(zdev->chan->bus_width / 8);
 	p->src_addr_widths = BIT(zdev->chan->bus_width / 8);
+	/* The write only pattern is written a bus word at a time */
+	p->fill_align = ilog2(zdev->chan->bus_width / 8);
 
 	dma_async_device_register(&zdev->common);
+	xilinx_dma_lat_hist_init(&zdev->chan->lat_hist, &zdev->chan->common);
 
 	ret = of_dma_controller_register(pdev->dev.of_node,
 					 of_zynqmp_dma_xlate, zdev);
@@ -1099,6 +1550,9 @@ static int zynqmp_dma_probe(struct platform_device *pdev)
 		goto free_chan_resources;
 	}
 
+	if (devm_device_add_group(&pdev->dev, &zynqmp_dma_pm_group))
+		dev_warn(&pdev->dev, "failed to create PM statistics\n");
+
 	pm_runtime_mark_last_busy(zdev->dev);
 	pm_runtime_put_sync_autosuspend(zdev->dev);
 
@@ -3,13 +3,17 @@
  * Copyright (C) 2020 Xilinx, Inc.
  */
 
+#include <linux/bitfield.h>
 #include <linux/edac.h>
 #include <linux/interrupt.h>
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/of_device.h>
 #include <linux/platform_device.h>
+#include <linux/ratelimit.h>
 #include <linux/sizes.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
 
 #include "edac_module.h"
 
@@ -18,6 +22,16 @@
 
 #define XDDR_EDAC_MSG_SIZE			256
 
+/* Delay used to coalesce correctable errors before reporting them */
+#define XDDR_CE_BATCH_DELAY			msecs_to_jiffies(100)
+/* CE interrupts per second above which CE interrupts are masked */
+#define XDDR_CE_STORM_THRESHOLD			100
+/* Poll period used while CE interrupts are masked */
+#define XDDR_CE_POLL_INTERVAL			msecs_to_jiffies(1000)
+/* Fully decoded CE reports allowed per rank and per second */
+#define XDDR_CE_DECODE_BURST			10
+#define XDDR_NR_RANKS				4
+
 #define XDDR_PCSR_OFFSET			0xC
 #define XDDR_ISR_OFFSET				0x14
 #define XDDR_IRQ_EN_OFFSET			0x20
@@ -211,9 +225,30 @@
 #define XDDR_MAX_BANK_CNT			2
 #define XDDR_MAX_GRP_CNT			2
 
+/*
+ * DRAM address packed as row, column, bank, group, rank, logical rank and
+ * channel, from the least significant bit. The address map lookup tables
+ * translate it a byte at a time.
+ */
+#define XDDR_DA_ROW_MASK			GENMASK_ULL(17, 0)
+#define XDDR_DA_COL_MASK			GENMASK_ULL(27, 18)
+#define XDDR_DA_BANK_MASK			GENMASK_ULL(29, 28)
+#define XDDR_DA_GRP_MASK			GENMASK_ULL(31, 30)
+#define XDDR_DA_RANK_MASK			GENMASK_ULL(33, 32)
+#define XDDR_DA_LRANK_MASK			GENMASK_ULL(36, 34)
+#define XDDR_DA_CH_MASK				BIT_ULL(37)
+#define XDDR_DA_BITS				38
+
+#define XDDR_LUT_CHUNK_BITS			8
+#define XDDR_LUT_CHUNK_SIZE			BIT(XDDR_LUT_CHUNK_BITS)
+#define XDDR_LUT_CHUNK_MASK			(XDDR_LUT_CHUNK_SIZE - 1)
+#define XDDR_LUT_DA_CHUNKS			DIV_ROUND_UP(XDDR_DA_BITS, \
+						     XDDR_LUT_CHUNK_BITS)
+#define XDDR_LUT_PA_CHUNKS			(64 / XDDR_LUT_CHUNK_BITS)
+
 #define PCSR_UNLOCK_VAL				0xF9E8D7C6
-#define XDDR_ERR_TYPE_CE			0
-#define XDDR_ERR_TYPE_UE			1
+#define XDDR_ERR_TYPE_CE			BIT(0)
+#define XDDR_ERR_TYPE_UE			BIT(1)
 
 #define XILINX_DRAM_SIZE_4G			0
 #define XILINX_DRAM_SIZE_6G			1
@@ -246,25 +281,62 @@ struct xddr_ecc_error_info {
  * struct xddr_ecc_status - ECC status information to report.
  * @ceinfo:	Correctable error log information.
  * @ueinfo:	Uncorrectable error log information.
- * @channel:	Channel number.
- * @error_type:	Error type information.
+ * @ce_channel:	Channel number of the correctable error.
+ * @ue_channel:	Channel number of the uncorrectable error.
+ * @error_type:	Mask of the error types logged.
  */
 struct xddr_ecc_status {
 	struct xddr_ecc_error_info ceinfo[2];
 	struct xddr_ecc_error_info ueinfo[2];
-	u32 channel;
+	u32 ce_channel;
+	u32 ue_channel;
 	u8 error_type;
 };
 
+/**
+ * struct xddr_ce_rank - Correctable errors of a rank not yet reported.
+ * @info:	Most recent correctable error log information.
+ * @channel:	Channel number of the most recent correctable error.
+ * @pending:	Number of correctable errors not yet reported.
+ */
+struct xddr_ce_rank {
+	struct xddr_ecc_error_info info;
+	u32 channel;
+	u32 pending;
+};
+
+/**
+ * struct xddr_addr_lut - Address map lookup tables.
+ * @to_phys:	Physical address bits of each byte of a packed DRAM address.
+ * @to_dram:	Packed DRAM address bits of each byte of a physical address.
+ */
+struct xddr_addr_lut {
+	u64 to_phys[XDDR_LUT_DA_CHUNKS][XDDR_LUT_CHUNK_SIZE];
+#ifdef CONFIG_EDAC_DEBUG
+	u64 to_dram[XDDR_LUT_PA_CHUNKS][XDDR_LUT_CHUNK_SIZE];
+#endif
+};
+
 /**
  * struct xddr_edac_priv - DDR memory controller private instance data.
  * @ddrmc_baseaddr:	Base address of the DDR controller.
  * @ddrmc_noc_baseaddr:	Base address of the DDRMC NOC.
+ * @mci:		EDAC memory controller instance.
  * @message:		Buffer for framing the event specific info.
  * @mc_id:		Memory controller ID.
  * @ce_cnt:		Correctable error count.
  * @ue_cnt:		UnCorrectable error count.
  * @stat:		ECC status information.
+ * @lock:		Protects the pending errors, the storm state and the
+ *			PCSR protected registers.
+ * @work:		Deferred error reporting and CE polling work.
+ * @ce_rank:		Correctable errors pending per rank.
+ * @ce_rs:		Per rank rate limit of the decoded CE reports.
+ * @ue_pending:		Uncorrectable errors not yet reported.
+ * @storm_start:	Start of the current CE storm detection window.
+ * @storm_cnt:		CE interrupts in the current detection window.
+ * @ce_polled:		CE interrupts are masked and CEs are polled.
+ * @stopping:		The driver is being removed.
  * @lrank_bit:		Bit shifts for lrank bit.
  * @rank_bit:		Bit shifts for rank bit.
  * @row_bit:		Bit shifts for row bit.
@@ -272,16 +344,27 @@ struct xddr_ecc_status {
  * @bank_bit:		Bit shifts for bank bit.
  * @grp_bit:		Bit shifts for group bit.
  * @ch_bit:		Bit shifts for channel bit.
+ * @lut:		Address map lookup tables.
  * @err_inject_addr:	Data poison address.
  */
 struct xddr_edac_priv {
 	void __iomem *ddrmc_baseaddr;
 	void __iomem *ddrmc_noc_baseaddr;
+	struct mem_ctl_info *mci;
 	char message[XDDR_EDAC_MSG_SIZE];
 	u32 mc_id;
 	u32 ce_cnt;
 	u32 ue_cnt;
 	struct xddr_ecc_status stat;
+	spinlock_t lock;
+	struct delayed_work work;
+	struct xddr_ce_rank ce_rank[XDDR_NR_RANKS];
+	struct ratelimit_state ce_rs[XDDR_NR_RANKS];
+	u32 ue_pending;
+	unsigned long storm_start;
+	u32 storm_cnt;
+	bool ce_polled;
+	bool stopping;
 	u32 lrank_bit[3];
 	u32 rank_bit[2];
 	u32 row_bit[18];
@@ -289,6 +372,7 @@ struct xddr_edac_priv {
 	u32 bank_bit[2];
 	u32 grp_bit[2];
 	u32 ch_bit;
+	struct xddr_addr_lut *lut;
 #ifdef CONFIG_EDAC_DEBUG
 	u64 err_inject_addr;
 #endif
@@ -319,11 +403,11 @@ static int xddr_get_error_info(struct xddr_edac_priv *priv)
 	else if (!eccr0_ceval && !eccr1_ceval)
 		goto ue_err;
 	else if (!eccr0_ceval)
-		p->channel = 1;
+		p->ce_channel = 1;
 	else
-		p->channel = 0;
+		p->ce_channel = 0;
 
-	p->error_type = XDDR_ERR_TYPE_CE;
+	p->error_type |= XDDR_ERR_TYPE_CE;
 	regval = readl(ddrmc_base + ECCR0_CE_ADDR_LO_OFFSET);
 	p->ceinfo[0].burstpos = (regval & ECCR_UE_CE_ADDR_LO_BP_MASK);
 	p->ceinfo[0].lrank = (regval & ECCR_UE_CE_ADDR_LO_LRANK_MASK) >>
@@ -373,11 +457,11 @@ static int xddr_get_error_info(struct xddr_edac_priv *priv)
 	if (!eccr0_ueval && !eccr1_ueval)
 		goto out;
 	else if (!eccr0_ueval)
-		p->channel = 1;
+		p->ue_channel = 1;
 	else
-		p->channel = 0;
+		p->ue_channel = 0;
 
-	p->error_type = XDDR_ERR_TYPE_UE;
+	p->error_type |= XDDR_ERR_TYPE_UE;
 	regval = readl(ddrmc_base + ECCR0_UE_ADDR_LO_OFFSET);
 	p->ueinfo[0].burstpos = (regval & ECCR_UE_CE_ADDR_LO_BP_MASK);
 	p->ueinfo[0].lrank = (regval & ECCR_UE_CE_ADDR_LO_LRANK_MASK) >>
@@ -439,94 +523,221 @@ static int xddr_get_error_info(struct xddr_edac_priv *priv)
 	return 0;
 }
 
+/**
+ * xddr_dram_addr - Pack the DRAM location of an error.
+ * @pinf:	ECC error info structure.
+ * @channel:	Channel number of the error.
+ *
+ * Return: Packed DRAM address.
+ */
+static u64 xddr_dram_addr(const struct xddr_ecc_error_info *pinf, u32 channel)
+{
+	return FIELD_PREP(XDDR_DA_ROW_MASK, pinf->row) |
+	       FIELD_PREP(XDDR_DA_COL_MASK, pinf->col) |
+	       FIELD_PREP(XDDR_DA_BANK_MASK, pinf->bank) |
+	       FIELD_PREP(XDDR_DA_GRP_MASK, pinf->group) |
+	       FIELD_PREP(XDDR_DA_RANK_MASK, pinf->rank) |
+	       FIELD_PREP(XDDR_DA_LRANK_MASK, pinf->lrank) |
+	       FIELD_PREP(XDDR_DA_CH_MASK, channel);
+}
+
 /**
  * xddr_convert_to_physical - Convert to physical address.
  * @priv:	DDR memory controller private instance data.
  * @pinf:	ECC error info structure.
+ * @channel:	Channel number of the error.
  *
  * Return: Physical address of the DDR memory.
  */
 static ulong xddr_convert_to_physical(struct xddr_edac_priv *priv,
-				      struct xddr_ecc_error_info pinf)
+				      struct xddr_ecc_error_info pinf,
+				      u32 channel)
 {
+	u64 da = xddr_dram_addr(&pinf, channel);
 	ulong err_addr = 0;
-	u32 index;
+	u32 chunk;
 
-	for (index = 0; index < XDDR_MAX_ROW_CNT; index++) {
-		err_addr |= (pinf.row & BIT(0)) << priv->row_bit[index];
-		pinf.row >>= 1;
+	for (chunk = 0; chunk < XDDR_LUT_DA_CHUNKS; chunk++) {
+		err_addr |= priv->lut->to_phys[chunk][da & XDDR_LUT_CHUNK_MASK];
+		da >>= XDDR_LUT_CHUNK_BITS;
 	}
 
-	for (index = 0; index < XDDR_MAX_COL_CNT; index++) {
-		err_addr |= (pinf.col & BIT(0)) << priv->col_bit[index];
-		pinf.col >>= 1;
-	}
+	return err_addr;
+}
 
-	for (index = 0; index < XDDR_MAX_BANK_CNT; index++) {
-		err_addr |= (pinf.bank & BIT(0)) << priv->bank_bit[index];
-		pinf.bank >>= 1;
-	}
+/**
+ * xddr_write_pcsr - Write a PCSR protected register.
+ * @priv:	DDR memory controller private instance data.
+ * @val:	Value to write.
+ * @offset:	Register offset.
+ */
+static void xddr_write_pcsr(struct xddr_edac_priv *priv, u32 val, u32 offset)
+{
+	/* Unlock the PCSR registers */
+	writel(PCSR_UNLOCK_VAL, priv->ddrmc_baseaddr + XDDR_PCSR_OFFSET);
 
-	for (index = 0; index < XDDR_MAX_GRP_CNT; index++) {
-		err_addr |= (pinf.group & BIT(0)) << priv->grp_bit[index];
-		pinf.group >>= 1;
-	}
+	writel(val, priv->ddrmc_baseaddr + offset);
 
-	for (index = 0; index < XDDR_MAX_RANK_CNT; index++) {
-		err_addr |= (pinf.rank & BIT(0)) << priv->rank_bit[index];
-		pinf.rank >>= 1;
-	}
+	/* Lock the PCSR registers */
+	writel(1, priv->ddrmc_baseaddr + XDDR_PCSR_OFFSET);
+}
 
-	for (index = 0; index < XDDR_MAX_LRANK_CNT; index++) {
-		err_addr |= (pinf.lrank & BIT(0)) << priv->lrank_bit[index];
-		pinf.lrank >>= 1;
+/**
+ * xddr_latch_errors - Move the logged errors to the pending errors.
+ * @priv:	DDR memory controller private instance data.
+ *
+ * Reads and clears the error logs of the controller and accounts the
+ * errors found as pending, the decoding and the reporting being left to
+ * the error work. Called with the lock held.
+ *
+ * Return: mask of the error types found.
+ */
+static u8 xddr_latch_errors(struct xddr_edac_priv *priv)
+{
+	struct xddr_ecc_status *stat = &priv->stat;
+	struct xddr_ce_rank *ce;
+	u8 error_type;
+
+	if (xddr_get_error_info(priv))
+		return 0;
+
+	error_type = stat->error_type;
+	if (error_type & XDDR_ERR_TYPE_CE) {
+		ce = &priv->ce_rank[stat->ceinfo[stat->ce_channel].rank];
+		ce->info = stat->ceinfo[stat->ce_channel];
+		ce->channel = stat->ce_channel;
+		ce->pending++;
 	}
 
-	err_addr |= (priv->stat.channel & BIT(0)) << priv->ch_bit;
+	/* The last UE log is kept in stat for the error work */
+	if (error_type & XDDR_ERR_TYPE_UE)
+		priv->ue_pending++;
+	stat->error_type = 0;
 
-	return err_addr;
+	return error_type;
 }
 
 /**
- * xddr_handle_error - Handle Correctable and Uncorrectable errors.
- * @mci:	EDAC memory controller instance.
- * @stat:	ECC status structure.
+ * xddr_ce_storm - Account a CE interrupt and detect a CE storm.
+ * @priv:	DDR memory controller private instance data.
  *
- * Handles ECC correctable and uncorrectable errors.
+ * Return: true if more than XDDR_CE_STORM_THRESHOLD CE interrupts were
+ * raised in the last second.
  */
-static void xddr_handle_error(struct mem_ctl_info *mci,
-			      struct xddr_ecc_status *stat)
+static bool xddr_ce_storm(struct xddr_edac_priv *priv)
 {
-	struct xddr_edac_priv *priv = mci->pvt_info;
-	struct xddr_ecc_error_info pinf;
+	if (time_after(jiffies, priv->storm_start + HZ)) {
+		priv->storm_start = jiffies;
+		priv->storm_cnt = 0;
+	}
 
-	if (stat->error_type == XDDR_ERR_TYPE_CE) {
-		priv->ce_cnt++;
-		pinf = stat->ceinfo[stat->channel];
+	return ++priv->storm_cnt > XDDR_CE_STORM_THRESHOLD;
+}
+
+/**
+ * xddr_report_ce - Report the correctable errors of a rank.
+ * @priv:	DDR memory controller private instance data.
+ * @rank:	Rank number.
+ * @ce:		Correctable errors of the rank.
+ *
+ * All the pending errors are accounted in a single EDAC event, the most
+ * recent one being decoded unless the rank exceeds its decode rate.
+ */
+static void xddr_report_ce(struct xddr_edac_priv *priv, u32 rank,
+			   struct xddr_ce_rank *ce)
+{
+	priv->ce_cnt += ce->pending;
+	if (__ratelimit(&priv->ce_rs[rank]))
 		snprintf(priv->message, XDDR_EDAC_MSG_SIZE,
 			 "Error type:%s MC ID: %d Addr at %lx Burst Pos: %d\n",
 			 "CE", priv->mc_id,
-			 xddr_convert_to_physical(priv, pinf), pinf.burstpos);
+			 xddr_convert_to_physical(priv, ce->info, ce->channel),
+			 ce->info.burstpos);
+	else
+		snprintf(priv->message, XDDR_EDAC_MSG_SIZE,
+			 "Error type:%s MC ID: %d Rank: %u\n",
+			 "CE", priv->mc_id, rank);
 
-		edac_mc_handle_error(HW_EVENT_ERR_CORRECTED, mci,
-				     priv->ce_cnt, 0, 0, 0, 0, 0, -1,
-				     priv->message, "");
-	}
+	edac_mc_handle_error(HW_EVENT_ERR_CORRECTED, priv->mci,
+			     ce->pending, 0, 0, 0, 0, 0, -1,
+			     priv->message, "");
+}
 
-	if (stat->error_type == XDDR_ERR_TYPE_UE) {
-		priv->ue_cnt++;
-		pinf = stat->ueinfo[stat->channel];
-		snprintf(priv->message, XDDR_EDAC_MSG_SIZE,
-			 "Error type:%s MC ID: %d Addr at %lx Burst Pos: %d\n",
-			 "UE", priv->mc_id,
-			 xddr_convert_to_physical(priv, pinf), pinf.burstpos);
+/**
+ * xddr_report_ue - Report the uncorrectable errors.
+ * @priv:	DDR memory controller private instance data.
+ * @count:	Number of uncorrectable errors.
+ * @pinf:	Most recent uncorrectable error log information.
+ * @channel:	Channel number of the most recent uncorrectable error.
+ */
+static void xddr_report_ue(struct xddr_edac_priv *priv, u32 count,
+			   struct xddr_ecc_error_info pinf, u32 channel)
+{
+	priv->ue_cnt += count;
+	snprintf(priv->message, XDDR_EDAC_MSG_SIZE,
+		 "Error type:%s MC ID: %d Addr at %lx Burst Pos: %d\n",
+		 "UE", priv->mc_id,
+		 xddr_convert_to_physical(priv, pinf, channel), pinf.burstpos);
+
+	edac_mc_handle_error(HW_EVENT_ERR_UNCORRECTED, priv->mci,
+			     count, 0, 0, 0, 0, 0, -1,
+			     priv->message, "");
+}
 
-		edac_mc_handle_error(HW_EVENT_ERR_UNCORRECTED, mci,
-				     priv->ue_cnt, 0, 0, 0, 0, 0, -1,
-				     priv->message, "");
+/**
+ * xddr_err_work - Decode and report the pending errors.
+ * @work:	Work structure.
+ *
+ * While a CE storm masks the CE interrupts, this also polls the error logs
+ * and unmasks the CE interrupts once a poll period goes by without a CE.
+ */
+static void xddr_err_work(struct work_struct *work)
+{
+	struct xddr_edac_priv *priv = container_of(to_delayed_work(work),
+						   struct xddr_edac_priv,
+						   work);
+	struct xddr_ce_rank ce[XDDR_NR_RANKS];
+	struct xddr_ecc_error_info ueinfo;
+	u32 rank, ue, ue_channel;
+	bool poll = false;
+
+	spin_lock_irq(&priv->lock);
+	if (priv->ce_polled && !priv->stopping) {
+		if (xddr_latch_errors(priv) & XDDR_ERR_TYPE_CE) {
+			poll = true;
+		} else {
+			xddr_write_pcsr(priv, XDDR_IRQ_CE_MASK,
+					XDDR_ISR_OFFSET);
+			xddr_write_pcsr(priv, XDDR_IRQ_CE_MASK,
+					XDDR_IRQ_EN_OFFSET);
+			priv->ce_polled = false;
+			priv->storm_start = jiffies;
+			priv->storm_cnt = 0;
+		}
 	}
 
-	memset(stat, 0, sizeof(*stat));
+	memcpy(ce, priv->ce_rank, sizeof(ce));
+	for (rank = 0; rank < XDDR_NR_RANKS; rank++)
+		priv->ce_rank[rank].pending = 0;
+
+	ue = priv->ue_pending;
+	ueinfo = priv->stat.ueinfo[priv->stat.ue_channel];
+	ue_channel = priv->stat.ue_channel;
+	priv->ue_pending = 0;
+	spin_unlock_irq(&priv->lock);
+
+	if (ue)
+		xddr_report_ue(priv, ue, ueinfo, ue_channel);
+
+	for (rank = 0; rank < XDDR_NR_RANKS; rank++)
+		if (ce[rank].pending)
+			xddr_report_ce(priv, rank, &ce[rank]);
+
+	edac_dbg(3, "Total error count CE %d UE %d\n",
+		 priv->ce_cnt, priv->ue_cnt);
+
+	if (poll)
+		schedule_delayed_work(&priv->work, XDDR_CE_POLL_INTERVAL);
 }
 
 /**
@@ -534,13 +745,20 @@ static void xddr_handle_error(struct mem_ctl_info *mci,
  * @irq:	IRQ number
  * @dev_id:	Device ID
  *
+ * Only latches the errors, the decoding and the reporting are deferred to
+ * the error work. CEs are batched for XDDR_CE_BATCH_DELAY while UEs are
+ * reported right away. A CE storm masks the CE interrupts and switches the
+ * error work to polling.
+ *
  * Return: IRQ_NONE, if interrupt not set or IRQ_HANDLED otherwise.
  */
 static irqreturn_t xddr_intr_handler(int irq, void *dev_id)
 {
 	struct mem_ctl_info *mci = dev_id;
 	struct xddr_edac_priv *priv;
-	int status, regval;
+	u8 error_type;
+	bool storm;
+	int regval;
 
 	priv = mci->pvt_info;
 	regval = readl(priv->ddrmc_baseaddr + XDDR_ISR_OFFSET);
@@ -548,23 +766,32 @@ static irqreturn_t xddr_intr_handler(int irq, void *dev_id)
 	if (!regval)
 		return IRQ_NONE;
 
-	/* Unlock the PCSR registers */
-	writel(PCSR_UNLOCK_VAL, priv->ddrmc_baseaddr + XDDR_PCSR_OFFSET);
-
+	spin_lock(&priv->lock);
 	/* Clear the ISR */
-	writel(regval, priv->ddrmc_baseaddr + XDDR_ISR_OFFSET);
-
-	/* Lock the PCSR registers */
-	writel(1, priv->ddrmc_baseaddr + XDDR_PCSR_OFFSET);
+	xddr_write_pcsr(priv, regval, XDDR_ISR_OFFSET);
+
+	error_type = xddr_latch_errors(priv);
+	storm = (error_type & XDDR_ERR_TYPE_CE) && !priv->ce_polled &&
+		xddr_ce_storm(priv);
+	if (storm) {
+		xddr_write_pcsr(priv, XDDR_IRQ_CE_MASK, XDDR_IRQ_DIS_OFFSET);
+		priv->ce_polled = true;
+	}
+	spin_unlock(&priv->lock);
 
-	status = xddr_get_error_info(priv);
-	if (status)
+	if (!error_type)
 		return IRQ_NONE;
 
-	xddr_handle_error(mci, &priv->stat);
+	if (storm)
+		edac_printk(KERN_WARNING, EDAC_MC,
+			    "MC ID: %d CE storm, polling CEs\n", priv->mc_id);
 
-	edac_dbg(3, "Total error count CE %d UE %d\n",
-		 priv->ce_cnt, priv->ue_cnt);
+	if (error_type & XDDR_ERR_TYPE_UE)
+		mod_delayed_work(system_wq, &priv->work, 0);
+	else
+		schedule_delayed_work(&priv->work, storm ?
+				      XDDR_CE_POLL_INTERVAL :
+				      XDDR_CE_BATCH_DELAY);
 
 	return IRQ_HANDLED;
 }
@@ -782,9 +1009,81 @@ static int xddr_setup_irq(struct mem_ctl_info *mci,
 	return 0;
 }
 
-#ifdef CONFIG_EDAC_DEBUG
 #define to_mci(k) container_of(k, struct mem_ctl_info, dev)
 
+static ssize_t xddr_show_bits(char *data, ssize_t len, const char *name,
+			      const u32 *bits, u32 count)
+{
+	u32 index;
+
+	len += scnprintf(data + len, PAGE_SIZE - len, "%s:", name);
+	for (index = 0; index < count; index++)
+		len += scnprintf(data + len, PAGE_SIZE - len, " %u",
+				 bits[index]);
+
+	return len + scnprintf(data + len, PAGE_SIZE - len, "\n");
+}
+
+/*
+ * Physical address bit of every bit of the DRAM location, one line per
+ * field from its least significant bit. Lets user space translate between
+ * physical addresses and rank/bank/row without a lookup per page.
+ */
+static ssize_t addr_map_show(struct device *dev,
+			     struct device_attribute *mattr,
+			     char *data)
+{
+	struct mem_ctl_info *mci = to_mci(dev);
+	struct xddr_edac_priv *priv = mci->pvt_info;
+	ssize_t len = 0;
+
+	len = xddr_show_bits(data, len, "row", priv->row_bit,
+			     XDDR_MAX_ROW_CNT);
+	len = xddr_show_bits(data, len, "col", priv->col_bit,
+			     XDDR_MAX_COL_CNT);
+	len = xddr_show_bits(data, len, "bank", priv->bank_bit,
+			     XDDR_MAX_BANK_CNT);
+	len = xddr_show_bits(data, len, "group", priv->grp_bit,
+			     XDDR_MAX_GRP_CNT);
+	len = xddr_show_bits(data, len, "rank", priv->rank_bit,
+			     XDDR_MAX_RANK_CNT);
+	len = xddr_show_bits(data, len, "lrank", priv->lrank_bit,
+			     XDDR_MAX_LRANK_CNT);
+
+	return xddr_show_bits(data, len, "channel", &priv->ch_bit, 1);
+}
+
+static DEVICE_ATTR_RO(addr_map);
+
+#ifdef CONFIG_EDAC_DEBUG
+/**
+ * xddr_phys_to_dram - Convert a physical address to its DRAM location.
+ * @priv:	DDR memory controller private instance data.
+ * @addr:	Physical address.
+ * @pinf:	ECC error info structure to fill.
+ * @channel:	Channel number of the address.
+ */
+static void xddr_phys_to_dram(struct xddr_edac_priv *priv, u64 addr,
+			      struct xddr_ecc_error_info *pinf, u32 *channel)
+{
+	u64 da = 0;
+	u32 chunk;
+
+	for (chunk = 0; chunk < XDDR_LUT_PA_CHUNKS; chunk++) {
+		da |= priv->lut->to_dram[chunk][addr & XDDR_LUT_CHUNK_MASK];
+		addr >>= XDDR_LUT_CHUNK_BITS;
+	}
+
+	pinf->row = FIELD_GET(XDDR_DA_ROW_MASK, da);
+	pinf->col = FIELD_GET(XDDR_DA_COL_MASK, da);
+	pinf->bank = FIELD_GET(XDDR_DA_BANK_MASK, da);
+	pinf->group = FIELD_GET(XDDR_DA_GRP_MASK, da);
+	pinf->rank = FIELD_GET(XDDR_DA_RANK_MASK, da);
+	pinf->lrank = FIELD_GET(XDDR_DA_LRANK_MASK, da);
+	pinf->burstpos = 0;
+	*channel = FIELD_GET(XDDR_DA_CH_MASK, da);
+}
+
 /**
  * ddr_poison_setup - Update poison registers.
  * @priv:	DDR memory controller private instance data.
@@ -794,40 +1093,10 @@ static int xddr_setup_irq(struct mem_ctl_info *mci,
  */
 static void xddr_poison_setup(struct xddr_edac_priv *priv)
 {
-	u32 col = 0, row = 0, bank = 0, grp = 0, rank = 0, lrank = 0, ch = 0;
-	u32 index, regval;
-
-	for (index = 0; index < XDDR_MAX_ROW_CNT; index++) {
-		row |= (((priv->err_inject_addr >> priv->row_bit[index]) &
-						BIT(0)) << index);
-	}
-
-	for (index = 0; index < XDDR_MAX_COL_CNT; index++) {
-		col |= (((priv->err_inject_addr >> priv->col_bit[index]) &
-						BIT(0)) << index);
-	}
-
-	for (index = 0; index < XDDR_MAX_BANK_CNT; index++) {
-		bank |= (((priv->err_inject_addr >> priv->bank_bit[index]) &
-						BIT(0)) << index);
-	}
-
-	for (index = 0; index < XDDR_MAX_GRP_CNT; index++) {
-		grp |= (((priv->err_inject_addr >> priv->grp_bit[index]) &
-						BIT(0)) << index);
-	}
-
-	for (index = 0; index < XDDR_MAX_RANK_CNT; index++) {
-		rank |= (((priv->err_inject_addr >> priv->rank_bit[index]) &
-						BIT(0)) << index);
-	}
-
-	for (index = 0; index < XDDR_MAX_LRANK_CNT; index++) {
-		lrank |= (((priv->err_inject_addr >> priv->lrank_bit[index]) &
-						BIT(0)) << index);
-	}
+	struct xddr_ecc_error_info pinf;
+	u32 ch, regval;
 
-	ch = (priv->err_inject_addr >> priv->ch_bit) & BIT(0);
+	xddr_phys_to_dram(priv, priv->err_inject_addr, &pinf, &ch);
 	if (ch)
 		writel(0xFF, priv->ddrmc_baseaddr + ECCW1_FLIP_CTRL);
 	else
@@ -836,15 +1105,17 @@ static void xddr_poison_setup(struct xddr_edac_priv *priv)
 	writel(0, priv->ddrmc_noc_baseaddr + XDDR_NOC_REG_ADEC12_OFFSET);
 	writel(0, priv->ddrmc_noc_baseaddr + XDDR_NOC_REG_ADEC13_OFFSET);
 
-	regval = (row & XDDR_NOC_ROW_MATCH_MASK);
-	regval |= (col << XDDR_NOC_COL_MATCH_SHIFT) & XDDR_NOC_COL_MATCH_MASK;
-	regval |= (bank << XDDR_NOC_BANK_MATCH_SHIFT) &
+	regval = (pinf.row & XDDR_NOC_ROW_MATCH_MASK);
+	regval |= (pinf.col << XDDR_NOC_COL_MATCH_SHIFT) &
+			XDDR_NOC_COL_MATCH_MASK;
+	regval |= (pinf.bank << XDDR_NOC_BANK_MATCH_SHIFT) &
 			XDDR_NOC_BANK_MATCH_MASK;
-	regval |= (grp << XDDR_NOC_GRP_MATCH_SHIFT) & XDDR_NOC_GRP_MATCH_MASK;
+	regval |= (pinf.group << XDDR_NOC_GRP_MATCH_SHIFT) &
+			XDDR_NOC_GRP_MATCH_MASK;
 	writel(regval, priv->ddrmc_noc_baseaddr + XDDR_NOC_REG_ADEC14_OFFSET);
 
-	regval = (rank & XDDR_NOC_RANK_MATCH_MASK);
-	regval |= (lrank << XDDR_NOC_LRANK_MATCH_SHIFT) &
+	regval = (pinf.rank & XDDR_NOC_RANK_MATCH_MASK);
+	regval |= (pinf.lrank << XDDR_NOC_LRANK_MATCH_SHIFT) &
 			XDDR_NOC_LRANK_MATCH_MASK;
 	regval |= (ch << XDDR_NOC_CH_MATCH_SHIFT) & XDDR_NOC_CH_MATCH_MASK;
 	regval |= (XDDR_NOC_MOD_SEL_MASK | XDDR_NOC_MATCH_EN_MASK);
@@ -952,6 +1223,7 @@ static void edac_remove_sysfs_attributes(struct mem_ctl_info *mci)
 	device_remove_file(&mci->dev, &dev_attr_inject_data_error);
 	device_remove_file(&mci->dev, &dev_attr_inject_data_poison);
 }
+#endif /* CONFIG_EDAC_DEBUG */
 
 static void xddr_setup_row_address_map(struct xddr_edac_priv *priv)
 {
@@ -1032,6 +1304,66 @@ static void xddr_setup_rank_lrank_address_map(struct xddr_edac_priv *priv)
 	priv->lrank_bit[2] = (regval & LRANK_2_MASK) >> LRANK_2_SHIFT;
 }
 
+static void xddr_fill_lut(u64 *lut)
+{
+	u32 val;
+
+	/* Single bit entries are set, combine them for the other values */
+	for (val = 1; val < XDDR_LUT_CHUNK_SIZE; val++)
+		lut[val] = lut[val & (val - 1)] | lut[val & -val];
+}
+
+/**
+ * xddr_setup_addr_lut - Build the address map lookup tables.
+ * @priv:	DDR memory controller private instance data.
+ *
+ * The address map being a bit permutation, every byte of an address
+ * translates independently and the conversions are reduced to one table
+ * lookup per byte.
+ */
+static void xddr_setup_addr_lut(struct xddr_edac_priv *priv)
+{
+	struct xddr_addr_lut *lut = priv->lut;
+	u32 shift[XDDR_DA_BITS];
+	u32 index, n = 0;
+
+	BUILD_BUG_ON(XDDR_MAX_ROW_CNT + XDDR_MAX_COL_CNT + XDDR_MAX_BANK_CNT +
+		     XDDR_MAX_GRP_CNT + XDDR_MAX_RANK_CNT +
+		     XDDR_MAX_LRANK_CNT + 1 != XDDR_DA_BITS);
+
+	for (index = 0; index < XDDR_MAX_ROW_CNT; index++)
+		shift[n++] = priv->row_bit[index];
+	for (index = 0; index < XDDR_MAX_COL_CNT; index++)
+		shift[n++] = priv->col_bit[index];
+	for (index = 0; index < XDDR_MAX_BANK_CNT; index++)
+		shift[n++] = priv->bank_bit[index];
+	for (index = 0; index < XDDR_MAX_GRP_CNT; index++)
+		shift[n++] = priv->grp_bit[index];
+	for (index = 0; index < XDDR_MAX_RANK_CNT; index++)
+		shift[n++] = priv->rank_bit[index];
+	for (index = 0; index < XDDR_MAX_LRANK_CNT; index++)
+		shift[n++] = priv->lrank_bit[index];
+	shift[n] = priv->ch_bit;
+
+	for (index = 0; index < XDDR_DA_BITS; index++) {
+		lut->to_phys[index / XDDR_LUT_CHUNK_BITS]
+			    [BIT(index % XDDR_LUT_CHUNK_BITS)] =
+			BIT_ULL(shift[index]);
+#ifdef CONFIG_EDAC_DEBUG
+		lut->to_dram[shift[index] / XDDR_LUT_CHUNK_BITS]
+			    [BIT(shift[index] % XDDR_LUT_CHUNK_BITS)] |=
+			BIT_ULL(index);
+#endif
+	}
+
+	for (index = 0; index < XDDR_LUT_DA_CHUNKS; index++)
+		xddr_fill_lut(lut->to_phys[index]);
+#ifdef CONFIG_EDAC_DEBUG
+	for (index = 0; index < XDDR_LUT_PA_CHUNKS; index++)
+		xddr_fill_lut(lut->to_dram[index]);
+#endif
+}
+
 /**
  * xddr_setup_address_map - Set Address Map by querying ADDRMAP registers.
  * @priv:	DDR memory controller private instance data.
@@ -1049,8 +1381,9 @@ static void xddr_setup_address_map(struct xddr_edac_priv *priv)
 	xddr_setup_bank_grp_ch_address_map(priv);
 
 	xddr_setup_rank_lrank_address_map(priv);
+
+	xddr_setup_addr_lut(priv);
 }
-#endif /* CONFIG_EDAC_DEBUG */
 
 /**
  * xddr_mc_probe - Check controller and bind driver.
@@ -1070,7 +1403,7 @@ static int xddr_mc_probe(struct platform_device *pdev)
 	struct resource *res;
 	int rc;
 	u8 num_chans, num_csrows;
-	u32 edac_mc_id, regval;
+	u32 edac_mc_id, regval, i;
 
 	res = platform_get_resource_byname(pdev, IORESOURCE_MEM, "ddrmc_base");
 	ddrmc_baseaddr = devm_ioremap_resource(&pdev->dev, res);
@@ -1120,11 +1453,26 @@ static int xddr_mc_probe(struct platform_device *pdev)
 	priv = mci->pvt_info;
 	priv->ddrmc_baseaddr = ddrmc_baseaddr;
 	priv->ddrmc_noc_baseaddr = ddrmc_noc_baseaddr;
+	priv->mci = mci;
 	priv->ce_cnt = 0;
 	priv->ue_cnt = 0;
+	spin_lock_init(&priv->lock);
+	INIT_DELAYED_WORK(&priv->work, xddr_err_work);
+	for (i = 0; i < XDDR_NR_RANKS; i++) {
+		ratelimit_state_init(&priv->ce_rs[i], HZ, XDDR_CE_DECODE_BURST);
+		ratelimit_set_flags(&priv->ce_rs[i], RATELIMIT_MSG_ON_RELEASE);
+	}
 
 	xddr_mc_init(mci, pdev);
 
+	priv->lut = devm_kzalloc(&pdev->dev, sizeof(*priv->lut), GFP_KERNEL);
+	if (!priv->lut) {
+		rc = -ENOMEM;
+		goto free_edac_mc;
+	}
+
+	xddr_setup_address_map(priv);
+
 	rc = xddr_setup_irq(mci, pdev);
 	if (rc)
 		goto free_edac_mc;
@@ -1136,14 +1484,16 @@ static int xddr_mc_probe(struct platform_device *pdev)
 		goto free_edac_mc;
 	}
 
+	if (device_create_file(&mci->dev, &dev_attr_addr_map))
+		edac_printk(KERN_ERR, EDAC_MC,
+			    "Failed to create addr_map sysfs entry\n");
+
 #ifdef CONFIG_EDAC_DEBUG
 	if (edac_create_sysfs_attributes(mci)) {
 		edac_printk(KERN_ERR, EDAC_MC,
 			    "Failed to create sysfs entries\n");
 		goto free_edac_mc;
 	}
-
-	xddr_setup_address_map(priv);
 #endif
 
 	return rc;
@@ -1165,11 +1515,17 @@ static int xddr_mc_remove(struct platform_device *pdev)
 	struct mem_ctl_info *mci = platform_get_drvdata(pdev);
 	struct xddr_edac_priv *priv = mci->pvt_info;
 
+	spin_lock_irq(&priv->lock);
+	priv->stopping = true;
 	xddr_disable_intr(priv);
+	spin_unlock_irq(&priv->lock);
+
+	cancel_delayed_work_sync(&priv->work);
 
 #ifdef CONFIG_EDAC_DEBUG
 	edac_remove_sysfs_attributes(mci);
 #endif
+	device_remove_file(&mci->dev, &dev_attr_addr_map);
 
 	edac_mc_del_mc(&pdev->dev);
 	edac_mc_free(mci);
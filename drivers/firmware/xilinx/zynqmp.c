@@ -13,11 +13,13 @@
 #include <linux/arm-smccc.h>
 #include <linux/compiler.h>
 #include <linux/device.h>
+#include <linux/hashtable.h>
 #include <linux/init.h>
 #include <linux/mfd/core.h>
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/of_platform.h>
+#include <linux/mutex.h>
 #include <linux/slab.h>
 #include <linux/uaccess.h>
 
@@ -31,6 +33,23 @@ static const struct zynqmp_eemi_ops *eemi_ops_tbl;
 static bool feature_check_enabled;
 static u32 zynqmp_pm_features[PM_API_MAX];
 
+#define ZYNQMP_PM_QUERY_CACHE_BITS	8
+
+/**
+ * struct zynqmp_pm_query_entry - Cached PM_QUERY_DATA response
+ * @node:	Entry in the query cache hashtable
+ * @qdata:	Query ID and arguments
+ * @payload:	Firmware response
+ */
+struct zynqmp_pm_query_entry {
+	struct hlist_node node;
+	struct zynqmp_pm_query_data qdata;
+	u32 payload[PAYLOAD_ARG_CNT];
+};
+
+static DEFINE_HASHTABLE(zynqmp_pm_query_cache, ZYNQMP_PM_QUERY_CACHE_BITS);
+static DEFINE_MUTEX(zynqmp_pm_query_lock);
+
 static const struct mfd_cell firmware_devs[] = {
 	{
 		.name = "zynqmp_power_controller",
@@ -328,8 +347,35 @@ static int get_set_conduit_method(struct device_node *np)
  */
 static int zynqmp_pm_query_data(struct zynqmp_pm_query_data qdata, u32 *out)
 {
+	struct zynqmp_pm_query_entry *entry;
+	bool cacheable;
+	u32 key;
 	int ret;
 
+	/*
+	 * The clock and pin control descriptions never change at runtime,
+	 * so only ask the firmware once. Further probes of the clock and
+	 * pin control drivers, e.g. after probe deferral or a rebind, are
+	 * served from the cache instead of a firmware call per query.
+	 */
+	cacheable = qdata.qid != PM_QID_INVALID &&
+		    qdata.qid <= PM_QID_CLOCK_GET_MAX_DIVISOR;
+	if (cacheable) {
+		key = qdata.qid ^ (qdata.arg1 << 8) ^ (qdata.arg2 << 16) ^
+		      (qdata.arg3 << 24);
+		mutex_lock(&zynqmp_pm_query_lock);
+		hash_for_each_possible(zynqmp_pm_query_cache, entry, node,
+				       key) {
+			if (!memcmp(&entry->qdata, &qdata, sizeof(qdata))) {
+				memcpy(out, entry->payload,
+				       sizeof(entry->payload));
+				mutex_unlock(&zynqmp_pm_query_lock);
+				return 0;
+			}
+		}
+		mutex_unlock(&zynqmp_pm_query_lock);
+	}
+
 	ret = zynqmp_pm_invoke_fn(PM_QUERY_DATA, qdata.qid, qdata.arg1,
 				  qdata.arg2, qdata.arg3, out);
 
@@ -338,7 +384,38 @@ static int zynqmp_pm_query_data(struct zynqmp_pm_query_data qdata, u32 *out)
 	 * characters and return code is always success. For invalid clocks,
 	 * clock name bytes would be zeros.
 	 */
-	return qdata.qid == PM_QID_CLOCK_GET_NAME ? 0 : ret;
+	if (qdata.qid == PM_QID_CLOCK_GET_NAME)
+		ret = 0;
+
+	if (cacheable && !ret) {
+		entry = kmalloc(sizeof(*entry), GFP_KERNEL);
+		if (entry) {
+			entry->qdata = qdata;
+			memcpy(entry->payload, out, sizeof(entry->payload));
+			mutex_lock(&zynqmp_pm_query_lock);
+			hash_add(zynqmp_pm_query_cache, &entry->node, key);
+			mutex_unlock(&zynqmp_pm_query_lock);
+		}
+	}
+
+	return ret;
+}
+
+/**
+ * zynqmp_pm_query_cache_free() - Free all cached PM_QUERY_DATA responses
+ */
+static void zynqmp_pm_query_cache_free(void)
+{
+	struct zynqmp_pm_query_entry *entry;
+	struct hlist_node *tmp;
+	int bkt;
+
+	mutex_lock(&zynqmp_pm_query_lock);
+	hash_for_each_safe(zynqmp_pm_query_cache, bkt, tmp, entry, node) {
+		hash_del(&entry->node);
+		kfree(entry);
+	}
+	mutex_unlock(&zynqmp_pm_query_lock);
 }
 
 /**
@@ -1754,6 +1831,7 @@ static int zynqmp_firmware_remove(struct platform_device *pdev)
 {
 	mfd_remove_devices(&pdev->dev);
 	zynqmp_pm_api_debugfs_exit();
+	zynqmp_pm_query_cache_free();
 
 	return 0;
 }
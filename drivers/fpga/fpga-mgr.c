@@ -23,6 +23,20 @@
 static DEFINE_IDA(fpga_mgr_ida);
 static struct class *fpga_mgr_class;
 
+/**
+ * struct fpga_mgr_image - FPGA image staged in memory
+ * @node:	entry in the manager images list
+ * @name:	firmware name of the image
+ * @buf:	image data
+ * @size:	size of the image in bytes
+ */
+struct fpga_mgr_image {
+	struct list_head node;
+	const char *name;
+	void *buf;
+	size_t size;
+};
+
 /**
  * fpga_image_info_alloc - Allocate a FPGA image info struct
  * @dev: owning device
@@ -340,6 +354,120 @@ static int fpga_dmabuf_load(struct fpga_manager *mgr,
 	return ret;
 }
 
+static struct fpga_mgr_image *fpga_mgr_image_find(struct fpga_manager *mgr,
+						  const char *image_name)
+{
+	struct fpga_mgr_image *image;
+
+	list_for_each_entry(image, &mgr->images, node) {
+		if (!strcmp(image->name, image_name))
+			return image;
+	}
+
+	return NULL;
+}
+
+static void fpga_mgr_image_free(struct fpga_mgr_image *image)
+{
+	list_del(&image->node);
+	kvfree(image->buf);
+	kfree_const(image->name);
+	kfree(image);
+}
+
+/**
+ * fpga_mgr_image_cache - stage a FPGA image in memory
+ * @mgr:	fpga manager
+ * @image_name:	name of image file on the firmware search path
+ *
+ * Request an FPGA image using the firmware class and keep it in memory.
+ * Later loads of @image_name through fpga_mgr_firmware_load(), such as the
+ * partial reconfigurations of a FPGA region, are programmed from the staged
+ * copy with no firmware request. The image is kept physically contiguous
+ * when possible, so that the low level driver can hand it to the hardware
+ * in place. Staging an image again replaces the previous copy.
+ *
+ * Return: 0 on success, negative error code otherwise.
+ */
+int fpga_mgr_image_cache(struct fpga_manager *mgr, const char *image_name)
+{
+	struct fpga_mgr_image *image, *old;
+	const struct firmware *fw;
+	int ret;
+
+	image = kzalloc(sizeof(*image), GFP_KERNEL);
+	if (!image)
+		return -ENOMEM;
+
+	image->name = kstrdup_const(image_name, GFP_KERNEL);
+	if (!image->name) {
+		ret = -ENOMEM;
+		goto err_free;
+	}
+
+	ret = request_firmware(&fw, image_name, &mgr->dev);
+	if (ret) {
+		dev_err(&mgr->dev, "Error requesting firmware %s\n",
+			image_name);
+		goto err_free;
+	}
+
+	image->buf = kvmalloc(fw->size, GFP_KERNEL);
+	if (!image->buf) {
+		release_firmware(fw);
+		ret = -ENOMEM;
+		goto err_free;
+	}
+
+	memcpy(image->buf, fw->data, fw->size);
+	image->size = fw->size;
+	release_firmware(fw);
+
+	mutex_lock(&mgr->images_lock);
+	old = fpga_mgr_image_find(mgr, image_name);
+	if (old)
+		fpga_mgr_image_free(old);
+	list_add_tail(&image->node, &mgr->images);
+	mutex_unlock(&mgr->images_lock);
+
+	return 0;
+
+err_free:
+	kfree_const(image->name);
+	kfree(image);
+	return ret;
+}
+EXPORT_SYMBOL_GPL(fpga_mgr_image_cache);
+
+/**
+ * fpga_mgr_image_uncache - release a FPGA image staged in memory
+ * @mgr:	fpga manager
+ * @image_name:	name of the staged image, NULL to release all the images
+ *
+ * Return: 0 on success, -ENOENT if @image_name isn't staged.
+ */
+int fpga_mgr_image_uncache(struct fpga_manager *mgr, const char *image_name)
+{
+	struct fpga_mgr_image *image, *tmp;
+	int ret = 0;
+
+	mutex_lock(&mgr->images_lock);
+	if (image_name) {
+		image = fpga_mgr_image_find(mgr, image_name);
+		if (image)
+			fpga_mgr_image_free(image);
+		else
+			ret = -ENOENT;
+	} else {
+		list_for_each_entry_safe(image, tmp, &mgr->images, node)
+			fpga_mgr_image_free(image);
+	}
+	mutex_unlock(&mgr->images_lock);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(fpga_mgr_image_uncache);
+
 /**
  * fpga_mgr_firmware_load - request firmware and load to fpga
  * @mgr:	fpga manager
@@ -347,6 +475,7 @@ static int fpga_dmabuf_load(struct fpga_manager *mgr,
  * @image_name:	name of image file on the firmware search path
  *
  * Request an FPGA image using the firmware class, then write out to the FPGA.
+ * Images staged with fpga_mgr_image_cache() are written out from memory.
  * Update the state before each step to provide info on what step failed if
  * there is a failure.  This code assumes the caller got the mgr pointer
  * from of_fpga_mgr_get() or fpga_mgr_get() and checked that it is not an error
@@ -359,17 +488,27 @@ static int fpga_mgr_firmware_load(struct fpga_manager *mgr,
 				  const char *image_name)
 {
 	struct device *dev = &mgr->dev;
+	struct fpga_mgr_image *image;
 	const struct firmware *fw;
 	int ret;
 
 	dev_info(dev, "writing %s to %s\n", image_name, mgr->name);
 
-	mgr->state = FPGA_MGR_STATE_FIRMWARE_REQ;
-
 	/* flags indicates whether to do full or partial reconfiguration */
 	info->flags = mgr->flags;
 	memcpy(info->key, mgr->key, ENCRYPTED_KEY_LEN);
 
+	mutex_lock(&mgr->images_lock);
+	image = fpga_mgr_image_find(mgr, image_name);
+	if (image) {
+		ret = fpga_mgr_buf_load(mgr, info, image->buf, image->size);
+		mutex_unlock(&mgr->images_lock);
+		return ret;
+	}
+	mutex_unlock(&mgr->images_lock);
+
+	mgr->state = FPGA_MGR_STATE_FIRMWARE_REQ;
+
 	ret = request_firmware(&fw, image_name, dev);
 	if (ret) {
 		mgr->state = FPGA_MGR_STATE_FIRMWARE_REQ_ERR;
@@ -516,6 +655,63 @@ static ssize_t firmware_store(struct device *dev,
 	return count;
 }
 
+static ssize_t cache_show(struct device *dev,
+			  struct device_attribute *attr, char *buf)
+{
+	struct fpga_manager *mgr = to_fpga_manager(dev);
+	struct fpga_mgr_image *image;
+	int len = 0;
+
+	mutex_lock(&mgr->images_lock);
+	list_for_each_entry(image, &mgr->images, node)
+		len += scnprintf(buf + len, PAGE_SIZE - len, "%s %zu\n",
+				 image->name, image->size);
+	mutex_unlock(&mgr->images_lock);
+
+	return len;
+}
+
+static ssize_t cache_store(struct device *dev,
+			   struct device_attribute *attr,
+			   const char *buf, size_t count)
+{
+	struct fpga_manager *mgr = to_fpga_manager(dev);
+	char image_name[NAME_MAX];
+	char *name;
+	int ret;
+
+	strscpy(image_name, buf, sizeof(image_name));
+	name = strim(image_name);
+	if (!name[0])
+		return -EINVAL;
+
+	ret = fpga_mgr_image_cache(mgr, name);
+	if (ret)
+		return ret;
+
+	return count;
+}
+
+static ssize_t uncache_store(struct device *dev,
+			     struct device_attribute *attr,
+			     const char *buf, size_t count)
+{
+	struct fpga_manager *mgr = to_fpga_manager(dev);
+	char image_name[NAME_MAX];
+	char *name;
+	int ret;
+
+	/* An empty name releases all the staged images */
+	strscpy(image_name, buf, sizeof(image_name));
+	name = strim(image_name);
+
+	ret = fpga_mgr_image_uncache(mgr, name[0] ? name : NULL);
+	if (ret)
+		return ret;
+
+	return count;
+}
+
 static ssize_t key_show(struct device *dev,
 			struct device_attribute *attr, char *buf)
 {
@@ -561,6 +757,8 @@ static DEVICE_ATTR_RO(name);
 static DEVICE_ATTR_RO(state);
 static DEVICE_ATTR_RO(status);
 static DEVICE_ATTR_WO(firmware);
+static DEVICE_ATTR_RW(cache);
+static DEVICE_ATTR_WO(uncache);
 static DEVICE_ATTR_RW(flags);
 static DEVICE_ATTR_RW(key);
 
@@ -569,6 +767,8 @@ static struct attribute *fpga_mgr_attrs[] = {
 	&dev_attr_state.attr,
 	&dev_attr_status.attr,
 	&dev_attr_firmware.attr,
+	&dev_attr_cache.attr,
+	&dev_attr_uncache.attr,
 	&dev_attr_flags.attr,
 	&dev_attr_key.attr,
 	NULL,
@@ -675,7 +875,20 @@ static int fpga_mgr_read(struct seq_file *s, void *data)
 
 static int fpga_mgr_read_open(struct inode *inode, struct file *file)
 {
-	return single_open(file, fpga_mgr_read, inode->i_private);
+	struct fpga_manager *mgr = inode->i_private;
+	size_t size = 0;
+
+	/*
+	 * seq_file runs fpga_mgr_read() again with a doubled buffer every
+	 * time the data overflows it. Allocate the buffer at once for large
+	 * readbacks rather than reading the FPGA back for every retry.
+	 */
+	if (mgr->mops->read_size)
+		size = mgr->mops->read_size(mgr);
+	if (size)
+		return single_open_size(file, fpga_mgr_read, mgr, size);
+
+	return single_open(file, fpga_mgr_read, mgr);
 }
 
 static const struct file_operations fpga_mgr_ops_image = {
@@ -815,6 +1028,8 @@ struct fpga_manager *fpga_mgr_create(struct device *dev, const char *name,
 	}
 
 	mutex_init(&mgr->ref_mutex);
+	mutex_init(&mgr->images_lock);
+	INIT_LIST_HEAD(&mgr->images);
 
 	mgr->name = name;
 	mgr->mops = mops;
@@ -994,6 +1209,8 @@ void fpga_mgr_unregister(struct fpga_manager *mgr)
 		mgr->mops->fpga_remove(mgr);
 
 	device_unregister(&mgr->dev);
+
+	fpga_mgr_image_uncache(mgr, NULL);
 }
 EXPORT_SYMBOL_GPL(fpga_mgr_unregister);
 
@@ -79,21 +79,8 @@ static void fpga_region_put(struct fpga_region *region)
 	mutex_unlock(&region->mutex);
 }
 
-/**
- * fpga_region_program_fpga - program FPGA
- *
- * @region: FPGA region
- *
- * Program an FPGA using fpga image info (region->info).
- * If the region has a get_bridges function, the exclusive reference for the
- * bridges will be held if programming succeeds.  This is intended to prevent
- * reprogramming the region until the caller considers it safe to do so.
- * The caller will need to call fpga_bridges_put() before attempting to
- * reprogram the region.
- *
- * Return 0 for success or negative error code.
- */
-int fpga_region_program_fpga(struct fpga_region *region)
+static int __fpga_region_program_fpga(struct fpga_region *region,
+				      bool wait_mgr)
 {
 	struct device *dev = &region->dev;
 	struct fpga_image_info *info = region->info;
@@ -105,10 +92,14 @@ int fpga_region_program_fpga(struct fpga_region *region)
 		return PTR_ERR(region);
 	}
 
-	ret = fpga_mgr_lock(region->mgr);
-	if (ret) {
-		dev_err(dev, "FPGA manager is busy\n");
-		goto err_put_region;
+	if (wait_mgr) {
+		mutex_lock(&region->mgr->ref_mutex);
+	} else {
+		ret = fpga_mgr_lock(region->mgr);
+		if (ret) {
+			dev_err(dev, "FPGA manager is busy\n");
+			goto err_put_region;
+		}
 	}
 
 	/*
@@ -156,8 +147,78 @@ int fpga_region_program_fpga(struct fpga_region *region)
 
 	return ret;
 }
+
+/**
+ * fpga_region_program_fpga - program FPGA
+ *
+ * @region: FPGA region
+ *
+ * Program an FPGA using fpga image info (region->info).
+ * If the region has a get_bridges function, the exclusive reference for the
+ * bridges will be held if programming succeeds.  This is intended to prevent
+ * reprogramming the region until the caller considers it safe to do so.
+ * The caller will need to call fpga_bridges_put() before attempting to
+ * reprogram the region.
+ *
+ * Return 0 for success or negative error code.
+ */
+int fpga_region_program_fpga(struct fpga_region *region)
+{
+	return __fpga_region_program_fpga(region, false);
+}
 EXPORT_SYMBOL_GPL(fpga_region_program_fpga);
 
+static void fpga_region_program_work(struct work_struct *work)
+{
+	struct fpga_region *region = container_of(work, struct fpga_region,
+						  program_work);
+	void (*complete)(struct fpga_region *region, int ret, void *data);
+	void *data;
+	int ret;
+
+	ret = __fpga_region_program_fpga(region, true);
+
+	complete = region->program_complete;
+	data = region->program_data;
+	atomic_set(&region->programming, 0);
+
+	if (complete)
+		complete(region, ret, data);
+}
+
+/**
+ * fpga_region_program_fpga_async - program FPGA without blocking
+ *
+ * @region: FPGA region
+ * @complete: optional function called with the programming result
+ * @data: data passed to @complete
+ *
+ * Queue the programming of an FPGA using fpga image info (region->info), as
+ * done by fpga_region_program_fpga(), and return immediately. @complete is
+ * called from a workqueue once the region is programmed, and may queue the
+ * next programming of the region. Regions programmed by different managers
+ * are programmed in parallel, regions sharing a manager wait for it in turn
+ * instead of failing with -EBUSY.
+ *
+ * Return 0 if the programming is queued, -EBUSY if an asynchronous
+ * programming of the region is already pending.
+ */
+int fpga_region_program_fpga_async(struct fpga_region *region,
+				   void (*complete)(struct fpga_region *region,
+						    int ret, void *data),
+				   void *data)
+{
+	if (atomic_cmpxchg(&region->programming, 0, 1))
+		return -EBUSY;
+
+	region->program_complete = complete;
+	region->program_data = data;
+	queue_work(system_unbound_wq, &region->program_work);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(fpga_region_program_fpga_async);
+
 static ssize_t compat_id_show(struct device *dev,
 			      struct device_attribute *attr, char *buf)
 {
@@ -211,6 +272,7 @@ struct fpga_region
 	region->get_bridges = get_bridges;
 	mutex_init(&region->mutex);
 	INIT_LIST_HEAD(&region->bridge_list);
+	INIT_WORK(&region->program_work, fpga_region_program_work);
 
 	device_initialize(&region->dev);
 	region->dev.class = fpga_region_class;
@@ -310,6 +372,7 @@ EXPORT_SYMBOL_GPL(fpga_region_register);
  */
 void fpga_region_unregister(struct fpga_region *region)
 {
+	flush_work(&region->program_work);
 	device_unregister(&region->dev);
 }
 EXPORT_SYMBOL_GPL(fpga_region_unregister);
@@ -457,6 +457,11 @@ static struct platform_driver of_fpga_region_driver = {
 	.driver = {
 		.name	= "of-fpga-region",
 		.of_match_table = of_match_ptr(fpga_region_of_match),
+		/*
+		 * Populating a region probes every IP block of its static
+		 * design, keep that off the boot path of the rest.
+		 */
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 };
 
@@ -9,6 +9,7 @@
 #include <linux/kernel.h>
 #include <linux/module.h>
 #include <linux/of_address.h>
+#include <linux/scatterlist.h>
 #include <linux/string.h>
 #include <linux/firmware/xlnx-zynqmp.h>
 
@@ -37,41 +38,87 @@ static int versal_fpga_ops_write_init(struct fpga_manager *mgr,
 	return 0;
 }
 
-static int versal_fpga_ops_write_sg(struct fpga_manager *mgr,
-				    struct sg_table *sgt)
+static unsigned long versal_fpga_get_contiguous_size(struct scatterlist *sgl,
+						     unsigned int nents)
 {
-	const struct zynqmp_eemi_ops *eemi_ops = zynqmp_pm_get_eemi_ops();
-	dma_addr_t dma_addr;
-	int ret;
-
-	if (IS_ERR_OR_NULL(eemi_ops) || !eemi_ops->fpga_load)
-		return -ENXIO;
-
-	dma_addr = sg_dma_address(sgt->sgl);
-	ret = eemi_ops->pdi_load(PDI_SOURCE_TYPE, dma_addr);
+	dma_addr_t expected = sg_dma_address(sgl);
+	unsigned long size = 0;
+	struct scatterlist *s;
+	unsigned int i;
+
+	for_each_sg(sgl, s, nents, i) {
+		if (sg_dma_address(s) != expected)
+			break;
+		expected = sg_dma_address(s) + sg_dma_len(s);
+		size += sg_dma_len(s);
+	}
 
-	return ret;
+	return size;
 }
 
-static int versal_fpga_ops_write(struct fpga_manager *mgr,
-				 const char *buf, size_t size)
+/*
+ * The PLM loads, decrypts and authenticates the PDI from a single region of
+ * the device address space. Map the pages of the PDI in place with the
+ * streaming DMA API, and only copy it to a coherent buffer when the mapping
+ * isn't contiguous. The same applies to dma-buf images, which are mapped by
+ * the FPGA manager core.
+ */
+static int versal_fpga_ops_write_sg(struct fpga_manager *mgr,
+				    struct sg_table *sgt)
 {
 	const struct zynqmp_eemi_ops *eemi_ops = zynqmp_pm_get_eemi_ops();
 	struct versal_fpga_priv *priv;
-	dma_addr_t dma_addr = 0;
+	unsigned long contig_size;
+	struct scatterlist *s;
+	dma_addr_t dma_addr;
+	unsigned int i;
+	size_t size = 0;
 	char *kbuf;
+	int nents;
 	int ret;
 
-	if (IS_ERR(eemi_ops) || !eemi_ops->pdi_load)
+	if (IS_ERR_OR_NULL(eemi_ops) || !eemi_ops->pdi_load)
 		return -ENXIO;
 
 	priv = mgr->priv;
 
+	if (priv->flags & FPGA_MGR_CONFIG_DMA_BUF) {
+		for_each_sg(sgt->sgl, s, sgt->nents, i)
+			size += sg_dma_len(s);
+
+		contig_size = versal_fpga_get_contiguous_size(sgt->sgl,
+							      sgt->nents);
+		if (contig_size == size)
+			return eemi_ops->pdi_load(PDI_SOURCE_TYPE,
+						  sg_dma_address(sgt->sgl));
+
+		goto copy;
+	}
+
+	for_each_sg(sgt->sgl, s, sgt->orig_nents, i)
+		size += s->length;
+
+	nents = dma_map_sg(priv->dev, sgt->sgl, sgt->orig_nents,
+			   DMA_TO_DEVICE);
+	if (nents) {
+		if (versal_fpga_get_contiguous_size(sgt->sgl, nents) == size) {
+			ret = eemi_ops->pdi_load(PDI_SOURCE_TYPE,
+						 sg_dma_address(sgt->sgl));
+			dma_unmap_sg(priv->dev, sgt->sgl, sgt->orig_nents,
+				     DMA_TO_DEVICE);
+			return ret;
+		}
+
+		dma_unmap_sg(priv->dev, sgt->sgl, sgt->orig_nents,
+			     DMA_TO_DEVICE);
+	}
+
+copy:
 	kbuf = dma_alloc_coherent(priv->dev, size, &dma_addr, GFP_KERNEL);
 	if (!kbuf)
 		return -ENOMEM;
 
-	memcpy(kbuf, buf, size);
+	sg_copy_to_buffer(sgt->sgl, sgt->orig_nents, kbuf, size);
 
 	wmb(); /* ensure all writes are done before initiate FW call */
 
@@ -96,7 +143,6 @@ static enum fpga_mgr_states versal_fpga_ops_state(struct fpga_manager *mgr)
 static const struct fpga_manager_ops versal_fpga_ops = {
 	.state = versal_fpga_ops_state,
 	.write_init = versal_fpga_ops_write_init,
-	.write = versal_fpga_ops_write,
 	.write_sg = versal_fpga_ops_write_sg,
 	.write_complete = versal_fpga_ops_write_complete,
 };
@@ -9,6 +9,7 @@
 #include <linux/kernel.h>
 #include <linux/module.h>
 #include <linux/of_address.h>
+#include <linux/scatterlist.h>
 #include <linux/seq_file.h>
 #include <linux/string.h>
 #include <linux/firmware/xlnx-zynqmp.h>
@@ -32,6 +33,8 @@
 #define IXR_FPGA_CONFIG_STAT_OFFSET	7U
 #define IXR_FPGA_READ_CONFIG_TYPE	0U
 
+#define ZYNQMP_FPGA_CFGDATA_HEADER	"zynqMP FPGA Configuration data contents are\n"
+
 static bool readback_type;
 module_param(readback_type, bool, 0644);
 MODULE_PARM_DESC(readback_type,
@@ -95,70 +98,15 @@ static int zynqmp_fpga_ops_write_init(struct fpga_manager *mgr,
 	return 0;
 }
 
-static int zynqmp_fpga_ops_write(struct fpga_manager *mgr,
-				 const char *buf, size_t size)
-{
-	const struct zynqmp_eemi_ops *eemi_ops = zynqmp_pm_get_eemi_ops();
-	struct zynqmp_fpga_priv *priv;
-	dma_addr_t dma_addr = 0;
-	u32 eemi_flags = 0;
-	size_t dma_size;
-	char *kbuf;
-	int ret;
-
-	if (IS_ERR_OR_NULL(eemi_ops) || !eemi_ops->fpga_load)
-		return -ENXIO;
-
-	priv = mgr->priv;
-	priv->size = size;
-
-	if (priv->flags & FPGA_MGR_USERKEY_ENCRYPTED_BITSTREAM)
-		dma_size = size + ENCRYPTED_KEY_LEN;
-	else
-		dma_size = size;
-
-	kbuf = dma_alloc_coherent(priv->dev, dma_size, &dma_addr, GFP_KERNEL);
-	if (!kbuf)
-		return -ENOMEM;
-
-	memcpy(kbuf, buf, size);
-
-	if (priv->flags & FPGA_MGR_USERKEY_ENCRYPTED_BITSTREAM) {
-		eemi_flags |= XILINX_ZYNQMP_PM_FPGA_ENCRYPTION_USERKEY;
-		memcpy(kbuf + size, mgr->key, ENCRYPTED_KEY_LEN);
-	} else if (priv->flags & FPGA_MGR_ENCRYPTED_BITSTREAM) {
-		eemi_flags |= XILINX_ZYNQMP_PM_FPGA_ENCRYPTION_DEVKEY;
-	}
-
-	wmb(); /* ensure all writes are done before initiate FW call */
-
-	if (priv->flags & FPGA_MGR_DDR_MEM_AUTH_BITSTREAM)
-		eemi_flags |= XILINX_ZYNQMP_PM_FPGA_AUTHENTICATION_DDR;
-	else if (priv->flags & FPGA_MGR_SECURE_MEM_AUTH_BITSTREAM)
-		eemi_flags |= XILINX_ZYNQMP_PM_FPGA_AUTHENTICATION_OCM;
-
-	if (priv->flags & FPGA_MGR_PARTIAL_RECONFIG)
-		eemi_flags |= XILINX_ZYNQMP_PM_FPGA_PARTIAL;
-
-	if (priv->flags & FPGA_MGR_USERKEY_ENCRYPTED_BITSTREAM)
-		ret = eemi_ops->fpga_load(dma_addr, dma_addr + size,
-					  eemi_flags);
-	else
-		ret = eemi_ops->fpga_load(dma_addr, size, eemi_flags);
-
-	dma_free_coherent(priv->dev, dma_size, kbuf, dma_addr);
-
-	return ret;
-}
-
-static unsigned long zynqmp_fpga_get_contiguous_size(struct sg_table *sgt)
+static unsigned long zynqmp_fpga_get_contiguous_size(struct scatterlist *sgl,
+						     unsigned int nents)
 {
-	dma_addr_t expected = sg_dma_address(sgt->sgl);
+	dma_addr_t expected = sg_dma_address(sgl);
 	unsigned long size = 0;
 	struct scatterlist *s;
 	unsigned int i;
 
-	for_each_sg(sgt->sgl, s, sgt->nents, i) {
+	for_each_sg(sgl, s, nents, i) {
 		if (sg_dma_address(s) != expected)
 			break;
 		expected = sg_dma_address(s) + sg_dma_len(s);
@@ -168,24 +116,17 @@ static unsigned long zynqmp_fpga_get_contiguous_size(struct sg_table *sgt)
 	return size;
 }
 
-static int zynqmp_fpga_ops_write_sg(struct fpga_manager *mgr,
-				    struct sg_table *sgt)
+static int zynqmp_fpga_load(struct fpga_manager *mgr, dma_addr_t dma_addr,
+			    size_t size)
 {
 	const struct zynqmp_eemi_ops *eemi_ops = zynqmp_pm_get_eemi_ops();
-	dma_addr_t dma_addr, key_addr = 0;
-	struct zynqmp_fpga_priv *priv;
-	unsigned long contig_size;
+	struct zynqmp_fpga_priv *priv = mgr->priv;
+	dma_addr_t key_addr = 0;
 	u32 eemi_flags = 0;
 	char *kbuf;
 	int ret;
 
-	if (IS_ERR_OR_NULL(eemi_ops) || !eemi_ops->fpga_load)
-		return -ENXIO;
-
-	priv = mgr->priv;
-
-	dma_addr = sg_dma_address(sgt->sgl);
-	contig_size = zynqmp_fpga_get_contiguous_size(sgt);
+	priv->size = size;
 
 	if (priv->flags & FPGA_MGR_PARTIAL_RECONFIG)
 		eemi_flags |= XILINX_ZYNQMP_PM_FPGA_PARTIAL;
@@ -207,9 +148,84 @@ static int zynqmp_fpga_ops_write_sg(struct fpga_manager *mgr,
 		ret = eemi_ops->fpga_load(dma_addr, key_addr, eemi_flags);
 		dma_free_coherent(priv->dev, ENCRYPTED_KEY_LEN, kbuf, key_addr);
 	} else {
-		ret = eemi_ops->fpga_load(dma_addr, contig_size, eemi_flags);
+		ret = eemi_ops->fpga_load(dma_addr, size, eemi_flags);
+	}
+
+	return ret;
+}
+
+/*
+ * The firmware loads, decrypts and authenticates the bitstream from a single
+ * region of the device address space, and can't be handed the image in
+ * several chunks. Map the pages of the image in place with the streaming DMA
+ * API, which succeeds without any copy when they are physically contiguous
+ * or merged by an IOMMU. Only when the mapping is scattered, the image is
+ * copied to a coherent buffer. The same applies to dma-buf images, which are
+ * mapped by the FPGA manager core.
+ */
+static int zynqmp_fpga_ops_write_sg(struct fpga_manager *mgr,
+				    struct sg_table *sgt)
+{
+	const struct zynqmp_eemi_ops *eemi_ops = zynqmp_pm_get_eemi_ops();
+	struct zynqmp_fpga_priv *priv;
+	unsigned long contig_size;
+	struct scatterlist *s;
+	dma_addr_t dma_addr;
+	unsigned int i;
+	size_t size = 0;
+	char *kbuf;
+	int nents;
+	int ret;
+
+	if (IS_ERR_OR_NULL(eemi_ops) || !eemi_ops->fpga_load)
+		return -ENXIO;
+
+	priv = mgr->priv;
+
+	if (priv->flags & FPGA_MGR_CONFIG_DMA_BUF) {
+		for_each_sg(sgt->sgl, s, sgt->nents, i)
+			size += sg_dma_len(s);
+
+		contig_size = zynqmp_fpga_get_contiguous_size(sgt->sgl,
+							      sgt->nents);
+		if (contig_size == size)
+			return zynqmp_fpga_load(mgr, sg_dma_address(sgt->sgl),
+						size);
+
+		goto copy;
 	}
 
+	for_each_sg(sgt->sgl, s, sgt->orig_nents, i)
+		size += s->length;
+
+	nents = dma_map_sg(priv->dev, sgt->sgl, sgt->orig_nents,
+			   DMA_TO_DEVICE);
+	if (nents) {
+		if (zynqmp_fpga_get_contiguous_size(sgt->sgl, nents) == size) {
+			ret = zynqmp_fpga_load(mgr, sg_dma_address(sgt->sgl),
+					       size);
+			dma_unmap_sg(priv->dev, sgt->sgl, sgt->orig_nents,
+				     DMA_TO_DEVICE);
+			return ret;
+		}
+
+		dma_unmap_sg(priv->dev, sgt->sgl, sgt->orig_nents,
+			     DMA_TO_DEVICE);
+	}
+
+copy:
+	kbuf = dma_alloc_coherent(priv->dev, size, &dma_addr, GFP_KERNEL);
+	if (!kbuf)
+		return -ENOMEM;
+
+	sg_copy_to_buffer(sgt->sgl, sgt->orig_nents, kbuf, size);
+
+	wmb(); /* ensure all writes are done before initiate FW call */
+
+	ret = zynqmp_fpga_load(mgr, dma_addr, size);
+
+	dma_free_coherent(priv->dev, size, kbuf, dma_addr);
+
 	return ret;
 }
 
@@ -328,7 +344,7 @@ static int zynqmp_fpga_read_cfgdata(struct fpga_manager *mgr,
 	if (!buf)
 		return -ENOMEM;
 
-	seq_puts(s, "zynqMP FPGA Configuration data contents are\n");
+	seq_puts(s, ZYNQMP_FPGA_CFGDATA_HEADER);
 	ret = eemi_ops->fpga_read((priv->size + DUMMY_FRAMES_SIZE) / 4,
 				  dma_addr, readback_type, &data_offset);
 	if (ret)
@@ -342,6 +358,16 @@ static int zynqmp_fpga_read_cfgdata(struct fpga_manager *mgr,
 	return ret;
 }
 
+static size_t zynqmp_fpga_ops_read_size(struct fpga_manager *mgr)
+{
+	struct zynqmp_fpga_priv *priv = mgr->priv;
+
+	if (!readback_type)
+		return 0;
+
+	return sizeof(ZYNQMP_FPGA_CFGDATA_HEADER) + priv->size;
+}
+
 static int zynqmp_fpga_ops_read(struct fpga_manager *mgr, struct seq_file *s)
 {
 	const struct zynqmp_eemi_ops *eemi_ops = zynqmp_pm_get_eemi_ops();
@@ -362,10 +388,10 @@ static const struct fpga_manager_ops zynqmp_fpga_ops = {
 	.state = zynqmp_fpga_ops_state,
 	.status = zynqmp_fpga_ops_status,
 	.write_init = zynqmp_fpga_ops_write_init,
-	.write = zynqmp_fpga_ops_write,
 	.write_sg = zynqmp_fpga_ops_write_sg,
 	.write_complete = zynqmp_fpga_ops_write_complete,
 	.read = zynqmp_fpga_ops_read,
+	.read_size = zynqmp_fpga_ops_read_size,
 };
 
 static int zynqmp_fpga_probe(struct platform_device *pdev)
@@ -100,6 +100,32 @@ static int xgpio_get(struct gpio_chip *gc, unsigned int gpio)
 	return !!(xgpio_readreg(regs + XGPIO_DATA_OFFSET) & BIT(gpio));
 }
 
+/**
+ * xgpio_get_multiple - Read the specified signals of the GPIO device.
+ * @gc:     Pointer to gpio_chip device structure.
+ * @mask:   Mask of the GPIOS to read.
+ * @bits:   Value read from each GPIO
+ *
+ * This function reads all the requested signals with a single read of the
+ * channel data register.
+ *
+ * Return: 0 always
+ */
+static int xgpio_get_multiple(struct gpio_chip *gc, unsigned long *mask,
+			      unsigned long *bits)
+{
+	struct of_mm_gpio_chip *mm_gc = to_of_mm_gpio_chip(gc);
+	struct xgpio_instance *chip =
+	    container_of(mm_gc, struct xgpio_instance, mmchip);
+	void __iomem *regs = mm_gc->regs + chip->offset;
+	u32 val;
+
+	val = xgpio_readreg(regs + XGPIO_DATA_OFFSET);
+	*bits = (*bits & ~*mask) | (val & *mask);
+
+	return 0;
+}
+
 /**
  * xgpio_set - Write the specified signal of the GPIO device.
  * @gc:     Pointer to gpio_chip device structure.
@@ -148,21 +174,11 @@ static void xgpio_set_multiple(struct gpio_chip *gc, unsigned long *mask,
 	struct xgpio_instance *chip =
 	    container_of(mm_gc, struct xgpio_instance, mmchip);
 	void __iomem *regs = mm_gc->regs;
-	int i;
 
 	spin_lock_irqsave(&chip->gpio_lock, flags);
 
 	/* Write to GPIO signals */
-	for (i = 0; i < gc->ngpio; i++) {
-		if (*mask == 0)
-			break;
-		if (__test_and_clear_bit(i, mask)) {
-			if (test_bit(i, bits))
-				chip->gpio_state |= BIT(i);
-			else
-				chip->gpio_state &= ~BIT(i);
-		}
-	}
+	chip->gpio_state = (chip->gpio_state & ~*mask) | (*bits & *mask);
 
 	xgpio_writereg(regs + chip->offset + XGPIO_DATA_OFFSET,
 		       chip->gpio_state);
@@ -646,6 +662,7 @@ static int xgpio_of_probe(struct platform_device *pdev)
 	chip->mmchip.gc.direction_output = xgpio_dir_out;
 	chip->mmchip.gc.get = xgpio_get;
 	chip->mmchip.gc.set = xgpio_set;
+	chip->mmchip.gc.get_multiple = xgpio_get_multiple;
 	chip->mmchip.gc.request = xgpio_request;
 	chip->mmchip.gc.free = xgpio_free;
 	chip->mmchip.gc.set_multiple = xgpio_set_multiple;
@@ -735,6 +752,7 @@ static int xgpio_of_probe(struct platform_device *pdev)
 		chip_dual->mmchip.gc.direction_output = xgpio_dir_out;
 		chip_dual->mmchip.gc.get = xgpio_get;
 		chip_dual->mmchip.gc.set = xgpio_set;
+		chip_dual->mmchip.gc.get_multiple = xgpio_get_multiple;
 		chip_dual->mmchip.gc.request = xgpio_request;
 		chip_dual->mmchip.gc.free = xgpio_free;
 		chip_dual->mmchip.gc.set_multiple = xgpio_set_multiple;
@@ -213,6 +213,34 @@ static inline void zynq_gpio_get_bank_pin(unsigned int pin_num,
 	*bank_pin_num = 0;
 }
 
+/**
+ * zynq_gpio_read_bank - Read the input state of all the pins of a bank
+ * @gpio:	gpio device data structure
+ * @bank_num:	bank to be read
+ *
+ * Return: the state of the bank pins, one bit per pin.
+ */
+static u32 zynq_gpio_read_bank(struct zynq_gpio *gpio, unsigned int bank_num)
+{
+	if (gpio_data_ro_bug(gpio)) {
+		if (zynq_gpio_is_zynq(gpio)) {
+			if (bank_num <= 1)
+				return readl_relaxed(gpio->base_addr +
+					ZYNQ_GPIO_DATA_RO_OFFSET(bank_num));
+			return readl_relaxed(gpio->base_addr +
+					ZYNQ_GPIO_DATA_OFFSET(bank_num));
+		}
+		if (bank_num <= 2)
+			return readl_relaxed(gpio->base_addr +
+					ZYNQ_GPIO_DATA_RO_OFFSET(bank_num));
+		return readl_relaxed(gpio->base_addr +
+				ZYNQ_GPIO_DATA_OFFSET(bank_num));
+	}
+
+	return readl_relaxed(gpio->base_addr +
+			ZYNQ_GPIO_DATA_RO_OFFSET(bank_num));
+}
+
 /**
  * zynq_gpio_get_value - Get the state of the specified pin of GPIO device
  * @chip:	gpio_chip instance to be worked on
@@ -224,35 +252,47 @@ static inline void zynq_gpio_get_bank_pin(unsigned int pin_num,
  */
 static int zynq_gpio_get_value(struct gpio_chip *chip, unsigned int pin)
 {
-	u32 data;
 	unsigned int bank_num, bank_pin_num;
 	struct zynq_gpio *gpio = gpiochip_get_data(chip);
 
 	zynq_gpio_get_bank_pin(pin, &bank_num, &bank_pin_num, gpio);
 
-	if (gpio_data_ro_bug(gpio)) {
-		if (zynq_gpio_is_zynq(gpio)) {
-			if (bank_num <= 1) {
-				data = readl_relaxed(gpio->base_addr +
-					ZYNQ_GPIO_DATA_RO_OFFSET(bank_num));
-			} else {
-				data = readl_relaxed(gpio->base_addr +
-					ZYNQ_GPIO_DATA_OFFSET(bank_num));
-			}
-		} else {
-			if (bank_num <= 2) {
-				data = readl_relaxed(gpio->base_addr +
-					ZYNQ_GPIO_DATA_RO_OFFSET(bank_num));
-			} else {
-				data = readl_relaxed(gpio->base_addr +
-					ZYNQ_GPIO_DATA_OFFSET(bank_num));
-			}
+	return (zynq_gpio_read_bank(gpio, bank_num) >> bank_pin_num) & 1;
+}
+
+/**
+ * zynq_gpio_get_multiple - Get the state of multiple pins of GPIO device
+ * @chip:	gpio_chip instance to be worked on
+ * @mask:	bitmap of the pins to be read
+ * @bits:	bitmap to return the state of the pins
+ *
+ * This function reads each bank holding a requested pin only once.
+ *
+ * Return: 0 always
+ */
+static int zynq_gpio_get_multiple(struct gpio_chip *chip, unsigned long *mask,
+				  unsigned long *bits)
+{
+	struct zynq_gpio *gpio = gpiochip_get_data(chip);
+	unsigned int bank_num, pin, min, max;
+	u32 data;
+
+	for (bank_num = 0; bank_num < gpio->p_data->max_bank; bank_num++) {
+		min = gpio->p_data->bank_min[bank_num];
+		max = gpio->p_data->bank_max[bank_num];
+
+		pin = find_next_bit(mask, max + 1, min);
+		if (pin <= max) {
+			data = zynq_gpio_read_bank(gpio, bank_num);
+			for_each_set_bit_from(pin, mask, max + 1)
+				__assign_bit(pin, bits, data & BIT(pin - min));
 		}
-	} else {
-		data = readl_relaxed(gpio->base_addr +
-			ZYNQ_GPIO_DATA_RO_OFFSET(bank_num));
+
+		if (gpio->p_data->quirks & GPIO_QUIRK_VERSAL)
+			bank_num = bank_num + VERSAL_UNUSED_BANKS;
 	}
-	return (data >> bank_pin_num) & 1;
+
+	return 0;
 }
 
 /**
@@ -292,6 +332,55 @@ static void zynq_gpio_set_value(struct gpio_chip *chip, unsigned int pin,
 	writel_relaxed(state, gpio->base_addr + reg_offset);
 }
 
+/**
+ * zynq_gpio_set_multiple - Modify the state of multiple pins of GPIO device
+ * @chip:	gpio_chip instance to be worked on
+ * @mask:	bitmap of the pins to be modified
+ * @bits:	bitmap of the values used to modify the pins
+ *
+ * This function updates the requested pins of each 16 bit half of a bank
+ * with a single write to its mask/data register.
+ */
+static void zynq_gpio_set_multiple(struct gpio_chip *chip,
+				   unsigned long *mask, unsigned long *bits)
+{
+	struct zynq_gpio *gpio = gpiochip_get_data(chip);
+	unsigned int bank_num, pin, min, max;
+	u32 lo_mask, hi_mask, data;
+
+	for (bank_num = 0; bank_num < gpio->p_data->max_bank; bank_num++) {
+		min = gpio->p_data->bank_min[bank_num];
+		max = gpio->p_data->bank_max[bank_num];
+
+		data = 0;
+		lo_mask = 0;
+		pin = min;
+		for_each_set_bit_from(pin, mask, max + 1) {
+			lo_mask |= BIT(pin - min);
+			if (test_bit(pin, bits))
+				data |= BIT(pin - min);
+		}
+
+		/* the upper 16 bits of the register mask out the data bits */
+		hi_mask = lo_mask >> ZYNQ_GPIO_MID_PIN_NUM;
+		lo_mask &= ~ZYNQ_GPIO_UPPER_MASK;
+		if (lo_mask)
+			writel_relaxed((~lo_mask << ZYNQ_GPIO_MID_PIN_NUM) |
+				       (data & lo_mask),
+				       gpio->base_addr +
+				       ZYNQ_GPIO_DATA_LSW_OFFSET(bank_num));
+		data >>= ZYNQ_GPIO_MID_PIN_NUM;
+		if (hi_mask)
+			writel_relaxed((~hi_mask << ZYNQ_GPIO_MID_PIN_NUM) |
+				       (data & hi_mask),
+				       gpio->base_addr +
+				       ZYNQ_GPIO_DATA_MSW_OFFSET(bank_num));
+
+		if (gpio->p_data->quirks & GPIO_QUIRK_VERSAL)
+			bank_num = bank_num + VERSAL_UNUSED_BANKS;
+	}
+}
+
 /**
  * zynq_gpio_dir_in - Set the direction of the specified GPIO pin as input
  * @chip:	gpio_chip instance to be worked on
@@ -926,6 +1015,8 @@ static int zynq_gpio_probe(struct platform_device *pdev)
 	chip->parent = &pdev->dev;
 	chip->get = zynq_gpio_get_value;
 	chip->set = zynq_gpio_set_value;
+	chip->get_multiple = zynq_gpio_get_multiple;
+	chip->set_multiple = zynq_gpio_set_multiple;
 	chip->request = zynq_gpio_request;
 	chip->free = zynq_gpio_free;
 	chip->direction_input = zynq_gpio_dir_in;
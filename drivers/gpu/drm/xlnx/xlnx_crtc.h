@@ -30,6 +30,9 @@
  * @get_format: Get the current format of CRTC device
  * @get_cursor_width: Get the cursor width
  * @get_cursor_height: Get the cursor height
+ * @wait_for_flip: Wait until the buffers replaced by the last commit are
+ *	released by the hardware. Optional. Return 0 on success, or an error
+ *	to make the commit fall back to waiting for the vblank.
  */
 struct xlnx_crtc {
 	struct drm_crtc crtc;
@@ -41,6 +44,7 @@ struct xlnx_crtc {
 	uint32_t (*get_format)(struct xlnx_crtc *crtc);
 	uint32_t (*get_cursor_width)(struct xlnx_crtc *crtc);
 	uint32_t (*get_cursor_height)(struct xlnx_crtc *crtc);
+	int (*wait_for_flip)(struct xlnx_crtc *crtc);
 };
 
 /*
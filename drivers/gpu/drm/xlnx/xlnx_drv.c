@@ -32,6 +32,7 @@
 #include <linux/module.h>
 #include <linux/of_graph.h>
 #include <linux/platform_device.h>
+#include <linux/sizes.h>
 
 #include "xlnx_bridge.h"
 #include "xlnx_crtc.h"
@@ -50,6 +51,11 @@ module_param_named(fbdev_vres, xlnx_fbdev_vres, uint, 0444);
 MODULE_PARM_DESC(fbdev_vres,
 		 "fbdev virtual resolution multiplier for fb (default: 2)");
 
+static uint xlnx_gem_pool_size = 32;
+module_param_named(gem_pool_size, xlnx_gem_pool_size, uint, 0444);
+MODULE_PARM_DESC(gem_pool_size,
+		 "max size in MB of freed buffers kept for reuse (default: 32)");
+
 /**
  * struct xlnx_drm - Xilinx DRM private data
  * @drm: DRM core
@@ -57,6 +63,7 @@ MODULE_PARM_DESC(fbdev_vres,
  * @fb: DRM fb helper
  * @master: logical master device for pipeline
  * @suspend_state: atomic state for suspend / resume
+ * @gem_pool: pool of freed GEM buffers for reuse
  * @master_count: Counter to track number of fake master instances
  */
 struct xlnx_drm {
@@ -65,6 +72,7 @@ struct xlnx_drm {
 	struct drm_fb_helper *fb;
 	struct platform_device *master;
 	struct drm_atomic_state *suspend_state;
+	struct xlnx_gem_pool *gem_pool;
 	u32 master_count;
 };
 
@@ -81,6 +89,19 @@ struct xlnx_crtc_helper *xlnx_get_crtc_helper(struct drm_device *drm)
 	return xlnx_drm->crtc;
 }
 
+/**
+ * xlnx_get_gem_pool - Return the GEM buffer pool
+ * @drm: DRM device
+ *
+ * Return: the GEM buffer pool, or NULL if buffers are not pooled
+ */
+struct xlnx_gem_pool *xlnx_get_gem_pool(struct drm_device *drm)
+{
+	struct xlnx_drm *xlnx_drm = drm->dev_private;
+
+	return xlnx_drm->gem_pool;
+}
+
 /**
  * xlnx_get_align - Return the align requirement through CRTC helper
  * @drm: DRM device
@@ -122,6 +143,57 @@ static const struct drm_mode_config_funcs xlnx_mode_config_funcs = {
 	.atomic_commit		= drm_atomic_helper_commit,
 };
 
+/**
+ * xlnx_wait_for_flips - Wait for the old buffers to be released
+ * @state: atomic state of the commit
+ *
+ * Wait on the flip completion of each active CRTC in @state instead of the
+ * next vblank. This lets the commit release the old framebuffers as soon as
+ * the hardware stops fetching them.
+ *
+ * Return: true if all CRTCs completed the flip, or false if the caller needs
+ * to wait for the vblanks.
+ */
+static bool xlnx_wait_for_flips(struct drm_atomic_state *state)
+{
+	struct drm_crtc_state *crtc_state;
+	struct drm_crtc *crtc;
+	struct xlnx_crtc *xlnx_crtc;
+	unsigned int i;
+
+	for_each_new_crtc_in_state(state, crtc, crtc_state, i) {
+		if (!crtc_state->active)
+			continue;
+
+		xlnx_crtc = to_xlnx_crtc(crtc);
+		if (!xlnx_crtc->wait_for_flip ||
+		    xlnx_crtc->wait_for_flip(xlnx_crtc))
+			return false;
+	}
+
+	return true;
+}
+
+static void xlnx_atomic_commit_tail(struct drm_atomic_state *state)
+{
+	struct drm_device *drm = state->dev;
+
+	drm_atomic_helper_commit_modeset_disables(drm, state);
+	drm_atomic_helper_commit_planes(drm, state, 0);
+	drm_atomic_helper_commit_modeset_enables(drm, state);
+	drm_atomic_helper_fake_vblank(state);
+	drm_atomic_helper_commit_hw_done(state);
+
+	if (!xlnx_wait_for_flips(state))
+		drm_atomic_helper_wait_for_vblanks(drm, state);
+
+	drm_atomic_helper_cleanup_planes(drm, state);
+}
+
+static const struct drm_mode_config_helper_funcs xlnx_mode_config_helpers = {
+	.atomic_commit_tail	= xlnx_atomic_commit_tail,
+};
+
 static void xlnx_mode_config_init(struct drm_device *drm)
 {
 	struct xlnx_drm *xlnx_drm = drm->dev_private;
@@ -203,7 +275,7 @@ static struct drm_driver xlnx_drm_driver = {
 	.gem_prime_vmap			= drm_gem_cma_prime_vmap,
 	.gem_prime_vunmap		= drm_gem_cma_prime_vunmap,
 	.gem_prime_mmap			= drm_gem_cma_prime_mmap,
-	.gem_free_object		= drm_gem_cma_free_object,
+	.gem_free_object		= xlnx_gem_cma_free_object,
 	.gem_vm_ops			= &drm_gem_cma_vm_ops,
 	.dumb_create			= xlnx_gem_cma_dumb_create,
 	.dumb_destroy			= drm_gem_dumb_destroy,
@@ -239,6 +311,7 @@ static int xlnx_bind(struct device *dev)
 
 	drm_mode_config_init(drm);
 	drm->mode_config.funcs = &xlnx_mode_config_funcs;
+	drm->mode_config.helper_private = &xlnx_mode_config_helpers;
 
 	ret = drm_vblank_init(drm, 1);
 	if (ret) {
@@ -250,6 +323,9 @@ static int xlnx_bind(struct device *dev)
 	drm->dev_private = xlnx_drm;
 	xlnx_drm->drm = drm;
 	xlnx_drm->master = master;
+	xlnx_drm->gem_pool = xlnx_gem_pool_init(drm,
+						(size_t)xlnx_gem_pool_size *
+						SZ_1M);
 	drm_kms_helper_poll_init(drm);
 	platform_set_drvdata(master, xlnx_drm);
 
@@ -299,6 +375,7 @@ static int xlnx_bind(struct device *dev)
 	xlnx_crtc_helper_fini(drm, xlnx_drm->crtc);
 err_xlnx_drm:
 	drm_mode_config_cleanup(drm);
+	xlnx_gem_pool_fini(drm, xlnx_drm->gem_pool);
 err_drm:
 	drm_dev_put(drm);
 	return ret;
@@ -316,6 +393,7 @@ static void xlnx_unbind(struct device *dev)
 	xlnx_crtc_helper_fini(drm, xlnx_drm->crtc);
 	drm_kms_helper_poll_fini(drm);
 	drm_mode_config_cleanup(drm);
+	xlnx_gem_pool_fini(drm, xlnx_drm->gem_pool);
 	drm_dev_put(drm);
 }
 
@@ -458,6 +536,7 @@ static struct platform_driver xlnx_driver = {
 	.driver			= {
 		.name		= "xlnx-drm",
 		.pm		= &xlnx_pm_ops,
+		.probe_type	= PROBE_PREFER_ASYNCHRONOUS,
 	},
 };
 
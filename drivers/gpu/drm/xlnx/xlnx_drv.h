@@ -21,6 +21,7 @@
 
 struct drm_device;
 struct xlnx_crtc_helper;
+struct xlnx_gem_pool;
 
 struct platform_device *xlnx_drm_pipeline_init(struct platform_device *parent);
 void xlnx_drm_pipeline_exit(struct platform_device *pipeline);
@@ -28,6 +29,7 @@ void xlnx_drm_pipeline_exit(struct platform_device *pipeline);
 uint32_t xlnx_get_format(struct drm_device *drm);
 unsigned int xlnx_get_align(struct drm_device *drm);
 struct xlnx_crtc_helper *xlnx_get_crtc_helper(struct drm_device *drm);
+struct xlnx_gem_pool *xlnx_get_gem_pool(struct drm_device *drm);
 struct xlnx_bridge_helper *xlnx_get_bridge_helper(struct drm_device *drm);
 
 #endif /* _XLNX_DRV_H_ */
@@ -19,29 +19,285 @@
 #include <drm/drmP.h>
 #include <drm/drm_gem_cma_helper.h>
 
+#include <linux/dma-mapping.h>
+#include <linux/list.h>
+#include <linux/mutex.h>
+
 #include "xlnx_drv.h"
 #include "xlnx_gem.h"
 
+/**
+ * struct xlnx_gem_pool - Pool of freed CMA buffers for reuse
+ * @lock: lock protecting the pool
+ * @bufs: free buffers, the most recently freed first
+ * @size: total size of the free buffers in bytes
+ * @max_size: maximum total size of the free buffers in bytes
+ */
+struct xlnx_gem_pool {
+	struct mutex lock;
+	struct list_head bufs;
+	size_t size;
+	size_t max_size;
+};
+
+/**
+ * struct xlnx_gem_pool_buf - Free CMA buffer in the pool
+ * @node: list node in the pool
+ * @size: size of the buffer in bytes
+ * @vaddr: kernel virtual address of the buffer
+ * @paddr: DMA address of the buffer
+ */
+struct xlnx_gem_pool_buf {
+	struct list_head node;
+	size_t size;
+	void *vaddr;
+	dma_addr_t paddr;
+};
+
+/**
+ * xlnx_gem_pool_init - Initialize the GEM buffer pool
+ * @drm: DRM object
+ * @max_size: maximum total size of the free buffers kept in bytes
+ *
+ * Return: the pool if successful, or NULL.
+ */
+struct xlnx_gem_pool *xlnx_gem_pool_init(struct drm_device *drm,
+					 size_t max_size)
+{
+	struct xlnx_gem_pool *pool;
+
+	pool = devm_kzalloc(drm->dev, sizeof(*pool), GFP_KERNEL);
+	if (!pool)
+		return NULL;
+
+	mutex_init(&pool->lock);
+	INIT_LIST_HEAD(&pool->bufs);
+	pool->max_size = max_size;
+
+	return pool;
+}
+
+/**
+ * xlnx_gem_pool_free_buf - Free a pool buffer back to CMA
+ * @drm: DRM object
+ * @buf: pool buffer
+ */
+static void xlnx_gem_pool_free_buf(struct drm_device *drm,
+				   struct xlnx_gem_pool_buf *buf)
+{
+	dma_free_wc(drm->dev, buf->size, buf->vaddr, buf->paddr);
+	kfree(buf);
+}
+
+/**
+ * xlnx_gem_pool_fini - Free all the buffers of the GEM buffer pool
+ * @drm: DRM object
+ * @pool: GEM buffer pool
+ *
+ * The buffers freed after this are released to CMA right away.
+ */
+void xlnx_gem_pool_fini(struct drm_device *drm, struct xlnx_gem_pool *pool)
+{
+	struct xlnx_gem_pool_buf *buf, *tmp;
+
+	if (!pool)
+		return;
+
+	mutex_lock(&pool->lock);
+	list_for_each_entry_safe(buf, tmp, &pool->bufs, node) {
+		list_del(&buf->node);
+		xlnx_gem_pool_free_buf(drm, buf);
+	}
+	pool->size = 0;
+	pool->max_size = 0;
+	mutex_unlock(&pool->lock);
+}
+
+/**
+ * xlnx_gem_pool_get - Take a free buffer of the given size from the pool
+ * @pool: GEM buffer pool
+ * @size: page aligned size of the buffer
+ *
+ * Return: the pool buffer if one of the size is free, or NULL.
+ */
+static struct xlnx_gem_pool_buf *xlnx_gem_pool_get(struct xlnx_gem_pool *pool,
+						   size_t size)
+{
+	struct xlnx_gem_pool_buf *buf;
+
+	if (!pool)
+		return NULL;
+
+	mutex_lock(&pool->lock);
+	list_for_each_entry(buf, &pool->bufs, node) {
+		if (buf->size == size) {
+			list_del(&buf->node);
+			pool->size -= size;
+			mutex_unlock(&pool->lock);
+			return buf;
+		}
+	}
+	mutex_unlock(&pool->lock);
+
+	return NULL;
+}
+
+/**
+ * xlnx_gem_pool_put - Keep a freed CMA buffer in the pool
+ * @drm: DRM object
+ * @pool: GEM buffer pool
+ * @cma_obj: GEM CMA object being freed
+ *
+ * The least recently freed buffers are released to CMA to make room for the
+ * new one.
+ *
+ * Return: true if the buffer is kept in the pool, false otherwise.
+ */
+static bool xlnx_gem_pool_put(struct drm_device *drm,
+			      struct xlnx_gem_pool *pool,
+			      struct drm_gem_cma_object *cma_obj)
+{
+	struct xlnx_gem_pool_buf *buf;
+	size_t size = cma_obj->base.size;
+
+	if (!pool || size > READ_ONCE(pool->max_size))
+		return false;
+
+	buf = kzalloc(sizeof(*buf), GFP_KERNEL);
+	if (!buf)
+		return false;
+
+	buf->size = size;
+	buf->vaddr = cma_obj->vaddr;
+	buf->paddr = cma_obj->paddr;
+
+	mutex_lock(&pool->lock);
+	if (size > pool->max_size) {
+		mutex_unlock(&pool->lock);
+		kfree(buf);
+		return false;
+	}
+	while (pool->size + size > pool->max_size) {
+		struct xlnx_gem_pool_buf *old;
+
+		old = list_last_entry(&pool->bufs, struct xlnx_gem_pool_buf,
+				      node);
+		list_del(&old->node);
+		pool->size -= old->size;
+		xlnx_gem_pool_free_buf(drm, old);
+	}
+	list_add(&buf->node, &pool->bufs);
+	pool->size += size;
+	mutex_unlock(&pool->lock);
+
+	return true;
+}
+
+/**
+ * xlnx_gem_cma_create - Create a GEM CMA object reusing a pool buffer
+ * @drm: DRM object
+ * @size: size of the object
+ *
+ * This function backs the object with a free buffer of the same size from the
+ * pool if any, and falls back to drm_gem_cma_create() otherwise.
+ *
+ * Return: the GEM CMA object if successful, or ERR_PTR.
+ */
+static struct drm_gem_cma_object *xlnx_gem_cma_create(struct drm_device *drm,
+						      size_t size)
+{
+	struct xlnx_gem_pool_buf *buf;
+	struct drm_gem_cma_object *cma_obj;
+	int ret;
+
+	size = round_up(size, PAGE_SIZE);
+	buf = xlnx_gem_pool_get(xlnx_get_gem_pool(drm), size);
+	if (!buf)
+		return drm_gem_cma_create(drm, size);
+
+	cma_obj = kzalloc(sizeof(*cma_obj), GFP_KERNEL);
+	if (!cma_obj) {
+		ret = -ENOMEM;
+		goto err_free_buf;
+	}
+
+	ret = drm_gem_object_init(drm, &cma_obj->base, size);
+	if (ret)
+		goto err_free_obj;
+
+	ret = drm_gem_create_mmap_offset(&cma_obj->base);
+	if (ret)
+		goto err_release_obj;
+
+	/* Don't leak the content of the previous owner */
+	memset(buf->vaddr, 0, size);
+	cma_obj->vaddr = buf->vaddr;
+	cma_obj->paddr = buf->paddr;
+	kfree(buf);
+
+	return cma_obj;
+
+err_release_obj:
+	drm_gem_object_release(&cma_obj->base);
+err_free_obj:
+	kfree(cma_obj);
+err_free_buf:
+	xlnx_gem_pool_free_buf(drm, buf);
+	return ERR_PTR(ret);
+}
+
+/**
+ * xlnx_gem_cma_free_object - (struct drm_driver)->gem_free_object callback
+ * @gem_obj: GEM object to free
+ *
+ * This function wraps around drm_gem_cma_free_object(), and keeps the CMA
+ * buffer of a non-imported object in the pool for reuse.
+ */
+void xlnx_gem_cma_free_object(struct drm_gem_object *gem_obj)
+{
+	struct drm_gem_cma_object *cma_obj = to_drm_gem_cma_obj(gem_obj);
+	struct drm_device *drm = gem_obj->dev;
+
+	if (!gem_obj->import_attach && cma_obj->vaddr &&
+	    xlnx_gem_pool_put(drm, xlnx_get_gem_pool(drm), cma_obj))
+		cma_obj->vaddr = NULL;
+
+	drm_gem_cma_free_object(gem_obj);
+}
+
 /*
  * xlnx_gem_cma_dumb_create - (struct drm_driver)->dumb_create callback
  * @file_priv: drm_file object
  * @drm: DRM object
  * @args: info for dumb scanout buffer creation
  *
- * This function is for dumb_create callback of drm_driver struct. Simply
- * it wraps around drm_gem_cma_dumb_create() and sets the pitch value
- * by retrieving the value from the device.
+ * This function is for dumb_create callback of drm_driver struct. It works
+ * as drm_gem_cma_dumb_create_internal() with the pitch value retrieved from
+ * the device, and reuses a free buffer of the pool when possible.
  *
- * Return: The return value from drm_gem_cma_dumb_create()
+ * Return: 0 if successful, or the error code.
  */
 int xlnx_gem_cma_dumb_create(struct drm_file *file_priv, struct drm_device *drm,
 			     struct drm_mode_create_dumb *args)
 {
 	int pitch = DIV_ROUND_UP(args->width * args->bpp, 8);
 	unsigned int align = xlnx_get_align(drm);
+	struct drm_gem_cma_object *cma_obj;
+	int ret;
 
 	if (!args->pitch || !IS_ALIGNED(args->pitch, align))
 		args->pitch = ALIGN(pitch, align);
 
-	return drm_gem_cma_dumb_create_internal(file_priv, drm, args);
+	if (args->size < args->pitch * args->height)
+		args->size = args->pitch * args->height;
+
+	cma_obj = xlnx_gem_cma_create(drm, args->size);
+	if (IS_ERR(cma_obj))
+		return PTR_ERR(cma_obj);
+
+	ret = drm_gem_handle_create(file_priv, &cma_obj->base, &args->handle);
+	/* drop reference from allocate - handle holds it now. */
+	drm_gem_object_put_unlocked(&cma_obj->base);
+
+	return ret;
 }
@@ -19,6 +19,12 @@
 #ifndef _XLNX_GEM_H_
 #define _XLNX_GEM_H_
 
+struct xlnx_gem_pool;
+
+struct xlnx_gem_pool *xlnx_gem_pool_init(struct drm_device *drm,
+					 size_t max_size);
+void xlnx_gem_pool_fini(struct drm_device *drm, struct xlnx_gem_pool *pool);
+void xlnx_gem_cma_free_object(struct drm_gem_object *gem_obj);
 int xlnx_gem_cma_dumb_create(struct drm_file *file_priv,
 			     struct drm_device *drm,
 			     struct drm_mode_create_dumb *args);
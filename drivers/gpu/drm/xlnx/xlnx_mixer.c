@@ -16,6 +16,7 @@
 #include <drm/drm_fb_cma_helper.h>
 #include <drm/drm_fourcc.h>
 #include <drm/drm_gem_cma_helper.h>
+#include <drm/drm_gem_framebuffer_helper.h>
 #include <drm/drm_modeset_helper_vtables.h>
 #include <linux/clk.h>
 #include <linux/component.h>
@@ -133,6 +134,7 @@
 #define XVMIX_CSC_COEFF_SIZE		(12)
 #define XVMIX_CSC_SCALE_FACTOR		(4096)
 #define XVMIX_CSC_DIVISOR		(10000)
+#define XVMIX_MAX_SHADOW_REGS		256
 
 /*************************** STATIC DATA  ************************************/
 static const s16
@@ -349,6 +351,16 @@ struct xlnx_mix_layer_data {
 	enum xlnx_mix_layer_id id;
 };
 
+/**
+ * struct xlnx_mix_shadow_reg - Staged mixer register write
+ * @offset: Register offset
+ * @val: Register value
+ */
+struct xlnx_mix_shadow_reg {
+	u32 offset;
+	u32 val;
+};
+
 /**
  * struct xlnx_mix_hw - Describes a mixer IP block instance within the design
  * @base: Base physical address of Mixer IP in memory map
@@ -375,6 +387,11 @@ struct xlnx_mix_layer_data {
  * @reset_gpio: GPIO line used to reset IP between modesetting operations
  * @intrpt_handler_fn: Interrupt handler function called when frame is completed
  * @intrpt_data: Data pointer passed to interrupt handler
+ * @shadow_lock: Lock protecting the shadow registers
+ * @shadow_regs: Shadow registers staged by a commit
+ * @num_shadow_regs: Number of valid shadow registers
+ * @shadow_en: Register writes are staged in the shadow registers
+ * @shadow_latch: Shadow registers are latched at the next frame done
  *
  * Used as the primary data structure for many L2 driver functions. Logo layer
  * data, if enabled within the IP, is described in this structure.  All other
@@ -406,6 +423,11 @@ struct xlnx_mix_hw {
 	struct gpio_desc *reset_gpio;
 	void (*intrpt_handler_fn)(void *);
 	void *intrpt_data;
+	spinlock_t shadow_lock;
+	struct xlnx_mix_shadow_reg shadow_regs[XVMIX_MAX_SHADOW_REGS];
+	u32 num_shadow_regs;
+	bool shadow_en;
+	bool shadow_latch;
 };
 
 /**
@@ -514,6 +536,146 @@ static inline u32 reg_readl(void __iomem *base, int offset)
 	return readl(base + offset);
 }
 
+/**
+ * xlnx_mix_find_shadow_reg - Find a staged register write
+ * @mixer: Mixer instance
+ * @offset: Register offset
+ *
+ * The shadow lock is expected to be held by the caller.
+ *
+ * Return:
+ * Index of the shadow register, or num_shadow_regs if not staged
+ */
+static u32 xlnx_mix_find_shadow_reg(struct xlnx_mix_hw *mixer, int offset)
+{
+	u32 i;
+
+	for (i = 0; i < mixer->num_shadow_regs; i++)
+		if (mixer->shadow_regs[i].offset == offset)
+			break;
+	return i;
+}
+
+/**
+ * xlnx_mix_write - Write a mixer layer register
+ * @mixer: Mixer instance
+ * @offset: Register offset
+ * @val: Register value
+ *
+ * While a commit is staging, the write is recorded in the shadow registers,
+ * which are latched in one burst at the next frame done interrupt. A write to
+ * an already staged register updates the staged value, so it isn't
+ * overwritten by the latch. Other writes go straight to the hardware.
+ */
+static void xlnx_mix_write(struct xlnx_mix_hw *mixer, int offset, u32 val)
+{
+	unsigned long flags;
+	u32 i;
+
+	spin_lock_irqsave(&mixer->shadow_lock, flags);
+	i = xlnx_mix_find_shadow_reg(mixer, offset);
+	if (i < mixer->num_shadow_regs ||
+	    (mixer->shadow_en && i < XVMIX_MAX_SHADOW_REGS)) {
+		mixer->shadow_regs[i].offset = offset;
+		mixer->shadow_regs[i].val = val;
+		if (i == mixer->num_shadow_regs)
+			mixer->num_shadow_regs++;
+		spin_unlock_irqrestore(&mixer->shadow_lock, flags);
+		return;
+	}
+	spin_unlock_irqrestore(&mixer->shadow_lock, flags);
+
+	reg_writel(mixer->base, offset, val);
+}
+
+static inline void xlnx_mix_writeq(struct xlnx_mix_hw *mixer, int offset,
+				   u64 val)
+{
+	xlnx_mix_write(mixer, offset, lower_32_bits(val));
+	xlnx_mix_write(mixer, offset + 4, upper_32_bits(val));
+}
+
+/**
+ * xlnx_mix_read - Read a mixer layer register
+ * @mixer: Mixer instance
+ * @offset: Register offset
+ *
+ * Return:
+ * The staged value of the register if any, the hardware value otherwise
+ */
+static u32 xlnx_mix_read(struct xlnx_mix_hw *mixer, int offset)
+{
+	unsigned long flags;
+	u32 i, val;
+
+	spin_lock_irqsave(&mixer->shadow_lock, flags);
+	i = xlnx_mix_find_shadow_reg(mixer, offset);
+	if (i < mixer->num_shadow_regs)
+		val = mixer->shadow_regs[i].val;
+	else
+		val = reg_readl(mixer->base, offset);
+	spin_unlock_irqrestore(&mixer->shadow_lock, flags);
+
+	return val;
+}
+
+/**
+ * xlnx_mix_latch_shadow_regs - Write the staged registers to hardware
+ * @mixer: Mixer instance
+ *
+ * The shadow lock is expected to be held by the caller.
+ */
+static void xlnx_mix_latch_shadow_regs(struct xlnx_mix_hw *mixer)
+{
+	u32 i;
+
+	for (i = 0; i < mixer->num_shadow_regs; i++)
+		reg_writel(mixer->base, mixer->shadow_regs[i].offset,
+			   mixer->shadow_regs[i].val);
+	mixer->num_shadow_regs = 0;
+	mixer->shadow_latch = false;
+}
+
+/**
+ * xlnx_mix_shadow_begin - Start staging the layer register writes
+ * @mixer: Mixer instance
+ *
+ * Staged writes which are not latched yet are merged with the new ones, and
+ * are latched together at the end of the new commit.
+ */
+static void xlnx_mix_shadow_begin(struct xlnx_mix_hw *mixer)
+{
+	/* The staged registers are latched by the frame done interrupt */
+	if (mixer->irq <= 0)
+		return;
+
+	spin_lock_irq(&mixer->shadow_lock);
+	mixer->shadow_en = true;
+	mixer->shadow_latch = false;
+	spin_unlock_irq(&mixer->shadow_lock);
+}
+
+/**
+ * xlnx_mix_shadow_end - Stop staging the layer register writes
+ * @mixer: Mixer instance
+ * @running: The mixer is running and generates frame done interrupts
+ *
+ * Arm the latch of the staged registers at the next frame done interrupt if
+ * the mixer is running, or write them to hardware right away otherwise.
+ */
+static void xlnx_mix_shadow_end(struct xlnx_mix_hw *mixer, bool running)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&mixer->shadow_lock, flags);
+	mixer->shadow_en = false;
+	if (running && mixer->num_shadow_regs)
+		mixer->shadow_latch = true;
+	else
+		xlnx_mix_latch_shadow_regs(mixer);
+	spin_unlock_irqrestore(&mixer->shadow_lock, flags);
+}
+
 /**
  * xlnx_mix_intrpt_enable_done - Enables interrupts
  * @mixer: instance of mixer IP core
@@ -596,14 +758,14 @@ static void xlnx_mix_set_yuv2_rgb_coeff(struct xlnx_mix_plane *plane,
 	u32 bpc_scale = 1 << (mixer->mixer_hw.bg_layer_bpc - 8);
 
 	for (i = 0; i < XVMIX_CSC_MATRIX_SIZE; i++)
-		reg_writel(mixer->mixer_hw.base, XVMIX_K00_1 + i * 8,
-			   xlnx_mix_yuv2rgb_coeffs[enc][range][i] *
-			   XVMIX_CSC_SCALE_FACTOR / XVMIX_CSC_DIVISOR);
+		xlnx_mix_write(&mixer->mixer_hw, XVMIX_K00_1 + i * 8,
+			       xlnx_mix_yuv2rgb_coeffs[enc][range][i] *
+			       XVMIX_CSC_SCALE_FACTOR / XVMIX_CSC_DIVISOR);
 
 	for (i = XVMIX_CSC_MATRIX_SIZE; i < XVMIX_CSC_COEFF_SIZE; i++)
-		reg_writel(mixer->mixer_hw.base, XVMIX_K00_1 + i * 8,
-			   (xlnx_mix_yuv2rgb_coeffs[enc][range][i] *
-			    bpc_scale));
+		xlnx_mix_write(&mixer->mixer_hw, XVMIX_K00_1 + i * 8,
+			       (xlnx_mix_yuv2rgb_coeffs[enc][range][i] *
+				bpc_scale));
 }
 
 /**
@@ -623,14 +785,14 @@ static void xlnx_mix_set_rgb2_yuv_coeff(struct xlnx_mix_plane *plane,
 	u32 bpc_scale = 1 << (mixer->mixer_hw.bg_layer_bpc - 8);
 
 	for (i = 0; i < XVMIX_CSC_MATRIX_SIZE; i++)
-		reg_writel(mixer->mixer_hw.base, XVMIX_K00_2 + i * 8,
-			   xlnx_mix_rgb2yuv_coeffs[enc][range][i] *
-			   XVMIX_CSC_SCALE_FACTOR / XVMIX_CSC_DIVISOR);
+		xlnx_mix_write(&mixer->mixer_hw, XVMIX_K00_2 + i * 8,
+			       xlnx_mix_rgb2yuv_coeffs[enc][range][i] *
+			       XVMIX_CSC_SCALE_FACTOR / XVMIX_CSC_DIVISOR);
 
 	for (i = XVMIX_CSC_MATRIX_SIZE; i < XVMIX_CSC_COEFF_SIZE; i++)
-		reg_writel(mixer->mixer_hw.base, XVMIX_K00_2 + i * 8,
-			   (xlnx_mix_rgb2yuv_coeffs[enc][range][i] *
-			    bpc_scale));
+		xlnx_mix_write(&mixer->mixer_hw, XVMIX_K00_2 + i * 8,
+			       (xlnx_mix_rgb2yuv_coeffs[enc][range][i] *
+				bpc_scale));
 }
 
 /**
@@ -681,8 +843,8 @@ static int xlnx_mix_set_active_area(struct xlnx_mix_hw *mixer,
 		return -EINVAL;
 	}
 	/* set resolution */
-	reg_writel(mixer->base, XVMIX_HEIGHT_DATA, vactive);
-	reg_writel(mixer->base, XVMIX_WIDTH_DATA, hactive);
+	xlnx_mix_write(mixer, XVMIX_HEIGHT_DATA, vactive);
+	xlnx_mix_write(mixer, XVMIX_WIDTH_DATA, hactive);
 	ld->layer_regs.width  = hactive;
 	ld->layer_regs.height = vactive;
 
@@ -757,17 +919,17 @@ static void xlnx_mix_layer_enable(struct xlnx_mix_hw *mixer,
 
 	/* Check if request is to enable all layers or single layer */
 	if (id == mixer->max_layers) {
-		reg_writel(mixer->base, XVMIX_LAYERENABLE_DATA,
-			   mixer->enable_all_mask);
+		xlnx_mix_write(mixer, XVMIX_LAYERENABLE_DATA,
+			       mixer->enable_all_mask);
 
 	} else if ((id < mixer->layer_cnt) || ((id == mixer->logo_layer_id) &&
 		   mixer->logo_layer_en)) {
-		curr_state = reg_readl(mixer->base, XVMIX_LAYERENABLE_DATA);
+		curr_state = xlnx_mix_read(mixer, XVMIX_LAYERENABLE_DATA);
 		if (id == mixer->logo_layer_id)
 			curr_state |= mixer->logo_en_mask;
 		else
 			curr_state |= BIT(id);
-		reg_writel(mixer->base, XVMIX_LAYERENABLE_DATA, curr_state);
+		xlnx_mix_write(mixer, XVMIX_LAYERENABLE_DATA, curr_state);
 	} else {
 		DRM_ERROR("Can't enable requested layer %d\n", id);
 	}
@@ -818,16 +980,16 @@ static void xlnx_mix_layer_disable(struct xlnx_mix_hw *mixer,
 	num_layers = mixer->layer_cnt;
 
 	if (id == mixer->max_layers) {
-		reg_writel(mixer->base, XVMIX_LAYERENABLE_DATA,
-			   XVMIX_MASK_DISABLE_ALL_LAYERS);
+		xlnx_mix_write(mixer, XVMIX_LAYERENABLE_DATA,
+			       XVMIX_MASK_DISABLE_ALL_LAYERS);
 	} else if ((id < num_layers) ||
 		   ((id == mixer->logo_layer_id) && (mixer->logo_layer_en))) {
-		curr_state = reg_readl(mixer->base, XVMIX_LAYERENABLE_DATA);
+		curr_state = xlnx_mix_read(mixer, XVMIX_LAYERENABLE_DATA);
 		if (id == mixer->logo_layer_id)
 			curr_state &= ~(mixer->logo_en_mask);
 		else
 			curr_state &= ~(BIT(id));
-		reg_writel(mixer->base, XVMIX_LAYERENABLE_DATA, curr_state);
+		xlnx_mix_write(mixer, XVMIX_LAYERENABLE_DATA, curr_state);
 	} else {
 		DRM_ERROR("Can't disable requested layer %d\n", id);
 	}
@@ -1055,14 +1217,14 @@ static int xlnx_mix_get_layer_scaling(struct xlnx_mix_hw *mixer,
 					XVMIX_LOGO_OFFSET;
 			else
 				reg = XVMIX_LOGOSCALEFACTOR_DATA;
-			scale_factor = reg_readl(mixer->base, reg);
+			scale_factor = xlnx_mix_read(mixer, reg);
 			l_data->layer_regs.scale_fact = scale_factor;
 		}
 	} else {
 		/*Layer0-Layer15*/
 		if (id < mixer->logo_layer_id && l_data->hw_config.can_scale) {
 			reg = XVMIX_LAYERSCALE_0_DATA + (id * XVMIX_REG_OFFSET);
-			scale_factor = reg_readl(mixer->base, reg);
+			scale_factor = xlnx_mix_read(mixer, reg);
 			l_data->layer_regs.scale_fact = scale_factor;
 		}
 	}
@@ -1123,10 +1285,10 @@ static int xlnx_mix_set_layer_window(struct xlnx_mix_hw *mixer,
 			w_reg = XVMIX_LOGOWIDTH_DATA;
 			h_reg = XVMIX_LOGOHEIGHT_DATA;
 		}
-		reg_writel(mixer->base, x_reg, x_pos);
-		reg_writel(mixer->base, y_reg, y_pos);
-		reg_writel(mixer->base, w_reg, width);
-		reg_writel(mixer->base, h_reg, height);
+		xlnx_mix_write(mixer, x_reg, x_pos);
+		xlnx_mix_write(mixer, y_reg, y_pos);
+		xlnx_mix_write(mixer, w_reg, width);
+		xlnx_mix_write(mixer, h_reg, height);
 		l_data->layer_regs.x_pos = x_pos;
 		l_data->layer_regs.y_pos = y_pos;
 		l_data->layer_regs.width = width;
@@ -1146,17 +1308,17 @@ static int xlnx_mix_set_layer_window(struct xlnx_mix_hw *mixer,
 		s_reg = XVMIX_LAYERSTRIDE_0_DATA;
 
 		off = id * XVMIX_REG_OFFSET;
-		reg_writel(mixer->base, (x_reg + off), x_pos);
-		reg_writel(mixer->base, (y_reg + off), y_pos);
-		reg_writel(mixer->base, (w_reg + off), width);
-		reg_writel(mixer->base, (h_reg + off), height);
+		xlnx_mix_write(mixer, (x_reg + off), x_pos);
+		xlnx_mix_write(mixer, (y_reg + off), y_pos);
+		xlnx_mix_write(mixer, (w_reg + off), width);
+		xlnx_mix_write(mixer, (h_reg + off), height);
 		l_data->layer_regs.x_pos = x_pos;
 		l_data->layer_regs.y_pos = y_pos;
 		l_data->layer_regs.width = width;
 		l_data->layer_regs.height = height;
 
 		if (!l_data->hw_config.is_streaming)
-			reg_writel(mixer->base, (s_reg + off), stride);
+			xlnx_mix_write(mixer, (s_reg + off), stride);
 		status = 0;
 	}
 	return status;
@@ -1233,7 +1395,6 @@ static int xlnx_mix_set_layer_dimensions(struct xlnx_mix_plane *plane,
 static int xlnx_mix_set_layer_scaling(struct xlnx_mix_hw *mixer,
 				      enum xlnx_mix_layer_id id, u32 scale)
 {
-	void __iomem *reg = mixer->base;
 	struct xlnx_mix_layer_data *l_data;
 	int status = 0;
 	u32 x_pos, y_pos, width, height, offset;
@@ -1250,11 +1411,13 @@ static int xlnx_mix_set_layer_scaling(struct xlnx_mix_hw *mixer,
 	if (id == mixer->logo_layer_id) {
 		if (mixer->logo_layer_en) {
 			if (mixer->max_layers > XVMIX_MAX_OVERLAY_LAYERS)
-				reg_writel(reg, XVMIX_LOGOSCALEFACTOR_DATA +
-					   XVMIX_LOGO_OFFSET, scale);
+				xlnx_mix_write(mixer,
+					       XVMIX_LOGOSCALEFACTOR_DATA +
+					       XVMIX_LOGO_OFFSET, scale);
 			else
-				reg_writel(reg, XVMIX_LOGOSCALEFACTOR_DATA,
-					   scale);
+				xlnx_mix_write(mixer,
+					       XVMIX_LOGOSCALEFACTOR_DATA,
+					       scale);
 			l_data->layer_regs.scale_fact = scale;
 			status = 0;
 		}
@@ -1263,8 +1426,8 @@ static int xlnx_mix_set_layer_scaling(struct xlnx_mix_hw *mixer,
 		if (id < mixer->layer_cnt && l_data->hw_config.can_scale) {
 			offset = id * XVMIX_REG_OFFSET;
 
-			reg_writel(reg, (XVMIX_LAYERSCALE_0_DATA + offset),
-				   scale);
+			xlnx_mix_write(mixer, XVMIX_LAYERSCALE_0_DATA + offset,
+				       scale);
 			l_data->layer_regs.scale_fact = scale;
 			status = 0;
 		}
@@ -1334,7 +1497,7 @@ static int xlnx_mix_set_layer_alpha(struct xlnx_mix_hw *mixer,
 				reg = XVMIX_LOGOALPHA_DATA + XVMIX_LOGO_OFFSET;
 			else
 				reg = XVMIX_LOGOALPHA_DATA;
-			reg_writel(mixer->base, reg, alpha);
+			xlnx_mix_write(mixer, reg, alpha);
 			layer_data->layer_regs.alpha = alpha;
 			status = 0;
 		}
@@ -1345,7 +1508,7 @@ static int xlnx_mix_set_layer_alpha(struct xlnx_mix_hw *mixer,
 			u32 offset =  layer_id * XVMIX_REG_OFFSET;
 
 			reg = XVMIX_LAYERALPHA_0_DATA;
-			reg_writel(mixer->base, (reg + offset), alpha);
+			xlnx_mix_write(mixer, (reg + offset), alpha);
 			layer_data->layer_regs.alpha = alpha;
 			status = 0;
 		}
@@ -1410,11 +1573,11 @@ static int xlnx_mix_set_layer_buff_addr(struct xlnx_mix_hw *mixer,
 	reg2 = XVMIX_LAYER1_BUF2_V_DATA + offset;
 	layer_data = &mixer->layer_data[id];
 	if (mixer->dma_addr_size == 64 && sizeof(dma_addr_t) == 8) {
-		reg_writeq(mixer->base, reg1, luma_addr);
-		reg_writeq(mixer->base, reg2, chroma_addr);
+		xlnx_mix_writeq(mixer, reg1, luma_addr);
+		xlnx_mix_writeq(mixer, reg2, chroma_addr);
 	} else {
-		reg_writel(mixer->base, reg1, (u32)luma_addr);
-		reg_writel(mixer->base, reg2, (u32)chroma_addr);
+		xlnx_mix_write(mixer, reg1, (u32)luma_addr);
+		xlnx_mix_write(mixer, reg2, (u32)chroma_addr);
 	}
 	layer_data->layer_regs.buff_addr1 = luma_addr;
 	layer_data->layer_regs.buff_addr2 = chroma_addr;
@@ -1601,6 +1764,12 @@ xlnx_mix_disp_plane_atomic_update_plane(struct drm_plane *plane,
 	return ret;
 }
 
+/* Memory layout used when the layer DMA doesn't report format modifiers */
+static const u64 xlnx_mix_modifiers[] = {
+	DRM_FORMAT_MOD_LINEAR,
+	DRM_FORMAT_MOD_INVALID,
+};
+
 static struct drm_plane_funcs xlnx_mix_plane_funcs = {
 	.update_plane	= xlnx_mix_disp_plane_atomic_update_plane,
 	.disable_plane	= drm_atomic_helper_disable_plane,
@@ -1947,12 +2116,6 @@ static int xlnx_mix_plane_mode_set(struct drm_plane *base_plane,
 	return ret;
 }
 
-static int xlnx_mix_plane_prepare_fb(struct drm_plane *plane,
-				     struct drm_plane_state *new_state)
-{
-	return 0;
-}
-
 static void xlnx_mix_plane_cleanup_fb(struct drm_plane *plane,
 				      struct drm_plane_state *old_state)
 {
@@ -2047,7 +2210,7 @@ xlnx_mix_plane_atomic_async_update(struct drm_plane *plane,
 }
 
 static const struct drm_plane_helper_funcs xlnx_mix_plane_helper_funcs = {
-	.prepare_fb	= xlnx_mix_plane_prepare_fb,
+	.prepare_fb	= drm_gem_fb_prepare_fb,
 	.cleanup_fb	= xlnx_mix_plane_cleanup_fb,
 	.atomic_check	= xlnx_mix_plane_atomic_check,
 	.atomic_update	= xlnx_mix_plane_atomic_update,
@@ -2061,6 +2224,7 @@ static int xlnx_mix_init_plane(struct xlnx_mix_plane *plane,
 			       struct device_node *layer_node)
 {
 	struct xlnx_mix *mixer = plane->mixer;
+	const u64 *modifiers = xlnx_mix_modifiers;
 	char name[16];
 	enum drm_plane_type type;
 	int ret, i;
@@ -2094,11 +2258,15 @@ static int xlnx_mix_init_plane(struct xlnx_mix_plane *plane,
 	if (plane == mixer->drm_primary_layer)
 		type = DRM_PLANE_TYPE_PRIMARY;
 
+	if (plane->dma[0].chan)
+		xilinx_xdma_get_drm_vid_fmt_modifiers(plane->dma[0].chan,
+						      &modifiers);
+
 	/* initialize drm plane */
 	ret = drm_universal_plane_init(mixer->drm, &plane->base,
 				       poss_crtcs, &xlnx_mix_plane_funcs,
 				       &plane->format,
-				       1, NULL, type, NULL);
+				       1, modifiers, type, NULL);
 
 	if (ret) {
 		DRM_ERROR("failed to initialize plane\n");
@@ -2244,6 +2412,7 @@ static int xlnx_mix_dt_parse(struct device *dev, struct xlnx_mix *mixer)
 	node = dev->of_node;
 	mixer_hw = &mixer->mixer_hw;
 	mixer->dpms = DRM_MODE_DPMS_OFF;
+	spin_lock_init(&mixer_hw->shadow_lock);
 
 	mixer_hw->reset_gpio = devm_gpiod_get(dev, "reset", GPIOD_OUT_LOW);
 	if (IS_ERR(mixer_hw->reset_gpio)) {
@@ -2434,6 +2603,11 @@ static irqreturn_t xlnx_mix_intr_handler(int irq, void *data)
 
 	if (!intr)
 		return IRQ_NONE;
+	/* latch the layer updates of the last commit before the next frame */
+	spin_lock(&mixer->shadow_lock);
+	if (mixer->shadow_latch)
+		xlnx_mix_latch_shadow_regs(mixer);
+	spin_unlock(&mixer->shadow_lock);
 	if (mixer->intrpt_handler_fn)
 		mixer->intrpt_handler_fn(mixer->intrpt_data);
 	xlnx_mix_clear_intr_status(mixer, intr);
@@ -2572,9 +2746,9 @@ static void xlnx_mix_set_bkg_col(struct xlnx_mix_hw *mixer, u64 rgb_value)
 	u16 r_val = (rgb_value >> 0) &  val_mask;
 
 	/* Set Background Color */
-	reg_writel(mixer->base, XVMIX_BACKGROUND_Y_R_DATA, r_val);
-	reg_writel(mixer->base, XVMIX_BACKGROUND_U_G_DATA, g_val);
-	reg_writel(mixer->base, XVMIX_BACKGROUND_V_B_DATA, b_val);
+	xlnx_mix_write(mixer, XVMIX_BACKGROUND_Y_R_DATA, r_val);
+	xlnx_mix_write(mixer, XVMIX_BACKGROUND_U_G_DATA, g_val);
+	xlnx_mix_write(mixer, XVMIX_BACKGROUND_V_B_DATA, b_val);
 	mixer->bg_color = rgb_value;
 }
 
@@ -2603,6 +2777,7 @@ static void xlnx_mix_dpms(struct xlnx_mix *mixer, int dpms)
 		xlnx_mix_start(&mixer->mixer_hw);
 		break;
 	default:
+		xlnx_mix_shadow_end(&mixer->mixer_hw, false);
 		xlnx_mix_stop(&mixer->mixer_hw);
 		mdelay(50); /* let IP shut down */
 		xlnx_mix_reset(mixer);
@@ -2774,10 +2949,21 @@ xlnx_mix_crtc_atomic_enable(struct drm_crtc *crtc,
  */
 static void xlnx_mix_clear_event(struct drm_crtc *crtc)
 {
+	struct xlnx_crtc *xcrtc = to_xlnx_crtc(crtc);
+	struct xlnx_mix *mixer = to_xlnx_mixer(xcrtc);
+
+	/* Don't rely on vblank when disabling crtc */
+	spin_lock_irq(&crtc->dev->event_lock);
+	if (mixer->event) {
+		drm_crtc_send_vblank_event(crtc, mixer->event);
+		drm_crtc_vblank_put(crtc);
+		mixer->event = NULL;
+	}
 	if (crtc->state->event) {
-		complete_all(crtc->state->event->base.completion);
+		drm_crtc_send_vblank_event(crtc, crtc->state->event);
 		crtc->state->event = NULL;
 	}
+	spin_unlock_irq(&crtc->dev->event_lock);
 }
 
 static void
@@ -2803,18 +2989,42 @@ static void
 xlnx_mix_crtc_atomic_begin(struct drm_crtc *crtc,
 			   struct drm_crtc_state *old_crtc_state)
 {
-	drm_crtc_vblank_on(crtc);
-	/* Don't rely on vblank when disabling crtc */
-	if (crtc->state->event) {
-		struct xlnx_crtc *xcrtc = to_xlnx_crtc(crtc);
-		struct xlnx_mix *mixer = to_xlnx_mixer(xcrtc);
+	struct xlnx_crtc *xcrtc = to_xlnx_crtc(crtc);
+	struct xlnx_mix *mixer = to_xlnx_mixer(xcrtc);
 
-		/* Consume the flip_done event from atomic helper */
-		crtc->state->event->pipe = drm_crtc_index(crtc);
-		WARN_ON(drm_crtc_vblank_get(crtc) != 0);
-		mixer->event = crtc->state->event;
-		crtc->state->event = NULL;
+	if (crtc->state->active)
+		drm_crtc_vblank_on(crtc);
+	/* stage the layer updates of a running mixer to latch them at once */
+	if (mixer->dpms == DRM_MODE_DPMS_ON)
+		xlnx_mix_shadow_begin(&mixer->mixer_hw);
+}
+
+static void
+xlnx_mix_crtc_atomic_flush(struct drm_crtc *crtc,
+			   struct drm_crtc_state *old_crtc_state)
+{
+	struct xlnx_crtc *xcrtc = to_xlnx_crtc(crtc);
+	struct xlnx_mix *mixer = to_xlnx_mixer(xcrtc);
+	struct drm_pending_vblank_event *event = crtc->state->event;
+
+	xlnx_mix_shadow_end(&mixer->mixer_hw, mixer->dpms == DRM_MODE_DPMS_ON);
+	if (!event)
+		return;
+
+	/*
+	 * Consume the flip_done event from atomic helper once the layers are
+	 * updated. The vblank handler sends it, which signals the out-fence
+	 * of a nonblocking commit.
+	 */
+	crtc->state->event = NULL;
+	spin_lock_irq(&crtc->dev->event_lock);
+	if (crtc->state->active && drm_crtc_vblank_get(crtc) == 0) {
+		WARN_ON(mixer->event);
+		mixer->event = event;
+	} else {
+		drm_crtc_send_vblank_event(crtc, event);
 	}
+	spin_unlock_irq(&crtc->dev->event_lock);
 }
 
 static struct drm_crtc_helper_funcs xlnx_mix_crtc_helper_funcs = {
@@ -2823,6 +3033,7 @@ static struct drm_crtc_helper_funcs xlnx_mix_crtc_helper_funcs = {
 	.mode_set_nofb	= xlnx_mix_crtc_mode_set_nofb,
 	.atomic_check	= xlnx_mix_crtc_atomic_check,
 	.atomic_begin	= xlnx_mix_crtc_atomic_begin,
+	.atomic_flush	= xlnx_mix_crtc_atomic_flush,
 };
 
 /**
@@ -16,6 +16,7 @@
 #include <drm/drm_fb_cma_helper.h>
 #include <drm/drm_fourcc.h>
 #include <drm/drm_gem_cma_helper.h>
+#include <drm/drm_gem_framebuffer_helper.h>
 #include <linux/component.h>
 #include <linux/device.h>
 #include <linux/dmaengine.h>
@@ -65,6 +66,7 @@ struct xlnx_dma_chan {
  * @vtc_bridge: vtc_bridge structure
  * @fid: field id
  * @prev_fid: previous field id
+ * @low_latency: scan out a framebuffer while it is still being written
  */
 struct xlnx_pl_disp {
 	struct device *dev;
@@ -80,6 +82,7 @@ struct xlnx_pl_disp {
 	struct xlnx_bridge *vtc_bridge;
 	u32 fid;
 	u32 prev_fid;
+	bool low_latency;
 };
 
 /*
@@ -100,9 +103,8 @@ static inline struct xlnx_pl_disp *crtc_to_dma(struct xlnx_crtc *xlnx_crtc)
 static void xlnx_pl_disp_complete(void *param)
 {
 	struct xlnx_pl_disp *xlnx_pl_disp = param;
-	struct drm_device *drm = xlnx_pl_disp->drm;
 
-	drm_handle_vblank(drm, 0);
+	drm_crtc_handle_vblank(&xlnx_pl_disp->xlnx_crtc.crtc);
 }
 
 /**
@@ -337,12 +339,43 @@ xlnx_pl_disp_plane_atomic_check(struct drm_plane *plane,
 	return 0;
 }
 
+/**
+ * xlnx_pl_disp_plane_prepare_fb - Prepare a framebuffer for scan out
+ * @plane: DRM plane object
+ * @state: new plane state
+ *
+ * In low latency mode the producer writing the framebuffer and the DMA
+ * reading it are kept a few lines apart by the synchronizer IP, so the
+ * implicit fence of the buffer is not waited for. Otherwise the commit would
+ * only be applied once the whole frame is written, which adds one frame of
+ * latency. Explicit in-fences are still honoured.
+ *
+ * Return: 0 on success, or the error code.
+ */
+static int xlnx_pl_disp_plane_prepare_fb(struct drm_plane *plane,
+					 struct drm_plane_state *state)
+{
+	struct xlnx_pl_disp *xlnx_pl_disp = plane_to_dma(plane);
+
+	if (xlnx_pl_disp->low_latency)
+		return 0;
+
+	return drm_gem_fb_prepare_fb(plane, state);
+}
+
 static const struct drm_plane_helper_funcs xlnx_pl_disp_plane_helper_funcs = {
+	.prepare_fb = xlnx_pl_disp_plane_prepare_fb,
 	.atomic_update = xlnx_pl_disp_plane_atomic_update,
 	.atomic_disable = xlnx_pl_disp_plane_atomic_disable,
 	.atomic_check = xlnx_pl_disp_plane_atomic_check,
 };
 
+/* Memory layout used when the DMA doesn't report its format modifiers */
+static const u64 xlnx_pl_disp_modifiers[] = {
+	DRM_FORMAT_MOD_LINEAR,
+	DRM_FORMAT_MOD_INVALID,
+};
+
 static struct drm_plane_funcs xlnx_pl_disp_plane_funcs = {
 	.update_plane = drm_atomic_helper_update_plane,
 	.disable_plane = drm_atomic_helper_disable_plane,
@@ -362,24 +395,41 @@ static inline struct xlnx_pl_disp *drm_crtc_to_dma(struct drm_crtc *crtc)
 static void xlnx_pl_disp_crtc_atomic_begin(struct drm_crtc *crtc,
 					   struct drm_crtc_state *old_state)
 {
-	drm_crtc_vblank_on(crtc);
+	if (crtc->state->active)
+		drm_crtc_vblank_on(crtc);
+}
+
+static void xlnx_pl_disp_crtc_atomic_flush(struct drm_crtc *crtc,
+					   struct drm_crtc_state *old_state)
+{
+	struct drm_pending_vblank_event *event = crtc->state->event;
+
+	if (!event)
+		return;
+
+	/*
+	 * Arm the flip_done event once the planes are updated, so the event
+	 * and the out-fence of a nonblocking commit signal on the vblank
+	 * which latches the new frame.
+	 */
+	crtc->state->event = NULL;
 	spin_lock_irq(&crtc->dev->event_lock);
-	if (crtc->state->event) {
-		/* Consume the flip_done event from atomic helper */
-		crtc->state->event->pipe = drm_crtc_index(crtc);
-		WARN_ON(drm_crtc_vblank_get(crtc) != 0);
-		drm_crtc_arm_vblank_event(crtc, crtc->state->event);
-		crtc->state->event = NULL;
-	}
+	if (crtc->state->active && drm_crtc_vblank_get(crtc) == 0)
+		drm_crtc_arm_vblank_event(crtc, event);
+	else
+		drm_crtc_send_vblank_event(crtc, event);
 	spin_unlock_irq(&crtc->dev->event_lock);
 }
 
 static void xlnx_pl_disp_clear_event(struct drm_crtc *crtc)
 {
+	/* Don't rely on vblank when disabling crtc */
+	spin_lock_irq(&crtc->dev->event_lock);
 	if (crtc->state->event) {
-		complete_all(crtc->state->event->base.completion);
+		drm_crtc_send_vblank_event(crtc, crtc->state->event);
 		crtc->state->event = NULL;
 	}
+	spin_unlock_irq(&crtc->dev->event_lock);
 }
 
 static void xlnx_pl_disp_crtc_atomic_enable(struct drm_crtc *crtc,
@@ -432,6 +482,7 @@ static struct drm_crtc_helper_funcs xlnx_pl_disp_crtc_helper_funcs = {
 	.atomic_disable = xlnx_pl_disp_crtc_atomic_disable,
 	.atomic_check = xlnx_pl_disp_crtc_atomic_check,
 	.atomic_begin = xlnx_pl_disp_crtc_atomic_begin,
+	.atomic_flush = xlnx_pl_disp_crtc_atomic_flush,
 };
 
 static void xlnx_pl_disp_crtc_destroy(struct drm_crtc *crtc)
@@ -484,15 +535,19 @@ static int xlnx_pl_disp_bind(struct device *dev, struct device *master,
 	int ret;
 	u32 *fmts = NULL;
 	unsigned int num_fmts = 0;
+	const u64 *modifiers = xlnx_pl_disp_modifiers;
 
 	/* in case of fb IP query the supported formats and there count */
 	xilinx_xdma_get_drm_vid_fmts(xlnx_pl_disp->chan->dma_chan,
 				     &num_fmts, &fmts);
+	xilinx_xdma_get_drm_vid_fmt_modifiers(xlnx_pl_disp->chan->dma_chan,
+					      &modifiers);
 	ret = drm_universal_plane_init(drm, &xlnx_pl_disp->plane, 0,
 				       &xlnx_pl_disp_plane_funcs,
 				       fmts ? fmts : &xlnx_pl_disp->fmt,
 				       num_fmts ? num_fmts : 1,
-				       NULL, DRM_PLANE_TYPE_PRIMARY, NULL);
+				       modifiers, DRM_PLANE_TYPE_PRIMARY,
+				       NULL);
 	if (ret)
 		return ret;
 
@@ -579,6 +634,11 @@ static int xlnx_pl_disp_probe(struct platform_device *pdev)
 		dev_info(dev, "vtc bridge property not present\n");
 	}
 
+	xlnx_pl_disp->low_latency = of_property_read_bool(dev->of_node,
+							  "xlnx,low-latency");
+	if (xlnx_pl_disp->low_latency)
+		dev_info(dev, "low latency scan out enabled\n");
+
 	xlnx_pl_disp->dev = dev;
 	platform_set_drvdata(pdev, xlnx_pl_disp);
 
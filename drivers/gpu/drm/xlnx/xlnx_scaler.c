@@ -944,6 +944,8 @@ struct xscaler_feature {
  * @H_phases: The phases needed to program the H-scaler for different taps
  * @hscaler_coeff: The complete array of H-scaler coefficients
  * @vscaler_coeff: The complete array of V-scaler coefficients
+ * @hscaler_bank: H-scaler coefficient bank programmed, NULL if none
+ * @vscaler_bank: V-scaler coefficient bank programmed, NULL if none
  * @is_polyphase: Track if scaling algorithm is polyphase or not
  * @rst_gpio: GPIO reset line to bring VPSS Scaler out of reset
  * @ctrl_clk: AXI Lite clock
@@ -969,6 +971,8 @@ struct xilinx_scaler {
 	u32 H_phases[XV_HSCALER_MAX_LINE_WIDTH];
 	short hscaler_coeff[XV_HSCALER_MAX_H_PHASES][XV_HSCALER_MAX_H_TAPS];
 	short vscaler_coeff[XV_VSCALER_MAX_V_PHASES][XV_VSCALER_MAX_V_TAPS];
+	const short *hscaler_bank;
+	const short *vscaler_bank;
 	bool is_polyphase;
 	struct gpio_desc *rst_gpio;
 	struct clk *ctrl_clk;
@@ -1229,6 +1233,34 @@ static const short *xv_select_coeff(struct xilinx_scaler *scaler,
 	return coeff;
 }
 
+/**
+ * xv_hscaler_set_coeff - Sets h-scaler coefficients
+ * @scaler: Pointer to scaler device structure
+ *
+ * This function sets coefficients of h-scaler.
+ */
+static void xv_hscaler_set_coeff(struct xilinx_scaler *scaler)
+{
+	int val, i, j, offset, rd_indx;
+	u32 ntaps = scaler->num_hori_taps;
+	u32 nphases = scaler->max_num_phases;
+	u32 base_addr;
+
+	offset = (XV_HSCALER_MAX_H_TAPS - ntaps) / 2;
+	base_addr = V_HSCALER_OFF + XV_HSCALER_CTRL_ADDR_HWREG_HFLTCOEFF_BASE;
+	for (i = 0; i < nphases; i++) {
+		for (j = 0; j < ntaps / 2; j++) {
+			rd_indx = j * 2 + offset;
+			val = (scaler->hscaler_coeff[i][rd_indx + 1] <<
+			       XSCALER_BITSHIFT_16) |
+			       (scaler->hscaler_coeff[i][rd_indx] &
+			       XHSC_MASK_LOW_16BITS);
+			xilinx_scaler_write(scaler->base, base_addr +
+				((i * ntaps / 2 + j) * 4), val);
+		}
+	}
+}
+
 /**
  * xv_hscaler_coeff_select - Selection of H-Scaler coefficients of operation
  * @scaler: Pointer to Scaler device structure
@@ -1249,6 +1281,10 @@ static const short *xv_select_coeff(struct xilinx_scaler *scaler,
  * This selection is adopted by the as it gives optimal
  * video output determined by repeated testing of the IP
  *
+ * The selected coefficients are programmed unless the same bank is already
+ * programmed. The coefficient memories keep their content across the IP
+ * reset, so a bank stays valid until another one is programmed.
+ *
  * Return: Will return 0 if successful. Returns -EINVAL on an unsupported
  * H-scaler number of taps.
  */
@@ -1263,38 +1299,16 @@ xv_hscaler_select_coeff(struct xilinx_scaler *scaler,
 	if (!coeff)
 		return -EINVAL;
 
+	/* The bank is still programmed from a previous stream */
+	if (coeff == scaler->hscaler_bank)
+		return 0;
+
 	xv_hscaler_load_ext_coeff(scaler, coeff, ntaps);
+	xv_hscaler_set_coeff(scaler);
+	scaler->hscaler_bank = coeff;
 	return 0;
 }
 
-/**
- * xv_hscaler_set_coeff - Sets h-scaler coefficients
- * @scaler: Pointer to scaler device structure
- *
- * This function sets coefficients of h-scaler.
- */
-static void xv_hscaler_set_coeff(struct xilinx_scaler *scaler)
-{
-	int val, i, j, offset, rd_indx;
-	u32 ntaps = scaler->num_hori_taps;
-	u32 nphases = scaler->max_num_phases;
-	u32 base_addr;
-
-	offset = (XV_HSCALER_MAX_H_TAPS - ntaps) / 2;
-	base_addr = V_HSCALER_OFF + XV_HSCALER_CTRL_ADDR_HWREG_HFLTCOEFF_BASE;
-	for (i = 0; i < nphases; i++) {
-		for (j = 0; j < ntaps / 2; j++) {
-			rd_indx = j * 2 + offset;
-			val = (scaler->hscaler_coeff[i][rd_indx + 1] <<
-			       XSCALER_BITSHIFT_16) |
-			       (scaler->hscaler_coeff[i][rd_indx] &
-			       XHSC_MASK_LOW_16BITS);
-			xilinx_scaler_write(scaler->base, base_addr +
-				((i * ntaps / 2 + j) * 4), val);
-		}
-	}
-}
-
 /**
  * xv_vscaler_load_ext_coeff - Loads external coefficients of v-scaler
  * @scaler: Pointer to scaler device structure
@@ -1382,6 +1396,10 @@ static void xv_vscaler_set_coeff(struct xilinx_scaler *scaler)
  * This selection is adopted by the as it gives optimal
  * video output determined by repeated testing of the IP
  *
+ * The selected coefficients are programmed unless the same bank is already
+ * programmed. The coefficient memories keep their content across the IP
+ * reset, so a bank stays valid until another one is programmed.
+ *
  * Return: Will return 0 if successful. Returns -EINVAL on an unsupported
  * V-scaler number of taps.
  */
@@ -1396,7 +1414,13 @@ xv_vscaler_select_coeff(struct xilinx_scaler *scaler,
 	if (!coeff)
 		return -EINVAL;
 
+	/* The bank is still programmed from a previous stream */
+	if (coeff == scaler->vscaler_bank)
+		return 0;
+
 	xv_vscaler_load_ext_coeff(scaler, coeff, ntaps);
+	xv_vscaler_set_coeff(scaler);
+	scaler->vscaler_bank = coeff;
 	return 0;
 }
 
@@ -1682,7 +1706,6 @@ static int xilinx_scaler_stream(struct xilinx_scaler *scaler)
 			dev_info(scaler->dev, "Failed: vscaler select coeff\n");
 			return ret;
 		}
-		xv_vscaler_set_coeff(scaler);
 	}
 	xilinx_scaler_write(scaler->base, V_VSCALER_OFF +
 			    XV_VSCALER_CTRL_ADDR_HWREG_LINERATE_DATA,
@@ -1708,7 +1731,6 @@ static int xilinx_scaler_stream(struct xilinx_scaler *scaler)
 			dev_info(scaler->dev, "Failed: hscaler select coeff\n");
 			return ret;
 		}
-		xv_hscaler_set_coeff(scaler);
 	}
 	xv_hscaler_calculate_phases(scaler, scaler->width_in,
 				    scaler->width_out, pixel_rate);
@@ -22,12 +22,15 @@
 #include <drm/drm_atomic_uapi.h>
 #include <drm/drm_crtc.h>
 #include <drm/drm_crtc_helper.h>
+#include <drm/drm_damage_helper.h>
 #include <drm/drm_fb_cma_helper.h>
 #include <drm/drm_fourcc.h>
 #include <drm/drm_plane_helper.h>
 
 #include <linux/clk.h>
 #include <linux/device.h>
+#include <linux/dma/xilinx_dpdma.h>
+#include <linux/dma-fence.h>
 #include <linux/dmaengine.h>
 #include <linux/interrupt.h>
 #include <linux/irqreturn.h>
@@ -349,12 +352,14 @@ enum zynqmp_disp_layer_mode {
  * @is_active: flag if the DMA is active
  * @xt: Interleaved desc config container
  * @sgl: Data chunk for dma_interleaved_template
+ * @fence: completion fence of the last submitted descriptor
  */
 struct zynqmp_disp_layer_dma {
 	struct dma_chan *chan;
 	bool is_active;
 	struct dma_interleaved_template xt;
 	struct data_chunk sgl[1];
+	struct dma_fence *fence;
 };
 
 /**
@@ -1926,6 +1931,11 @@ static int zynqmp_disp_layer_enable(struct zynqmp_disp *disp,
 				return -ENOMEM;
 			}
 
+			dma_fence_put(dma->fence);
+			dma->fence = xilinx_dpdma_get_fence(desc);
+			if (IS_ERR(dma->fence))
+				dma->fence = NULL;
+
 			dmaengine_submit(desc);
 			dma_async_issue_pending(dma->chan);
 		}
@@ -1956,9 +1966,12 @@ static int zynqmp_disp_layer_disable(struct zynqmp_disp *disp,
 		return -EBUSY;
 	}
 
-	for (i = 0; i < ZYNQMP_DISP_MAX_NUM_SUB_PLANES; i++)
+	for (i = 0; i < ZYNQMP_DISP_MAX_NUM_SUB_PLANES; i++) {
 		if (layer->dma[i].chan && layer->dma[i].is_active)
 			dmaengine_terminate_sync(layer->dma[i].chan);
+		dma_fence_put(layer->dma[i].fence);
+		layer->dma[i].fence = NULL;
+	}
 
 	zynqmp_disp_av_buf_disable_vid(&disp->av_buf, layer);
 	zynqmp_disp_blend_layer_disable(&disp->blend, layer);
@@ -2021,6 +2034,8 @@ static void zynqmp_disp_layer_release_dma(struct zynqmp_disp *disp,
 			dmaengine_terminate_all(layer->dma[i].chan);
 			dma_release_channel(layer->dma[i].chan);
 		}
+		dma_fence_put(layer->dma[i].fence);
+		layer->dma[i].fence = NULL;
 	}
 }
 
@@ -2677,6 +2692,11 @@ zynqmp_disp_plane_atomic_update(struct drm_plane *plane,
 	if (!plane->state->crtc || !plane->state->fb)
 		return;
 
+	/*
+	 * The layer DMA scans the whole framebuffer out every frame, so the
+	 * damaged area of the same framebuffer is picked up by the next frame
+	 * without reprogramming the layer.
+	 */
 	if (plane->state->fb == old_state->fb &&
 	    plane->state->crtc_x == old_state->crtc_x &&
 	    plane->state->crtc_y == old_state->crtc_y &&
@@ -2717,6 +2737,27 @@ zynqmp_disp_plane_atomic_disable(struct drm_plane *plane,
 static int zynqmp_disp_plane_atomic_async_check(struct drm_plane *plane,
 						struct drm_plane_state *state)
 {
+	struct drm_plane_state *old_state = plane->state;
+	struct drm_crtc_state *crtc_state;
+
+	crtc_state = drm_atomic_get_new_crtc_state(state->state, state->crtc);
+	if (!crtc_state)
+		crtc_state = state->crtc->state;
+	if (!crtc_state->active || !old_state->fb)
+		return -EINVAL;
+
+	/*
+	 * The layers cover the whole output, so only the framebuffer and the
+	 * source offset can be changed without reprogramming the blender. A
+	 * format or size change goes through a full commit.
+	 */
+	if (old_state->fb->format != state->fb->format ||
+	    old_state->crtc_w != state->crtc_w ||
+	    old_state->crtc_h != state->crtc_h ||
+	    old_state->src_w != state->src_w ||
+	    old_state->src_h != state->src_h)
+		return -EINVAL;
+
 	return 0;
 }
 
@@ -2726,13 +2767,11 @@ zynqmp_disp_plane_atomic_async_update(struct drm_plane *plane,
 {
 	int ret;
 
-	if (plane->state->fb == new_state->fb)
+	if (plane->state->fb == new_state->fb &&
+	    plane->state->src_x == new_state->src_x &&
+	    plane->state->src_y == new_state->src_y)
 		return;
 
-	if (plane->state->fb &&
-	    plane->state->fb->format->format != new_state->fb->format->format)
-		zynqmp_disp_plane_disable(plane);
-
 	 /* Update the current state with new configurations */
 	swap(plane->state->fb, new_state->fb);
 	plane->state->crtc = new_state->crtc;
@@ -2789,6 +2828,7 @@ static int zynqmp_disp_create_plane(struct zynqmp_disp *disp)
 			goto err_plane;
 		drm_plane_helper_add(&layer->plane,
 				     &zynqmp_disp_plane_helper_funcs);
+		drm_plane_enable_fb_damage_clips(&layer->plane);
 		type = DRM_PLANE_TYPE_PRIMARY;
 	}
 
@@ -2870,6 +2910,37 @@ static u64 zynqmp_disp_get_dma_mask(struct xlnx_crtc *xlnx_crtc)
 	return DMA_BIT_MASK(ZYNQMP_DISP_MAX_DMA_BIT);
 }
 
+static int zynqmp_disp_wait_for_flip(struct xlnx_crtc *xlnx_crtc)
+{
+	struct zynqmp_disp *disp = xlnx_crtc_to_disp(xlnx_crtc);
+	struct zynqmp_disp_layer *layer;
+	struct dma_fence *fence;
+	unsigned int i, j;
+	long ret;
+
+	for (i = 0; i < ZYNQMP_DISP_NUM_LAYERS; i++) {
+		layer = &disp->layers[i];
+		if (!layer->enabled || layer->mode == ZYNQMP_DISP_LAYER_LIVE)
+			continue;
+
+		for (j = 0; j < layer->num_chan; j++) {
+			fence = layer->dma[j].fence;
+			if (!fence)
+				continue;
+
+			/* The new buffer is fetched within the next frame */
+			ret = dma_fence_wait_timeout(fence, false,
+						     msecs_to_jiffies(100));
+			if (ret <= 0)
+				return ret ? ret : -ETIMEDOUT;
+			if (fence->error)
+				return fence->error;
+		}
+	}
+
+	return 0;
+}
+
 /*
  * DRM crtc functions
  */
@@ -3101,6 +3172,7 @@ static int zynqmp_disp_create_crtc(struct zynqmp_disp *disp)
 	disp->xlnx_crtc.get_format = &zynqmp_disp_get_format;
 	disp->xlnx_crtc.get_align = &zynqmp_disp_get_align;
 	disp->xlnx_crtc.get_dma_mask = &zynqmp_disp_get_dma_mask;
+	disp->xlnx_crtc.wait_for_flip = &zynqmp_disp_wait_for_flip;
 	xlnx_crtc_register(disp->drm, &disp->xlnx_crtc);
 
 	return 0;
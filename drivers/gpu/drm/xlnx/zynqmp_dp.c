@@ -301,6 +301,24 @@ struct zynqmp_dp_config {
 	u8 num_colors;
 };
 
+/**
+ * struct zynqmp_dp_train_cache - Last successful link training
+ * @valid: the entry holds a successful training
+ * @dpcd: receiver capabilities of the sink the link was trained with
+ * @pclock: pixel clock of the mode the link was trained for
+ * @bw_code: link rate the training succeeded at
+ * @lane_cnt: number of lanes the training succeeded with
+ * @train_set: voltage swing and pre-emphasis the sink settled on
+ */
+struct zynqmp_dp_train_cache {
+	bool valid;
+	u8 dpcd[DP_RECEIVER_CAP_SIZE];
+	int pclock;
+	u8 bw_code;
+	u8 lane_cnt;
+	u8 train_set[ZYNQMP_DP_MAX_LANES];
+};
+
 /**
  * struct zynqmp_dp - Xilinx DisplayPort core
  * @encoder: the drm encoder structure
@@ -324,6 +342,7 @@ struct zynqmp_dp_config {
  * @link_config: common link configuration between IP core and sink device
  * @mode: current mode between IP core and sink device
  * @train_set: set of training data
+ * @train_cache: last successful link training
  */
 struct zynqmp_dp {
 	struct drm_encoder encoder;
@@ -349,6 +368,7 @@ struct zynqmp_dp {
 	struct zynqmp_dp_link_config link_config;
 	struct zynqmp_dp_mode mode;
 	u8 train_set[ZYNQMP_DP_MAX_LANES];
+	struct zynqmp_dp_train_cache train_cache;
 };
 
 static inline struct zynqmp_dp *encoder_to_dp(struct drm_encoder *encoder)
@@ -837,14 +857,69 @@ static int zynqmp_dp_link_train_ce(struct zynqmp_dp *dp)
 	return 0;
 }
 
+/**
+ * zynqmp_dp_train_cache_match - Check the training cache against the link
+ * @dp: DisplayPort IP core structure
+ *
+ * Return: true if the last successful training was done with the connected
+ * sink for the current mode.
+ */
+static bool zynqmp_dp_train_cache_match(struct zynqmp_dp *dp)
+{
+	struct zynqmp_dp_train_cache *cache = &dp->train_cache;
+
+	return cache->valid && cache->pclock == dp->mode.pclock &&
+	       !memcmp(cache->dpcd, dp->dpcd, sizeof(dp->dpcd));
+}
+
+/**
+ * zynqmp_dp_link_ok - Check if the link needs no training
+ * @dp: DisplayPort IP core structure
+ *
+ * Return: true if both ends are still set up for the current link rate and
+ * lane count, and the sink reports clock recovery and channel equalization
+ * done on all the lanes.
+ */
+static bool zynqmp_dp_link_ok(struct zynqmp_dp *dp)
+{
+	u8 link_status[DP_LINK_STATUS_SIZE];
+	u8 link_set[2];
+	int ret;
+
+	if (zynqmp_dp_read(dp->iomem, ZYNQMP_DP_TX_LINK_BW_SET) !=
+	    dp->mode.bw_code ||
+	    zynqmp_dp_read(dp->iomem, ZYNQMP_DP_TX_LANE_CNT_SET) !=
+	    dp->mode.lane_cnt)
+		return false;
+
+	ret = drm_dp_dpcd_read(&dp->aux, DP_LINK_BW_SET, link_set,
+			       sizeof(link_set));
+	if (ret != sizeof(link_set) || link_set[0] != dp->mode.bw_code ||
+	    (link_set[1] & DP_LANE_COUNT_MASK) != dp->mode.lane_cnt)
+		return false;
+
+	ret = drm_dp_dpcd_read_link_status(&dp->aux, link_status);
+	if (ret < 0)
+		return false;
+
+	return drm_dp_clock_recovery_ok(link_status, dp->mode.lane_cnt) &&
+	       drm_dp_channel_eq_ok(link_status, dp->mode.lane_cnt);
+}
+
 /**
  * zynqmp_dp_link_train - Train the link
  * @dp: DisplayPort IP core structure
  *
+ * The training starts from the voltage swing and pre-emphasis of the last
+ * successful training of the sink at the same link rate and lane count, so
+ * it usually completes in one iteration of each phase. If that fails, it is
+ * redone from the lowest levels.
+ *
  * Return: 0 if all trains are done successfully, or corresponding error code.
  */
 static int zynqmp_dp_train(struct zynqmp_dp *dp)
 {
+	struct zynqmp_dp_train_cache *cache = &dp->train_cache;
 	u32 reg;
 	u8 bw_code = dp->mode.bw_code;
 	u8 lane_cnt = dp->mode.lane_cnt;
@@ -908,14 +983,26 @@ static int zynqmp_dp_train(struct zynqmp_dp *dp)
 		return ret;
 
 	zynqmp_dp_write(dp->iomem, ZYNQMP_DP_TX_SCRAMBLING_DISABLE, 1);
-	memset(dp->train_set, 0, ARRAY_SIZE(dp->train_set));
-	ret = zynqmp_dp_link_train_cr(dp);
-	if (ret)
-		return ret;
+	ret = -EIO;
+	if (zynqmp_dp_train_cache_match(dp) &&
+	    cache->bw_code == bw_code && cache->lane_cnt == lane_cnt) {
+		memcpy(dp->train_set, cache->train_set,
+		       ARRAY_SIZE(dp->train_set));
+		ret = zynqmp_dp_link_train_cr(dp);
+		if (!ret)
+			ret = zynqmp_dp_link_train_ce(dp);
+	}
 
-	ret = zynqmp_dp_link_train_ce(dp);
-	if (ret)
-		return ret;
+	if (ret) {
+		memset(dp->train_set, 0, ARRAY_SIZE(dp->train_set));
+		ret = zynqmp_dp_link_train_cr(dp);
+		if (!ret)
+			ret = zynqmp_dp_link_train_ce(dp);
+		if (ret) {
+			cache->valid = false;
+			return ret;
+		}
+	}
 
 	ret = drm_dp_dpcd_writeb(&dp->aux, DP_TRAINING_PATTERN_SET,
 				 DP_TRAINING_PATTERN_DISABLE);
@@ -928,6 +1015,13 @@ static int zynqmp_dp_train(struct zynqmp_dp *dp)
 
 	zynqmp_dp_write(dp->iomem, ZYNQMP_DP_TX_SCRAMBLING_DISABLE, 0);
 
+	memcpy(cache->dpcd, dp->dpcd, sizeof(cache->dpcd));
+	cache->pclock = dp->mode.pclock;
+	cache->bw_code = bw_code;
+	cache->lane_cnt = lane_cnt;
+	memcpy(cache->train_set, dp->train_set, ARRAY_SIZE(cache->train_set));
+	cache->valid = true;
+
 	return 0;
 }
 
@@ -936,13 +1030,25 @@ static int zynqmp_dp_train(struct zynqmp_dp *dp)
  * @dp: DisplayPort IP core structure
  *
  * Train the link by downshifting the link rate if training is not successful.
+ * For the mode and sink of the last successful training, start from the link
+ * rate and lane count it ended up with, and leave the link alone if it is
+ * still up with them.
  */
 static void zynqmp_dp_train_loop(struct zynqmp_dp *dp)
 {
 	struct zynqmp_dp_mode *mode = &dp->mode;
-	u8 bw = mode->bw_code;
+	u8 bw;
 	int ret;
 
+	if (zynqmp_dp_train_cache_match(dp)) {
+		mode->bw_code = dp->train_cache.bw_code;
+		mode->lane_cnt = dp->train_cache.lane_cnt;
+		if (dp->status == connector_status_connected && dp->enabled &&
+		    zynqmp_dp_link_ok(dp))
+			return;
+	}
+
+	bw = mode->bw_code;
 	do {
 		if (dp->status == connector_status_disconnected ||
 		    !dp->enabled)
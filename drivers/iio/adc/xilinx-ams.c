@@ -18,6 +18,8 @@
 #include <linux/iio/sysfs.h>
 #include <linux/iio/events.h>
 #include <linux/iio/buffer.h>
+#include <linux/iio/trigger_consumer.h>
+#include <linux/iio/triggered_buffer.h>
 #include <linux/io.h>
 
 #include "xilinx-ams.h"
@@ -311,6 +313,17 @@ static void ams_read_vcc_reg(struct ams *ams, unsigned int offset, u32 *data)
 	ams_enable_channel_sequence(ams);
 }
 
+static void ams_read_chan(struct ams *ams, struct iio_chan_spec const *chan,
+			  u32 *data)
+{
+	if (chan->scan_index >= (PS_SEQ_MAX * 3))
+		ams_read_vcc_reg(ams, chan->address, data);
+	else if (chan->scan_index >= PS_SEQ_MAX)
+		ams->pl_bus->read(ams, chan->address, data);
+	else
+		ams_ps_read_reg(ams, chan->address, data);
+}
+
 static int ams_read_raw(struct iio_dev *indio_dev,
 			struct iio_chan_spec const *chan,
 			int *val, int *val2, long mask)
@@ -320,12 +333,7 @@ static int ams_read_raw(struct iio_dev *indio_dev,
 	switch (mask) {
 	case IIO_CHAN_INFO_RAW:
 		mutex_lock(&ams->mutex);
-		if (chan->scan_index >= (PS_SEQ_MAX * 3))
-			ams_read_vcc_reg(ams, chan->address, val);
-		else if (chan->scan_index >= PS_SEQ_MAX)
-			ams->pl_bus->read(ams, chan->address, val);
-		else
-			ams_ps_read_reg(ams, chan->address, val);
+		ams_read_chan(ams, chan, val);
 		mutex_unlock(&ams->mutex);
 
 		*val2 = 0;
@@ -384,6 +392,100 @@ static int ams_read_raw(struct iio_dev *indio_dev,
 	return -EINVAL;
 }
 
+static const struct iio_chan_spec *
+ams_scan_index_to_channel(struct iio_dev *indio_dev, int scan_index)
+{
+	int i;
+
+	for (i = 0; i < indio_dev->num_channels; i++)
+		if (indio_dev->channels[i].scan_index == scan_index)
+			break;
+
+	return &indio_dev->channels[i];
+}
+
+static int ams_update_scan_mode(struct iio_dev *indio_dev,
+				const unsigned long *mask)
+{
+	struct ams *ams = iio_priv(indio_dev);
+	unsigned int i, n;
+
+	kfree(ams->scan_chans);
+	kfree(ams->data);
+
+	n = bitmap_weight(mask, indio_dev->masklength);
+	ams->scan_chans = kcalloc(n, sizeof(*ams->scan_chans), GFP_KERNEL);
+	ams->data = kcalloc(n, sizeof(*ams->data), GFP_KERNEL);
+	if (!ams->scan_chans || !ams->data) {
+		kfree(ams->scan_chans);
+		kfree(ams->data);
+		ams->scan_chans = NULL;
+		ams->data = NULL;
+		return -ENOMEM;
+	}
+
+	/*
+	 * Resolve the channels once here, in scan order, so that the trigger
+	 * handler only has to walk the list and read the result registers.
+	 */
+	n = 0;
+	for_each_set_bit(i, mask, indio_dev->masklength)
+		ams->scan_chans[n++] = ams_scan_index_to_channel(indio_dev, i);
+
+	return 0;
+}
+
+static irqreturn_t ams_trigger_handler(int irq, void *p)
+{
+	struct iio_poll_func *pf = p;
+	struct iio_dev *indio_dev = pf->indio_dev;
+	struct ams *ams = iio_priv(indio_dev);
+	unsigned int i, n;
+	u32 val;
+
+	if (!ams->data)
+		goto out;
+
+	n = bitmap_weight(indio_dev->active_scan_mask, indio_dev->masklength);
+
+	/*
+	 * The sequencer keeps converting all the PS and PL channels in
+	 * continuous mode, so a scan is just one pass over the result
+	 * registers under a single lock.
+	 */
+	mutex_lock(&ams->mutex);
+	for (i = 0; i < n; i++) {
+		ams_read_chan(ams, ams->scan_chans[i], &val);
+		ams->data[i] = val;
+	}
+	mutex_unlock(&ams->mutex);
+
+	iio_push_to_buffers(indio_dev, ams->data);
+
+out:
+	iio_trigger_notify_done(indio_dev->trig);
+
+	return IRQ_HANDLED;
+}
+
+static bool ams_validate_scan_mask(struct iio_dev *indio_dev,
+				   const unsigned long *mask)
+{
+	/*
+	 * The AMS control channels are only converted by switching the PS
+	 * sysmon to single channel mode, which takes the channel out of the
+	 * sequence and needs a settling delay. Keep them out of the buffer.
+	 */
+	return find_next_bit(mask, indio_dev->masklength, PS_SEQ_MAX * 3) >=
+	       indio_dev->masklength;
+}
+
+static const struct iio_buffer_setup_ops ams_buffer_ops = {
+	.postenable = &iio_triggered_buffer_postenable,
+	.predisable = &iio_triggered_buffer_predisable,
+	.validate_scan_mask = &ams_validate_scan_mask,
+};
+
 static int ams_get_alarm_offset(int scan_index, enum iio_event_direction dir)
 {
 	int offset = 0;
@@ -968,6 +1070,7 @@ static int ams_parse_dt(struct iio_dev *indio_dev, struct platform_device *pdev)
 
 static const struct iio_info iio_pl_info = {
 	.read_raw = &ams_read_raw,
+	.update_scan_mode = &ams_update_scan_mode,
 	.read_event_config = &ams_read_event_config,
 	.write_event_config = &ams_write_event_config,
 	.read_event_value = &ams_read_event_value,
@@ -1051,6 +1154,15 @@ static int ams_probe(struct platform_device *pdev)
 		goto clk_disable;
 	}
 
+	ret = devm_iio_triggered_buffer_setup(&pdev->dev, indio_dev,
+					      &iio_pollfunc_store_time,
+					      &ams_trigger_handler,
+					      &ams_buffer_ops);
+	if (ret) {
+		dev_err(&pdev->dev, "failed to setup triggered buffer\n");
+		goto clk_disable;
+	}
+
 	platform_set_drvdata(pdev, indio_dev);
 
 	return iio_device_register(indio_dev);
@@ -1070,6 +1182,8 @@ static int ams_remove(struct platform_device *pdev)
 	/* Unregister the device */
 	iio_device_unregister(indio_dev);
 	clk_disable_unprepare(ams->clk);
+	kfree(ams->scan_chans);
+	kfree(ams->data);
 	return 0;
 }
 
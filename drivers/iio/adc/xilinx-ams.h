@@ -264,6 +264,9 @@ struct ams {
 	u64 intr_mask;
 	int irq;
 
+	const struct iio_chan_spec **scan_chans;
+	u16 *data;
+
 	struct delayed_work ams_unmask_work;
 	const struct ams_pl_bus_ops *pl_bus;
 };
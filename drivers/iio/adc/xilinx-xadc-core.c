@@ -660,13 +660,19 @@ static irqreturn_t xadc_trigger_handler(int irq, void *p)
 	if (!xadc->data)
 		goto out;
 
+	/*
+	 * The sequencer has just completed a full pass, so read the whole scan
+	 * in one go instead of bouncing the device mutex for every channel.
+	 */
 	j = 0;
+	mutex_lock(&xadc->mutex);
 	for_each_set_bit(i, indio_dev->active_scan_mask,
 		indio_dev->masklength) {
 		chan = xadc_scan_index_to_channel(i);
-		xadc_read_adc_reg(xadc, chan, &xadc->data[j]);
+		_xadc_read_adc_reg(xadc, chan, &xadc->data[j]);
 		j++;
 	}
+	mutex_unlock(&xadc->mutex);
 
 	iio_push_to_buffers(indio_dev, xadc->data);
 
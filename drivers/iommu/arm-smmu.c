@@ -1309,6 +1309,40 @@ struct arm_smmu_device *arm_smmu_get_by_fwnode(struct fwnode_handle *fwnode)
 	return dev ? dev_get_drvdata(dev) : NULL;
 }
 
+/*
+ * Apply the translation policy a master asks for in the device tree:
+ * "xlnx,iommu-passthrough" puts it in an identity domain, so a trusted
+ * high-bandwidth master skips translation altogether, while
+ * "xlnx,iommu-non-strict" defers and batches the IOTLB invalidations of its
+ * DMA domain through the DMA layer flush queue, as iommu.strict=0 does for
+ * all of them.
+ */
+static void arm_smmu_apply_master_policy(struct device *dev)
+{
+	struct device_node *np = dev->of_node;
+	struct iommu_domain *domain;
+	int attr = 1;
+
+	if (!np)
+		return;
+
+	if (of_property_read_bool(np, "xlnx,iommu-passthrough")) {
+		if (iommu_request_dm_for_dev(dev))
+			dev_warn(dev, "failed to set up identity mapping\n");
+		else
+			dev_info(dev, "using identity mapping\n");
+		return;
+	}
+
+	if (of_property_read_bool(np, "xlnx,iommu-non-strict")) {
+		domain = iommu_get_domain_for_dev(dev);
+		if (domain && domain->type == IOMMU_DOMAIN_DMA)
+			iommu_domain_set_attr(domain,
+					      DOMAIN_ATTR_DMA_USE_FLUSH_QUEUE,
+					      &attr);
+	}
+}
+
 static int arm_smmu_add_device(struct device *dev)
 {
 	struct arm_smmu_device *smmu;
@@ -1376,6 +1410,8 @@ static int arm_smmu_add_device(struct device *dev)
 	device_link_add(dev, smmu->dev,
 			DL_FLAG_PM_RUNTIME | DL_FLAG_AUTOREMOVE_SUPPLIER);
 
+	arm_smmu_apply_master_policy(dev);
+
 	return 0;
 
 out_cfg_free:
@@ -1499,6 +1535,20 @@ static int arm_smmu_domain_set_attr(struct iommu_domain *domain,
 		switch (attr) {
 		case DOMAIN_ATTR_DMA_USE_FLUSH_QUEUE:
 			smmu_domain->non_strict = *(int *)data;
+			/*
+			 * The default domain is already attached, and so its
+			 * page table allocated, when a master asks for it.
+			 */
+			if (smmu_domain->pgtbl_ops) {
+				struct io_pgtable_cfg *cfg =
+					&io_pgtable_ops_to_pgtable(
+						smmu_domain->pgtbl_ops)->cfg;
+
+				if (smmu_domain->non_strict)
+					cfg->quirks |= IO_PGTABLE_QUIRK_NON_STRICT;
+				else
+					cfg->quirks &= ~IO_PGTABLE_QUIRK_NON_STRICT;
+			}
 			break;
 		default:
 			ret = -ENODEV;
@@ -20,6 +20,7 @@
 #include <linux/of_irq.h>
 #include <linux/cpuhotplug.h>
 #include <linux/smp.h>
+#include <linux/interrupt.h>
 
 /* No one else should require these constants, so define them locally here. */
 #define ISR 0x00			/* Interrupt Status Register */
@@ -30,6 +31,7 @@
 #define CIE 0x14			/* Clear Interrupt Enable bits */
 #define IVR 0x18			/* Interrupt Vector Register */
 #define MER 0x1c			/* Master Enable Register */
+#define IMR 0x20			/* Interrupt Mode Register */
 
 #define MER_ME (1<<0)
 #define MER_HIE (1<<1)
@@ -41,6 +43,9 @@ struct xintc_irq_chip {
 	struct			irq_chip *intc_dev;
 	u32				nr_irq;
 	u32				sw_irq;
+	unsigned int			parent_irq;
+	bool				has_ipr;
+	bool				has_fast;
 };
 
 static DEFINE_STATIC_KEY_FALSE(xintc_is_be);
@@ -129,18 +134,26 @@ static void intc_mask_ack(struct irq_data *d)
 	xintc_write(local_intc, IAR, mask);
 }
 
-static unsigned int xintc_get_irq_local(struct xintc_irq_chip *local_intc)
+#ifdef CONFIG_SMP
+/*
+ * The sources of a cascaded controller share its output line, so they all
+ * follow the affinity of the parent interrupt.
+ */
+static int intc_set_affinity(struct irq_data *d, const struct cpumask *mask,
+			     bool force)
 {
-	int hwirq, irq = -1;
+	struct xintc_irq_chip *local_intc = irq_data_get_irq_chip_data(d);
+	int ret;
 
-	hwirq = xintc_read(local_intc, IVR);
-	if (hwirq != -1U)
-		irq = irq_find_mapping(local_intc->domain, hwirq);
+	ret = irq_set_affinity(local_intc->parent_irq, mask);
+	if (ret)
+		return ret;
 
-	pr_debug("irq-xilinx: hwirq=%d, irq=%d\n", hwirq, irq);
+	irq_data_update_effective_affinity(d, mask);
 
-	return irq;
+	return IRQ_SET_MASK_OK_DONE;
 }
+#endif
 
 static int xintc_map(struct irq_domain *d, unsigned int irq, irq_hw_number_t hw)
 {
@@ -181,9 +194,11 @@ static int xintc_map(struct irq_domain *d, unsigned int irq, irq_hw_number_t hw)
 	/*
 	 * Setup all IRQs to be per CPU because servicing it by different
 	 * cpu is not implemented yet. And for uniprocessor system this flag
-	 * is nop all time time.
+	 * is nop all time time. Cascaded controllers follow the affinity of
+	 * their parent interrupt instead.
 	 */
-	irq_set_status_flags(irq, IRQ_PER_CPU);
+	if (!local_intc->parent_irq)
+		irq_set_status_flags(irq, IRQ_PER_CPU);
 
 	pr_debug("cpu: %u, xintc_map: hwirq=%u, irq=%u, edge=%u\n",
 		 smp_processor_id(), (u32)hw, irq, edge);
@@ -210,6 +225,13 @@ static void xil_intc_initial_setup(struct xintc_irq_chip *irqc)
 	/* Acknowledge any pending interrupts just in case. */
 	xintc_write(irqc, IAR, 0xffffffff);
 
+	/*
+	 * Fast interrupts vector the processor directly and are acknowledged
+	 * by it, Linux demultiplexes every source in normal mode.
+	 */
+	if (irqc->has_fast)
+		xintc_write(irqc, IMR, 0);
+
 	/* Turn on the Master Enable. */
 	xintc_write(irqc, MER, MER_HIE | MER_ME);
 	if (!(xintc_read(irqc, MER) & (MER_HIE | MER_ME))) {
@@ -225,20 +247,36 @@ static void xil_intc_initial_setup(struct xintc_irq_chip *irqc)
 	}
 }
 
+static unsigned long xintc_get_pending(struct xintc_irq_chip *irqc)
+{
+	u32 pending;
+
+	if (irqc->has_ipr)
+		pending = xintc_read(irqc, IPR);
+	else
+		pending = xintc_read(irqc, ISR) & xintc_read(irqc, IER);
+
+	return pending & GENMASK(irqc->nr_irq - 1, 0);
+}
+
 static void xil_intc_irq_handler(struct irq_desc *desc)
 {
 	struct irq_chip *chip = irq_desc_get_chip(desc);
 	struct xintc_irq_chip *local_intc =
 		irq_data_get_irq_handler_data(&desc->irq_data);
-	u32 pending;
+	unsigned long pending;
+	unsigned int hwirq;
 
 	chained_irq_enter(chip, desc);
-	do {
-		pending = xintc_get_irq_local(local_intc);
-		if (pending == -1U)
-			break;
-		generic_handle_irq(pending);
-	} while (true);
+	/*
+	 * Handle all the sources pending at once, lowest first as the IVR
+	 * would return them, instead of reading the IVR for each of them.
+	 */
+	while ((pending = xintc_get_pending(local_intc))) {
+		for_each_set_bit(hwirq, &pending, local_intc->nr_irq)
+			generic_handle_irq(irq_find_mapping(local_intc->domain,
+							    hwirq));
+	}
 	chained_irq_exit(chip, desc);
 }
 
@@ -294,7 +332,7 @@ static void xil_intc_handle_irq(struct pt_regs *regs)
 static int __init xilinx_intc_of_init(struct device_node *intc,
 					     struct device_node *parent)
 {
-	int ret, irq;
+	int ret;
 	struct xintc_irq_chip *irqc;
 	struct irq_chip *intc_dev;
 	u32 cpu_id = 0;
@@ -338,6 +376,9 @@ static int __init xilinx_intc_of_init(struct device_node *intc,
 	/* sw irqs are optinal */
 	of_property_read_u32(intc, "xlnx,num-sw-intr", &irqc->sw_irq);
 
+	irqc->has_ipr = of_property_read_bool(intc, "xlnx,has-ipr");
+	irqc->has_fast = of_property_read_bool(intc, "xlnx,has-fast");
+
 	pr_info("irq-xilinx: %pOF: num_irq=%d, sw_irq=%d, edge=0x%x\n",
 		intc, irqc->nr_irq, irqc->sw_irq, irqc->intr_mask);
 
@@ -360,6 +401,18 @@ static int __init xilinx_intc_of_init(struct device_node *intc,
 	intc_dev->irq_mask_ack = intc_mask_ack,
 	irqc->intc_dev = intc_dev;
 
+	if (parent) {
+		irqc->parent_irq = irq_of_parse_and_map(intc, 0);
+		if (!irqc->parent_irq) {
+			pr_err("irq-xilinx: interrupts property not in DT\n");
+			ret = -EINVAL;
+			goto err_alloc;
+		}
+#ifdef CONFIG_SMP
+		intc_dev->irq_set_affinity = intc_set_affinity;
+#endif
+	}
+
 	irqc->domain = irq_domain_add_linear(intc, irqc->nr_irq,
 						  &xintc_irq_domain_ops, irqc);
 	if (!irqc->domain) {
@@ -369,16 +422,8 @@ static int __init xilinx_intc_of_init(struct device_node *intc,
 	}
 
 	if (parent) {
-		irq = irq_of_parse_and_map(intc, 0);
-		if (irq) {
-			irq_set_chained_handler_and_data(irq,
-							 xil_intc_irq_handler,
-							 irqc);
-		} else {
-			pr_err("irq-xilinx: interrupts property not in DT\n");
-			ret = -EINVAL;
-			goto err_alloc;
-		}
+		irq_set_chained_handler_and_data(irqc->parent_irq,
+						 xil_intc_irq_handler, irqc);
 		xil_intc_initial_setup(irqc);
 		return 0;
 	}
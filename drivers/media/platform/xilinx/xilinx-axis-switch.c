@@ -38,6 +38,8 @@
  * @subdev: The v4l2 subdev structure
  * @pads: media pads
  * @routing: sink pad connected to each source pad (-1 if none)
+ * @tdest: TDEST (CSI-2 virtual channel) decoded to each source pad in TDEST
+ *	   routing mode (-1 if not described)
  * @formats: active V4L2 media bus formats on sink pads
  * @nsinks: number of sink pads (1 to 8)
  * @nsources: number of source pads (2 to 8)
@@ -51,6 +53,7 @@ struct xvswitch_device {
 	struct v4l2_subdev subdev;
 	struct media_pad *pads;
 	int routing[MAX_VSW_SRCS];
+	int tdest[MAX_VSW_SRCS];
 	struct v4l2_mbus_framefmt *formats;
 	u32 nsinks;
 	u32 nsources;
@@ -75,6 +78,30 @@ static inline void xvswitch_write(struct xvswitch_device *xvsw, u32 addr,
 	iowrite32(value, xvsw->iomem + addr);
 }
 
+/*
+ * Write the routing table to the MI mux registers. The switch only applies
+ * them on the register update, once the transfers in progress on its ports
+ * are complete, so all the routes change together and no transfer is cut.
+ */
+static void xvsw_write_routing(struct xvswitch_device *xvsw)
+{
+	unsigned int i;
+
+	for (i = 0; i < MAX_VSW_SRCS; i++) {
+		u32 val;
+
+		if (xvsw->routing[i] != -1)
+			val = xvsw->routing[i];
+		else
+			val = XVSW_MI_MUX_DISABLE_MASK;
+
+		xvswitch_write(xvsw, XVSW_MI_MUX_REG_BASE + (i * 4),
+			       val);
+	}
+
+	xvswitch_write(xvsw, XVSW_CTRL_REG, XVSW_CTRL_REG_UPDATE_MASK);
+}
+
 /* -----------------------------------------------------------------------------
  * V4L2 Subdevice Video Operations
  */
@@ -103,19 +130,7 @@ static int xvsw_s_stream(struct v4l2_subdev *subdev, int enable)
 	 * from routing table write the values into respective reg
 	 * and enable
 	 */
-	for (i = 0; i < MAX_VSW_SRCS; i++) {
-		u32 val;
-
-		if (xvsw->routing[i] != -1)
-			val = xvsw->routing[i];
-		else
-			val = XVSW_MI_MUX_DISABLE_MASK;
-
-		xvswitch_write(xvsw, XVSW_MI_MUX_REG_BASE + (i * 4),
-			       val);
-	}
-
-	xvswitch_write(xvsw, XVSW_CTRL_REG, XVSW_CTRL_REG_UPDATE_MASK);
+	xvsw_write_routing(xvsw);
 
 	return 0;
 }
@@ -199,7 +214,8 @@ static int xvsw_set_format(struct v4l2_subdev *subdev,
 		return xvsw_get_format(subdev, cfg, fmt);
 	}
 
-	if (xvsw->nsinks == 1 && fmt->pad != 0) {
+	if (xvsw->nsinks == 1 && fmt->pad != 0 &&
+	    xvsw->tdest[fmt->pad - 1] < 0) {
 		struct v4l2_mbus_framefmt *sinkformat;
 
 		/*
@@ -207,6 +223,11 @@ static int xvsw_set_format(struct v4l2_subdev *subdev,
 		 * source pads will have same property as sink pad, assuming
 		 * streams going to each source pad will have same
 		 * properties.
+		 *
+		 * This doesn't hold when the source pad decodes a given
+		 * TDEST, e.g. a CSI-2 virtual channel of a link aggregating
+		 * several sensors. Each virtual channel then carries its own
+		 * format, which is set on the source pad below.
 		 */
 
 		/* get sink pad format */
@@ -283,10 +304,40 @@ static int xvsw_get_routing(struct v4l2_subdev *subdev,
 	return 0;
 }
 
+/*
+ * While streaming, a source pad can only be switched from a sink pad to
+ * another one with the same format, so that the pipeline downstream, which
+ * was validated at stream on, keeps receiving what it was configured for.
+ * Source pads can't be enabled or disabled.
+ */
+static int xvsw_check_live_routing(struct xvswitch_device *xvsw,
+				   const int *routing)
+{
+	const struct v4l2_mbus_framefmt *from, *to;
+	unsigned int i;
+
+	for (i = 0; i < xvsw->nsources; ++i) {
+		if (routing[i] == xvsw->routing[i])
+			continue;
+
+		if (routing[i] < 0 || xvsw->routing[i] < 0)
+			return -EBUSY;
+
+		from = &xvsw->formats[xvsw->routing[i]];
+		to = &xvsw->formats[routing[i]];
+		if (from->code != to->code || from->width != to->width ||
+		    from->height != to->height || from->field != to->field)
+			return -EBUSY;
+	}
+
+	return 0;
+}
+
 static int xvsw_set_routing(struct v4l2_subdev *subdev,
 			    struct v4l2_subdev_routing *route)
 {
 	struct xvswitch_device *xvsw = to_xvsw(subdev);
+	int routing[MAX_VSW_SRCS];
 	unsigned int i;
 	int ret = 0;
 
@@ -294,19 +345,37 @@ static int xvsw_set_routing(struct v4l2_subdev *subdev,
 	if (xvsw->tdest_routing)
 		return -EINVAL;
 
+	for (i = 0; i < MAX_VSW_SRCS; ++i)
+		routing[i] = -1;
+
+	for (i = 0; i < route->num_routes; ++i) {
+		u32 sink = route->routes[i].sink;
+		u32 source = route->routes[i].source;
+
+		if (sink >= xvsw->nsinks || source < xvsw->nsinks ||
+		    source >= xvsw->nsinks + xvsw->nsources)
+			return -EINVAL;
+
+		routing[source - xvsw->nsinks] = sink;
+	}
+
 	mutex_lock(&subdev->entity.graph_obj.mdev->graph_mutex);
 
+	/*
+	 * Routes of a streaming switch are changed in place: the other
+	 * streams keep running and the switched ones change source at the
+	 * end of the transfer in progress, see xvsw_write_routing().
+	 */
 	if (subdev->entity.stream_count) {
-		ret = -EBUSY;
-		goto done;
+		ret = xvsw_check_live_routing(xvsw, routing);
+		if (ret)
+			goto done;
 	}
 
-	for (i = 0; i < xvsw->nsources; ++i)
-		xvsw->routing[i] = -1;
+	memcpy(xvsw->routing, routing, sizeof(routing));
 
-	for (i = 0; i < route->num_routes; ++i)
-		xvsw->routing[route->routes[i].source - xvsw->nsinks] =
-			route->routes[i].sink;
+	if (subdev->entity.stream_count)
+		xvsw_write_routing(xvsw);
 
 done:
 	mutex_unlock(&subdev->entity.graph_obj.mdev->graph_mutex);
@@ -386,6 +455,7 @@ static int xvsw_parse_of(struct xvswitch_device *xvsw)
 	struct device_node *ports;
 	struct device_node *port;
 	unsigned int nports = 0;
+	unsigned int i;
 	u32 routing_mode = 0;
 	int ret;
 
@@ -441,8 +511,12 @@ static int xvsw_parse_of(struct xvswitch_device *xvsw)
 	if (!ports)
 		ports = node;
 
+	for (i = 0; i < MAX_VSW_SRCS; i++)
+		xvsw->tdest[i] = -1;
+
 	for_each_child_of_node(ports, port) {
 		struct device_node *endpoint;
+		u32 reg, tdest;
 
 		if (!port->name || of_node_cmp(port->name, "port"))
 			continue;
@@ -450,8 +524,25 @@ static int xvsw_parse_of(struct xvswitch_device *xvsw)
 		endpoint = of_get_next_child(port, NULL);
 		if (!endpoint) {
 			dev_err(xvsw->dev, "No port at\n");
+			of_node_put(port);
 			return -EINVAL;
 		}
+		of_node_put(endpoint);
+
+		/*
+		 * In TDEST routing mode, a source port may describe the
+		 * TDEST value the switch decodes to it, which is the virtual
+		 * channel of the stream when fed by a CSI-2 Rx subsystem.
+		 */
+		if (xvsw->tdest_routing &&
+		    !of_property_read_u32(port, "reg", &reg) &&
+		    reg >= xvsw->nsinks &&
+		    reg < xvsw->nsinks + xvsw->nsources &&
+		    !of_property_read_u32(port, "xlnx,tdest", &tdest)) {
+			xvsw->tdest[reg - xvsw->nsinks] = tdest;
+			dev_dbg(xvsw->dev, "TDEST %u routed to source pad %u\n",
+				tdest, reg);
+		}
 
 		/* Count the number of ports. */
 		nports++;
@@ -9,16 +9,23 @@
  *           Laurent Pinchart <laurent.pinchart@ideasonboard.com>
  */
 
+#include <linux/debugfs.h>
 #include <linux/dma/xilinx_dma.h>
 #include <linux/dma/xilinx_frmbuf.h>
 #include <linux/lcm.h>
 #include <linux/list.h>
+#include <linux/log2.h>
+#include <linux/math64.h>
 #include <linux/module.h>
 #include <linux/of.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/xilinx-v4l2-controls.h>
 
+#include <media/media-request.h>
 #include <media/v4l2-dev.h>
+#include <media/v4l2-device.h>
+#include <media/v4l2-event.h>
 #include <media/v4l2-fh.h>
 #include <media/v4l2-ioctl.h>
 #include <media/videobuf2-v4l2.h>
@@ -38,6 +45,12 @@
 #define XVIP_DMA_MIN_HEIGHT		1U
 #define XVIP_DMA_MAX_HEIGHT		8191U
 
+/* Statistics buffers are transferred as a single line of bytes */
+#define XVIP_DMA_META_DEF_SIZE		4096U
+
+/* Number of events queued per file handle before the oldest is dropped */
+#define XVIP_DMA_NUM_EVENTS		4
+
 /* -----------------------------------------------------------------------------
  * Helper functions
  */
@@ -57,6 +70,11 @@ xvip_dma_remote_subdev(struct media_pad *local, u32 *pad)
 	return media_entity_to_v4l2_subdev(remote->entity);
 }
 
+static inline bool xvip_dma_is_meta(struct xvip_dma *dma)
+{
+	return dma->format.type == V4L2_BUF_TYPE_META_CAPTURE;
+}
+
 static int xvip_dma_verify_format(struct xvip_dma *dma)
 {
 	struct v4l2_subdev_format fmt;
@@ -72,6 +90,10 @@ static int xvip_dma_verify_format(struct xvip_dma *dma)
 	if (ret < 0)
 		return ret == -ENOIOCTLCMD ? -EINVAL : ret;
 
+	/* Statistics are produced on fixed format pads. */
+	if (xvip_dma_is_meta(dma))
+		return fmt.format.code == MEDIA_BUS_FMT_FIXED ? 0 : -EINVAL;
+
 	if (dma->fmtinfo->code != fmt.format.code)
 		return -EINVAL;
 
@@ -257,19 +279,147 @@ static int xvip_pipeline_prepare(struct xvip_pipeline *pipe,
  * @queue: buffer list entry in the DMA engine queued buffers list
  * @dma: DMA channel that uses the buffer
  * @desc: Descriptor associated with this structure
+ * @req_done: the controls of the buffer request have been applied
+ * @fence: write fence attached to the dma-bufs of an imported capture buffer
  */
 struct xvip_dma_buffer {
 	struct vb2_v4l2_buffer buf;
 	struct list_head queue;
 	struct xvip_dma *dma;
 	struct dma_async_tx_descriptor *desc;
+	bool req_done;
+	struct dma_fence *fence;
+	u64 queue_ts;
 };
 
 #define to_xvip_dma_buffer(vb)	container_of(vb, struct xvip_dma_buffer, buf)
 
+/* -----------------------------------------------------------------------------
+ * Requests
+ */
+
+/**
+ * xvip_dma_request_ctrls - Apply and complete the controls of a request
+ * @dma: The DMA channel
+ * @req: The media request
+ * @apply: Apply the control values stored in the request
+ *
+ * The controls of a request can be set through the video node or through any
+ * sub-device of the composite device. Apply the request to all the control
+ * handlers when @apply is true, and then mark the request controls as
+ * completed with the values that are now current.
+ */
+static void xvip_dma_request_ctrls(struct xvip_dma *dma,
+				   struct media_request *req, bool apply)
+{
+	struct v4l2_device *v4l2_dev = &dma->xdev->v4l2_dev;
+	struct v4l2_subdev *subdev;
+
+	if (apply) {
+		v4l2_ctrl_request_setup(req, &dma->ctrl_handler);
+		v4l2_device_for_each_subdev(subdev, v4l2_dev)
+			v4l2_ctrl_request_setup(req, subdev->ctrl_handler);
+	}
+
+	v4l2_ctrl_request_complete(req, &dma->ctrl_handler);
+	v4l2_device_for_each_subdev(subdev, v4l2_dev)
+		v4l2_ctrl_request_complete(req, subdev->ctrl_handler);
+}
+
+/**
+ * xvip_dma_next_request - Get the request of the next buffer to be processed
+ * @dma: The DMA channel
+ *
+ * Must be called with the queued_lock held.
+ *
+ * Return: the request of the first queued buffer with a reference taken, or
+ * NULL if the buffer has no request or its request has already been applied.
+ */
+static struct media_request *xvip_dma_next_request(struct xvip_dma *dma)
+{
+	struct xvip_dma_buffer *buf;
+	struct media_request *req;
+
+	buf = list_first_entry_or_null(&dma->queued_bufs,
+				       struct xvip_dma_buffer, queue);
+	if (!buf || buf->req_done)
+		return NULL;
+
+	req = buf->buf.vb2_buf.req_obj.req;
+	if (!req)
+		return NULL;
+
+	buf->req_done = true;
+	media_request_get(req);
+
+	return req;
+}
+
+/*
+ * The controls of a request are applied when the buffer before it completes,
+ * which is when the pipeline moves on to the frame of the request. The control
+ * handlers sleep, so this runs from a work item rather than from the DMA
+ * completion callback.
+ */
+static void xvip_dma_request_work(struct work_struct *work)
+{
+	struct xvip_dma *dma = container_of(work, struct xvip_dma, req_work);
+	struct media_request *req;
+
+	spin_lock_irq(&dma->queued_lock);
+	req = xvip_dma_next_request(dma);
+	spin_unlock_irq(&dma->queued_lock);
+
+	if (!req)
+		return;
+
+	xvip_dma_request_ctrls(dma, req, true);
+	media_request_put(req);
+}
+
+static unsigned int xvip_dma_stats_bucket(u64 ns)
+{
+	u64 us = div_u64(ns, NSEC_PER_USEC);
+
+	if (!us)
+		return 0;
+
+	return min_t(unsigned int, ilog2(us) + 1, XVIP_DMA_STATS_BUCKETS - 1);
+}
+
+static void xvip_dma_stats_update(struct xvip_dma *dma,
+				  struct xvip_dma_buffer *buf, bool underrun)
+{
+	struct xvip_dma_stats *stats = &dma->stats;
+	u64 ts = buf->buf.vb2_buf.timestamp;
+	u64 latency = ts - buf->queue_ts;
+	unsigned int i;
+
+	spin_lock(&dma->queued_lock);
+
+	if (stats->frames)
+		stats->interval[xvip_dma_stats_bucket(ts - stats->last_ts)]++;
+	else
+		stats->first_ts = ts;
+	stats->last_ts = ts;
+	stats->frames++;
+
+	for (i = 0; i < buf->buf.vb2_buf.num_planes; i++)
+		stats->bytes += vb2_get_plane_payload(&buf->buf.vb2_buf, i);
+
+	if (underrun)
+		stats->underruns++;
+
+	stats->latency[xvip_dma_stats_bucket(latency)]++;
+	stats->max_latency = max(stats->max_latency, latency);
+
+	spin_unlock(&dma->queued_lock);
+}
+
 static void xvip_dma_complete(void *param)
 {
 	struct xvip_dma_buffer *buf = param;
+	struct xvip_dma_buffer *next;
 	struct xvip_dma *dma = buf->dma;
 	int i, sizeimage;
 	u32 fid;
@@ -277,6 +427,10 @@ static void xvip_dma_complete(void *param)
 
 	spin_lock(&dma->queued_lock);
 	list_del(&buf->queue);
+	next = list_first_entry_or_null(&dma->queued_bufs,
+					struct xvip_dma_buffer, queue);
+	if (next && next->buf.vb2_buf.req_obj.req && !next->req_done)
+		schedule_work(&dma->req_work);
 	spin_unlock(&dma->queued_lock);
 
 	buf->buf.field = V4L2_FIELD_NONE;
@@ -303,7 +457,25 @@ static void xvip_dma_complete(void *param)
 		}
 	}
 
-	if (V4L2_TYPE_IS_MULTIPLANAR(dma->format.type)) {
+	/*
+	 * In low latency mode the callback is given when the DMA starts
+	 * writing the frame. Signal the start of the frame to the clients that
+	 * consume it while it is being written, such as an encoder paced by the
+	 * synchronizer IP.
+	 */
+	if (dma->low_latency_cap) {
+		struct v4l2_event event = {
+			.type = V4L2_EVENT_FRAME_SYNC,
+			.u.frame_sync.frame_sequence = buf->buf.sequence,
+		};
+
+		v4l2_event_queue(&dma->video, &event);
+	}
+
+	if (xvip_dma_is_meta(dma)) {
+		vb2_set_plane_payload(&buf->buf.vb2_buf, 0,
+				      dma->format.fmt.meta.buffersize);
+	} else if (V4L2_TYPE_IS_MULTIPLANAR(dma->format.type)) {
 		for (i = 0; i < dma->fmtinfo->buffers; i++) {
 			sizeimage =
 				dma->format.fmt.pix_mp.plane_fmt[i].sizeimage;
@@ -314,6 +486,10 @@ static void xvip_dma_complete(void *param)
 		vb2_set_plane_payload(&buf->buf.vb2_buf, 0, sizeimage);
 	}
 
+	xvip_dma_stats_update(dma, buf, !next);
+
+	xvip_buffer_signal_fence(buf->fence, 0);
+	buf->fence = NULL;
 	vb2_buffer_done(&buf->buf.vb2_buf, VB2_BUF_STATE_DONE);
 }
 
@@ -350,7 +526,10 @@ xvip_dma_queue_setup(struct vb2_queue *vq,
 	}
 
 	/* Single planar case: Make sure the image size is large enough */
-	sizeimage = dma->format.fmt.pix.sizeimage;
+	if (xvip_dma_is_meta(dma))
+		sizeimage = dma->format.fmt.meta.buffersize;
+	else
+		sizeimage = dma->format.fmt.pix.sizeimage;
 	if (*nplanes == 1)
 		return sizes[0] < sizeimage ? -EINVAL : 0;
 
@@ -367,15 +546,39 @@ static int xvip_dma_buffer_prepare(struct vb2_buffer *vb)
 	struct xvip_dma_buffer *buf = to_xvip_dma_buffer(vbuf);
 
 	buf->dma = dma;
+	buf->req_done = false;
 
-	return 0;
+	/* Wait for the producers and consumers of imported buffers. */
+	return xvip_buffer_wait_fences(vb, !V4L2_TYPE_IS_OUTPUT(vb->type));
 }
 
-static void xvip_dma_buffer_queue(struct vb2_buffer *vb)
+static void xvip_dma_buffer_request_complete(struct vb2_buffer *vb)
 {
 	struct vb2_v4l2_buffer *vbuf = to_vb2_v4l2_buffer(vb);
 	struct xvip_dma *dma = vb2_get_drv_priv(vb->vb2_queue);
 	struct xvip_dma_buffer *buf = to_xvip_dma_buffer(vbuf);
+
+	if (buf->req_done)
+		return;
+
+	buf->req_done = true;
+	xvip_dma_request_ctrls(dma, vb->req_obj.req, false);
+}
+
+/**
+ * xvip_dma_prep_desc - Prepare the DMA descriptor of a buffer
+ * @dma: The DMA channel
+ * @buf: The buffer
+ *
+ * Program the interleaved template with the active format and prepare the
+ * descriptor transferring @buf. The descriptor is not submitted.
+ *
+ * Return: the descriptor, or NULL if it couldn't be prepared.
+ */
+static struct dma_async_tx_descriptor *
+xvip_dma_prep_desc(struct xvip_dma *dma, struct xvip_dma_buffer *buf)
+{
+	struct vb2_buffer *vb = &buf->buf.vb2_buf;
 	struct dma_async_tx_descriptor *desc;
 	dma_addr_t addr = vb2_dma_contig_plane_dma_addr(vb, 0);
 	u32 flags = 0;
@@ -385,7 +588,8 @@ static void xvip_dma_buffer_queue(struct vb2_buffer *vb)
 	u32 bpl;
 
 	if (dma->queue.type == V4L2_BUF_TYPE_VIDEO_CAPTURE ||
-	    dma->queue.type == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE) {
+	    dma->queue.type == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE ||
+	    dma->queue.type == V4L2_BUF_TYPE_META_CAPTURE) {
 		flags = DMA_PREP_INTERRUPT | DMA_CTRL_ACK;
 		dma->xt.dir = DMA_DEV_TO_MEM;
 		dma->xt.src_sgl = false;
@@ -404,7 +608,13 @@ static void xvip_dma_buffer_queue(struct vb2_buffer *vb)
 	 * DMA IP supports only 2 planes, so one datachunk is sufficient
 	 * to get start address of 2nd plane
 	 */
-	if (V4L2_TYPE_IS_MULTIPLANAR(dma->format.type)) {
+	if (xvip_dma_is_meta(dma)) {
+		dma->xt.frame_size = 1;
+		dma->xt.numf = 1;
+		dma->sgl[0].size = dma->format.fmt.meta.buffersize;
+		dma->sgl[0].icg = 0;
+		dma->sgl[0].dst_icg = 0;
+	} else if (V4L2_TYPE_IS_MULTIPLANAR(dma->format.type)) {
 		struct v4l2_pix_format_mplane *pix_mp;
 		size_t size;
 
@@ -475,12 +685,10 @@ static void xvip_dma_buffer_queue(struct vb2_buffer *vb)
 	desc = dmaengine_prep_interleaved_dma(dma->dma, &dma->xt, flags);
 	if (!desc) {
 		dev_err(dma->xdev->dev, "Failed to prepare DMA transfer\n");
-		vb2_buffer_done(&buf->buf.vb2_buf, VB2_BUF_STATE_ERROR);
-		return;
+		return NULL;
 	}
 	desc->callback = xvip_dma_complete;
 	desc->callback_param = buf;
-	buf->desc = desc;
 
 	if (buf->buf.field == V4L2_FIELD_TOP)
 		fid = 1;
@@ -491,10 +699,6 @@ static void xvip_dma_buffer_queue(struct vb2_buffer *vb)
 
 	xilinx_xdma_set_fid(dma->dma, desc, fid);
 
-	spin_lock_irq(&dma->queued_lock);
-	list_add_tail(&buf->queue, &dma->queued_bufs);
-	spin_unlock_irq(&dma->queued_lock);
-
 	/*
 	 * Low latency capture: Give descriptor callback at start of
 	 * processing the descriptor
@@ -502,6 +706,37 @@ static void xvip_dma_buffer_queue(struct vb2_buffer *vb)
 	if (dma->low_latency_cap)
 		xilinx_xdma_set_earlycb(dma->dma, desc,
 					EARLY_CALLBACK_START_DESC);
+
+	return desc;
+}
+
+static void xvip_dma_buffer_queue(struct vb2_buffer *vb)
+{
+	struct vb2_v4l2_buffer *vbuf = to_vb2_v4l2_buffer(vb);
+	struct xvip_dma *dma = vb2_get_drv_priv(vb->vb2_queue);
+	struct xvip_dma_buffer *buf = to_xvip_dma_buffer(vbuf);
+	struct dma_async_tx_descriptor *desc;
+
+	desc = xvip_dma_prep_desc(dma, buf);
+	if (!desc) {
+		xvip_dma_buffer_request_complete(vb);
+		vb2_buffer_done(&buf->buf.vb2_buf, VB2_BUF_STATE_ERROR);
+		return;
+	}
+	buf->desc = desc;
+
+	if (!V4L2_TYPE_IS_OUTPUT(vb->type))
+		buf->fence = xvip_buffer_attach_fence(&dma->fence_tl, vb);
+
+	buf->queue_ts = ktime_get_ns();
+
+	spin_lock_irq(&dma->queued_lock);
+	list_add_tail(&buf->queue, &dma->queued_bufs);
+	if (vb2_is_streaming(&dma->queue) && vb->req_obj.req &&
+	    list_is_singular(&dma->queued_bufs))
+		schedule_work(&dma->req_work);
+	spin_unlock_irq(&dma->queued_lock);
+
 	dmaengine_submit(desc);
 
 	if (vb2_is_streaming(&dma->queue))
@@ -518,6 +753,10 @@ static int xvip_dma_start_streaming(struct vb2_queue *vq, unsigned int count)
 	dma->sequence = 0;
 	dma->prev_fid = ~0;
 
+	spin_lock_irq(&dma->queued_lock);
+	memset(&dma->stats, 0, sizeof(dma->stats));
+	spin_unlock_irq(&dma->queued_lock);
+
 	/*
 	 * Start streaming on the pipeline. No link touching an entity in the
 	 * pipeline can be activated or deactivated once streaming is started.
@@ -545,6 +784,9 @@ static int xvip_dma_start_streaming(struct vb2_queue *vq, unsigned int count)
 	if (ret < 0)
 		goto error_stop;
 
+	/* Apply the request of the first frame before anything is started. */
+	xvip_dma_request_work(&dma->req_work);
+
 	/* Start the DMA engine. This must be done before starting the blocks
 	 * in the pipeline to avoid DMA synchronization issues.
 	 * We dont't want to start DMA in case of low latency capture mode,
@@ -577,6 +819,8 @@ static int xvip_dma_start_streaming(struct vb2_queue *vq, unsigned int count)
 	/* Give back all queued buffers to videobuf2. */
 	spin_lock_irq(&dma->queued_lock);
 	list_for_each_entry_safe(buf, nbuf, &dma->queued_bufs, queue) {
+		xvip_buffer_signal_fence(buf->fence, -ECANCELED);
+		buf->fence = NULL;
 		vb2_buffer_done(&buf->buf.vb2_buf, VB2_BUF_STATE_QUEUED);
 		list_del(&buf->queue);
 	}
@@ -596,6 +840,7 @@ static void xvip_dma_stop_streaming(struct vb2_queue *vq)
 
 	/* Stop and reset the DMA engine. */
 	dmaengine_terminate_all(dma->dma);
+	cancel_work_sync(&dma->req_work);
 
 	/* Cleanup the pipeline and mark it as being stopped. */
 	xvip_pipeline_cleanup(pipe);
@@ -604,6 +849,8 @@ static void xvip_dma_stop_streaming(struct vb2_queue *vq)
 	/* Give back all queued buffers to videobuf2. */
 	spin_lock_irq(&dma->queued_lock);
 	list_for_each_entry_safe(buf, nbuf, &dma->queued_bufs, queue) {
+		xvip_buffer_signal_fence(buf->fence, -ECANCELED);
+		buf->fence = NULL;
 		vb2_buffer_done(&buf->buf.vb2_buf, VB2_BUF_STATE_ERROR);
 		list_del(&buf->queue);
 	}
@@ -614,6 +861,7 @@ static const struct vb2_ops xvip_dma_queue_qops = {
 	.queue_setup = xvip_dma_queue_setup,
 	.buf_prepare = xvip_dma_buffer_prepare,
 	.buf_queue = xvip_dma_buffer_queue,
+	.buf_request_complete = xvip_dma_buffer_request_complete,
 	.wait_prepare = vb2_ops_wait_prepare,
 	.wait_finish = vb2_ops_wait_finish,
 	.start_streaming = xvip_dma_start_streaming,
@@ -973,18 +1221,10 @@ xvip_dma_try_format(struct file *file, void *fh, struct v4l2_format *format)
 	return 0;
 }
 
-static int
-xvip_dma_set_format(struct file *file, void *fh, struct v4l2_format *format)
+static void xvip_dma_apply_format(struct xvip_dma *dma,
+				  const struct v4l2_format *format,
+				  const struct xvip_video_format *info)
 {
-	struct v4l2_fh *vfh = file->private_data;
-	struct xvip_dma *dma = to_xvip_dma(vfh->vdev);
-	const struct xvip_video_format *info;
-
-	__xvip_dma_try_format(dma, format, &info);
-
-	if (vb2_is_busy(&dma->queue))
-		return -EBUSY;
-
 	if (V4L2_TYPE_IS_MULTIPLANAR(dma->format.type)) {
 		dma->format.fmt.pix_mp = format->fmt.pix_mp;
 
@@ -1001,6 +1241,204 @@ xvip_dma_set_format(struct file *file, void *fh, struct v4l2_format *format)
 	}
 
 	dma->fmtinfo = info;
+}
+
+static bool xvip_dma_buffers_fit(struct xvip_dma *dma,
+				 const struct v4l2_format *format,
+				 const struct xvip_video_format *info)
+{
+	struct vb2_queue *queue = &dma->queue;
+	unsigned int i, p;
+
+	for (i = 0; i < queue->num_buffers; i++) {
+		struct vb2_buffer *vb = queue->bufs[i];
+
+		if (!V4L2_TYPE_IS_MULTIPLANAR(format->type)) {
+			if (vb2_plane_size(vb, 0) < format->fmt.pix.sizeimage)
+				return false;
+			continue;
+		}
+
+		if (vb->num_planes != info->buffers)
+			return false;
+
+		for (p = 0; p < info->buffers; p++) {
+			if (vb2_plane_size(vb, p) <
+			    format->fmt.pix_mp.plane_fmt[p].sizeimage)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * xvip_dma_switch_format - Change the format of a streaming DMA channel
+ * @dma: The DMA channel
+ * @format: The new format, adjusted by __xvip_dma_try_format()
+ * @info: Format information corresponding to @format
+ *
+ * Switch to a new format without stopping the queue, typically after a source
+ * change event once the sub-devices have been given their new formats. The
+ * queued buffers are kept when they are large enough for the new format. The
+ * DMA engine is stopped and the queued buffers are reprogrammed, and the
+ * sub-devices of a running pipeline are restarted to apply their formats.
+ *
+ * Return: 0 on success, -EBUSY if the buffers are too small for @format, or
+ * the format verification error, in which case the previous format is kept.
+ */
+static int xvip_dma_switch_format(struct xvip_dma *dma,
+				  const struct v4l2_format *format,
+				  const struct xvip_video_format *info)
+{
+	struct xvip_pipeline *pipe = to_xvip_pipeline(&dma->video.entity);
+	const struct xvip_video_format *old_info = dma->fmtinfo;
+	struct v4l2_format old_format = dma->format;
+	struct v4l2_rect old_r = dma->r;
+	struct xvip_dma_buffer *buf, *nbuf;
+	LIST_HEAD(bufs);
+	bool running;
+	int ret;
+
+	if (!xvip_dma_buffers_fit(dma, format, info))
+		return -EBUSY;
+
+	mutex_lock(&pipe->lock);
+
+	running = pipe->stream_count == pipe->num_dmas;
+	if (running)
+		xvip_graph_pipeline_start_stop(dma->xdev, pipe, false);
+
+	dmaengine_terminate_sync(dma->dma);
+
+	xvip_dma_apply_format(dma, format, info);
+	ret = xvip_dma_verify_format(dma);
+	if (ret < 0) {
+		dma->format = old_format;
+		dma->fmtinfo = old_info;
+		dma->r = old_r;
+	}
+
+	/* Reprogram the buffers that were queued to the DMA engine. */
+	spin_lock_irq(&dma->queued_lock);
+	list_splice_init(&dma->queued_bufs, &bufs);
+	spin_unlock_irq(&dma->queued_lock);
+
+	list_for_each_entry_safe(buf, nbuf, &bufs, queue) {
+		list_del(&buf->queue);
+
+		buf->desc = xvip_dma_prep_desc(dma, buf);
+		if (!buf->desc) {
+			xvip_buffer_signal_fence(buf->fence, -ECANCELED);
+			buf->fence = NULL;
+			xvip_dma_buffer_request_complete(&buf->buf.vb2_buf);
+			vb2_buffer_done(&buf->buf.vb2_buf, VB2_BUF_STATE_ERROR);
+			continue;
+		}
+
+		spin_lock_irq(&dma->queued_lock);
+		list_add_tail(&buf->queue, &dma->queued_bufs);
+		spin_unlock_irq(&dma->queued_lock);
+
+		dmaengine_submit(buf->desc);
+	}
+
+	dma_async_issue_pending(dma->dma);
+
+	if (running && xvip_graph_pipeline_start_stop(dma->xdev, pipe, true)) {
+		dev_err(dma->xdev->dev, "failed to restart the pipeline\n");
+		ret = -EPIPE;
+	}
+
+	mutex_unlock(&pipe->lock);
+
+	return ret;
+}
+
+static int
+xvip_dma_set_format(struct file *file, void *fh, struct v4l2_format *format)
+{
+	struct v4l2_fh *vfh = file->private_data;
+	struct xvip_dma *dma = to_xvip_dma(vfh->vdev);
+	const struct xvip_video_format *info = dma->fmtinfo;
+
+	__xvip_dma_try_format(dma, format, &info);
+
+	if (vb2_is_busy(&dma->queue)) {
+		if (!vb2_is_streaming(&dma->queue) || dma->low_latency_cap)
+			return -EBUSY;
+
+		return xvip_dma_switch_format(dma, format, info);
+	}
+
+	xvip_dma_apply_format(dma, format, info);
+
+	return 0;
+}
+
+static int
+xvip_dma_enum_meta_format(struct file *file, void *fh, struct v4l2_fmtdesc *f)
+{
+	if (f->index > 0)
+		return -EINVAL;
+
+	f->pixelformat = V4L2_META_FMT_XILINX_STATS;
+
+	return 0;
+}
+
+static int
+xvip_dma_get_meta_format(struct file *file, void *fh,
+			 struct v4l2_format *format)
+{
+	struct v4l2_fh *vfh = file->private_data;
+	struct xvip_dma *dma = to_xvip_dma(vfh->vdev);
+
+	format->fmt.meta = dma->format.fmt.meta;
+
+	return 0;
+}
+
+static void __xvip_dma_try_meta_format(struct xvip_dma *dma,
+				       struct v4l2_format *format)
+{
+	struct v4l2_meta_format *meta = &format->fmt.meta;
+
+	/*
+	 * The layout of the statistics is defined by the PL core producing
+	 * them, only the size of the block transferred per frame is set here.
+	 */
+	meta->dataformat = V4L2_META_FMT_XILINX_STATS;
+	meta->buffersize = clamp(roundup(meta->buffersize, dma->align),
+				 roundup(XVIP_DMA_MIN_WIDTH, dma->align),
+				 rounddown(XVIP_DMA_MAX_WIDTH, dma->align));
+}
+
+static int
+xvip_dma_try_meta_format(struct file *file, void *fh,
+			 struct v4l2_format *format)
+{
+	struct v4l2_fh *vfh = file->private_data;
+	struct xvip_dma *dma = to_xvip_dma(vfh->vdev);
+
+	__xvip_dma_try_meta_format(dma, format);
+
+	return 0;
+}
+
+static int
+xvip_dma_set_meta_format(struct file *file, void *fh,
+			 struct v4l2_format *format)
+{
+	struct v4l2_fh *vfh = file->private_data;
+	struct xvip_dma *dma = to_xvip_dma(vfh->vdev);
+
+	__xvip_dma_try_meta_format(dma, format);
+
+	if (vb2_is_busy(&dma->queue))
+		return -EBUSY;
+
+	dma->format.fmt.meta = format->fmt.meta;
 
 	return 0;
 }
@@ -1105,6 +1543,19 @@ xvip_dma_s_selection(struct file *file, void *fh, struct v4l2_selection *sel)
 	return 0;
 }
 
+static int xvip_dma_subscribe_event(struct v4l2_fh *fh,
+				    const struct v4l2_event_subscription *sub)
+{
+	switch (sub->type) {
+	case V4L2_EVENT_FRAME_SYNC:
+		return v4l2_event_subscribe(fh, sub, XVIP_DMA_NUM_EVENTS, NULL);
+	case V4L2_EVENT_SOURCE_CHANGE:
+		return v4l2_src_change_event_subscribe(fh, sub);
+	default:
+		return v4l2_ctrl_subscribe_event(fh, sub);
+	}
+}
+
 static const struct v4l2_ioctl_ops xvip_dma_ioctl_ops = {
 	.vidioc_querycap		= xvip_dma_querycap,
 	.vidioc_enum_fmt_vid_cap	= xvip_dma_enum_format,
@@ -1121,6 +1572,10 @@ static const struct v4l2_ioctl_ops xvip_dma_ioctl_ops = {
 	.vidioc_try_fmt_vid_cap_mplane	= xvip_dma_try_format,
 	.vidioc_try_fmt_vid_out		= xvip_dma_try_format,
 	.vidioc_try_fmt_vid_out_mplane	= xvip_dma_try_format,
+	.vidioc_enum_fmt_meta_cap	= xvip_dma_enum_meta_format,
+	.vidioc_g_fmt_meta_cap		= xvip_dma_get_meta_format,
+	.vidioc_s_fmt_meta_cap		= xvip_dma_set_meta_format,
+	.vidioc_try_fmt_meta_cap	= xvip_dma_try_meta_format,
 	.vidioc_s_selection		= xvip_dma_s_selection,
 	.vidioc_g_selection		= xvip_dma_g_selection,
 	.vidioc_reqbufs			= vb2_ioctl_reqbufs,
@@ -1134,6 +1589,8 @@ static const struct v4l2_ioctl_ops xvip_dma_ioctl_ops = {
 	.vidioc_enum_input	= &xvip_dma_enum_input,
 	.vidioc_g_input		= &xvip_dma_get_input,
 	.vidioc_s_input		= &xvip_dma_set_input,
+	.vidioc_subscribe_event		= xvip_dma_subscribe_event,
+	.vidioc_unsubscribe_event	= v4l2_event_unsubscribe,
 };
 
 /* -----------------------------------------------------------------------------
@@ -1239,6 +1696,88 @@ static const struct v4l2_file_operations xvip_dma_fops = {
 	.mmap		= vb2_fop_mmap,
 };
 
+/* -----------------------------------------------------------------------------
+ * debugfs
+ *
+ * Each DMA channel reports the throughput statistics of its current or last
+ * stream in <debugfs>/<composite device>/<video node>. Paired with a test
+ * pattern generator source, this measures the frame rate, bandwidth and
+ * buffer underruns a bitstream sustains. Writing to the file resets the
+ * statistics.
+ */
+
+static int xvip_dma_stats_show(struct seq_file *s, void *data)
+{
+	struct xvip_dma *dma = s->private;
+	struct xvip_dma_stats stats;
+	u64 elapsed = 0;
+	u64 mfps = 0;
+	u64 kibps = 0;
+	unsigned int i;
+
+	spin_lock_irq(&dma->queued_lock);
+	stats = dma->stats;
+	spin_unlock_irq(&dma->queued_lock);
+
+	if (stats.frames > 1)
+		elapsed = div_u64(stats.last_ts - stats.first_ts,
+				  NSEC_PER_USEC);
+	if (elapsed) {
+		mfps = div64_u64((stats.frames - 1) * USEC_PER_SEC * 1000,
+				 elapsed);
+		kibps = div64_u64((stats.bytes >> 10) * USEC_PER_SEC, elapsed);
+	}
+
+	seq_printf(s, "frames: %llu\n", stats.frames);
+	seq_printf(s, "bytes: %llu\n", stats.bytes);
+	seq_printf(s, "underruns: %llu\n", stats.underruns);
+	seq_printf(s, "elapsed: %llu us\n", elapsed);
+	seq_printf(s, "frame rate: %llu.%03u fps\n", div_u64(mfps, 1000),
+		   (u32)(mfps % 1000));
+	seq_printf(s, "bandwidth: %llu KiB/s\n", kibps);
+	seq_printf(s, "max latency: %llu us\n",
+		   div_u64(stats.max_latency, NSEC_PER_USEC));
+
+	seq_puts(s, "bucket (us)\tinterval\tlatency\n");
+	for (i = 0; i < XVIP_DMA_STATS_BUCKETS; i++) {
+		if (!stats.interval[i] && !stats.latency[i])
+			continue;
+
+		seq_printf(s, "%s%u\t%u\t%u\n",
+			   i == XVIP_DMA_STATS_BUCKETS - 1 ? ">=" : "<",
+			   i == XVIP_DMA_STATS_BUCKETS - 1 ? 1U << (i - 1) :
+			   1U << i, stats.interval[i], stats.latency[i]);
+	}
+
+	return 0;
+}
+
+static int xvip_dma_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, xvip_dma_stats_show, inode->i_private);
+}
+
+static ssize_t xvip_dma_stats_write(struct file *file, const char __user *buf,
+				    size_t count, loff_t *ppos)
+{
+	struct xvip_dma *dma = file_inode(file)->i_private;
+
+	spin_lock_irq(&dma->queued_lock);
+	memset(&dma->stats, 0, sizeof(dma->stats));
+	spin_unlock_irq(&dma->queued_lock);
+
+	return count;
+}
+
+static const struct file_operations xvip_dma_stats_fops = {
+	.owner = THIS_MODULE,
+	.open = xvip_dma_stats_open,
+	.read = seq_read,
+	.write = xvip_dma_stats_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 /* -----------------------------------------------------------------------------
  * Xilinx Video DMA Core
  */
@@ -1256,11 +1795,15 @@ int xvip_dma_init(struct xvip_composite_device *xdev, struct xvip_dma *dma,
 	mutex_init(&dma->pipe.lock);
 	INIT_LIST_HEAD(&dma->queued_bufs);
 	spin_lock_init(&dma->queued_lock);
+	INIT_WORK(&dma->req_work, xvip_dma_request_work);
 
 	dma->fmtinfo = xvip_get_format_by_fourcc(XVIP_DMA_DEF_FORMAT);
 	dma->format.type = type;
 
-	if (V4L2_TYPE_IS_MULTIPLANAR(type)) {
+	if (type == V4L2_BUF_TYPE_META_CAPTURE) {
+		dma->format.fmt.meta.dataformat = V4L2_META_FMT_XILINX_STATS;
+		dma->format.fmt.meta.buffersize = XVIP_DMA_META_DEF_SIZE;
+	} else if (V4L2_TYPE_IS_MULTIPLANAR(type)) {
 		struct v4l2_pix_format_mplane *pix_mp;
 
 		pix_mp = &dma->format.fmt.pix_mp;
@@ -1304,7 +1847,8 @@ int xvip_dma_init(struct xvip_composite_device *xdev, struct xvip_dma *dma,
 
 	/* Initialize the media entity... */
 	if (type == V4L2_BUF_TYPE_VIDEO_CAPTURE ||
-	    type == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE)
+	    type == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE ||
+	    type == V4L2_BUF_TYPE_META_CAPTURE)
 		dma->pad.flags = MEDIA_PAD_FL_SINK;
 	else
 		dma->pad.flags = MEDIA_PAD_FL_SOURCE;
@@ -1353,14 +1897,17 @@ int xvip_dma_init(struct xvip_composite_device *xdev, struct xvip_dma *dma,
 	dma->video.queue = &dma->queue;
 	snprintf(dma->video.name, sizeof(dma->video.name), "%pOFn %s %u",
 		 xdev->dev->of_node,
+		 type == V4L2_BUF_TYPE_META_CAPTURE ? "stats" :
 		 (type == V4L2_BUF_TYPE_VIDEO_CAPTURE ||
 		  type == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE)
 					? "output" : "input",
 		 port);
+	xvip_fence_timeline_init(&dma->fence_tl, dma->video.name);
 
 	dma->video.vfl_type = VFL_TYPE_GRABBER;
 	if (type == V4L2_BUF_TYPE_VIDEO_CAPTURE ||
-	    type == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE)
+	    type == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE ||
+	    type == V4L2_BUF_TYPE_META_CAPTURE)
 		dma->video.vfl_dir = VFL_DIR_RX;
 	else
 		dma->video.vfl_dir = VFL_DIR_TX;
@@ -1382,6 +1929,9 @@ int xvip_dma_init(struct xvip_composite_device *xdev, struct xvip_dma *dma,
 	case V4L2_BUF_TYPE_VIDEO_OUTPUT:
 		dma->video.device_caps |= V4L2_CAP_VIDEO_OUTPUT;
 		break;
+	case V4L2_BUF_TYPE_META_CAPTURE:
+		dma->video.device_caps |= V4L2_CAP_META_CAPTURE;
+		break;
 	}
 
 	video_set_drvdata(&dma->video, dma);
@@ -1404,6 +1954,7 @@ int xvip_dma_init(struct xvip_composite_device *xdev, struct xvip_dma *dma,
 	dma->queue.timestamp_flags = V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC
 				   | V4L2_BUF_FLAG_TSTAMP_SRC_EOF;
 	dma->queue.dev = dma->xdev->dev;
+	dma->queue.supports_requests = true;
 	ret = vb2_queue_init(&dma->queue);
 	if (ret < 0) {
 		dev_err(dma->xdev->dev, "failed to initialize VB2 queue\n");
@@ -1429,6 +1980,10 @@ int xvip_dma_init(struct xvip_composite_device *xdev, struct xvip_dma *dma,
 		goto error;
 	}
 
+	dma->debugfs = debugfs_create_file(video_device_node_name(&dma->video),
+					   0600, xdev->debugfs, dma,
+					   &xvip_dma_stats_fops);
+
 	return 0;
 
 error:
@@ -1438,6 +1993,8 @@ int xvip_dma_init(struct xvip_composite_device *xdev, struct xvip_dma *dma,
 
 void xvip_dma_cleanup(struct xvip_dma *dma)
 {
+	debugfs_remove(dma->debugfs);
+
 	if (video_is_registered(&dma->video))
 		video_unregister_device(&dma->video);
 
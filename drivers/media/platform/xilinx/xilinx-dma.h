@@ -16,12 +16,16 @@
 #include <linux/mutex.h>
 #include <linux/spinlock.h>
 #include <linux/videodev2.h>
+#include <linux/workqueue.h>
 
 #include <media/media-entity.h>
 #include <media/v4l2-ctrls.h>
 #include <media/v4l2-dev.h>
 #include <media/videobuf2-v4l2.h>
 
+#include "xilinx-vip.h"
+
+struct dentry;
 struct dma_chan;
 struct xvip_composite_device;
 struct xvip_video_format;
@@ -51,6 +55,34 @@ static inline struct xvip_pipeline *to_xvip_pipeline(struct media_entity *e)
 	return container_of(e->pipe, struct xvip_pipeline, pipe);
 }
 
+#define XVIP_DMA_STATS_BUCKETS	24
+
+/**
+ * struct xvip_dma_stats - Video DMA channel throughput statistics
+ * @frames: number of completed buffers
+ * @bytes: number of bytes transferred
+ * @underruns: number of buffers completed with no other buffer queued, the
+ *	       frames received until the next buffer is queued are dropped
+ * @first_ts: completion time of the first buffer (in ns)
+ * @last_ts: completion time of the last buffer (in ns)
+ * @max_latency: maximum buffer queue to completion latency (in ns)
+ * @interval: histogram of the intervals between completed buffers, bucket 0
+ *	      counts the intervals below 1us and bucket n the intervals in
+ *	      [2^(n-1), 2^n) us
+ * @latency: histogram of the buffer queue to completion latencies, with the
+ *	     same buckets as @interval
+ */
+struct xvip_dma_stats {
+	u64 frames;
+	u64 bytes;
+	u64 underruns;
+	u64 first_ts;
+	u64 last_ts;
+	u64 max_latency;
+	u32 interval[XVIP_DMA_STATS_BUCKETS];
+	u32 latency[XVIP_DMA_STATS_BUCKETS];
+};
+
 /**
  * struct xvip_dma - Video DMA channel
  * @list: list entry in a composite device dmas list
@@ -70,13 +102,17 @@ static inline struct xvip_pipeline *to_xvip_pipeline(struct media_entity *e)
  * @queue: vb2 buffers queue
  * @sequence: V4L2 buffers sequence number
  * @queued_bufs: list of queued buffers
- * @queued_lock: protects the buf_queued list
+ * @queued_lock: protects the buf_queued list and @stats
+ * @req_work: work applying the request of the next buffer
+ * @fence_tl: timeline of the write fences of the imported capture buffers
  * @dma: DMA engine channel
  * @align: transfer alignment required by the DMA channel (in bytes)
  * @xt: dma interleaved template for dma configuration
  * @sgl: data chunk structure for dma_interleaved_template
  * @prev_fid: Previous Field ID
  * @low_latency_cap: Low latency capture mode
+ * @stats: throughput statistics of the current stream
+ * @debugfs: debugfs file reporting @stats
  */
 struct xvip_dma {
 	struct list_head list;
@@ -102,6 +138,8 @@ struct xvip_dma {
 
 	struct list_head queued_bufs;
 	spinlock_t queued_lock;
+	struct work_struct req_work;
+	struct xvip_fence_timeline fence_tl;
 
 	struct dma_chan *dma;
 	unsigned int align;
@@ -110,6 +148,9 @@ struct xvip_dma {
 
 	u32 prev_fid;
 	u32 low_latency_cap;
+
+	struct xvip_dma_stats stats;
+	struct dentry *debugfs;
 };
 
 #define to_xvip_dma(vdev)	container_of(vdev, struct xvip_dma, video)
@@ -26,10 +26,14 @@
 #include "xilinx-hls-common.h"
 #include "xilinx-vip.h"
 
+#define XHLS_PAD_STATS		2
+#define XHLS_MAX_PADS		3
+
 /**
  * struct xhls_device - Xilinx HLS Core device structure
  * @xvip: Xilinx Video IP device
  * @pads: media pads
+ * @num_pads: number of media pads, 3 when the core has a statistics output
  * @compatible: first DT compatible string for the device
  * @formats: active V4L2 media bus formats at the sink and source pads
  * @default_formats: default V4L2 media bus formats
@@ -41,12 +45,13 @@
  */
 struct xhls_device {
 	struct xvip_device xvip;
-	struct media_pad pads[2];
+	struct media_pad pads[XHLS_MAX_PADS];
+	unsigned int num_pads;
 
 	const char *compatible;
 
-	struct v4l2_mbus_framefmt formats[2];
-	struct v4l2_mbus_framefmt default_formats[2];
+	struct v4l2_mbus_framefmt formats[XHLS_MAX_PADS];
+	struct v4l2_mbus_framefmt default_formats[XHLS_MAX_PADS];
 	const struct xvip_video_format *vip_formats[2];
 
 	struct v4l2_ctrl_handler ctrl_handler;
@@ -205,6 +210,9 @@ __xhls_get_pad_format(struct xhls_device *xhls,
 {
 	struct v4l2_mbus_framefmt *format;
 
+	if (pad >= xhls->num_pads)
+		return NULL;
+
 	switch (which) {
 	case V4L2_SUBDEV_FORMAT_TRY:
 		format = v4l2_subdev_get_try_format(&xhls->xvip.subdev,
@@ -248,7 +256,8 @@ static int xhls_set_format(struct v4l2_subdev *subdev,
 	if (!format)
 		return -EINVAL;
 
-	if (fmt->pad == XVIP_PAD_SOURCE) {
+	/* The source and statistics formats follow the sink format. */
+	if (fmt->pad != XVIP_PAD_SINK) {
 		fmt->format = *format;
 		return 0;
 	}
@@ -284,6 +293,12 @@ static int xhls_open(struct v4l2_subdev *subdev, struct v4l2_subdev_fh *fh)
 	format = v4l2_subdev_get_try_format(subdev, fh->pad, XVIP_PAD_SOURCE);
 	*format = xhls->default_formats[XVIP_PAD_SOURCE];
 
+	if (xhls->num_pads > XHLS_PAD_STATS) {
+		format = v4l2_subdev_get_try_format(subdev, fh->pad,
+						    XHLS_PAD_STATS);
+		*format = xhls->default_formats[XHLS_PAD_STATS];
+	}
+
 	return 0;
 }
 
@@ -350,6 +365,16 @@ static void xhls_init_formats(struct xhls_device *xhls)
 	format->code = xhls->vip_formats[XVIP_PAD_SOURCE]->code;
 
 	xhls->formats[XVIP_PAD_SOURCE] = *format;
+
+	/*
+	 * The statistics computed by the core are written to memory by a DMA
+	 * engine as a block of bytes, the pad has no frame format.
+	 */
+	format = &xhls->default_formats[XHLS_PAD_STATS];
+	format->code = MEDIA_BUS_FMT_FIXED;
+	format->field = V4L2_FIELD_NONE;
+
+	xhls->formats[XHLS_PAD_STATS] = *format;
 }
 
 static int xhls_parse_of(struct xhls_device *xhls)
@@ -369,23 +394,31 @@ static int xhls_parse_of(struct xhls_device *xhls)
 	if (ports == NULL)
 		ports = node;
 
+	xhls->num_pads = 2;
+
 	/* Get the format description for each pad */
 	for_each_child_of_node(ports, port) {
 		if (port->name && (of_node_cmp(port->name, "port") == 0)) {
 			const struct xvip_video_format *vip_format;
 
-			vip_format = xvip_of_get_format(port);
-			if (IS_ERR(vip_format)) {
-				dev_err(dev, "invalid format in DT");
-				return PTR_ERR(vip_format);
-			}
-
 			ret = of_property_read_u32(port, "reg", &port_id);
 			if (ret < 0) {
 				dev_err(dev, "no reg in DT");
 				return ret;
 			}
 
+			/* The optional statistics port carries no video */
+			if (port_id == XHLS_PAD_STATS) {
+				xhls->num_pads = XHLS_MAX_PADS;
+				continue;
+			}
+
+			vip_format = xvip_of_get_format(port);
+			if (IS_ERR(vip_format)) {
+				dev_err(dev, "invalid format in DT");
+				return PTR_ERR(vip_format);
+			}
+
 			if (port_id != 0 && port_id != 1) {
 				dev_err(dev, "invalid reg in DT");
 				return -EINVAL;
@@ -441,8 +474,10 @@ static int xhls_probe(struct platform_device *pdev)
 
 	xhls->pads[XVIP_PAD_SINK].flags = MEDIA_PAD_FL_SINK;
 	xhls->pads[XVIP_PAD_SOURCE].flags = MEDIA_PAD_FL_SOURCE;
+	xhls->pads[XHLS_PAD_STATS].flags = MEDIA_PAD_FL_SOURCE;
 	subdev->entity.ops = &xhls_media_ops;
-	ret = media_entity_pads_init(&subdev->entity, 2, xhls->pads);
+	ret = media_entity_pads_init(&subdev->entity, xhls->num_pads,
+				     xhls->pads);
 	if (ret < 0)
 		goto error;
 
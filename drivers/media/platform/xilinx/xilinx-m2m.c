@@ -9,6 +9,7 @@
 
 #include <drm/drm_fourcc.h>
 #include <linux/delay.h>
+#include <linux/dma-fence.h>
 #include <linux/dma/xilinx_frmbuf.h>
 #include <linux/lcm.h>
 #include <linux/list.h>
@@ -165,14 +166,29 @@ struct xvip_m2m_dma {
  * @xdev: composite mem2mem device the DMA channels belongs to
  * @xt: dma interleaved template for dma configuration
  * @sgl: data chunk structure for dma_interleaved_template
+ * @fence_tl: timeline of the write fences of the imported capture buffers
  */
 struct xvip_m2m_ctx {
 	struct v4l2_fh fh;
 	struct xvip_m2m_dev *xdev;
 	struct dma_interleaved_template xt;
 	struct data_chunk sgl[1];
+	struct xvip_fence_timeline fence_tl;
 };
 
+/**
+ * struct xvip_m2m_buffer - VIPP mem2mem buffer
+ * @m2m_buf: mem2mem buffer base object
+ * @fence: write fence attached to the dma-bufs of an imported capture buffer
+ */
+struct xvip_m2m_buffer {
+	struct v4l2_m2m_buffer m2m_buf;
+	struct dma_fence *fence;
+};
+
+#define to_xvip_m2m_buffer(vbuf) \
+	container_of(vbuf, struct xvip_m2m_buffer, m2m_buf.vb)
+
 static inline struct xvip_m2m_ctx *file2ctx(struct file *file)
 {
 	return container_of(file->private_data, struct xvip_m2m_ctx, fh);
@@ -541,6 +557,14 @@ static int xvip_pipeline_prepare(struct xvip_pipeline *pipe,
 	return ret;
 }
 
+static void xvip_m2m_buf_signal_fence(struct vb2_v4l2_buffer *vbuf, int error)
+{
+	struct xvip_m2m_buffer *buf = to_xvip_m2m_buffer(vbuf);
+
+	xvip_buffer_signal_fence(buf->fence, error);
+	buf->fence = NULL;
+}
+
 static void xvip_m2m_dma_callback_mem2dev(void *data)
 {
 }
@@ -561,6 +585,8 @@ static void xvip_m2m_dma_callback(void *data)
 		src_vb->flags & V4L2_BUF_FLAG_TSTAMP_SRC_MASK;
 	dst_vb->timecode = src_vb->timecode;
 
+	xvip_m2m_buf_signal_fence(dst_vb, 0);
+
 	v4l2_m2m_buf_done(src_vb, VB2_BUF_STATE_DONE);
 	v4l2_m2m_buf_done(dst_vb, VB2_BUF_STATE_DONE);
 	v4l2_m2m_job_finish(xdev->m2m_dev, ctx->fh.m2m_ctx);
@@ -636,7 +662,8 @@ static int xvip_m2m_buf_prepare(struct vb2_buffer *vb)
 				      f->fmt.pix_mp.plane_fmt[i].sizeimage);
 	}
 
-	return 0;
+	/* Wait for the producers and consumers of imported buffers. */
+	return xvip_buffer_wait_fences(vb, !V4L2_TYPE_IS_OUTPUT(vb->type));
 }
 
 static void xvip_m2m_buf_queue(struct vb2_buffer *vb)
@@ -644,6 +671,10 @@ static void xvip_m2m_buf_queue(struct vb2_buffer *vb)
 	struct vb2_v4l2_buffer *vbuf = to_vb2_v4l2_buffer(vb);
 	struct xvip_m2m_ctx *ctx = vb2_get_drv_priv(vb->vb2_queue);
 
+	if (!V4L2_TYPE_IS_OUTPUT(vb->type))
+		to_xvip_m2m_buffer(vbuf)->fence =
+			xvip_buffer_attach_fence(&ctx->fence_tl, vb);
+
 	v4l2_m2m_buf_queue(ctx->fh.m2m_ctx, vbuf);
 }
 
@@ -678,6 +709,9 @@ static void xvip_m2m_stop_streaming(struct vb2_queue *q)
 		if (!vbuf)
 			return;
 
+		if (!V4L2_TYPE_IS_OUTPUT(q->type))
+			xvip_m2m_buf_signal_fence(vbuf, -ECANCELED);
+
 		spin_lock(&ctx->xdev->queued_lock);
 		v4l2_m2m_buf_done(vbuf, VB2_BUF_STATE_ERROR);
 		spin_unlock(&ctx->xdev->queued_lock);
@@ -747,7 +781,7 @@ static int xvip_m2m_queue_init(void *priv, struct vb2_queue *src_vq,
 	src_vq->type = V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE;
 	src_vq->io_modes = VB2_MMAP | VB2_USERPTR | VB2_DMABUF;
 	src_vq->drv_priv = ctx;
-	src_vq->buf_struct_size = sizeof(struct v4l2_m2m_buffer);
+	src_vq->buf_struct_size = sizeof(struct xvip_m2m_buffer);
 	src_vq->ops = &m2m_vb2_ops;
 	src_vq->mem_ops = &vb2_dma_contig_memops;
 	src_vq->timestamp_flags = V4L2_BUF_FLAG_TIMESTAMP_COPY;
@@ -760,7 +794,7 @@ static int xvip_m2m_queue_init(void *priv, struct vb2_queue *src_vq,
 	dst_vq->type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
 	dst_vq->io_modes = VB2_MMAP | VB2_USERPTR | VB2_DMABUF;
 	dst_vq->drv_priv = ctx;
-	dst_vq->buf_struct_size = sizeof(struct v4l2_m2m_buffer);
+	dst_vq->buf_struct_size = sizeof(struct xvip_m2m_buffer);
 	dst_vq->ops = &m2m_vb2_ops;
 	dst_vq->mem_ops = &vb2_dma_contig_memops;
 	dst_vq->timestamp_flags = V4L2_BUF_FLAG_TIMESTAMP_COPY;
@@ -1148,6 +1182,7 @@ static int xvip_m2m_open(struct file *file)
 	v4l2_fh_init(&ctx->fh, video_devdata(file));
 	file->private_data = &ctx->fh;
 	ctx->xdev = xdev;
+	xvip_fence_timeline_init(&ctx->fence_tl, XVIP_M2M_NAME);
 
 	ctx->fh.m2m_ctx = v4l2_m2m_ctx_init(xdev->m2m_dev, ctx,
 					    &xvip_m2m_queue_init);
@@ -1240,21 +1240,20 @@ static void xm2msc_job_done(struct xm2m_msc_dev *xm2msc)
 	}
 }
 
-static void xm2msc_device_run(void *priv)
+/*
+ * Reconfigure the IP for the current set of streaming channels. The IP always
+ * processes the channels 0 to XM2MSC_NUM_OUTS - 1 and needs a reset to update
+ * XM2MSC_NUM_OUTS, so the channels are only reprogrammed when that set
+ * changes. Everything but the buffer addresses then stays programmed across
+ * runs.
+ */
+static int xm2msc_update_running_chan(struct xm2m_msc_dev *xm2msc)
 {
-	struct xm2msc_chan_ctx *chan_ctx = priv;
-	struct xm2m_msc_dev *xm2msc = chan_ctx->xm2msc_dev;
 	void __iomem *base = xm2msc->regs;
 	unsigned long flags;
-	int ret;
+	int ret = 0;
 
 	spin_lock_irqsave(&xm2msc->lock, flags);
-	if (xm2msc->device_busy) {
-		spin_unlock_irqrestore(&xm2msc->lock, flags);
-		return;
-	}
-	xm2msc->device_busy = true;
-
 	if (xm2msc->running_chan != NUM_STREAM(xm2msc)) {
 		dev_dbg(xm2msc->dev, "Running chan was %d\n",
 			xm2msc->running_chan);
@@ -1264,56 +1263,80 @@ static void xm2msc_device_run(void *priv)
 		xm2msc_reset(xm2msc);
 		xm2msc_writereg(base + XM2MSC_NUM_OUTS, xm2msc->running_chan);
 		ret = xm2msc_program_allchan(xm2msc);
-		if (ret) {
-			spin_unlock_irqrestore(&xm2msc->lock, flags);
-			xm2msc->device_busy = false;
-			return;
-		}
+
+		xm2msc_writereg(base + XM2MSC_GIE, XM2MSC_GIE_EN);
+		xm2msc_writereg(base + XM2MSC_IER, XM2MSC_ISR_DONE);
 	}
 	spin_unlock_irqrestore(&xm2msc->lock, flags);
 
-	dev_dbg(xm2msc->dev, "Running chan = %d\n", xm2msc->running_chan);
-	if (!xm2msc->running_chan) {
-		xm2msc->device_busy = false;
-		return;
-	}
+	return ret;
+}
 
-	ret = xm2msc_set_bufaddr(xm2msc);
-	if (ret) {
-		/*
-		 * All channel does not have buffer
-		 * Currently we do not handle the removal of any Intermediate
-		 * channel while streaming is going on
-		 */
-		if (xm2msc->out_streamed_chan || xm2msc->cap_streamed_chan)
-			dev_err(xm2msc->dev,
-				"Buffer not available, streaming chan 0x%x\n",
-				xm2msc->cap_streamed_chan);
+static void xm2msc_device_run(void *priv)
+{
+	struct xm2msc_chan_ctx *chan_ctx = priv;
+	struct xm2m_msc_dev *xm2msc = chan_ctx->xm2msc_dev;
+	void __iomem *base = xm2msc->regs;
+	unsigned long flags;
+	bool ran = false;
+	int ret;
 
-		xm2msc->device_busy = false;
+	spin_lock_irqsave(&xm2msc->lock, flags);
+	if (xm2msc->device_busy) {
+		spin_unlock_irqrestore(&xm2msc->lock, flags);
 		return;
 	}
+	xm2msc->device_busy = true;
+	spin_unlock_irqrestore(&xm2msc->lock, flags);
+
+	/*
+	 * Keep the IP busy as long as every running channel has a job queued:
+	 * the buffers of the next batch are programmed as soon as the previous
+	 * batch is done, instead of going back through the m2m framework for
+	 * each batch.
+	 */
+	do {
+		ret = xm2msc_update_running_chan(xm2msc);
+		if (ret)
+			break;
+
+		dev_dbg(xm2msc->dev, "Running chan = %d\n",
+			xm2msc->running_chan);
+		if (!xm2msc->running_chan)
+			break;
 
-	xm2msc_writereg(base + XM2MSC_GIE, XM2MSC_GIE_EN);
-	xm2msc_writereg(base + XM2MSC_IER, XM2MSC_ISR_DONE);
+		ret = xm2msc_set_bufaddr(xm2msc);
+		if (ret) {
+			/*
+			 * All channel does not have buffer
+			 * Currently we do not handle the removal of any
+			 * Intermediate channel while streaming is going on
+			 */
+			if (!ran && (xm2msc->out_streamed_chan ||
+				     xm2msc->cap_streamed_chan))
+				dev_err(xm2msc->dev,
+					"Buffer not available, streaming chan 0x%x\n",
+					xm2msc->cap_streamed_chan);
+			break;
+		}
 
-	xm2msc_pr_status(xm2msc, __func__);
-	xm2msc_pr_screg(xm2msc->dev, base);
-	xm2msc_pr_allchanreg(xm2msc);
+		xm2msc_pr_status(xm2msc, __func__);
+		xm2msc_pr_screg(xm2msc->dev, base);
+		xm2msc_pr_allchanreg(xm2msc);
 
-	xm2msc_start(xm2msc);
+		xm2msc_start(xm2msc);
 
-	xm2msc->isr_wait = true;
-	wait_event(xm2msc->isr_finished, !xm2msc->isr_wait);
+		xm2msc->isr_wait = true;
+		wait_event(xm2msc->isr_finished, !xm2msc->isr_wait);
 
-	xm2msc_job_done(xm2msc);
+		xm2msc_job_done(xm2msc);
+		ran = true;
+	} while (xm2msc_alljob_ready(xm2msc));
 
 	xm2msc->device_busy = false;
 
-	if (xm2msc_alljob_ready(xm2msc))
-		xm2msc_device_run(xm2msc->xm2msc_chan);
-
-	xm2msc_job_finish(xm2msc);
+	if (ran)
+		xm2msc_job_finish(xm2msc);
 }
 
 static irqreturn_t xm2msc_isr(int irq, void *data)
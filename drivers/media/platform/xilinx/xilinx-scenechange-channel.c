@@ -33,6 +33,13 @@
 #define XSCD_SCENE_CHANGE		1
 #define XSCD_NO_SCENE_CHANGE		0
 
+/*
+ * Number of detection results kept per file handle. In memory-based mode a
+ * single run of the core processes a frame of every channel with queued
+ * buffers, so keep enough results for a reader draining them in batches.
+ */
+#define XSCD_EVENT_QUEUE_DEPTH		16
+
 /* -----------------------------------------------------------------------------
  * V4L2 Subdevice Pad Operations
  */
@@ -237,7 +244,8 @@ static int xscd_subscribe_event(struct v4l2_subdev *sd,
 
 	switch (sub->type) {
 	case V4L2_EVENT_XLNXSCD:
-		ret = v4l2_event_subscribe(fh, sub, 1, NULL);
+		ret = v4l2_event_subscribe(fh, sub, XSCD_EVENT_QUEUE_DEPTH,
+					   NULL);
 		break;
 	default:
 		ret = -EINVAL;
@@ -338,6 +346,7 @@ void xscd_chan_event_notify(struct xscd_chan *chan)
 		eventdata[0] = XSCD_SCENE_CHANGE;
 	else
 		eventdata[0] = XSCD_NO_SCENE_CHANGE;
+	eventdata[1] = sad;
 
 	chan->event.type = V4L2_EVENT_XLNXSCD;
 	v4l2_subdev_notify_event(&chan->subdev, &chan->event);
@@ -10,10 +10,15 @@
  */
 
 #include <linux/clk.h>
+#include <linux/dma-buf.h>
+#include <linux/dma-fence.h>
+#include <linux/dma-resv.h>
 #include <linux/export.h>
 #include <linux/kernel.h>
 #include <linux/of.h>
 #include <linux/platform_device.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
 
 #include <dt-bindings/media/xilinx-vip.h>
 
@@ -392,6 +397,139 @@ void xvip_cleanup_resources(struct xvip_device *xvip)
 }
 EXPORT_SYMBOL_GPL(xvip_cleanup_resources);
 
+/* -----------------------------------------------------------------------------
+ * Buffer fences
+ */
+
+static const char *xvip_fence_get_driver_name(struct dma_fence *fence)
+{
+	return "xilinx-video";
+}
+
+static const char *xvip_fence_get_timeline_name(struct dma_fence *fence)
+{
+	struct xvip_fence_timeline *tl =
+		container_of(fence->lock, struct xvip_fence_timeline, lock);
+
+	return tl->name;
+}
+
+static const struct dma_fence_ops xvip_fence_ops = {
+	.get_driver_name = xvip_fence_get_driver_name,
+	.get_timeline_name = xvip_fence_get_timeline_name,
+};
+
+/**
+ * xvip_fence_timeline_init - Initialize a fence timeline
+ * @tl: the fence timeline
+ * @name: name of the timeline, must outlive all the fences of the timeline
+ */
+void xvip_fence_timeline_init(struct xvip_fence_timeline *tl,
+			      const char *name)
+{
+	spin_lock_init(&tl->lock);
+	tl->context = dma_fence_context_alloc(1);
+	tl->seqno = 0;
+	tl->name = name;
+}
+EXPORT_SYMBOL_GPL(xvip_fence_timeline_init);
+
+/**
+ * xvip_buffer_wait_fences - Wait for the implicit fences of a buffer
+ * @vb: the video buffer
+ * @write: the hardware writes to the buffer
+ *
+ * Wait for the fences attached to the dma-bufs of an imported buffer. A buffer
+ * read by the hardware waits for the pending writer only, a buffer written by
+ * the hardware waits for all pending readers and writers.
+ *
+ * Return: 0 on success, or a negative error code if the wait was interrupted
+ */
+int xvip_buffer_wait_fences(struct vb2_buffer *vb, bool write)
+{
+	unsigned int i;
+	long ret;
+
+	if (vb->memory != VB2_MEMORY_DMABUF)
+		return 0;
+
+	for (i = 0; i < vb->num_planes; i++) {
+		ret = dma_resv_wait_timeout_rcu(vb->planes[i].dbuf->resv,
+						write, true,
+						MAX_SCHEDULE_TIMEOUT);
+		if (ret < 0)
+			return ret;
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(xvip_buffer_wait_fences);
+
+/**
+ * xvip_buffer_attach_fence - Attach a write fence to a buffer
+ * @tl: the fence timeline
+ * @vb: the video buffer written by the hardware
+ *
+ * Create a fence and attach it as the exclusive fence of the dma-bufs of an
+ * imported buffer, so that the consumers of the dma-bufs, such as a display
+ * controller, can wait for the hardware to be done with the buffer without
+ * userspace dequeuing it first. The fence is signaled with
+ * xvip_buffer_signal_fence().
+ *
+ * Return: the fence, or NULL if the buffer isn't an imported dma-buf or the
+ * fence can't be allocated
+ */
+struct dma_fence *xvip_buffer_attach_fence(struct xvip_fence_timeline *tl,
+					   struct vb2_buffer *vb)
+{
+	struct dma_fence *fence;
+	unsigned long flags;
+	unsigned int i;
+	u64 seqno;
+
+	if (vb->memory != VB2_MEMORY_DMABUF)
+		return NULL;
+
+	fence = kzalloc(sizeof(*fence), GFP_KERNEL);
+	if (!fence)
+		return NULL;
+
+	spin_lock_irqsave(&tl->lock, flags);
+	seqno = ++tl->seqno;
+	spin_unlock_irqrestore(&tl->lock, flags);
+
+	dma_fence_init(fence, &xvip_fence_ops, &tl->lock, tl->context, seqno);
+
+	for (i = 0; i < vb->num_planes; i++) {
+		struct dma_resv *resv = vb->planes[i].dbuf->resv;
+
+		dma_resv_lock(resv, NULL);
+		dma_resv_add_excl_fence(resv, fence);
+		dma_resv_unlock(resv);
+	}
+
+	return fence;
+}
+EXPORT_SYMBOL_GPL(xvip_buffer_attach_fence);
+
+/**
+ * xvip_buffer_signal_fence - Signal and release a buffer write fence
+ * @fence: the fence returned by xvip_buffer_attach_fence(), may be NULL
+ * @error: 0 if the hardware completed the buffer, a negative error code
+ *	   otherwise
+ */
+void xvip_buffer_signal_fence(struct dma_fence *fence, int error)
+{
+	if (!fence)
+		return;
+
+	if (error)
+		dma_fence_set_error(fence, error);
+	dma_fence_signal(fence);
+	dma_fence_put(fence);
+}
+EXPORT_SYMBOL_GPL(xvip_buffer_signal_fence);
+
 /* -----------------------------------------------------------------------------
  * Subdev operations handlers
  */
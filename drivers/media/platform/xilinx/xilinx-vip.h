@@ -14,9 +14,12 @@
 
 #include <linux/bitops.h>
 #include <linux/io.h>
+#include <linux/spinlock.h>
 #include <media/v4l2-subdev.h>
+#include <media/videobuf2-core.h>
 
 struct clk;
+struct dma_fence;
 
 /*
  * Minimum and maximum width and height common to most video IP cores. IP
@@ -129,6 +132,20 @@ struct xvip_video_format {
 	u8 vsub;
 };
 
+/**
+ * struct xvip_fence_timeline - Timeline of the fences of a video buffers queue
+ * @lock: protects @seqno, and is the lock of the fences of the timeline
+ * @context: fence context
+ * @seqno: sequence number of the last fence created on the timeline
+ * @name: timeline name
+ */
+struct xvip_fence_timeline {
+	spinlock_t lock;
+	u64 context;
+	u64 seqno;
+	const char *name;
+};
+
 const struct xvip_video_format *xvip_get_format_by_code(unsigned int code);
 const struct xvip_video_format *xvip_get_format_by_fourcc(u32 fourcc);
 const struct xvip_video_format *xvip_of_get_format(struct device_node *node);
@@ -143,6 +160,13 @@ int xvip_enum_frame_size(struct v4l2_subdev *subdev,
 			 struct v4l2_subdev_pad_config *cfg,
 			 struct v4l2_subdev_frame_size_enum *fse);
 
+void xvip_fence_timeline_init(struct xvip_fence_timeline *tl,
+			      const char *name);
+int xvip_buffer_wait_fences(struct vb2_buffer *vb, bool write);
+struct dma_fence *xvip_buffer_attach_fence(struct xvip_fence_timeline *tl,
+					   struct vb2_buffer *vb);
+void xvip_buffer_signal_fence(struct dma_fence *fence, int error);
+
 static inline u32 xvip_read(struct xvip_device *xvip, u32 addr)
 {
 	return ioread32(xvip->iomem + addr);
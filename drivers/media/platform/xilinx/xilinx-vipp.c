@@ -9,6 +9,7 @@
  *           Laurent Pinchart <laurent.pinchart@ideasonboard.com>
  */
 
+#include <linux/debugfs.h>
 #include <linux/list.h>
 #include <linux/module.h>
 #include <linux/of.h>
@@ -19,7 +20,9 @@
 #include <media/v4l2-async.h>
 #include <media/v4l2-common.h>
 #include <media/v4l2-device.h>
+#include <media/v4l2-event.h>
 #include <media/v4l2-fwnode.h>
+#include <media/videobuf2-v4l2.h>
 
 #include "xilinx-dma.h"
 #include "xilinx-vipp.h"
@@ -656,6 +659,8 @@ static int xvip_graph_dma_init_one(struct xvip_composite_device *xdev,
 	else if (strcmp(direction, "output") == 0)
 		type = xvip_is_mplane ? V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE :
 					V4L2_BUF_TYPE_VIDEO_OUTPUT;
+	else if (strcmp(direction, "stats") == 0)
+		type = V4L2_BUF_TYPE_META_CAPTURE;
 	else
 		return -EINVAL;
 
@@ -681,6 +686,8 @@ static int xvip_graph_dma_init_one(struct xvip_composite_device *xdev,
 		xdev->v4l2_caps |= V4L2_CAP_VIDEO_OUTPUT;
 	else if (type == V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE)
 		xdev->v4l2_caps |= V4L2_CAP_VIDEO_OUTPUT_MPLANE;
+	else if (type == V4L2_BUF_TYPE_META_CAPTURE)
+		xdev->v4l2_caps |= V4L2_CAP_META_CAPTURE;
 
 	return 0;
 }
@@ -774,6 +781,39 @@ static void xvip_composite_v4l2_cleanup(struct xvip_composite_device *xdev)
 	media_device_cleanup(&xdev->media_dev);
 }
 
+static const struct media_device_ops xvip_media_ops = {
+	.req_validate = vb2_request_validate,
+	.req_queue = vb2_request_queue,
+};
+
+/*
+ * Forward the source change events of the sub-devices to the video nodes of
+ * their pipeline, so that applications can switch formats from the video
+ * node without stopping the stream. This may be called from interrupt
+ * context.
+ */
+static void xvip_composite_notify(struct v4l2_subdev *sd,
+				  unsigned int notification, void *arg)
+{
+	struct xvip_composite_device *xdev =
+		container_of(sd->v4l2_dev, struct xvip_composite_device,
+			     v4l2_dev);
+	const struct v4l2_event *event = arg;
+	struct xvip_dma *dma;
+
+	if (notification != V4L2_DEVICE_NOTIFY_EVENT ||
+	    event->type != V4L2_EVENT_SOURCE_CHANGE)
+		return;
+
+	list_for_each_entry(dma, &xdev->dmas, list) {
+		if (sd->entity.pipe &&
+		    sd->entity.pipe != dma->video.entity.pipe)
+			continue;
+
+		v4l2_event_queue(&dma->video, event);
+	}
+}
+
 static int xvip_composite_v4l2_init(struct xvip_composite_device *xdev)
 {
 	int ret;
@@ -782,10 +822,12 @@ static int xvip_composite_v4l2_init(struct xvip_composite_device *xdev)
 	strscpy(xdev->media_dev.model, "Xilinx Video Composite Device",
 		sizeof(xdev->media_dev.model));
 	xdev->media_dev.hw_revision = 0;
+	xdev->media_dev.ops = &xvip_media_ops;
 
 	media_device_init(&xdev->media_dev);
 
 	xdev->v4l2_dev.mdev = &xdev->media_dev;
+	xdev->v4l2_dev.notify = xvip_composite_notify;
 	ret = v4l2_device_register(xdev->dev, &xdev->v4l2_dev);
 	if (ret < 0) {
 		dev_err(xdev->dev, "V4L2 device registration failed (%d)\n",
@@ -819,6 +861,8 @@ static int xvip_composite_probe(struct platform_device *pdev)
 	if (ret < 0)
 		return ret;
 
+	xdev->debugfs = debugfs_create_dir(dev_name(xdev->dev), NULL);
+
 	ret = xvip_graph_init(xdev);
 	if (ret < 0)
 		goto error;
@@ -830,6 +874,7 @@ static int xvip_composite_probe(struct platform_device *pdev)
 	return 0;
 
 error:
+	debugfs_remove_recursive(xdev->debugfs);
 	xvip_composite_v4l2_cleanup(xdev);
 	return ret;
 }
@@ -840,6 +885,7 @@ static int xvip_composite_remove(struct platform_device *pdev)
 
 	mutex_destroy(&xdev->lock);
 	xvip_graph_cleanup(xdev);
+	debugfs_remove_recursive(xdev->debugfs);
 	xvip_composite_v4l2_cleanup(xdev);
 
 	return 0;
@@ -855,6 +901,7 @@ static struct platform_driver xvip_composite_driver = {
 	.driver = {
 		.name = "xilinx-video",
 		.of_match_table = xvip_composite_of_id_table,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 	.probe = xvip_composite_probe,
 	.remove = xvip_composite_remove,
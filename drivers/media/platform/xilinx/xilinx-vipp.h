@@ -28,6 +28,7 @@
  * @dmas: list of DMA channels at the pipeline output and input
  * @v4l2_caps: V4L2 capabilities of the whole device (see VIDIOC_QUERYCAP)
  * @lock: This is to ensure all dma path entities acquire same pipeline object
+ * @debugfs: debugfs directory of the DMA channels statistics
  */
 struct xvip_composite_device {
 	struct v4l2_device v4l2_dev;
@@ -39,6 +40,7 @@ struct xvip_composite_device {
 	struct list_head dmas;
 	u32 v4l2_caps;
 	struct mutex lock; /* lock to protect xvip pipeline instance */
+	struct dentry *debugfs;
 };
 
 int xvip_graph_pipeline_start_stop(struct xvip_composite_device *xdev,
@@ -164,6 +164,7 @@ rgb_to_ycrcb_unity[XV_CSC_K_MAX_ROWS][XV_CSC_K_MAX_COLUMNS + 1] = {
  * @rst_gpio: Handle to PS GPIO specifier to assert/de-assert the reset line
  * @max_width: Maximum width supported by IP.
  * @max_height: Maximum height supported by IP.
+ * @streaming: The IP is started, its registers follow the configuration
  */
 struct xcsc_dev {
 	struct xvip_device xvip;
@@ -194,6 +195,7 @@ struct xcsc_dev {
 	struct gpio_desc *rst_gpio;
 	u32 max_width;
 	u32 max_height;
+	bool streaming;
 };
 
 #ifdef DEBUG
@@ -310,6 +312,26 @@ static void xcsc_write_coeff(struct xcsc_dev *xcsc)
 	xcsc_write_rgb_offset(xcsc);
 }
 
+static void xcsc_write_config(struct xcsc_dev *xcsc)
+{
+	xcsc_write(xcsc, XV_CSC_INVIDEOFORMAT, xcsc->cft_in);
+	xcsc_write(xcsc, XV_CSC_OUTVIDEOFORMAT, xcsc->cft_out);
+	xcsc_write_coeff(xcsc);
+	xcsc_write(xcsc, XV_CSC_CLIPMAX, xcsc->clip_max);
+	xcsc_write(xcsc, XV_CSC_CLAMPMIN, XCSC_CLAMP_MIN_ZERO);
+}
+
+/*
+ * The IP is reset when the stream stops and s_stream() writes the whole
+ * configuration, so the coefficients only go to the registers right away
+ * while streaming.
+ */
+static void xcsc_update_coeff(struct xcsc_dev *xcsc)
+{
+	if (xcsc->streaming)
+		xcsc_write_coeff(xcsc);
+}
+
 static void xcsc_set_v4l2_ctrl_defaults(struct xcsc_dev *xcsc)
 {
 	unsigned int i;
@@ -361,11 +383,7 @@ static void xcsc_set_default_state(struct xcsc_dev *xcsc)
 	xcsc->clip_max = BIT(xcsc->color_depth) - 1;
 	xcsc_set_control_defaults(xcsc);
 	xcsc_set_unity_matrix(xcsc);
-	xcsc_write(xcsc, XV_CSC_INVIDEOFORMAT, xcsc->cft_in);
-	xcsc_write(xcsc, XV_CSC_OUTVIDEOFORMAT, xcsc->cft_out);
-	xcsc_write_coeff(xcsc);
-	xcsc_write(xcsc, XV_CSC_CLIPMAX, xcsc->clip_max);
-	xcsc_write(xcsc, XV_CSC_CLAMPMIN, XCSC_CLAMP_MIN_ZERO);
+	xcsc_write_config(xcsc);
 }
 
 static void
@@ -448,6 +466,10 @@ xcsc_rgb_to_ycrcb(struct xcsc_dev *xcsc, s32 *clip_max,
 	*clip_max = BIT(xcsc->color_depth) - 1;
 }
 
+/*
+ * Compute the configuration of the formats, it is written to the IP by
+ * s_stream() or right away while streaming
+ */
 static int xcsc_update_formats(struct xcsc_dev *xcsc)
 {
 	u32 color_in, color_out;
@@ -518,16 +540,8 @@ static int xcsc_update_formats(struct xcsc_dev *xcsc)
 		break;
 	}
 
-	xcsc_write(xcsc, XV_CSC_INVIDEOFORMAT, xcsc->cft_in);
-	xcsc_write(xcsc, XV_CSC_OUTVIDEOFORMAT, xcsc->cft_out);
-
-	xcsc_write_coeff(xcsc);
-
-	xcsc_write(xcsc, XV_CSC_CLIPMAX, xcsc->clip_max);
-	xcsc_write(xcsc, XV_CSC_CLAMPMIN, XCSC_CLAMP_MIN_ZERO);
 #ifdef DEBUG
 	xcsc_print_k_hw(xcsc);
-	xcsc_print_coeff(xcsc);
 #endif
 	return 0;
 }
@@ -586,6 +600,15 @@ xcsc_correct_coeff(struct xcsc_dev *xcsc,
 		dev_dbg(xcsc->xvip.dev, "%s : YUV to RGB", __func__);
 		xcsc_ycrcb_to_rgb(xcsc, &xcsc->clip_max, csc_change);
 		xcsc_matrix_multiply(csc_change, temp, xcsc->k_hw);
+	} else if (mbus_in != MEDIA_BUS_FMT_RBG888_1X24 &&
+		   mbus_out != MEDIA_BUS_FMT_RBG888_1X24 &&
+		   !memcmp(temp, rgb_unity_matrix, sizeof(rgb_unity_matrix))) {
+		/*
+		 * No color correction, skip the round trip through RGB which
+		 * would leave rounding errors in place of a unity matrix.
+		 */
+		dev_dbg(xcsc->xvip.dev, "%s : YUV to YUV unity", __func__);
+		xcsc_set_unity_matrix(xcsc);
 	} else if (mbus_in != MEDIA_BUS_FMT_RBG888_1X24 &&
 		   mbus_out != MEDIA_BUS_FMT_RBG888_1X24) {
 		dev_dbg(xcsc->xvip.dev, "%s : YUV to YUV", __func__);
@@ -619,7 +642,7 @@ static void xcsc_set_brightness(struct xcsc_dev *xcsc)
 	}
 	xcsc->brightness_active = xcsc->brightness;
 	xcsc_correct_coeff(xcsc, xcsc->shadow_coeff);
-	xcsc_write_coeff(xcsc);
+	xcsc_update_coeff(xcsc);
 }
 
 static void xcsc_set_contrast(struct xcsc_dev *xcsc)
@@ -640,7 +663,7 @@ static void xcsc_set_contrast(struct xcsc_dev *xcsc)
 	xcsc->shadow_coeff[2][3] += contrast * scale;
 	xcsc->contrast_active = xcsc->contrast;
 	xcsc_correct_coeff(xcsc, xcsc->shadow_coeff);
-	xcsc_write_coeff(xcsc);
+	xcsc_update_coeff(xcsc);
 }
 
 static void xcsc_set_red_gain(struct xcsc_dev *xcsc)
@@ -662,7 +685,7 @@ static void xcsc_set_red_gain(struct xcsc_dev *xcsc)
 					    xcsc->red_gain_active;
 		xcsc->red_gain_active = xcsc->red_gain;
 		xcsc_correct_coeff(xcsc, xcsc->shadow_coeff);
-		xcsc_write_coeff(xcsc);
+		xcsc_update_coeff(xcsc);
 	}
 }
 
@@ -685,7 +708,7 @@ static void xcsc_set_green_gain(struct xcsc_dev *xcsc)
 					    xcsc->green_gain_active;
 		xcsc->green_gain_active = xcsc->green_gain;
 		xcsc_correct_coeff(xcsc, xcsc->shadow_coeff);
-		xcsc_write_coeff(xcsc);
+		xcsc_update_coeff(xcsc);
 	}
 }
 
@@ -708,7 +731,7 @@ static void xcsc_set_blue_gain(struct xcsc_dev *xcsc)
 					     xcsc->blue_gain_active;
 		xcsc->blue_gain_active = xcsc->blue_gain;
 		xcsc_correct_coeff(xcsc, xcsc->shadow_coeff);
-		xcsc_write_coeff(xcsc);
+		xcsc_update_coeff(xcsc);
 	}
 }
 
@@ -732,16 +755,14 @@ static int xcsc_s_stream(struct v4l2_subdev *subdev, int enable)
 		enable ? "On" : "Off");
 	if (!enable) {
 		/* Reset the Global IP Reset through PS GPIO */
+		xcsc->streaming = false;
 		gpiod_set_value_cansleep(xcsc->rst_gpio, XCSC_RESET_ASSERT);
 		gpiod_set_value_cansleep(xcsc->rst_gpio, XCSC_RESET_DEASSERT);
 		return 0;
 	}
-	xcsc_write(xcsc, XV_CSC_INVIDEOFORMAT, xcsc->cft_in);
-	xcsc_write(xcsc, XV_CSC_OUTVIDEOFORMAT, xcsc->cft_out);
-	xcsc_write(xcsc, XV_CSC_CLIPMAX, xcsc->clip_max);
-	xcsc_write(xcsc, XV_CSC_CLAMPMIN, XCSC_CLAMP_MIN_ZERO);
+	/* The whole configuration, the reset at stream off cleared it */
+	xcsc_write_config(xcsc);
 	xcsc_set_size(xcsc);
-	xcsc_write_coeff(xcsc);
 #ifdef DEBUG
 	xcsc_print_coeff(xcsc);
 	dev_dbg(xcsc->xvip.dev, "cft_in = %d cft_out = %d",
@@ -756,6 +777,7 @@ static int xcsc_s_stream(struct v4l2_subdev *subdev, int enable)
 #endif
 	/* Start VPSS CSC IP */
 	xcsc_write(xcsc, XV_CSC_AP_CTRL, XCSC_STREAM_ON);
+	xcsc->streaming = true;
 	return 0;
 }
 
@@ -824,7 +846,12 @@ static int xcsc_set_format(struct v4l2_subdev *subdev,
 	__propagate->height = __format->height;
 
 	fmt->format = *__format;
+	if (fmt->which == V4L2_SUBDEV_FORMAT_TRY)
+		return 0;
+
 	xcsc_update_formats(xcsc);
+	if (xcsc->streaming)
+		xcsc_write_config(xcsc);
 	xcsc_set_control_defaults(xcsc);
 	xcsc_set_v4l2_ctrl_defaults(xcsc);
 	dev_info(xcsc->xvip.dev, "VPSS CSC color controls reset to defaults");
@@ -948,6 +948,8 @@ struct xscaler_feature {
  * @H_phases: The phases needed to program the H-scaler for different taps
  * @hscaler_coeff: The complete array of H-scaler coefficients
  * @vscaler_coeff: The complete array of V-scaler coefficients
+ * @hscaler_bank: H-scaler coefficient bank programmed, NULL if none
+ * @vscaler_bank: V-scaler coefficient bank programmed, NULL if none
  * @is_polyphase: Track if scaling algorithm is polyphase or not
  * @rst_gpio: GPIO reset line to bring VPSS Scaler out of reset
  * @cfg: Pointer to scaler config structure
@@ -971,6 +973,8 @@ struct xscaler_device {
 	u64 H_phases[XV_HSCALER_MAX_LINE_WIDTH];
 	short hscaler_coeff[XV_HSCALER_MAX_H_PHASES][XV_HSCALER_MAX_H_TAPS];
 	short vscaler_coeff[XV_VSCALER_MAX_V_PHASES][XV_VSCALER_MAX_V_TAPS];
+	const short *hscaler_bank;
+	const short *vscaler_bank;
 	bool is_polyphase;
 
 	struct gpio_desc *rst_gpio;
@@ -1207,6 +1211,28 @@ static const short *xv_select_coeff(struct xscaler_device *xscaler,
 	return coeff;
 }
 
+static void xv_hscaler_set_coeff(struct xscaler_device *xscaler)
+{
+	int val, i, j, offset, rd_indx;
+	u32 ntaps = xscaler->num_hori_taps;
+	u32 nphases = xscaler->max_num_phases;
+	u32 base_addr;
+
+	offset = (XV_HSCALER_MAX_H_TAPS - ntaps) / 2;
+	base_addr = V_HSCALER_OFF + XV_HSCALER_CTRL_ADDR_HWREG_HFLTCOEFF_BASE;
+	for (i = 0; i < nphases; i++) {
+		for (j = 0; j < ntaps / 2; j++) {
+			rd_indx = j * 2 + offset;
+			val = (xscaler->hscaler_coeff[i][rd_indx + 1] <<
+			       XSCALER_BITSHIFT_16) |
+			       (xscaler->hscaler_coeff[i][rd_indx] &
+			       XHSC_MASK_LOW_16BITS);
+			 xvip_write(&xscaler->xvip, base_addr +
+				    ((i * ntaps / 2 + j) * 4), val);
+		}
+	}
+}
+
 /**
  * xv_hscaler_coeff_select - Selection of H-Scaler coefficients of operation
  * @xscaler: VPSS Scaler device information
@@ -1227,6 +1253,10 @@ static const short *xv_select_coeff(struct xscaler_device *xscaler,
  * This selection is adopted by the as it gives optimal
  * video output determined by repeated testing of the IP
  *
+ * The selected coefficients are programmed unless the same bank is already
+ * programmed. The coefficient memories keep their content across the IP
+ * reset, so a bank stays valid until another one is programmed.
+ *
  * Return: Will return 0 if successful. Returns -EINVAL on an unsupported
  * H-scaler number of taps.
  */
@@ -1241,32 +1271,16 @@ xv_hscaler_select_coeff(struct xscaler_device *xscaler,
 	if (!coeff)
 		return -EINVAL;
 
+	/* The bank is still programmed from a previous stream */
+	if (coeff == xscaler->hscaler_bank)
+		return 0;
+
 	xv_hscaler_load_ext_coeff(xscaler, coeff, ntaps);
+	xv_hscaler_set_coeff(xscaler);
+	xscaler->hscaler_bank = coeff;
 	return 0;
 }
 
-static void xv_hscaler_set_coeff(struct xscaler_device *xscaler)
-{
-	int val, i, j, offset, rd_indx;
-	u32 ntaps = xscaler->num_hori_taps;
-	u32 nphases = xscaler->max_num_phases;
-	u32 base_addr;
-
-	offset = (XV_HSCALER_MAX_H_TAPS - ntaps) / 2;
-	base_addr = V_HSCALER_OFF + XV_HSCALER_CTRL_ADDR_HWREG_HFLTCOEFF_BASE;
-	for (i = 0; i < nphases; i++) {
-		for (j = 0; j < ntaps / 2; j++) {
-			rd_indx = j * 2 + offset;
-			val = (xscaler->hscaler_coeff[i][rd_indx + 1] <<
-			       XSCALER_BITSHIFT_16) |
-			       (xscaler->hscaler_coeff[i][rd_indx] &
-			       XHSC_MASK_LOW_16BITS);
-			 xvip_write(&xscaler->xvip, base_addr +
-				    ((i * ntaps / 2 + j) * 4), val);
-		}
-	}
-}
-
 static void
 xv_vscaler_load_ext_coeff(struct xscaler_device *xscaler,
 			  const short *coeff, u32 ntaps)
@@ -1345,6 +1359,10 @@ static void xv_vscaler_set_coeff(struct xscaler_device *xscaler)
  * This selection is adopted by the as it gives optimal
  * video output determined by repeated testing of the IP
  *
+ * The selected coefficients are programmed unless the same bank is already
+ * programmed. The coefficient memories keep their content across the IP
+ * reset, so a bank stays valid until another one is programmed.
+ *
  * Return: Will return 0 if successful. Returns -EINVAL on an unsupported
  * V-scaler number of taps.
  */
@@ -1359,7 +1377,13 @@ xv_vscaler_select_coeff(struct xscaler_device *xscaler,
 	if (!coeff)
 		return -EINVAL;
 
+	/* The bank is still programmed from a previous stream */
+	if (coeff == xscaler->vscaler_bank)
+		return 0;
+
 	xv_vscaler_load_ext_coeff(xscaler, coeff, ntaps);
+	xv_vscaler_set_coeff(xscaler);
+	xscaler->vscaler_bank = coeff;
 	return 0;
 }
 
@@ -1623,7 +1647,6 @@ static int xscaler_s_stream(struct v4l2_subdev *subdev, int enable)
 		ret = xv_vscaler_select_coeff(xscaler, height_in, height_out);
 		if (ret < 0)
 			return ret;
-		xv_vscaler_set_coeff(xscaler);
 	}
 
 	xvip_write(&xscaler->xvip, V_VSCALER_OFF +
@@ -1657,7 +1680,6 @@ static int xscaler_s_stream(struct v4l2_subdev *subdev, int enable)
 		ret = xv_hscaler_select_coeff(xscaler, width_in, width_out);
 		if (ret < 0)
 			return ret;
-		xv_hscaler_set_coeff(xscaler);
 	}
 
 	xv_hscaler_calculate_phases(xscaler, width_in, width_out, pixel_rate);
@@ -13,7 +13,9 @@
 #include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/errno.h>
+#include <linux/gpio/consumer.h>
 #include <linux/init.h>
+#include <linux/interrupt.h>
 #include <linux/io.h>
 #include <linux/module.h>
 #include <linux/of_device.h>
@@ -21,6 +23,7 @@
 #include <linux/slab.h>
 #include <linux/uaccess.h>
 #include <linux/wait.h>
+#include <linux/workqueue.h>
 
 #include "xilinx_jesd204b.h"
 
@@ -33,6 +36,22 @@ struct child_clk {
 
 #define to_clk_priv(_hw) container_of(_hw, struct child_clk, hw)
 
+/* Link state machine polling period and synchronisation timeout */
+#define JESD204B_LINK_POLL_MS		1
+#define JESD204B_LINK_SYNC_TIMEOUT_MS	100
+
+#define JESD204B_SNAPSHOT_SIZE						\
+	((XLNX_JESD204_NUM_LINK_REGS +					\
+	  XLNX_JESD204_MAX_LANES * XLNX_JESD204_NUM_LANE_REGS) * sizeof(u32))
+
+static const char * const jesd204b_link_state_names[] = {
+	[JESD204B_LINK_DOWN] = "down",
+	[JESD204B_LINK_RESET] = "reset",
+	[JESD204B_LINK_SYNCING] = "syncing",
+	[JESD204B_LINK_UP] = "up",
+	[JESD204B_LINK_FAILED] = "failed",
+};
+
 static inline void jesd204b_write(struct jesd204b_state *st,
 				  unsigned int reg, unsigned int val)
 {
@@ -203,6 +222,153 @@ static ssize_t jesd204b_syncreg_read(struct device *dev,
 
 static DEVICE_ATTR(sync_status, 0400, jesd204b_syncreg_read, NULL);
 
+static void jesd204b_link_queue(struct jesd204b_state *st, unsigned int ms)
+{
+	mod_delayed_work(system_highpri_wq, &st->link_work,
+			 msecs_to_jiffies(ms));
+}
+
+/* Reset the core and resynchronise the link from the state machine */
+static void jesd204b_link_restart(struct jesd204b_state *st)
+{
+	WRITE_ONCE(st->link_state, JESD204B_LINK_RESET);
+	jesd204b_write(st, XLNX_JESD204_REG_RESET, XLNX_JESD204_RESET);
+	jesd204b_link_queue(st, 0);
+}
+
+static void jesd204b_link_work(struct work_struct *work)
+{
+	struct jesd204b_state *st = container_of(to_delayed_work(work),
+						 struct jesd204b_state,
+						 link_work);
+	u32 sync;
+
+	switch (st->link_state) {
+	case JESD204B_LINK_RESET:
+		if (jesd204b_read(st, XLNX_JESD204_REG_RESET) &
+		    XLNX_JESD204_RESET) {
+			jesd204b_link_queue(st, JESD204B_LINK_POLL_MS);
+			break;
+		}
+
+		jesd204b_write(st, XLNX_JESD204_REG_ILA_CTRL, st->ila_ctrl);
+		jesd204b_write(st, XLNX_JESD204_REG_SCR_CTRL, st->scr_ctrl);
+		jesd204b_write(st, XLNX_JESD204_REG_SYSREF_CTRL,
+			       st->sysref_ctrl);
+
+		st->sync_deadline = jiffies +
+			msecs_to_jiffies(JESD204B_LINK_SYNC_TIMEOUT_MS);
+		WRITE_ONCE(st->link_state, JESD204B_LINK_SYNCING);
+		/* fall through */
+	case JESD204B_LINK_SYNCING:
+		sync = jesd204b_read(st, XLNX_JESD204_REG_SYNC_STATUS);
+		if (sync & XLNX_JESD204_SYNC_STAT_SYNC) {
+			WRITE_ONCE(st->link_state, JESD204B_LINK_UP);
+			dev_dbg(st->dev, "link up\n");
+		} else if (time_after(jiffies, st->sync_deadline)) {
+			WRITE_ONCE(st->link_state, JESD204B_LINK_FAILED);
+			dev_warn(st->dev, "link failed to synchronise\n");
+		} else if (st->sync_gpio) {
+			/* The SYNC interrupt requeues the work earlier */
+			mod_delayed_work(system_highpri_wq, &st->link_work,
+					 st->sync_deadline - jiffies + 1);
+		} else {
+			jesd204b_link_queue(st, JESD204B_LINK_POLL_MS);
+		}
+		break;
+	case JESD204B_LINK_UP:
+		sync = jesd204b_read(st, XLNX_JESD204_REG_SYNC_STATUS);
+		if (!(sync & XLNX_JESD204_SYNC_STAT_SYNC)) {
+			dev_dbg(st->dev, "link lost synchronisation\n");
+			jesd204b_link_restart(st);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/* SYNC~ changed, the link either synchronised or requests a resync */
+static irqreturn_t jesd204b_sync_irq(int irq, void *data)
+{
+	struct jesd204b_state *st = data;
+
+	jesd204b_link_queue(st, 0);
+
+	return IRQ_HANDLED;
+}
+
+static int jesd204b_clk_notifier(struct notifier_block *nb,
+				 unsigned long event, void *data)
+{
+	struct jesd204b_state *st = container_of(nb, struct jesd204b_state,
+						 clk_nb);
+	struct clk_notifier_data *ndata = data;
+
+	if (event != POST_RATE_CHANGE)
+		return NOTIFY_DONE;
+
+	st->rate = ndata->new_rate;
+	jesd204b_link_restart(st);
+
+	return NOTIFY_OK;
+}
+
+static ssize_t jesd204b_link_state_read(struct device *dev,
+					struct device_attribute *attr,
+					char *buf)
+{
+	struct jesd204b_state *st = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%s\n",
+		       jesd204b_link_state_names[READ_ONCE(st->link_state)]);
+}
+
+static ssize_t jesd204b_link_state_write(struct device *dev,
+					 struct device_attribute *attr,
+					 const char *buf, size_t count)
+{
+	struct jesd204b_state *st = dev_get_drvdata(dev);
+
+	if (!sysfs_streq(buf, "restart"))
+		return -EINVAL;
+
+	jesd204b_link_restart(st);
+
+	return count;
+}
+
+static DEVICE_ATTR(link_state, 0600, jesd204b_link_state_read,
+		   jesd204b_link_state_write);
+
+/*
+ * Snapshot of the link status: the link registers 0x000 to 0x03C, then the
+ * 13 registers 0x800 to 0x830 of each of the 8 lanes, 0 for unused lanes.
+ */
+static ssize_t snapshot_read(struct file *filp, struct kobject *kobj,
+			     struct bin_attribute *attr, char *buf,
+			     loff_t off, size_t count)
+{
+	struct device *dev = kobj_to_dev(kobj);
+	struct jesd204b_state *st = dev_get_drvdata(dev);
+	u32 regs[JESD204B_SNAPSHOT_SIZE / sizeof(u32)] = { 0 };
+	unsigned int i, lane, n = 0;
+
+	for (i = 0; i < XLNX_JESD204_NUM_LINK_REGS; i++)
+		regs[n++] = jesd204b_read(st, i * sizeof(u32));
+
+	for (lane = 0; lane < XLNX_JESD204_MAX_LANES; lane++)
+		for (i = 0; i < XLNX_JESD204_NUM_LANE_REGS; i++, n++)
+			if (lane < st->lanes)
+				regs[n] = jesd204b_read(st,
+					XLNX_JESD204_REG_LANE_VERSION(lane) +
+					i * sizeof(u32));
+
+	return memory_read_from_buffer(buf, count, &off, regs, sizeof(regs));
+}
+
+static BIN_ATTR_RO(snapshot, JESD204B_SNAPSHOT_SIZE);
+
 /* Match table for of_platform binding */
 static const struct of_device_id jesd204b_of_match[] = {
 	{ .compatible = "xlnx,jesd204-5.1",},
@@ -253,24 +419,40 @@ static int jesd204b_probe(struct platform_device *pdev)
 	if (ret)
 		st->lanes = jesd204b_read(st, XLNX_JESD204_REG_LANES) + 1;
 
-	jesd204b_write(st, XLNX_JESD204_REG_RESET, XLNX_JESD204_RESET);
-	while (!jesd204b_read(st, XLNX_JESD204_REG_RESET))
-		msleep(20);
-
-	jesd204b_write(st, XLNX_JESD204_REG_ILA_CTRL,
-		       (of_property_read_bool(pdev->dev.of_node,
-			"xlnx,lanesync-enable") ? XLNX_JESD204_ILA_EN : 0));
-
-	jesd204b_write(st, XLNX_JESD204_REG_SCR_CTRL,
-		       (of_property_read_bool(pdev->dev.of_node,
-			"xlnx,scramble-enable") ? XLNX_JESD204_SCR_EN : 0));
-
-	jesd204b_write(st, XLNX_JESD204_REG_SYSREF_CTRL,
-		       (of_property_read_bool(pdev->dev.of_node,
-			"xlnx,sysref-always-enable") ?
-			XLNX_JESD204_ALWAYS_SYSREF_EN : 0));
+	st->ila_ctrl = of_property_read_bool(pdev->dev.of_node,
+					     "xlnx,lanesync-enable") ?
+		       XLNX_JESD204_ILA_EN : 0;
+
+	st->scr_ctrl = of_property_read_bool(pdev->dev.of_node,
+					     "xlnx,scramble-enable") ?
+		       XLNX_JESD204_SCR_EN : 0;
+
+	st->sysref_ctrl = of_property_read_bool(pdev->dev.of_node,
+						"xlnx,sysref-always-enable") ?
+			  XLNX_JESD204_ALWAYS_SYSREF_EN : 0;
+
+	INIT_DELAYED_WORK(&st->link_work, jesd204b_link_work);
+
+	/* SYNC~ line of the link, to detect synchronisation without polling */
+	st->sync_gpio = devm_gpiod_get_optional(&pdev->dev, "sync", GPIOD_IN);
+	if (IS_ERR(st->sync_gpio))
+		return PTR_ERR(st->sync_gpio);
+
+	if (st->sync_gpio) {
+		ret = devm_request_irq(&pdev->dev, gpiod_to_irq(st->sync_gpio),
+				       jesd204b_sync_irq,
+				       IRQF_TRIGGER_RISING |
+				       IRQF_TRIGGER_FALLING,
+				       dev_name(&pdev->dev), st);
+		if (ret) {
+			dev_err(&pdev->dev, "Unable to request SYNC irq.\n");
+			return ret;
+		}
+	}
 
 	device_create_file(&pdev->dev, &dev_attr_reg_access);
+	device_create_file(&pdev->dev, &dev_attr_link_state);
+	device_create_bin_file(&pdev->dev, &bin_attr_snapshot);
 
 	device_create_file(&pdev->dev, &dev_attr_sync_status);
 	switch (st->lanes) {
@@ -331,6 +513,14 @@ static int jesd204b_probe(struct platform_device *pdev)
 		dev_err(&pdev->dev, "Unable to enable clock.\n");
 		return ret;
 	}
+	/* Relink as soon as the lane rate changes */
+	st->clk_nb.notifier_call = jesd204b_clk_notifier;
+	ret = clk_notifier_register(clk, &st->clk_nb);
+	if (ret)
+		dev_warn(&pdev->dev, "Unable to register clock notifier.\n");
+
+	jesd204b_link_restart(st);
+
 	val = jesd204b_read(st, XLNX_JESD204_REG_VERSION);
 
 	dev_info(&pdev->dev,
@@ -347,6 +537,10 @@ static int jesd204b_remove(struct platform_device *pdev)
 {
 	struct jesd204b_state *st = platform_get_drvdata(pdev);
 
+	clk_notifier_unregister(st->clk, &st->clk_nb);
+	if (st->sync_gpio)
+		devm_free_irq(&pdev->dev, gpiod_to_irq(st->sync_gpio), st);
+	cancel_delayed_work_sync(&st->link_work);
 	clk_disable_unprepare(st->clk);
 	clk_put(st->clk);
 
@@ -11,6 +11,22 @@
 #ifndef XILINX_JESD204B_H_
 #define XILINX_JESD204B_H_
 
+/**
+ * enum jesd204b_link_state - State of the link bring-up state machine
+ * @JESD204B_LINK_DOWN: Link not started
+ * @JESD204B_LINK_RESET: Core reset in progress
+ * @JESD204B_LINK_SYNCING: Waiting for the link to synchronise
+ * @JESD204B_LINK_UP: Link synchronised
+ * @JESD204B_LINK_FAILED: Link did not synchronise in time
+ */
+enum jesd204b_link_state {
+	JESD204B_LINK_DOWN,
+	JESD204B_LINK_RESET,
+	JESD204B_LINK_SYNCING,
+	JESD204B_LINK_UP,
+	JESD204B_LINK_FAILED,
+};
+
 struct jesd204b_state {
 	struct device	*dev;
 	void __iomem	*regs;
@@ -23,6 +39,14 @@ struct jesd204b_state {
 	u32		transmit;
 	u32		pll;
 	unsigned long	rate;
+	u32		ila_ctrl;
+	u32		scr_ctrl;
+	u32		sysref_ctrl;
+	enum jesd204b_link_state	link_state;
+	unsigned long	sync_deadline;
+	struct delayed_work	link_work;
+	struct notifier_block	clk_nb;
+	struct gpio_desc	*sync_gpio;
 };
 
 #define XLNX_JESD204_REG_VERSION		0x000
@@ -66,6 +90,7 @@ struct jesd204b_state {
 						   */
 
 #define XLNX_JESD204_REG_SYNC_STATUS		0x038 /* Link SYNC status */
+#define XLNX_JESD204_SYNC_STAT_SYNC		(1 << 0)
 #define XLNX_JESD204_REG_SYNC_ERR_STAT		0x01C /* RX only */
 #define XLNX_JESD204_SYNC_ERR_NOT_IN_TAB(lane)		(1 << (0 + (lane) * 3))
 #define XLNX_JESD204_SYNC_ERR_DISPARITY(lane)		(1 << (1 + (lane) * 3))
@@ -132,4 +157,8 @@ struct jesd204b_state {
 #define XLNX_JESD204_REG_TM_MFC_CNT(l)		(0x82C + ((l) * 0x40))
 #define XLNX_JESD204_REG_TM_BUF_ADJ(l)		(0x830 + ((l) * 0x40))
 
+#define XLNX_JESD204_NUM_LINK_REGS		16 /* 0x000..0x03C */
+#define XLNX_JESD204_NUM_LANE_REGS		13 /* 0x800..0x830 */
+#define XLNX_JESD204_MAX_LANES			8
+
 #endif /* ADI_JESD204B_V51_H_ */
@@ -29,12 +29,24 @@
 #define AIE_SHIMNOC_DMA_BD0_ADDRLOW_REGOFF	0x0001d000U
 #define AIE_SHIMNOC_DMA_BD15_PACKET_REGOFF	0x0001d13cU
 #define AIE_SHIMNOC_AXIMM_REGOFF		0x0001e020U
+#define AIE_SHIMNOC_MUX_CONFIG_REGOFF		0x0001f000U
+#define AIE_SHIMNOC_DEMUX_CONFIG_REGOFF		0x0001f004U
 #define AIE_SHIMPL_L1INTR_MASK_A_REGOFF		0x00035000U
 #define AIE_SHIMPL_L1INTR_BLOCK_NORTH_B_REGOFF	0x00035050U
 #define AIE_SHIMPL_CLKCNTR_REGOFF		0x00036040U
 #define AIE_SHIMPL_COLRESET_REGOFF		0x00036048U
 #define AIE_SHIMPL_RESET_REGOFF			0x0003604cU
 #define AIE_SHIMPL_GROUP_ERROR_REGOFF		0x0003450cU
+#define AIE_SHIMPL_STRMSW_START_REGOFF		0x0003f000U
+#define AIE_SHIMPL_STRMSW_END_REGOFF		0x0003f35cU
+#define AIE_TILE_DATA_MEM_START_REGOFF		0x00000000U
+#define AIE_TILE_DATA_MEM_END_REGOFF		0x00007ffcU
+#define AIE_TILE_PROG_MEM_START_REGOFF		0x00020000U
+#define AIE_TILE_PROG_MEM_END_REGOFF		0x00023ffcU
+#define AIE_TILE_MEM_DMA_BD0_REGOFF		0x0001d000U
+#define AIE_TILE_MEM_DMA_BD15_END_REGOFF	0x0001d1fcU
+#define AIE_TILE_STRMSW_START_REGOFF		0x0003f000U
+#define AIE_TILE_STRMSW_END_REGOFF		0x0003f37cU
 #define AIE_TILE_CORE_CLKCNTR_REGOFF		0x00036040U
 #define AIE_TILE_CORE_GROUP_ERROR_REGOFF	0x00034510U
 #define AIE_TILE_MEM_GROUP_ERROR_REGOFF		0x00014514U
@@ -120,6 +132,50 @@ static const struct aie_tile_regs aie_kernel_regs[] = {
 	},
 };
 
+/*
+ * Memories and configuration registers saved in a partition context. The
+ * DMA channels control and start queues, the locks and the cores control
+ * are not saved as writing them back starts the hardware.
+ */
+static const struct aie_tile_regs aie_ctx_regs[] = {
+	/* SHIM DMA buffer descriptors */
+	{.attribute = AIE_TILE_TYPE_SHIMNOC << AIE_REGS_ATTR_TILE_TYPE_SHIFT,
+	 .soff = AIE_SHIMNOC_DMA_BD0_ADDRLOW_REGOFF,
+	 .eoff = AIE_SHIMNOC_DMA_BD15_PACKET_REGOFF,
+	},
+	/* SHIM NOC stream mux and demux */
+	{.attribute = AIE_TILE_TYPE_SHIMNOC << AIE_REGS_ATTR_TILE_TYPE_SHIFT,
+	 .soff = AIE_SHIMNOC_MUX_CONFIG_REGOFF,
+	 .eoff = AIE_SHIMNOC_DEMUX_CONFIG_REGOFF,
+	},
+	/* SHIM stream switch */
+	{.attribute = (AIE_TILE_TYPE_SHIMPL | AIE_TILE_TYPE_SHIMNOC) <<
+		      AIE_REGS_ATTR_TILE_TYPE_SHIFT,
+	 .soff = AIE_SHIMPL_STRMSW_START_REGOFF,
+	 .eoff = AIE_SHIMPL_STRMSW_END_REGOFF,
+	},
+	/* Tile data memory */
+	{.attribute = AIE_TILE_TYPE_TILE << AIE_REGS_ATTR_TILE_TYPE_SHIFT,
+	 .soff = AIE_TILE_DATA_MEM_START_REGOFF,
+	 .eoff = AIE_TILE_DATA_MEM_END_REGOFF,
+	},
+	/* Tile program memory */
+	{.attribute = AIE_TILE_TYPE_TILE << AIE_REGS_ATTR_TILE_TYPE_SHIFT,
+	 .soff = AIE_TILE_PROG_MEM_START_REGOFF,
+	 .eoff = AIE_TILE_PROG_MEM_END_REGOFF,
+	},
+	/* Tile DMA buffer descriptors */
+	{.attribute = AIE_TILE_TYPE_TILE << AIE_REGS_ATTR_TILE_TYPE_SHIFT,
+	 .soff = AIE_TILE_MEM_DMA_BD0_REGOFF,
+	 .eoff = AIE_TILE_MEM_DMA_BD15_END_REGOFF,
+	},
+	/* Tile stream switch */
+	{.attribute = AIE_TILE_TYPE_TILE << AIE_REGS_ATTR_TILE_TYPE_SHIFT,
+	 .soff = AIE_TILE_STRMSW_START_REGOFF,
+	 .eoff = AIE_TILE_STRMSW_END_REGOFF,
+	},
+};
+
 static const struct aie_single_reg_field aie_col_rst = {
 	.mask = AIE_SHIMPL_COLRST_MASK,
 	.regoff = AIE_SHIMPL_COLRESET_REGOFF,
@@ -143,9 +199,57 @@ static const struct aie_dma_attr aie_shimdma = {
 		.mask = 0xffffffffU,
 		.regoff = 0x4U,
 	},
+	.next_bd = {
+		.mask = GENMASK(14, 11),
+		.regoff = 0x10U,
+	},
+	.use_next_bd = {
+		.mask = BIT(15),
+		.regoff = 0x10U,
+	},
+	.valid_bd = {
+		.mask = BIT(0),
+		.regoff = 0x10U,
+	},
+	.lock_id = {
+		.mask = GENMASK(25, 22),
+		.regoff = 0x10U,
+	},
+	.chan_ctrl = {
+		.mask = BIT(0),
+		.regoff = 0x0001d140U,
+	},
+	.start_queue = {
+		.mask = GENMASK(3, 0),
+		.regoff = 0x0001d144U,
+	},
+	.chan_regoff = 0x8U,
 	.bd_regoff = 0x0001d000U,
 	.num_bds = 16,
 	.bd_len = 0x14U,
+	.num_chans = 4U,
+	.bd_done_event = 18U,
+};
+
+static const struct aie_perfcnt_attr aie_pl_perfcnt = {
+	.ctrl_regoff = 0x31000U,
+	.reset_regoff = 0x31008U,
+	.cnt_regoff = 0x31020U,
+	.num_cnts = 2U,
+};
+
+static const struct aie_perfcnt_attr aie_mem_perfcnt = {
+	.ctrl_regoff = 0x11000U,
+	.reset_regoff = 0x11008U,
+	.cnt_regoff = 0x11020U,
+	.num_cnts = 2U,
+};
+
+static const struct aie_perfcnt_attr aie_core_perfcnt = {
+	.ctrl_regoff = 0x31000U,
+	.reset_regoff = 0x31008U,
+	.cnt_regoff = 0x31020U,
+	.num_cnts = 4U,
 };
 
 static const struct aie_event_attr aie_pl_event = {
@@ -219,6 +323,22 @@ static const struct aie_l1_intr_ctrl_attr aie_l1_intr_ctrl = {
 		.mask = GENMASK(6, 0),
 		.regoff = 0x44U,
 	},
+	.swa_enable = {
+		.mask = GENMASK(19, 0),
+		.regoff = 0x4U,
+	},
+	.swb_enable = {
+		.mask = GENMASK(19, 0),
+		.regoff = 0x34U,
+	},
+	.swa_disable = {
+		.mask = GENMASK(19, 0),
+		.regoff = 0x8U,
+	},
+	.swb_disable = {
+		.mask = GENMASK(19, 0),
+		.regoff = 0x38U,
+	},
 	.regoff = 0x35000U,
 	.event_lsb = 8,
 	.num_broadcasts = 0x14U,
@@ -861,12 +981,17 @@ int aie_device_init(struct aie_device *adev)
 	adev->ops = &aie_ops;
 	adev->num_kernel_regs = ARRAY_SIZE(aie_kernel_regs);
 	adev->kernel_regs = aie_kernel_regs;
+	adev->num_ctx_regs = ARRAY_SIZE(aie_ctx_regs);
+	adev->ctx_regs = aie_ctx_regs;
 	adev->col_rst = &aie_col_rst;
 	adev->col_clkbuf = &aie_col_clkbuf;
 	adev->shim_dma = &aie_shimdma;
 	adev->pl_events = &aie_pl_event;
 	adev->mem_events = &aie_mem_event;
 	adev->core_events = &aie_core_event;
+	adev->pl_perfcnt = &aie_pl_perfcnt;
+	adev->mem_perfcnt = &aie_mem_perfcnt;
+	adev->core_perfcnt = &aie_core_perfcnt;
 	adev->l1_ctrl = &aie_l1_intr_ctrl;
 	adev->l2_ctrl = &aie_l2_intr_ctrl;
 	adev->core_errors = &aie_core_error;
@@ -175,7 +175,9 @@ int aie_part_request_tiles_from_user(struct aie_partition *apart,
 		return ret;
 	}
 
+	down_write(&apart->clk_rwsem);
 	ret = aie_part_request_tiles(apart, args.num_tiles, locs);
+	up_write(&apart->clk_rwsem);
 	mutex_unlock(&apart->mlock);
 
 	kfree(locs);
@@ -236,7 +238,9 @@ int aie_part_release_tiles_from_user(struct aie_partition *apart,
 		return ret;
 	}
 
+	down_write(&apart->clk_rwsem);
 	ret = aie_part_release_tiles(apart, args.num_tiles, locs);
+	up_write(&apart->clk_rwsem);
 	mutex_unlock(&apart->mlock);
 
 	kfree(locs);
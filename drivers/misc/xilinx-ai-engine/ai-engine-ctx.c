@@ -0,0 +1,308 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Xilinx AI Engine device driver partition context save and restore
+ *
+ * Copyright (C) 2020 Xilinx, Inc.
+ */
+
+#include <linux/bitmap.h>
+#include <linux/idr.h>
+#include <linux/io.h>
+#include <linux/overflow.h>
+#include <linux/slab.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+
+#include "ai-engine-internal.h"
+
+/**
+ * struct aie_part_ctx - AI engine partition saved context
+ * @saved: bitmap of the tiles saved in the context, tiles which were clock
+ *	   gated at save time are not saved
+ * @size: size of the saved registers and memories in 32bit words
+ * @data: saved registers and memories, tile by tile and range by range
+ */
+struct aie_part_ctx {
+	unsigned long *saved;
+	u32 size;
+	u32 data[];
+};
+
+/**
+ * aie_part_ctx_tile_words() - get the number of context words of a tile
+ * @adev: AI engine device
+ * @ttype: tile type
+ * @return: number of 32bit words saved for a tile of type @ttype
+ */
+static u32 aie_part_ctx_tile_words(struct aie_device *adev, u32 ttype)
+{
+	u32 i, words = 0;
+
+	for (i = 0; i < adev->num_ctx_regs; i++) {
+		const struct aie_tile_regs *regs = &adev->ctx_regs[i];
+		u32 rttype;
+
+		rttype = (regs->attribute & AIE_REGS_ATTR_TILE_TYPE_MASK) >>
+			 AIE_REGS_ATTR_TILE_TYPE_SHIFT;
+		if (ttype & rttype)
+			words += (regs->eoff - regs->soff) / sizeof(u32) + 1;
+	}
+
+	return words;
+}
+
+/**
+ * aie_part_ctx_copy_tile() - copy the context of a tile
+ * @apart: AI engine partition
+ * @loc: absolute tile location
+ * @data: context data of the tile
+ * @save: true to save the tile to @data, false to restore it from @data
+ * @return: number of 32bit words copied
+ */
+static u32 aie_part_ctx_copy_tile(struct aie_partition *apart,
+				  struct aie_location loc, u32 *data,
+				  bool save)
+{
+	struct aie_device *adev = apart->adev;
+	u32 i, ttype, words = 0;
+
+	ttype = adev->ops->get_tile_type(&loc);
+	for (i = 0; i < adev->num_ctx_regs; i++) {
+		const struct aie_tile_regs *regs = &adev->ctx_regs[i];
+		void __iomem *va;
+		u32 rttype, count;
+
+		rttype = (regs->attribute & AIE_REGS_ATTR_TILE_TYPE_MASK) >>
+			 AIE_REGS_ATTR_TILE_TYPE_SHIFT;
+		if (!(ttype & rttype))
+			continue;
+
+		va = adev->base + aie_cal_regoff(adev, loc, regs->soff);
+		count = (regs->eoff - regs->soff) / sizeof(u32) + 1;
+		if (save)
+			__ioread32_copy(data + words, va, count);
+		else
+			__iowrite32_copy(va, data + words, count);
+		words += count;
+	}
+
+	return words;
+}
+
+/**
+ * aie_part_ctx_copy_tiles() - save or restore all the tiles of a context
+ * @apart: AI engine partition
+ * @ctx: partition context
+ * @save: true to save the tiles, false to restore the saved tiles
+ *
+ * The partition lock is expected to be held by the caller.
+ */
+static void aie_part_ctx_copy_tiles(struct aie_partition *apart,
+				    struct aie_part_ctx *ctx, bool save)
+{
+	struct aie_device *adev = apart->adev;
+	struct aie_location loc;
+	u32 tile = 0, off = 0;
+
+	for (loc.col = apart->range.start.col;
+	     loc.col < apart->range.start.col + apart->range.size.col;
+	     loc.col++) {
+		for (loc.row = apart->range.start.row;
+		     loc.row < apart->range.start.row + apart->range.size.row;
+		     loc.row++, tile++) {
+			u32 ttype = adev->ops->get_tile_type(&loc);
+
+			if (save) {
+				if (!aie_part_check_clk_enable_loc(apart,
+								   &loc)) {
+					off += aie_part_ctx_tile_words(adev,
+								       ttype);
+					continue;
+				}
+				set_bit(tile, ctx->saved);
+			} else if (!test_bit(tile, ctx->saved)) {
+				off += aie_part_ctx_tile_words(adev, ttype);
+				continue;
+			}
+
+			off += aie_part_ctx_copy_tile(apart, loc,
+						      ctx->data + off, save);
+		}
+	}
+}
+
+/**
+ * aie_part_ctx_free() - free an AI engine partition context
+ * @ctx: partition context
+ */
+static void aie_part_ctx_free(struct aie_part_ctx *ctx)
+{
+	bitmap_free(ctx->saved);
+	vfree(ctx);
+}
+
+/**
+ * aie_part_save_ctx() - save the context of an AI engine partition
+ * @apart: AI engine partition
+ * @user_args: user pointer to return the context ID
+ * @return: 0 for success, negative value for failure
+ *
+ * This function snapshots the memories and the configuration registers
+ * listed by the device context registers of all the clock enabled tiles of
+ * the partition into a kernel buffer, and returns an ID to restore it
+ * later. The application is expected to stop the cores and the DMAs before
+ * saving the context.
+ */
+int aie_part_save_ctx(struct aie_partition *apart, void __user *user_args)
+{
+	struct aie_device *adev = apart->adev;
+	struct aie_part_ctx *ctx;
+	struct aie_location loc;
+	u32 num_tiles, size = 0;
+	int ret, id;
+
+	num_tiles = apart->range.size.col * apart->range.size.row;
+	for (loc.col = apart->range.start.col;
+	     loc.col < apart->range.start.col + apart->range.size.col;
+	     loc.col++) {
+		for (loc.row = apart->range.start.row;
+		     loc.row < apart->range.start.row + apart->range.size.row;
+		     loc.row++) {
+			u32 ttype = adev->ops->get_tile_type(&loc);
+
+			size += aie_part_ctx_tile_words(adev, ttype);
+		}
+	}
+
+	ctx = vzalloc(struct_size(ctx, data, size));
+	if (!ctx)
+		return -ENOMEM;
+
+	ctx->saved = bitmap_zalloc(num_tiles, GFP_KERNEL);
+	if (!ctx->saved) {
+		vfree(ctx);
+		return -ENOMEM;
+	}
+	ctx->size = size;
+
+	ret = mutex_lock_interruptible(&apart->mlock);
+	if (ret) {
+		aie_part_ctx_free(ctx);
+		return ret;
+	}
+
+	aie_part_ctx_copy_tiles(apart, ctx, true);
+
+	id = idr_alloc(&apart->ctxs, ctx, 0, 0, GFP_KERNEL);
+	mutex_unlock(&apart->mlock);
+	if (id < 0) {
+		aie_part_ctx_free(ctx);
+		return id;
+	}
+
+	if (put_user(id, (u32 __user *)user_args)) {
+		mutex_lock(&apart->mlock);
+		idr_remove(&apart->ctxs, id);
+		mutex_unlock(&apart->mlock);
+		aie_part_ctx_free(ctx);
+		return -EFAULT;
+	}
+
+	return 0;
+}
+
+/**
+ * aie_part_restore_ctx() - restore a saved context of an AI engine partition
+ * @apart: AI engine partition
+ * @id: context ID returned when the context was saved
+ * @return: 0 for success, negative value for failure
+ *
+ * This function writes back the saved memories and configuration registers
+ * of a context. All the tiles saved in the context have to be clock enabled.
+ * The context is kept and can be restored again. The application restarts
+ * the DMAs and the cores after restoring the context.
+ */
+int aie_part_restore_ctx(struct aie_partition *apart, u32 id)
+{
+	struct aie_part_ctx *ctx;
+	struct aie_location loc;
+	u32 tile = 0;
+	int ret;
+
+	ret = mutex_lock_interruptible(&apart->mlock);
+	if (ret)
+		return ret;
+
+	ctx = idr_find(&apart->ctxs, id);
+	if (!ctx) {
+		dev_err(&apart->dev, "invalid context %u.\n", id);
+		ret = -EINVAL;
+		goto out;
+	}
+
+	for (loc.col = apart->range.start.col;
+	     loc.col < apart->range.start.col + apart->range.size.col;
+	     loc.col++) {
+		for (loc.row = apart->range.start.row;
+		     loc.row < apart->range.start.row + apart->range.size.row;
+		     loc.row++, tile++) {
+			if (test_bit(tile, ctx->saved) &&
+			    !aie_part_check_clk_enable_loc(apart, &loc)) {
+				dev_err(&apart->dev,
+					"failed to restore context, tile(%u,%u) is gated.\n",
+					loc.col, loc.row);
+				ret = -EINVAL;
+				goto out;
+			}
+		}
+	}
+
+	aie_part_ctx_copy_tiles(apart, ctx, false);
+
+out:
+	mutex_unlock(&apart->mlock);
+	return ret;
+}
+
+/**
+ * aie_part_free_ctx() - free a saved context of an AI engine partition
+ * @apart: AI engine partition
+ * @id: context ID returned when the context was saved
+ * @return: 0 for success, negative value for failure
+ */
+int aie_part_free_ctx(struct aie_partition *apart, u32 id)
+{
+	struct aie_part_ctx *ctx;
+	int ret;
+
+	ret = mutex_lock_interruptible(&apart->mlock);
+	if (ret)
+		return ret;
+
+	ctx = idr_remove(&apart->ctxs, id);
+	mutex_unlock(&apart->mlock);
+	if (!ctx) {
+		dev_err(&apart->dev, "invalid context %u.\n", id);
+		return -EINVAL;
+	}
+
+	aie_part_ctx_free(ctx);
+	return 0;
+}
+
+/**
+ * aie_part_release_ctxs() - free all the saved contexts of a partition
+ * @apart: AI engine partition
+ *
+ * This function is expected to be called with the partition lock held.
+ */
+void aie_part_release_ctxs(struct aie_partition *apart)
+{
+	struct aie_part_ctx *ctx;
+	int id;
+
+	idr_for_each_entry(&apart->ctxs, ctx, id) {
+		idr_remove(&apart->ctxs, id);
+		aie_part_ctx_free(ctx);
+	}
+}
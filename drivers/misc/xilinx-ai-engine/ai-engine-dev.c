@@ -7,6 +7,7 @@
 
 #include <linux/anon_inodes.h>
 #include <linux/cdev.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/device.h>
 #include <linux/dma-mapping.h>
@@ -28,11 +29,15 @@
 
 #include "ai-engine-internal.h"
 
+#define CREATE_TRACE_POINTS
+#include "ai-engine-trace.h"
+
 #define AIE_DEV_MAX			(MINORMASK + 1)
 #define VERSAL_SILICON_REV_MASK		GENMASK(31, 28)
 
 static dev_t aie_major;
 struct class *aie_class;
+struct dentry *aie_debugfs_root;
 
 static DEFINE_IDA(aie_device_ida);
 static DEFINE_IDA(aie_minor_ida);
@@ -172,11 +177,14 @@ static int aie_partition_get(struct aie_partition *apart,
 
 	(void)req;
 
+	trace_aie_part_request_start(apart);
+
 	if (apart->status & XAIE_PART_STATUS_INUSE) {
 		dev_err(&apart->dev,
 			"request partition %u failed, partition in use.\n",
 			apart->partition_id);
-		return -EBUSY;
+		ret = -EBUSY;
+		goto out;
 	}
 	/*
 	 * TODO:
@@ -188,7 +196,7 @@ static int aie_partition_get(struct aie_partition *apart,
 	/* scan to setup the initial clock state for tiles */
 	ret = aie_part_scan_clk_state(apart);
 	if (ret)
-		return ret;
+		goto out;
 
 	/* Get a file for the partition */
 	filep = anon_inode_getfile(dev_name(&apart->dev), &aie_part_fops,
@@ -197,7 +205,8 @@ static int aie_partition_get(struct aie_partition *apart,
 		dev_err(&apart->dev,
 			"Failed to request partition %u, failed to get file.\n",
 			apart->partition_id);
-		return PTR_ERR(filep);
+		ret = PTR_ERR(filep);
+		goto out;
 	}
 
 	filep->f_mode |= (FMODE_LSEEK | FMODE_PREAD | FMODE_PWRITE);
@@ -205,7 +214,9 @@ static int aie_partition_get(struct aie_partition *apart,
 
 	apart->status = XAIE_PART_STATUS_INUSE;
 	apart->cntrflag = req->flag;
-	return 0;
+out:
+	trace_aie_part_request_end(apart, ret);
+	return ret;
 }
 
 /**
@@ -729,6 +740,8 @@ static int __init xilinx_ai_engine_init(void)
 		return PTR_ERR(aie_class);
 	}
 
+	aie_debugfs_root = debugfs_create_dir("xilinx-aie", NULL);
+
 	platform_driver_register(&xilinx_ai_engine_driver);
 
 	return 0;
@@ -738,6 +751,7 @@ postcore_initcall(xilinx_ai_engine_init);
 static void __exit xilinx_ai_engine_exit(void)
 {
 	platform_driver_unregister(&xilinx_ai_engine_driver);
+	debugfs_remove_recursive(aie_debugfs_root);
 	class_destroy(aie_class);
 	unregister_chrdev_region(aie_major, AIE_DEV_MAX);
 }
@@ -6,6 +6,7 @@
  */
 
 #include "ai-engine-internal.h"
+#include "ai-engine-trace.h"
 #include <linux/dma-buf.h>
 #include <linux/kernel.h>
 #include <linux/mm.h>
@@ -13,19 +14,36 @@
 #include <linux/slab.h>
 #include <linux/types.h>
 #include <linux/uaccess.h>
+#include <linux/xarray.h>
 
 /**
  * struct aie_dmabuf - AI engine dmabuf information
  * @attach: dmabuf attachment pointer
  * @sgt: scatter/gather table
  * @refs: refcount of the attached aie_dmabuf
- * @node: list node
  */
 struct aie_dmabuf {
 	struct dma_buf_attachment *attach;
 	struct sg_table *sgt;
 	refcount_t refs;
+};
+
+/**
+ * struct aie_dma_ring - AI engine SHIM DMA buffer ring
+ * @node: list node
+ * @loc: SHIM tile location relative to the start of the partition
+ * @chan: DMA channel
+ * @bd_id: buffer descriptor ID of the first buffer
+ * @num_bufs: number of buffers
+ * @adbufs: attached dmabufs of the buffers
+ */
+struct aie_dma_ring {
 	struct list_head node;
+	struct aie_location loc;
+	u32 chan;
+	u32 bd_id;
+	u32 num_bufs;
+	struct aie_dmabuf *adbufs[];
 };
 
 /**
@@ -35,21 +53,13 @@ struct aie_dmabuf {
  * @return: pointer to AI engine dmabuf struct of the found dmabuf, if dmabuf
  *	    is not found, returns NULL.
  *
- * This function scans all the attached dmabufs to see the input dmabuf is
- * in the list. if it is attached, return the corresponding struct aie_dmabuf
- * pointer.
+ * This function looks up the input dmabuf in the attached dmabufs index. If
+ * it is attached, return the corresponding struct aie_dmabuf pointer.
  */
 static struct aie_dmabuf *
 aie_part_find_dmabuf(struct aie_partition *apart, struct dma_buf *dmabuf)
 {
-	struct aie_dmabuf *adbuf;
-
-	list_for_each_entry(adbuf, &apart->dbufs, node) {
-		if (dmabuf == adbuf->attach->dmabuf)
-			return adbuf;
-	}
-
-	return NULL;
+	return xa_load(&apart->dbufs, (unsigned long)dmabuf);
 }
 
 /**
@@ -59,9 +69,9 @@ aie_part_find_dmabuf(struct aie_partition *apart, struct dma_buf *dmabuf)
  * @return: pointer to AI engine dmabuf struct of the found dmabuf, if dmabuf
  *	    is not found, returns NULL.
  *
- * This function scans all the attached dmabufs of the AI engine partition,
- * it checks the file with the attached dmabufs, if it founds a match, it
- * returns the aie_dmabuf pointer.
+ * The private data of a dmabuf file is its dmabuf. This function looks it
+ * up in the attached dmabufs index of the AI engine partition, and checks
+ * the file of the found dmabuf to reject the files which are not dmabufs.
  */
 static struct aie_dmabuf *
 aie_part_find_dmabuf_from_file(struct aie_partition *apart,
@@ -69,12 +79,14 @@ aie_part_find_dmabuf_from_file(struct aie_partition *apart,
 {
 	struct aie_dmabuf *adbuf;
 
-	list_for_each_entry(adbuf, &apart->dbufs, node) {
-		if (file == adbuf->attach->dmabuf->file)
-			return adbuf;
-	}
+	if (!file)
+		return NULL;
 
-	return NULL;
+	adbuf = xa_load(&apart->dbufs, (unsigned long)file->private_data);
+	if (adbuf && file != adbuf->attach->dmabuf->file)
+		return NULL;
+
+	return adbuf;
 }
 
 /**
@@ -194,6 +206,9 @@ static int aie_part_set_shimdma_bd(struct aie_partition *apart,
 	struct aie_location loc_adjust;
 	u32 i, regoff, intile_regoff;
 
+	trace_aie_part_set_shimdma_bd(apart, loc, bd_id);
+	atomic64_inc(&apart->stats.bd_submissions);
+
 	intile_regoff = shim_dma->bd_regoff + shim_dma->bd_len * bd_id;
 	loc_adjust.col = loc.col + apart->range.start.col;
 	loc_adjust.row = loc.row + apart->range.start.row;
@@ -205,6 +220,34 @@ static int aie_part_set_shimdma_bd(struct aie_partition *apart,
 	return 0;
 }
 
+/**
+ * aie_dma_bd_set_field() - Set a field of a buffer descriptor
+ * @field: buffer descriptor field attributes
+ * @bd: pointer buffer descriptor content
+ * @val: value of the field
+ */
+static void aie_dma_bd_set_field(const struct aie_single_reg_field *field,
+				 u32 *bd, u32 val)
+{
+	u32 *tmpbd = (u32 *)((char *)bd + field->regoff);
+
+	*tmpbd &= ~field->mask;
+	*tmpbd |= aie_get_field_val(field, val);
+}
+
+/**
+ * aie_dma_bd_set_addr() - Set the address of a buffer descriptor
+ * @shim_dma: SHIM DMA attributes
+ * @bd: pointer buffer descriptor content
+ * @addr: DMA address of the buffer
+ */
+static void aie_dma_bd_set_addr(const struct aie_dma_attr *shim_dma, u32 *bd,
+				dma_addr_t addr)
+{
+	aie_dma_bd_set_field(&shim_dma->laddr, bd, lower_32_bits(addr));
+	aie_dma_bd_set_field(&shim_dma->haddr, bd, upper_32_bits(addr));
+}
+
 /**
  * aie_part_validate_bdloc() - Validate SHIM DMA buffer descriptor location
  * @apart: AI engine partition
@@ -265,6 +308,7 @@ static struct aie_dmabuf *aie_part_attach_dmabuf(struct aie_partition *apart,
 	struct aie_dmabuf *adbuf;
 	struct dma_buf_attachment *attach;
 	struct sg_table *sgt;
+	int ret;
 
 	attach = dma_buf_attach(dbuf, &apart->dev);
 	if (IS_ERR(attach)) {
@@ -314,7 +358,15 @@ static struct aie_dmabuf *aie_part_attach_dmabuf(struct aie_partition *apart,
 
 	refcount_set(&adbuf->refs, 1);
 
-	list_add(&adbuf->node, &apart->dbufs);
+	ret = xa_err(xa_store(&apart->dbufs, (unsigned long)dbuf, adbuf,
+			      GFP_KERNEL));
+	if (ret) {
+		devm_kfree(&apart->dev, adbuf);
+		dma_buf_unmap_attachment(attach, sgt, attach->dir);
+		dma_buf_detach(dbuf, attach);
+		return ERR_PTR(ret);
+	}
+
 	return adbuf;
 }
 
@@ -331,12 +383,14 @@ static void aie_part_dmabuf_attach_get(struct aie_dmabuf *adbuf)
 
 /**
  * aie_part_dmabuf_attach_put() - Put reference to an dmabuf attachment
+ * @apart: AI engine partition
  * @adbuf: AI engine partition attached dmabuf
  *
  * This call will decrease the reference count by 1. If the refcount reaches
  * 0, it will detach the dmabuf.
  */
-static void aie_part_dmabuf_attach_put(struct aie_dmabuf *adbuf)
+static void aie_part_dmabuf_attach_put(struct aie_partition *apart,
+				       struct aie_dmabuf *adbuf)
 {
 	struct dma_buf *dbuf;
 
@@ -347,7 +401,8 @@ static void aie_part_dmabuf_attach_put(struct aie_dmabuf *adbuf)
 	dma_buf_unmap_attachment(adbuf->attach, adbuf->sgt, adbuf->attach->dir);
 	dma_buf_detach(dbuf, adbuf->attach);
 	dma_buf_put(dbuf);
-	list_del(&adbuf->node);
+	xa_erase(&apart->dbufs, (unsigned long)dbuf);
+	devm_kfree(&apart->dev, adbuf);
 }
 
 /**
@@ -356,16 +411,17 @@ static void aie_part_dmabuf_attach_put(struct aie_dmabuf *adbuf)
  */
 void aie_part_release_dmabufs(struct aie_partition *apart)
 {
-	struct aie_dmabuf *adbuf, *tmpadbuf;
+	struct aie_dmabuf *adbuf;
+	unsigned long index;
 
-	list_for_each_entry_safe(adbuf, tmpadbuf, &apart->dbufs, node) {
+	xa_for_each(&apart->dbufs, index, adbuf) {
 		struct dma_buf *dbuf = adbuf->attach->dmabuf;
 
 		dma_buf_unmap_attachment(adbuf->attach, adbuf->sgt,
 					 adbuf->attach->dir);
 		dma_buf_detach(dbuf, adbuf->attach);
 		dma_buf_put(dbuf);
-		list_del(&adbuf->node);
+		xa_erase(&apart->dbufs, index);
 		devm_kfree(&apart->dev, adbuf);
 	}
 }
@@ -463,7 +519,7 @@ long aie_part_detach_dmabuf_req(struct aie_partition *apart,
 		return -EINVAL;
 	}
 
-	aie_part_dmabuf_attach_put(adbuf);
+	aie_part_dmabuf_attach_put(apart, adbuf);
 
 	mutex_unlock(&apart->mlock);
 
@@ -485,7 +541,7 @@ long aie_part_set_bd(struct aie_partition *apart, void __user *user_args)
 	struct aie_device *adev = apart->adev;
 	const struct aie_dma_attr *shim_dma = adev->shim_dma;
 	struct aie_dma_bd_args args;
-	u32 *bd, *tmpbd, buf_len, laddr, haddr, regval;
+	u32 *bd, buf_len, regval;
 	dma_addr_t addr;
 	int ret;
 
@@ -527,17 +583,7 @@ long aie_part_set_bd(struct aie_partition *apart, void __user *user_args)
 		return -EINVAL;
 	}
 
-	/* Set low 32bit address */
-	laddr = lower_32_bits(addr);
-	tmpbd = (u32 *)((char *)bd + shim_dma->laddr.regoff);
-	*tmpbd &= ~shim_dma->laddr.mask;
-	*tmpbd |= aie_get_field_val(&shim_dma->laddr, laddr);
-
-	/* Set high 32bit address */
-	haddr = upper_32_bits(addr);
-	tmpbd = (u32 *)((char *)bd + shim_dma->haddr.regoff);
-	*tmpbd &= ~shim_dma->haddr.mask;
-	*tmpbd |= aie_get_field_val(&shim_dma->haddr, haddr);
+	aie_dma_bd_set_addr(shim_dma, bd, addr);
 
 	ret = aie_part_set_shimdma_bd(apart, args.loc, args.bd_id, bd);
 	mutex_unlock(&apart->mlock);
@@ -615,17 +661,7 @@ long aie_part_set_dmabuf_bd(struct aie_partition *apart,
 		return -EINVAL;
 	}
 
-	/* Set low 32bit address */
-	laddr = lower_32_bits(addr);
-	tmpbd = (u32 *)((char *)bd + shim_dma->laddr.regoff);
-	*tmpbd &= ~shim_dma->laddr.mask;
-	*tmpbd |= aie_get_field_val(&shim_dma->laddr, laddr);
-
-	/* Set high 32bit address */
-	haddr = upper_32_bits(addr);
-	tmpbd = (u32 *)((char *)bd + shim_dma->haddr.regoff);
-	*tmpbd &= ~shim_dma->haddr.mask;
-	*tmpbd |= aie_get_field_val(&shim_dma->haddr, haddr);
+	aie_dma_bd_set_addr(shim_dma, bd, addr);
 
 	ret = aie_part_set_shimdma_bd(apart, args.loc, args.bd_id, bd);
 	mutex_unlock(&apart->mlock);
@@ -635,3 +671,261 @@ long aie_part_set_dmabuf_bd(struct aie_partition *apart,
 	kfree(bd);
 	return ret;
 }
+
+/**
+ * aie_dma_ring_free() - Free a SHIM DMA buffer ring
+ * @apart: AI engine partition
+ * @ring: SHIM DMA buffer ring
+ *
+ * This function drops the references to the ring dmabufs and frees the ring.
+ * It is expected to be called with the partition lock held.
+ */
+static void aie_dma_ring_free(struct aie_partition *apart,
+			      struct aie_dma_ring *ring)
+{
+	u32 i;
+
+	for (i = 0; i < ring->num_bufs; i++) {
+		if (ring->adbufs[i])
+			aie_part_dmabuf_attach_put(apart, ring->adbufs[i]);
+	}
+	kfree(ring);
+}
+
+/**
+ * aie_part_find_dma_ring() - Find the buffer ring of a SHIM DMA channel
+ * @apart: AI engine partition
+ * @loc: SHIM tile location relative to the start of the partition
+ * @chan: DMA channel
+ * @return: pointer to the ring, or NULL if the channel has no ring
+ */
+static struct aie_dma_ring *aie_part_find_dma_ring(struct aie_partition *apart,
+						   struct aie_location loc,
+						   u32 chan)
+{
+	struct aie_dma_ring *ring;
+
+	list_for_each_entry(ring, &apart->dma_rings, node) {
+		if (ring->loc.col == loc.col && ring->loc.row == loc.row &&
+		    ring->chan == chan)
+			return ring;
+	}
+
+	return NULL;
+}
+
+/**
+ * aie_part_start_dma_chan() - Start a SHIM DMA channel
+ * @apart: AI engine partition
+ * @loc: SHIM tile location relative to the start of the partition
+ * @chan: DMA channel
+ * @bd_id: buffer descriptor ID to start from
+ */
+static void aie_part_start_dma_chan(struct aie_partition *apart,
+				    struct aie_location loc, u32 chan,
+				    u32 bd_id)
+{
+	const struct aie_dma_attr *shim_dma = apart->adev->shim_dma;
+	struct aie_location loc_adjust;
+	u32 regoff, regval;
+
+	loc_adjust.col = loc.col + apart->range.start.col;
+	loc_adjust.row = loc.row + apart->range.start.row;
+
+	regoff = aie_cal_regoff(apart->adev, loc_adjust,
+				shim_dma->chan_ctrl.regoff +
+				shim_dma->chan_regoff * chan);
+	regval = ioread32(apart->adev->base + regoff);
+	regval |= shim_dma->chan_ctrl.mask;
+	iowrite32(regval, apart->adev->base + regoff);
+
+	regoff = aie_cal_regoff(apart->adev, loc_adjust,
+				shim_dma->start_queue.regoff +
+				shim_dma->chan_regoff * chan);
+	iowrite32(aie_get_field_val(&shim_dma->start_queue, bd_id),
+		  apart->adev->base + regoff);
+}
+
+/**
+ * aie_part_set_dmabuf_ring() - Set a ring of dmabuf buffers to an AI engine
+ *				SHIM DMA channel
+ * @apart: AI engine partition
+ * @user_args: user AI engine dmabuf ring argument
+ *
+ * @return: 0 for success, negative value for failure
+ *
+ * This function programs one SHIM DMA buffer descriptor per user buffer from
+ * the user buffer descriptor template, chains them in order and pushes the
+ * first one to the channel start queue. If the ring is cyclic, the last
+ * buffer descriptor is chained to the first one so that the hardware keeps
+ * rotating the buffers. The ring holds a reference to each dmabuf until it
+ * is replaced or released. If the number of buffers is 0, the ring of the
+ * channel is released.
+ */
+long aie_part_set_dmabuf_ring(struct aie_partition *apart,
+			      void __user *user_args)
+{
+	const struct aie_dma_attr *shim_dma = apart->adev->shim_dma;
+	struct aie_dmabuf_ring_buf *bufs = NULL;
+	struct aie_dmabuf_ring_args args;
+	struct aie_dma_ring *ring, *old;
+	u32 *bd = NULL, *tmpl = NULL;
+	long ret;
+	u32 i;
+
+	if (copy_from_user(&args, user_args, sizeof(args)))
+		return -EFAULT;
+
+	if (args.chan >= shim_dma->num_chans ||
+	    args.flags & ~AIE_DMA_RING_CYCLIC) {
+		dev_err(&apart->dev, "invalid SHIM DMA ring channel %u.\n",
+			args.chan);
+		return -EINVAL;
+	}
+
+	if (!args.num_bufs) {
+		ret = mutex_lock_interruptible(&apart->mlock);
+		if (ret)
+			return ret;
+
+		old = aie_part_find_dma_ring(apart, args.loc, args.chan);
+		if (old) {
+			list_del(&old->node);
+			aie_dma_ring_free(apart, old);
+		}
+		mutex_unlock(&apart->mlock);
+		return 0;
+	}
+
+	if (args.bd_id >= shim_dma->num_bds ||
+	    args.num_bufs > shim_dma->num_bds - args.bd_id) {
+		dev_err(&apart->dev,
+			"invalid SHIM DMA ring bds %u, %u.\n", args.bd_id,
+			args.num_bufs);
+		return -EINVAL;
+	}
+
+	ret = aie_part_validate_bdloc(apart, args.loc, args.bd_id);
+	if (ret) {
+		dev_err(&apart->dev, "invalid SHIM DMA BD reg address.\n");
+		return -EINVAL;
+	}
+
+	tmpl = memdup_user((void __user *)args.bd, shim_dma->bd_len);
+	if (IS_ERR(tmpl))
+		return PTR_ERR(tmpl);
+
+	bufs = memdup_user((void __user *)args.bufs,
+			   array_size(args.num_bufs, sizeof(*bufs)));
+	if (IS_ERR(bufs)) {
+		kfree(tmpl);
+		return PTR_ERR(bufs);
+	}
+
+	bd = kmalloc(shim_dma->bd_len, GFP_KERNEL);
+	ring = kzalloc(struct_size(ring, adbufs, args.num_bufs), GFP_KERNEL);
+	if (!bd || !ring) {
+		ret = -ENOMEM;
+		goto free_mem;
+	}
+
+	ring->loc = args.loc;
+	ring->chan = args.chan;
+	ring->bd_id = args.bd_id;
+	ring->num_bufs = args.num_bufs;
+
+	ret = mutex_lock_interruptible(&apart->mlock);
+	if (ret)
+		goto free_mem;
+
+	for (i = 0; i < args.num_bufs; i++) {
+		struct aie_dmabuf *adbuf;
+		struct dma_buf *dbuf;
+		dma_addr_t addr;
+		u32 next_bd = args.bd_id + i + 1;
+
+		if (!bufs[i].len) {
+			dev_err(&apart->dev, "no buf length for ring buf %u.\n",
+				i);
+			ret = -EINVAL;
+			goto put_ring;
+		}
+
+		addr = aie_part_get_dmabuf_da_from_off(apart, bufs[i].buf_fd,
+						       bufs[i].off,
+						       bufs[i].len);
+		if (!addr) {
+			ret = -EINVAL;
+			goto put_ring;
+		}
+
+		/* dmabuf is attached as the address has been found */
+		dbuf = dma_buf_get(bufs[i].buf_fd);
+		if (IS_ERR(dbuf)) {
+			ret = PTR_ERR(dbuf);
+			goto put_ring;
+		}
+		adbuf = aie_part_find_dmabuf(apart, dbuf);
+		dma_buf_put(dbuf);
+		aie_part_dmabuf_attach_get(adbuf);
+		ring->adbufs[i] = adbuf;
+
+		if (i == args.num_bufs - 1)
+			next_bd = args.bd_id;
+
+		memcpy(bd, tmpl, shim_dma->bd_len);
+		aie_dma_bd_set_addr(shim_dma, bd, addr);
+		aie_dma_bd_set_field(&shim_dma->buflen, bd, bufs[i].len);
+		aie_dma_bd_set_field(&shim_dma->lock_id, bd, bufs[i].lock_id);
+		aie_dma_bd_set_field(&shim_dma->next_bd, bd, next_bd);
+		aie_dma_bd_set_field(&shim_dma->use_next_bd, bd,
+				     i != args.num_bufs - 1 ||
+				     args.flags & AIE_DMA_RING_CYCLIC);
+		aie_dma_bd_set_field(&shim_dma->valid_bd, bd, 1);
+
+		aie_part_set_shimdma_bd(apart, args.loc, args.bd_id + i, bd);
+	}
+
+	old = aie_part_find_dma_ring(apart, args.loc, args.chan);
+	if (old) {
+		list_del(&old->node);
+		aie_dma_ring_free(apart, old);
+	}
+	list_add_tail(&ring->node, &apart->dma_rings);
+
+	aie_part_start_dma_chan(apart, args.loc, args.chan, args.bd_id);
+	mutex_unlock(&apart->mlock);
+
+	kfree(bd);
+	kfree(bufs);
+	kfree(tmpl);
+	return 0;
+
+put_ring:
+	aie_dma_ring_free(apart, ring);
+	ring = NULL;
+	mutex_unlock(&apart->mlock);
+free_mem:
+	kfree(ring);
+	kfree(bd);
+	kfree(bufs);
+	kfree(tmpl);
+	return ret;
+}
+
+/**
+ * aie_part_release_dma_rings() - release all the SHIM DMA buffer rings of a
+ *				  partition
+ * @apart: AI engine partition
+ *
+ * This function is expected to be called with the partition lock held.
+ */
+void aie_part_release_dma_rings(struct aie_partition *apart)
+{
+	struct aie_dma_ring *ring, *tmpring;
+
+	list_for_each_entry_safe(ring, tmpring, &apart->dma_rings, node) {
+		list_del(&ring->node);
+		aie_dma_ring_free(apart, ring);
+	}
+}
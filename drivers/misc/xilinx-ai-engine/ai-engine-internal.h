@@ -8,19 +8,24 @@
 #ifndef AIE_INTERNAL_H
 #define AIE_INTERNAL_H
 
+#include <linux/atomic.h>
 #include <linux/bitfield.h>
 #include <linux/bits.h>
 #include <linux/cdev.h>
 #include <linux/device.h>
 #include <linux/dma-buf.h>
+#include <linux/eventfd.h>
 #include <linux/file.h>
 #include <linux/fpga/fpga-bridge.h>
+#include <linux/idr.h>
 #include <linux/io.h>
 #include <linux/interrupt.h>
 #include <linux/list.h>
 #include <linux/mutex.h>
 #include <linux/of.h>
 #include <linux/of_device.h>
+#include <linux/rwsem.h>
+#include <linux/xarray.h>
 #include <uapi/linux/xlnx-ai-engine.h>
 
 /*
@@ -115,17 +120,38 @@ struct aie_part_mem {
  * @laddr: low address field attributes
  * @haddr: high address field attributes
  * @buflen: buffer length field attributes
+ * @next_bd: next buffer descriptor ID field attributes
+ * @use_next_bd: use next buffer descriptor field attributes
+ * @valid_bd: valid buffer descriptor field attributes
+ * @lock_id: lock ID field attributes
+ * @chan_ctrl: channel control register enable field attributes, the
+ *	       register offset is of channel 0
+ * @start_queue: channel start queue register BD ID field attributes, the
+ *		 register offset is of channel 0
+ * @chan_regoff: offset between the registers of two channels
  * @bd_regoff: SHIM DMA buffer descriptors register offset
  * @num_bds: number of buffer descriptors
  * @bd_len: length of a buffer descriptor in bytes
+ * @num_chans: number of DMA channels, S2MM channels first then MM2S channels
+ * @bd_done_event: PL module event of a finished buffer descriptor on
+ *		   channel 0, the other channels events follow
  */
 struct aie_dma_attr {
 	struct aie_single_reg_field laddr;
 	struct aie_single_reg_field haddr;
 	struct aie_single_reg_field buflen;
+	struct aie_single_reg_field next_bd;
+	struct aie_single_reg_field use_next_bd;
+	struct aie_single_reg_field valid_bd;
+	struct aie_single_reg_field lock_id;
+	struct aie_single_reg_field chan_ctrl;
+	struct aie_single_reg_field start_queue;
+	u32 chan_regoff;
 	u32 bd_regoff;
 	u32 num_bds;
 	u32 bd_len;
+	u32 num_chans;
+	u8 bd_done_event;
 };
 
 /**
@@ -199,6 +225,22 @@ struct aie_event_attr {
 	u32 num_events;
 };
 
+/**
+ * struct aie_perfcnt_attr - AI engine module performance counters attributes
+ * @ctrl_regoff: start and stop events control register offset, each
+ *		 register controls two counters
+ * @reset_regoff: reset events control register offset, each register
+ *		  controls four counters
+ * @cnt_regoff: first counter register offset
+ * @num_cnts: number of performance counters of the module
+ */
+struct aie_perfcnt_attr {
+	u32 ctrl_regoff;
+	u32 reset_regoff;
+	u32 cnt_regoff;
+	u32 num_cnts;
+};
+
 /**
  * struct aie_l1_intr_ctrl_attr - AI engine level 1 interrupt controller
  *				  attributes structure.
@@ -207,6 +249,10 @@ struct aie_event_attr {
  * @swb_status: switch A level 1 interrupt controller status attribute.
  * @swa_event: switch A level 1 interrupt controller event attribute.
  * @swb_event: switch A level 1 interrupt controller event attribute.
+ * @swa_enable: switch A level 1 interrupt controller enable attribute.
+ * @swb_enable: switch B level 1 interrupt controller enable attribute.
+ * @swa_disable: switch A level 1 interrupt controller disable attribute.
+ * @swb_disable: switch B level 1 interrupt controller disable attribute.
  * @regoff: base level 1 interrupt controller register offset.
  * @event_lsb: lsb of IRQ event within IRQ event switch register.
  * @num_broadcasts: total number of broadcast signals to level 1 interrupt
@@ -217,6 +263,10 @@ struct aie_l1_intr_ctrl_attr {
 	struct aie_single_reg_field swb_status;
 	struct aie_single_reg_field swa_event;
 	struct aie_single_reg_field swb_event;
+	struct aie_single_reg_field swa_enable;
+	struct aie_single_reg_field swb_enable;
+	struct aie_single_reg_field swa_disable;
+	struct aie_single_reg_field swb_disable;
 	u32 regoff;
 	u32 event_lsb;
 	u32 num_broadcasts;
@@ -295,6 +345,8 @@ struct aie_error_attr {
  * @res: memory resource of AI engine device
  * @eemi_ops: pointer to eemi ops structure
  * @kernel_regs: array of kernel only registers
+ * @ctx_regs: array of memories and registers ranges saved in a partition
+ *	      context
  * @ops: tile operations
  * @col_rst: column reset attribute
  * @col_clkbuf: column clock buffer attribute
@@ -302,6 +354,9 @@ struct aie_error_attr {
  * @pl_events: pl module event attribute
  * @mem_events: memory module event attribute
  * @core_events: core module event attribute
+ * @pl_perfcnt: pl module performance counters attribute
+ * @mem_perfcnt: memory module performance counters attribute
+ * @core_perfcnt: core module performance counters attribute
  * @l1_ctrl: level 1 interrupt controller attribute
  * @l2_ctrl: level 2 interrupt controller attribute
  * @core_errors: core module error attribute
@@ -314,6 +369,7 @@ struct aie_error_attr {
  * @cols_res: AI engine columns resources to indicate
  *	      while columns are occupied by partitions.
  * @num_kernel_regs: number of kernel only registers range
+ * @num_ctx_regs: number of partition context ranges
  * @irq: Linux IRQ number
  * @backtrack: workqueue to backtrack interrupt
  * @version: AI engine device version
@@ -328,6 +384,7 @@ struct aie_device {
 	struct resource *res;
 	const struct zynqmp_eemi_ops *eemi_ops;
 	const struct aie_tile_regs *kernel_regs;
+	const struct aie_tile_regs *ctx_regs;
 	const struct aie_tile_operations *ops;
 	const struct aie_single_reg_field *col_rst;
 	const struct aie_single_reg_field *col_clkbuf;
@@ -335,6 +392,9 @@ struct aie_device {
 	const struct aie_event_attr *pl_events;
 	const struct aie_event_attr *mem_events;
 	const struct aie_event_attr *core_events;
+	const struct aie_perfcnt_attr *pl_perfcnt;
+	const struct aie_perfcnt_attr *mem_perfcnt;
+	const struct aie_perfcnt_attr *core_perfcnt;
 	const struct aie_l1_intr_ctrl_attr *l1_ctrl;
 	const struct aie_l2_intr_ctrl_attr *l2_ctrl;
 	const struct aie_error_attr *core_errors;
@@ -346,6 +406,7 @@ struct aie_device {
 	u32 col_shift;
 	u32 row_shift;
 	u32 num_kernel_regs;
+	u32 num_ctx_regs;
 	int irq;
 	struct work_struct backtrack;
 	int version;
@@ -362,16 +423,54 @@ struct aie_part_bridge {
 	struct fpga_bridge *br;
 };
 
+/**
+ * struct aie_dma_eventfd - AI engine SHIM DMA completion eventfd
+ * @node: list node
+ * @loc: absolute location of the SHIM tile
+ * @chan: DMA channel
+ * @efd: eventfd signalled when a buffer descriptor of @chan finishes
+ */
+struct aie_dma_eventfd {
+	struct list_head node;
+	struct aie_location loc;
+	u32 chan;
+	struct eventfd_ctx *efd;
+};
+
+/**
+ * struct aie_part_stats - AI engine partition statistics
+ * @reg_writes: number of register writes
+ * @reg_write_bytes: number of bytes written to registers
+ * @bd_submissions: number of SHIM DMA buffer descriptors set
+ * @error_irqs: number of error interrupts seen on the SHIM tiles
+ * @errors: number of module errors found by backtracking
+ *
+ * The counters are cumulative since the partition was probed. They are read
+ * from the stats file of the partition in debugfs.
+ */
+struct aie_part_stats {
+	atomic64_t reg_writes;
+	atomic64_t reg_write_bytes;
+	atomic64_t bd_submissions;
+	atomic64_t error_irqs;
+	atomic64_t errors;
+};
+
 /**
  * struct aie_partition - AI engine partition structure
  * @node: list node
- * @dbufs: dmabufs list
+ * @dbufs: attached dmabufs indexed by their dmabuf pointers
+ * @dma_efds: SHIM DMA completion eventfds list
+ * @dma_rings: SHIM DMA buffer rings list
  * @adev: pointer to AI device instance
  * @filep: pointer to file for refcount on the users of the partition
  * @pmems: pointer to partition memories types
  * @br: AI engine FPGA bridge
  * @range: range of partition
  * @mlock: protection for AI engine partition operations
+ * @clk_rwsem: protection of the tiles clock state, held for reading by the
+ *	       register accesses, and for writing with @mlock held when the
+ *	       clock state changes
  * @dev: device for the AI engine partition
  * @cores_clk_state: bitmap to indicate the power state of core modules
  * @tiles_inuse: bitmap to indicate if a tile is in use
@@ -380,6 +479,12 @@ struct aie_part_bridge {
  * @mem_event_status: memory module event bitmap
  * @pl_event_status: pl module event bitmap
  * @l2_mask: level 2 interrupt controller mask bitmap
+ * @l2_status: level 2 interrupt controller pending status bitmap, the
+ *	       broadcast lines to backtrack
+ * @err_status: aggregated error counters page, which can be mmapped by user
+ * @ctxs: saved partition contexts
+ * @stats: partition statistics
+ * @debugfs: debugfs directory of the partition
  * @partition_id: partition id. Partition ID is the identifier
  *		  of the AI engine partition in the system.
  * @status: indicate if the partition is in use
@@ -392,13 +497,16 @@ struct aie_part_bridge {
  */
 struct aie_partition {
 	struct list_head node;
-	struct list_head dbufs;
+	struct xarray dbufs;
+	struct list_head dma_efds;
+	struct list_head dma_rings;
 	struct aie_part_bridge br;
 	struct aie_device *adev;
 	struct file *filep;
 	struct aie_part_mem *pmems;
 	struct aie_range range;
 	struct mutex mlock; /* protection for AI engine partition operations */
+	struct rw_semaphore clk_rwsem;
 	struct device dev;
 	struct aie_resource cores_clk_state;
 	struct aie_resource tiles_inuse;
@@ -407,6 +515,11 @@ struct aie_partition {
 	struct aie_resource mem_event_status;
 	struct aie_resource pl_event_status;
 	struct aie_resource l2_mask;
+	struct aie_resource l2_status;
+	struct aie_error_status *err_status;
+	struct idr ctxs;
+	struct aie_part_stats stats;
+	struct dentry *debugfs;
 	u32 partition_id;
 	u32 status;
 	u32 cntrflag;
@@ -414,6 +527,7 @@ struct aie_partition {
 };
 
 extern struct class *aie_class;
+extern struct dentry *aie_debugfs_root;
 extern const struct file_operations aie_part_fops;
 
 #define cdev_to_aiedev(i_cdev) container_of((i_cdev), struct aie_device, cdev)
@@ -548,6 +662,9 @@ long aie_part_set_bd(struct aie_partition *apart, void __user *user_args);
 long aie_part_set_dmabuf_bd(struct aie_partition *apart,
 			    void __user *user_args);
 void aie_part_release_dmabufs(struct aie_partition *apart);
+long aie_part_set_dmabuf_ring(struct aie_partition *apart,
+			      void __user *user_args);
+void aie_part_release_dma_rings(struct aie_partition *apart);
 
 int aie_part_scan_clk_state(struct aie_partition *apart);
 bool aie_part_check_clk_enable_loc(struct aie_partition *apart,
@@ -561,10 +678,23 @@ int aie_device_init(struct aie_device *adev);
 void aie_array_backtrack(struct work_struct *work);
 irqreturn_t aie_interrupt(int irq, void *data);
 void aie_part_clear_cached_events(struct aie_partition *apart);
+long aie_part_set_dma_eventfd(struct aie_partition *apart,
+			      void __user *user_args);
+void aie_part_release_dma_eventfds(struct aie_partition *apart);
 
 bool aie_part_has_mem_mmapped(struct aie_partition *apart);
 bool aie_part_has_regs_mmapped(struct aie_partition *apart);
 
 int aie_part_reset(struct aie_partition *apart);
+
+long aie_part_set_perfcnt(struct aie_partition *apart,
+			  void __user *user_args);
+long aie_part_get_perfcnts(struct aie_partition *apart,
+			   void __user *user_args);
+
+int aie_part_save_ctx(struct aie_partition *apart, void __user *user_args);
+int aie_part_restore_ctx(struct aie_partition *apart, u32 id);
+int aie_part_free_ctx(struct aie_partition *apart, u32 id);
+void aie_part_release_ctxs(struct aie_partition *apart);
 int aie_part_post_reinit(struct aie_partition *apart);
 #endif /* AIE_INTERNAL_H */
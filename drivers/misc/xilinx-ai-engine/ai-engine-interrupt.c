@@ -9,13 +9,20 @@
 #include <linux/interrupt.h>
 #include <linux/io.h>
 #include <linux/slab.h>
+#include <linux/uaccess.h>
 #include <linux/workqueue.h>
 
 #include "ai-engine-internal.h"
+#include "ai-engine-trace.h"
 #include "linux/xlnx-ai-engine.h"
 
 #define AIE_ARRAY_TILE_ERROR_BC_ID		0U
+/* Level 1 status bit of the first IRQ event */
+#define AIE_L1_IRQ_ID_BASE			16U
 #define AIE_SHIM_TILE_ERROR_IRQ_ID		16U
+/* SHIM DMA channels use IRQ events 1 and 2 of each switch */
+#define AIE_SHIM_TILE_DMA_IRQ_ID		17U
+#define AIE_SHIM_TILE_DMA_IRQS_PER_SW		2U
 
 /**
  * aie_get_broadcast_event() - get event ID being broadcast on given
@@ -227,6 +234,7 @@ static u8 aie_get_l1_event(struct aie_partition *apart,
 		l1mask = intr_ctrl->swb_event.mask;
 	}
 
+	irq_id -= AIE_L1_IRQ_ID_BASE;
 	regoff = aie_cal_regoff(apart->adev, *loc, l1off);
 	reg_value = ioread32(apart->adev->base + regoff);
 	reg_value &= l1mask << (irq_id * intr_ctrl->event_lsb);
@@ -234,6 +242,66 @@ static u8 aie_get_l1_event(struct aie_partition *apart,
 	return reg_value;
 }
 
+/**
+ * aie_set_l1_event() - set event ID to be broadcast on level 1 IRQ.
+ * @apart: AIE partition pointer.
+ * @loc: pointer to tile location.
+ * @sw: switch type.
+ * @irq_id: IRQ event ID to be set.
+ * @event: event ID.
+ */
+static void aie_set_l1_event(struct aie_partition *apart,
+			     struct aie_location *loc,
+			     enum aie_shim_switch_type sw, u8 irq_id, u8 event)
+{
+	const struct aie_l1_intr_ctrl_attr *intr_ctrl = apart->adev->l1_ctrl;
+	u32 l1off, l1mask, regoff, reg_value, shift;
+
+	if (sw == AIE_SHIM_SWITCH_A) {
+		l1off = intr_ctrl->regoff + intr_ctrl->swa_event.regoff;
+		l1mask = intr_ctrl->swa_event.mask;
+	} else {
+		l1off = intr_ctrl->regoff + intr_ctrl->swb_event.regoff;
+		l1mask = intr_ctrl->swb_event.mask;
+	}
+
+	shift = (irq_id - AIE_L1_IRQ_ID_BASE) * intr_ctrl->event_lsb;
+	regoff = aie_cal_regoff(apart->adev, *loc, l1off);
+	reg_value = ioread32(apart->adev->base + regoff);
+	reg_value &= ~(l1mask << shift);
+	reg_value |= (event & l1mask) << shift;
+	iowrite32(reg_value, apart->adev->base + regoff);
+}
+
+/**
+ * aie_enable_l1_intr() - enable level 1 interrupt controller IRQ.
+ * @apart: AIE partition pointer.
+ * @loc: pointer to tile location.
+ * @sw: switch type.
+ * @irq_id: IRQ ID to be enabled.
+ * @enable: true to enable, false to disable the IRQ.
+ */
+static void aie_enable_l1_intr(struct aie_partition *apart,
+			       struct aie_location *loc,
+			       enum aie_shim_switch_type sw, u8 irq_id,
+			       bool enable)
+{
+	const struct aie_l1_intr_ctrl_attr *intr_ctrl = apart->adev->l1_ctrl;
+	const struct aie_single_reg_field *field;
+	u32 regoff;
+
+	if (sw == AIE_SHIM_SWITCH_A)
+		field = enable ? &intr_ctrl->swa_enable :
+				 &intr_ctrl->swa_disable;
+	else
+		field = enable ? &intr_ctrl->swb_enable :
+				 &intr_ctrl->swb_disable;
+
+	regoff = aie_cal_regoff(apart->adev, *loc,
+				intr_ctrl->regoff + field->regoff);
+	iowrite32(BIT(irq_id) & field->mask, apart->adev->base + regoff);
+}
+
 /**
  * aie_clear_l1_intr() - clear level 1 interrupt controller status.
  * @apart: AIE partition pointer.
@@ -435,6 +503,30 @@ static bool aie_check_error_bitmap(struct aie_partition *apart,
 	return aie_resource_testbit(event_sts, offset);
 }
 
+/**
+ * aie_part_count_error() - count an asserted error in the partition error
+ *			    status.
+ * @apart: AIE partition pointer.
+ * @module: module type.
+ */
+static void aie_part_count_error(struct aie_partition *apart,
+				 enum aie_module_type module)
+{
+	struct aie_error_status *err_status = apart->err_status;
+
+	atomic64_inc(&apart->stats.errors);
+
+	if (module == AIE_CORE_MOD)
+		WRITE_ONCE(err_status->num_core_errors,
+			   err_status->num_core_errors + 1);
+	else if (module == AIE_MEM_MOD)
+		WRITE_ONCE(err_status->num_mem_errors,
+			   err_status->num_mem_errors + 1);
+	else
+		WRITE_ONCE(err_status->num_shim_errors,
+			   err_status->num_shim_errors + 1);
+}
+
 /**
  * aie_tile_backtrack() - if error was asserted on a broadcast line in
  *			  the given array tile,
@@ -474,6 +566,7 @@ static bool aie_tile_backtrack(struct aie_partition *apart,
 			continue;
 		grenabled &= ~BIT(n);
 		aie_part_set_event_bitmap(apart, loc, module, eevent);
+		aie_part_count_error(apart, module);
 		ret = true;
 		dev_err_ratelimited(&apart->adev->dev,
 				    "Asserted tile error event %d at col %d row %d\n",
@@ -514,6 +607,56 @@ static void aie_map_l2_to_l1(struct aie_partition *apart, u32 set_pos,
 	}
 }
 
+/**
+ * aie_dma_chan_to_l1() - get the level 1 IRQ of a SHIM DMA channel.
+ * @chan: SHIM DMA channel.
+ * @sw: pointer to return the level 1 interrupt controller switch ID.
+ * @irq_id: pointer to return the level 1 IRQ ID.
+ *
+ * S2MM channels use the IRQ events of switch A and MM2S channels use the IRQ
+ * events of switch B, after the IRQ event of the shim tile errors.
+ */
+static void aie_dma_chan_to_l1(u32 chan, enum aie_shim_switch_type *sw,
+			       u8 *irq_id)
+{
+	if (chan < AIE_SHIM_TILE_DMA_IRQS_PER_SW)
+		*sw = AIE_SHIM_SWITCH_A;
+	else
+		*sw = AIE_SHIM_SWITCH_B;
+	*irq_id = AIE_SHIM_TILE_DMA_IRQ_ID +
+		  chan % AIE_SHIM_TILE_DMA_IRQS_PER_SW;
+}
+
+/**
+ * aie_part_notify_dma() - signal the SHIM DMA completion eventfds of a level
+ *			   1 interrupt controller.
+ * @apart: AIE partition pointer.
+ * @loc: tile location of level 1 interrupt controller.
+ * @sw: switch type.
+ * @status: level 1 interrupt controller status.
+ */
+static void aie_part_notify_dma(struct aie_partition *apart,
+				struct aie_location *loc,
+				enum aie_shim_switch_type sw,
+				unsigned long status)
+{
+	struct aie_dma_eventfd *dmaefd;
+	enum aie_shim_switch_type esw;
+	u8 irq_id;
+
+	list_for_each_entry(dmaefd, &apart->dma_efds, node) {
+		if (dmaefd->loc.col != loc->col)
+			continue;
+
+		aie_dma_chan_to_l1(dmaefd->chan, &esw, &irq_id);
+		if (esw != sw || !(status & BIT(irq_id)))
+			continue;
+
+		aie_clear_l1_intr(apart, loc, sw, irq_id);
+		eventfd_signal(dmaefd->efd, 1);
+	}
+}
+
 /**
  * aie_l1_backtrack() - backtrack AIE array tiles or shim tile based on
  *			the level 2 status bit set.
@@ -584,6 +727,10 @@ static bool aie_l1_backtrack(struct aie_partition *apart,
 				       AIE_SHIM_TILE_ERROR_IRQ_ID))
 			ret = true;
 	}
+
+	if (!list_empty(&apart->dma_efds))
+		aie_part_notify_dma(apart, &l1_ctrl, sw, status);
+
 	return ret;
 }
 
@@ -595,8 +742,10 @@ static bool aie_l1_backtrack(struct aie_partition *apart,
  */
 static void aie_l2_backtrack(struct aie_partition *apart)
 {
-	struct aie_location loc;
-	unsigned long l2_mask = 0;
+	struct aie_error_status *err_status = apart->err_status;
+	struct aie_location loc, l1_ctrl;
+	enum aie_shim_switch_type sw;
+	unsigned long l2_mask = 0, l2_pending = 0;
 	u32 n, ttype, l2_bitmap_offset = 0;
 	int ret;
 	bool sched_work = false;
@@ -615,38 +764,59 @@ static void aie_l2_backtrack(struct aie_partition *apart)
 		if (ttype != AIE_TILE_TYPE_SHIMNOC)
 			continue;
 
+		/*
+		 * Only the level 2 controllers which raised the interrupt are
+		 * disabled by the interrupt handler, visit their pending
+		 * broadcast lines only.
+		 */
+		aie_resource_cpy_to_arr32(&apart->l2_status, l2_bitmap_offset *
+					  32, (u32 *)&l2_pending, 32);
+		if (!l2_pending) {
+			l2_bitmap_offset++;
+			continue;
+		}
+		aie_resource_clear(&apart->l2_status, l2_bitmap_offset * 32,
+				   32);
 		aie_resource_cpy_to_arr32(&apart->l2_mask, l2_bitmap_offset *
 					  32, (u32 *)&l2_mask, 32);
-		l2_bitmap_offset++;
+		l2_pending &= l2_mask;
 
-		for_each_set_bit(n, &l2_mask,
+		for_each_set_bit(n, &l2_pending,
 				 apart->adev->l2_ctrl->num_broadcasts) {
 			if (aie_l1_backtrack(apart, loc, n))
 				apart->error_to_report = 1;
 		}
 
 		aie_enable_l2_ctrl(apart, &loc, l2_mask);
-	}
 
-	/*
-	 * Level 2 interrupt registers are edge-triggered. As a result,
-	 * re-enabling level 2 won't trigger an interrupt for the already
-	 * latched interrupts at level 1 controller.
-	 */
-	for (loc.col = apart->range.start.col, loc.row = 0;
-	     loc.col < apart->range.start.col + apart->range.size.col;
-	     loc.col++) {
-		if (aie_get_l1_status(apart, &loc, AIE_SHIM_SWITCH_A) ||
-		    aie_get_l1_status(apart, &loc, AIE_SHIM_SWITCH_B)) {
-			mutex_unlock(&apart->mlock);
-			sched_work = true;
-			schedule_work(&apart->adev->backtrack);
-			break;
+		/*
+		 * Level 2 interrupt registers are edge-triggered. As a result,
+		 * re-enabling level 2 won't trigger an interrupt for the
+		 * already latched interrupts at level 1 controller. Keep
+		 * those broadcast lines pending for the next backtracking.
+		 */
+		l1_ctrl.row = 0;
+		for_each_set_bit(n, &l2_pending,
+				 apart->adev->l2_ctrl->num_broadcasts) {
+			aie_map_l2_to_l1(apart, n, loc.col, &l1_ctrl.col, &sw);
+			if (aie_get_l1_status(apart, &l1_ctrl, sw)) {
+				aie_resource_set(&apart->l2_status,
+						 l2_bitmap_offset * 32 + n, 1);
+				sched_work = true;
+			}
 		}
+		l2_bitmap_offset++;
 	}
 
-	if (!sched_work)
-		mutex_unlock(&apart->mlock);
+	WRITE_ONCE(err_status->num_backtracks, err_status->num_backtracks + 1);
+	/* Counters are visible to the user before the sequence number */
+	smp_wmb();
+	WRITE_ONCE(err_status->seqno, err_status->seqno + 1);
+
+	mutex_unlock(&apart->mlock);
+
+	if (sched_work)
+		schedule_work(&apart->adev->backtrack);
 
 	/*
 	 * If error was asserted or there are errors pending to be reported to
@@ -758,15 +928,29 @@ irqreturn_t aie_interrupt(int irq, void *data)
 							    32, &l2_mask, 32);
 				aie_disable_l2_ctrl(apart, &loc, l2_mask);
 			}
-			l2_bitmap_offset++;
 
 			l2_status = aie_get_l2_status(apart, &loc);
 			if (l2_status) {
+				u32 l2_pending;
+
+				trace_aie_part_error_irq(apart, loc.col,
+							 l2_status);
+				atomic64_inc(&apart->stats.error_irqs);
+
 				aie_clear_l2_intr(apart, &loc, l2_status);
+				aie_resource_cpy_to_arr32(&apart->l2_status,
+							  l2_bitmap_offset *
+							  32, &l2_pending, 32);
+				l2_pending |= l2_status;
+				aie_resource_cpy_from_arr32(&apart->l2_status,
+							    l2_bitmap_offset *
+							    32, &l2_pending,
+							    32);
 				sched_work = true;
 			} else {
 				aie_enable_l2_ctrl(apart, &loc, l2_mask);
 			}
+			l2_bitmap_offset++;
 		}
 		mutex_unlock(&apart->mlock);
 	}
@@ -1213,3 +1397,127 @@ void aie_free_errors(struct aie_errors *aie_errs)
 	kfree(aie_errs);
 }
 EXPORT_SYMBOL_GPL(aie_free_errors);
+
+/**
+ * aie_part_set_dma_eventfd() - set the completion eventfd of a SHIM DMA
+ *				channel.
+ * @apart: AIE partition pointer.
+ * @user_args: user AI engine SHIM DMA eventfd arguments.
+ * @return: 0 for success, negative value for failure.
+ *
+ * This function routes the finished buffer descriptor event of the channel
+ * to a level 1 IRQ of the SHIM tile, and signals the eventfd from the
+ * interrupt backtracking when the IRQ is raised. A negative file descriptor
+ * disables the IRQ and drops the eventfd.
+ */
+long aie_part_set_dma_eventfd(struct aie_partition *apart,
+			      void __user *user_args)
+{
+	const struct aie_dma_attr *shim_dma = apart->adev->shim_dma;
+	struct aie_dma_eventfd *dmaefd, *found = NULL;
+	struct aie_dma_eventfd_args args;
+	struct eventfd_ctx *efd = NULL;
+	enum aie_shim_switch_type sw;
+	struct aie_location loc;
+	u8 irq_id;
+	int ret;
+
+	if (copy_from_user(&args, user_args, sizeof(args)))
+		return -EFAULT;
+
+	if (args.chan >= shim_dma->num_chans) {
+		dev_err(&apart->dev, "Invalid SHIM DMA channel %u.\n",
+			args.chan);
+		return -EINVAL;
+	}
+
+	loc.col = args.loc.col + apart->range.start.col;
+	loc.row = args.loc.row + apart->range.start.row;
+	if (aie_validate_location(apart, loc) ||
+	    apart->adev->ops->get_tile_type(&loc) != AIE_TILE_TYPE_SHIMNOC) {
+		dev_err(&apart->dev, "Invalid SHIM DMA tile (%u,%u).\n",
+			args.loc.col, args.loc.row);
+		return -EINVAL;
+	}
+
+	if (args.fd >= 0) {
+		efd = eventfd_ctx_fdget(args.fd);
+		if (IS_ERR(efd))
+			return PTR_ERR(efd);
+	}
+
+	ret = mutex_lock_interruptible(&apart->mlock);
+	if (ret) {
+		if (efd)
+			eventfd_ctx_put(efd);
+		return ret;
+	}
+
+	list_for_each_entry(dmaefd, &apart->dma_efds, node) {
+		if (dmaefd->loc.col == loc.col && dmaefd->chan == args.chan) {
+			found = dmaefd;
+			break;
+		}
+	}
+
+	aie_dma_chan_to_l1(args.chan, &sw, &irq_id);
+	if (!efd) {
+		if (found) {
+			aie_enable_l1_intr(apart, &loc, sw, irq_id, false);
+			aie_clear_l1_intr(apart, &loc, sw, irq_id);
+			list_del(&found->node);
+			eventfd_ctx_put(found->efd);
+			kfree(found);
+		}
+		goto out_unlock;
+	}
+
+	if (found) {
+		eventfd_ctx_put(found->efd);
+		found->efd = efd;
+		goto out_unlock;
+	}
+
+	found = kzalloc(sizeof(*found), GFP_KERNEL);
+	if (!found) {
+		eventfd_ctx_put(efd);
+		ret = -ENOMEM;
+		goto out_unlock;
+	}
+
+	found->loc = loc;
+	found->chan = args.chan;
+	found->efd = efd;
+	list_add_tail(&found->node, &apart->dma_efds);
+
+	aie_set_l1_event(apart, &loc, sw, irq_id,
+			 shim_dma->bd_done_event + args.chan);
+	aie_enable_l1_intr(apart, &loc, sw, irq_id, true);
+
+out_unlock:
+	mutex_unlock(&apart->mlock);
+	return ret;
+}
+
+/**
+ * aie_part_release_dma_eventfds() - release all the SHIM DMA completion
+ *				     eventfds of a partition.
+ * @apart: AIE partition pointer.
+ *
+ * This function is expected to be called with the partition lock held.
+ */
+void aie_part_release_dma_eventfds(struct aie_partition *apart)
+{
+	struct aie_dma_eventfd *dmaefd, *next;
+	enum aie_shim_switch_type sw;
+	u8 irq_id;
+
+	list_for_each_entry_safe(dmaefd, next, &apart->dma_efds, node) {
+		aie_dma_chan_to_l1(dmaefd->chan, &sw, &irq_id);
+		aie_enable_l1_intr(apart, &dmaefd->loc, sw, irq_id, false);
+		aie_clear_l1_intr(apart, &dmaefd->loc, sw, irq_id);
+		list_del(&dmaefd->node);
+		eventfd_ctx_put(dmaefd->efd);
+		kfree(dmaefd);
+	}
+}
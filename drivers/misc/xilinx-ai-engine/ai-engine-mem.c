@@ -71,7 +71,12 @@ static int aie_mem_mmap(struct dma_buf *dmabuf, struct vm_area_struct *vma)
 	if (remainder + offset > pmem->size)
 		return -EINVAL;
 
-	vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
+	/*
+	 * Tile memories are plain memories, map them write combined so that
+	 * the user stores are merged into bursts instead of being issued one
+	 * by one as device accesses.
+	 */
+	vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
 	for (loc.col = mem->range.start.col;
 	     loc.col < mem->range.start.col + mem->range.size.col; loc.col++) {
 		for (loc.row = mem->range.start.row;
@@ -85,7 +90,7 @@ static int aie_mem_mmap(struct dma_buf *dmabuf, struct vm_area_struct *vma)
 			if (!remainder)
 				return 0;
 
-			if (moffset + msize < offset) {
+			if (moffset + msize <= offset) {
 				moffset += msize;
 				continue;
 			}
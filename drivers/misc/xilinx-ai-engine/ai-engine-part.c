@@ -6,10 +6,14 @@
  */
 
 #include <linux/cdev.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/device.h>
 #include <linux/dma-mapping.h>
+#include <linux/firmware/xlnx-zynqmp.h>
 #include <linux/fs.h>
+#include <linux/io_uring.h>
+#include <linux/iopoll.h>
 #include <linux/kernel.h>
 #include <linux/list.h>
 #include <linux/mm.h>
@@ -18,12 +22,40 @@
 #include <linux/mutex.h>
 #include <linux/of.h>
 #include <linux/of_device.h>
+#include <linux/seq_file.h>
+#include <linux/sizes.h>
 #include <linux/slab.h>
 #include <linux/uaccess.h>
 #include <linux/uio.h>
 #include <uapi/linux/xlnx-ai-engine.h>
 
 #include "ai-engine-internal.h"
+#include "ai-engine-trace.h"
+
+/* Default timeout of an AIE_REG_POLL register operation */
+#define AIE_REG_POLL_TIMEOUT_US		1000U
+/* Number of user register operations copied in at a time */
+#define AIE_REG_CMDBUF_CHUNK		128U
+
+/* PDI source type of a PDI in DDR for the platform management firmware */
+#define AIE_PDI_SRC_DDR			0xFU
+/* Largest PDI accepted by AIE_LOAD_PDI_IOCTL */
+#define AIE_PDI_MAX_SIZE		SZ_64M
+
+/**
+ * struct aie_part_reg_cache - tile validated by the last register access
+ * @loc: tile location
+ * @ttype: tile type
+ * @valid: true if @loc has been validated
+ *
+ * A batch of register operations usually targets the same tile in a row, so
+ * the tile location and clock checks only run when the tile changes.
+ */
+struct aie_part_reg_cache {
+	struct aie_location loc;
+	u32 ttype;
+	bool valid;
+};
 
 /**
  * aie_cal_loc() - calculate tile location from register offset to the AI
@@ -49,13 +81,16 @@ static void aie_cal_loc(struct aie_device *adev,
  * @offset: AI engine register offset
  * @len: len of data to write/read
  * @is_write: is the access to write to register
+ * @cache: tile validated by the previous access, or NULL
  * @return: 0 for success, or negative value for failure.
  *
  * This function validate if the register to access is within the AI engine
  * partition. If it is write access, if the register is writable by user.
+ * If @cache holds the tile of the register, the tile checks are skipped.
  */
 static int aie_part_reg_validation(struct aie_partition *apart, size_t offset,
-				   size_t len, u8 is_write)
+				   size_t len, u8 is_write,
+				   struct aie_part_reg_cache *cache)
 {
 	struct aie_device *adev;
 	u32 regend32, ttype;
@@ -85,6 +120,12 @@ static int aie_part_reg_validation(struct aie_partition *apart, size_t offset,
 	}
 
 	aie_cal_loc(adev, &loc, offset);
+	if (cache && cache->valid && cache->loc.col == loc.col &&
+	    cache->loc.row == loc.row) {
+		ttype = cache->ttype;
+		goto check_perm;
+	}
+
 	if (aie_validate_location(apart, loc)) {
 		dev_err(&apart->dev,
 			"Invalid (%d,%d) out of part(%d,%d),(%d,%d)\n",
@@ -115,11 +156,18 @@ static int aie_part_reg_validation(struct aie_partition *apart, size_t offset,
 		return -EINVAL;
 	}
 
+	ttype = adev->ops->get_tile_type(&loc);
+	if (cache) {
+		cache->loc = loc;
+		cache->ttype = ttype;
+		cache->valid = true;
+	}
+
+check_perm:
 	if (!is_write)
 		return 0;
 
 	regend32 = lower_32_bits(regend64);
-	ttype = adev->ops->get_tile_type(&loc);
 	for (i = 0; i < adev->num_kernel_regs; i++) {
 		const struct aie_tile_regs *regs;
 		u32 rttype, writable;
@@ -152,13 +200,15 @@ static int aie_part_reg_validation(struct aie_partition *apart, size_t offset,
  * @len: len of data to write
  * @data: data to write
  * @mask: mask, if it is non 0, it is mask write.
+ * @cache: tile validated by the previous access, or NULL
  * @return: number of bytes write for success, or negative value for failure.
  *
  * This function writes data to the specified registers.
  * If the mask is non 0, it is mask write.
  */
 static int aie_part_write_register(struct aie_partition *apart, size_t offset,
-				   size_t len, void *data, u32 mask)
+				   size_t len, void *data, u32 mask,
+				   struct aie_part_reg_cache *cache)
 {
 	int ret;
 	void __iomem *va;
@@ -172,13 +222,17 @@ static int aie_part_write_register(struct aie_partition *apart, size_t offset,
 
 	/* offset is expected to be relative to the start of the partition */
 	offset += aie_cal_regoff(apart->adev, apart->range.start, 0);
-	ret = aie_part_reg_validation(apart, offset, len, 1);
+	ret = aie_part_reg_validation(apart, offset, len, 1, cache);
 	if (ret < 0) {
 		dev_err(&apart->dev, "failed to write to 0x%zx,0x%zx.\n",
 			offset, len);
 		return ret;
 	}
 
+	trace_aie_part_write_register(apart, offset, len, mask);
+	atomic64_inc(&apart->stats.reg_writes);
+	atomic64_add(len, &apart->stats.reg_write_bytes);
+
 	va = apart->adev->base + offset;
 	if (!mask) {
 		if (len == sizeof(u32))
@@ -202,19 +256,21 @@ static int aie_part_write_register(struct aie_partition *apart, size_t offset,
  * @offset: AI engine register offset
  * @len: len of data to read
  * @data: pointer to the memory to store the read data
+ * @cache: tile validated by the previous access, or NULL
  * @return: number of bytes read for success, or negative value for failure.
  *
  * This function reads data from the specified registers.
  */
 static int aie_part_read_register(struct aie_partition *apart, size_t offset,
-				  size_t len, void *data)
+				  size_t len, void *data,
+				  struct aie_part_reg_cache *cache)
 {
 	void __iomem *va;
 	int ret;
 
 	/* offset is expected to be relative to the start of the partition */
 	offset += aie_cal_regoff(apart->adev, apart->range.start, 0);
-	ret = aie_part_reg_validation(apart, offset, len, 0);
+	ret = aie_part_reg_validation(apart, offset, len, 0, cache);
 	if (ret) {
 		dev_err(&apart->dev, "Invalid read request 0x%zx,0x%zx.\n",
 			offset, len);
@@ -230,17 +286,63 @@ static int aie_part_read_register(struct aie_partition *apart, size_t offset,
 	return (int)len;
 }
 
+/**
+ * aie_part_poll_register() - AI engine partition poll register
+ * @apart: AI engine partition
+ * @offset: AI engine register offset
+ * @val: value to wait for
+ * @mask: bits of @val to compare, 0 to compare all bits
+ * @timeout_us: timeout in microseconds
+ * @cache: tile validated by the previous access, or NULL
+ * @return: 0 for success, or negative value for failure.
+ *
+ * This function polls the specified register until the masked register value
+ * equals the masked @val.
+ */
+static int aie_part_poll_register(struct aie_partition *apart, size_t offset,
+				  u32 val, u32 mask, u32 timeout_us,
+				  struct aie_part_reg_cache *cache)
+{
+	void __iomem *va;
+	u32 regval;
+	int ret;
+
+	if (!mask)
+		mask = ~0U;
+
+	/* offset is expected to be relative to the start of the partition */
+	offset += aie_cal_regoff(apart->adev, apart->range.start, 0);
+	ret = aie_part_reg_validation(apart, offset, sizeof(u32), 0, cache);
+	if (ret) {
+		dev_err(&apart->dev, "Invalid poll request 0x%zx.\n", offset);
+		return -EINVAL;
+	}
+
+	va = apart->adev->base + offset;
+	ret = readl_poll_timeout(va, regval, (regval & mask) == (val & mask),
+				 1, timeout_us);
+	if (ret)
+		dev_err(&apart->dev, "poll 0x%zx timed out, 0x%x.\n",
+			offset, regval);
+
+	return ret;
+}
+
 /**
  * aie_part_access_regs() - AI engine partition registers access
  * @apart: AI engine partition
  * @num_reqs: number of access requests
  * @reqs: array of registers access
+ * @timeout_us: timeout of each poll request in microseconds
+ * @cache: tile validated by the previous access, or NULL
  * @return: 0 for success, and negative value for failure.
  *
  * This function executes AI engine partition register access requests.
+ * The value of a read request is returned in its @val.
  */
 static int aie_part_access_regs(struct aie_partition *apart, u32 num_reqs,
-				struct aie_reg_args *reqs)
+				struct aie_reg_args *reqs, u32 timeout_us,
+				struct aie_part_reg_cache *cache)
 {
 	u32 i;
 
@@ -248,16 +350,32 @@ static int aie_part_access_regs(struct aie_partition *apart, u32 num_reqs,
 		struct aie_reg_args *args = &reqs[i];
 		int ret;
 
-		if (args->op != AIE_REG_WRITE) {
+		switch (args->op) {
+		case AIE_REG_WRITE:
+			ret = aie_part_write_register(apart,
+						      (size_t)args->offset,
+						      sizeof(args->val),
+						      &args->val, args->mask,
+						      cache);
+			break;
+		case AIE_REG_READ:
+			ret = aie_part_read_register(apart,
+						     (size_t)args->offset,
+						     sizeof(args->val),
+						     &args->val, cache);
+			break;
+		case AIE_REG_POLL:
+			ret = aie_part_poll_register(apart,
+						     (size_t)args->offset,
+						     args->val, args->mask,
+						     timeout_us, cache);
+			break;
+		default:
 			dev_err(&apart->dev,
 				"Invalid register command type: %u.\n",
 				args->op);
 			return -EINVAL;
 		}
-		ret = aie_part_write_register(apart,
-					      (size_t)args->offset,
-					      sizeof(args->val),
-					      &args->val, args->mask);
 		if (ret < 0) {
 			dev_err(&apart->dev, "reg op %u failed: 0x%llx.\n",
 				args->op, args->offset);
@@ -268,6 +386,147 @@ static int aie_part_access_regs(struct aie_partition *apart, u32 num_reqs,
 	return 0;
 }
 
+/**
+ * aie_part_access_regs_from_user() - execute a user register command buffer
+ * @apart: AI engine partition
+ * @user_args: user AI engine register command buffer
+ * @return: 0 for success, and negative value for failure.
+ *
+ * This function executes the register access requests of the command buffer
+ * in order, under a single hold of the clock state lock. The requests are
+ * copied in by chunks, and the chunks with read requests are copied back to
+ * return the read values. It stops at the first failing request.
+ */
+static int aie_part_access_regs_from_user(struct aie_partition *apart,
+					  void __user *user_args)
+{
+	struct aie_part_reg_cache cache = { .valid = false };
+	struct aie_reg_cmdbuf cmdbuf;
+	struct aie_reg_args *reqs;
+	u32 timeout_us, done, num, i;
+	int ret;
+
+	if (copy_from_user(&cmdbuf, user_args, sizeof(cmdbuf)))
+		return -EFAULT;
+
+	if (!cmdbuf.num_cmds)
+		return 0;
+
+	timeout_us = cmdbuf.poll_timeout_us;
+	if (!timeout_us)
+		timeout_us = AIE_REG_POLL_TIMEOUT_US;
+
+	reqs = kmalloc_array(min(cmdbuf.num_cmds, AIE_REG_CMDBUF_CHUNK),
+			     sizeof(*reqs), GFP_KERNEL);
+	if (!reqs)
+		return -ENOMEM;
+
+	ret = down_read_killable(&apart->clk_rwsem);
+	if (ret) {
+		kfree(reqs);
+		return ret;
+	}
+
+	trace_aie_part_access_regs_start(apart, cmdbuf.num_cmds);
+
+	for (done = 0; done < cmdbuf.num_cmds; done += num) {
+		void __user *ureqs = (void __user *)(cmdbuf.cmds + done);
+
+		num = min(cmdbuf.num_cmds - done, AIE_REG_CMDBUF_CHUNK);
+		if (copy_from_user(reqs, ureqs, num * sizeof(*reqs))) {
+			ret = -EFAULT;
+			break;
+		}
+
+		ret = aie_part_access_regs(apart, num, reqs, timeout_us,
+					   &cache);
+		if (ret)
+			break;
+
+		for (i = 0; i < num; i++) {
+			if (reqs[i].op != AIE_REG_READ)
+				continue;
+			if (copy_to_user(ureqs, reqs, num * sizeof(*reqs)))
+				ret = -EFAULT;
+			break;
+		}
+		if (ret)
+			break;
+	}
+
+	trace_aie_part_access_regs_end(apart, ret);
+
+	up_read(&apart->clk_rwsem);
+	kfree(reqs);
+
+	return ret;
+}
+
+/**
+ * aie_part_load_pdi_from_user() - load a user PDI to the AI engine partition
+ * @apart: AI engine partition
+ * @user_args: user AI engine PDI load arguments
+ * @return: 0 for success, and negative value for failure.
+ *
+ * This function copies the PDI to a DMA buffer and asks the platform
+ * management firmware to load it. The firmware processes the configuration
+ * data objects of the PDI and writes them to the array with DMA, which is
+ * much faster than writing the registers and memories from the CPU. As the
+ * PDI can ungate tiles, the tiles clock states are scanned again after the
+ * PDI is loaded.
+ */
+static int aie_part_load_pdi_from_user(struct aie_partition *apart,
+				       void __user *user_args)
+{
+	const struct zynqmp_eemi_ops *eemi_ops = apart->adev->eemi_ops;
+	struct aie_pdi_args args;
+	dma_addr_t dma_addr;
+	void *buf;
+	int ret;
+
+	if (!eemi_ops->pdi_load)
+		return -EOPNOTSUPP;
+
+	if (copy_from_user(&args, user_args, sizeof(args)))
+		return -EFAULT;
+
+	if (!args.size || args.size > AIE_PDI_MAX_SIZE) {
+		dev_err(&apart->dev, "Invalid PDI size %u.\n", args.size);
+		return -EINVAL;
+	}
+
+	buf = dma_alloc_coherent(&apart->dev, args.size, &dma_addr,
+				 GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	if (copy_from_user(buf, (void __user *)args.pdi, args.size)) {
+		ret = -EFAULT;
+		goto free_buf;
+	}
+
+	ret = mutex_lock_interruptible(&apart->mlock);
+	if (ret)
+		goto free_buf;
+
+	/* ensure the PDI is written before the firmware reads it */
+	wmb();
+	down_write(&apart->clk_rwsem);
+	ret = eemi_ops->pdi_load(AIE_PDI_SRC_DDR, dma_addr);
+	if (ret)
+		dev_err(&apart->dev, "failed to load PDI: %d.\n", ret);
+	else
+		ret = aie_part_scan_clk_state(apart);
+	up_write(&apart->clk_rwsem);
+
+	mutex_unlock(&apart->mlock);
+
+free_buf:
+	dma_free_coherent(&apart->dev, args.size, buf, dma_addr);
+
+	return ret;
+}
+
 /**
  * aie_part_create_event_bitmap() - create event bitmap for all modules in a
  *				    given partition.
@@ -337,6 +596,14 @@ static int aie_part_create_l2_bitmap(struct aie_partition *apart)
 		return ret;
 	}
 
+	ret = aie_resource_initialize(&apart->l2_status, num_l2_ctrls *
+				      AIE_INTR_L2_CTRL_MASK_WIDTH);
+	if (ret) {
+		dev_err(&apart->dev,
+			"failed to initialize l2 status resource.\n");
+		return ret;
+	}
+
 	return 0;
 }
 
@@ -362,7 +629,12 @@ static int aie_part_release(struct inode *inode, struct file *filp)
 	if (ret)
 		return ret;
 
+	trace_aie_part_release_start(apart);
+
+	aie_part_release_dma_rings(apart);
 	aie_part_release_dmabufs(apart);
+	aie_part_release_dma_eventfds(apart);
+	aie_part_release_ctxs(apart);
 	aie_part_clean(apart);
 
 	apart->error_cb.cb = NULL;
@@ -372,6 +644,10 @@ static int aie_part_release(struct inode *inode, struct file *filp)
 
 	aie_part_clear_cached_events(apart);
 	aie_resource_clear_all(&apart->l2_mask);
+	aie_resource_clear_all(&apart->l2_status);
+	memset(apart->err_status, 0, sizeof(*apart->err_status));
+
+	trace_aie_part_release_end(apart, 0);
 
 	mutex_unlock(&apart->mlock);
 
@@ -395,14 +671,14 @@ static ssize_t aie_part_write_iter(struct kiocb *iocb, struct iov_iter *from)
 		return -EFAULT;
 	}
 
-	ret = mutex_lock_interruptible(&apart->mlock);
+	ret = down_read_killable(&apart->clk_rwsem);
 	if (ret) {
 		kfree(buf);
 		return ret;
 	}
 
-	ret = aie_part_write_register(apart, (size_t)offset, len, buf, 0);
-	mutex_unlock(&apart->mlock);
+	ret = aie_part_write_register(apart, (size_t)offset, len, buf, 0, NULL);
+	up_read(&apart->clk_rwsem);
 	kfree(buf);
 
 	return ret;
@@ -421,14 +697,14 @@ static ssize_t aie_part_read_iter(struct kiocb *iocb, struct iov_iter *to)
 	if (!buf)
 		return -ENOMEM;
 
-	ret = mutex_lock_interruptible(&apart->mlock);
+	ret = down_read_killable(&apart->clk_rwsem);
 	if (ret) {
 		kfree(buf);
 		return ret;
 	}
 
-	ret = aie_part_read_register(apart, (size_t)offset, len, buf);
-	mutex_unlock(&apart->mlock);
+	ret = aie_part_read_register(apart, (size_t)offset, len, buf, NULL);
+	up_read(&apart->clk_rwsem);
 	if (ret > 0) {
 		if (copy_to_iter(buf, ret, to) != len) {
 			dev_err(&apart->dev, "Failed to copy to read iter.\n");
@@ -462,6 +738,14 @@ static int aie_part_mmap(struct file *fp, struct vm_area_struct *vma)
 			__func__);
 		return -EINVAL;
 	}
+	if (offset == AIE_ERROR_STATUS_MMAP_OFFSET) {
+		if (vma->vm_end - vma->vm_start != PAGE_SIZE)
+			return -EINVAL;
+		return remap_pfn_range(vma, vma->vm_start,
+				       virt_to_phys(apart->err_status) >>
+				       PAGE_SHIFT, PAGE_SIZE,
+				       vma->vm_page_prot);
+	}
 	vma->vm_private_data = apart;
 	vma->vm_ops = &aie_part_physical_vm_ops;
 	size = apart->range.size.col << adev->col_shift;
@@ -497,14 +781,36 @@ static long aie_part_ioctl(struct file *fp, unsigned int cmd, unsigned long arg)
 		if (copy_from_user(&raccess, argp, sizeof(raccess)))
 			return -EFAULT;
 
-		ret = mutex_lock_interruptible(&apart->mlock);
+		ret = down_read_killable(&apart->clk_rwsem);
 		if (ret)
 			return ret;
 
-		ret = aie_part_access_regs(apart, 1, &raccess);
-		mutex_unlock(&apart->mlock);
+		ret = aie_part_access_regs(apart, 1, &raccess,
+					   AIE_REG_POLL_TIMEOUT_US, NULL);
+		up_read(&apart->clk_rwsem);
+		if (!ret && raccess.op == AIE_REG_READ &&
+		    copy_to_user(argp, &raccess, sizeof(raccess)))
+			ret = -EFAULT;
 		break;
 	}
+	case AIE_REG_CMDBUF_IOCTL:
+		return aie_part_access_regs_from_user(apart, argp);
+	case AIE_LOAD_PDI_IOCTL:
+		return aie_part_load_pdi_from_user(apart, argp);
+	case AIE_SET_SHIMDMA_EVENTFD_IOCTL:
+		return aie_part_set_dma_eventfd(apart, argp);
+	case AIE_SET_SHIMDMA_DMABUF_RING_IOCTL:
+		return aie_part_set_dmabuf_ring(apart, argp);
+	case AIE_SAVE_CONTEXT_IOCTL:
+		return aie_part_save_ctx(apart, argp);
+	case AIE_RESTORE_CONTEXT_IOCTL:
+		return aie_part_restore_ctx(apart, (u32)arg);
+	case AIE_FREE_CONTEXT_IOCTL:
+		return aie_part_free_ctx(apart, (u32)arg);
+	case AIE_SET_PERFCNT_IOCTL:
+		return aie_part_set_perfcnt(apart, argp);
+	case AIE_GET_PERFCNTS_IOCTL:
+		return aie_part_get_perfcnts(apart, argp);
 	case AIE_GET_MEM_IOCTL:
 		return aie_mem_get_info(apart, arg);
 	case AIE_ATTACH_DMABUF_IOCTL:
@@ -528,6 +834,33 @@ static long aie_part_ioctl(struct file *fp, unsigned int cmd, unsigned long arg)
 	return ret;
 }
 
+/*
+ * Commands which poll registers, load or save whole partitions, or go
+ * through the firmware are issued from an io_uring async worker, the others
+ * are cheap register accesses done from the submitter.
+ */
+static long aie_part_uring_cmd(struct file *fp, unsigned int cmd,
+			       unsigned long arg, unsigned int issue_flags)
+{
+	if (issue_flags & IO_URING_F_NONBLOCK) {
+		switch (cmd) {
+		case AIE_REG_IOCTL:
+		case AIE_REG_CMDBUF_IOCTL:
+		case AIE_LOAD_PDI_IOCTL:
+		case AIE_SAVE_CONTEXT_IOCTL:
+		case AIE_RESTORE_CONTEXT_IOCTL:
+		case AIE_FREE_CONTEXT_IOCTL:
+		case AIE_REQUEST_TILES_IOCTL:
+		case AIE_RELEASE_TILES_IOCTL:
+			return -EAGAIN;
+		default:
+			break;
+		}
+	}
+
+	return aie_part_ioctl(fp, cmd, arg);
+}
+
 const struct file_operations aie_part_fops = {
 	.owner		= THIS_MODULE,
 	.release	= aie_part_release,
@@ -535,6 +868,7 @@ const struct file_operations aie_part_fops = {
 	.write_iter	= aie_part_write_iter,
 	.mmap		= aie_part_mmap,
 	.unlocked_ioctl	= aie_part_ioctl,
+	.uring_cmd	= aie_part_uring_cmd,
 };
 
 /**
@@ -560,6 +894,9 @@ static void aie_part_release_device(struct device *dev)
 				apart->range.size.col);
 	aie_part_release_event_bitmap(apart);
 	aie_resource_uninitialize(&apart->l2_mask);
+	aie_resource_uninitialize(&apart->l2_status);
+	free_page((unsigned long)apart->err_status);
+	idr_destroy(&apart->ctxs);
 	list_del(&apart->node);
 	mutex_unlock(&adev->mlock);
 	aie_fpga_free_bridge(apart);
@@ -651,9 +988,13 @@ static struct aie_partition *aie_create_partition(struct aie_device *adev,
 		return ERR_PTR(-ENOMEM);
 
 	apart->adev = adev;
-	INIT_LIST_HEAD(&apart->dbufs);
+	xa_init(&apart->dbufs);
+	INIT_LIST_HEAD(&apart->dma_efds);
+	INIT_LIST_HEAD(&apart->dma_rings);
+	idr_init(&apart->ctxs);
 	memcpy(&apart->range, range, sizeof(*range));
 	mutex_init(&apart->mlock);
+	init_rwsem(&apart->clk_rwsem);
 
 	/* Create AI engine partition device */
 	dev = &apart->dev;
@@ -711,6 +1052,14 @@ static struct aie_partition *aie_create_partition(struct aie_device *adev,
 		return ERR_PTR(ret);
 	}
 
+	apart->err_status = (struct aie_error_status *)
+			    get_zeroed_page(GFP_KERNEL);
+	if (!apart->err_status) {
+		dev_err(&apart->dev, "Failed to allocate error status.\n");
+		put_device(dev);
+		return ERR_PTR(-ENOMEM);
+	}
+
 	ret = mutex_lock_interruptible(&adev->mlock);
 	if (ret) {
 		put_device(dev);
@@ -724,6 +1073,31 @@ static struct aie_partition *aie_create_partition(struct aie_device *adev,
 	return apart;
 }
 
+/**
+ * aie_part_stats_show() - show the statistics of an AI engine partition
+ * @m: seq_file to print to
+ * @unused: unused
+ * @return: 0, always.
+ */
+static int aie_part_stats_show(struct seq_file *m, void *unused)
+{
+	struct aie_partition *apart = m->private;
+	struct aie_part_stats *stats = &apart->stats;
+
+	seq_printf(m, "reg_writes: %lld\n",
+		   atomic64_read(&stats->reg_writes));
+	seq_printf(m, "reg_write_bytes: %lld\n",
+		   atomic64_read(&stats->reg_write_bytes));
+	seq_printf(m, "bd_submissions: %lld\n",
+		   atomic64_read(&stats->bd_submissions));
+	seq_printf(m, "error_irqs: %lld\n",
+		   atomic64_read(&stats->error_irqs));
+	seq_printf(m, "errors: %lld\n", atomic64_read(&stats->errors));
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(aie_part_stats);
+
 struct aie_partition *
 of_aie_part_probe(struct aie_device *adev, struct device_node *nc)
 {
@@ -791,6 +1165,11 @@ of_aie_part_probe(struct aie_device *adev, struct device_node *nc)
 	if (ret < 0)
 		dev_warn(&apart->dev, "failed to create fpga region.\n");
 
+	apart->debugfs = debugfs_create_dir(dev_name(&apart->dev),
+					    aie_debugfs_root);
+	debugfs_create_file("stats", 0444, apart->debugfs, apart,
+			    &aie_part_stats_fops);
+
 	dev_info(&adev->dev,
 		 "AI engine part(%u,%u),(%u,%u), id %u is probed successfully.\n",
 		 range.start.col, range.start.row,
@@ -807,6 +1186,7 @@ of_aie_part_probe(struct aie_device *adev, struct device_node *nc)
  */
 void aie_part_remove(struct aie_partition *apart)
 {
+	debugfs_remove_recursive(apart->debugfs);
 	device_del(&apart->dev);
 	put_device(&apart->dev);
 }
@@ -0,0 +1,219 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Xilinx AI Engine device driver performance counters implementation
+ *
+ * Copyright (C) 2020 Xilinx, Inc.
+ */
+
+#include <linux/bitops.h>
+#include <linux/io.h>
+#include <linux/uaccess.h>
+
+#include "ai-engine-internal.h"
+
+#define AIE_PERFCNT_EVENT_MASK		GENMASK(6, 0)
+#define AIE_PERFCNT_EVENT_WIDTH		8U
+#define AIE_PERFCNT_CTRL_CNTS		2U
+#define AIE_PERFCNT_RESET_CNTS		4U
+
+/**
+ * aie_part_get_perfcnt_attr() - get the performance counter attributes of a
+ *				 tile module
+ * @apart: AI engine partition
+ * @loc: absolute tile location
+ * @module: module type
+ * @return: performance counter attributes, NULL if the tile doesn't have the
+ *	    module
+ */
+static const struct aie_perfcnt_attr *
+aie_part_get_perfcnt_attr(struct aie_partition *apart,
+			  struct aie_location *loc, u32 module)
+{
+	struct aie_device *adev = apart->adev;
+	u32 ttype = adev->ops->get_tile_type(loc);
+
+	if (ttype == AIE_TILE_TYPE_TILE) {
+		if (module == AIE_MEM_MOD)
+			return adev->mem_perfcnt;
+		if (module == AIE_CORE_MOD)
+			return adev->core_perfcnt;
+	} else if (module == AIE_PL_MOD) {
+		return adev->pl_perfcnt;
+	}
+
+	return NULL;
+}
+
+/**
+ * aie_part_validate_perfcnt() - validate a performance counter
+ * @apart: AI engine partition
+ * @args: performance counter arguments
+ * @loc: pointer to return the absolute tile location
+ * @return: performance counter attributes for success, error pointer for
+ *	    failure
+ */
+static const struct aie_perfcnt_attr *
+aie_part_validate_perfcnt(struct aie_partition *apart,
+			  struct aie_perfcnt_args *args,
+			  struct aie_location *loc)
+{
+	const struct aie_perfcnt_attr *perfcnt;
+
+	loc->col = args->loc.col + apart->range.start.col;
+	loc->row = args->loc.row + apart->range.start.row;
+	if (aie_validate_location(apart, *loc) < 0) {
+		dev_err(&apart->dev, "invalid perf counter loc (%u,%u).\n",
+			args->loc.col, args->loc.row);
+		return ERR_PTR(-EINVAL);
+	}
+
+	perfcnt = aie_part_get_perfcnt_attr(apart, loc, args->module);
+	if (!perfcnt || args->cnt >= perfcnt->num_cnts) {
+		dev_err(&apart->dev,
+			"invalid perf counter %u of module %u at (%u,%u).\n",
+			args->cnt, args->module, args->loc.col, args->loc.row);
+		return ERR_PTR(-EINVAL);
+	}
+
+	if (!aie_part_check_clk_enable_loc(apart, loc)) {
+		dev_err(&apart->dev, "Tile(%u,%u) is gated.\n", args->loc.col,
+			args->loc.row);
+		return ERR_PTR(-EINVAL);
+	}
+
+	return perfcnt;
+}
+
+/**
+ * aie_part_set_perfcnt_event() - set an event field of a performance counter
+ *				  control register
+ * @apart: AI engine partition
+ * @loc: absolute tile location
+ * @regoff: control register offset within the tile
+ * @shift: event field shift
+ * @event: event ID
+ */
+static void aie_part_set_perfcnt_event(struct aie_partition *apart,
+				       struct aie_location loc, u32 regoff,
+				       u32 shift, u8 event)
+{
+	void __iomem *va;
+	u32 regval;
+
+	va = apart->adev->base + aie_cal_regoff(apart->adev, loc, regoff);
+	regval = ioread32(va);
+	regval &= ~(AIE_PERFCNT_EVENT_MASK << shift);
+	regval |= (event & AIE_PERFCNT_EVENT_MASK) << shift;
+	iowrite32(regval, va);
+}
+
+/**
+ * aie_part_set_perfcnt() - set an AI engine performance counter
+ * @apart: AI engine partition
+ * @user_args: user AI engine performance counter argument
+ * @return: 0 for success, negative value for failure
+ *
+ * This function sets the start, stop and reset events and the initial value
+ * of a performance counter.
+ */
+long aie_part_set_perfcnt(struct aie_partition *apart,
+			  void __user *user_args)
+{
+	const struct aie_perfcnt_attr *perfcnt;
+	struct aie_perfcnt_args args;
+	struct aie_location loc;
+	u32 regoff, shift;
+	long ret;
+
+	if (copy_from_user(&args, user_args, sizeof(args)))
+		return -EFAULT;
+
+	ret = mutex_lock_interruptible(&apart->mlock);
+	if (ret)
+		return ret;
+
+	perfcnt = aie_part_validate_perfcnt(apart, &args, &loc);
+	if (IS_ERR(perfcnt)) {
+		mutex_unlock(&apart->mlock);
+		return PTR_ERR(perfcnt);
+	}
+
+	regoff = perfcnt->ctrl_regoff +
+		 (args.cnt / AIE_PERFCNT_CTRL_CNTS) * sizeof(u32);
+	shift = (args.cnt % AIE_PERFCNT_CTRL_CNTS) * 2 *
+		AIE_PERFCNT_EVENT_WIDTH;
+	aie_part_set_perfcnt_event(apart, loc, regoff, shift,
+				   args.start_event);
+	aie_part_set_perfcnt_event(apart, loc, regoff,
+				   shift + AIE_PERFCNT_EVENT_WIDTH,
+				   args.stop_event);
+
+	regoff = perfcnt->reset_regoff +
+		 (args.cnt / AIE_PERFCNT_RESET_CNTS) * sizeof(u32);
+	shift = (args.cnt % AIE_PERFCNT_RESET_CNTS) * AIE_PERFCNT_EVENT_WIDTH;
+	aie_part_set_perfcnt_event(apart, loc, regoff, shift,
+				   args.reset_event);
+
+	regoff = aie_cal_regoff(apart->adev, loc, perfcnt->cnt_regoff +
+				args.cnt * sizeof(u32));
+	iowrite32(args.value, apart->adev->base + regoff);
+
+	mutex_unlock(&apart->mlock);
+	return 0;
+}
+
+/**
+ * aie_part_get_perfcnts() - read AI engine performance counters
+ * @apart: AI engine partition
+ * @user_args: user AI engine performance counters array argument
+ * @return: 0 for success, negative value for failure
+ *
+ * This function reads the values of an array of performance counters and
+ * returns them to the value field of each user counter.
+ */
+long aie_part_get_perfcnts(struct aie_partition *apart,
+			   void __user *user_args)
+{
+	struct aie_perfcnt_args __user *ucnts;
+	struct aie_perfcnt_array array;
+	long ret;
+	u32 i;
+
+	if (copy_from_user(&array, user_args, sizeof(array)))
+		return -EFAULT;
+
+	ucnts = (struct aie_perfcnt_args __user *)array.cnts;
+
+	ret = mutex_lock_interruptible(&apart->mlock);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < array.num_cnts; i++) {
+		const struct aie_perfcnt_attr *perfcnt;
+		struct aie_perfcnt_args args;
+		struct aie_location loc;
+		u32 regoff;
+
+		if (copy_from_user(&args, &ucnts[i], sizeof(args))) {
+			ret = -EFAULT;
+			break;
+		}
+
+		perfcnt = aie_part_validate_perfcnt(apart, &args, &loc);
+		if (IS_ERR(perfcnt)) {
+			ret = PTR_ERR(perfcnt);
+			break;
+		}
+
+		regoff = aie_cal_regoff(apart->adev, loc, perfcnt->cnt_regoff +
+					args.cnt * sizeof(u32));
+		args.value = ioread32(apart->adev->base + regoff);
+		if (put_user(args.value, &ucnts[i].value)) {
+			ret = -EFAULT;
+			break;
+		}
+	}
+
+	mutex_unlock(&apart->mlock);
+	return ret;
+}
@@ -9,6 +9,7 @@
 #include <linux/io.h>
 
 #include "ai-engine-internal.h"
+#include "ai-engine-trace.h"
 
 /**
  * aie_part_set_col_reset() - set AI engine column reset
@@ -181,6 +182,8 @@ int aie_part_reset(struct aie_partition *apart)
 	if (ret)
 		return ret;
 
+	trace_aie_part_reset_start(apart);
+
 	/*
 	 * Check if any AI engine memories or registers in the
 	 * partition have been mapped. If yes, don't reset.
@@ -189,10 +192,13 @@ int aie_part_reset(struct aie_partition *apart)
 	    aie_part_has_regs_mmapped(apart)) {
 		dev_err(&apart->dev,
 			"failed to reset, there are mmapped memories or registers.\n");
+		trace_aie_part_reset_end(apart, -EBUSY);
 		mutex_unlock(&apart->mlock);
 		return -EBUSY;
 	}
 
+	down_write(&apart->clk_rwsem);
+
 	/* Clear tiles in use bitmap and clock state bitmap */
 	aie_resource_clear_all(&apart->tiles_inuse);
 	aie_resource_clear_all(&apart->cores_clk_state);
@@ -202,15 +208,20 @@ int aie_part_reset(struct aie_partition *apart)
 
 	ret = apart->adev->ops->reset_shim(adev, &apart->range);
 	if (ret < 0) {
-		return ret;
+		up_write(&apart->clk_rwsem);
+		trace_aie_part_reset_end(apart, ret);
 		mutex_unlock(&apart->mlock);
+		return ret;
 	}
 
 	aie_part_set_cols_clkbuf(apart, false);
+	up_write(&apart->clk_rwsem);
 
 	aie_part_clear_cached_events(apart);
 	aie_resource_clear_all(&apart->l2_mask);
+	aie_resource_clear_all(&apart->l2_status);
 
+	trace_aie_part_reset_end(apart, 0);
 	mutex_unlock(&apart->mlock);
 	return 0;
 }
@@ -236,7 +247,9 @@ int aie_part_post_reinit(struct aie_partition *apart)
 	if (ret)
 		return ret;
 
+	down_write(&apart->clk_rwsem);
 	ret = aie_part_scan_clk_state(apart);
+	up_write(&apart->clk_rwsem);
 	mutex_unlock(&apart->mlock);
 	if (ret) {
 		dev_err(&apart->dev,
@@ -0,0 +1,203 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Xilinx AI Engine driver tracepoints
+ *
+ * The partition request, release and reset, and the register access batches
+ * have start and end events, so their duration is the time between the two.
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM xilinx_aie
+
+#if !defined(_AI_ENGINE_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _AI_ENGINE_TRACE_H
+
+#include <linux/tracepoint.h>
+
+#include "ai-engine-internal.h"
+
+DECLARE_EVENT_CLASS(aie_part,
+
+	TP_PROTO(struct aie_partition *apart),
+
+	TP_ARGS(apart),
+
+	TP_STRUCT__entry(
+		__field(u32, partition_id)
+	),
+
+	TP_fast_assign(
+		__entry->partition_id = apart->partition_id;
+	),
+
+	TP_printk("partition=%u", __entry->partition_id)
+);
+
+DECLARE_EVENT_CLASS(aie_part_ret,
+
+	TP_PROTO(struct aie_partition *apart, int ret),
+
+	TP_ARGS(apart, ret),
+
+	TP_STRUCT__entry(
+		__field(u32, partition_id)
+		__field(int, ret)
+	),
+
+	TP_fast_assign(
+		__entry->partition_id = apart->partition_id;
+		__entry->ret = ret;
+	),
+
+	TP_printk("partition=%u ret=%d", __entry->partition_id, __entry->ret)
+);
+
+DEFINE_EVENT(aie_part, aie_part_request_start,
+
+	TP_PROTO(struct aie_partition *apart),
+
+	TP_ARGS(apart)
+);
+
+DEFINE_EVENT(aie_part_ret, aie_part_request_end,
+
+	TP_PROTO(struct aie_partition *apart, int ret),
+
+	TP_ARGS(apart, ret)
+);
+
+DEFINE_EVENT(aie_part, aie_part_release_start,
+
+	TP_PROTO(struct aie_partition *apart),
+
+	TP_ARGS(apart)
+);
+
+DEFINE_EVENT(aie_part_ret, aie_part_release_end,
+
+	TP_PROTO(struct aie_partition *apart, int ret),
+
+	TP_ARGS(apart, ret)
+);
+
+DEFINE_EVENT(aie_part, aie_part_reset_start,
+
+	TP_PROTO(struct aie_partition *apart),
+
+	TP_ARGS(apart)
+);
+
+DEFINE_EVENT(aie_part_ret, aie_part_reset_end,
+
+	TP_PROTO(struct aie_partition *apart, int ret),
+
+	TP_ARGS(apart, ret)
+);
+
+TRACE_EVENT(aie_part_access_regs_start,
+
+	TP_PROTO(struct aie_partition *apart, u32 num_reqs),
+
+	TP_ARGS(apart, num_reqs),
+
+	TP_STRUCT__entry(
+		__field(u32, partition_id)
+		__field(u32, num_reqs)
+	),
+
+	TP_fast_assign(
+		__entry->partition_id = apart->partition_id;
+		__entry->num_reqs = num_reqs;
+	),
+
+	TP_printk("partition=%u num_reqs=%u", __entry->partition_id,
+		  __entry->num_reqs)
+);
+
+DEFINE_EVENT(aie_part_ret, aie_part_access_regs_end,
+
+	TP_PROTO(struct aie_partition *apart, int ret),
+
+	TP_ARGS(apart, ret)
+);
+
+TRACE_EVENT(aie_part_write_register,
+
+	TP_PROTO(struct aie_partition *apart, size_t offset, size_t len,
+		 u32 mask),
+
+	TP_ARGS(apart, offset, len, mask),
+
+	TP_STRUCT__entry(
+		__field(u32, partition_id)
+		__field(size_t, offset)
+		__field(size_t, len)
+		__field(u32, mask)
+	),
+
+	TP_fast_assign(
+		__entry->partition_id = apart->partition_id;
+		__entry->offset = offset;
+		__entry->len = len;
+		__entry->mask = mask;
+	),
+
+	TP_printk("partition=%u offset=0x%zx len=%zu mask=0x%08x",
+		  __entry->partition_id, __entry->offset, __entry->len,
+		  __entry->mask)
+);
+
+TRACE_EVENT(aie_part_set_shimdma_bd,
+
+	TP_PROTO(struct aie_partition *apart, struct aie_location loc,
+		 u32 bd_id),
+
+	TP_ARGS(apart, loc, bd_id),
+
+	TP_STRUCT__entry(
+		__field(u32, partition_id)
+		__field(u32, col)
+		__field(u32, row)
+		__field(u32, bd_id)
+	),
+
+	TP_fast_assign(
+		__entry->partition_id = apart->partition_id;
+		__entry->col = loc.col;
+		__entry->row = loc.row;
+		__entry->bd_id = bd_id;
+	),
+
+	TP_printk("partition=%u col=%u row=%u bd=%u", __entry->partition_id,
+		  __entry->col, __entry->row, __entry->bd_id)
+);
+
+TRACE_EVENT(aie_part_error_irq,
+
+	TP_PROTO(struct aie_partition *apart, u32 col, u32 l2_status),
+
+	TP_ARGS(apart, col, l2_status),
+
+	TP_STRUCT__entry(
+		__field(u32, partition_id)
+		__field(u32, col)
+		__field(u32, l2_status)
+	),
+
+	TP_fast_assign(
+		__entry->partition_id = apart->partition_id;
+		__entry->col = col;
+		__entry->l2_status = l2_status;
+	),
+
+	TP_printk("partition=%u col=%u l2_status=0x%08x",
+		  __entry->partition_id, __entry->col, __entry->l2_status)
+);
+
+#endif /* _AI_ENGINE_TRACE_H */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE ai-engine-trace
+#include <trace/define_trace.h>
@@ -5,6 +5,7 @@
  */
 
 #include <linux/firmware/xlnx-zynqmp.h>
+#include <linux/hrtimer.h>
 #include <linux/init.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
@@ -12,6 +13,7 @@
 #include <linux/mutex.h>
 #include <linux/of_platform.h>
 #include <linux/of_address.h>
+#include <linux/perf_event.h>
 #include <linux/platform_device.h>
 #include <linux/slab.h>
 
@@ -54,6 +56,7 @@
 #define FPM_SRC_BUSY			0x4
 #define FPM_SRC_WAIT			0x5
 #define FPM_SRC_PACKET			0x6
+#define FPM_SRC_MAX			FPM_SRC_PACKET
 
 /* Port values */
 #define FPM_PORT_LPD_AFIFS_AXI		0x0
@@ -64,6 +67,18 @@
 #define FPM_PORT_FPDAXI			0x1
 #define FPM_PORT_PROTXPPU		0x2
 
+/* perf event config fields */
+#define FPM_PMU_PROBE_MASK		GENMASK(1, 0)
+#define FPM_PMU_FPD			BIT(2)
+#define FPM_PMU_PORT_SHIFT		8
+#define FPM_PMU_PORT_MASK		GENMASK(7, 0)
+#define FPM_PMU_SRC_SHIFT		16
+#define FPM_PMU_SRC_MASK		GENMASK(3, 0)
+#define FPM_PMU_CONFIG_MASK		GENMASK(19, 0)
+#define FPM_PMU_NUM_PROBES		4
+#define FPM_PMU_NUM_EVENTS		(2 * FPM_PMU_NUM_PROBES)
+#define FPM_PMU_POLL_PERIOD_NS		NSEC_PER_SEC
+
 /**
  * struct xflex_dev_info - Global Driver structure
  * @dev: Device structure
@@ -73,6 +88,13 @@
  * @counterid_lpd: LPD counter id
  * @counterid_fpd: FPD counter id
  * @mutex: avoid parallel access to device
+ * @pmu: perf PMU over the LPD and FPD probes
+ * @eemi_ops: firmware operations used to read the probe counters
+ * @events: perf events, indexed by domain and probe
+ * @hrtimer: timer folding the 32bit counters before they wrap
+ * @num_active: number of active perf events
+ * @cpu: CPU the perf events are bound to
+ * @pmu_registered: the PMU is registered
  */
 struct xflex_dev_info {
 	struct device *dev;
@@ -82,6 +104,13 @@ struct xflex_dev_info {
 	u32 counterid_fpd;
 	u32 counterid_lpd;
 	struct mutex mutex; /* avoid parallel access to device */
+	struct pmu pmu;
+	const struct zynqmp_eemi_ops *eemi_ops;
+	struct perf_event *events[FPM_PMU_NUM_EVENTS];
+	struct hrtimer hrtimer;
+	unsigned int num_active;
+	unsigned int cpu;
+	bool pmu_registered;
 };
 
 /**
@@ -128,9 +157,9 @@ static inline void fpm_reg(void __iomem *base, u32 val, u32 offset)
 	writel(val, base + FPM_WR_RES_OFFSET + offset);
 }
 
-static void reset_default(struct device *dev, u32 counter, u32 domain)
+static void xflex_setup_counter(struct xflex_dev_info *flexpm, u32 counter,
+				u32 domain, u32 port, u32 src)
 {
-	struct xflex_dev_info *flexpm = to_xflex_dev_info(dev);
 	void __iomem *base = flexpm->basefpd;
 	u32 offset;
 
@@ -142,14 +171,20 @@ static void reset_default(struct device *dev, u32 counter, u32 domain)
 	fpm_reg(base, FPM_STATEN | FPM_STATCOND_DUMP, FPM_MAIN_CTRL_OFFSET);
 
 	offset = FPM_PORT_SEL_OFFSET + counter * FPM_COUNTER_OFFSET;
-	fpm_reg(base, FPM_PORT_LPD_OCM, offset);
+	fpm_reg(base, port, offset);
 	offset = FPM_SRC_SEL_OFFSET + counter * FPM_COUNTER_OFFSET;
-	fpm_reg(base, FPM_SRC_PACKET, offset);
+	fpm_reg(base, src, offset);
 
 	fpm_reg(base, 0, FPM_STATPERIOD);
 	fpm_reg(base, FPM_GLOBALEN, FPM_CFGCTRL);
 }
 
+static void reset_default(struct device *dev, u32 counter, u32 domain)
+{
+	xflex_setup_counter(to_xflex_dev_info(dev), counter, domain,
+			    FPM_PORT_LPD_OCM, FPM_SRC_PACKET);
+}
+
 /**
  * xflex_sysfs_cmd - Implements sysfs operations
  * @dev: Device structure
@@ -240,7 +275,7 @@ static int xflex_sysfs_cmd(struct device *dev, const char *buf,
 		if (ret < 0)
 			goto exit_unlock;
 
-		counter = flexpm->counterid_fpd * FPM_COUNTER_OFFSET;
+		counter = flexpm->counterid_fpd;
 		offset = FPM_PORT_SEL_OFFSET + counter * FPM_COUNTER_OFFSET;
 		fpm_reg(flexpm->basefpd, val, offset);
 		break;
@@ -250,7 +285,7 @@ static int xflex_sysfs_cmd(struct device *dev, const char *buf,
 		if (ret < 0)
 			goto exit_unlock;
 
-		counter = flexpm->counterid_lpd * FPM_COUNTER_OFFSET;
+		counter = flexpm->counterid_lpd;
 		offset = FPM_PORT_SEL_OFFSET + counter * FPM_COUNTER_OFFSET;
 		fpm_reg(flexpm->baselpd, val, offset);
 		break;
@@ -570,6 +605,374 @@ static struct attribute *xflex_attrs[] = {
 
 ATTRIBUTE_GROUPS(xflex);
 
+#ifdef CONFIG_PERF_EVENTS
+/*
+ * Each domain has one active counter, selected with the counteridlpd and
+ * counteridfpd attributes, which is sampled by the four read/write
+ * request/response probes. A perf event selects a domain and a probe and
+ * may set the port and the source counted by the domain counter, so all
+ * the active events of a domain have to agree on the port and source.
+ * The predefined events count packets. The counters are read through the
+ * firmware and are never reset, the PMU accumulates 32bit deltas.
+ */
+#define to_xflex_pmu(p)	container_of(p, struct xflex_dev_info, pmu)
+
+static ssize_t xflex_pmu_cpumask_show(struct device *dev,
+				      struct device_attribute *attr, char *buf)
+{
+	struct xflex_dev_info *flexpm = to_xflex_pmu(dev_get_drvdata(dev));
+
+	return cpumap_print_to_pagebuf(true, buf, cpumask_of(flexpm->cpu));
+}
+
+static struct device_attribute xflex_pmu_cpumask_attr =
+	__ATTR(cpumask, 0444, xflex_pmu_cpumask_show, NULL);
+
+static struct attribute *xflex_pmu_cpumask_attrs[] = {
+	&xflex_pmu_cpumask_attr.attr,
+	NULL,
+};
+
+static struct attribute_group xflex_pmu_cpumask_attr_group = {
+	.attrs = xflex_pmu_cpumask_attrs,
+};
+
+static ssize_t xflex_pmu_event_show(struct device *dev,
+				    struct device_attribute *attr, char *page)
+{
+	struct perf_pmu_events_attr *pmu_attr;
+
+	pmu_attr = container_of(attr, struct perf_pmu_events_attr, attr);
+	return sprintf(page, "%s\n", pmu_attr->event_str);
+}
+
+#define XFLEX_PMU_EVENT_ATTR(_name, _str)				\
+	(&((struct perf_pmu_events_attr[]) {				\
+		{ .attr = __ATTR(_name, 0444, xflex_pmu_event_show, NULL),\
+		  .event_str = _str, }					\
+	})[0].attr.attr)
+
+static struct attribute *xflex_pmu_events_attrs[] = {
+	XFLEX_PMU_EVENT_ATTR(lpd-read-requests, "probe=0,fpd=0,src=0x6"),
+	XFLEX_PMU_EVENT_ATTR(lpd-read-responses, "probe=1,fpd=0,src=0x6"),
+	XFLEX_PMU_EVENT_ATTR(lpd-write-requests, "probe=2,fpd=0,src=0x6"),
+	XFLEX_PMU_EVENT_ATTR(lpd-write-responses, "probe=3,fpd=0,src=0x6"),
+	XFLEX_PMU_EVENT_ATTR(fpd-read-requests, "probe=0,fpd=1,src=0x6"),
+	XFLEX_PMU_EVENT_ATTR(fpd-read-responses, "probe=1,fpd=1,src=0x6"),
+	XFLEX_PMU_EVENT_ATTR(fpd-write-requests, "probe=2,fpd=1,src=0x6"),
+	XFLEX_PMU_EVENT_ATTR(fpd-write-responses, "probe=3,fpd=1,src=0x6"),
+	NULL,
+};
+
+static struct attribute_group xflex_pmu_events_attr_group = {
+	.name = "events",
+	.attrs = xflex_pmu_events_attrs,
+};
+
+PMU_FORMAT_ATTR(probe, "config:0-1");
+PMU_FORMAT_ATTR(fpd, "config:2");
+PMU_FORMAT_ATTR(port, "config:8-15");
+PMU_FORMAT_ATTR(src, "config:16-19");
+
+static struct attribute *xflex_pmu_format_attrs[] = {
+	&format_attr_probe.attr,
+	&format_attr_fpd.attr,
+	&format_attr_port.attr,
+	&format_attr_src.attr,
+	NULL,
+};
+
+static struct attribute_group xflex_pmu_format_attr_group = {
+	.name = "format",
+	.attrs = xflex_pmu_format_attrs,
+};
+
+static const struct attribute_group *xflex_pmu_attr_groups[] = {
+	&xflex_pmu_events_attr_group,
+	&xflex_pmu_format_attr_group,
+	&xflex_pmu_cpumask_attr_group,
+	NULL,
+};
+
+/**
+ * xflex_pmu_read_counter - Read the probe counter of a perf event
+ * @event: Pointer to the perf event
+ *
+ * Return: counter value, or the previous value if the firmware call fails
+ */
+static u64 xflex_pmu_read_counter(struct perf_event *event)
+{
+	struct xflex_dev_info *flexpm = to_xflex_pmu(event->pmu);
+	struct hw_perf_event *hwc = &event->hw;
+	u32 pm_api_ret[4] = {0, 0, 0, 0};
+	u32 domain;
+
+	domain = (event->attr.config & FPM_PMU_FPD) ? FPM_FPD : FPM_LPD;
+	if (flexpm->eemi_ops->ioctl(domain, IOCTL_PROBE_COUNTER_READ,
+				    hwc->config_base, 0, &pm_api_ret[0]) < 0)
+		return local64_read(&hwc->prev_count);
+
+	return pm_api_ret[1];
+}
+
+/**
+ * xflex_pmu_event_update - Accumulate the counter delta into a perf event
+ * @event: Pointer to the perf event
+ */
+static void xflex_pmu_event_update(struct perf_event *event)
+{
+	struct hw_perf_event *hwc = &event->hw;
+	u64 prev, now;
+
+	do {
+		prev = local64_read(&hwc->prev_count);
+		now = xflex_pmu_read_counter(event);
+	} while (local64_cmpxchg(&hwc->prev_count, prev, now) != prev);
+
+	local64_add((now - prev) & 0xffffffff, &event->count);
+}
+
+/**
+ * xflex_pmu_event_init - Validate a new perf event
+ * @event: Pointer to the perf event
+ *
+ * Return: 0 on success and failure value on error
+ */
+static int xflex_pmu_event_init(struct perf_event *event)
+{
+	struct xflex_dev_info *flexpm = to_xflex_pmu(event->pmu);
+	struct perf_event *sibling;
+	u32 src;
+
+	if (event->attr.type != event->pmu->type)
+		return -ENOENT;
+
+	if (is_sampling_event(event) || event->attach_state & PERF_ATTACH_TASK)
+		return -EOPNOTSUPP;
+
+	if (event->cpu < 0)
+		return -EOPNOTSUPP;
+
+	src = (event->attr.config >> FPM_PMU_SRC_SHIFT) & FPM_PMU_SRC_MASK;
+	if (event->attr.config & ~FPM_PMU_CONFIG_MASK || src > FPM_SRC_MAX)
+		return -EINVAL;
+
+	if (event->group_leader->pmu != event->pmu &&
+	    !is_software_event(event->group_leader))
+		return -EINVAL;
+
+	for_each_sibling_event(sibling, event->group_leader) {
+		if (sibling->pmu != event->pmu && !is_software_event(sibling))
+			return -EINVAL;
+	}
+
+	event->cpu = flexpm->cpu;
+	event->hw.idx = -1;
+
+	return 0;
+}
+
+/**
+ * xflex_pmu_event_start - Start counting a perf event
+ * @event: Pointer to the perf event
+ * @flags: Start flags
+ */
+static void xflex_pmu_event_start(struct perf_event *event, int flags)
+{
+	struct hw_perf_event *hwc = &event->hw;
+
+	local64_set(&hwc->prev_count, xflex_pmu_read_counter(event));
+	hwc->state = 0;
+}
+
+/**
+ * xflex_pmu_event_stop - Stop counting a perf event
+ * @event: Pointer to the perf event
+ * @flags: Stop flags
+ */
+static void xflex_pmu_event_stop(struct perf_event *event, int flags)
+{
+	struct hw_perf_event *hwc = &event->hw;
+
+	if (hwc->state & PERF_HES_STOPPED)
+		return;
+
+	xflex_pmu_event_update(event);
+	hwc->state |= PERF_HES_STOPPED | PERF_HES_UPTODATE;
+}
+
+/**
+ * xflex_pmu_event_add - Bind a perf event to its domain probe
+ * @event: Pointer to the perf event
+ * @flags: Add flags
+ *
+ * Return: 0 on success and failure value on error
+ */
+static int xflex_pmu_event_add(struct perf_event *event, int flags)
+{
+	struct xflex_dev_info *flexpm = to_xflex_pmu(event->pmu);
+	struct hw_perf_event *hwc = &event->hw;
+	u64 config = event->attr.config;
+	u32 probe, domain, counter;
+	int i, base, idx;
+
+	probe = config & FPM_PMU_PROBE_MASK;
+	base = (config & FPM_PMU_FPD) ? FPM_PMU_NUM_PROBES : 0;
+	idx = base + probe;
+	if (flexpm->events[idx])
+		return -EAGAIN;
+
+	/* The probes of a domain share the port and source selection */
+	for (i = base; i < base + FPM_PMU_NUM_PROBES; i++) {
+		struct perf_event *other = flexpm->events[i];
+
+		if (other && (other->attr.config & ~FPM_PMU_PROBE_MASK) !=
+			     (config & ~FPM_PMU_PROBE_MASK))
+			return -EAGAIN;
+	}
+
+	if (config & FPM_PMU_FPD) {
+		domain = FPM_FPD;
+		counter = flexpm->counterid_fpd;
+	} else {
+		domain = FPM_LPD;
+		counter = flexpm->counterid_lpd;
+	}
+
+	for (i = base; i < base + FPM_PMU_NUM_PROBES; i++)
+		if (flexpm->events[i])
+			break;
+	if (i == base + FPM_PMU_NUM_PROBES)
+		xflex_setup_counter(flexpm, counter, domain,
+				    (config >> FPM_PMU_PORT_SHIFT) &
+				    FPM_PMU_PORT_MASK,
+				    (config >> FPM_PMU_SRC_SHIFT) &
+				    FPM_PMU_SRC_MASK);
+
+	flexpm->events[idx] = event;
+	hwc->idx = idx;
+	hwc->config_base = counter | FPM_VAL |
+			   (FPM_RDREQ_L + (probe << FPM_PROBE_SHIFT));
+	hwc->state = PERF_HES_STOPPED | PERF_HES_UPTODATE;
+
+	if (flags & PERF_EF_START)
+		xflex_pmu_event_start(event, flags);
+
+	if (!flexpm->num_active++)
+		hrtimer_start(&flexpm->hrtimer,
+			      ns_to_ktime(FPM_PMU_POLL_PERIOD_NS),
+			      HRTIMER_MODE_REL_PINNED);
+
+	return 0;
+}
+
+/**
+ * xflex_pmu_event_del - Release the domain probe of a perf event
+ * @event: Pointer to the perf event
+ * @flags: Delete flags
+ */
+static void xflex_pmu_event_del(struct perf_event *event, int flags)
+{
+	struct xflex_dev_info *flexpm = to_xflex_pmu(event->pmu);
+	struct hw_perf_event *hwc = &event->hw;
+
+	xflex_pmu_event_stop(event, PERF_EF_UPDATE);
+
+	if (!--flexpm->num_active)
+		hrtimer_cancel(&flexpm->hrtimer);
+
+	flexpm->events[hwc->idx] = NULL;
+	hwc->idx = -1;
+}
+
+/**
+ * xflex_pmu_poll - Fold the counters into the perf events before they wrap
+ * @hrtimer: Pointer to the hrtimer
+ *
+ * Return: HRTIMER_RESTART always
+ */
+static enum hrtimer_restart xflex_pmu_poll(struct hrtimer *hrtimer)
+{
+	struct xflex_dev_info *flexpm = container_of(hrtimer,
+						     struct xflex_dev_info,
+						     hrtimer);
+	unsigned long flags;
+	int i;
+
+	local_irq_save(flags);
+	for (i = 0; i < FPM_PMU_NUM_EVENTS; i++) {
+		struct perf_event *event = flexpm->events[i];
+
+		if (event && !(event->hw.state & PERF_HES_STOPPED))
+			xflex_pmu_event_update(event);
+	}
+	local_irq_restore(flags);
+
+	hrtimer_forward_now(hrtimer, ns_to_ktime(FPM_PMU_POLL_PERIOD_NS));
+
+	return HRTIMER_RESTART;
+}
+
+/**
+ * xflex_pmu_register - Register the LPD and FPD probes as a perf PMU
+ * @flexpm: Pointer to the xflex_dev_info structure
+ *
+ * Return: 0 on success and failure value on error
+ */
+static int xflex_pmu_register(struct xflex_dev_info *flexpm)
+{
+	int ret;
+
+	flexpm->eemi_ops = zynqmp_pm_get_eemi_ops();
+	if (IS_ERR_OR_NULL(flexpm->eemi_ops) || !flexpm->eemi_ops->ioctl)
+		return -ENODEV;
+
+	flexpm->cpu = raw_smp_processor_id();
+	hrtimer_init(&flexpm->hrtimer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	flexpm->hrtimer.function = xflex_pmu_poll;
+
+	flexpm->pmu = (struct pmu) {
+		.module = THIS_MODULE,
+		.capabilities = PERF_PMU_CAP_NO_EXCLUDE,
+		.task_ctx_nr = perf_invalid_context,
+		.attr_groups = xflex_pmu_attr_groups,
+		.event_init = xflex_pmu_event_init,
+		.add = xflex_pmu_event_add,
+		.del = xflex_pmu_event_del,
+		.start = xflex_pmu_event_start,
+		.stop = xflex_pmu_event_stop,
+		.read = xflex_pmu_event_update,
+	};
+
+	ret = perf_pmu_register(&flexpm->pmu, "xlnx_flexnoc", -1);
+	if (ret)
+		return ret;
+
+	flexpm->pmu_registered = true;
+
+	return 0;
+}
+
+/**
+ * xflex_pmu_unregister - Unregister the perf PMU
+ * @flexpm: Pointer to the xflex_dev_info structure
+ */
+static void xflex_pmu_unregister(struct xflex_dev_info *flexpm)
+{
+	if (flexpm->pmu_registered)
+		perf_pmu_unregister(&flexpm->pmu);
+}
+#else
+static int xflex_pmu_register(struct xflex_dev_info *flexpm)
+{
+	return 0;
+}
+
+static void xflex_pmu_unregister(struct xflex_dev_info *flexpm)
+{
+}
+#endif
+
 /**
  * xflex_probe - Driver probe function
  * @pdev: Pointer to the platform_device structure
@@ -618,6 +1021,10 @@ static int xflex_probe(struct platform_device *pdev)
 
 	dev_set_drvdata(dev, flexpm);
 
+	err = xflex_pmu_register(flexpm);
+	if (err)
+		dev_warn(dev, "unable to register perf PMU %d\n", err);
+
 	return 0;
 }
 
@@ -631,6 +1038,7 @@ static int xflex_probe(struct platform_device *pdev)
  */
 static int xflex_remove(struct platform_device *pdev)
 {
+	xflex_pmu_unregister(to_xflex_dev_info(&pdev->dev));
 	sysfs_remove_groups(&pdev->dev.kobj, xflex_groups);
 	return 0;
 }
@@ -0,0 +1,535 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Xilinx HLS kernel
+ *
+ * Copyright (C) 2020 Xilinx, Inc.
+ *
+ * Description:
+ * This driver runs a Vitis HLS kernel with an s_axi_control interface and
+ * an ap_ctrl_hs or ap_ctrl_chain block protocol. The argument registers are
+ * listed by the device tree, so one driver serves any kernel:
+ *
+ *	xlnx,arg-offsets	offsets of the argument registers
+ *	xlnx,ap-ctrl-chain	the kernel has the ap_ctrl_chain protocol
+ *
+ * Jobs are queued in a ring shared with user space, see
+ * <uapi/misc/xilinx_hls_kernel.h>. The completion interrupt starts the next
+ * job, so a stream of jobs costs no system call per job. With ap_ctrl_chain
+ * the next job is started as soon as the kernel takes the arguments of the
+ * previous one (ap_ready), before that one is done.
+ */
+
+#include <linux/miscdevice.h>
+#include <linux/io.h>
+#include <linux/interrupt.h>
+#include <linux/io_uring.h>
+#include <linux/kernel.h>
+#include <linux/mm.h>
+#include <linux/module.h>
+#include <linux/of_platform.h>
+#include <linux/poll.h>
+#include <linux/slab.h>
+#include <linux/clk.h>
+#include <linux/compat.h>
+#include <linux/vmalloc.h>
+
+#include <uapi/misc/xilinx_hls_kernel.h>
+
+#define DEV_NAME_LEN 12
+
+static DEFINE_IDA(dev_nrs);
+
+/* Block level control register */
+#define XHLS_AP_CTRL		0x00
+#define XHLS_AP_START		BIT(0)
+#define XHLS_AP_DONE		BIT(1)
+#define XHLS_AP_IDLE		BIT(2)
+#define XHLS_AP_READY		BIT(3)
+#define XHLS_AP_CONTINUE	BIT(4)
+
+/* Global interrupt enable register */
+#define XHLS_GIE		0x04
+#define XHLS_GIE_EN		BIT(0)
+
+/* Interrupt enable and status registers, the status is toggle on write */
+#define XHLS_IER		0x08
+#define XHLS_ISR		0x0c
+#define XHLS_INT_DONE		BIT(0)
+#define XHLS_INT_READY		BIT(1)
+
+/* Time given to the jobs in flight when the device is closed */
+#define XHLS_DRAIN_TIMEOUT	HZ
+
+/**
+ * struct xhls_kernel - Driver data for an HLS kernel
+ * @miscdev: Misc device
+ * @dev: Device of the kernel
+ * @regs: s_axi_control registers
+ * @clk: Kernel clock
+ * @irq: Interrupt of the kernel
+ * @arg_offsets: Offsets of the argument registers
+ * @num_args: Number of argument registers
+ * @chain: The kernel has the ap_ctrl_chain protocol
+ * @ring: Job ring shared with user space
+ * @ring_size: Size of @ring
+ * @lock: Protects the job state below and the control registers
+ * @started: Jobs started, free running
+ * @head: Jobs completed, free running
+ * @ready: ap_ctrl_chain kernel ready for the arguments of a new job
+ * @stopping: No new job is started
+ * @waitq: Wait queue of the job completions
+ * @in_use: Bit 0 is set while the device is open
+ * @dev_id: Device number
+ * @dev_name: Device name
+ */
+struct xhls_kernel {
+	struct miscdevice miscdev;
+	struct device *dev;
+	void __iomem *regs;
+	struct clk *clk;
+	int irq;
+	u32 *arg_offsets;
+	u32 num_args;
+	bool chain;
+	struct xhls_ring *ring;
+	size_t ring_size;
+	/* Job state, protected by lock */
+	spinlock_t lock;
+	u32 started;
+	u32 head;
+	bool ready;
+	bool stopping;
+	wait_queue_head_t waitq;
+	unsigned long in_use;
+	int dev_id;
+	char dev_name[DEV_NAME_LEN];
+};
+
+static inline struct xhls_kernel *file_to_xhls(struct file *fptr)
+{
+	return container_of(fptr->private_data, struct xhls_kernel, miscdev);
+}
+
+/**
+ * xhls_start_job - Start the next queued job
+ * @xhls: HLS kernel
+ *
+ * Called with the lock held, when the kernel can take a new job.
+ *
+ * Return: true if a job was started
+ */
+static bool xhls_start_job(struct xhls_kernel *xhls)
+{
+	struct xhls_ring *ring = xhls->ring;
+	const u32 *args;
+	u32 tail, i;
+
+	if (xhls->stopping)
+		return false;
+
+	/* Pairs with the release of the tail by user space */
+	tail = smp_load_acquire(&ring->tail);
+	if (tail == xhls->started)
+		return false;
+	/* A tail lapping the head would overwrite jobs not run yet */
+	if (tail - xhls->head > XHLS_RING_JOBS) {
+		dev_warn_ratelimited(xhls->dev,
+				     "ring overrun, tail %u head %u\n",
+				     tail, xhls->head);
+		return false;
+	}
+
+	args = &ring->args[(xhls->started % XHLS_RING_JOBS) * xhls->num_args];
+	for (i = 0; i < xhls->num_args; i++)
+		writel(READ_ONCE(args[i]), xhls->regs + xhls->arg_offsets[i]);
+	writel(XHLS_AP_START, xhls->regs + XHLS_AP_CTRL);
+
+	xhls->started++;
+	xhls->ready = false;
+	return true;
+}
+
+/**
+ * xhls_kick - Start the next queued job if the kernel can take it
+ * @xhls: HLS kernel
+ *
+ * Called with the lock held. When no job is in flight and none is queued,
+ * running is cleared for user space to kick the next job, and the tail is
+ * read again to catch a job queued before user space saw the clear.
+ */
+static void xhls_kick(struct xhls_kernel *xhls)
+{
+	struct xhls_ring *ring = xhls->ring;
+
+	if (xhls->chain ? !xhls->ready : xhls->started != xhls->head)
+		return;
+
+	if (xhls_start_job(xhls)) {
+		WRITE_ONCE(ring->running, 1);
+		return;
+	}
+
+	/* A completion in flight picks the next job up */
+	if (xhls->started != xhls->head)
+		return;
+
+	WRITE_ONCE(ring->running, 0);
+	/* Pairs with the barrier of user space between the tail and running */
+	smp_mb();
+	if (xhls_start_job(xhls))
+		WRITE_ONCE(ring->running, 1);
+}
+
+static irqreturn_t xhls_irq(int irq, void *data)
+{
+	struct xhls_kernel *xhls = data;
+	u32 isr;
+
+	isr = readl(xhls->regs + XHLS_ISR);
+	if (!isr)
+		return IRQ_NONE;
+	writel(isr, xhls->regs + XHLS_ISR);
+
+	spin_lock(&xhls->lock);
+	if (isr & XHLS_INT_READY)
+		xhls->ready = true;
+	if (isr & XHLS_INT_DONE) {
+		/* ap_done stays set until acknowledged, one job per done */
+		if (xhls->chain)
+			writel(XHLS_AP_CONTINUE, xhls->regs + XHLS_AP_CTRL);
+		WRITE_ONCE(xhls->head, xhls->head + 1);
+		smp_store_release(&xhls->ring->head, xhls->head);
+		wake_up(&xhls->waitq);
+	}
+	xhls_kick(xhls);
+	spin_unlock(&xhls->lock);
+
+	return IRQ_HANDLED;
+}
+
+static void xhls_irq_enable(struct xhls_kernel *xhls, bool enable)
+{
+	u32 ier = 0;
+
+	if (enable)
+		ier = xhls->chain ? XHLS_INT_DONE | XHLS_INT_READY :
+				    XHLS_INT_DONE;
+
+	writel(ier, xhls->regs + XHLS_IER);
+	writel(enable ? XHLS_GIE_EN : 0, xhls->regs + XHLS_GIE);
+}
+
+static int xhls_dev_open(struct inode *iptr, struct file *fptr)
+{
+	struct xhls_kernel *xhls = file_to_xhls(fptr);
+	struct xhls_ring *ring = xhls->ring;
+	u32 ctrl;
+
+	/* One ring, so one user */
+	if (test_and_set_bit(0, &xhls->in_use))
+		return -EBUSY;
+
+	ctrl = readl(xhls->regs + XHLS_AP_CTRL);
+	if (!(ctrl & XHLS_AP_IDLE)) {
+		dev_dbg(xhls->dev, "kernel not idle, ctrl 0x%x\n", ctrl);
+		clear_bit(0, &xhls->in_use);
+		return -EBUSY;
+	}
+
+	spin_lock_irq(&xhls->lock);
+	ring->tail = 0;
+	ring->head = 0;
+	ring->running = 0;
+	xhls->started = 0;
+	xhls->head = 0;
+	xhls->ready = true;
+	xhls->stopping = false;
+	/* A done left from a previous user would complete a job */
+	writel(readl(xhls->regs + XHLS_ISR), xhls->regs + XHLS_ISR);
+	xhls_irq_enable(xhls, true);
+	spin_unlock_irq(&xhls->lock);
+
+	return 0;
+}
+
+static int xhls_dev_release(struct inode *iptr, struct file *fptr)
+{
+	struct xhls_kernel *xhls = file_to_xhls(fptr);
+
+	spin_lock_irq(&xhls->lock);
+	xhls->stopping = true;
+	spin_unlock_irq(&xhls->lock);
+
+	/* The jobs in flight can't be aborted, let them complete */
+	if (!wait_event_timeout(xhls->waitq,
+				READ_ONCE(xhls->head) == xhls->started,
+				XHLS_DRAIN_TIMEOUT))
+		dev_warn(xhls->dev, "%u jobs still in flight\n",
+			 xhls->started - READ_ONCE(xhls->head));
+
+	spin_lock_irq(&xhls->lock);
+	xhls_irq_enable(xhls, false);
+	spin_unlock_irq(&xhls->lock);
+
+	clear_bit(0, &xhls->in_use);
+	return 0;
+}
+
+static int xhls_dev_mmap(struct file *fptr, struct vm_area_struct *vma)
+{
+	struct xhls_kernel *xhls = file_to_xhls(fptr);
+
+	return remap_vmalloc_range(vma, xhls->ring, vma->vm_pgoff);
+}
+
+static bool xhls_reached(struct xhls_kernel *xhls, u32 seq)
+{
+	return (s32)(READ_ONCE(xhls->head) - seq) >= 0;
+}
+
+static int xhls_wait(struct xhls_kernel *xhls, void __user *arg, bool nonblock)
+{
+	u32 seq;
+
+	if (copy_from_user(&seq, arg, sizeof(seq)))
+		return -EFAULT;
+
+	if (xhls_reached(xhls, seq))
+		return 0;
+	if (nonblock)
+		return -EAGAIN;
+
+	return wait_event_interruptible(xhls->waitq, xhls_reached(xhls, seq));
+}
+
+static int xhls_get_info(struct xhls_kernel *xhls, void __user *arg)
+{
+	struct xhls_info info = {
+		.num_args = xhls->num_args,
+		.ring_jobs = XHLS_RING_JOBS,
+		.ring_size = xhls->ring_size,
+	};
+
+	if (copy_to_user(arg, &info, sizeof(info)))
+		return -EFAULT;
+
+	return 0;
+}
+
+static long xhls_ioctl(struct file *fptr, unsigned int cmd,
+		       unsigned long data, bool nonblock)
+{
+	struct xhls_kernel *xhls = file_to_xhls(fptr);
+	void __user *arg = (void __user *)data;
+
+	switch (cmd) {
+	case XHLS_KICK:
+		spin_lock_irq(&xhls->lock);
+		xhls_kick(xhls);
+		spin_unlock_irq(&xhls->lock);
+		return 0;
+	case XHLS_WAIT:
+		return xhls_wait(xhls, arg, nonblock);
+	case XHLS_GET_INFO:
+		return xhls_get_info(xhls, arg);
+	default:
+		return -ENOTTY;
+	}
+}
+
+static long xhls_dev_ioctl(struct file *fptr, unsigned int cmd,
+			   unsigned long data)
+{
+	return xhls_ioctl(fptr, cmd, data, fptr->f_flags & O_NONBLOCK);
+}
+
+/* Only a wait for jobs not done yet blocks, it goes to an async worker */
+static long xhls_dev_uring_cmd(struct file *fptr, unsigned int cmd,
+			       unsigned long data, unsigned int issue_flags)
+{
+	return xhls_ioctl(fptr, cmd, data, issue_flags & IO_URING_F_NONBLOCK);
+}
+
+#ifdef CONFIG_COMPAT
+static long xhls_dev_compat_ioctl(struct file *fptr, unsigned int cmd,
+				  unsigned long data)
+{
+	return xhls_dev_ioctl(fptr, cmd, (unsigned long)compat_ptr(data));
+}
+#endif
+
+/* Readable once all the queued jobs are done */
+static __poll_t xhls_poll(struct file *fptr, poll_table *wait)
+{
+	struct xhls_kernel *xhls = file_to_xhls(fptr);
+
+	poll_wait(fptr, &xhls->waitq, wait);
+
+	if (READ_ONCE(xhls->head) == READ_ONCE(xhls->ring->tail))
+		return EPOLLIN | EPOLLRDNORM;
+
+	return 0;
+}
+
+static const struct file_operations xhls_fops = {
+	.owner = THIS_MODULE,
+	.open = xhls_dev_open,
+	.release = xhls_dev_release,
+	.mmap = xhls_dev_mmap,
+	.unlocked_ioctl = xhls_dev_ioctl,
+	.uring_cmd = xhls_dev_uring_cmd,
+	.poll = xhls_poll,
+#ifdef CONFIG_COMPAT
+	.compat_ioctl = xhls_dev_compat_ioctl,
+#endif
+};
+
+static int xhls_parse_of(struct xhls_kernel *xhls)
+{
+	struct device *dev = xhls->dev;
+	struct device_node *node = dev->of_node;
+	int num_args, ret;
+
+	num_args = of_property_count_u32_elems(node, "xlnx,arg-offsets");
+	if (num_args < 0) {
+		dev_err(dev, "no xlnx,arg-offsets: %d\n", num_args);
+		return num_args;
+	}
+
+	xhls->arg_offsets = devm_kcalloc(dev, num_args,
+					 sizeof(*xhls->arg_offsets),
+					 GFP_KERNEL);
+	if (!xhls->arg_offsets)
+		return -ENOMEM;
+
+	ret = of_property_read_u32_array(node, "xlnx,arg-offsets",
+					 xhls->arg_offsets, num_args);
+	if (ret)
+		return ret;
+
+	xhls->num_args = num_args;
+	xhls->chain = of_property_read_bool(node, "xlnx,ap-ctrl-chain");
+
+	return 0;
+}
+
+static int xhls_probe(struct platform_device *pdev)
+{
+	struct device *dev = &pdev->dev;
+	struct xhls_kernel *xhls;
+	struct resource *res;
+	size_t size;
+	int err;
+
+	xhls = devm_kzalloc(dev, sizeof(*xhls), GFP_KERNEL);
+	if (!xhls)
+		return -ENOMEM;
+
+	xhls->dev = dev;
+	spin_lock_init(&xhls->lock);
+	init_waitqueue_head(&xhls->waitq);
+
+	res = platform_get_resource(pdev, IORESOURCE_MEM, 0);
+	xhls->regs = devm_ioremap_resource(dev, res);
+	if (IS_ERR(xhls->regs))
+		return PTR_ERR(xhls->regs);
+
+	xhls->irq = platform_get_irq(pdev, 0);
+	if (xhls->irq < 0)
+		return xhls->irq;
+
+	err = xhls_parse_of(xhls);
+	if (err)
+		return err;
+
+	xhls->clk = devm_clk_get_optional(dev, "ap_clk");
+	if (IS_ERR(xhls->clk)) {
+		err = PTR_ERR(xhls->clk);
+		if (err != -EPROBE_DEFER)
+			dev_err(dev, "failed to get ap_clk: %d\n", err);
+		return err;
+	}
+
+	size = struct_size(xhls->ring, args, XHLS_RING_JOBS * xhls->num_args);
+	xhls->ring_size = PAGE_ALIGN(size);
+	xhls->ring = vmalloc_user(xhls->ring_size);
+	if (!xhls->ring)
+		return -ENOMEM;
+	xhls->ring->num_args = xhls->num_args;
+
+	err = clk_prepare_enable(xhls->clk);
+	if (err)
+		goto err_ring;
+
+	/* Nothing is enabled until the device is opened */
+	xhls_irq_enable(xhls, false);
+
+	err = devm_request_irq(dev, xhls->irq, xhls_irq, IRQF_SHARED,
+			       "xilinx-hls-kernel", xhls);
+	if (err) {
+		dev_err(dev, "unable to request IRQ%d\n", xhls->irq);
+		goto err_clk;
+	}
+
+	platform_set_drvdata(pdev, xhls);
+
+	err = ida_alloc(&dev_nrs, GFP_KERNEL);
+	if (err < 0)
+		goto err_clk;
+	xhls->dev_id = err;
+
+	snprintf(xhls->dev_name, DEV_NAME_LEN, "xhls%d", xhls->dev_id);
+	xhls->miscdev.minor = MISC_DYNAMIC_MINOR;
+	xhls->miscdev.name = xhls->dev_name;
+	xhls->miscdev.fops = &xhls_fops;
+	xhls->miscdev.parent = dev;
+	err = misc_register(&xhls->miscdev);
+	if (err) {
+		dev_err(dev, "error:%d. Unable to register device", err);
+		goto err_ida;
+	}
+
+	dev_info(dev, "%s: %u arguments, ap_ctrl_%s\n", xhls->dev_name,
+		 xhls->num_args, xhls->chain ? "chain" : "hs");
+	return 0;
+
+err_ida:
+	ida_free(&dev_nrs, xhls->dev_id);
+err_clk:
+	clk_disable_unprepare(xhls->clk);
+err_ring:
+	vfree(xhls->ring);
+	return err;
+}
+
+static int xhls_remove(struct platform_device *pdev)
+{
+	struct xhls_kernel *xhls = platform_get_drvdata(pdev);
+
+	misc_deregister(&xhls->miscdev);
+	ida_free(&dev_nrs, xhls->dev_id);
+	devm_free_irq(&pdev->dev, xhls->irq, xhls);
+	clk_disable_unprepare(xhls->clk);
+	vfree(xhls->ring);
+	return 0;
+}
+
+static const struct of_device_id xhls_of_match[] = {
+	{ .compatible = "xlnx,hls-kernel-1.0", },
+	{ /* end of table */ }
+};
+MODULE_DEVICE_TABLE(of, xhls_of_match);
+
+static struct platform_driver xhls_driver = {
+	.driver = {
+		.name = "xilinx-hls-kernel",
+		.of_match_table = xhls_of_match,
+	},
+	.probe = xhls_probe,
+	.remove = xhls_remove,
+};
+module_platform_driver(xhls_driver);
+
+MODULE_AUTHOR("Xilinx, Inc");
+MODULE_DESCRIPTION("Xilinx HLS Kernel Job Ring Driver");
+MODULE_LICENSE("GPL");
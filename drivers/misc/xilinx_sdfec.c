@@ -20,7 +20,7 @@
 #include <linux/slab.h>
 #include <linux/clk.h>
 #include <linux/compat.h>
-#include <linux/highmem.h>
+#include <linux/string.h>
 
 #include <uapi/misc/xilinx_sdfec.h>
 
@@ -161,9 +161,6 @@ static DEFINE_IDA(dev_nrs);
 #define XSDFEC_LDPC_REG_JUMP (0x10)
 #define XSDFEC_REG_WIDTH_JUMP (4)
 
-/* The maximum number of pinned pages */
-#define MAX_NUM_PAGES ((XSDFEC_QC_TABLE_DEPTH / PAGE_SIZE) + 1)
-
 /**
  * struct xsdfec_clks - For managing SD-FEC clocks
  * @core_clk: Main processing clock for core
@@ -601,11 +598,7 @@ static int xsdfec_table_write(struct xsdfec_dev *xsdfec, u32 offset,
 			      u32 *src_ptr, u32 len, const u32 base_addr,
 			      const u32 depth)
 {
-	u32 reg = 0;
-	u32 res;
-	u32 n, i;
-	u32 *addr = NULL;
-	struct page *page[MAX_NUM_PAGES];
+	u32 *table;
 
 	/*
 	 * Writes that go beyond the length of
@@ -618,30 +611,17 @@ static int xsdfec_table_write(struct xsdfec_dev *xsdfec, u32 offset,
 		return -EINVAL;
 	}
 
-	n = (len * XSDFEC_REG_WIDTH_JUMP) / PAGE_SIZE;
-	if ((len * XSDFEC_REG_WIDTH_JUMP) % PAGE_SIZE)
-		n += 1;
-
-	res = get_user_pages_fast((unsigned long)src_ptr, n, 0, page);
-	if (res < n) {
-		for (i = 0; i < res; i++)
-			put_page(page[i]);
+	/* Copy the whole table in once and burst it into the core */
+	table = memdup_user((void __user *)src_ptr,
+			    len * XSDFEC_REG_WIDTH_JUMP);
+	if (IS_ERR(table))
 		return -EINVAL;
-	}
 
-	for (i = 0; i < n; i++) {
-		addr = kmap(page[i]);
-		do {
-			xsdfec_regwrite(xsdfec,
-					base_addr + ((offset + reg) *
-						     XSDFEC_REG_WIDTH_JUMP),
-					addr[reg]);
-			reg++;
-		} while ((reg < len) &&
-			 ((reg * XSDFEC_REG_WIDTH_JUMP) % PAGE_SIZE));
-		put_page(page[i]);
-	}
-	return reg;
+	__iowrite32_copy(xsdfec->regs + base_addr +
+			 offset * XSDFEC_REG_WIDTH_JUMP, table, len);
+	kfree(table);
+
+	return len;
 }
 
 static int xsdfec_add_ldpc(struct xsdfec_dev *xsdfec, void __user *arg)
@@ -1017,6 +997,13 @@ static long xsdfec_dev_ioctl(struct file *fptr, unsigned int cmd,
 	return rval;
 }
 
+/* All the commands are register accesses which never block */
+static long xsdfec_dev_uring_cmd(struct file *fptr, unsigned int cmd,
+				 unsigned long data, unsigned int issue_flags)
+{
+	return xsdfec_dev_ioctl(fptr, cmd, data);
+}
+
 #ifdef CONFIG_COMPAT
 static long xsdfec_dev_compat_ioctl(struct file *file, unsigned int cmd,
 				    unsigned long data)
@@ -1054,6 +1041,7 @@ static const struct file_operations xsdfec_fops = {
 	.open = xsdfec_dev_open,
 	.release = xsdfec_dev_release,
 	.unlocked_ioctl = xsdfec_dev_ioctl,
+	.uring_cmd = xsdfec_dev_uring_cmd,
 	.poll = xsdfec_poll,
 #ifdef CONFIG_COMPAT
 	.compat_ioctl = xsdfec_dev_compat_ioctl,
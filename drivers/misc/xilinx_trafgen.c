@@ -18,7 +18,10 @@
 #include <linux/init.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
+#include <linux/iopoll.h>
+#include <linux/ktime.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
 #include <linux/of_platform.h>
 #include <linux/of_address.h>
 #include <linux/of_irq.h>
@@ -196,6 +199,8 @@
 #define CMD_WDS	0x4	/* No of words in command ram per command */
 #define EXT_WDS	0x1	/* No of words in extended ram per command */
 #define MSB_INDEX	0x4
+
+#define XTG_RUN_POLL_US		10	/* Master run completion poll period */
 /**
  * struct xtg_cram - Command RAM structure
  * @addr: Address Driven to a*_addr line
@@ -286,6 +291,12 @@ struct xtg_pram {
  * @id: Device instance id
  * @xtg_mram_offset: MasterRam offset
  * @clk: Input clock
+ * @run_lock: Serializes timed master runs and their statistics
+ * @run_count: Number of completed timed runs
+ * @run_last_ns: Duration of the last timed run
+ * @run_min_ns: Shortest timed run
+ * @run_max_ns: Longest timed run
+ * @run_total_ns: Accumulated duration of the timed runs
  */
 struct xtg_dev_info {
 	void __iomem *regs;
@@ -296,6 +307,12 @@ struct xtg_dev_info {
 	u32 id;
 	u32 xtg_mram_offset;
 	struct clk *clk;
+	struct mutex run_lock; /* serializes timed runs */
+	u32 run_count;
+	u64 run_last_ns;
+	u64 run_min_ns;
+	u64 run_max_ns;
+	u64 run_total_ns;
 };
 
 /**
@@ -1171,6 +1188,104 @@ static ssize_t loop_enable_store(struct device *dev,
 }
 static DEVICE_ATTR_RW(loop_enable);
 
+static ssize_t master_run_show(struct device *dev,
+			       struct device_attribute *attr, char *buf)
+{
+	struct xtg_dev_info *tg = to_xtg_dev_info(dev);
+
+	return snprintf(buf, PAGE_SIZE, "%llu\n", tg->run_last_ns);
+}
+
+/*
+ * Start the master logic on the loaded command and parameter RAMs and wait,
+ * up to the written number of milliseconds, for it to complete. The elapsed
+ * time is reported back through master_run and master_run_stats.
+ */
+static ssize_t master_run_store(struct device *dev,
+				struct device_attribute *attr,
+				const char *buf, size_t size)
+{
+	struct xtg_dev_info *tg = to_xtg_dev_info(dev);
+	unsigned long timeout_ms;
+	ktime_t start;
+	u64 elapsed;
+	u32 val;
+	int ret;
+
+	ret = kstrtoul(buf, 0, &timeout_ms);
+	if (ret < 0)
+		return ret;
+
+	if (!timeout_ms)
+		return -EINVAL;
+
+	mutex_lock(&tg->run_lock);
+
+	if (readl(tg->regs + XTG_MCNTL_OFFSET) & XTG_MCNTL_MSTEN_MASK) {
+		ret = -EBUSY;
+		goto out_unlock;
+	}
+
+	start = ktime_get();
+	writel(readl(tg->regs + XTG_MCNTL_OFFSET) | XTG_MCNTL_MSTEN_MASK,
+	       tg->regs + XTG_MCNTL_OFFSET);
+	ret = readl_poll_timeout(tg->regs + XTG_MCNTL_OFFSET, val,
+				 !(val & XTG_MCNTL_MSTEN_MASK),
+				 XTG_RUN_POLL_US, timeout_ms * USEC_PER_MSEC);
+	elapsed = ktime_to_ns(ktime_sub(ktime_get(), start));
+	if (ret)
+		goto out_unlock;
+
+	tg->run_last_ns = elapsed;
+	tg->run_total_ns += elapsed;
+	if (!tg->run_count++ || elapsed < tg->run_min_ns)
+		tg->run_min_ns = elapsed;
+	if (elapsed > tg->run_max_ns)
+		tg->run_max_ns = elapsed;
+
+	if (readl(tg->regs + XTG_ERR_STS_OFFSET) & XTG_ERR_ALL_ERRS_MASK &
+	    ~XTG_ERR_STS_MSTDONE_MASK)
+		ret = -EIO;
+
+out_unlock:
+	mutex_unlock(&tg->run_lock);
+
+	return ret ? ret : size;
+}
+static DEVICE_ATTR_RW(master_run);
+
+static ssize_t master_run_stats_show(struct device *dev,
+				     struct device_attribute *attr, char *buf)
+{
+	struct xtg_dev_info *tg = to_xtg_dev_info(dev);
+	ssize_t len;
+
+	mutex_lock(&tg->run_lock);
+	len = snprintf(buf, PAGE_SIZE, "%u %llu %llu %llu\n", tg->run_count,
+		       tg->run_min_ns, tg->run_max_ns, tg->run_total_ns);
+	mutex_unlock(&tg->run_lock);
+
+	return len;
+}
+
+static ssize_t master_run_stats_store(struct device *dev,
+				      struct device_attribute *attr,
+				      const char *buf, size_t size)
+{
+	struct xtg_dev_info *tg = to_xtg_dev_info(dev);
+
+	mutex_lock(&tg->run_lock);
+	tg->run_count = 0;
+	tg->run_last_ns = 0;
+	tg->run_min_ns = 0;
+	tg->run_max_ns = 0;
+	tg->run_total_ns = 0;
+	mutex_unlock(&tg->run_lock);
+
+	return size;
+}
+static DEVICE_ATTR_RW(master_run_stats);
+
 static ssize_t xtg_pram_read(struct file *filp, struct kobject *kobj,
 			     struct bin_attribute *bin_attr,
 			     char *buf, loff_t off, size_t count)
@@ -1189,41 +1304,47 @@ static ssize_t xtg_pram_write(struct file *filp, struct kobject *kobj,
 	u32 *data = (u32 *)buf;
 	struct xtg_pram *cmdp = (struct xtg_pram *)buf;
 	u32 param_word;
+	size_t i, n;
 
 	if (off >= XTG_PARAM_RAM_SIZE) {
 		pr_err("Requested Write len exceeds 2K PRAM size\n");
 		return -ENOMEM;
 	}
 
-	if (count >= XTG_PARAM_RAM_SIZE)
-		count = XTG_PARAM_RAM_SIZE;
-
-	/* Program each command */
-	if (count == sizeof(struct xtg_pram)) {
-
-		if (!cmdp)
-			return -EINVAL;
-
-		if (cmdp->is_valid_req == VALID_SIG) {
-			/* Prepare parameter word */
-			xtg_prepare_param_word(tg, cmdp, &param_word);
-
-			count = XTG_PRAM_BYTES_PER_ENTRY;
-			data = &param_word;
-
+	/*
+	 * Program each command. A write can carry a whole table of entries,
+	 * which are all validated before the RAM is touched.
+	 */
+	n = count / sizeof(*cmdp);
+	if (n && count == n * sizeof(*cmdp) &&
+	    cmdp->is_valid_req == VALID_SIG) {
+		for (i = 0; i < n; i++) {
 			/* Maximum command entries are 256 */
-			if (cmdp->index > MAX_NUM_ENTRIES)
+			if (cmdp[i].is_valid_req != VALID_SIG ||
+			    cmdp[i].index >= MAX_NUM_ENTRIES)
 				return -EINVAL;
+		}
+
+		for (i = 0; i < n; i++) {
+			/* Prepare parameter word */
+			xtg_prepare_param_word(tg, &cmdp[i], &param_word);
 
 			/* Calculate the block index */
-			if (cmdp->is_write_block)
-				off = XTG_PRM_RAM_BLOCK_SIZE +
-						cmdp->index * count;
-			else
-				off = cmdp->index * count;
+			off = cmdp[i].index * XTG_PRAM_BYTES_PER_ENTRY;
+			if (cmdp[i].is_write_block)
+				off += XTG_PRM_RAM_BLOCK_SIZE;
+
+			xtg_access_rams(tg, XTG_PARAM_RAM_OFFSET + off,
+					XTG_PRAM_BYTES_PER_ENTRY,
+					XTG_WRITE_RAM, &param_word);
 		}
+
+		return count;
 	}
 
+	if (count >= XTG_PARAM_RAM_SIZE)
+		count = XTG_PARAM_RAM_SIZE;
+
 	off += XTG_PARAM_RAM_OFFSET;
 	xtg_access_rams(tg, off, count, XTG_WRITE_RAM, data);
 
@@ -1280,45 +1401,50 @@ static ssize_t xtg_cram_write(struct file *filp, struct kobject *kobj,
 	u32 *data = (u32 *)buf;
 	struct xtg_cram *cmdp = (struct xtg_cram *)buf;
 	u32 cmd_words[CMD_WDS + EXT_WDS];
+	size_t i, n;
 
 	if (off >= XTG_COMMAND_RAM_SIZE) {
 		pr_err("Requested Write len exceeds 8K CRAM size\n");
 		return -ENOMEM;
 	}
 
-	/* Program each command */
-	if (count == sizeof(struct xtg_cram)) {
-
-		if (!cmdp)
-			return -EINVAL;
-
-		if (cmdp->is_valid_req == VALID_SIG) {
-			/* Prepare command words */
-			xtg_prepare_cmd_words(tg, cmdp, cmd_words);
-			count = XTG_CRAM_BYTES_PER_ENTRY;
-			data = cmd_words;
-
+	/*
+	 * Program each command. A write can carry a whole table of entries,
+	 * which are all validated before the RAM is touched.
+	 */
+	n = count / sizeof(*cmdp);
+	if (n && count == n * sizeof(*cmdp) &&
+	    cmdp->is_valid_req == VALID_SIG) {
+		for (i = 0; i < n; i++) {
 			/* Maximum command entries are 256 */
-			if (cmdp->index > MAX_NUM_ENTRIES)
+			if (cmdp[i].is_valid_req != VALID_SIG ||
+			    cmdp[i].index >= MAX_NUM_ENTRIES)
 				return -EINVAL;
+		}
+
+		for (i = 0; i < n; i++) {
+			/* Prepare command words */
+			xtg_prepare_cmd_words(tg, &cmdp[i], cmd_words);
 
 			/* Calculate the block index */
-			if (cmdp->is_write_block)
-				off = XTG_CMD_RAM_BLOCK_SIZE +
-						cmdp->index * count;
-			else
-				off = cmdp->index * count;
+			off = cmdp[i].index * XTG_CRAM_BYTES_PER_ENTRY;
+			if (cmdp[i].is_write_block)
+				off += XTG_CMD_RAM_BLOCK_SIZE;
+
+			xtg_access_rams(tg, XTG_COMMAND_RAM_OFFSET + off,
+					XTG_CRAM_BYTES_PER_ENTRY,
+					XTG_WRITE_RAM, cmd_words);
 
 			/* Store the valid command index */
-			if (cmdp->valid_cmd) {
-				if (cmdp->is_write_block)
-					tg->last_wr_valid_idx =
-							cmdp->index;
+			if (cmdp[i].valid_cmd) {
+				if (cmdp[i].is_write_block)
+					tg->last_wr_valid_idx = cmdp[i].index;
 				else
-					tg->last_rd_valid_idx =
-							cmdp->index;
+					tg->last_rd_valid_idx = cmdp[i].index;
 			}
 		}
+
+		return count;
 	}
 
 	off += XTG_COMMAND_RAM_OFFSET;
@@ -1449,6 +1575,8 @@ static const struct attribute *xtg_attrs[] = {
 	&dev_attr_stream_enable.attr,
 	&dev_attr_reset_static_transferdone.attr,
 	&dev_attr_loop_enable.attr,
+	&dev_attr_master_run.attr,
+	&dev_attr_master_run_stats.attr,
 	NULL,
 };
 
@@ -1522,6 +1650,7 @@ static int xtg_probe(struct platform_device *pdev)
 	tg->dev = &pdev->dev;
 	dev = tg->dev;
 	node = pdev->dev.of_node;
+	mutex_init(&tg->run_lock);
 
 	/* Map the registers */
 	res = platform_get_resource(pdev, IORESOURCE_MEM, 0);
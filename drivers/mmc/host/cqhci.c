@@ -266,6 +266,13 @@ static void __cqhci_enable(struct cqhci_host *cq_host)
 
 	cqhci_writel(cq_host, cq_host->rca, CQHCI_SSC2);
 
+	if (cq_host->ic_thresh)
+		cqhci_writel(cq_host, CQHCI_IC_ENABLE | CQHCI_IC_ICCTHWEN |
+			     CQHCI_IC_ICCTH(cq_host->ic_thresh) |
+			     CQHCI_IC_ICTOVALWEN |
+			     CQHCI_IC_ICTOVAL(cq_host->ic_timeout),
+			     CQHCI_IC);
+
 	cqhci_set_irqs(cq_host, 0);
 
 	cqcfg |= CQHCI_ENABLE;
@@ -588,7 +595,8 @@ static int cqhci_request(struct mmc_host *mmc, struct mmc_request *mrq)
 
 	if (mrq->data) {
 		task_desc = (__le64 __force *)get_desc(cq_host, tag);
-		cqhci_prep_task_desc(mrq, &data, 1);
+		/* leave the completion interrupt to the coalescing logic */
+		cqhci_prep_task_desc(mrq, &data, !cq_host->ic_thresh);
 		*task_desc = cpu_to_le64(data);
 		err = cqhci_prep_tran_desc(mrq, cq_host, tag);
 		if (err) {
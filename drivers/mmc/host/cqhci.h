@@ -165,6 +165,10 @@ struct cqhci_host {
 	u32 quirks;
 #define CQHCI_QUIRK_SHORT_TXFR_DESC_SZ	0x1
 
+	/* interrupt coalescing counter threshold and timeout, 0 disables */
+	u32 ic_thresh;
+	u32 ic_timeout;
+
 	bool enabled;
 	bool halted;
 	bool init_done;
@@ -1402,6 +1402,14 @@ static int sdhci_arasan_add_host(struct sdhci_arasan_data *sdhci_arasan)
 	if (dma64)
 		cq_host->caps |= CQHCI_TASK_DESC_SZ_128;
 
+	/* Optional interrupt coalescing of the task completions */
+	of_property_read_u32(host->mmc->parent->of_node,
+			     "xlnx,cqe-ic-threshold", &cq_host->ic_thresh);
+	of_property_read_u32(host->mmc->parent->of_node,
+			     "xlnx,cqe-ic-timeout", &cq_host->ic_timeout);
+	if (cq_host->ic_thresh && !cq_host->ic_timeout)
+		cq_host->ic_timeout = CQHCI_IC_DEFAULT_ICTOVAL;
+
 	ret = cqhci_init(cq_host, host->mmc, dma64);
 	if (ret)
 		goto cleanup;
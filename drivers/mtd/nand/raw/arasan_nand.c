@@ -363,40 +363,6 @@ static void anfc_prepare_cmd(struct nand_chip *chip, u8 cmd1,
 	writel(regval, nfc->base + CMD_OFST);
 }
 
-static void anfc_rw_dma_op(struct mtd_info *mtd, u8 *buf, int len,
-			   bool do_read, u32 prog, int pktcount, int pktsize)
-{
-	dma_addr_t paddr;
-	struct nand_chip *chip = mtd_to_nand(mtd);
-	struct anfc_nand_controller *nfc = to_anfc(chip->controller);
-	struct anfc_nand_chip *achip = to_anfc_nand(chip);
-	u32 eccintr = 0, dir;
-
-	if (pktsize == 0)
-		pktsize = len;
-
-	anfc_setpktszcnt(nfc, pktsize, pktcount);
-
-	if (!achip->strength)
-		eccintr = MBIT_ERROR;
-
-	if (do_read)
-		dir = DMA_FROM_DEVICE;
-	else
-		dir = DMA_TO_DEVICE;
-	paddr = dma_map_single(nfc->dev, buf, len, dir);
-	if (dma_mapping_error(nfc->dev, paddr)) {
-		dev_err(nfc->dev, "Read buffer mapping error");
-		return;
-	}
-	writel(paddr, nfc->base + DMA_ADDR0_OFST);
-	writel((paddr >> 32), nfc->base + DMA_ADDR1_OFST);
-	anfc_enable_intrs(nfc, (XFER_COMPLETE | eccintr));
-	writel(prog, nfc->base + PROG_OFST);
-	anfc_wait_for_event(nfc);
-	dma_unmap_single(nfc->dev, paddr, len, dir);
-}
-
 static void anfc_rw_pio_op(struct mtd_info *mtd, u8 *buf, int len,
 			   bool do_read, int prog, int pktcount, int pktsize)
 {
@@ -440,6 +406,42 @@ static void anfc_rw_pio_op(struct mtd_info *mtd, u8 *buf, int len,
 	anfc_wait_for_event(nfc);
 }
 
+static void anfc_rw_dma_op(struct mtd_info *mtd, u8 *buf, int len,
+			   bool do_read, u32 prog, int pktcount, int pktsize)
+{
+	dma_addr_t paddr;
+	struct nand_chip *chip = mtd_to_nand(mtd);
+	struct anfc_nand_controller *nfc = to_anfc(chip->controller);
+	struct anfc_nand_chip *achip = to_anfc_nand(chip);
+	u32 eccintr = 0, dir;
+
+	if (pktsize == 0)
+		pktsize = len;
+
+	anfc_setpktszcnt(nfc, pktsize, pktcount);
+
+	if (!achip->strength)
+		eccintr = MBIT_ERROR;
+
+	if (do_read)
+		dir = DMA_FROM_DEVICE;
+	else
+		dir = DMA_TO_DEVICE;
+	paddr = dma_map_single(nfc->dev, buf, len, dir);
+	if (dma_mapping_error(nfc->dev, paddr)) {
+		dev_warn(nfc->dev, "buffer mapping error, using PIO\n");
+		anfc_rw_pio_op(mtd, buf, len, do_read, prog, pktcount,
+			       pktsize);
+		return;
+	}
+	writel(paddr, nfc->base + DMA_ADDR0_OFST);
+	writel((paddr >> 32), nfc->base + DMA_ADDR1_OFST);
+	anfc_enable_intrs(nfc, (XFER_COMPLETE | eccintr));
+	writel(prog, nfc->base + PROG_OFST);
+	anfc_wait_for_event(nfc);
+	dma_unmap_single(nfc->dev, paddr, len, dir);
+}
+
 static void anfc_read_data_op(struct nand_chip *chip, u8 *buf, int len,
 			      int pktcount, int pktsize)
 {
@@ -1315,7 +1317,13 @@ static int anfc_nand_chip_init(struct anfc_nand_controller *nfc,
 				   anand_chip->csnum);
 	mtd->dev.parent = nfc->dev;
 	chip->controller = &nfc->controller;
-	chip->options = NAND_BUSWIDTH_AUTO | NAND_NO_SUBPAGE_WRITE;
+	/*
+	 * Let the core bounce the vmalloc'ed buffers used by UBI, so that the
+	 * page is moved with a single DMA transfer instead of one PIO
+	 * interrupt round trip per packet.
+	 */
+	chip->options = NAND_BUSWIDTH_AUTO | NAND_NO_SUBPAGE_WRITE |
+			NAND_USE_BOUNCE_BUFFER;
 	chip->bbt_options = NAND_BBT_USE_FLASH;
 	chip->legacy.select_chip = anfc_select_chip;
 	nand_set_flash_node(chip, np);
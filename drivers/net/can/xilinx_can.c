@@ -11,12 +11,16 @@
 
 #include <linux/clk.h>
 #include <linux/errno.h>
+#include <linux/ethtool.h>
+#include <linux/hrtimer.h>
 #include <linux/init.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
 #include <linux/kernel.h>
+#include <linux/ktime.h>
 #include <linux/module.h>
 #include <linux/netdevice.h>
+#include <linux/net_tstamp.h>
 #include <linux/of.h>
 #include <linux/of_device.h>
 #include <linux/platform_device.h>
@@ -43,6 +47,7 @@ enum xcan_reg {
 	XCAN_ISR_OFFSET		= 0x1C, /* Interrupt status */
 	XCAN_IER_OFFSET		= 0x20, /* Interrupt enable */
 	XCAN_ICR_OFFSET		= 0x24, /* Interrupt clear */
+	XCAN_TSR_OFFSET		= 0x28, /* Timestamp (CAN FD only) */
 
 	/* not on CAN FD cores */
 	XCAN_TXFIFO_OFFSET	= 0x30, /* TX FIFO base */
@@ -57,6 +62,7 @@ enum xcan_reg {
 	XCAN_TRR_OFFSET		= 0x0090, /* TX Buffer Ready Request */
 	XCAN_AFR_EXT_OFFSET	= 0x00E0, /* Acceptance Filter */
 	XCAN_FSR_OFFSET		= 0x00E8, /* RX FIFO Status */
+	XCAN_WIR_OFFSET		= 0x00EC, /* Watermark Interrupt */
 	XCAN_TXMSG_BASE_OFFSET	= 0x0100, /* TX Message Space */
 	XCAN_RXMSG_BASE_OFFSET	= 0x1100, /* RX Message Space */
 	XCAN_RXMSG_2_BASE_OFFSET	= 0x2100, /* RX Message Space */
@@ -78,8 +84,8 @@ enum xcan_reg {
 #define XCAN_RXMSG_2_FRAME_OFFSET(n)	(XCAN_RXMSG_2_BASE_OFFSET + \
 					 XCAN_CANFD_FRAME_SIZE * (n))
 
-/* the single TX mailbox used by this driver on CAN FD HW */
-#define XCAN_TX_MAILBOX_IDX		0
+/* TX mailboxes used by this driver on CAN FD HW, one bit each in TRR */
+#define XCAN_TX_MAILBOX_MAX		32
 
 /* CAN register bit masks - XCAN_<REG>_<BIT>_MASK */
 #define XCAN_SRR_CEN_MASK		0x00000002 /* CAN enable */
@@ -107,6 +113,7 @@ enum xcan_reg {
 #define XCAN_SR_LBACK_MASK		0x00000002 /* Loop back mode */
 #define XCAN_SR_CONFIG_MASK		0x00000001 /* Configuration mode */
 #define XCAN_IXR_RXMNF_MASK		0x00020000 /* RX match not finished */
+#define XCAN_IXR_RXFWMFLL_MASK		0x00008000 /* RX FIFO Watermark Full */
 #define XCAN_IXR_TXFEMP_MASK		0x00004000 /* TX FIFO Empty */
 #define XCAN_IXR_WKUP_MASK		0x00000800 /* Wake up interrupt */
 #define XCAN_IXR_SLP_MASK		0x00000400 /* Sleep interrupt */
@@ -131,6 +138,8 @@ enum xcan_reg {
 #define XCAN_2_FSR_RI_MASK		0x0000003F /* RX Read Index */
 #define XCAN_DLCR_EDL_MASK		0x08000000 /* EDL Mask in DLC */
 #define XCAN_DLCR_BRS_MASK		0x04000000 /* BRS Mask in DLC */
+#define XCAN_DLCR_TS_MASK		0x0000FFFF /* RX Timestamp in DLC */
+#define XCAN_WIR_FW_MASK		0x000000FF /* RX FIFO Full Watermark */
 
 /* CAN register bit shift - XCAN_<REG>_<BIT>_SHIFT */
 #define XCAN_BTR_SJW_SHIFT		7  /* Synchronous jump width */
@@ -141,12 +150,17 @@ enum xcan_reg {
 #define XCAN_IDR_ID2_SHIFT		1  /* Extended Message Identifier */
 #define XCAN_DLCR_DLC_SHIFT		28 /* Data length code */
 #define XCAN_ESR_REC_SHIFT		8  /* Rx Error Count */
+#define XCAN_FSR_FL_SHIFT		8  /* RX Fill Level */
+#define XCAN_TSR_CNT_SHIFT		16 /* Timestamp Counter */
 
 /* CAN frame length constants */
 #define XCAN_FRAME_MAX_DATA_LEN		8
 #define XCANFD_DW_BYTES			4
 #define XCAN_TIMEOUT			(1 * HZ)
 
+/* Width of the CAN FD RX timestamp counter */
+#define XCAN_TS_CNT_WRAP		0x10000ULL
+
 /* TX-FIFO-empty interrupt available */
 #define XCAN_FLAG_TXFEMP	0x0001
 /* RX Match Not Finished interrupt available */
@@ -184,7 +198,23 @@ struct xcan_devtype_data {
  * @tx_head:			Tx CAN packets ready to send on the queue
  * @tx_tail:			Tx CAN packets successfully sended on the queue
  * @tx_max:			Maximum number packets the driver can send
+ * @tx_batch:			Next free TX mailbox of the current mailbox pass
+ * @tx_ready:			TX mailboxes written but not yet requested
+ * @tx_inflight:		TX mailboxes requested and not yet sent
+ * @tx_held:			TX mailbox held back until tx_inflight drains
+ * @tx_last_id:			Highest ID register value requested or ready
+ * @tx_held_id:			ID register value of the held TX mailbox
  * @napi:			NAPI structure
+ * @rx_max:			RX FIFO depth
+ * @rx_wmark:			RX FIFO watermark, 0 for an interrupt per frame
+ * @rx_usecs:			Latency bound of the watermark mode
+ * @rx_timer:			Polls the RX FIFO below the watermark
+ * @rx_ts_mult:			RX timestamp counter tick in 16.16 fixed point ns
+ * @rx_ts_wrap_ns:		RX timestamp counter wrap period
+ * @rx_ts_time:			System time of the current RX batch sample
+ * @rx_ts_empty:		System time the RX FIFO was last seen empty
+ * @rx_ts_cnt:			Timestamp counter of the current RX batch sample
+ * @rx_ts_valid:		Frame ages of the current RX batch are valid
  * @read_reg:			For reading data from CAN registers
  * @write_reg:			For writing data to CAN registers
  * @dev:			Network device data structure
@@ -200,7 +230,23 @@ struct xcan_priv {
 	unsigned int tx_head;
 	unsigned int tx_tail;
 	unsigned int tx_max;
+	unsigned int tx_batch;
+	u32 tx_ready;
+	u32 tx_inflight;
+	u32 tx_held;
+	u32 tx_last_id;
+	u32 tx_held_id;
 	struct napi_struct napi;
+	unsigned int rx_max;
+	unsigned int rx_wmark;
+	unsigned int rx_usecs;
+	struct hrtimer rx_timer;
+	u32 rx_ts_mult;
+	u64 rx_ts_wrap_ns;
+	ktime_t rx_ts_time;
+	ktime_t rx_ts_empty;
+	u16 rx_ts_cnt;
+	bool rx_ts_valid;
 	u32 (*read_reg)(const struct xcan_priv *priv, enum xcan_reg reg);
 	void (*write_reg)(const struct xcan_priv *priv, enum xcan_reg reg,
 			  u32 val);
@@ -489,6 +535,19 @@ static int xcan_chip_start(struct net_device *ndev)
 
 	priv->write_reg(priv, XCAN_IER_OFFSET, ier);
 
+	/* The watermark interrupt is only enabled by xcan_rx_poll() once
+	 * frames are flowing, RXOK still signals the first frame
+	 */
+	if (priv->rx_wmark > 1)
+		priv->write_reg(priv, XCAN_WIR_OFFSET,
+				priv->rx_wmark & XCAN_WIR_FW_MASK);
+
+	/* The reset above cancelled any outstanding mailbox */
+	priv->tx_batch = 0;
+	priv->tx_ready = 0;
+	priv->tx_inflight = 0;
+	priv->tx_held = 0;
+
 	/* Check whether it is loopback mode or normal mode  */
 	if (priv->can.ctrlmode & CAN_CTRLMODE_LOOPBACK)
 		reg_msr = XCAN_MSR_LBACK_MASK;
@@ -547,9 +606,11 @@ static int xcan_do_set_mode(struct net_device *ndev, enum can_mode mode)
  * @ndev:		Pointer to net_device structure
  * @skb:		sk_buff pointer that contains data to be Txed
  * @frame_offset:	Register offset to write the frame to
+ *
+ * Return: the value written to the ID register
  */
-static void xcan_write_frame(struct net_device *ndev, struct sk_buff *skb,
-			     int frame_offset)
+static u32 xcan_write_frame(struct net_device *ndev, struct sk_buff *skb,
+			    int frame_offset)
 {
 	u32 id, dlc, data[2] = {0, 0};
 	struct canfd_frame *cf = (struct canfd_frame *)skb->data;
@@ -590,8 +651,9 @@ static void xcan_write_frame(struct net_device *ndev, struct sk_buff *skb,
 		dlc |= XCAN_DLCR_EDL_MASK;
 	}
 
-	if (!(priv->devtype.flags & XCAN_FLAG_TX_MAILBOXES) &&
-	    (priv->devtype.flags & XCAN_FLAG_TXFEMP))
+	if (priv->devtype.flags & XCAN_FLAG_TX_MAILBOXES)
+		can_put_echo_skb(skb, ndev, priv->tx_batch);
+	else if (priv->devtype.flags & XCAN_FLAG_TXFEMP)
 		can_put_echo_skb(skb, ndev, priv->tx_head % priv->tx_max);
 	else
 		can_put_echo_skb(skb, ndev, 0);
@@ -630,6 +692,8 @@ static void xcan_write_frame(struct net_device *ndev, struct sk_buff *skb,
 					data[1]);
 		}
 	}
+
+	return id;
 }
 
 /**
@@ -666,31 +730,70 @@ static int xcan_start_xmit_fifo(struct sk_buff *skb, struct net_device *ndev)
 	return 0;
 }
 
+/**
+ * xcan_tx_mailbox_request - Request the transmission of the ready mailboxes
+ * @priv:	Driver private data structure
+ *
+ * Must be called with tx_lock held.
+ */
+static void xcan_tx_mailbox_request(struct xcan_priv *priv)
+{
+	if (!priv->tx_ready)
+		return;
+
+	priv->write_reg(priv, XCAN_TRR_OFFSET, priv->tx_ready);
+	priv->tx_inflight |= priv->tx_ready;
+	priv->tx_ready = 0;
+}
+
 /**
  * xcan_start_xmit_mailbox - Starts the transmission (mailbox mode)
  * @skb:	sk_buff pointer that contains data to be Txed
  * @ndev:	Pointer to net_device structure
  *
+ * Frames fill the mailboxes in order and are requested with a single TRR
+ * write per batch of xmit_more frames. HW sends the requested mailboxes in
+ * CAN ID priority order, lowest mailbox first on equal IDs. The ID register
+ * layout follows the arbitration field, so FIFO ordering is kept as long as
+ * the ID register values do not decrease within a pass over the mailboxes.
+ * A frame that would overtake an earlier one is held back in its mailbox
+ * until all the earlier ones are sent.
+ *
  * Return: 0 on success, -ENOSPC if there is no space
  */
 static int xcan_start_xmit_mailbox(struct sk_buff *skb, struct net_device *ndev)
 {
 	struct xcan_priv *priv = netdev_priv(ndev);
 	unsigned long flags;
+	unsigned int idx;
+	u32 id;
+
+	spin_lock_irqsave(&priv->tx_lock, flags);
 
-	if (unlikely(priv->read_reg(priv, XCAN_TRR_OFFSET) &
-		     BIT(XCAN_TX_MAILBOX_IDX)))
+	idx = priv->tx_batch;
+	if (unlikely(idx >= priv->tx_max || priv->tx_held)) {
+		spin_unlock_irqrestore(&priv->tx_lock, flags);
 		return -ENOSPC;
+	}
 
-	spin_lock_irqsave(&priv->tx_lock, flags);
+	id = xcan_write_frame(ndev, skb, XCAN_TXMSG_FRAME_OFFSET(idx));
+	priv->tx_batch++;
 
-	xcan_write_frame(ndev, skb,
-			 XCAN_TXMSG_FRAME_OFFSET(XCAN_TX_MAILBOX_IDX));
+	if ((priv->tx_ready | priv->tx_inflight) && id < priv->tx_last_id) {
+		priv->tx_held = BIT(idx);
+		priv->tx_held_id = id;
+		xcan_tx_mailbox_request(priv);
+		netif_stop_queue(ndev);
+	} else {
+		priv->tx_ready |= BIT(idx);
+		priv->tx_last_id = id;
 
-	/* Mark buffer as ready for transmit */
-	priv->write_reg(priv, XCAN_TRR_OFFSET, BIT(XCAN_TX_MAILBOX_IDX));
+		if (priv->tx_batch == priv->tx_max)
+			netif_stop_queue(ndev);
 
-	netif_stop_queue(ndev);
+		if (priv->tx_batch == priv->tx_max || !netdev_xmit_more())
+			xcan_tx_mailbox_request(priv);
+	}
 
 	spin_unlock_irqrestore(&priv->tx_lock, flags);
 
@@ -805,7 +908,8 @@ static int xcan_rx(struct net_device *ndev, int frame_base)
  *
  * This function is invoked from the CAN isr(poll) to process the Rx frames. It
  * does minimal processing and invokes "netif_receive_skb" to complete further
- * processing.
+ * processing. The frame timestamp is derived from the counter value latched
+ * in the DLC word and the sample of the current batch.
  * Return: 1 on success and 0 on failure.
  */
 static int xcanfd_rx(struct net_device *ndev, int frame_base)
@@ -872,6 +976,14 @@ static int xcanfd_rx(struct net_device *ndev, int frame_base)
 			*(__be32 *)(cf->data + i) = cpu_to_be32(data[0]);
 		}
 	}
+	if (priv->rx_ts_valid) {
+		u16 age = priv->rx_ts_cnt - (dlc & XCAN_DLCR_TS_MASK);
+		u64 ns = ((u64)age * priv->rx_ts_mult) >> 16;
+
+		skb_hwtstamps(skb)->hwtstamp = ktime_sub_ns(priv->rx_ts_time,
+							    ns);
+	}
+
 	stats->rx_bytes += cf->len;
 	stats->rx_packets++;
 	netif_receive_skb(skb);
@@ -1131,49 +1243,108 @@ static void xcan_state_interrupt(struct net_device *ndev, u32 isr)
  * xcan_rx_fifo_get_next_frame - Get register offset of next RX frame
  * @priv:	Driver private data structure
  *
+ * Only used on cores with the regular RX FIFO, see xcanfd_rx_fifo_drain()
+ * for the CAN FD RX FIFO.
+ *
  * Return: Register offset of the next frame in RX FIFO.
  */
 static int xcan_rx_fifo_get_next_frame(struct xcan_priv *priv)
 {
-	int offset;
+	/* check if RX FIFO is empty */
+	if (!(priv->read_reg(priv, XCAN_ISR_OFFSET) & XCAN_IXR_RXNEMP_MASK))
+		return -ENOENT;
 
-	if (priv->devtype.flags & XCAN_FLAG_RX_FIFO_MULTI) {
-		u32 fsr, mask;
+	/* frames are read from a static offset */
+	return XCAN_RXFIFO_OFFSET;
+}
+
+/**
+ * xcanfd_rx_ts_sample - Sample the timestamp counter for an RX batch
+ * @priv:	Driver private data structure
+ * @now:	System time taken before the RX FIFO status was read
+ *
+ * The CAN FD cores latch the 16 bit timestamp counter into the DLC word of
+ * each received frame. Sampling the counter together with the system time
+ * once per batch gives each frame timestamp from its age, with no further
+ * register access. The age is only unambiguous within one counter wrap,
+ * which holds when the FIFO was seen empty less than a wrap ago.
+ */
+static void xcanfd_rx_ts_sample(struct xcan_priv *priv, ktime_t now)
+{
+	priv->rx_ts_valid = priv->rx_ts_wrap_ns &&
+			    ktime_to_ns(ktime_sub(now, priv->rx_ts_empty)) <
+			    priv->rx_ts_wrap_ns;
+	if (!priv->rx_ts_valid)
+		return;
 
+	priv->rx_ts_time = now;
+	priv->rx_ts_cnt = priv->read_reg(priv, XCAN_TSR_OFFSET) >>
+			  XCAN_TSR_CNT_SHIFT;
+}
+
+/**
+ * xcanfd_rx_fifo_drain - Receive a batch of frames from the CAN FD RX FIFO
+ * @ndev:	Pointer to net_device structure
+ * @quota:	Max number of rx packets to be processed
+ *
+ * The fill level and read index are read once per batch and the frames
+ * are then taken in order from consecutive buffers, instead of reading the
+ * FIFO status again for every frame.
+ *
+ * Return: number of packets received
+ */
+static int xcanfd_rx_fifo_drain(struct net_device *ndev, int quota)
+{
+	struct xcan_priv *priv = netdev_priv(ndev);
+	u32 fsr, fl_mask, ri_mask;
+	unsigned int fill, ri;
+	int work_done = 0;
+	ktime_t now;
+
+	if (priv->devtype.flags & XCAN_FLAG_CANFD_2) {
+		fl_mask = XCAN_2_FSR_FL_MASK;
+		ri_mask = XCAN_2_FSR_RI_MASK;
+	} else {
+		fl_mask = XCAN_FSR_FL_MASK;
+		ri_mask = XCAN_FSR_RI_MASK;
+	}
+
+	while (work_done < quota) {
 		/* clear RXOK before the is-empty check so that any newly
 		 * received frame will reassert it without a race
 		 */
-		priv->write_reg(priv, XCAN_ICR_OFFSET, XCAN_IXR_RXOK_MASK);
+		priv->write_reg(priv, XCAN_ICR_OFFSET,
+				XCAN_IXR_RXOK_MASK | XCAN_IXR_RXFWMFLL_MASK);
 
+		now = ktime_get_real();
 		fsr = priv->read_reg(priv, XCAN_FSR_OFFSET);
+		fill = (fsr & fl_mask) >> XCAN_FSR_FL_SHIFT;
+		if (!fill) {
+			priv->rx_ts_empty = now;
+			break;
+		}
 
-		/* check if RX FIFO is empty */
-		if (priv->devtype.flags & XCAN_FLAG_CANFD_2)
-			mask = XCAN_2_FSR_FL_MASK;
-		else
-			mask = XCAN_FSR_FL_MASK;
-
-		if (!(fsr & mask))
-			return -ENOENT;
-
-		if (priv->devtype.flags & XCAN_FLAG_CANFD_2)
-			offset =
-			  XCAN_RXMSG_2_FRAME_OFFSET(fsr & XCAN_2_FSR_RI_MASK);
-		else
-			offset =
-			  XCAN_RXMSG_FRAME_OFFSET(fsr & XCAN_FSR_RI_MASK);
+		xcanfd_rx_ts_sample(priv, now);
 
-	} else {
-		/* check if RX FIFO is empty */
-		if (!(priv->read_reg(priv, XCAN_ISR_OFFSET) &
-		      XCAN_IXR_RXNEMP_MASK))
-			return -ENOENT;
+		ri = fsr & ri_mask;
+		fill = min_t(unsigned int, fill, quota - work_done);
+		while (fill--) {
+			if (priv->devtype.flags & XCAN_FLAG_CANFD_2)
+				work_done += xcanfd_rx(ndev,
+						XCAN_RXMSG_2_FRAME_OFFSET(ri));
+			else
+				work_done += xcanfd_rx(ndev,
+						XCAN_RXMSG_FRAME_OFFSET(ri));
 
-		/* frames are read from a static offset */
-		offset = XCAN_RXFIFO_OFFSET;
+			/* increment read index */
+			priv->write_reg(priv, XCAN_FSR_OFFSET,
+					XCAN_FSR_IRI_MASK);
+			if (++ri == priv->rx_max)
+				ri = 0;
+		}
 	}
 
-	return offset;
+	return work_done;
 }
 
 /**
@@ -1184,6 +1355,11 @@ static int xcan_rx_fifo_get_next_frame(struct xcan_priv *priv)
  * This is the poll routine for rx part.
  * It will process the packets maximux quota value.
  *
+ * With an RX FIFO watermark set, the RXOK interrupt stays off while frames
+ * keep coming in. The next poll is then triggered by the watermark
+ * interrupt, or by rx_timer after rx_usecs below the watermark. A poll that
+ * finds no frame switches back to RXOK.
+ *
  * Return: number of packets received
  */
 static int xcan_rx_poll(struct napi_struct *napi, int quota)
@@ -1194,23 +1370,19 @@ static int xcan_rx_poll(struct napi_struct *napi, int quota)
 	int work_done = 0;
 	int frame_offset;
 
-	while ((frame_offset = xcan_rx_fifo_get_next_frame(priv)) >= 0 &&
-	       (work_done < quota)) {
-		if (xcan_rx_int_mask(priv) & XCAN_IXR_RXOK_MASK)
-			work_done += xcanfd_rx(ndev, frame_offset);
-		else
+	if (priv->devtype.flags & XCAN_FLAG_RX_FIFO_MULTI) {
+		work_done = xcanfd_rx_fifo_drain(ndev, quota);
+	} else {
+		while (work_done < quota &&
+		       (frame_offset = xcan_rx_fifo_get_next_frame(priv)) >= 0) {
 			work_done += xcan_rx(ndev, frame_offset);
 
-		if (priv->devtype.flags & XCAN_FLAG_RX_FIFO_MULTI)
-			/* increment read index */
-			priv->write_reg(priv, XCAN_FSR_OFFSET,
-					XCAN_FSR_IRI_MASK);
-		else
 			/* clear rx-not-empty (will actually clear only if
 			 * empty)
 			 */
 			priv->write_reg(priv, XCAN_ICR_OFFSET,
 					XCAN_IXR_RXNEMP_MASK);
+		}
 	}
 
 	if (work_done) {
@@ -1221,12 +1393,37 @@ static int xcan_rx_poll(struct napi_struct *napi, int quota)
 	if (work_done < quota) {
 		napi_complete_done(napi, work_done);
 		ier = priv->read_reg(priv, XCAN_IER_OFFSET);
-		ier |= xcan_rx_int_mask(priv);
+		if (work_done && priv->rx_wmark > 1) {
+			ier |= XCAN_IXR_RXFWMFLL_MASK;
+			hrtimer_start(&priv->rx_timer,
+				      ns_to_ktime(priv->rx_usecs *
+						  NSEC_PER_USEC),
+				      HRTIMER_MODE_REL);
+		} else {
+			ier &= ~XCAN_IXR_RXFWMFLL_MASK;
+			ier |= xcan_rx_int_mask(priv);
+		}
 		priv->write_reg(priv, XCAN_IER_OFFSET, ier);
 	}
 	return work_done;
 }
 
+/**
+ * xcan_rx_timer - RX latency bound of the watermark mode
+ * @timer:	Pointer to the rx_timer
+ *
+ * Return: HRTIMER_NORESTART always
+ */
+static enum hrtimer_restart xcan_rx_timer(struct hrtimer *timer)
+{
+	struct xcan_priv *priv = container_of(timer, struct xcan_priv,
+					      rx_timer);
+
+	napi_schedule(&priv->napi);
+
+	return HRTIMER_NORESTART;
+}
+
 /**
  * xcan_tx_interrupt - Tx Done Isr
  * @ndev:	net_device pointer
@@ -1305,6 +1502,57 @@ static void xcan_tx_interrupt(struct net_device *ndev, u32 isr)
 	xcan_update_error_state_after_rxtx(ndev);
 }
 
+/**
+ * xcan_tx_mailbox_interrupt - Tx Done Isr (mailbox mode)
+ * @ndev:	net_device pointer
+ */
+static void xcan_tx_mailbox_interrupt(struct net_device *ndev)
+{
+	struct xcan_priv *priv = netdev_priv(ndev);
+	struct net_device_stats *stats = &ndev->stats;
+	unsigned long flags;
+	unsigned int idx;
+	u32 sent;
+
+	spin_lock_irqsave(&priv->tx_lock, flags);
+
+	/* clear TXOK before reading TRR so that a mailbox sent after this
+	 * point reasserts it
+	 */
+	priv->write_reg(priv, XCAN_ICR_OFFSET, XCAN_IXR_TXOK_MASK);
+	sent = priv->tx_inflight & ~priv->read_reg(priv, XCAN_TRR_OFFSET);
+
+	/* mailboxes of a pass were filled in order, echo them in order */
+	while (sent) {
+		idx = __ffs(sent);
+		sent &= ~BIT(idx);
+		priv->tx_inflight &= ~BIT(idx);
+		stats->tx_bytes += can_get_echo_skb(ndev, idx);
+		priv->tx_tail++;
+		stats->tx_packets++;
+	}
+
+	if (!priv->tx_inflight) {
+		if (priv->tx_held) {
+			priv->tx_ready = priv->tx_held;
+			priv->tx_last_id = priv->tx_held_id;
+			priv->tx_held = 0;
+			xcan_tx_mailbox_request(priv);
+		} else if (!priv->tx_ready) {
+			/* start the next pass from the first mailbox */
+			priv->tx_batch = 0;
+		}
+	}
+
+	if (!priv->tx_held && priv->tx_batch < priv->tx_max)
+		netif_wake_queue(ndev);
+
+	spin_unlock_irqrestore(&priv->tx_lock, flags);
+
+	can_led_event(ndev, CAN_LED_EVENT_TX);
+	xcan_update_error_state_after_rxtx(ndev);
+}
+
 /**
  * xcan_interrupt - CAN Isr
  * @irq:	irq number
@@ -1322,7 +1570,7 @@ static irqreturn_t xcan_interrupt(int irq, void *dev_id)
 	struct xcan_priv *priv = netdev_priv(ndev);
 	u32 isr, ier;
 	u32 isr_errors;
-	u32 rx_int_mask = xcan_rx_int_mask(priv);
+	u32 rx_int_mask = xcan_rx_int_mask(priv) | XCAN_IXR_RXFWMFLL_MASK;
 
 	/* Get the interrupt status from Xilinx CAN */
 	isr = priv->read_reg(priv, XCAN_ISR_OFFSET);
@@ -1337,8 +1585,12 @@ static irqreturn_t xcan_interrupt(int irq, void *dev_id)
 	}
 
 	/* Check for Tx interrupt and Processing it */
-	if (isr & XCAN_IXR_TXOK_MASK)
-		xcan_tx_interrupt(ndev, isr);
+	if (isr & XCAN_IXR_TXOK_MASK) {
+		if (priv->devtype.flags & XCAN_FLAG_TX_MAILBOXES)
+			xcan_tx_mailbox_interrupt(ndev);
+		else
+			xcan_tx_interrupt(ndev, isr);
+	}
 
 	/* Check for the type of error interrupt and Processing it */
 	isr_errors = isr & (XCAN_IXR_ERROR_MASK | XCAN_IXR_RXOFLW_MASK |
@@ -1349,12 +1601,16 @@ static irqreturn_t xcan_interrupt(int irq, void *dev_id)
 		xcan_err_interrupt(ndev, isr);
 	}
 
-	/* Check for the type of receive interrupt and Processing it */
+	/* Check for the type of receive interrupt and Processing it. The RX
+	 * status bits are set while masked too, only act on the enabled ones.
+	 */
 	if (isr & rx_int_mask) {
 		ier = priv->read_reg(priv, XCAN_IER_OFFSET);
-		ier &= ~rx_int_mask;
-		priv->write_reg(priv, XCAN_IER_OFFSET, ier);
-		napi_schedule(&priv->napi);
+		if (ier & isr & rx_int_mask) {
+			ier &= ~rx_int_mask;
+			priv->write_reg(priv, XCAN_IER_OFFSET, ier);
+			napi_schedule(&priv->napi);
+		}
 	}
 	return IRQ_HANDLED;
 }
@@ -1451,6 +1707,7 @@ static int xcan_close(struct net_device *ndev)
 
 	netif_stop_queue(ndev);
 	napi_disable(&priv->napi);
+	hrtimer_cancel(&priv->rx_timer);
 	xcan_chip_stop(ndev);
 	free_irq(ndev->irq, ndev);
 	close_candev(ndev);
@@ -1498,6 +1755,86 @@ static const struct net_device_ops xcan_netdev_ops = {
 	.ndo_change_mtu	= can_change_mtu,
 };
 
+/**
+ * xcan_get_coalesce - Get the RX FIFO watermark
+ * @ndev:	Pointer to net_device structure
+ * @ec:		Pointer to ethtool_coalesce structure
+ *
+ * Return: 0 always
+ */
+static int xcan_get_coalesce(struct net_device *ndev,
+			     struct ethtool_coalesce *ec)
+{
+	struct xcan_priv *priv = netdev_priv(ndev);
+
+	ec->rx_max_coalesced_frames = max(priv->rx_wmark, 1U);
+	ec->rx_coalesce_usecs = priv->rx_usecs;
+
+	return 0;
+}
+
+/**
+ * xcan_set_coalesce - Set the RX FIFO watermark
+ * @ndev:	Pointer to net_device structure
+ * @ec:		Pointer to ethtool_coalesce structure
+ *
+ * rx-frames is the RX FIFO watermark, rx-usecs the longest a frame may
+ * wait below it. The watermark is programmed on the next start.
+ *
+ * Return: 0 on success, -EOPNOTSUPP without an RX FIFO watermark, -EBUSY
+ * while the interface is up and -EINVAL on invalid values
+ */
+static int xcan_set_coalesce(struct net_device *ndev,
+			     struct ethtool_coalesce *ec)
+{
+	struct xcan_priv *priv = netdev_priv(ndev);
+
+	if (!(priv->devtype.flags & XCAN_FLAG_RX_FIFO_MULTI))
+		return -EOPNOTSUPP;
+
+	if (netif_running(ndev))
+		return -EBUSY;
+
+	if (ec->rx_max_coalesced_frames > priv->rx_max ||
+	    ec->rx_max_coalesced_frames > XCAN_WIR_FW_MASK ||
+	    (ec->rx_max_coalesced_frames > 1 && !ec->rx_coalesce_usecs))
+		return -EINVAL;
+
+	priv->rx_wmark = ec->rx_max_coalesced_frames;
+	priv->rx_usecs = ec->rx_coalesce_usecs;
+
+	return 0;
+}
+
+/**
+ * xcan_get_ts_info - Get the timestamping capabilities
+ * @ndev:	Pointer to net_device structure
+ * @info:	Pointer to ethtool_ts_info structure
+ *
+ * Return: 0 always
+ */
+static int xcan_get_ts_info(struct net_device *ndev,
+			    struct ethtool_ts_info *info)
+{
+	struct xcan_priv *priv = netdev_priv(ndev);
+
+	ethtool_op_get_ts_info(ndev, info);
+
+	if (priv->rx_ts_wrap_ns) {
+		info->so_timestamping |= SOF_TIMESTAMPING_RX_HARDWARE |
+					 SOF_TIMESTAMPING_RAW_HARDWARE;
+		info->rx_filters = BIT(HWTSTAMP_FILTER_ALL);
+	}
+
+	return 0;
+}
+
+static const struct ethtool_ops xcan_ethtool_ops = {
+	.get_coalesce	= xcan_get_coalesce,
+	.set_coalesce	= xcan_set_coalesce,
+	.get_ts_info	= xcan_get_ts_info,
+};
+
 /**
  * xcan_suspend - Suspend method for the driver
  * @dev:	Address of the device structure
@@ -1508,11 +1845,13 @@ static const struct net_device_ops xcan_netdev_ops = {
 static int __maybe_unused xcan_suspend(struct device *dev)
 {
 	struct net_device *ndev = dev_get_drvdata(dev);
+	struct xcan_priv *priv = netdev_priv(ndev);
 
 	if (netif_running(ndev)) {
 		netif_stop_queue(ndev);
 		netif_device_detach(ndev);
 		xcan_chip_stop(ndev);
+		hrtimer_cancel(&priv->rx_timer);
 	}
 
 	return pm_runtime_force_suspend(dev);
@@ -1722,10 +2061,12 @@ static int xcan_probe(struct platform_device *pdev)
 	 * With TX mailboxes:
 	 *
 	 * HW sends frames in CAN ID priority order. To preserve FIFO ordering
-	 * we submit frames one at a time.
+	 * xcan_start_xmit_mailbox() holds back a frame that would overtake
+	 * an earlier one, so all the mailboxes can be used.
 	 */
-	if (!(devtype->flags & XCAN_FLAG_TX_MAILBOXES) &&
-	    (devtype->flags & XCAN_FLAG_TXFEMP))
+	if (devtype->flags & XCAN_FLAG_TX_MAILBOXES)
+		tx_max = clamp(hw_tx_max, 1U, (u32)XCAN_TX_MAILBOX_MAX);
+	else if (devtype->flags & XCAN_FLAG_TXFEMP)
 		tx_max = min(hw_tx_max, 2U);
 	else
 		tx_max = 1;
@@ -1759,8 +2100,11 @@ static int xcan_probe(struct platform_device *pdev)
 
 	priv->reg_base = addr;
 	priv->tx_max = tx_max;
+	priv->rx_max = rx_max;
 	priv->devtype = *devtype;
 	spin_lock_init(&priv->tx_lock);
+	hrtimer_init(&priv->rx_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	priv->rx_timer.function = xcan_rx_timer;
 
 	/* Get IRQ for the device */
 	ndev->irq = platform_get_irq(pdev, 0);
@@ -1769,6 +2113,7 @@ static int xcan_probe(struct platform_device *pdev)
 	platform_set_drvdata(pdev, ndev);
 	SET_NETDEV_DEV(ndev, &pdev->dev);
 	ndev->netdev_ops = &xcan_netdev_ops;
+	ndev->ethtool_ops = &xcan_ethtool_ops;
 
 	/* Getting the CAN can_clk info */
 	priv->can_clk = devm_clk_get(&pdev->dev, "can_clk");
@@ -1805,6 +2150,14 @@ static int xcan_probe(struct platform_device *pdev)
 
 	priv->can.clock.freq = clk_get_rate(priv->can_clk);
 
+	/* The RX timestamp counter runs from can_clk */
+	if ((devtype->flags & XCAN_FLAG_RX_FIFO_MULTI) &&
+	    priv->can.clock.freq) {
+		priv->rx_ts_mult = div_u64((u64)NSEC_PER_SEC << 16,
+					   priv->can.clock.freq);
+		priv->rx_ts_wrap_ns = XCAN_TS_CNT_WRAP * priv->rx_ts_mult >> 16;
+	}
+
 	netif_napi_add(ndev, &priv->napi, xcan_rx_poll, rx_max);
 
 	ret = register_candev(ndev);
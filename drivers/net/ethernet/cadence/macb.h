@@ -11,6 +11,7 @@
 #include <linux/ptp_clock_kernel.h>
 #include <linux/net_tstamp.h>
 #include <linux/interrupt.h>
+#include <net/xdp.h>
 
 #if defined(CONFIG_ARCH_DMA_ADDR_T_64BIT) || defined(CONFIG_MACB_USE_HWSTAMP)
 #define MACB_EXT_DESC
@@ -194,6 +195,9 @@
 /* Which screening type 2 EtherType register will be used (0 - 7) */
 #define SCRT2_ETHT		0
 
+/* Largest Rx flow spreading indirection table, one screener per entry */
+#define GEM_RSS_MAX_INDIR	8
+
 #define GEM_ISR(hw_q)		(0x0400 + ((hw_q) << 2))
 #define GEM_TBQP(hw_q)		(0x0440 + ((hw_q) << 2))
 #define GEM_TBQPH(hw_q)		(0x04C8)
@@ -868,6 +872,7 @@ struct gem_tx_ts {
 /* struct macb_tx_skb - data about an skb which is being transmitted
  * @skb: skb currently being transmitted, only set for the last buffer
  *       of the frame
+ * @xdpf: redirected XDP frame being transmitted, set instead of @skb
  * @mapping: DMA address of the skb's fragment buffer
  * @size: size of the DMA mapped buffer
  * @mapped_as_page: true when buffer was mapped with skb_frag_dma_map(),
@@ -875,6 +880,7 @@ struct gem_tx_ts {
  */
 struct macb_tx_skb {
 	struct sk_buff		*skb;
+	struct xdp_frame	*xdpf;
 	dma_addr_t		mapping;
 	size_t			size;
 	bool			mapped_as_page;
@@ -1154,7 +1160,9 @@ struct macb_queue {
 	unsigned int		rx_tail;
 	unsigned int		rx_prepared_head;
 	struct macb_dma_desc	*rx_ring;
-	struct sk_buff		**rx_skbuff;
+	struct page		**rx_page;
+	struct page_pool	*page_pool;
+	struct xdp_rxq_info	xdp_rxq;
 	void			*rx_buffers;
 	struct napi_struct	napi;
 	struct queue_stats stats;
@@ -1254,6 +1262,10 @@ struct macb {
 	spinlock_t rx_fs_lock;
 	unsigned int max_tuples;
 
+	/* RX flow spreading on the last screeners, under rx_fs_lock */
+	unsigned int rss_indir_size;
+	u32 rss_indir[GEM_RSS_MAX_INDIR];
+
 	struct tasklet_struct	hresp_err_tasklet;
 
 	int	rx_bd_rd_prefetch;
@@ -1262,6 +1274,8 @@ struct macb {
 	u32	rx_intr_mask;
 
 	struct macb_pm_data pm_data;
+
+	struct bpf_prog		*xdp_prog;
 };
 
 #ifdef CONFIG_MACB_USE_HWSTAMP
@@ -38,6 +38,9 @@
 #include <linux/pm_runtime.h>
 #include <linux/crc32.h>
 #include <linux/inetdevice.h>
+#include <linux/bpf.h>
+#include <linux/bpf_trace.h>
+#include <net/page_pool.h>
 #include "macb.h"
 
 /* This structure is only used for MACB on SiFive FU540 devices */
@@ -50,6 +53,12 @@ struct sifive_fu540_macb_mgmt {
 #define MACB_RX_BUFFER_SIZE	128
 #define RX_BUFFER_MULTIPLE	64  /* bytes */
 
+/* Every GEM Rx buffer is a page pool page holding the XDP headroom, the
+ * hardware buffer and the skb_shared_info used by build_skb()
+ */
+#define GEM_RX_HEADROOM		XDP_PACKET_HEADROOM
+#define GEM_RX_TAILROOM		SKB_DATA_ALIGN(sizeof(struct skb_shared_info))
+
 #define DEFAULT_RX_RING_SIZE	512 /* must be power of 2 */
 #define MIN_RX_RING_SIZE	64
 #define MAX_RX_RING_SIZE	8192
@@ -686,6 +695,11 @@ static void macb_tx_unmap(struct macb *bp, struct macb_tx_skb *tx_skb)
 		dev_kfree_skb_any(tx_skb->skb);
 		tx_skb->skb = NULL;
 	}
+
+	if (tx_skb->xdpf) {
+		xdp_return_frame(tx_skb->xdpf);
+		tx_skb->xdpf = NULL;
+	}
 }
 
 static void macb_set_addr(struct macb *bp, struct macb_dma_desc *desc, dma_addr_t addr)
@@ -770,8 +784,8 @@ static void macb_tx_error_task(struct work_struct *work)
 		skb = tx_skb->skb;
 
 		if (ctrl & MACB_BIT(TX_USED)) {
-			/* skb is set for the last buffer of the frame */
-			while (!skb) {
+			/* skb or xdpf is set for the last buffer of the frame */
+			while (!skb && !tx_skb->xdpf) {
 				macb_tx_unmap(bp, tx_skb);
 				tail++;
 				tx_skb = macb_tx_skb(queue, tail);
@@ -782,13 +796,15 @@ static void macb_tx_error_task(struct work_struct *work)
 			 * since it's the only one written back by the hardware
 			 */
 			if (!(ctrl & MACB_BIT(TX_BUF_EXHAUSTED))) {
-				netdev_vdbg(bp->dev, "txerr skb %u (data %p) TX complete\n",
-					    macb_tx_ring_wrap(bp, tail),
-					    skb->data);
+				unsigned int len = skb ? skb->len :
+						   tx_skb->xdpf->len;
+
+				netdev_vdbg(bp->dev, "txerr frame %u TX complete\n",
+					    macb_tx_ring_wrap(bp, tail));
 				bp->dev->stats.tx_packets++;
 				queue->stats.tx_packets++;
-				bp->dev->stats.tx_bytes += skb->len;
-				queue->stats.tx_bytes += skb->len;
+				bp->dev->stats.tx_bytes += len;
+				queue->stats.tx_bytes += len;
 			}
 		} else {
 			/* "Buffers exhausted mid-frame" errors may only happen
@@ -858,6 +874,7 @@ static void macb_tx_interrupt(struct macb_queue *queue)
 	for (tail = queue->tx_tail; tail != head; tail++) {
 		struct macb_tx_skb	*tx_skb;
 		struct sk_buff		*skb;
+		struct xdp_frame	*xdpf;
 		struct macb_dma_desc	*desc;
 		u32			ctrl;
 
@@ -878,8 +895,15 @@ static void macb_tx_interrupt(struct macb_queue *queue)
 		for (;; tail++) {
 			tx_skb = macb_tx_skb(queue, tail);
 			skb = tx_skb->skb;
+			xdpf = tx_skb->xdpf;
 
 			/* First, update TX stats if needed */
+			if (xdpf) {
+				bp->dev->stats.tx_packets++;
+				queue->stats.tx_packets++;
+				bp->dev->stats.tx_bytes += xdpf->len;
+				queue->stats.tx_bytes += xdpf->len;
+			}
 			if (skb) {
 				if (unlikely(skb_shinfo(skb)->tx_flags &
 					     SKBTX_HW_TSTAMP) &&
@@ -901,11 +925,12 @@ static void macb_tx_interrupt(struct macb_queue *queue)
 			/* Now we can safely release resources */
 			macb_tx_unmap(bp, tx_skb);
 
-			/* skb is set only for the last buffer of the frame.
+			/* skb or xdpf is set only for the last buffer of the
+			 * frame.
 			 * WARNING: at this point skb has been freed by
 			 * macb_tx_unmap().
 			 */
-			if (skb)
+			if (skb || xdpf)
 				break;
 		}
 	}
@@ -920,7 +945,7 @@ static void macb_tx_interrupt(struct macb_queue *queue)
 static void gem_rx_refill(struct macb_queue *queue)
 {
 	unsigned int		entry;
-	struct sk_buff		*skb;
+	struct page		*page;
 	dma_addr_t		paddr;
 	struct macb *bp = queue->bp;
 	struct macb_dma_desc *desc;
@@ -934,25 +959,21 @@ static void gem_rx_refill(struct macb_queue *queue)
 
 		desc = macb_rx_desc(queue, entry);
 
-		if (!queue->rx_skbuff[entry]) {
-			/* allocate sk_buff for this free entry in ring */
-			skb = netdev_alloc_skb(bp->dev, bp->rx_buffer_size);
-			if (unlikely(!skb)) {
+		if (!queue->rx_page[entry]) {
+			/* allocate a page for this free entry in ring */
+			page = page_pool_dev_alloc_pages(queue->page_pool);
+			if (unlikely(!page)) {
 				netdev_err(bp->dev,
-					   "Unable to allocate sk_buff\n");
+					   "Unable to allocate Rx page\n");
 				break;
 			}
 
-			/* now fill corresponding descriptor entry */
-			paddr = dma_map_single(&bp->pdev->dev, skb->data,
-					       bp->rx_buffer_size,
-					       DMA_FROM_DEVICE);
-			if (dma_mapping_error(&bp->pdev->dev, paddr)) {
-				dev_kfree_skb(skb);
-				break;
-			}
+			/* The pool synced the part of the buffer the device
+			 * and the CPU may have dirtied before handing it out.
+			 */
+			paddr = page_pool_get_dma_addr(page) + GEM_RX_HEADROOM;
 
-			queue->rx_skbuff[entry] = skb;
+			queue->rx_page[entry] = page;
 
 			if (entry == bp->rx_ring_size - 1)
 				paddr |= MACB_BIT(RX_WRAP);
@@ -962,9 +983,6 @@ static void gem_rx_refill(struct macb_queue *queue)
 			 */
 			dma_wmb();
 			macb_set_addr(bp, desc, paddr);
-
-			/* properly align Ethernet header */
-			skb_reserve(skb, NET_IP_ALIGN);
 		} else {
 			desc->ctrl = 0;
 			dma_wmb();
@@ -1001,15 +1019,101 @@ static void discard_partial_frame(struct macb_queue *queue, unsigned int begin,
 	 */
 }
 
-static int macb_validate_hw_csum(struct sk_buff *skb)
+static int macb_validate_hw_csum(const u8 *data, unsigned int len)
 {
-	u32 pkt_csum = *((u32 *)&skb->data[skb->len - ETH_FCS_LEN]);
-	u32 csum  = ~crc32_le(~0, skb_mac_header(skb),
-			skb->len + ETH_HLEN - ETH_FCS_LEN);
+	u32 pkt_csum = *((u32 *)&data[len - ETH_FCS_LEN]);
+	u32 csum  = ~crc32_le(~0, data, len - ETH_FCS_LEN);
 
 	return (pkt_csum != csum);
 }
 
+/**
+ * gem_rx_skb - Run XDP on a received frame and build its skb
+ * @queue: Rx queue the frame was received on
+ * @prog: XDP program, NULL if none is attached
+ * @page: Page pool page holding the frame
+ * @data: Start of the frame in @page
+ * @len: Length of the frame
+ * @xdp_redir: Set when the frame was redirected, the caller then flushes
+ *	the redirect maps at the end of the poll
+ *
+ * The program never sees the FCS, which is only kept in the buffer when
+ * Rx checksum offload is disabled. Frames passed to the stack are wrapped
+ * with build_skb() and their page leaves the pool.
+ *
+ * Return: skb to hand to the stack, or NULL if the frame was consumed
+ */
+static struct sk_buff *gem_rx_skb(struct macb_queue *queue,
+				  struct bpf_prog *prog, struct page *page,
+				  void *data, unsigned int len, bool *xdp_redir)
+{
+	struct macb *bp = queue->bp;
+	void *hard_start = page_address(page);
+	unsigned int sync_len = NET_IP_ALIGN + len;
+	struct xdp_buff xdp;
+	struct sk_buff *skb;
+	u32 act;
+
+	if (prog) {
+		if (!(bp->dev->features & NETIF_F_RXCSUM))
+			len -= ETH_FCS_LEN;
+
+		xdp.data_hard_start = hard_start;
+		xdp.data = data;
+		xdp_set_data_meta_invalid(&xdp);
+		xdp.data_end = data + len;
+		xdp.rxq = &queue->xdp_rxq;
+
+		act = bpf_prog_run_xdp(prog, &xdp);
+
+		/* A recycled page only needs syncing as far as either the
+		 * device or the program wrote into it.
+		 */
+		sync_len = max_t(unsigned int, sync_len,
+				 xdp.data_end - hard_start - GEM_RX_HEADROOM);
+
+		switch (act) {
+		case XDP_PASS:
+			/* The program may have moved the frame boundaries */
+			data = xdp.data;
+			len = xdp.data_end - xdp.data;
+			break;
+		case XDP_REDIRECT:
+			if (unlikely(xdp_do_redirect(bp->dev, &xdp, prog)))
+				goto out_failure;
+			*xdp_redir = true;
+			return NULL;
+		default:
+			bpf_warn_invalid_xdp_action(act);
+			/* fall through */
+		case XDP_TX:
+		case XDP_ABORTED:
+out_failure:
+			trace_xdp_exception(bp->dev, prog, act);
+			/* fall through */
+		case XDP_DROP:
+			page_pool_recycle_direct_len(queue->page_pool, page,
+						     sync_len);
+			return NULL;
+		}
+	}
+
+	skb = build_skb(hard_start, PAGE_SIZE << queue->page_pool->p.order);
+	if (unlikely(!skb)) {
+		page_pool_recycle_direct_len(queue->page_pool, page,
+					     sync_len);
+		bp->dev->stats.rx_dropped++;
+		queue->stats.rx_dropped++;
+		return NULL;
+	}
+
+	page_pool_release_page(queue->page_pool, page);
+	skb_reserve(skb, data - hard_start);
+	skb_put(skb, len);
+
+	return skb;
+}
+
 static int gem_rx(struct macb_queue *queue, struct napi_struct *napi,
 		  int budget)
 {
@@ -1018,8 +1122,15 @@ static int gem_rx(struct macb_queue *queue, struct napi_struct *napi,
 	unsigned int		entry;
 	struct sk_buff		*skb;
 	struct macb_dma_desc	*desc;
+	struct bpf_prog		*xdp_prog;
+	bool			xdp_redir = false;
+	struct page		*page;
+	void			*data;
 	int			count = 0;
 
+	rcu_read_lock();
+	xdp_prog = READ_ONCE(bp->xdp_prog);
+
 	while (count < budget) {
 		u32 ctrl;
 		dma_addr_t addr;
@@ -1052,8 +1163,8 @@ static int gem_rx(struct macb_queue *queue, struct napi_struct *napi,
 			queue->stats.rx_dropped++;
 			break;
 		}
-		skb = queue->rx_skbuff[entry];
-		if (unlikely(!skb)) {
+		page = queue->rx_page[entry];
+		if (unlikely(!page)) {
 			netdev_err(bp->dev,
 				   "inconsistent Rx descriptor chain\n");
 			bp->dev->stats.rx_dropped++;
@@ -1061,26 +1172,35 @@ static int gem_rx(struct macb_queue *queue, struct napi_struct *napi,
 			break;
 		}
 		/* now everything is ready for receiving packet */
-		queue->rx_skbuff[entry] = NULL;
+		queue->rx_page[entry] = NULL;
 		len = ctrl & bp->rx_frm_len_mask;
 
 		netdev_vdbg(bp->dev, "gem_rx %u (len %u)\n", entry, len);
 
-		skb_put(skb, len);
-		dma_unmap_single(&bp->pdev->dev, addr,
-				 bp->rx_buffer_size, DMA_FROM_DEVICE);
-
-		skb->protocol = eth_type_trans(skb, bp->dev);
+		dma_sync_single_for_cpu(&bp->pdev->dev, addr,
+					NET_IP_ALIGN + len, DMA_FROM_DEVICE);
+		data = page_address(page) + GEM_RX_HEADROOM + NET_IP_ALIGN;
 
 		/* Validate MAC fcs if RX checsum offload disabled */
 		if (!(bp->dev->features & NETIF_F_RXCSUM)) {
-			if (macb_validate_hw_csum(skb)) {
+			if (macb_validate_hw_csum(data, len)) {
 				netdev_err(bp->dev, "incorrect FCS\n");
 				bp->dev->stats.rx_dropped++;
+				page_pool_recycle_direct_len(queue->page_pool,
+							     page,
+							     NET_IP_ALIGN +
+							     len);
 				break;
 			}
 		}
 
+		skb = gem_rx_skb(queue, xdp_prog, page, data, len,
+				 &xdp_redir);
+		if (!skb)
+			continue;
+
+		skb->protocol = eth_type_trans(skb, bp->dev);
+
 		skb_checksum_none_assert(skb);
 		if (bp->dev->features & NETIF_F_RXCSUM &&
 		    !(bp->dev->flags & IFF_PROMISC) &&
@@ -1106,6 +1226,10 @@ static int gem_rx(struct macb_queue *queue, struct napi_struct *napi,
 		napi_gro_receive(napi, skb);
 	}
 
+	if (xdp_redir)
+		xdp_do_flush_map();
+	rcu_read_unlock();
+
 	gem_rx_refill(queue);
 
 	return count;
@@ -1180,7 +1304,8 @@ static int macb_rx_frame(struct macb_queue *queue, struct napi_struct *napi,
 
 	/* Validate MAC fcs if RX checsum offload disabled */
 	if (!(bp->dev->features & NETIF_F_RXCSUM)) {
-		if (macb_validate_hw_csum(skb)) {
+		if (macb_validate_hw_csum(skb->data + NET_IP_ALIGN,
+					  skb->len - NET_IP_ALIGN)) {
 			netdev_err(bp->dev, "incorrect FCS\n");
 			bp->dev->stats.rx_dropped++;
 
@@ -1918,6 +2043,116 @@ static netdev_tx_t macb_start_xmit(struct sk_buff *skb, struct net_device *dev)
 	return ret;
 }
 
+/**
+ * macb_xdp_queue_one - Queue one redirected XDP frame on a Tx ring
+ * @queue: Tx queue, with bp->lock held
+ * @xdpf: XDP frame to transmit
+ *
+ * The frame may come from any driver, it is mapped for the GEM here and
+ * takes a single buffer descriptor. Transmission is not started.
+ *
+ * Return: 0 on success, negative error code otherwise
+ */
+static int macb_xdp_queue_one(struct macb_queue *queue,
+			      struct xdp_frame *xdpf)
+{
+	struct macb *bp = queue->bp;
+	struct macb_tx_skb *tx_skb;
+	struct macb_dma_desc *desc;
+	unsigned int entry;
+	dma_addr_t mapping;
+	u32 ctrl;
+
+	if (CIRC_SPACE(queue->tx_head, queue->tx_tail, bp->tx_ring_size) < 1)
+		return -ENOSPC;
+
+	if (xdpf->len > bp->max_tx_length)
+		return -EINVAL;
+
+	mapping = dma_map_single(&bp->pdev->dev, xdpf->data, xdpf->len,
+				 DMA_TO_DEVICE);
+	if (dma_mapping_error(&bp->pdev->dev, mapping))
+		return -ENOMEM;
+
+	entry = macb_tx_ring_wrap(bp, queue->tx_head);
+	tx_skb = &queue->tx_skb[entry];
+	tx_skb->skb = NULL;
+	tx_skb->xdpf = xdpf;
+	tx_skb->mapping = mapping;
+	tx_skb->size = xdpf->len;
+	tx_skb->mapped_as_page = false;
+
+	/* Set end of TX queue before handing the descriptor over */
+	desc = macb_tx_desc(queue, queue->tx_head + 1);
+	desc->ctrl = MACB_BIT(TX_USED);
+
+	ctrl = xdpf->len | MACB_BIT(TX_LAST);
+	if (unlikely(entry == (bp->tx_ring_size - 1)))
+		ctrl |= MACB_BIT(TX_WRAP);
+
+	desc = macb_tx_desc(queue, entry);
+	macb_set_addr(bp, desc, mapping);
+	/* desc->addr must be visible to hardware before clearing
+	 * 'TX_USED' bit in desc->ctrl.
+	 */
+	wmb();
+	desc->ctrl = ctrl;
+
+	queue->tx_head++;
+
+	return 0;
+}
+
+/**
+ * macb_xdp_xmit - ndo_xdp_xmit handler
+ * @dev: network device
+ * @n: number of frames
+ * @frames: redirected XDP frames
+ * @flags: XDP_XMIT_* flags
+ *
+ * The frames of a devmap bulk queue are all put on the ring first and
+ * transmission is started once, when the redirecting driver flushes at
+ * the end of its NAPI poll. A batch thus costs a single TSTART write
+ * instead of one per frame.
+ *
+ * Return: number of frames queued for transmission, or negative error
+ */
+static int macb_xdp_xmit(struct net_device *dev, int n,
+			 struct xdp_frame **frames, u32 flags)
+{
+	struct macb *bp = netdev_priv(dev);
+	struct macb_queue *queue;
+	unsigned long irqflags;
+	int i, drops = 0;
+
+	if (unlikely(flags & ~XDP_XMIT_FLAGS_MASK))
+		return -EINVAL;
+
+	if (unlikely(!netif_running(dev) || !netif_carrier_ok(dev)))
+		return -ENETDOWN;
+
+	queue = &bp->queues[smp_processor_id() % bp->num_queues];
+
+	spin_lock_irqsave(&bp->lock, irqflags);
+	for (i = 0; i < n; i++) {
+		if (macb_xdp_queue_one(queue, frames[i])) {
+			xdp_return_frame_rx_napi(frames[i]);
+			drops++;
+		}
+	}
+
+	if (flags & XDP_XMIT_FLUSH) {
+		/* Make newly initialized descriptors visible to hardware */
+		wmb();
+		macb_writel(bp, NCR, macb_readl(bp, NCR) | MACB_BIT(TSTART));
+	}
+	spin_unlock_irqrestore(&bp->lock, irqflags);
+
+	dev->stats.tx_dropped += drops;
+
+	return n - drops;
+}
+
 static void macb_init_rx_buffer_size(struct macb *bp, size_t size)
 {
 	if (!macb_is_gem(bp)) {
@@ -1940,34 +2175,29 @@ static void macb_init_rx_buffer_size(struct macb *bp, size_t size)
 
 static void gem_free_rx_buffers(struct macb *bp)
 {
-	struct sk_buff		*skb;
-	struct macb_dma_desc	*desc;
 	struct macb_queue *queue;
-	dma_addr_t		addr;
+	struct page *page;
 	unsigned int q;
 	int i;
 
 	for (q = 0, queue = bp->queues; q < bp->num_queues; ++q, ++queue) {
-		if (!queue->rx_skbuff)
-			continue;
-
-		for (i = 0; i < bp->rx_ring_size; i++) {
-			skb = queue->rx_skbuff[i];
+		if (queue->rx_page) {
+			for (i = 0; i < bp->rx_ring_size; i++) {
+				page = queue->rx_page[i];
 
-			if (!skb)
-				continue;
-
-			desc = macb_rx_desc(queue, i);
-			addr = macb_get_addr(bp, desc);
+				if (page)
+					page_pool_put_page(queue->page_pool,
+							   page, false);
+			}
 
-			dma_unmap_single(&bp->pdev->dev, addr, bp->rx_buffer_size,
-					DMA_FROM_DEVICE);
-			dev_kfree_skb_any(skb);
-			skb = NULL;
+			kfree(queue->rx_page);
+			queue->rx_page = NULL;
 		}
 
-		kfree(queue->rx_skbuff);
-		queue->rx_skbuff = NULL;
+		if (xdp_rxq_info_is_reg(&queue->xdp_rxq))
+			xdp_rxq_info_unreg(&queue->xdp_rxq);
+		page_pool_destroy(queue->page_pool);
+		queue->page_pool = NULL;
 	}
 }
 
@@ -2015,6 +2245,46 @@ static void macb_free_consistent(struct macb *bp)
 	}
 }
 
+/**
+ * gem_rx_pool_create - Create the page pool and XDP info of a Rx queue
+ * @queue: Rx queue
+ *
+ * The pool pages are DMA mapped once, when they enter the pool, and are
+ * recycled by the Rx path without being unmapped.
+ *
+ * Return: 0 on success, negative error code otherwise
+ */
+static int gem_rx_pool_create(struct macb_queue *queue)
+{
+	struct macb *bp = queue->bp;
+	struct page_pool_params pp_params = { 0 };
+	struct page_pool *pool;
+	int err;
+
+	pp_params.order = get_order(GEM_RX_HEADROOM + bp->rx_buffer_size +
+				    GEM_RX_TAILROOM);
+	pp_params.flags = PP_FLAG_DMA_MAP | PP_FLAG_DMA_SYNC_DEV;
+	pp_params.pool_size = bp->rx_ring_size;
+	pp_params.nid = dev_to_node(&bp->pdev->dev);
+	pp_params.dev = &bp->pdev->dev;
+	pp_params.dma_dir = DMA_FROM_DEVICE;
+	pp_params.max_len = bp->rx_buffer_size;
+	pp_params.offset = GEM_RX_HEADROOM;
+
+	pool = page_pool_create(&pp_params);
+	if (IS_ERR(pool))
+		return PTR_ERR(pool);
+
+	queue->page_pool = pool;
+
+	err = xdp_rxq_info_reg(&queue->xdp_rxq, bp->dev, queue - bp->queues);
+	if (err)
+		return err;
+
+	return xdp_rxq_info_reg_mem_model(&queue->xdp_rxq, MEM_TYPE_PAGE_POOL,
+					  pool);
+}
+
 static int gem_alloc_rx_buffers(struct macb *bp)
 {
 	struct macb_queue *queue;
@@ -2022,14 +2292,17 @@ static int gem_alloc_rx_buffers(struct macb *bp)
 	int size;
 
 	for (q = 0, queue = bp->queues; q < bp->num_queues; ++q, ++queue) {
-		size = bp->rx_ring_size * sizeof(struct sk_buff *);
-		queue->rx_skbuff = kzalloc(size, GFP_KERNEL);
-		if (!queue->rx_skbuff)
+		if (gem_rx_pool_create(queue))
+			return -ENOMEM;
+
+		size = bp->rx_ring_size * sizeof(struct page *);
+		queue->rx_page = kzalloc(size, GFP_KERNEL);
+		if (!queue->rx_page)
 			return -ENOMEM;
 		else
 			netdev_dbg(bp->dev,
-				   "Allocated %d RX struct sk_buff entries at %p\n",
-				   bp->rx_ring_size, queue->rx_skbuff);
+				   "Allocated %d RX page entries at %p\n",
+				   bp->rx_ring_size, queue->rx_page);
 	}
 	return 0;
 }
@@ -2070,7 +2343,7 @@ static int macb_alloc_consistent(struct macb *bp)
 			   queue->tx_ring);
 
 		size = bp->tx_ring_size * sizeof(struct macb_tx_skb);
-		queue->tx_skb = kmalloc(size, GFP_KERNEL);
+		queue->tx_skb = kzalloc(size, GFP_KERNEL);
 		if (!queue->tx_skb)
 			goto out_err;
 
@@ -2604,11 +2877,27 @@ static int macb_close(struct net_device *dev)
 	return 0;
 }
 
+/* Check whether a frame of the given MTU fits a single page Rx buffer */
+static bool gem_xdp_mtu_fits(int mtu)
+{
+	size_t size = roundup(mtu + ETH_HLEN + ETH_FCS_LEN + NET_IP_ALIGN,
+			      RX_BUFFER_MULTIPLE);
+
+	return GEM_RX_HEADROOM + size + GEM_RX_TAILROOM <= PAGE_SIZE;
+}
+
 static int macb_change_mtu(struct net_device *dev, int new_mtu)
 {
+	struct macb *bp = netdev_priv(dev);
+
 	if (netif_running(dev))
 		return -EBUSY;
 
+	if (bp->xdp_prog && !gem_xdp_mtu_fits(new_mtu)) {
+		netdev_err(dev, "MTU %d too large for XDP\n", new_mtu);
+		return -EINVAL;
+	}
+
 	dev->mtu = new_mtu;
 
 	return 0;
@@ -3066,6 +3355,64 @@ static void gem_prog_cmp_regs(struct macb *bp, struct ethtool_rx_flow_spec *fs)
 	gem_writel_n(bp, SCRT2, index, t2_scr);
 }
 
+/* GEM has no Rx hash, so flows are spread on the low bits of the TCP/UDP
+ * source port instead. Entry i of the indirection table is a type 2
+ * screener on one of the last rss_indir_size screener slots, matching the
+ * IPv4 frames whose source port ends with i. Frames matched by an ntuple
+ * rule first and non IPv4 frames are not spread. An all zero table keeps
+ * the screeners disabled.
+ */
+static unsigned int gem_rss_first(struct macb *bp)
+{
+	return bp->max_tuples - bp->rss_indir_size;
+}
+
+static bool gem_rss_enabled(struct macb *bp)
+{
+	unsigned int i;
+
+	for (i = 0; i < bp->rss_indir_size; i++)
+		if (bp->rss_indir[i])
+			return true;
+
+	return false;
+}
+
+static void gem_rss_apply(struct macb *bp)
+{
+	u16 mask = bp->rss_indir_size - 1;
+	bool enable = gem_rss_enabled(bp);
+	unsigned int i, index;
+	u32 w0, w1, t2_scr;
+
+	for (i = 0; i < bp->rss_indir_size; i++) {
+		index = gem_rss_first(bp) + i;
+		if (!enable) {
+			gem_writel_n(bp, SCRT2, index, 0);
+			continue;
+		}
+
+		/* 16-bit compare of the source port under the index mask */
+		w0 = 0;
+		w1 = 0;
+		w0 = GEM_BFINS(T2CMP, (__force u16)htons(i), w0);
+		w0 = GEM_BFINS(T2MASK, (__force u16)htons(mask), w0);
+		w1 = GEM_BFINS(T2DISMSK, 0, w1);
+		w1 = GEM_BFINS(T2CMPOFST, GEM_T2COMPOFST_IPHDR, w1);
+		w1 = GEM_BFINS(T2OFST, IPHDR_SRCPORT_OFFSET, w1);
+		gem_writel_n(bp, T2CMPW0, T2CMP_OFST(GEM_PORT_CMP(index)), w0);
+		gem_writel_n(bp, T2CMPW1, T2CMP_OFST(GEM_PORT_CMP(index)), w1);
+
+		t2_scr = 0;
+		t2_scr = GEM_BFINS(QUEUE, bp->rss_indir[i], t2_scr);
+		t2_scr = GEM_BFINS(ETHT2IDX, SCRT2_ETHT, t2_scr);
+		t2_scr = GEM_BFINS(ETHTEN, 1, t2_scr);
+		t2_scr = GEM_BFINS(CMPC, GEM_PORT_CMP(index), t2_scr);
+		t2_scr = GEM_BFINS(CMPCEN, 1, t2_scr);
+		gem_writel_n(bp, SCRT2, index, t2_scr);
+	}
+}
+
 static int gem_add_flow_filter(struct net_device *netdev,
 		struct ethtool_rxnfc *cmd)
 {
@@ -3090,6 +3437,13 @@ static int gem_add_flow_filter(struct net_device *netdev,
 
 	spin_lock_irqsave(&bp->rx_fs_lock, flags);
 
+	if (gem_rss_enabled(bp) && fs->location >= gem_rss_first(bp)) {
+		netdev_err(netdev, "Rule not added: location %d used for Rx flow spreading\n",
+			   fs->location);
+		ret = -EBUSY;
+		goto err;
+	}
+
 	/* find correct place to add in list */
 	list_for_each_entry(item, &bp->rx_fs_list.list, list) {
 		if (item->fs.location > newfs->fs.location) {
@@ -3244,6 +3598,72 @@ static int gem_set_rxnfc(struct net_device *netdev, struct ethtool_rxnfc *cmd)
 	return ret;
 }
 
+static u32 gem_get_rxfh_indir_size(struct net_device *netdev)
+{
+	struct macb *bp = netdev_priv(netdev);
+
+	return bp->rss_indir_size;
+}
+
+static int gem_get_rxfh(struct net_device *netdev, u32 *indir, u8 *key,
+			u8 *hfunc)
+{
+	struct macb *bp = netdev_priv(netdev);
+	unsigned long flags;
+
+	if (hfunc)
+		*hfunc = ETH_RSS_HASH_UNKNOWN;
+
+	if (indir) {
+		spin_lock_irqsave(&bp->rx_fs_lock, flags);
+		memcpy(indir, bp->rss_indir,
+		       bp->rss_indir_size * sizeof(*indir));
+		spin_unlock_irqrestore(&bp->rx_fs_lock, flags);
+	}
+
+	return 0;
+}
+
+static int gem_set_rxfh(struct net_device *netdev, const u32 *indir,
+			const u8 *key, const u8 hfunc)
+{
+	struct macb *bp = netdev_priv(netdev);
+	struct ethtool_rx_fs_item *item;
+	unsigned long flags;
+	unsigned int i;
+	bool enable = false;
+
+	if (key || hfunc != ETH_RSS_HASH_NO_CHANGE)
+		return -EOPNOTSUPP;
+
+	if (!indir)
+		return 0;
+
+	for (i = 0; i < bp->rss_indir_size; i++)
+		enable |= !!indir[i];
+
+	spin_lock_irqsave(&bp->rx_fs_lock, flags);
+
+	/* the spreading screeners must not overwrite ntuple rules */
+	if (enable) {
+		list_for_each_entry(item, &bp->rx_fs_list.list, list) {
+			if (item->fs.location >= gem_rss_first(bp)) {
+				spin_unlock_irqrestore(&bp->rx_fs_lock, flags);
+				netdev_err(netdev, "Rx flow spreading needs locations %u to %u free\n",
+					   gem_rss_first(bp), bp->max_tuples - 1);
+				return -EBUSY;
+			}
+		}
+	}
+
+	memcpy(bp->rss_indir, indir, bp->rss_indir_size * sizeof(*indir));
+	gem_rss_apply(bp);
+
+	spin_unlock_irqrestore(&bp->rx_fs_lock, flags);
+
+	return 0;
+}
+
 static const struct ethtool_ops macb_ethtool_ops = {
 	.get_regs_len		= macb_get_regs_len,
 	.get_regs		= macb_get_regs,
@@ -3269,6 +3689,9 @@ static const struct ethtool_ops gem_ethtool_ops = {
 	.set_ringparam		= macb_set_ringparam,
 	.get_rxnfc			= gem_get_rxnfc,
 	.set_rxnfc			= gem_set_rxnfc,
+	.get_rxfh_indir_size	= gem_get_rxfh_indir_size,
+	.get_rxfh		= gem_get_rxfh,
+	.set_rxfh		= gem_set_rxfh,
 };
 
 static int macb_ioctl(struct net_device *dev, struct ifreq *rq, int cmd)
@@ -3373,6 +3796,52 @@ static void macb_restore_features(struct macb *bp)
 
 	/* RX Flow Filters */
 	macb_set_rxflow_feature(bp, features);
+
+	/* RX flow spreading */
+	if (bp->rss_indir_size)
+		gem_rss_apply(bp);
+}
+
+/**
+ * macb_xdp - ndo_bpf handler
+ * @dev: Pointer to net_device structure
+ * @bpf: Pointer to the netdev_bpf command
+ *
+ * XDP runs on the GEM Rx path only. The page pool is mapped for device
+ * writes only and stays as is, so programs are swapped on the fly.
+ *
+ * Return: 0 on success, negative error code otherwise
+ */
+static int macb_xdp(struct net_device *dev, struct netdev_bpf *bpf)
+{
+	struct macb *bp = netdev_priv(dev);
+	struct bpf_prog *prog = bpf->prog;
+	struct bpf_prog *old_prog;
+
+	switch (bpf->command) {
+	case XDP_SETUP_PROG:
+		if (prog && !macb_is_gem(bp)) {
+			NL_SET_ERR_MSG_MOD(bpf->extack,
+					   "XDP is only supported on GEM");
+			return -EOPNOTSUPP;
+		}
+
+		if (prog && !gem_xdp_mtu_fits(dev->mtu)) {
+			NL_SET_ERR_MSG_MOD(bpf->extack,
+					   "MTU too large for XDP");
+			return -EINVAL;
+		}
+
+		old_prog = xchg(&bp->xdp_prog, prog);
+		if (old_prog)
+			bpf_prog_put(old_prog);
+		return 0;
+	case XDP_QUERY_PROG:
+		bpf->prog_id = bp->xdp_prog ? bp->xdp_prog->aux->id : 0;
+		return 0;
+	default:
+		return -EINVAL;
+	}
 }
 
 static const struct net_device_ops macb_netdev_ops = {
@@ -3390,6 +3859,8 @@ static const struct net_device_ops macb_netdev_ops = {
 #endif
 	.ndo_set_features	= macb_set_features,
 	.ndo_features_check	= macb_features_check,
+	.ndo_bpf		= macb_xdp,
+	.ndo_xdp_xmit		= macb_xdp_xmit,
 };
 
 /* Configure peripheral capabilities according to device tree
@@ -3695,6 +4166,11 @@ static int macb_init(struct platform_device *pdev)
 			INIT_LIST_HEAD(&bp->rx_fs_list.list);
 			bp->rx_fs_list.count = 0;
 			spin_lock_init(&bp->rx_fs_lock);
+			/* half of the screeners can spread flows over queues */
+			if (bp->max_tuples >= 4 && bp->num_queues > 1)
+				bp->rss_indir_size =
+					min_t(unsigned int, GEM_RSS_MAX_INDIR,
+					      rounddown_pow_of_two(bp->max_tuples / 2));
 		} else
 			bp->max_tuples = 0;
 	}
@@ -357,7 +357,7 @@ struct temac_local {
 	int emac_num;
 
 	struct sk_buff **rx_skb;
-	spinlock_t rx_lock;
+	struct napi_struct napi;
 	/* For synchronization of indirect register access.  Must be
 	 * shared mutex between interfaces in same TEMAC block.
 	 */
@@ -319,6 +319,25 @@ static void temac_dma_bd_release(struct net_device *ndev)
 				lp->tx_bd_v, lp->tx_bd_p);
 }
 
+/**
+ * temac_dma_chnl_ctrl_setup - Program the DMA interrupt coalescing
+ * @lp: Pointer to the TEMAC private data
+ *
+ * The channel control registers hold the delay timeout in bits 31:24 and
+ * the completed BD count in bits 23:16 of the interrupt coalescing.
+ */
+static void temac_dma_chnl_ctrl_setup(struct temac_local *lp)
+{
+	lp->dma_out(lp, TX_CHNL_CTRL, lp->tx_chnl_ctrl |
+		    0x00000400 | // Use 1 Bit Wide Counters. Currently Not Used!
+		    CHNL_CTRL_IRQ_EN | CHNL_CTRL_IRQ_ERR_EN |
+		    CHNL_CTRL_IRQ_DLY_EN | CHNL_CTRL_IRQ_COAL_EN);
+	lp->dma_out(lp, RX_CHNL_CTRL, lp->rx_chnl_ctrl |
+		    CHNL_CTRL_IRQ_IOE |
+		    CHNL_CTRL_IRQ_EN | CHNL_CTRL_IRQ_ERR_EN |
+		    CHNL_CTRL_IRQ_DLY_EN | CHNL_CTRL_IRQ_COAL_EN);
+}
+
 /**
  * temac_dma_bd_init - Setup buffer descriptor rings
  */
@@ -373,14 +392,7 @@ static int temac_dma_bd_init(struct net_device *ndev)
 	}
 
 	/* Configure DMA channel (irq setup) */
-	lp->dma_out(lp, TX_CHNL_CTRL, lp->tx_chnl_ctrl |
-		    0x00000400 | // Use 1 Bit Wide Counters. Currently Not Used!
-		    CHNL_CTRL_IRQ_EN | CHNL_CTRL_IRQ_ERR_EN |
-		    CHNL_CTRL_IRQ_DLY_EN | CHNL_CTRL_IRQ_COAL_EN);
-	lp->dma_out(lp, RX_CHNL_CTRL, lp->rx_chnl_ctrl |
-		    CHNL_CTRL_IRQ_IOE |
-		    CHNL_CTRL_IRQ_EN | CHNL_CTRL_IRQ_ERR_EN |
-		    CHNL_CTRL_IRQ_DLY_EN | CHNL_CTRL_IRQ_COAL_EN);
+	temac_dma_chnl_ctrl_setup(lp);
 
 	/* Init descriptor indexes */
 	lp->tx_bd_ci = 0;
@@ -755,7 +767,7 @@ static void *ptr_from_txbd(struct cdmac_bd *bd)
 
 #endif
 
-static void temac_start_xmit_done(struct net_device *ndev)
+static void temac_start_xmit_done(struct net_device *ndev, int budget)
 {
 	struct temac_local *lp = netdev_priv(ndev);
 	struct cdmac_bd *cur_p;
@@ -770,7 +782,7 @@ static void temac_start_xmit_done(struct net_device *ndev)
 				 be32_to_cpu(cur_p->len), DMA_TO_DEVICE);
 		skb = (struct sk_buff *)ptr_from_txbd(cur_p);
 		if (skb)
-			dev_consume_skb_irq(skb);
+			napi_consume_skb(skb, budget);
 		cur_p->app0 = 0;
 		cur_p->app1 = 0;
 		cur_p->app2 = 0;
@@ -788,7 +800,8 @@ static void temac_start_xmit_done(struct net_device *ndev)
 		stat = be32_to_cpu(cur_p->app0);
 	}
 
-	netif_wake_queue(ndev);
+	if (netif_queue_stopped(ndev))
+		netif_wake_queue(ndev);
 }
 
 static inline int temac_check_tx_bd_space(struct temac_local *lp, int num_frag)
@@ -885,7 +898,8 @@ temac_start_xmit(struct sk_buff *skb, struct net_device *ndev)
 }
 
 
-static void ll_temac_recv(struct net_device *ndev)
+/* Returns the number of packets received, at most @budget */
+static int ll_temac_recv(struct net_device *ndev, int budget)
 {
 	struct temac_local *lp = netdev_priv(ndev);
 	struct sk_buff *skb, *new_skb;
@@ -893,15 +907,21 @@ static void ll_temac_recv(struct net_device *ndev)
 	struct cdmac_bd *cur_p;
 	dma_addr_t tail_p, skb_dma_addr;
 	int length;
-	unsigned long flags;
-
-	spin_lock_irqsave(&lp->rx_lock, flags);
+	int work_done = 0;
 
 	tail_p = lp->rx_bd_p + sizeof(*lp->rx_bd_v) * lp->rx_bd_ci;
 	cur_p = &lp->rx_bd_v[lp->rx_bd_ci];
 
 	bdstat = be32_to_cpu(cur_p->app0);
-	while ((bdstat & STS_CTRL_APP0_CMPLT)) {
+	while ((bdstat & STS_CTRL_APP0_CMPLT) && work_done < budget) {
+		work_done++;
+
+		/* Drop the frame and reuse its buffer if there is no new one */
+		new_skb = napi_alloc_skb(&lp->napi, XTE_MAX_JUMBO_FRAME_SIZE);
+		if (!new_skb) {
+			ndev->stats.rx_dropped++;
+			goto rearm;
+		}
 
 		skb = lp->rx_skb[lp->rx_bd_ci];
 		length = be32_to_cpu(cur_p->app4) & 0x3FFF;
@@ -928,19 +948,11 @@ static void ll_temac_recv(struct net_device *ndev)
 		}
 
 		if (!skb_defer_rx_timestamp(skb))
-			netif_rx(skb);
+			napi_gro_receive(&lp->napi, skb);
 
 		ndev->stats.rx_packets++;
 		ndev->stats.rx_bytes += length;
 
-		new_skb = netdev_alloc_skb_ip_align(ndev,
-						XTE_MAX_JUMBO_FRAME_SIZE);
-		if (!new_skb) {
-			spin_unlock_irqrestore(&lp->rx_lock, flags);
-			return;
-		}
-
-		cur_p->app0 = cpu_to_be32(STS_CTRL_APP0_IRQONEND);
 		skb_dma_addr = dma_map_single(ndev->dev.parent, new_skb->data,
 					      XTE_MAX_JUMBO_FRAME_SIZE,
 					      DMA_FROM_DEVICE);
@@ -948,6 +960,9 @@ static void ll_temac_recv(struct net_device *ndev)
 		cur_p->len = cpu_to_be32(XTE_MAX_JUMBO_FRAME_SIZE);
 		lp->rx_skb[lp->rx_bd_ci] = new_skb;
 
+rearm:
+		cur_p->app0 = cpu_to_be32(STS_CTRL_APP0_IRQONEND);
+		tail_p = lp->rx_bd_p + sizeof(*lp->rx_bd_v) * lp->rx_bd_ci;
 		lp->rx_bd_ci++;
 		if (lp->rx_bd_ci >= RX_BD_NUM)
 			lp->rx_bd_ci = 0;
@@ -955,9 +970,43 @@ static void ll_temac_recv(struct net_device *ndev)
 		cur_p = &lp->rx_bd_v[lp->rx_bd_ci];
 		bdstat = be32_to_cpu(cur_p->app0);
 	}
-	lp->dma_out(lp, RX_TAILDESC_PTR, tail_p);
 
-	spin_unlock_irqrestore(&lp->rx_lock, flags);
+	/* Hand all the BDs refilled in this pass back to the DMA at once */
+	if (work_done) {
+		wmb();
+		lp->dma_out(lp, RX_TAILDESC_PTR, tail_p);
+	}
+
+	return work_done;
+}
+
+static int temac_poll(struct napi_struct *napi, int budget)
+{
+	struct temac_local *lp = container_of(napi, struct temac_local, napi);
+	int work_done;
+
+	temac_start_xmit_done(lp->ndev, budget);
+	work_done = ll_temac_recv(lp->ndev, budget);
+
+	if (work_done < budget && napi_complete_done(napi, work_done)) {
+		enable_irq(lp->tx_irq);
+		enable_irq(lp->rx_irq);
+	}
+
+	return work_done;
+}
+
+/*
+ * Both DMA channels are serviced from the one NAPI context, with both
+ * interrupt lines masked until it completes.
+ */
+static void temac_napi_schedule(struct temac_local *lp)
+{
+	if (napi_schedule_prep(&lp->napi)) {
+		disable_irq_nosync(lp->tx_irq);
+		disable_irq_nosync(lp->rx_irq);
+		__napi_schedule(&lp->napi);
+	}
 }
 
 static irqreturn_t ll_temac_tx_irq(int irq, void *_ndev)
@@ -970,7 +1019,7 @@ static irqreturn_t ll_temac_tx_irq(int irq, void *_ndev)
 	lp->dma_out(lp, TX_IRQ_REG, status);
 
 	if (status & (IRQ_COAL | IRQ_DLY))
-		temac_start_xmit_done(lp->ndev);
+		temac_napi_schedule(lp);
 	if (status & (IRQ_ERR | IRQ_DMAERR))
 		dev_err_ratelimited(&ndev->dev,
 				    "TX error 0x%x TX_CHNL_STS=0x%08x\n",
@@ -990,7 +1039,7 @@ static irqreturn_t ll_temac_rx_irq(int irq, void *_ndev)
 	lp->dma_out(lp, RX_IRQ_REG, status);
 
 	if (status & (IRQ_COAL | IRQ_DLY))
-		ll_temac_recv(lp->ndev);
+		temac_napi_schedule(lp);
 	if (status & (IRQ_ERR | IRQ_DMAERR))
 		dev_err_ratelimited(&ndev->dev,
 				    "RX error 0x%x RX_CHNL_STS=0x%08x\n",
@@ -1026,6 +1075,7 @@ static int temac_open(struct net_device *ndev)
 	}
 
 	temac_device_reset(ndev);
+	napi_enable(&lp->napi);
 
 	rc = request_irq(lp->tx_irq, ll_temac_tx_irq, 0, ndev->name, ndev);
 	if (rc)
@@ -1039,6 +1089,7 @@ static int temac_open(struct net_device *ndev)
  err_rx_irq:
 	free_irq(lp->tx_irq, ndev);
  err_tx_irq:
+	napi_disable(&lp->napi);
 	if (phydev)
 		phy_disconnect(phydev);
 	dev_err(lp->dev, "request_irq() failed\n");
@@ -1052,6 +1103,7 @@ static int temac_stop(struct net_device *ndev)
 
 	dev_dbg(&ndev->dev, "temac_close()\n");
 
+	napi_disable(&lp->napi);
 	free_irq(lp->tx_irq, ndev);
 	free_irq(lp->rx_irq, ndev);
 
@@ -1134,12 +1186,59 @@ static const struct attribute_group temac_attr_group = {
 };
 
 /* ethtool support */
+
+/*
+ * The delay timer counts in units of 512 DMA clock cycles, taken to run
+ * at 100 MHz here.
+ */
+#define TEMAC_COALESCE_DELAY_TO_USECS(d)	((d) * 512 / 100)
+#define TEMAC_COALESCE_USECS_TO_DELAY(u)	\
+	min_t(u32, 255, DIV_ROUND_UP((u) * 100, 512))
+
+static int temac_get_coalesce(struct net_device *ndev,
+			      struct ethtool_coalesce *ec)
+{
+	struct temac_local *lp = netdev_priv(ndev);
+
+	ec->rx_max_coalesced_frames = (lp->rx_chnl_ctrl >> 16) & 0xff;
+	ec->tx_max_coalesced_frames = (lp->tx_chnl_ctrl >> 16) & 0xff;
+	ec->rx_coalesce_usecs =
+		TEMAC_COALESCE_DELAY_TO_USECS(lp->rx_chnl_ctrl >> 24);
+	ec->tx_coalesce_usecs =
+		TEMAC_COALESCE_DELAY_TO_USECS(lp->tx_chnl_ctrl >> 24);
+	return 0;
+}
+
+static int temac_set_coalesce(struct net_device *ndev,
+			      struct ethtool_coalesce *ec)
+{
+	struct temac_local *lp = netdev_priv(ndev);
+
+	if (!ec->rx_max_coalesced_frames || ec->rx_max_coalesced_frames > 255 ||
+	    !ec->tx_max_coalesced_frames || ec->tx_max_coalesced_frames > 255)
+		return -EINVAL;
+
+	lp->rx_chnl_ctrl =
+		(TEMAC_COALESCE_USECS_TO_DELAY(ec->rx_coalesce_usecs) << 24) |
+		(ec->rx_max_coalesced_frames << 16);
+	lp->tx_chnl_ctrl =
+		(TEMAC_COALESCE_USECS_TO_DELAY(ec->tx_coalesce_usecs) << 24) |
+		(ec->tx_max_coalesced_frames << 16);
+
+	if (netif_running(ndev))
+		temac_dma_chnl_ctrl_setup(lp);
+
+	return 0;
+}
+
 static const struct ethtool_ops temac_ethtool_ops = {
 	.nway_reset = phy_ethtool_nway_reset,
 	.get_link = ethtool_op_get_link,
 	.get_ts_info = ethtool_op_get_ts_info,
 	.get_link_ksettings = phy_ethtool_get_link_ksettings,
 	.set_link_ksettings = phy_ethtool_set_link_ksettings,
+	.get_coalesce = temac_get_coalesce,
+	.set_coalesce = temac_set_coalesce,
 };
 
 static int temac_probe(struct platform_device *pdev)
@@ -1183,7 +1282,7 @@ static int temac_probe(struct platform_device *pdev)
 	lp->ndev = ndev;
 	lp->dev = &pdev->dev;
 	lp->options = XTE_OPTION_DEFAULTS;
-	spin_lock_init(&lp->rx_lock);
+	netif_napi_add(ndev, &lp->napi, temac_poll, NAPI_POLL_WEIGHT);
 
 	/* Setup mutex for synchronization of indirect register access */
 	if (pdata) {
@@ -16,6 +16,10 @@
 #include <linux/net_tstamp.h>
 #include <linux/phy.h>
 #include <linux/of_platform.h>
+#include <linux/dim.h>
+#include <linux/u64_stats_sync.h>
+#include <net/xdp.h>
+#include <net/pkt_sched.h>
 
 /* Packet size info */
 #define XAE_HDR_SIZE			14 /* Size of Ethernet header */
@@ -170,6 +174,7 @@
 #define XAXIFIFO_TXTS_TAG_MASK		0xFFFF0000
 #define XAXIFIFO_TXTS_TAG_SHIFT		16
 #define XAXIFIFO_TXTS_TAG_MAX		0xFFFE
+#define XAXIFIFO_RXTS_ENTRY_WORDS	3 /* nsec, sec and tag words */
 
 /* Axi Ethernet registers definition */
 #define XAE_RAF_OFFSET		0x00000000 /* Reset and Address filter */
@@ -576,6 +581,7 @@
  *		   Otherwise reserved.
  * @tx_skb:	  Transmit skb address
  * @tx_desc_mapping: Tx Descriptor DMA mapping type.
+ * @tx_xdpf:	  Transmit XDP frame address
  */
 struct axidma_bd {
 	phys_addr_t next;	/* Physical address of next buffer descriptor */
@@ -600,6 +606,7 @@ struct axidma_bd {
 	u32 ptp_tx_ts_tag;
 	phys_addr_t tx_skb;
 	u32 tx_desc_mapping;
+	phys_addr_t tx_xdpf;
 } __aligned(XAXIDMA_BD_MINIMUM_ALIGNMENT);
 /**
  * struct aximcdma_bd - Axi MCDMA buffer descriptor layout
@@ -624,6 +631,7 @@ struct axidma_bd {
  *		   Otherwise reserved.
  * @tx_skb:	  Transmit skb address
  * @tx_desc_mapping: Tx Descriptor DMA mapping type.
+ * @tx_xdpf:	  Transmit XDP frame address
  */
 struct aximcdma_bd {
 	phys_addr_t next;	/* Physical address of next buffer descriptor */
@@ -648,10 +656,13 @@ struct aximcdma_bd {
 	u32 ptp_tx_ts_tag;
 	phys_addr_t tx_skb;
 	u32 tx_desc_mapping;
+	phys_addr_t tx_xdpf;
 } __aligned(XAXIDMA_BD_MINIMUM_ALIGNMENT);
 
 #define DESC_DMA_MAP_SINGLE 0
 #define DESC_DMA_MAP_PAGE 1
+#define DESC_DMA_MAP_NONE 2
+#define DESC_DMA_MAP_XSK 3
 
 #if defined(CONFIG_XILINX_TSN)
 #define XAE_MAX_QUEUES		5
@@ -691,9 +702,12 @@ enum axienet_tsn_ioctl {
  * @regs:	Base address for the axienet_local device address space
  * @mcdma_regs:	Base address for the aximcdma device address space
  * @napi:	Napi Structure array for all dma queues
+ * @napi_tx:	Napi Structure array for Tx completion of all dma queues
  * @num_tx_queues: Total number of Tx DMA queues
  * @num_rx_queues: Total number of Rx DMA queues
+ * @max_queues:	Number of DMA queues provided by the hardware
  * @dq:		DMA queues data
+ * @xdp_prog:	Attached XDP program, NULL when XDP is disabled
  * @phy_mode:	Phy type to identify between MII/GMII/RGMII/SGMII/1000 Base-X
  * @is_tsn:	Denotes a tsn port
  * @temac_no:	Denotes the port number in TSN IP
@@ -708,6 +722,11 @@ enum axienet_tsn_ioctl {
  * @ptp_rx_sw_pointer: ptp rx sw pointer
  * @ptp_txq:	PTP tx queue header
  * @tx_tstamp_work: PTP timestamping work queue
+ * @offload_fwd_mark: Received frames were already forwarded by the TSN
+ *		      switch, set while the port is enslaved to a bridge
+ * @qbv_pending: taprio schedule waiting for the pending Qbv admin list to
+ *		 become operational, NULL when there is none
+ * @qbv_lock:	Protects @qbv_pending against the Qbv interrupt
  * @ptp_tx_lock: PTP tx lock
  * @dma_err_tasklet: Tasklet structure to process Axi DMA errors
  * @eth_irq:	Axi Ethernet IRQ number
@@ -725,6 +744,8 @@ enum axienet_tsn_ioctl {
  * @csum_offload_on_rx_path:	Stores the checksum selection on RX side.
  * @coalesce_count_rx:	Store the irq coalesce on RX side.
  * @coalesce_count_tx:	Store the irq coalesce on TX side.
+ * @rx_dim_enabled:	Adaptive Rx interrupt coalescing is enabled.
+ * @tx_dim_enabled:	Adaptive Tx interrupt coalescing is enabled.
  * @phy_interface: Phy interface type.
  * @phy_flags:	Phy interface flags.
  * @eth_hasnobuf: Ethernet is configured in Non buf mode.
@@ -734,6 +755,8 @@ enum axienet_tsn_ioctl {
  * @rx_ts_regs:	  Base address for the rx axififo device address space.
  * @tstamp_config: Hardware timestamp config structure.
  * @tx_ptpheader: Stores the tx ptp header.
+ * @tx_hwts_skbq: Completed 2-step skbs waiting for their Tx timestamp.
+ * @tx_hwts_work: Drains the Tx timestamp FIFO for @tx_hwts_skbq.
  * @aclk: AXI4-Lite clock for ethernet and dma.
  * @eth_sclk: AXI4-Stream interface clock.
  * @eth_refclk: Stable clock used by signal delay primitives and transceivers.
@@ -752,6 +775,7 @@ enum axienet_tsn_ioctl {
  * @gt_ctrl: GT speed and reset control register space.
  * @phc_index: Index to corresponding PTP clock used.
  * @gt_lane: MRMAC GT lane index used.
+ * @debugfs: debugfs directory of the device.
  */
 struct axienet_local {
 	struct net_device *ndev;
@@ -773,13 +797,16 @@ struct axienet_local {
 
 	struct tasklet_struct dma_err_tasklet[XAE_MAX_QUEUES];
 	struct napi_struct napi[XAE_MAX_QUEUES];	/* NAPI Structure */
+	struct napi_struct napi_tx[XAE_MAX_QUEUES];	/* Tx NAPI Structure */
 
 	#define XAE_TEMAC1 0
 	#define XAE_TEMAC2 1
 	u8     temac_no;
 	u16    num_tx_queues;	/* Number of TX DMA queues */
 	u16    num_rx_queues;	/* Number of RX DMA queues */
+	u16    max_queues;	/* Number of DMA queues in hardware */
 	struct axienet_dma_q *dq[XAE_MAX_QUEUES];	/* DMA queue data*/
+	struct bpf_prog *xdp_prog;
 
 	phy_interface_t phy_mode;
 
@@ -798,6 +825,13 @@ struct axienet_local {
 	struct sk_buff_head ptp_txq;
 	struct work_struct tx_tstamp_work;
 #endif
+#ifdef CONFIG_XILINX_TSN_SWITCH
+	bool offload_fwd_mark;
+#endif
+#ifdef CONFIG_XILINX_TSN_QBV
+	struct qbv_info *qbv_pending;
+	spinlock_t qbv_lock;		/* Qbv pending schedule lock */
+#endif
 #endif
 	spinlock_t ptp_tx_lock;		/* PTP tx lock*/
 	int eth_irq;
@@ -817,6 +851,8 @@ struct axienet_local {
 
 	u32 coalesce_count_rx;
 	u32 coalesce_count_tx;
+	bool rx_dim_enabled;
+	bool tx_dim_enabled;
 	u32 phy_interface;
 	u32 phy_flags;
 	bool eth_hasnobuf;
@@ -828,6 +864,10 @@ struct axienet_local {
 	void __iomem *rx_ts_regs;
 	struct hwtstamp_config tstamp_config;
 	u8 *tx_ptpheader;
+#endif
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+	struct sk_buff_head tx_hwts_skbq;
+	struct work_struct tx_hwts_work;
 #endif
 	struct clk *aclk;
 	struct clk *eth_sclk;
@@ -852,6 +892,43 @@ struct axienet_local {
 	void __iomem *gt_ctrl;	/* GT speed and reset control register space */
 	u32 phc_index;		/* Index to corresponding PTP clock used  */
 	u32 gt_lane;		/* MRMAC GT lane index used */
+	struct dentry *debugfs;
+};
+
+/**
+ * struct axienet_rx_stats - Rx counters of a dma queue
+ * @packets:	Number of receive packets processed by the dma queue.
+ * @bytes:	Number of receive bytes processed by the dma queue.
+ * @budget_exhausted: Number of NAPI polls that used up their budget.
+ * @refill_failures: Number of Rx buffers that could not be replaced.
+ * @syncp:	Synchronizes the counters with their readers.
+ *
+ * The counters are only written from the Rx NAPI context of the queue.
+ */
+struct axienet_rx_stats {
+	u64 packets;
+	u64 bytes;
+	u64 budget_exhausted;
+	u64 refill_failures;
+	struct u64_stats_sync syncp;
+};
+
+/**
+ * struct axienet_tx_stats - Tx counters of a dma queue
+ * @packets:	Number of transmit packets processed by the dma queue.
+ * @bytes:	Number of transmit bytes processed by the dma queue.
+ * @budget_exhausted: Number of NAPI polls that used up their budget.
+ * @ring_full:	Number of frames refused or dropped for lack of free BDs.
+ * @syncp:	Synchronizes the counters written from the Tx NAPI context.
+ * @xmit_syncp:	Synchronizes @ring_full, written under the queue Tx lock.
+ */
+struct axienet_tx_stats {
+	u64 packets;
+	u64 bytes;
+	u64 budget_exhausted;
+	u64 ring_full;
+	struct u64_stats_sync syncp;
+	struct u64_stats_sync xmit_syncp;
 };
 
 /**
@@ -871,6 +948,9 @@ struct axienet_local {
  * @tx_bufs:	Virutal address of the Tx buffer address.
  * @tx_bufs_dma: Physical address of the Tx buffer address used by the driver
  *		 when DMA h/w is configured without DRE.
+ * @tx_db_pending: Tx BDs were queued without moving the tail pointer.
+ * @tso_hdrs:	Virtual address of the per BD TSO segment headers.
+ * @tso_hdrs_dma: Physical address of the per BD TSO segment headers.
  * @eth_hasdre: Tells whether DMA h/w is configured with dre or not.
  * @tx_bd_ci:	Stores the index of the Tx buffer descriptor in the ring being
  *		accessed currently. Used while alloc. BDs before a TX starts
@@ -883,13 +963,24 @@ struct axienet_local {
  * @rx_offset:	MCDMA S2MM channel starting offset.
  * @txq_bd_v:	Virtual address of the MCDMA TX buffer descriptor ring
  * @rxq_bd_v:	Virtual address of the MCDMA RX buffer descriptor ring
- * @tx_packets: Number of transmit packets processed by the dma queue.
- * @tx_bytes:   Number of transmit bytes processed by the dma queue.
- * @rx_packets: Number of receive packets processed by the dma queue.
- * @rx_bytes:	Number of receive bytes processed by the dma queue.
+ * @tx_stats:	Tx counters of the dma queue.
+ * @rx_stats:	Rx counters of the dma queue.
+ * @xdp_rxq:	XDP Rx queue information for the dma queue.
+ * @page_pool:	Page pool backing the Rx buffers of the dma queue.
+ * @xsk_umem:	AF_XDP UMEM bound to the dma queue for zero-copy.
+ * @zca:	Zero-copy allocator returning UMEM Rx buffers to the queue.
+ * @xsk_rx_next: Next Rx BD to be refilled from the UMEM fill queue.
+ * @xsk_rx_count: Number of Rx BDs holding a UMEM buffer.
+ * @rx_dim:	DIM context of the Rx channel.
+ * @tx_dim:	DIM context of the Tx channel.
+ * @rx_dim_events: Number of Rx interrupts, sampled by DIM.
+ * @tx_dim_events: Number of Tx interrupts, sampled by DIM.
+ * @rx_dim_cr:	Rx coalesce and delay fields selected by DIM.
+ * @tx_dim_cr:	Tx coalesce and delay fields selected by DIM.
  */
 struct axienet_dma_q {
 	struct axienet_local	*lp; /* parent */
+	u16 index; /* index in lp->dq and of the netdev Tx queue */
 	void __iomem *dma_regs;
 
 	int tx_irq;
@@ -907,6 +998,9 @@ struct axienet_dma_q {
 	unsigned char *tx_buf[XAE_TX_BUFFERS];
 	unsigned char *tx_bufs;
 	dma_addr_t tx_bufs_dma;
+	bool tx_db_pending;
+	char *tso_hdrs;
+	dma_addr_t tso_hdrs_dma;
 	bool eth_hasdre;
 
 	u32 tx_bd_ci;
@@ -919,14 +1013,31 @@ struct axienet_dma_q {
 	struct aximcdma_bd *txq_bd_v;
 	struct aximcdma_bd *rxq_bd_v;
 
-	unsigned long tx_packets;
-	unsigned long tx_bytes;
-	unsigned long rx_packets;
-	unsigned long rx_bytes;
+	struct axienet_tx_stats tx_stats;
+	struct axienet_rx_stats rx_stats;
+
+	struct xdp_rxq_info xdp_rxq;
+	struct page_pool *page_pool;
+
+	/* AF_XDP zero-copy fields */
+	struct xdp_umem *xsk_umem;
+	struct zero_copy_allocator zca;
+	u32 xsk_rx_next;
+	u32 xsk_rx_count;
+
+	/* Adaptive interrupt coalescing fields */
+	struct dim rx_dim;
+	struct dim tx_dim;
+	u16 rx_dim_events;
+	u16 tx_dim_events;
+	u32 rx_dim_cr;
+	u32 tx_dim_cr;
 };
 
-#define AXIENET_TX_SSTATS_LEN(lp) ((lp)->num_tx_queues * 2)
-#define AXIENET_RX_SSTATS_LEN(lp) ((lp)->num_rx_queues * 2)
+#define AXIENET_TX_QSTATS_LEN	4 /* Counters of struct axienet_tx_stats */
+#define AXIENET_RX_QSTATS_LEN	4 /* Counters of struct axienet_rx_stats */
+#define AXIENET_TX_SSTATS_LEN(lp) ((lp)->num_tx_queues * AXIENET_TX_QSTATS_LEN)
+#define AXIENET_RX_SSTATS_LEN(lp) ((lp)->num_rx_queues * AXIENET_RX_QSTATS_LEN)
 
 /**
  * enum axienet_ip_type - AXIENET IP/MAC type.
@@ -1128,6 +1239,18 @@ int axienet_qbv_init(struct net_device *ndev);
 void axienet_qbv_remove(struct net_device *ndev);
 int axienet_set_schedule(struct net_device *ndev, void __user *useraddr);
 int axienet_get_schedule(struct net_device *ndev, void __user *useraddr);
+int axienet_taprio_setup(struct net_device *ndev,
+			 struct tc_taprio_qopt_offload *qopt);
+#endif
+
+#ifdef CONFIG_XILINX_TSN_SWITCH
+void tsn_switchdev_port_register(struct net_device *ndev);
+void tsn_switchdev_port_unregister(struct net_device *ndev);
+int tsn_switch_get_port_parent_id(struct netdev_phys_item_id *ppid);
+#endif
+
+#ifdef CONFIG_XILINX_TSN_QCI
+int tsn_qci_flower(struct net_device *ndev, struct flow_cls_offload *f);
 #endif
 
 #ifdef CONFIG_XILINX_TSN_QBR
@@ -1135,6 +1258,11 @@ int axienet_preemption(struct net_device *ndev, void __user *useraddr);
 int axienet_preemption_ctrl(struct net_device *ndev, void __user *useraddr);
 int axienet_preemption_sts(struct net_device *ndev, void __user *useraddr);
 int axienet_preemption_cnt(struct net_device *ndev, void __user *useraddr);
+int axienet_preemption_sset_count(struct net_device *ndev, int sset);
+void axienet_preemption_strings(struct net_device *ndev, u32 sset, u8 *data);
+void axienet_preemption_stats(struct net_device *ndev, u64 *data);
+u32 axienet_preemption_get_priv_flags(struct net_device *ndev);
+int axienet_preemption_set_priv_flags(struct net_device *ndev, u32 flags);
 #ifdef CONFIG_XILINX_TSN_QBV
 int axienet_qbu_user_override(struct net_device *ndev, void __user *useraddr);
 int axienet_qbu_sts(struct net_device *ndev, void __user *useraddr);
@@ -1155,6 +1283,54 @@ void __axienet_device_reset(struct axienet_dma_q *q);
 void axienet_set_mac_address(struct net_device *ndev, const void *address);
 void axienet_set_multicast_list(struct net_device *ndev);
 int xaxienet_rx_poll(struct napi_struct *napi, int quota);
+int xaxienet_tx_poll(struct napi_struct *napi, int budget);
+int axienet_rx_buf_alloc(struct axienet_dma_q *q, phys_addr_t *phys,
+			 phys_addr_t *sw_id);
+void axienet_rx_buf_free(struct axienet_dma_q *q, phys_addr_t sw_id);
+int axienet_check_tx_bd_space(struct axienet_dma_q *q, int num_frag);
+void axienet_xdp_ring_tx_db(struct axienet_dma_q *q);
+u32 axienet_run_xdp(struct axienet_dma_q *q, struct bpf_prog *prog,
+		    struct xdp_buff *xdp);
+
+/**
+ * axienet_xdp_txq - Get the DMA queue used to transmit XDP frames
+ * @lp:		Pointer to axienet local structure
+ * @index:	Rx queue or CPU index the frame originates from
+ *
+ * Return: Pointer to the Tx DMA queue
+ */
+static inline struct axienet_dma_q *axienet_xdp_txq(struct axienet_local *lp,
+						    unsigned int index)
+{
+	return lp->dq[index % lp->num_tx_queues];
+}
+
+/**
+ * axienet_dma_q_txq - Get the netdev Tx queue of a DMA queue
+ * @q:		Pointer to DMA queue structure
+ *
+ * Return: Pointer to the netdev Tx queue
+ */
+static inline struct netdev_queue *axienet_dma_q_txq(struct axienet_dma_q *q)
+{
+	return netdev_get_tx_queue(q->lp->ndev, q->index);
+}
+
+/**
+ * axienet_xsk_umem - Get the UMEM used for zero-copy on a DMA queue
+ * @q:		Pointer to DMA queue structure
+ *
+ * Zero-copy is only in effect while an XDP program is attached.
+ *
+ * Return: Pointer to the UMEM, NULL if the queue does not run zero-copy
+ */
+static inline struct xdp_umem *axienet_xsk_umem(struct axienet_dma_q *q)
+{
+	if (!READ_ONCE(q->lp->xdp_prog))
+		return NULL;
+
+	return q->xsk_umem;
+}
 
 #if defined(CONFIG_AXIENET_HAS_MCDMA)
 int __maybe_unused axienet_mcdma_rx_q_init(struct net_device *ndev,
@@ -1181,6 +1357,17 @@ int __maybe_unused axienet_mcdma_tx_probe(struct platform_device *pdev,
 int __maybe_unused axienet_mcdma_rx_probe(struct platform_device *pdev,
 					  struct axienet_local *lp,
 					  struct net_device *ndev);
+int axienet_xsk_umem_dma_map(struct axienet_local *lp, struct xdp_umem *umem);
+void axienet_xsk_umem_dma_unmap(struct axienet_local *lp,
+				struct xdp_umem *umem);
+void axienet_xsk_zca_free(struct zero_copy_allocator *zca,
+			  unsigned long handle);
+void axienet_xsk_rx_refill(struct axienet_dma_q *q);
+void axienet_xsk_rx_ring_free(struct axienet_dma_q *q);
+int axienet_xsk_recv(struct net_device *ndev, int budget,
+		     struct axienet_dma_q *q);
+bool axienet_xsk_xmit(struct axienet_dma_q *q, unsigned int budget);
+int axienet_xsk_wakeup(struct net_device *ndev, u32 qid, u32 flags);
 #endif
 
 #ifdef CONFIG_AXIENET_HAS_MCDMA
@@ -29,30 +29,29 @@ void __maybe_unused axienet_bd_free(struct net_device *ndev,
 	int i;
 	struct axienet_local *lp = netdev_priv(ndev);
 
-	for (i = 0; i < lp->rx_bd_num; i++) {
-		dma_unmap_single(ndev->dev.parent, q->rx_bd_v[i].phys,
-				 lp->max_frm_size, DMA_FROM_DEVICE);
-		dev_kfree_skb((struct sk_buff *)
-			      (q->rx_bd_v[i].sw_id_offset));
-	}
-
 	if (q->rx_bd_v) {
+		for (i = 0; i < lp->rx_bd_num; i++)
+			axienet_rx_buf_free(q, q->rx_bd_v[i].sw_id_offset);
+
 		dma_free_coherent(ndev->dev.parent,
 				  sizeof(*q->rx_bd_v) * lp->rx_bd_num,
 				  q->rx_bd_v,
 				  q->rx_bd_p);
+		q->rx_bd_v = NULL;
 	}
 	if (q->tx_bd_v) {
 		dma_free_coherent(ndev->dev.parent,
 				  sizeof(*q->tx_bd_v) * lp->tx_bd_num,
 				  q->tx_bd_v,
 				  q->tx_bd_p);
+		q->tx_bd_v = NULL;
 	}
 	if (q->tx_bufs) {
 		dma_free_coherent(ndev->dev.parent,
 				  XAE_MAX_PKT_LEN * lp->tx_bd_num,
 				  q->tx_bufs,
 				  q->tx_bufs_dma);
+		q->tx_bufs = NULL;
 	}
 }
 
@@ -73,6 +72,8 @@ static int __dma_txq_init(struct net_device *ndev, struct axienet_dma_q *q)
 
 	q->tx_bd_ci = 0;
 	q->tx_bd_tail = 0;
+	q->tx_db_pending = false;
+	netdev_tx_reset_queue(axienet_dma_q_txq(q));
 
 	q->tx_bd_v = dma_alloc_coherent(ndev->dev.parent,
 					sizeof(*q->tx_bd_v) * lp->tx_bd_num,
@@ -138,7 +139,6 @@ static int __dma_rxq_init(struct net_device *ndev,
 {
 	int i;
 	u32 cr;
-	struct sk_buff *skb;
 	struct axienet_local *lp = netdev_priv(ndev);
 	/* Reset the indexes which are used for accessing the BDs */
 	q->rx_bd_ci = 0;
@@ -155,20 +155,10 @@ static int __dma_rxq_init(struct net_device *ndev,
 				     sizeof(*q->rx_bd_v) *
 				     ((i + 1) % lp->rx_bd_num);
 
-		skb = netdev_alloc_skb(ndev, lp->max_frm_size);
-		if (!skb)
+		if (axienet_rx_buf_alloc(q, &q->rx_bd_v[i].phys,
+					 &q->rx_bd_v[i].sw_id_offset))
 			goto out;
 
-		/* Ensure that the skb is completely updated
-		 * prio to mapping the DMA
-		 */
-		wmb();
-
-		q->rx_bd_v[i].sw_id_offset = (phys_addr_t)skb;
-		q->rx_bd_v[i].phys = dma_map_single(ndev->dev.parent,
-						    skb->data,
-						    lp->max_frm_size,
-						    DMA_FROM_DEVICE);
 		q->rx_bd_v[i].cntrl = lp->max_frm_size;
 	}
 
@@ -252,8 +242,9 @@ static int map_dma_q_irq(int irq, struct axienet_local *lp)
  *
  * Return: IRQ_HANDLED if device generated a TX interrupt, IRQ_NONE otherwise.
  *
- * This is the Axi DMA Tx done Isr. It invokes "axienet_start_xmit_done"
- * to complete the BD processing.
+ * This is the Axi DMA Tx done Isr. It masks the completion interrupts and
+ * schedules the Tx NAPI, which invokes "axienet_start_xmit_done" to complete
+ * the BD processing.
  */
 irqreturn_t __maybe_unused axienet_tx_irq(int irq, void *_ndev)
 {
@@ -272,7 +263,10 @@ irqreturn_t __maybe_unused axienet_tx_irq(int irq, void *_ndev)
 	status = axienet_dma_in32(q, XAXIDMA_TX_SR_OFFSET);
 	if (status & (XAXIDMA_IRQ_IOC_MASK | XAXIDMA_IRQ_DELAY_MASK)) {
 		axienet_dma_out32(q, XAXIDMA_TX_SR_OFFSET, status);
-		axienet_start_xmit_done(lp->ndev, q);
+		cr = axienet_dma_in32(q, XAXIDMA_TX_CR_OFFSET);
+		cr &= ~(XAXIDMA_IRQ_IOC_MASK | XAXIDMA_IRQ_DELAY_MASK);
+		axienet_dma_out32(q, XAXIDMA_TX_CR_OFFSET, cr);
+		napi_schedule(&lp->napi_tx[i]);
 		goto out;
 	}
 
@@ -403,13 +397,15 @@ void __maybe_unused axienet_dma_err_handler(unsigned long data)
 
 	for (i = 0; i < lp->tx_bd_num; i++) {
 		cur_p = &q->tx_bd_v[i];
-		if (cur_p->phys)
+		if (cur_p->phys && cur_p->tx_desc_mapping != DESC_DMA_MAP_NONE)
 			dma_unmap_single(ndev->dev.parent, cur_p->phys,
 					 (cur_p->cntrl &
 					  XAXIDMA_BD_CTRL_LENGTH_MASK),
 					 DMA_TO_DEVICE);
 		if (cur_p->tx_skb)
 			dev_kfree_skb_irq((struct sk_buff *)cur_p->tx_skb);
+		if (cur_p->tx_xdpf)
+			xdp_return_frame((struct xdp_frame *)cur_p->tx_xdpf);
 		cur_p->phys = 0;
 		cur_p->cntrl = 0;
 		cur_p->status = 0;
@@ -420,6 +416,7 @@ void __maybe_unused axienet_dma_err_handler(unsigned long data)
 		cur_p->app4 = 0;
 		cur_p->sw_id_offset = 0;
 		cur_p->tx_skb = 0;
+		cur_p->tx_xdpf = 0;
 	}
 
 	for (i = 0; i < lp->rx_bd_num; i++) {
@@ -434,6 +431,8 @@ void __maybe_unused axienet_dma_err_handler(unsigned long data)
 
 	q->tx_bd_ci = 0;
 	q->tx_bd_tail = 0;
+	q->tx_db_pending = false;
+	netdev_tx_reset_queue(axienet_dma_q_txq(q));
 	q->rx_bd_ci = 0;
 
 	/* Start updating the Rx channel control register */
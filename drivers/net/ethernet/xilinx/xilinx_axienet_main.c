@@ -24,6 +24,7 @@
 
 #include <linux/clk.h>
 #include <linux/circ_buf.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/etherdevice.h>
 #include <linux/module.h>
@@ -42,12 +43,25 @@
 #include <linux/ptp_classify.h>
 #include <linux/net_tstamp.h>
 #include <linux/random.h>
+#include <linux/sched/isolation.h>
+#include <linux/seq_file.h>
+#include <linux/bpf.h>
+#include <linux/bpf_trace.h>
+#include <linux/filter.h>
+#include <net/page_pool.h>
 #include <net/sock.h>
+#include <net/xdp_sock.h>
+#include <net/tso.h>
+#include <net/flow_offload.h>
 #include <linux/xilinx_phy.h>
+#include <asm/unaligned.h>
 #include <linux/clk.h>
 
 #include "xilinx_axienet.h"
 
+#define CREATE_TRACE_POINTS
+#include "xilinx_axienet_trace.h"
+
 #ifdef CONFIG_XILINX_TSN_PTP
 #include "xilinx_tsn_ptp.h"
 #include "xilinx_tsn_timer.h"
@@ -57,6 +71,8 @@
 #define RX_BD_NUM_DEFAULT		128
 #define TX_BD_NUM_MAX			4096
 #define RX_BD_NUM_MAX			4096
+#define TX_BD_NUM_MIN			(MAX_SKB_FRAGS + 2)
+#define RX_BD_NUM_MIN			2
 
 /* Must be shorter than length of ethtool_drvinfo.driver field to fit */
 #define DRIVER_NAME		"xaxienet"
@@ -68,7 +84,26 @@
 #define XXVENET_TS_HEADER_LEN	4
 #define NS_PER_SEC              1000000000ULL /* Nanoseconds per second */
 
-#define MRMAC_RESET_DELAY	1 /* Delay in msecs*/
+#define MRMAC_RESET_DELAY_US	1000 /* Delay in usecs */
+
+/* Every Rx buffer is a page_pool page holding the XDP headroom, the frame
+ * and room for the skb_shared_info of build_skb()
+ */
+#define XAE_RX_HEADROOM		XDP_PACKET_HEADROOM
+#define XAE_RX_TAILROOM		SKB_DATA_ALIGN(sizeof(struct skb_shared_info))
+/* Frames up to this size are copied so that their page is recycled at once */
+#define XAE_RX_COPYBREAK	256
+
+/* The DMA delay timer counts in units of 125 SG clock cycles */
+#define XAE_DIM_DELAY_CYCLES	125
+/* SG clock rate assumed when the AXI4-Lite clock rate is not known */
+#define XAE_DIM_DFT_CLK_RATE	100000000
+
+/* XDP verdicts as seen by the Rx loop */
+#define XAE_XDP_PASS		0
+#define XAE_XDP_CONSUMED	BIT(0)
+#define XAE_XDP_TX		BIT(1)
+#define XAE_XDP_REDIR		BIT(2)
 
 #ifdef CONFIG_XILINX_TSN_PTP
 int axienet_phc_index = -1;
@@ -186,6 +221,126 @@ static struct xxvenet_option mrmacenet_options[] = {
 	{}
 };
 
+/**
+ * axienet_rx_pool_create - Create the page pool backing a Rx DMA queue
+ * @q:		Pointer to DMA queue structure
+ *
+ * The pool pages are DMA mapped once, when they enter the pool, and are
+ * recycled by the Rx path without being unmapped. The mapping is made
+ * bidirectional while an XDP program is attached so that XDP_TX can send
+ * the Rx page as is. Queues running AF_XDP zero-copy get their buffers
+ * from the UMEM and do not use a pool.
+ *
+ * Return: 0, on success
+ *	    Non-zero error value on failure
+ */
+static int axienet_rx_pool_create(struct axienet_dma_q *q)
+{
+	struct axienet_local *lp = q->lp;
+	struct page_pool_params pp_params = { 0 };
+	struct page_pool *pool;
+
+	if (axienet_xsk_umem(q))
+		return 0;
+
+	pp_params.order = get_order(XAE_RX_HEADROOM + lp->max_frm_size +
+				    XAE_RX_TAILROOM);
+	pp_params.flags = PP_FLAG_DMA_MAP | PP_FLAG_DMA_SYNC_DEV;
+	pp_params.pool_size = lp->rx_bd_num;
+	pp_params.nid = dev_to_node(lp->dev);
+	pp_params.dev = lp->ndev->dev.parent;
+	pp_params.dma_dir = lp->xdp_prog ? DMA_BIDIRECTIONAL : DMA_FROM_DEVICE;
+	pp_params.max_len = lp->max_frm_size;
+	pp_params.offset = XAE_RX_HEADROOM;
+
+	pool = page_pool_create(&pp_params);
+	if (IS_ERR(pool))
+		return PTR_ERR(pool);
+
+	q->page_pool = pool;
+
+	return 0;
+}
+
+/**
+ * axienet_rx_buf_alloc - Get a receive buffer for a Rx BD from the page pool
+ * @q:		Pointer to DMA queue structure
+ * @phys:	Returns the DMA address to be programmed in the BD
+ * @sw_id:	Returns the buffer cookie to be stored in the BD sw_id_offset
+ *
+ * Return: 0, on success -ENOMEM, on failure
+ */
+int axienet_rx_buf_alloc(struct axienet_dma_q *q, phys_addr_t *phys,
+			 phys_addr_t *sw_id)
+{
+	struct page *page;
+
+	/* The pool already synced the frame area for the device */
+	page = page_pool_dev_alloc_pages(q->page_pool);
+	if (!page)
+		return -ENOMEM;
+
+	*sw_id = (phys_addr_t)page;
+	*phys = page_pool_get_dma_addr(page) + XAE_RX_HEADROOM;
+
+	return 0;
+}
+
+/**
+ * axienet_rx_buf_free - Return the receive buffer of a Rx BD to the page pool
+ * @q:		Pointer to DMA queue structure
+ * @sw_id:	Buffer cookie stored in the BD sw_id_offset
+ */
+void axienet_rx_buf_free(struct axienet_dma_q *q, phys_addr_t sw_id)
+{
+	if (!sw_id)
+		return;
+
+	page_pool_put_page(q->page_pool, (struct page *)sw_id, false);
+}
+
+/**
+ * axienet_tso_hdrs_alloc - Allocate the TSO segment headers of a Tx queue
+ * @q:		Pointer to DMA queue structure
+ *
+ * Every Tx BD owns a header slot, which is used when the BD starts a TSO
+ * segment.
+ *
+ * Return: 0, on success -ENOMEM, on failure
+ */
+static int axienet_tso_hdrs_alloc(struct axienet_dma_q *q)
+{
+	struct axienet_local *lp = q->lp;
+
+	if (!(lp->ndev->hw_features & NETIF_F_TSO))
+		return 0;
+
+	q->tso_hdrs = dma_alloc_coherent(lp->ndev->dev.parent,
+					 TSO_HEADER_SIZE * lp->tx_bd_num,
+					 &q->tso_hdrs_dma, GFP_KERNEL);
+	if (!q->tso_hdrs)
+		return -ENOMEM;
+
+	return 0;
+}
+
+/**
+ * axienet_tso_hdrs_free - Release the TSO segment headers of a Tx queue
+ * @q:		Pointer to DMA queue structure
+ */
+static void axienet_tso_hdrs_free(struct axienet_dma_q *q)
+{
+	struct axienet_local *lp = q->lp;
+
+	if (!q->tso_hdrs)
+		return;
+
+	dma_free_coherent(lp->ndev->dev.parent,
+			  TSO_HEADER_SIZE * lp->tx_bd_num,
+			  q->tso_hdrs, q->tso_hdrs_dma);
+	q->tso_hdrs = NULL;
+}
+
 /**
  * axienet_dma_bd_release - Release buffer descriptor rings
  * @ndev:	Pointer to the net_device structure
@@ -210,7 +365,14 @@ void axienet_dma_bd_release(struct net_device *ndev)
 #else
 		axienet_bd_free(ndev, lp->dq[i]);
 #endif
+		if (xdp_rxq_info_is_reg(&lp->dq[i]->xdp_rxq))
+			xdp_rxq_info_unreg(&lp->dq[i]->xdp_rxq);
+		page_pool_destroy(lp->dq[i]->page_pool);
+		lp->dq[i]->page_pool = NULL;
 	}
+
+	for_each_tx_dma_queue(lp, i)
+		axienet_tso_hdrs_free(lp->dq[i]);
 }
 
 /**
@@ -236,6 +398,13 @@ static int axienet_dma_bd_init(struct net_device *ndev)
 	}
 #endif
 	for_each_rx_dma_queue(lp, i) {
+		ret = axienet_rx_pool_create(lp->dq[i]);
+		if (ret != 0) {
+			netdev_err(ndev, "%s: Failed to create Rx page pool\n",
+				   __func__);
+			break;
+		}
+
 #ifdef CONFIG_AXIENET_HAS_MCDMA
 		ret = axienet_mcdma_rx_q_init(ndev, lp->dq[i]);
 #else
@@ -245,6 +414,33 @@ static int axienet_dma_bd_init(struct net_device *ndev)
 			netdev_err(ndev, "%s: Failed to init DMA buf\n", __func__);
 			break;
 		}
+
+		ret = xdp_rxq_info_reg(&lp->dq[i]->xdp_rxq, ndev, i);
+		if (!ret && axienet_xsk_umem(lp->dq[i]))
+			ret = xdp_rxq_info_reg_mem_model(&lp->dq[i]->xdp_rxq,
+							 MEM_TYPE_ZERO_COPY,
+							 &lp->dq[i]->zca);
+		else if (!ret)
+			ret = xdp_rxq_info_reg_mem_model(&lp->dq[i]->xdp_rxq,
+							 MEM_TYPE_PAGE_POOL,
+							 lp->dq[i]->page_pool);
+		if (ret != 0) {
+			netdev_err(ndev, "%s: Failed to register XDP Rx queue\n",
+				   __func__);
+			break;
+		}
+	}
+
+	if (ret)
+		return ret;
+
+	for_each_tx_dma_queue(lp, i) {
+		ret = axienet_tso_hdrs_alloc(lp->dq[i]);
+		if (ret != 0) {
+			netdev_err(ndev, "%s: Failed to allocate TSO headers\n",
+				   __func__);
+			break;
+		}
 	}
 
 	return ret;
@@ -436,7 +632,7 @@ static inline void axienet_mrmac_reset(struct axienet_local *lp)
 	val |= (MRMAC_RX_SERDES_RST_MASK | MRMAC_TX_SERDES_RST_MASK |
 		MRMAC_RX_RST_MASK | MRMAC_TX_RST_MASK);
 	axienet_iow(lp, MRMAC_RESET_OFFSET, val);
-	mdelay(MRMAC_RESET_DELAY);
+	usleep_range(MRMAC_RESET_DELAY_US, 2 * MRMAC_RESET_DELAY_US);
 
 	reg = axienet_ior(lp, MRMAC_MODE_OFFSET);
 	if (lp->mrmac_rate == SPEED_25000) {
@@ -477,7 +673,8 @@ static inline int axienet_mrmac_gt_reset(struct net_device *ndev)
 			iowrite32(MRMAC_GT_RST_ALL_MASK, (lp->gt_ctrl +
 				  (MRMAC_GT_LANE_OFFSET * i) +
 				  MRMAC_GT_CTRL_OFFSET));
-			mdelay(MRMAC_RESET_DELAY);
+			usleep_range(MRMAC_RESET_DELAY_US,
+				     2 * MRMAC_RESET_DELAY_US);
 			iowrite32(0, (lp->gt_ctrl + (MRMAC_GT_LANE_OFFSET * i) +
 				      MRMAC_GT_CTRL_OFFSET));
 		}
@@ -506,10 +703,10 @@ static inline int axienet_mrmac_gt_reset(struct net_device *ndev)
 	iowrite32(MRMAC_GT_RST_RX_MASK | MRMAC_GT_RST_TX_MASK,
 		  (lp->gt_ctrl + MRMAC_GT_LANE_OFFSET * lp->gt_lane +
 		  MRMAC_GT_CTRL_OFFSET));
-	mdelay(MRMAC_RESET_DELAY);
+	usleep_range(MRMAC_RESET_DELAY_US, 2 * MRMAC_RESET_DELAY_US);
 	iowrite32(0, (lp->gt_ctrl + MRMAC_GT_LANE_OFFSET * lp->gt_lane +
 		  MRMAC_GT_CTRL_OFFSET));
-	mdelay(MRMAC_RESET_DELAY);
+	usleep_range(MRMAC_RESET_DELAY_US, 2 * MRMAC_RESET_DELAY_US);
 
 	return 0;
 }
@@ -562,7 +759,7 @@ static void axienet_device_reset(struct net_device *ndev)
 		val |= XXV_GT_RESET_MASK;
 		axienet_iow(lp, XXV_GT_RESET_OFFSET, val);
 		/* Wait for 1ms for GT reset to complete as per spec */
-		mdelay(1);
+		usleep_range(1000, 2000);
 		val = axienet_ior(lp, XXV_GT_RESET_OFFSET);
 		val &= ~XXV_GT_RESET_MASK;
 		axienet_iow(lp, XXV_GT_RESET_OFFSET, val);
@@ -743,11 +940,21 @@ static void axienet_adjust_link(struct net_device *ndev)
 }
 
 #ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+/* Tag of a 2-step skb queued on lp->tx_hwts_skbq */
+struct axienet_tx_hwts_cb {
+	u32 tag;
+};
+
+#define AXIENET_TX_HWTS_CB(skb)	((struct axienet_tx_hwts_cb *)(skb)->cb)
+
 /**
- * axienet_tx_hwtstamp - Read tx timestamp from hw and update it to the skbuff
+ * axienet_tx_hwtstamp - Queue a completed skb for its tx timestamp
  * @lp:		Pointer to axienet local structure
  * @cur_p:	Pointer to the axi_dma/axi_mcdma current bd
  *
+ * The timestamp FIFO is read from axienet_tx_hwtstamp_work(), so the Tx
+ * completion path does not wait for the FIFO to fill.
+ *
  * Return:	None.
  */
 #ifdef CONFIG_AXIENET_HAS_MCDMA
@@ -758,35 +965,54 @@ void axienet_tx_hwtstamp(struct axienet_local *lp,
 			 struct axidma_bd *cur_p)
 #endif
 {
+	struct sk_buff *skb = (struct sk_buff *)cur_p->ptp_tx_skb;
+
+	AXIENET_TX_HWTS_CB(skb)->tag = cur_p->ptp_tx_ts_tag;
+	skb_queue_tail(&lp->tx_hwts_skbq, skb);
+	/* Unbound, so that it stays off the isolated CPUs */
+	queue_work(system_unbound_wq, &lp->tx_hwts_work);
+	cur_p->ptp_tx_skb = 0;
+}
+
+/**
+ * axienet_tx_hwtstamp_fifo - Read tx timestamp from hw and update it to the
+ *			      skbuff
+ * @lp:		Pointer to axienet local structure
+ * @skb:	Pointer to the sk_buff structure, consumed in all cases
+ *
+ * Return:	0 on success, -ETIMEDOUT if the FIFO has no timestamp entry.
+ */
+static int axienet_tx_hwtstamp_fifo(struct axienet_local *lp,
+				    struct sk_buff *skb)
+{
+	u32 tag = AXIENET_TX_HWTS_CB(skb)->tag;
 	u32 sec = 0, nsec = 0, val;
 	u64 time64;
 	int err = 0;
 	u32 count, len = lp->axienet_config->tx_ptplen;
-	struct skb_shared_hwtstamps *shhwtstamps =
-		skb_hwtstamps((struct sk_buff *)cur_p->ptp_tx_skb);
-
-	val = axienet_txts_ior(lp, XAXIFIFO_TXTS_ISR);
-	if (unlikely(!(val & XAXIFIFO_TXTS_INT_RC_MASK)))
-		dev_info(lp->dev, "Did't get FIFO tx interrupt %d\n", val);
+	struct skb_shared_hwtstamps shhwtstamps;
 
 	/* If FIFO is configured in cut through Mode we will get Rx complete
 	 * interrupt even one byte is there in the fifo wait for the full packet
 	 */
-	err = readl_poll_timeout_atomic(lp->tx_ts_regs + XAXIFIFO_TXTS_RLR, val,
-					((val & XAXIFIFO_TXTS_RXFD_MASK) >=
-					len), 0, 1000000);
-	if (err)
+	err = readl_poll_timeout(lp->tx_ts_regs + XAXIFIFO_TXTS_RLR, val,
+				 ((val & XAXIFIFO_TXTS_RXFD_MASK) >= len),
+				 10, 1000000);
+	if (err) {
 		netdev_err(lp->ndev, "%s: Didn't get the full timestamp packet",
 			   __func__);
+		dev_kfree_skb_any(skb);
+		return err;
+	}
 
 	nsec = axienet_txts_ior(lp, XAXIFIFO_TXTS_RXFD);
 	sec  = axienet_txts_ior(lp, XAXIFIFO_TXTS_RXFD);
 	val = axienet_txts_ior(lp, XAXIFIFO_TXTS_RXFD);
 	val = ((val & XAXIFIFO_TXTS_TAG_MASK) >> XAXIFIFO_TXTS_TAG_SHIFT);
 	dev_dbg(lp->dev, "tx_stamp:[%04x] %04x %u %9u\n",
-		cur_p->ptp_tx_ts_tag, val, sec, nsec);
+		tag, val, sec, nsec);
 
-	if (val != cur_p->ptp_tx_ts_tag) {
+	if (val != tag) {
 		count = axienet_txts_ior(lp, XAXIFIFO_TXTS_RFO);
 		while (count) {
 			nsec = axienet_txts_ior(lp, XAXIFIFO_TXTS_RXFD);
@@ -796,16 +1022,15 @@ void axienet_tx_hwtstamp(struct axienet_local *lp,
 				XAXIFIFO_TXTS_TAG_SHIFT);
 
 			dev_dbg(lp->dev, "tx_stamp:[%04x] %04x %u %9u\n",
-				cur_p->ptp_tx_ts_tag, val, sec, nsec);
-			if (val == cur_p->ptp_tx_ts_tag)
+				tag, val, sec, nsec);
+			if (val == tag)
 				break;
 			count = axienet_txts_ior(lp, XAXIFIFO_TXTS_RFO);
 		}
-		if (val != cur_p->ptp_tx_ts_tag) {
+		if (val != tag) {
 			dev_info(lp->dev, "Mismatching 2-step tag. Got %x",
 				 val);
-			dev_info(lp->dev, "Expected %x\n",
-				 cur_p->ptp_tx_ts_tag);
+			dev_info(lp->dev, "Expected %x\n", tag);
 		}
 	}
 
@@ -814,64 +1039,131 @@ void axienet_tx_hwtstamp(struct axienet_local *lp,
 		val = axienet_txts_ior(lp, XAXIFIFO_TXTS_RXFD);
 
 	time64 = sec * NS_PER_SEC + nsec;
-	memset(shhwtstamps, 0, sizeof(struct skb_shared_hwtstamps));
-	shhwtstamps->hwtstamp = ns_to_ktime(time64);
+	memset(&shhwtstamps, 0, sizeof(struct skb_shared_hwtstamps));
+	shhwtstamps.hwtstamp = ns_to_ktime(time64);
 	if (lp->axienet_config->mactype != XAXIENET_10G_25G &&
 	    lp->axienet_config->mactype != XAXIENET_MRMAC)
-		skb_pull((struct sk_buff *)cur_p->ptp_tx_skb,
-			 AXIENET_TS_HEADER_LEN);
+		skb_pull(skb, AXIENET_TS_HEADER_LEN);
 
-	skb_tstamp_tx((struct sk_buff *)cur_p->ptp_tx_skb, shhwtstamps);
-	dev_kfree_skb_any((struct sk_buff *)cur_p->ptp_tx_skb);
-	cur_p->ptp_tx_skb = 0;
+	skb_tstamp_tx(skb, &shhwtstamps);
+	dev_kfree_skb_any(skb);
+
+	return 0;
+}
+
+/**
+ * axienet_tx_hwtstamp_work - Deliver the tx timestamps of queued skbs
+ * @work:	Pointer to the tx_hwts_work of axienet local structure
+ *
+ * The FIFO returns the timestamps in transmit order, so all skbs queued
+ * since the last run are served in one pass. If the FIFO stops delivering
+ * entries the remaining skbs are released without a timestamp.
+ */
+static void axienet_tx_hwtstamp_work(struct work_struct *work)
+{
+	struct axienet_local *lp = container_of(work, struct axienet_local,
+						tx_hwts_work);
+	struct sk_buff *skb;
+
+	while ((skb = skb_dequeue(&lp->tx_hwts_skbq))) {
+		if (axienet_tx_hwtstamp_fifo(lp, skb)) {
+			skb_queue_purge(&lp->tx_hwts_skbq);
+			break;
+		}
+	}
 }
 
 /**
  * axienet_rx_hwtstamp - Read rx timestamp from hw and update it to the skbuff
  * @lp:		Pointer to axienet local structure
- * @skb:	Pointer to the sk_buff structure
+ * @skb:	Pointer to the sk_buff structure, NULL to only drain the FIFO
+ *		entry of a frame consumed by XDP
+ * @ts_words:	FIFO words known to be available, kept by the caller across
+ *		a NAPI poll
+ *
+ * The FIFO occupancy is only read when the entries seen by the previous
+ * read are used up, so a burst of frames costs one register read for the
+ * occupancy plus the reads of the entries themselves.
  *
  * Return:	None.
  */
 static void axienet_rx_hwtstamp(struct axienet_local *lp,
-				struct sk_buff *skb)
+				struct sk_buff *skb, u32 *ts_words)
 {
 	u32 sec = 0, nsec = 0, val;
 	u64 time64;
 	int err = 0;
-	struct skb_shared_hwtstamps *shhwtstamps = skb_hwtstamps(skb);
+	struct skb_shared_hwtstamps *shhwtstamps;
 
-	val = axienet_rxts_ior(lp, XAXIFIFO_TXTS_ISR);
-	if (unlikely(!(val & XAXIFIFO_TXTS_INT_RC_MASK))) {
-		dev_info(lp->dev, "Did't get FIFO rx interrupt %d\n", val);
-		return;
+	if (*ts_words < XAXIFIFO_RXTS_ENTRY_WORDS) {
+		*ts_words = axienet_rxts_ior(lp, XAXIFIFO_TXTS_RFO);
+		if (!*ts_words)
+			return;
 	}
 
-	val = axienet_rxts_ior(lp, XAXIFIFO_TXTS_RFO);
-	if (!val)
-		return;
-
-	/* If FIFO is configured in cut through Mode we will get Rx complete
-	 * interrupt even one byte is there in the fifo wait for the full packet
-	 */
-	err = readl_poll_timeout_atomic(lp->rx_ts_regs + XAXIFIFO_TXTS_RLR, val,
-					((val & XAXIFIFO_TXTS_RXFD_MASK) >= 12),
-					0, 1000000);
-	if (err) {
-		netdev_err(lp->ndev, "%s: Didn't get the full timestamp packet",
-			   __func__);
-		return;
+	if (*ts_words >= XAXIFIFO_RXTS_ENTRY_WORDS) {
+		/* A full entry is queued, start reading it */
+		axienet_rxts_ior(lp, XAXIFIFO_TXTS_RLR);
+	} else {
+		/* If FIFO is configured in cut through Mode the occupancy
+		 * counts a partial entry, wait for the full packet
+		 */
+		err = readl_poll_timeout_atomic(lp->rx_ts_regs +
+						XAXIFIFO_TXTS_RLR, val,
+						((val & XAXIFIFO_TXTS_RXFD_MASK)
+						 >= 12), 0, 1000000);
+		if (err) {
+			netdev_err(lp->ndev, "%s: Didn't get the full timestamp packet",
+				   __func__);
+			*ts_words = 0;
+			return;
+		}
+		*ts_words = XAXIFIFO_RXTS_ENTRY_WORDS;
 	}
 
 	nsec = axienet_rxts_ior(lp, XAXIFIFO_TXTS_RXFD);
 	sec  = axienet_rxts_ior(lp, XAXIFIFO_TXTS_RXFD);
 	val = axienet_rxts_ior(lp, XAXIFIFO_TXTS_RXFD);
+	*ts_words -= XAXIFIFO_RXTS_ENTRY_WORDS;
 
-	if (lp->tstamp_config.rx_filter == HWTSTAMP_FILTER_ALL) {
+	if (skb && lp->tstamp_config.rx_filter == HWTSTAMP_FILTER_ALL) {
 		time64 = sec * NS_PER_SEC + nsec;
+		shhwtstamps = skb_hwtstamps(skb);
 		shhwtstamps->hwtstamp = ns_to_ktime(time64);
 	}
 }
+
+/**
+ * axienet_rx_inline_hwtstamp - Strip the in-band rx timestamp of a frame
+ * @lp:		Pointer to axienet local structure
+ * @skb:	Pointer to the sk_buff structure
+ *
+ * The 1G and 2.5G MACs prepend the timestamp to the frame. It is read in
+ * place and pulled off, without copying it out of the buffer first.
+ *
+ * Return:	None.
+ */
+static void axienet_rx_inline_hwtstamp(struct axienet_local *lp,
+				       struct sk_buff *skb)
+{
+	u32 sec, nsec;
+	u64 time64;
+
+	/* The first 8 bytes will be the timestamp */
+	if (lp->axienet_config->mactype == XAXIENET_1G ||
+	    lp->axienet_config->mactype == XAXIENET_2_5G) {
+		sec = get_unaligned_be32(&skb->data[0]);
+		nsec = get_unaligned_be32(&skb->data[4]);
+	} else {
+		nsec = get_unaligned((u32 *)&skb->data[0]);
+		sec = get_unaligned((u32 *)&skb->data[4]);
+	}
+
+	/* Remove these 8 bytes from the buffer */
+	skb_pull(skb, 8);
+	time64 = sec * NS_PER_SEC + nsec;
+	skb_hwtstamps(skb)->hwtstamp = ns_to_ktime(time64);
+}
 #endif
 
 /**
@@ -880,7 +1172,7 @@ static void axienet_rx_hwtstamp(struct axienet_local *lp,
  * @ndev:	Pointer to the net_device structure
  * @q:		Pointer to DMA queue structure
  *
- * This function is invoked from the Axi DMA Tx isr to notify the completion
+ * This function is invoked from the Tx NAPI poll to notify the completion
  * of transmit operation. It clears fields in the corresponding Tx BDs and
  * unmaps the corresponding buffer so that CPU can regain ownership of the
  * buffer. It finally invokes "netif_wake_queue" to restart transmission if
@@ -891,10 +1183,13 @@ void axienet_start_xmit_done(struct net_device *ndev,
 {
 	u32 size = 0;
 	u32 packets = 0;
+	u32 bql_bytes = 0;
+	u32 bql_pkts = 0;
 	struct axienet_local *lp = netdev_priv(ndev);
 
 #ifdef CONFIG_AXIENET_HAS_MCDMA
 	struct aximcdma_bd *cur_p;
+	u32 xsk_frames = 0;
 #else
 	struct axidma_bd *cur_p;
 #endif
@@ -908,22 +1203,39 @@ void axienet_start_xmit_done(struct net_device *ndev,
 	status = cur_p->status;
 #endif
 	while (status & XAXIDMA_BD_STS_COMPLETE_MASK) {
-#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
-		if (cur_p->ptp_tx_skb)
-			axienet_tx_hwtstamp(lp, cur_p);
-#endif
+		trace_axienet_tx_done(q, q->tx_bd_ci,
+				      status & XAXIDMA_BD_STS_ACTUAL_LEN_MASK);
+
 		if (cur_p->tx_desc_mapping == DESC_DMA_MAP_PAGE)
 			dma_unmap_page(ndev->dev.parent, cur_p->phys,
 				       cur_p->cntrl &
 				       XAXIDMA_BD_CTRL_LENGTH_MASK,
 				       DMA_TO_DEVICE);
-		else
+		else if (cur_p->tx_desc_mapping == DESC_DMA_MAP_SINGLE)
 			dma_unmap_single(ndev->dev.parent, cur_p->phys,
 					 cur_p->cntrl &
 					 XAXIDMA_BD_CTRL_LENGTH_MASK,
 					 DMA_TO_DEVICE);
-		if (cur_p->tx_skb)
-			dev_kfree_skb_irq((struct sk_buff *)cur_p->tx_skb);
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+		else if (cur_p->tx_desc_mapping == DESC_DMA_MAP_XSK)
+			xsk_frames++;
+#endif
+		if (cur_p->tx_skb) {
+			struct sk_buff *skb = (struct sk_buff *)cur_p->tx_skb;
+
+			bql_bytes += skb->len;
+			bql_pkts++;
+			dev_kfree_skb_irq(skb);
+		}
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+		/* Queued after the BQL accounting, the timestamp work pulls the
+		 * timestamp header off the skb.
+		 */
+		if (cur_p->ptp_tx_skb)
+			axienet_tx_hwtstamp(lp, cur_p);
+#endif
+		if (cur_p->tx_xdpf)
+			xdp_return_frame((struct xdp_frame *)cur_p->tx_xdpf);
 		/*cur_p->phys = 0;*/
 		cur_p->app0 = 0;
 		cur_p->app1 = 0;
@@ -931,6 +1243,7 @@ void axienet_start_xmit_done(struct net_device *ndev,
 		cur_p->app4 = 0;
 		cur_p->status = 0;
 		cur_p->tx_skb = 0;
+		cur_p->tx_xdpf = 0;
 #ifdef CONFIG_AXIENET_HAS_MCDMA
 		cur_p->sband_stats = 0;
 #endif
@@ -949,10 +1262,17 @@ void axienet_start_xmit_done(struct net_device *ndev,
 #endif
 	}
 
-	ndev->stats.tx_packets += packets;
-	ndev->stats.tx_bytes += size;
-	q->tx_packets += packets;
-	q->tx_bytes += size;
+	u64_stats_update_begin(&q->tx_stats.syncp);
+	q->tx_stats.packets += packets;
+	q->tx_stats.bytes += size;
+	u64_stats_update_end(&q->tx_stats.syncp);
+	/* XDP and XSK frames bypass the qdisc and are not BQL accounted */
+	netdev_tx_completed_queue(axienet_dma_q_txq(q), bql_pkts, bql_bytes);
+
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	if (xsk_frames)
+		xsk_umem_complete_tx(q->xsk_umem, xsk_frames);
+#endif
 
 	/* Matches barrier in axienet_start_xmit */
 	smp_mb();
@@ -978,8 +1298,7 @@ void axienet_start_xmit_done(struct net_device *ndev,
  * transmission. If the BD or any of the BDs are not free the function
  * returns a busy status. This is invoked from axienet_start_xmit.
  */
-static inline int axienet_check_tx_bd_space(struct axienet_dma_q *q,
-					    int num_frag)
+int axienet_check_tx_bd_space(struct axienet_dma_q *q, int num_frag)
 {
 	struct axienet_local *lp = q->lp;
 #ifdef CONFIG_AXIENET_HAS_MCDMA
@@ -1215,67 +1534,350 @@ static int axienet_skb_tstsmp(struct sk_buff **__skb, struct axienet_dma_q *q,
 }
 #endif
 
-static int axienet_queue_xmit(struct sk_buff *skb,
-			      struct net_device *ndev, u16 map)
+/**
+ * axienet_tx_sent - Account a queued skb and ring the Tx doorbell
+ * @q:		Pointer to DMA queue structure
+ * @skb:	skb whose BDs were queued
+ *
+ * The tail pointer write is deferred while the stack has more frames for
+ * the queue, so that a burst rings the doorbell once. BQL may stop the
+ * queue, in which case the doorbell is rung at once. The caller must hold
+ * q->tx_lock.
+ */
+static void axienet_tx_sent(struct axienet_dma_q *q, struct sk_buff *skb)
 {
-	u32 ii;
-	u32 num_frag;
-	u32 csum_start_off;
-	u32 csum_index_off;
-	dma_addr_t tail_p;
-	struct axienet_local *lp = netdev_priv(ndev);
-#ifdef CONFIG_AXIENET_HAS_MCDMA
-	struct aximcdma_bd *cur_p;
-#else
-	struct axidma_bd *cur_p;
-#endif
-	unsigned long flags;
-	struct axienet_dma_q *q;
+	if (__netdev_tx_sent_queue(axienet_dma_q_txq(q), skb->len,
+				   netdev_xmit_more()))
+		axienet_xdp_ring_tx_db(q);
+	else
+		q->tx_db_pending = true;
+}
 
-	if (lp->axienet_config->mactype == XAXIENET_10G_25G ||
-	    lp->axienet_config->mactype == XAXIENET_MRMAC) {
-		/* Need to manually pad the small frames in case of XXV MAC
-		 * because the pad field is not added by the IP. We must present
-		 * a packet that meets the minimum length to the IP core.
-		 * When the IP core is configured to calculate and add the FCS
-		 * to the packet the minimum packet length is 60 bytes.
-		 */
-		if (eth_skb_pad(skb)) {
-			ndev->stats.tx_dropped++;
-			return NETDEV_TX_OK;
-		}
-	}
+/**
+ * axienet_tx_flush - Ring the Tx doorbell for deferred BDs
+ * @q:		Pointer to DMA queue structure
+ *
+ * Called before a frame is refused, as the stack then does not send the
+ * frame that would have rung the doorbell. The caller must hold
+ * q->tx_lock.
+ */
+static void axienet_tx_flush(struct axienet_dma_q *q)
+{
+	if (q->tx_db_pending)
+		axienet_xdp_ring_tx_db(q);
+}
 
-#ifdef CONFIG_XILINX_TSN
-	if (unlikely(lp->is_tsn)) {
-		map = tsn_queue_mapping(skb, lp->num_tc);
-#ifdef CONFIG_XILINX_TSN_PTP
-		const struct ethhdr *eth;
+/**
+ * axienet_tso_count_descs - Get the number of Tx BDs a TSO skb needs
+ * @skb:	GSO skb to be transmitted
+ *
+ * Every segment takes one header BD and at least one payload BD, and a
+ * payload BD never crosses a fragment boundary.
+ *
+ * Return: Number of Tx BDs
+ */
+static inline int axienet_tso_count_descs(struct sk_buff *skb)
+{
+	return tso_count_descs(skb);
+}
 
-		eth = (struct ethhdr *)skb->data;
-		/* check if skb is a PTP frame ? */
-		if (eth->h_proto == htons(ETH_P_1588))
-			return axienet_ptp_xmit(skb, ndev);
-#endif
-		if (lp->temac_no == XAE_TEMAC2) {
-			dev_kfree_skb_any(skb);
-			return NETDEV_TX_OK;
-		}
-	}
-#endif
-	num_frag = skb_shinfo(skb)->nr_frags;
+/**
+ * axienet_set_gso_max_segs - Bound the TSO segments to the Tx ring size
+ * @lp:		Pointer to axienet local structure
+ *
+ * A TSO skb has to fit the Tx ring in one go, larger ones are segmented by
+ * the stack.
+ */
+static void axienet_set_gso_max_segs(struct axienet_local *lp)
+{
+	int segs = ((int)lp->tx_bd_num - 1 - MAX_SKB_FRAGS) / 2;
 
-	q = lp->dq[map];
+	lp->ndev->gso_max_segs = clamp_t(int, segs, 0, GSO_MAX_SEGS);
+}
 
-#ifdef CONFIG_AXIENET_HAS_MCDMA
-	cur_p = &q->txq_bd_v[q->tx_bd_tail];
-#else
-	cur_p = &q->tx_bd_v[q->tx_bd_tail];
-#endif
+/**
+ * axienet_tso_init - Advertise TSO when the hardware can support it
+ * @lp:		Pointer to axienet local structure
+ *
+ * TSO is done by the driver and relies on the Tx checksum offload of the
+ * 1G/2.5G MAC for every segment. The payload BDs point at arbitrary skb
+ * offsets, so every Tx DMA channel needs the data realignment engine.
+ */
+static void axienet_tso_init(struct axienet_local *lp)
+{
+	int i;
 
+	if (lp->axienet_config->mactype != XAXIENET_1G || lp->eth_hasnobuf ||
+	    lp->is_tsn ||
+	    !(lp->features & (XAE_FEATURE_PARTIAL_TX_CSUM |
+			      XAE_FEATURE_FULL_TX_CSUM)))
+		return;
+
+	for (i = 0; i < lp->max_queues; i++)
+		if (!lp->dq[i]->eth_hasdre)
+			return;
+
+	lp->ndev->hw_features |= NETIF_F_SG | NETIF_F_IP_CSUM | NETIF_F_TSO;
+	lp->ndev->features |= NETIF_F_TSO;
+	axienet_set_gso_max_segs(lp);
+}
+
+/**
+ * axienet_features_check - Drop the offloads a skb cannot use
+ * @skb:	skb to be transmitted
+ * @ndev:	Pointer to net_device structure
+ * @features:	Offloads enabled for the skb
+ *
+ * Return: Offloads the skb can use
+ */
+static netdev_features_t axienet_features_check(struct sk_buff *skb,
+						struct net_device *ndev,
+						netdev_features_t features)
+{
+	/* The segment headers have to fit a TSO header slot */
+	if (skb_is_gso(skb) &&
+	    skb_transport_offset(skb) + tcp_hdrlen(skb) > TSO_HEADER_SIZE)
+		features &= ~NETIF_F_GSO_MASK;
+
+	return vlan_features_check(skb, features);
+}
+
+/**
+ * axienet_tso_csum - Set up the checksum offload of a TSO segment
+ * @lp:		Pointer to axienet local structure
+ * @skb:	GSO skb being transmitted
+ * @hdr:	Segment header built by tso_build_hdr()
+ * @data_len:	Payload length of the segment
+ * @app0:	Returns the app0 field of the segment SOF BD
+ * @app1:	Returns the app1 field of the segment SOF BD
+ *
+ * The IPv4 header checksum of every segment is computed here. With partial
+ * offload the TCP checksum field is seeded with the pseudo header sum of
+ * the segment, the core adds the TCP header and payload.
+ */
+static void axienet_tso_csum(struct axienet_local *lp, struct sk_buff *skb,
+			     char *hdr, int data_len, u32 *app0, u32 *app1)
+{
+	struct iphdr *iph = (struct iphdr *)(hdr + skb_network_offset(skb));
+	struct tcphdr *tcph = (struct tcphdr *)(hdr +
+						skb_transport_offset(skb));
+	u32 csum_start_off = skb_transport_offset(skb);
+
+	ip_send_check(iph);
+
+	if (lp->features & XAE_FEATURE_FULL_TX_CSUM) {
+		/* Tx Full Checksum Offload Enabled */
+		*app0 = 2;
+		*app1 = 0;
+		return;
+	}
+
+	tcph->check = ~csum_tcpudp_magic(iph->saddr, iph->daddr,
+					 tcp_hdrlen(skb) + data_len,
+					 IPPROTO_TCP, 0);
+	/* Tx Partial Checksum Offload Enabled */
+	*app0 = 1;
+	*app1 = (csum_start_off << 16) |
+		(csum_start_off + offsetof(struct tcphdr, check));
+}
+
+/**
+ * axienet_tso_xmit - Transmit a GSO skb as a chain of TCP segments
+ * @skb:	GSO skb to be transmitted
+ * @q:		Pointer to DMA queue structure
+ *
+ * The headers of every segment are built in the header slot of its SOF
+ * BD, the payload BDs point straight into the skb. The caller holds the
+ * queue Tx lock and has checked that axienet_tso_count_descs() BDs are
+ * free. Like for other skbs, the doorbell may be deferred by xmit_more.
+ *
+ * Return: NETDEV_TX_OK, the skb is consumed even if it could not be mapped
+ */
+static int axienet_tso_xmit(struct sk_buff *skb, struct axienet_dma_q *q)
+{
+	struct axienet_local *lp = q->lp;
+	struct net_device *ndev = lp->ndev;
+	int hdr_len = skb_transport_offset(skb) + tcp_hdrlen(skb);
+	int total_len = skb->len - hdr_len;
+	u32 first = q->tx_bd_tail;
+	u32 sof, eof, app0, app1;
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	struct aximcdma_bd *cur_p;
+#else
+	struct axidma_bd *cur_p;
+#endif
+	struct tso_t tso;
+	char *hdr;
+
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	sof = XMCDMA_BD_CTRL_TXSOF_MASK;
+	eof = XMCDMA_BD_CTRL_TXEOF_MASK;
+#else
+	sof = XAXIDMA_BD_CTRL_TXSOF_MASK;
+	eof = XAXIDMA_BD_CTRL_TXEOF_MASK;
+#endif
+
+	tso_start(skb, &tso);
+	while (total_len > 0) {
+		int data_left = min_t(int, skb_shinfo(skb)->gso_size,
+				      total_len);
+
+		total_len -= data_left;
+
+		/* Segment header */
+		hdr = q->tso_hdrs + q->tx_bd_tail * TSO_HEADER_SIZE;
+		tso_build_hdr(skb, hdr, &tso, data_left, total_len == 0);
+		axienet_tso_csum(lp, skb, hdr, data_left, &app0, &app1);
+
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+		cur_p = &q->txq_bd_v[q->tx_bd_tail];
+#else
+		cur_p = &q->tx_bd_v[q->tx_bd_tail];
+#endif
+		cur_p->phys = q->tso_hdrs_dma +
+			      q->tx_bd_tail * TSO_HEADER_SIZE;
+		cur_p->cntrl = hdr_len | sof;
+		cur_p->app0 = app0;
+		cur_p->app1 = app1;
+		cur_p->tx_desc_mapping = DESC_DMA_MAP_NONE;
+		if (++q->tx_bd_tail >= lp->tx_bd_num)
+			q->tx_bd_tail = 0;
+
+		/* Segment payload */
+		while (data_left > 0) {
+			int size = min_t(int, tso.size, data_left);
+
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+			cur_p = &q->txq_bd_v[q->tx_bd_tail];
+#else
+			cur_p = &q->tx_bd_v[q->tx_bd_tail];
+#endif
+			cur_p->phys = dma_map_single(ndev->dev.parent,
+						     tso.data, size,
+						     DMA_TO_DEVICE);
+			if (dma_mapping_error(ndev->dev.parent, cur_p->phys))
+				goto err_unmap;
+
+			cur_p->cntrl = size;
+			cur_p->app0 = 0;
+			cur_p->app1 = 0;
+			cur_p->tx_desc_mapping = DESC_DMA_MAP_SINGLE;
+			if (++q->tx_bd_tail >= lp->tx_bd_num)
+				q->tx_bd_tail = 0;
+
+			data_left -= size;
+			tso_build_data(skb, &tso, size);
+		}
+		cur_p->cntrl |= eof;
+	}
+
+	cur_p->tx_skb = (phys_addr_t)skb;
+	trace_axienet_xmit(q, first, skb->len);
+	axienet_tx_sent(q, skb);
+
+	return NETDEV_TX_OK;
+
+err_unmap:
+	/* Give back the BDs of the segments built so far */
+	while (q->tx_bd_tail != first) {
+		q->tx_bd_tail = q->tx_bd_tail ? q->tx_bd_tail - 1 :
+				lp->tx_bd_num - 1;
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+		cur_p = &q->txq_bd_v[q->tx_bd_tail];
+#else
+		cur_p = &q->tx_bd_v[q->tx_bd_tail];
+#endif
+		if (cur_p->tx_desc_mapping == DESC_DMA_MAP_SINGLE)
+			dma_unmap_single(ndev->dev.parent, cur_p->phys,
+					 cur_p->cntrl &
+					 XAXIDMA_BD_CTRL_LENGTH_MASK,
+					 DMA_TO_DEVICE);
+		cur_p->cntrl = 0;
+		cur_p->app0 = 0;
+		cur_p->app1 = 0;
+	}
+	axienet_tx_flush(q);
+	dev_kfree_skb_any(skb);
+	ndev->stats.tx_dropped++;
+
+	return NETDEV_TX_OK;
+}
+
+static int axienet_queue_xmit(struct sk_buff *skb,
+			      struct net_device *ndev, u16 map)
+{
+	u32 ii;
+	u32 num_frag;
+	u32 first;
+	int ret;
+	u32 csum_start_off;
+	u32 csum_index_off;
+	struct axienet_local *lp = netdev_priv(ndev);
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	struct aximcdma_bd *cur_p;
+#else
+	struct axidma_bd *cur_p;
+#endif
+	unsigned long flags;
+	struct axienet_dma_q *q;
+
+	if (lp->axienet_config->mactype == XAXIENET_10G_25G ||
+	    lp->axienet_config->mactype == XAXIENET_MRMAC) {
+		/* Need to manually pad the small frames in case of XXV MAC
+		 * because the pad field is not added by the IP. We must present
+		 * a packet that meets the minimum length to the IP core.
+		 * When the IP core is configured to calculate and add the FCS
+		 * to the packet the minimum packet length is 60 bytes.
+		 */
+		if (eth_skb_pad(skb)) {
+			ndev->stats.tx_dropped++;
+			return NETDEV_TX_OK;
+		}
+	}
+
+#ifdef CONFIG_XILINX_TSN
+	if (unlikely(lp->is_tsn)) {
+		map = tsn_queue_mapping(skb, lp->num_tc);
+#ifdef CONFIG_XILINX_TSN_PTP
+		const struct ethhdr *eth;
+
+		eth = (struct ethhdr *)skb->data;
+		/* check if skb is a PTP frame ? */
+		if (eth->h_proto == htons(ETH_P_1588))
+			return axienet_ptp_xmit(skb, ndev);
+#endif
+		if (lp->temac_no == XAE_TEMAC2) {
+			dev_kfree_skb_any(skb);
+			return NETDEV_TX_OK;
+		}
+	}
+#endif
+	num_frag = skb_shinfo(skb)->nr_frags;
+	/* A TSO skb needs a header BD per segment on top of the payload */
+	if (skb_is_gso(skb))
+		num_frag = axienet_tso_count_descs(skb) - 1;
+
+	q = lp->dq[map];
+
+	/* The tail index is shared with the XDP transmit paths, so it is only
+	 * sampled under the queue lock.
+	 */
 	spin_lock_irqsave(&q->tx_lock, flags);
+	first = q->tx_bd_tail;
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	cur_p = &q->txq_bd_v[q->tx_bd_tail];
+#else
+	cur_p = &q->tx_bd_v[q->tx_bd_tail];
+#endif
 	if (axienet_check_tx_bd_space(q, num_frag)) {
+		trace_axienet_tx_ring_full(q, num_frag + 1);
+
+		u64_stats_update_begin(&q->tx_stats.xmit_syncp);
+		q->tx_stats.ring_full++;
+		u64_stats_update_end(&q->tx_stats.xmit_syncp);
+
 		if (netif_queue_stopped(ndev)) {
+			axienet_tx_flush(q);
 			spin_unlock_irqrestore(&q->tx_lock, flags);
 			return NETDEV_TX_BUSY;
 		}
@@ -1287,6 +1889,7 @@ static int axienet_queue_xmit(struct sk_buff *skb,
 
 		/* Space might have just been freed - check again */
 		if (axienet_check_tx_bd_space(q, num_frag)) {
+			axienet_tx_flush(q);
 			spin_unlock_irqrestore(&q->tx_lock, flags);
 			return NETDEV_TX_BUSY;
 		}
@@ -1294,8 +1897,16 @@ static int axienet_queue_xmit(struct sk_buff *skb,
 		netif_wake_queue(ndev);
 	}
 
+	/* TSO segments are sent without hardware timestamps */
+	if (skb_is_gso(skb)) {
+		ret = axienet_tso_xmit(skb, q);
+		spin_unlock_irqrestore(&q->tx_lock, flags);
+		return ret;
+	}
+
 #ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
 	if (axienet_skb_tstsmp(&skb, q, ndev)) {
+		axienet_tx_flush(q);
 		spin_unlock_irqrestore(&q->tx_lock, flags);
 		return NETDEV_TX_BUSY;
 	}
@@ -1337,6 +1948,7 @@ static int axienet_queue_xmit(struct sk_buff *skb,
 #else
 		cur_p->cntrl = skb_pagelen(skb) | XAXIDMA_BD_CTRL_TXSOF_MASK;
 #endif
+		cur_p->tx_desc_mapping = DESC_DMA_MAP_NONE;
 		goto out;
 	} else {
 		cur_p->phys = dma_map_single(ndev->dev.parent, skb->data,
@@ -1367,51 +1979,458 @@ static int axienet_queue_xmit(struct sk_buff *skb,
 out:
 #ifdef CONFIG_AXIENET_HAS_MCDMA
 	cur_p->cntrl |= XMCDMA_BD_CTRL_TXEOF_MASK;
-	tail_p = q->tx_bd_p + sizeof(*q->txq_bd_v) * q->tx_bd_tail;
 #else
 	cur_p->cntrl |= XAXIDMA_BD_CTRL_TXEOF_MASK;
-	tail_p = q->tx_bd_p + sizeof(*q->tx_bd_v) * q->tx_bd_tail;
 #endif
 	cur_p->tx_skb = (phys_addr_t)skb;
-	cur_p->tx_skb = (phys_addr_t)skb;
 
-	tail_p = q->tx_bd_p + sizeof(*q->tx_bd_v) * q->tx_bd_tail;
+	if (++q->tx_bd_tail >= lp->tx_bd_num)
+		q->tx_bd_tail = 0;
+
+	trace_axienet_xmit(q, first, skb->len);
+	axienet_tx_sent(q, skb);
+
+	spin_unlock_irqrestore(&q->tx_lock, flags);
+
+	return NETDEV_TX_OK;
+}
+
+/**
+ * axienet_start_xmit - Starts the transmission.
+ * @skb:	sk_buff pointer that contains data to be Txed.
+ * @ndev:	Pointer to net_device structure.
+ *
+ * Return: NETDEV_TX_OK, on success
+ *	    NETDEV_TX_BUSY, if any of the descriptors are not free
+ *
+ * This function is invoked from upper layers to initiate transmission. The
+ * function uses the next available free BDs and populates their fields to
+ * start the transmission. Additionally if checksum offloading is supported,
+ * it populates AXI Stream Control fields with appropriate values.
+ */
+static int axienet_start_xmit(struct sk_buff *skb, struct net_device *ndev)
+{
+	u16 map = skb_get_queue_mapping(skb); /* Single dma queue default*/
+
+	return axienet_queue_xmit(skb, ndev, map);
+}
+
+/**
+ * axienet_select_queue - Select the Tx DMA queue of a frame
+ * @ndev:	Pointer to net_device structure
+ * @skb:	Frame to be transmitted
+ * @sb_dev:	Subordinate device, unused
+ *
+ * TSN ports map the VLAN PCP to the traffic class queues. Other frames are
+ * spread over the DMA queues on their flow hash, so that a flow always
+ * uses the same queue and stays in order.
+ *
+ * Return: Tx queue index
+ */
+static u16 axienet_select_queue(struct net_device *ndev, struct sk_buff *skb,
+				struct net_device *sb_dev)
+{
+#ifdef CONFIG_XILINX_TSN
+	struct axienet_local *lp = netdev_priv(ndev);
+
+	if (lp->is_tsn)
+		return tsn_queue_mapping(skb, lp->num_tc);
+#endif
+	if (ndev->real_num_tx_queues == 1)
+		return 0;
+
+	return netdev_pick_tx(ndev, skb, sb_dev);
+}
+
+/**
+ * axienet_dma_q_affinity - Get the CPU the interrupts of a DMA queue go to
+ * @lp:		Pointer to axienet local structure
+ * @i:		DMA queue index
+ *
+ * The Rx and Tx interrupts of a queue, and so its NAPI contexts and error
+ * tasklet, are kept on the same CPU and the queues are spread over the CPUs
+ * of the node. When CPUs are isolated with isolcpus=, the queues are spread
+ * over the housekeeping CPUs instead.
+ *
+ * Return: Affinity mask for the interrupts of the queue
+ */
+static const struct cpumask *axienet_dma_q_affinity(struct axienet_local *lp,
+						    int i)
+{
+	const struct cpumask *hk = housekeeping_cpumask(HK_FLAG_DOMAIN);
+	unsigned int cpu, n = 0;
+
+	if (!housekeeping_enabled(HK_FLAG_DOMAIN))
+		return cpumask_of(cpumask_local_spread(i,
+						       dev_to_node(lp->dev)));
+
+	for_each_cpu_and(cpu, hk, cpu_online_mask)
+		n++;
+	if (!n)
+		return hk;
+
+	n = i % n;
+	for_each_cpu_and(cpu, hk, cpu_online_mask)
+		if (!n--)
+			break;
+
+	return cpumask_of(cpu);
+}
+
+/**
+ * axienet_irq_affinity - Keep a MAC interrupt off the isolated CPUs
+ * @irq:	Interrupt number
+ *
+ * The interrupts which are not bound to a DMA queue go to the housekeeping
+ * CPUs when CPUs are isolated with isolcpus=, and keep the default affinity
+ * otherwise. The hint must be cleared before the interrupt is freed.
+ */
+static void axienet_irq_affinity(int irq)
+{
+	if (housekeeping_enabled(HK_FLAG_DOMAIN))
+		irq_set_affinity_hint(irq,
+				      housekeeping_cpumask(HK_FLAG_DOMAIN));
+}
+
+/**
+ * axienet_xdp_ts_inband - Check whether 1588 timestamps are carried in-band
+ * @lp:		Pointer to axienet local structure
+ *
+ * On the 1G/2.5G MACs the hardware timestamps are prepended to the frame
+ * data, which the XDP paths can neither strip on Rx nor provide on Tx.
+ *
+ * Return: true if frames carry an in-band timestamp header
+ */
+static bool axienet_xdp_ts_inband(struct axienet_local *lp)
+{
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+	if (lp->axienet_config->mactype == XAXIENET_10G_25G ||
+	    lp->axienet_config->mactype == XAXIENET_MRMAC)
+		return false;
+
+	return lp->eth_hasptp ||
+	       lp->tstamp_config.rx_filter == HWTSTAMP_FILTER_ALL ||
+	       lp->tstamp_config.tx_type != HWTSTAMP_TX_OFF;
+#else
+	return false;
+#endif
+}
+
+/**
+ * axienet_xdp_frame_fits - Check whether a frame fits an XDP Rx page
+ * @mtu:	MTU to check
+ *
+ * Return: true if a frame of the given MTU, with the XDP headroom and the
+ *	   build_skb() tailroom, fits in a single page
+ */
+static bool axienet_xdp_frame_fits(int mtu)
+{
+	u32 frm_size = max_t(u32, XAE_MAX_VLAN_FRAME_SIZE,
+			     mtu + VLAN_ETH_HLEN + XAE_TRL_SIZE);
+
+	return XAE_RX_HEADROOM + frm_size + XAE_RX_TAILROOM <=
+	       PAGE_SIZE;
+}
+
+/**
+ * axienet_xdp_queue_one - Queue an XDP frame on the Tx ring
+ * @q:		Pointer to DMA queue structure
+ * @xdpf:	XDP frame to be transmitted
+ * @dma_map:	true if the frame must be DMA mapped, false if it sits in a
+ *		page of the Rx page pool which is already mapped
+ *
+ * The caller must hold q->tx_lock. The tail descriptor is not written, this
+ * is left to axienet_xdp_ring_tx_db() so that a batch of frames is kicked
+ * with a single register write.
+ *
+ * Return: 0, on success
+ *	    Non-zero error value on failure
+ */
+static int axienet_xdp_queue_one(struct axienet_dma_q *q,
+				 struct xdp_frame *xdpf, bool dma_map)
+{
+	struct axienet_local *lp = q->lp;
+	struct net_device *ndev = lp->ndev;
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	struct aximcdma_bd *cur_p;
+#else
+	struct axidma_bd *cur_p;
+#endif
+	struct page *page;
+	dma_addr_t addr;
+
+	if (axienet_check_tx_bd_space(q, 0)) {
+		u64_stats_update_begin(&q->tx_stats.xmit_syncp);
+		q->tx_stats.ring_full++;
+		u64_stats_update_end(&q->tx_stats.xmit_syncp);
+		return -ENOSPC;
+	}
+
+	if (axienet_xdp_ts_inband(lp))
+		return -EOPNOTSUPP;
+
+	/* The XXV MAC neither pads short frames nor takes them */
+	if ((lp->axienet_config->mactype == XAXIENET_10G_25G ||
+	     lp->axienet_config->mactype == XAXIENET_MRMAC) &&
+	    xdpf->len < ETH_ZLEN)
+		return -EINVAL;
+
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	cur_p = &q->txq_bd_v[q->tx_bd_tail];
+#else
+	cur_p = &q->tx_bd_v[q->tx_bd_tail];
+#endif
+
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+	if ((lp->axienet_config->mactype == XAXIENET_10G_25G ||
+	     lp->axienet_config->mactype == XAXIENET_MRMAC) &&
+	    axienet_create_tsheader(lp->tx_ptpheader, TX_TS_OP_NOOP, q))
+		return -EBUSY;
+#endif
+
+	if (!q->eth_hasdre && ((phys_addr_t)xdpf->data & 0x3)) {
+		if (xdpf->len > XAE_MAX_PKT_LEN)
+			return -EINVAL;
+
+		memcpy(q->tx_buf[q->tx_bd_tail], xdpf->data, xdpf->len);
+		cur_p->phys = q->tx_bufs_dma +
+			      (q->tx_buf[q->tx_bd_tail] - q->tx_bufs);
+		cur_p->tx_desc_mapping = DESC_DMA_MAP_NONE;
+	} else if (!dma_map) {
+		page = virt_to_page(xdpf->data);
+		addr = page_pool_get_dma_addr(page) +
+		       (xdpf->data - page_address(page));
+		dma_sync_single_for_device(ndev->dev.parent, addr, xdpf->len,
+					   DMA_BIDIRECTIONAL);
+		cur_p->phys = addr;
+		cur_p->tx_desc_mapping = DESC_DMA_MAP_NONE;
+	} else {
+		addr = dma_map_single(ndev->dev.parent, xdpf->data, xdpf->len,
+				      DMA_TO_DEVICE);
+		if (dma_mapping_error(ndev->dev.parent, addr))
+			return -ENOMEM;
+
+		cur_p->phys = addr;
+		cur_p->tx_desc_mapping = DESC_DMA_MAP_SINGLE;
+	}
+
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	cur_p->cntrl = xdpf->len | XMCDMA_BD_CTRL_TXSOF_MASK |
+		       XMCDMA_BD_CTRL_TXEOF_MASK;
+#else
+	cur_p->cntrl = xdpf->len | XAXIDMA_BD_CTRL_TXSOF_MASK |
+		       XAXIDMA_BD_CTRL_TXEOF_MASK;
+#endif
+	cur_p->app0 = 0;
+	cur_p->app1 = 0;
+	cur_p->tx_skb = 0;
+	cur_p->tx_xdpf = (phys_addr_t)xdpf;
+
+	if (++q->tx_bd_tail >= lp->tx_bd_num)
+		q->tx_bd_tail = 0;
+
+	return 0;
+}
+
+/**
+ * axienet_xdp_ring_tx_db - Start the transfer of the queued Tx BDs
+ * @q:		Pointer to DMA queue structure
+ *
+ * Moves the tail pointer to the last queued BD, which also covers skbs
+ * whose doorbell was deferred. The caller must hold q->tx_lock.
+ */
+void axienet_xdp_ring_tx_db(struct axienet_dma_q *q)
+{
+	struct axienet_local *lp = q->lp;
+	dma_addr_t tail_p;
+	u32 tail;
+
+	tail = q->tx_bd_tail ? q->tx_bd_tail - 1 : lp->tx_bd_num - 1;
+	q->tx_db_pending = false;
+
 	/* Ensure BD write before starting transfer */
 	wmb();
 
-	/* Start the transfer */
-#ifdef CONFIG_AXIENET_HAS_MCDMA
-	axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id),
-			  tail_p);
-#else
-	axienet_dma_bdout(q, XAXIDMA_TX_TDESC_OFFSET, tail_p);
-#endif
-	if (++q->tx_bd_tail >= lp->tx_bd_num)
-		q->tx_bd_tail = 0;
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	tail_p = q->tx_bd_p + sizeof(*q->txq_bd_v) * tail;
+	axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id),
+			  tail_p);
+#else
+	tail_p = q->tx_bd_p + sizeof(*q->tx_bd_v) * tail;
+	axienet_dma_bdout(q, XAXIDMA_TX_TDESC_OFFSET, tail_p);
+#endif
+}
+
+/**
+ * axienet_xdp_xmit - Transmit a batch of redirected XDP frames
+ * @ndev:	Pointer to net_device structure
+ * @n:		Number of frames
+ * @frames:	Array of XDP frames
+ * @flags:	XDP_XMIT_* flags
+ *
+ * Return: Number of frames queued for transmission, or negative error
+ */
+static int axienet_xdp_xmit(struct net_device *ndev, int n,
+			    struct xdp_frame **frames, u32 flags)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	struct axienet_dma_q *q;
+	unsigned long irq_flags;
+	int i, drops = 0;
+
+	if (unlikely(flags & ~XDP_XMIT_FLAGS_MASK))
+		return -EINVAL;
+
+	if (unlikely(!netif_running(ndev) || !netif_device_present(ndev)))
+		return -ENETDOWN;
+
+	if (unlikely(lp->is_tsn))
+		return -EOPNOTSUPP;
+
+	q = axienet_xdp_txq(lp, smp_processor_id());
+
+	spin_lock_irqsave(&q->tx_lock, irq_flags);
+	for (i = 0; i < n; i++) {
+		if (axienet_xdp_queue_one(q, frames[i], true)) {
+			xdp_return_frame_rx_napi(frames[i]);
+			drops++;
+		}
+	}
+
+	if (flags & XDP_XMIT_FLUSH)
+		axienet_xdp_ring_tx_db(q);
+	spin_unlock_irqrestore(&q->tx_lock, irq_flags);
+
+	ndev->stats.tx_dropped += drops;
 
-	spin_unlock_irqrestore(&q->tx_lock, flags);
+	return n - drops;
+}
 
-	return NETDEV_TX_OK;
+/**
+ * axienet_run_xdp - Run the attached XDP program on a received frame
+ * @q:		Pointer to the Rx DMA queue structure
+ * @prog:	XDP program
+ * @xdp:	XDP buffer describing the frame
+ *
+ * Return: XAE_XDP_PASS if the frame must go up the stack, otherwise the
+ *	   XAE_XDP_* action that consumed it
+ */
+u32 axienet_run_xdp(struct axienet_dma_q *q, struct bpf_prog *prog,
+		    struct xdp_buff *xdp)
+{
+	struct axienet_local *lp = q->lp;
+	struct net_device *ndev = lp->ndev;
+	struct axienet_dma_q *txq;
+	struct xdp_frame *xdpf;
+	unsigned long flags;
+	u32 act;
+	int err;
+
+	act = bpf_prog_run_xdp(prog, xdp);
+	switch (act) {
+	case XDP_PASS:
+		return XAE_XDP_PASS;
+	case XDP_TX:
+		xdpf = convert_to_xdp_frame(xdp);
+		if (unlikely(!xdpf))
+			goto out_failure;
+
+		txq = axienet_xdp_txq(lp, xdp->rxq->queue_index);
+		spin_lock_irqsave(&txq->tx_lock, flags);
+		err = axienet_xdp_queue_one(txq, xdpf,
+					    xdpf->mem.type != MEM_TYPE_PAGE_POOL);
+		spin_unlock_irqrestore(&txq->tx_lock, flags);
+		if (err) {
+			xdp_return_frame_rx_napi(xdpf);
+			ndev->stats.tx_dropped++;
+			return XAE_XDP_CONSUMED;
+		}
+		return XAE_XDP_TX;
+	case XDP_REDIRECT:
+		err = xdp_do_redirect(ndev, xdp, prog);
+		if (unlikely(err))
+			goto out_failure;
+		return XAE_XDP_REDIR;
+	default:
+		bpf_warn_invalid_xdp_action(act);
+		/* fall through */
+	case XDP_ABORTED:
+out_failure:
+		trace_xdp_exception(ndev, prog, act);
+		/* fall through */
+	case XDP_DROP:
+		xdp_return_buff(xdp);
+		return XAE_XDP_CONSUMED;
+	}
 }
 
 /**
- * axienet_start_xmit - Starts the transmission.
- * @skb:	sk_buff pointer that contains data to be Txed.
- * @ndev:	Pointer to net_device structure.
+ * axienet_rx_skb - Build the skb of a received frame
+ * @q:		Pointer to the Rx DMA queue structure
+ * @prog:	XDP program, NULL if none is attached
+ * @page:	Page pool page holding the frame
+ * @length:	Length of the received frame
+ * @xdp_act:	Accumulates the XAE_XDP_* actions taken in this poll
  *
- * Return: NETDEV_TX_OK, on success
- *	    NETDEV_TX_BUSY, if any of the descriptors are not free
+ * The XDP program, if any, is run first. Short frames are copied to a new
+ * skb and their page is recycled straight into the pool, larger frames are
+ * wrapped with build_skb() and their page is released from the pool.
  *
- * This function is invoked from upper layers to initiate transmission. The
- * function uses the next available free BDs and populates their fields to
- * start the transmission. Additionally if checksum offloading is supported,
- * it populates AXI Stream Control fields with appropriate values.
+ * Return: skb to hand to the stack, or NULL if the frame was consumed
  */
-static int axienet_start_xmit(struct sk_buff *skb, struct net_device *ndev)
+static struct sk_buff *axienet_rx_skb(struct axienet_dma_q *q,
+				      struct bpf_prog *prog, struct page *page,
+				      u32 length, u32 *xdp_act)
 {
-	u16 map = skb_get_queue_mapping(skb); /* Single dma queue default*/
+	struct axienet_local *lp = q->lp;
+	struct net_device *ndev = lp->ndev;
+	void *hard_start = page_address(page);
+	void *data = hard_start + XAE_RX_HEADROOM;
+	unsigned int sync_len = length;
+	struct xdp_buff xdp;
+	struct sk_buff *skb;
+	u32 act;
+
+	if (prog) {
+		xdp.data_hard_start = hard_start;
+		xdp.data = data;
+		xdp_set_data_meta_invalid(&xdp);
+		xdp.data_end = xdp.data + length;
+		xdp.rxq = &q->xdp_rxq;
+
+		act = axienet_run_xdp(q, prog, &xdp);
+		*xdp_act |= act;
+		if (act != XAE_XDP_PASS)
+			return NULL;
+
+		/* The program may have moved the frame boundaries */
+		data = xdp.data;
+		length = xdp.data_end - xdp.data;
+		sync_len = max_t(unsigned int, sync_len,
+				 xdp.data_end - hard_start - XAE_RX_HEADROOM);
+	}
 
-	return axienet_queue_xmit(skb, ndev, map);
+	if (length <= XAE_RX_COPYBREAK) {
+		skb = netdev_alloc_skb(ndev, length);
+		if (likely(skb))
+			skb_put_data(skb, data, length);
+		page_pool_recycle_direct_len(q->page_pool, page, sync_len);
+	} else {
+		skb = build_skb(hard_start, PAGE_SIZE << q->page_pool->p.order);
+		if (likely(skb)) {
+			page_pool_release_page(q->page_pool, page);
+			skb_reserve(skb, data - hard_start);
+			skb_put(skb, length);
+		} else {
+			page_pool_recycle_direct_len(q->page_pool, page,
+						     sync_len);
+		}
+	}
+
+	if (unlikely(!skb))
+		ndev->stats.rx_dropped++;
+
+	return skb;
 }
 
 /**
@@ -1435,7 +2454,15 @@ static int axienet_recv(struct net_device *ndev, int budget,
 	u32 packets = 0;
 	dma_addr_t tail_p = 0;
 	struct axienet_local *lp = netdev_priv(ndev);
-	struct sk_buff *skb, *new_skb;
+	struct sk_buff *skb;
+	phys_addr_t new_phys, new_sw_id;
+	struct bpf_prog *xdp_prog;
+	struct axienet_dma_q *txq;
+	unsigned long flags;
+	u32 xdp_act = 0;
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+	u32 rx_ts_words = 0;
+#endif
 #ifdef CONFIG_AXIENET_HAS_MCDMA
 	struct aximcdma_bd *cur_p;
 #else
@@ -1443,6 +2470,8 @@ static int axienet_recv(struct net_device *ndev, int budget,
 #endif
 	unsigned int numbdfree = 0;
 
+	xdp_prog = READ_ONCE(lp->xdp_prog);
+
 	/* Get relevat BD status value */
 	rmb();
 #ifdef CONFIG_AXIENET_HAS_MCDMA
@@ -1453,9 +2482,13 @@ static int axienet_recv(struct net_device *ndev, int budget,
 
 	while ((numbdfree < budget) &&
 	       (cur_p->status & XAXIDMA_BD_STS_COMPLETE_MASK)) {
-		new_skb = netdev_alloc_skb(ndev, lp->max_frm_size);
-		if (!new_skb) {
-			dev_err(lp->dev, "No memory for new_skb\n");
+		if (axienet_rx_buf_alloc(q, &new_phys, &new_sw_id)) {
+			trace_axienet_rx_refill_fail(q, q->rx_bd_ci,
+				cur_p->status & XAXIDMA_BD_STS_ACTUAL_LEN_MASK);
+			u64_stats_update_begin(&q->rx_stats.syncp);
+			q->rx_stats.refill_failures++;
+			u64_stats_update_end(&q->rx_stats.syncp);
+			dev_err(lp->dev, "No memory for new Rx buffer\n");
 			break;
 		}
 #ifdef CONFIG_AXIENET_HAS_MCDMA
@@ -1464,55 +2497,48 @@ static int axienet_recv(struct net_device *ndev, int budget,
 		tail_p = q->rx_bd_p + sizeof(*q->rx_bd_v) * q->rx_bd_ci;
 #endif
 
-		dma_unmap_single(ndev->dev.parent, cur_p->phys,
-				 lp->max_frm_size,
-				 DMA_FROM_DEVICE);
-
-		skb = (struct sk_buff *)(cur_p->sw_id_offset);
-
 		if (lp->eth_hasnobuf ||
 		    (lp->axienet_config->mactype != XAXIENET_1G))
 			length = cur_p->status & XAXIDMA_BD_STS_ACTUAL_LEN_MASK;
 		else
 			length = cur_p->app4 & 0x0000FFFF;
 
-		skb_put(skb, length);
+		trace_axienet_rx(q, q->rx_bd_ci, length);
+
+		dma_sync_single_for_cpu(ndev->dev.parent, cur_p->phys, length,
+					page_pool_get_dma_dir(q->page_pool));
+
+		skb = axienet_rx_skb(q, xdp_prog,
+				     (struct page *)cur_p->sw_id_offset,
+				     length, &xdp_act);
+		if (!skb) {
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+			/* Keep the Rx timestamp FIFO in step */
+			if (!lp->is_tsn &&
+			    (lp->axienet_config->mactype == XAXIENET_10G_25G ||
+			     lp->axienet_config->mactype == XAXIENET_MRMAC))
+				axienet_rx_hwtstamp(lp, NULL, &rx_ts_words);
+#endif
+			goto refill;
+		}
 #ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
 	if (!lp->is_tsn) {
 		if ((lp->tstamp_config.rx_filter == HWTSTAMP_FILTER_ALL ||
 			lp->eth_hasptp) &&
 			(lp->axienet_config->mactype != XAXIENET_10G_25G) &&
 			(lp->axienet_config->mactype != XAXIENET_MRMAC)) {
-			u32 sec, nsec;
-			u64 time64;
-			struct skb_shared_hwtstamps *shhwtstamps;
-
-			if (lp->axienet_config->mactype == XAXIENET_1G ||
-			    lp->axienet_config->mactype == XAXIENET_2_5G) {
-				/* The first 8 bytes will be the timestamp */
-				memcpy(&sec, &skb->data[0], 4);
-				memcpy(&nsec, &skb->data[4], 4);
-
-				sec = cpu_to_be32(sec);
-				nsec = cpu_to_be32(nsec);
-			} else {
-				/* The first 8 bytes will be the timestamp */
-				memcpy(&nsec, &skb->data[0], 4);
-				memcpy(&sec, &skb->data[4], 4);
-			}
-
-			/* Remove these 8 bytes from the buffer */
-			skb_pull(skb, 8);
-			time64 = sec * NS_PER_SEC + nsec;
-			shhwtstamps = skb_hwtstamps(skb);
-			shhwtstamps->hwtstamp = ns_to_ktime(time64);
+			axienet_rx_inline_hwtstamp(lp, skb);
 		} else if (lp->axienet_config->mactype == XAXIENET_10G_25G ||
 			   lp->axienet_config->mactype == XAXIENET_MRMAC) {
-			axienet_rx_hwtstamp(lp, skb);
+			axienet_rx_hwtstamp(lp, skb, &rx_ts_words);
 		}
 	}
 #endif
 		skb->protocol = eth_type_trans(skb, ndev);
+#ifdef CONFIG_XILINX_TSN_SWITCH
+		/* keep the bridge from forwarding it a second time */
+		skb->offload_fwd_mark = lp->offload_fwd_mark;
+#endif
 		/*skb_checksum_none_assert(skb);*/
 		skb->ip_summed = CHECKSUM_NONE;
 
@@ -1536,20 +2562,14 @@ static int axienet_recv(struct net_device *ndev, int budget,
 
 		netif_receive_skb(skb);
 
+refill:
 		size += length;
 		packets++;
 
-		/* Ensure that the skb is completely updated
-		 * prio to mapping the DMA
-		 */
-		wmb();
-
-		cur_p->phys = dma_map_single(ndev->dev.parent, new_skb->data,
-					     lp->max_frm_size,
-					     DMA_FROM_DEVICE);
+		cur_p->phys = new_phys;
 		cur_p->cntrl = lp->max_frm_size;
 		cur_p->status = 0;
-		cur_p->sw_id_offset = (phys_addr_t)new_skb;
+		cur_p->sw_id_offset = new_sw_id;
 
 		if (++q->rx_bd_ci >= lp->rx_bd_num)
 			q->rx_bd_ci = 0;
@@ -1564,10 +2584,10 @@ static int axienet_recv(struct net_device *ndev, int budget,
 		numbdfree++;
 	}
 
-	ndev->stats.rx_packets += packets;
-	ndev->stats.rx_bytes += size;
-	q->rx_packets += packets;
-	q->rx_bytes += size;
+	u64_stats_update_begin(&q->rx_stats.syncp);
+	q->rx_stats.packets += packets;
+	q->rx_stats.bytes += size;
+	u64_stats_update_end(&q->rx_stats.syncp);
 
 	if (tail_p) {
 #ifdef CONFIG_AXIENET_HAS_MCDMA
@@ -1578,9 +2598,115 @@ static int axienet_recv(struct net_device *ndev, int budget,
 #endif
 	}
 
+	if (xdp_act & XAE_XDP_REDIR)
+		xdp_do_flush_map();
+
+	if (xdp_act & XAE_XDP_TX) {
+		txq = axienet_xdp_txq(lp, q->xdp_rxq.queue_index);
+		spin_lock_irqsave(&txq->tx_lock, flags);
+		axienet_xdp_ring_tx_db(txq);
+		spin_unlock_irqrestore(&txq->tx_lock, flags);
+	}
+
 	return numbdfree;
 }
 
+/**
+ * axienet_dim_cr - Encode a DIM moderation in the DMA control register fields
+ * @lp:		Pointer to axienet local structure
+ * @moder:	Moderation selected by DIM
+ *
+ * The AXI DMA and MCDMA channel control registers share the layout of the
+ * coalesce and delay fields. The delay timer runs from the SG clock, which
+ * is approximated with the AXI4-Lite clock.
+ *
+ * Return: Coalesce and delay fields of the channel control register
+ */
+static u32 axienet_dim_cr(struct axienet_local *lp, struct dim_cq_moder moder)
+{
+	unsigned long rate = clk_get_rate(lp->aclk);
+	u32 count, delay;
+
+	if (!rate)
+		rate = XAE_DIM_DFT_CLK_RATE;
+
+	count = clamp_t(u32, moder.pkts, 1, 255);
+	delay = DIV_ROUND_UP(moder.usec * (rate / USEC_PER_SEC),
+			     XAE_DIM_DELAY_CYCLES);
+	delay = clamp_t(u32, delay, 1, 255);
+
+	return (count << XAXIDMA_COALESCE_SHIFT) |
+	       (delay << XAXIDMA_DELAY_SHIFT);
+}
+
+/**
+ * axienet_rx_dim_work - Apply a new Rx moderation profile selected by DIM
+ * @work:	Work structure embedded in the Rx DIM context
+ */
+static void axienet_rx_dim_work(struct work_struct *work)
+{
+	struct dim *dim = container_of(work, struct dim, work);
+	struct axienet_dma_q *q = container_of(dim, struct axienet_dma_q,
+					       rx_dim);
+	struct dim_cq_moder moder;
+
+	moder = net_dim_get_rx_moderation(dim->mode, dim->profile_ix);
+	/* Picked up by the Rx NAPI when it enables the interrupts again */
+	WRITE_ONCE(q->rx_dim_cr, axienet_dim_cr(q->lp, moder));
+	dim->state = DIM_START_MEASURE;
+}
+
+/**
+ * axienet_tx_dim_work - Apply a new Tx moderation profile selected by DIM
+ * @work:	Work structure embedded in the Tx DIM context
+ */
+static void axienet_tx_dim_work(struct work_struct *work)
+{
+	struct dim *dim = container_of(work, struct dim, work);
+	struct axienet_dma_q *q = container_of(dim, struct axienet_dma_q,
+					       tx_dim);
+	struct dim_cq_moder moder;
+
+	moder = net_dim_get_tx_moderation(dim->mode, dim->profile_ix);
+	/* Picked up by the Tx NAPI when it enables the interrupts again */
+	WRITE_ONCE(q->tx_dim_cr, axienet_dim_cr(q->lp, moder));
+	dim->state = DIM_START_MEASURE;
+}
+
+/**
+ * axienet_dim_init - Reset the DIM contexts of a DMA queue
+ * @lp:		Pointer to axienet local structure
+ * @q:		Pointer to DMA queue structure
+ *
+ * DIM starts from the static ethtool coalescing setting.
+ */
+static void axienet_dim_init(struct axienet_local *lp, struct axienet_dma_q *q)
+{
+	memset(&q->rx_dim, 0, sizeof(q->rx_dim));
+	INIT_WORK(&q->rx_dim.work, axienet_rx_dim_work);
+	q->rx_dim.mode = DIM_CQ_PERIOD_MODE_START_FROM_EQE;
+	q->rx_dim_cr = (lp->coalesce_count_rx << XAXIDMA_COALESCE_SHIFT) |
+		       (XAXIDMA_DFT_RX_WAITBOUND << XAXIDMA_DELAY_SHIFT);
+
+	memset(&q->tx_dim, 0, sizeof(q->tx_dim));
+	INIT_WORK(&q->tx_dim.work, axienet_tx_dim_work);
+	q->tx_dim.mode = DIM_CQ_PERIOD_MODE_START_FROM_EQE;
+	q->tx_dim_cr = (lp->coalesce_count_tx << XAXIDMA_COALESCE_SHIFT) |
+		       (XAXIDMA_DFT_TX_WAITBOUND << XAXIDMA_DELAY_SHIFT);
+}
+
+/**
+ * axienet_dim_update_cr - Merge the DIM moderation in a control register
+ * @cr:		Channel control register value
+ * @dim_cr:	Coalesce and delay fields selected by DIM
+ *
+ * Return: Control register value to be written
+ */
+static inline u32 axienet_dim_update_cr(u32 cr, u32 dim_cr)
+{
+	return (cr & ~(XAXIDMA_COALESCE_MASK | XAXIDMA_DELAY_MASK)) | dim_cr;
+}
+
 /**
  * xaxienet_rx_poll - Poll routine for rx packets (NAPI)
  * @napi:	napi structure pointer
@@ -1604,6 +2730,9 @@ int xaxienet_rx_poll(struct napi_struct *napi, int quota)
 
 #ifdef CONFIG_AXIENET_HAS_MCDMA
 	spin_lock(&q->rx_lock);
+	/* A wakeup from the AF_XDP socket means new fill queue entries */
+	if (axienet_xsk_umem(q))
+		axienet_xsk_rx_refill(q);
 	status = axienet_dma_in32(q, XMCDMA_CHAN_SR_OFFSET(q->chan_id) +
 				  q->rx_offset);
 	while ((status & (XMCDMA_IRQ_IOC_MASK | XMCDMA_IRQ_DELAY_MASK)) &&
@@ -1614,7 +2743,12 @@ int xaxienet_rx_poll(struct napi_struct *napi, int quota)
 			dev_err(lp->dev, "Rx error 0x%x\n\r", status);
 			break;
 		}
-		work_done += axienet_recv(lp->ndev, quota - work_done, q);
+		if (axienet_xsk_umem(q))
+			work_done += axienet_xsk_recv(lp->ndev,
+						      quota - work_done, q);
+		else
+			work_done += axienet_recv(lp->ndev,
+						  quota - work_done, q);
 		status = axienet_dma_in32(q, XMCDMA_CHAN_SR_OFFSET(q->chan_id) +
 					  q->rx_offset);
 	}
@@ -1636,26 +2770,110 @@ int xaxienet_rx_poll(struct napi_struct *napi, int quota)
 	spin_unlock(&q->rx_lock);
 #endif
 
+	trace_axienet_rx_poll(q, work_done, quota);
+
 	if (work_done < quota) {
 		napi_complete(napi);
+
+		if (lp->rx_dim_enabled) {
+			struct dim_sample sample = {};
+
+			dim_update_sample(++q->rx_dim_events,
+					  q->rx_stats.packets,
+					  q->rx_stats.bytes, &sample);
+			net_dim(&q->rx_dim, sample);
+		}
 #ifdef CONFIG_AXIENET_HAS_MCDMA
 		/* Enable the interrupts again */
 		cr = axienet_dma_in32(q, XMCDMA_CHAN_CR_OFFSET(q->chan_id) +
 				      XMCDMA_RX_OFFSET);
 		cr |= (XMCDMA_IRQ_IOC_MASK | XMCDMA_IRQ_DELAY_MASK);
+		if (lp->rx_dim_enabled)
+			cr = axienet_dim_update_cr(cr, READ_ONCE(q->rx_dim_cr));
 		axienet_dma_out32(q, XMCDMA_CHAN_CR_OFFSET(q->chan_id) +
 				  XMCDMA_RX_OFFSET, cr);
 #else
 		/* Enable the interrupts again */
 		cr = axienet_dma_in32(q, XAXIDMA_RX_CR_OFFSET);
 		cr |= (XAXIDMA_IRQ_IOC_MASK | XAXIDMA_IRQ_DELAY_MASK);
+		if (lp->rx_dim_enabled)
+			cr = axienet_dim_update_cr(cr, READ_ONCE(q->rx_dim_cr));
 		axienet_dma_out32(q, XAXIDMA_RX_CR_OFFSET, cr);
 #endif
+	} else {
+		u64_stats_update_begin(&q->rx_stats.syncp);
+		q->rx_stats.budget_exhausted++;
+		u64_stats_update_end(&q->rx_stats.syncp);
 	}
 
 	return work_done;
 }
 
+/**
+ * xaxienet_tx_poll - Poll routine for tx completions (NAPI)
+ * @napi:	napi structure pointer
+ * @budget:	Max number of rx packets, unused for tx completion.
+ *
+ * This is the poll routine for tx part. It reclaims the completed Tx BDs
+ * and enables the Tx completion interrupts again. Completions are handled
+ * from softirq context so that XDP frames can be returned to their memory
+ * allocator. On a queue bound to an AF_XDP socket it also queues up to
+ * @budget frames of the socket Tx ring.
+ *
+ * Return: 0, all pending completions are always processed
+ *	   @budget, if the AF_XDP Tx ring still holds frames
+ */
+int xaxienet_tx_poll(struct napi_struct *napi, int budget)
+{
+	struct net_device *ndev = napi->dev;
+	struct axienet_local *lp = netdev_priv(ndev);
+	int map = napi - lp->napi_tx;
+	struct axienet_dma_q *q = lp->dq[map];
+	u32 cr;
+
+	axienet_start_xmit_done(ndev, q);
+
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	if (axienet_xsk_umem(q)) {
+		if (xsk_umem_uses_need_wakeup(q->xsk_umem))
+			xsk_set_tx_need_wakeup(q->xsk_umem);
+		if (!axienet_xsk_xmit(q, budget)) {
+			u64_stats_update_begin(&q->tx_stats.syncp);
+			q->tx_stats.budget_exhausted++;
+			u64_stats_update_end(&q->tx_stats.syncp);
+			return budget;
+		}
+	}
+#endif
+
+	napi_complete(napi);
+
+	if (lp->tx_dim_enabled) {
+		struct dim_sample sample = {};
+
+		dim_update_sample(++q->tx_dim_events, q->tx_stats.packets,
+				  q->tx_stats.bytes, &sample);
+		net_dim(&q->tx_dim, sample);
+	}
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	/* Enable the interrupts again */
+	cr = axienet_dma_in32(q, XMCDMA_CHAN_CR_OFFSET(q->chan_id));
+	cr |= (XMCDMA_IRQ_IOC_MASK | XMCDMA_IRQ_DELAY_MASK);
+	if (lp->tx_dim_enabled)
+		cr = axienet_dim_update_cr(cr, READ_ONCE(q->tx_dim_cr));
+	axienet_dma_out32(q, XMCDMA_CHAN_CR_OFFSET(q->chan_id), cr);
+#else
+	/* Enable the interrupts again */
+	cr = axienet_dma_in32(q, XAXIDMA_TX_CR_OFFSET);
+	cr |= (XAXIDMA_IRQ_IOC_MASK | XAXIDMA_IRQ_DELAY_MASK);
+	if (lp->tx_dim_enabled)
+		cr = axienet_dim_update_cr(cr, READ_ONCE(q->tx_dim_cr));
+	axienet_dma_out32(q, XAXIDMA_TX_CR_OFFSET, cr);
+#endif
+
+	return 0;
+}
+
 /**
  * axienet_eth_irq - Ethernet core Isr.
  * @irq:	irq number
@@ -1766,6 +2984,7 @@ static int axienet_open(struct net_device *ndev)
 				     axienet_dma_err_handler,
 				     (unsigned long)lp->dq[i]);
 #endif
+			axienet_dim_init(lp, lp->dq[i]);
 
 			/* Enable NAPI scheduling before enabling Axi DMA Rx
 			 * IRQ, or you might run into a race condition; the RX
@@ -1779,6 +2998,11 @@ static int axienet_open(struct net_device *ndev)
 		}
 		for_each_tx_dma_queue(lp, i) {
 			struct axienet_dma_q *q = lp->dq[i];
+
+			/* Tx completions are reaped by NAPI, which also
+			 * re-enables the Tx IRQs.
+			 */
+			napi_enable(&lp->napi_tx[i]);
 #ifdef CONFIG_AXIENET_HAS_MCDMA
 			/* Enable interrupts for Axi MCDMA Tx */
 			ret = request_irq(q->tx_irq, axienet_mcdma_tx_irq,
@@ -1792,6 +3016,8 @@ static int axienet_open(struct net_device *ndev)
 			if (ret)
 				goto err_tx_irq;
 #endif
+			irq_set_affinity_hint(q->tx_irq,
+					      axienet_dma_q_affinity(lp, i));
 		}
 
 		for_each_rx_dma_queue(lp, i) {
@@ -1809,6 +3035,8 @@ static int axienet_open(struct net_device *ndev)
 			if (ret)
 				goto err_rx_irq;
 #endif
+			irq_set_affinity_hint(q->rx_irq,
+					      axienet_dma_q_affinity(lp, i));
 		}
 	}
 #ifdef CONFIG_XILINX_TSN_PTP
@@ -1825,11 +3053,13 @@ static int axienet_open(struct net_device *ndev)
 				  0, "ptp_rx", ndev);
 		if (ret)
 			goto err_ptp_rx_irq;
+		axienet_irq_affinity(lp->ptp_rx_irq);
 
 		ret = request_irq(lp->ptp_tx_irq, axienet_ptp_tx_irq,
 				  0, "ptp_tx", ndev);
 		if (ret)
 			goto err_ptp_rx_irq;
+		axienet_irq_affinity(lp->ptp_tx_irq);
 	}
 #endif
 
@@ -1872,10 +3102,10 @@ static int axienet_open(struct net_device *ndev)
 		 */
 		axienet_iow(lp, XXV_USXGMII_AN_OFFSET,
 			    reg & ~USXGMII_AN_RESTART);
-		mdelay(1);
+		usleep_range(1000, 2000);
 		axienet_iow(lp, XXV_USXGMII_AN_OFFSET,
 			    reg | USXGMII_AN_RESTART);
-		mdelay(1);
+		usleep_range(1000, 2000);
 		axienet_iow(lp, XXV_USXGMII_AN_OFFSET,
 			    reg & ~USXGMII_AN_RESTART);
 
@@ -1911,7 +3141,7 @@ static int axienet_open(struct net_device *ndev)
 		/* Reset MRMAC */
 		axienet_mrmac_reset(lp);
 
-		mdelay(MRMAC_RESET_DELAY);
+		usleep_range(MRMAC_RESET_DELAY_US, 2 * MRMAC_RESET_DELAY_US);
 		/* Check for block lock bit to be set. This ensures that
 		 * MRMAC ethernet IP is functioning normally.
 		 */
@@ -1936,6 +3166,7 @@ static int axienet_open(struct net_device *ndev)
 				  ndev->name, ndev);
 		if (ret)
 			goto err_eth_irq;
+		axienet_irq_affinity(lp->eth_irq);
 	}
 
 	netif_tx_start_all_queues(ndev);
@@ -1944,15 +3175,19 @@ static int axienet_open(struct net_device *ndev)
 err_eth_irq:
 	while (i--) {
 		q = lp->dq[i];
+		irq_set_affinity_hint(q->rx_irq, NULL);
 		free_irq(q->rx_irq, ndev);
 	}
 	i = lp->num_tx_queues;
 err_rx_irq:
 	while (i--) {
 		q = lp->dq[i];
+		irq_set_affinity_hint(q->tx_irq, NULL);
 		free_irq(q->tx_irq, ndev);
 	}
 err_tx_irq:
+	for_each_tx_dma_queue(lp, i)
+		napi_disable(&lp->napi_tx[i]);
 	for_each_rx_dma_queue(lp, i)
 		napi_disable(&lp->napi[i]);
 	if (phydev)
@@ -2030,7 +3265,9 @@ static int axienet_stop(struct net_device *ndev)
 				axienet_mdio_enable(lp);
 				mutex_unlock(&lp->mii_bus->mdio_lock);
 			}
+			irq_set_affinity_hint(q->tx_irq, NULL);
 			free_irq(q->tx_irq, ndev);
+			napi_disable(&lp->napi_tx[i]);
 		}
 
 		for_each_rx_dma_queue(lp, i) {
@@ -2038,16 +3275,30 @@ static int axienet_stop(struct net_device *ndev)
 			netif_stop_queue(ndev);
 			napi_disable(&lp->napi[i]);
 			tasklet_kill(&lp->dma_err_tasklet[i]);
+			cancel_work_sync(&q->rx_dim.work);
+			cancel_work_sync(&q->tx_dim.work);
+			irq_set_affinity_hint(q->rx_irq, NULL);
 			free_irq(q->rx_irq, ndev);
 		}
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+		if (!lp->is_tsn) {
+			cancel_work_sync(&lp->tx_hwts_work);
+			skb_queue_purge(&lp->tx_hwts_skbq);
+		}
+#endif
 #ifdef CONFIG_XILINX_TSN_PTP
 		if (lp->is_tsn) {
+			irq_set_affinity_hint(lp->ptp_tx_irq, NULL);
 			free_irq(lp->ptp_tx_irq, ndev);
+			irq_set_affinity_hint(lp->ptp_rx_irq, NULL);
 			free_irq(lp->ptp_rx_irq, ndev);
 		}
 #endif
-		if ((lp->axienet_config->mactype == XAXIENET_1G) && !lp->eth_hasnobuf)
+		if ((lp->axienet_config->mactype == XAXIENET_1G) &&
+		    !lp->eth_hasnobuf) {
+			irq_set_affinity_hint(lp->eth_irq, NULL);
 			free_irq(lp->eth_irq, ndev);
+		}
 
 		if (ndev->phydev)
 			phy_disconnect(ndev->phydev);
@@ -2080,11 +3331,184 @@ static int axienet_change_mtu(struct net_device *ndev, int new_mtu)
 		XAE_TRL_SIZE) > lp->rxmem)
 		return -EINVAL;
 
+	if (lp->xdp_prog && !axienet_xdp_frame_fits(new_mtu))
+		return -EINVAL;
+
 	ndev->mtu = new_mtu;
 
 	return 0;
 }
 
+/**
+ * axienet_xdp_setup - Attach or detach an XDP program
+ * @ndev:	Pointer to net_device structure
+ * @bpf:	Pointer to the netdev_bpf command
+ *
+ * The Rx page pools are mapped bidirectionally only while a program is
+ * attached, so the interface is restarted to recreate them when a program
+ * is attached to or detached from a running device. Replacing one program
+ * by another is done on the fly.
+ *
+ * Return: 0, on success
+ *	    Non-zero error value on failure
+ */
+static int axienet_xdp_setup(struct net_device *ndev, struct netdev_bpf *bpf)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	struct bpf_prog *prog = bpf->prog;
+	struct bpf_prog *old_prog;
+	bool need_reset;
+	int ret;
+
+	if (prog && lp->is_tsn) {
+		NL_SET_ERR_MSG_MOD(bpf->extack,
+				   "XDP is not supported on TSN ports");
+		return -EOPNOTSUPP;
+	}
+
+	if (prog && !axienet_xdp_frame_fits(ndev->mtu)) {
+		NL_SET_ERR_MSG_MOD(bpf->extack, "MTU too large for XDP");
+		return -EINVAL;
+	}
+
+	if (prog && axienet_xdp_ts_inband(lp)) {
+		NL_SET_ERR_MSG_MOD(bpf->extack,
+				   "XDP is not supported with in-band timestamps");
+		return -EBUSY;
+	}
+
+	need_reset = !!lp->xdp_prog != !!prog;
+	if (need_reset && netif_running(ndev))
+		axienet_stop(ndev);
+	else
+		need_reset = false;
+
+	old_prog = xchg(&lp->xdp_prog, prog);
+	if (old_prog)
+		bpf_prog_put(old_prog);
+
+	if (need_reset) {
+		ret = axienet_open(ndev);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+/**
+ * axienet_xsk_umem_setup - Bind or unbind an AF_XDP UMEM to a DMA queue
+ * @ndev:	Pointer to net_device structure
+ * @umem:	UMEM to be bound, NULL to unbind the current one
+ * @qid:	DMA queue index
+ *
+ * The Rx and Tx rings of the queue are rebuilt on top of the UMEM, so a
+ * running interface is restarted. Zero-copy only takes effect while an XDP
+ * program is attached, the queue uses the page pool otherwise.
+ *
+ * Return: 0, on success
+ *	    Non-zero error value on failure
+ */
+static int axienet_xsk_umem_setup(struct net_device *ndev,
+				  struct xdp_umem *umem, u16 qid)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	struct xdp_umem_fq_reuse *reuseq;
+	struct xdp_umem *old_umem;
+	struct axienet_dma_q *q;
+	bool running;
+	int ret;
+
+	if (qid >= lp->num_rx_queues || qid >= lp->num_tx_queues)
+		return -EINVAL;
+
+	q = lp->dq[qid];
+	old_umem = q->xsk_umem;
+	if (umem) {
+		if (lp->is_tsn)
+			return -EOPNOTSUPP;
+
+		/* The 10G/25G and MRMAC timestamp FIFOs are drained by the
+		 * skb path, which zero-copy frames never go through.
+		 */
+		if (IS_ENABLED(CONFIG_XILINX_AXI_EMAC_HWTSTAMP) &&
+		    (lp->axienet_config->mactype == XAXIENET_10G_25G ||
+		     lp->axienet_config->mactype == XAXIENET_MRMAC))
+			return -EOPNOTSUPP;
+
+		if (old_umem)
+			return -EBUSY;
+
+		if (umem->chunk_size_nohr - XDP_PACKET_HEADROOM <
+		    lp->max_frm_size)
+			return -EINVAL;
+
+		reuseq = xsk_reuseq_prepare(lp->rx_bd_num);
+		if (!reuseq)
+			return -ENOMEM;
+
+		xsk_reuseq_free(xsk_reuseq_swap(umem, reuseq));
+
+		ret = axienet_xsk_umem_dma_map(lp, umem);
+		if (ret)
+			return ret;
+
+		q->zca.free = axienet_xsk_zca_free;
+	} else if (!old_umem) {
+		return -EINVAL;
+	}
+
+	running = netif_running(ndev);
+	if (running)
+		axienet_stop(ndev);
+
+	q->xsk_umem = umem;
+	if (!umem)
+		axienet_xsk_umem_dma_unmap(lp, old_umem);
+
+	if (running) {
+		ret = axienet_open(ndev);
+		if (ret)
+			return ret;
+	}
+
+	/* Kick the socket rings that may already hold descriptors */
+	if (running && umem && lp->xdp_prog)
+		axienet_xsk_wakeup(ndev, qid, XDP_WAKEUP_RX | XDP_WAKEUP_TX);
+
+	return 0;
+}
+#endif
+
+/**
+ * axienet_xdp - ndo_bpf handler
+ * @ndev:	Pointer to net_device structure
+ * @bpf:	Pointer to the netdev_bpf command
+ *
+ * Return: 0, on success
+ *	    Non-zero error value on failure
+ */
+static int axienet_xdp(struct net_device *ndev, struct netdev_bpf *bpf)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+
+	switch (bpf->command) {
+	case XDP_SETUP_PROG:
+		return axienet_xdp_setup(ndev, bpf);
+	case XDP_QUERY_PROG:
+		bpf->prog_id = lp->xdp_prog ? lp->xdp_prog->aux->id : 0;
+		return 0;
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	case XDP_SETUP_XSK_UMEM:
+		return axienet_xsk_umem_setup(ndev, bpf->xsk.umem,
+					      bpf->xsk.queue_id);
+#endif
+	default:
+		return -EINVAL;
+	}
+}
+
 #ifdef CONFIG_NET_POLL_CONTROLLER
 /**
  * axienet_poll_controller - Axi Ethernet poll mechanism.
@@ -2227,6 +3651,14 @@ static int axienet_set_ts_config(struct axienet_local *lp, struct ifreq *ifr)
 	if (copy_from_user(&config, ifr->ifr_data, sizeof(config)))
 		return -EFAULT;
 
+	/* In-band timestamps would corrupt the frames seen by XDP */
+	if (lp->xdp_prog &&
+	    lp->axienet_config->mactype != XAXIENET_10G_25G &&
+	    lp->axienet_config->mactype != XAXIENET_MRMAC &&
+	    (config.tx_type != HWTSTAMP_TX_OFF ||
+	     config.rx_filter != HWTSTAMP_FILTER_NONE))
+		return -EBUSY;
+
 	err = axienet_set_timestamp_mode(lp, &config);
 	if (err)
 		return err;
@@ -2306,17 +3738,156 @@ static int axienet_ioctl(struct net_device *dev, struct ifreq *rq, int cmd)
 	}
 }
 
+/**
+ * axienet_get_stats64 - Get the statistics of the interface
+ * @ndev:	Pointer to net_device structure
+ * @stats:	Pointer to rtnl_link_stats64 structure to fill in
+ *
+ * The packet and byte counters are kept per DMA queue so that the data
+ * path does not share a cache line between queues. All queues found at
+ * probe time are summed up, so the counters do not go backwards when
+ * the number of channels is reduced.
+ */
+static void axienet_get_stats64(struct net_device *ndev,
+				struct rtnl_link_stats64 *stats)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	struct axienet_tx_stats *tx;
+	struct axienet_rx_stats *rx;
+	u64 packets, bytes;
+	unsigned int start;
+	int i;
+
+	netdev_stats_to_stats64(stats, &ndev->stats);
+
+	for (i = 0; i < lp->max_queues; i++) {
+		/* A TSN slave port has no DMA queues of its own */
+		if (!lp->dq[i])
+			continue;
+
+		tx = &lp->dq[i]->tx_stats;
+		do {
+			start = u64_stats_fetch_begin_irq(&tx->syncp);
+			packets = tx->packets;
+			bytes = tx->bytes;
+		} while (u64_stats_fetch_retry_irq(&tx->syncp, start));
+		stats->tx_packets += packets;
+		stats->tx_bytes += bytes;
+
+		rx = &lp->dq[i]->rx_stats;
+		do {
+			start = u64_stats_fetch_begin_irq(&rx->syncp);
+			packets = rx->packets;
+			bytes = rx->bytes;
+		} while (u64_stats_fetch_retry_irq(&rx->syncp, start));
+		stats->rx_packets += packets;
+		stats->rx_bytes += bytes;
+	}
+}
+
+#ifdef CONFIG_XILINX_TSN_SWITCH
+/**
+ * axienet_get_port_parent_id - Get the ID of the switch behind a TSN port
+ * @ndev:	Pointer to net_device structure
+ * @ppid:	Pointer to the ID to fill in
+ *
+ * Both TSN MAC ports report the same ID, so the bridge knows that frames
+ * between them are forwarded by the switch.
+ *
+ * Return: 0 on success, -EOPNOTSUPP on a non TSN port.
+ */
+static int axienet_get_port_parent_id(struct net_device *ndev,
+				      struct netdev_phys_item_id *ppid)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+
+	if (!lp->is_tsn)
+		return -EOPNOTSUPP;
+
+	return tsn_switch_get_port_parent_id(ppid);
+}
+#endif
+
+#ifdef CONFIG_XILINX_TSN_QCI
+static LIST_HEAD(axienet_block_cb_list);
+
+static int axienet_setup_tc_block_cb(enum tc_setup_type type, void *type_data,
+				     void *cb_priv)
+{
+	struct net_device *ndev = cb_priv;
+
+	switch (type) {
+	case TC_SETUP_CLSFLOWER:
+		return tsn_qci_flower(ndev, type_data);
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+#endif
+
+#if defined(CONFIG_XILINX_TSN_QBV) || defined(CONFIG_XILINX_TSN_QCI)
+/**
+ * axienet_setup_tc - Offload a traffic control configuration
+ * @ndev:	Pointer to net_device structure
+ * @type:	Type of the offload
+ * @type_data:	Offload parameters, depending on @type
+ *
+ * taprio schedules go to the Qbv shaper, flower rules on the ingress
+ * block to the Qci stream filters.
+ *
+ * Return: 0 on success, -EOPNOTSUPP for an offload the TSN MAC port does
+ * not support, or the error returned by the shaper or the filters.
+ */
+static int axienet_setup_tc(struct net_device *ndev, enum tc_setup_type type,
+			    void *type_data)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+
+	if (!lp->is_tsn)
+		return -EOPNOTSUPP;
+
+	switch (type) {
+#ifdef CONFIG_XILINX_TSN_QBV
+	case TC_SETUP_QDISC_TAPRIO:
+		return axienet_taprio_setup(ndev, type_data);
+#endif
+#ifdef CONFIG_XILINX_TSN_QCI
+	case TC_SETUP_BLOCK:
+		return flow_block_cb_setup_simple(type_data,
+						  &axienet_block_cb_list,
+						  axienet_setup_tc_block_cb,
+						  ndev, ndev, true);
+#endif
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+#endif
+
 static const struct net_device_ops axienet_netdev_ops = {
 	.ndo_open = axienet_open,
 	.ndo_stop = axienet_stop,
 	.ndo_start_xmit = axienet_start_xmit,
+	.ndo_get_stats64 = axienet_get_stats64,
+	.ndo_select_queue = axienet_select_queue,
+	.ndo_features_check = axienet_features_check,
 	.ndo_change_mtu	= axienet_change_mtu,
 	.ndo_set_mac_address = netdev_set_mac_address,
 	.ndo_validate_addr = eth_validate_addr,
 	.ndo_set_rx_mode = axienet_set_multicast_list,
 	.ndo_do_ioctl = axienet_ioctl,
+	.ndo_bpf = axienet_xdp,
+	.ndo_xdp_xmit = axienet_xdp_xmit,
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	.ndo_xsk_wakeup = axienet_xsk_wakeup,
+#endif
 #ifdef CONFIG_NET_POLL_CONTROLLER
 	.ndo_poll_controller = axienet_poll_controller,
+#endif#if defined(CONFIG_XILINX_TSN_QBV) || defined(CONFIG_XILINX_TSN_QCI)
+	.ndo_setup_tc = axienet_setup_tc,
+#endif
+#ifdef CONFIG_XILINX_TSN_SWITCH
+	.ndo_get_port_parent_id = axienet_get_port_parent_id,
 #endif
 };
 
@@ -2429,22 +4000,284 @@ static void axienet_ethtools_get_ringparam(struct net_device *ndev,
 	ering->tx_pending = lp->tx_bd_num;
 }
 
+/**
+ * axienet_tx_bd_drop - Release the Tx BDs still owned by the DMA
+ * @q:		Pointer to DMA queue structure
+ *
+ * Used once the DMA is held in reset, every BD between the consumer and
+ * the tail index is unmapped and its frame released without completion.
+ */
+static void axienet_tx_bd_drop(struct axienet_dma_q *q)
+{
+	struct axienet_local *lp = q->lp;
+	struct device *dev = lp->ndev->dev.parent;
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	struct aximcdma_bd *cur_p;
+	u32 xsk_frames = 0;
+#else
+	struct axidma_bd *cur_p;
+#endif
+
+	while (q->tx_bd_ci != q->tx_bd_tail) {
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+		cur_p = &q->txq_bd_v[q->tx_bd_ci];
+#else
+		cur_p = &q->tx_bd_v[q->tx_bd_ci];
+#endif
+		if (cur_p->tx_desc_mapping == DESC_DMA_MAP_PAGE)
+			dma_unmap_page(dev, cur_p->phys,
+				       cur_p->cntrl &
+				       XAXIDMA_BD_CTRL_LENGTH_MASK,
+				       DMA_TO_DEVICE);
+		else if (cur_p->tx_desc_mapping == DESC_DMA_MAP_SINGLE)
+			dma_unmap_single(dev, cur_p->phys,
+					 cur_p->cntrl &
+					 XAXIDMA_BD_CTRL_LENGTH_MASK,
+					 DMA_TO_DEVICE);
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+		else if (cur_p->tx_desc_mapping == DESC_DMA_MAP_XSK)
+			xsk_frames++;
+#endif
+		if (cur_p->tx_skb)
+			dev_kfree_skb_any((struct sk_buff *)cur_p->tx_skb);
+		if (cur_p->tx_xdpf)
+			xdp_return_frame((struct xdp_frame *)cur_p->tx_xdpf);
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+		if (cur_p->ptp_tx_skb)
+			dev_kfree_skb_any((struct sk_buff *)cur_p->ptp_tx_skb);
+		cur_p->ptp_tx_skb = 0;
+#endif
+		cur_p->tx_skb = 0;
+		cur_p->tx_xdpf = 0;
+
+		if (++q->tx_bd_ci >= lp->tx_bd_num)
+			q->tx_bd_ci = 0;
+	}
+
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	if (xsk_frames)
+		xsk_umem_complete_tx(q->xsk_umem, xsk_frames);
+#endif
+}
+
+/**
+ * axienet_dma_restart - Rebuild the BD rings of a running interface
+ * @ndev:	Pointer to net_device structure
+ * @rx_bd_num:	New number of Rx BDs per queue
+ * @tx_bd_num:	New number of Tx BDs per queue
+ *
+ * The data path is quiesced and the DMA is reset, then the rings are
+ * reallocated with the new sizes and the channels are started again. The
+ * PHY stays attached and only the MAC settings lost in the DMA reset are
+ * programmed again, so the link is kept. If the new rings cannot be
+ * allocated the previous sizes are restored.
+ *
+ * Return: 0 on success, -ENOMEM if the new rings could not be allocated.
+ */
+static int axienet_dma_restart(struct net_device *ndev, u32 rx_bd_num,
+			       u32 tx_bd_num)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	u32 old_rx_bd_num = lp->rx_bd_num;
+	u32 old_tx_bd_num = lp->tx_bd_num;
+	struct axienet_dma_q *q;
+	u32 axienet_status;
+	int i, ret;
+
+	/* Keeps ndo_xdp_xmit off the rings, netif_tx_disable() waits for
+	 * the stack transmit path.
+	 */
+	netif_device_detach(ndev);
+	netif_tx_disable(ndev);
+	synchronize_net();
+
+	lp->axienet_config->setoptions(ndev, lp->options &
+				       ~(XAE_OPTION_TXEN | XAE_OPTION_RXEN));
+
+	for_each_tx_dma_queue(lp, i) {
+		q = lp->dq[i];
+		disable_irq(q->tx_irq);
+		napi_disable(&lp->napi_tx[i]);
+	}
+	for_each_rx_dma_queue(lp, i) {
+		q = lp->dq[i];
+		disable_irq(q->rx_irq);
+		napi_disable(&lp->napi[i]);
+		tasklet_disable(&lp->dma_err_tasklet[i]);
+	}
+
+	if (lp->axienet_config->mactype != XAXIENET_10G_25G &&
+	    lp->axienet_config->mactype != XAXIENET_MRMAC) {
+		mutex_lock(&lp->mii_bus->mdio_lock);
+		axienet_mdio_wait_until_ready(lp);
+		axienet_mdio_disable(lp);
+	}
+
+	for_each_rx_dma_queue(lp, i)
+		__axienet_device_reset(lp->dq[i]);
+
+	for_each_tx_dma_queue(lp, i)
+		axienet_tx_bd_drop(lp->dq[i]);
+
+	axienet_dma_bd_release(ndev);
+	lp->rx_bd_num = rx_bd_num;
+	lp->tx_bd_num = tx_bd_num;
+	ret = axienet_dma_bd_init(ndev);
+	if (ret) {
+		netdev_err(ndev, "%s: Failed to resize rings, keeping %u/%u\n",
+			   __func__, old_rx_bd_num, old_tx_bd_num);
+		axienet_dma_bd_release(ndev);
+		lp->rx_bd_num = old_rx_bd_num;
+		lp->tx_bd_num = old_tx_bd_num;
+		if (axienet_dma_bd_init(ndev))
+			netdev_err(ndev, "%s: descriptor allocation failed\n",
+				   __func__);
+	}
+
+	if (lp->axienet_config->mactype != XAXIENET_10G_25G &&
+	    lp->axienet_config->mactype != XAXIENET_MRMAC) {
+		axienet_mdio_enable(lp);
+		axienet_mdio_wait_until_ready(lp);
+		mutex_unlock(&lp->mii_bus->mdio_lock);
+
+		axienet_status = axienet_ior(lp, XAE_RCW1_OFFSET);
+		axienet_status &= ~XAE_RCW1_RX_MASK;
+		axienet_iow(lp, XAE_RCW1_OFFSET, axienet_status);
+		axienet_iow(lp, XAE_FCC_OFFSET, XAE_FCC_FCRX_MASK);
+	}
+
+	if (lp->axienet_config->mactype == XAXIENET_1G && !lp->eth_hasnobuf) {
+		axienet_status = axienet_ior(lp, XAE_IP_OFFSET);
+		if (axienet_status & XAE_INT_RXRJECT_MASK)
+			axienet_iow(lp, XAE_IS_OFFSET, XAE_INT_RXRJECT_MASK);
+		axienet_iow(lp, XAE_IE_OFFSET, lp->eth_irq > 0 ?
+			    XAE_INT_RECV_ERROR_MASK : 0);
+	}
+
+	axienet_set_mac_address(ndev, NULL);
+	axienet_set_multicast_list(ndev);
+	lp->axienet_config->setoptions(ndev, lp->options);
+
+	for_each_rx_dma_queue(lp, i) {
+		q = lp->dq[i];
+		tasklet_enable(&lp->dma_err_tasklet[i]);
+		napi_enable(&lp->napi[i]);
+		enable_irq(q->rx_irq);
+	}
+	for_each_tx_dma_queue(lp, i) {
+		q = lp->dq[i];
+		napi_enable(&lp->napi_tx[i]);
+		enable_irq(q->tx_irq);
+	}
+
+	netif_device_attach(ndev);
+
+	return ret;
+}
+
+/**
+ * axienet_ethtools_set_ringparam - Set the number of Rx and Tx BDs
+ * @ndev:	Pointer to net_device structure
+ * @ering:	Pointer to ethtool_ringparam structure
+ *
+ * A running interface gets its rings rebuilt in place, without a close and
+ * open cycle. Issue "ethtool -G ethX rx N tx M" to execute this function.
+ *
+ * Return: 0 on success, negative error value on failure.
+ */
 static int axienet_ethtools_set_ringparam(struct net_device *ndev,
 					  struct ethtool_ringparam *ering)
 {
 	struct axienet_local *lp = netdev_priv(ndev);
+	int ret = 0;
 
 	if (ering->rx_pending > RX_BD_NUM_MAX ||
+	    ering->rx_pending < RX_BD_NUM_MIN ||
 	    ering->rx_mini_pending ||
 	    ering->rx_jumbo_pending ||
-	    ering->rx_pending > TX_BD_NUM_MAX)
+	    ering->tx_pending > TX_BD_NUM_MAX ||
+	    ering->tx_pending < TX_BD_NUM_MIN)
+		return -EINVAL;
+
+	if (ering->rx_pending == lp->rx_bd_num &&
+	    ering->tx_pending == lp->tx_bd_num)
+		return 0;
+
+	if (netif_running(ndev)) {
+		/* The DMA of a TSN port is shared with its second MAC */
+		if (lp->is_tsn)
+			return -EBUSY;
+		ret = axienet_dma_restart(ndev, ering->rx_pending,
+					  ering->tx_pending);
+	} else {
+		lp->rx_bd_num = ering->rx_pending;
+		lp->tx_bd_num = ering->tx_pending;
+	}
+
+	if (ndev->hw_features & NETIF_F_TSO)
+		axienet_set_gso_max_segs(lp);
+	return ret;
+}
+
+/**
+ * axienet_ethtools_get_channels - Get the number of DMA queues in use
+ * @ndev:	Pointer to net_device structure
+ * @ch:		Pointer to ethtool_channels structure
+ *
+ * Every DMA queue has its own Rx and Tx channel, they are reported as
+ * combined channels. Issue "ethtool -l ethX" to execute this function.
+ */
+static void axienet_ethtools_get_channels(struct net_device *ndev,
+					  struct ethtool_channels *ch)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+
+	ch->max_combined = lp->max_queues;
+	ch->combined_count = lp->num_tx_queues;
+}
+
+/**
+ * axienet_ethtools_set_channels - Set the number of DMA queues in use
+ * @ndev:	Pointer to net_device structure
+ * @ch:		Pointer to ethtool_channels structure
+ *
+ * The queues of a TSN port are bound to its traffic classes and cannot be
+ * changed. Issue "ethtool -L ethX combined N" to execute this function.
+ *
+ * Return: 0 on success, Non-zero error value on failure.
+ */
+static int axienet_ethtools_set_channels(struct net_device *ndev,
+					 struct ethtool_channels *ch)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	int i, ret;
+
+	if (lp->is_tsn)
+		return -EOPNOTSUPP;
+
+	if (ch->rx_count || ch->tx_count || ch->other_count ||
+	    !ch->combined_count || ch->combined_count > lp->max_queues)
 		return -EINVAL;
 
 	if (netif_running(ndev))
 		return -EBUSY;
 
-	lp->rx_bd_num = ering->rx_pending;
-	lp->tx_bd_num = ering->tx_pending;
+	/* Keep the queues an AF_XDP socket is bound to */
+	for (i = ch->combined_count; i < lp->max_queues; i++)
+		if (lp->dq[i]->xsk_umem)
+			return -EBUSY;
+
+	ret = netif_set_real_num_tx_queues(ndev, ch->combined_count);
+	if (ret)
+		return ret;
+
+	ret = netif_set_real_num_rx_queues(ndev, ch->combined_count);
+	if (ret)
+		return ret;
+
+	lp->num_tx_queues = ch->combined_count;
+	lp->num_rx_queues = ch->combined_count;
+
 	return 0;
 }
 
@@ -2543,6 +4376,8 @@ static int axienet_ethtools_get_coalesce(struct net_device *ndev,
 						(regval & XAXIDMA_COALESCE_MASK)
 						     >> XAXIDMA_COALESCE_SHIFT;
 	}
+	ecoalesce->use_adaptive_rx_coalesce = lp->rx_dim_enabled;
+	ecoalesce->use_adaptive_tx_coalesce = lp->tx_dim_enabled;
 	return 0;
 }
 
@@ -2553,7 +4388,8 @@ static int axienet_ethtools_get_coalesce(struct net_device *ndev,
  *
  * This implements ethtool command for setting the DMA interrupt coalescing
  * count on Tx and Rx paths. Issue "ethtool -C ethX rx-frames 5" under linux
- * prompt to execute this function.
+ * prompt to execute this function. With "adaptive-rx on" or "adaptive-tx on"
+ * the count is only the starting point of the dynamic interrupt moderation.
  *
  * Return: 0, on success, Non-zero error value on failure.
  */
@@ -2575,8 +4411,6 @@ static int axienet_ethtools_set_coalesce(struct net_device *ndev,
 	    (ecoalesce->tx_coalesce_usecs_irq) ||
 	    (ecoalesce->tx_max_coalesced_frames_irq) ||
 	    (ecoalesce->stats_block_coalesce_usecs) ||
-	    (ecoalesce->use_adaptive_rx_coalesce) ||
-	    (ecoalesce->use_adaptive_tx_coalesce) ||
 	    (ecoalesce->pkt_rate_low) ||
 	    (ecoalesce->rx_coalesce_usecs_low) ||
 	    (ecoalesce->rx_max_coalesced_frames_low) ||
@@ -2593,6 +4427,8 @@ static int axienet_ethtools_set_coalesce(struct net_device *ndev,
 		lp->coalesce_count_rx = ecoalesce->rx_max_coalesced_frames;
 	if (ecoalesce->tx_max_coalesced_frames)
 		lp->coalesce_count_tx = ecoalesce->tx_max_coalesced_frames;
+	lp->rx_dim_enabled = !!ecoalesce->use_adaptive_rx_coalesce;
+	lp->tx_dim_enabled = !!ecoalesce->use_adaptive_tx_coalesce;
 
 	return 0;
 }
@@ -2632,6 +4468,8 @@ static const struct ethtool_ops axienet_ethtool_ops = {
 	.get_link       = ethtool_op_get_link,
 	.get_ringparam	= axienet_ethtools_get_ringparam,
 	.set_ringparam  = axienet_ethtools_set_ringparam,
+	.get_channels	= axienet_ethtools_get_channels,
+	.set_channels	= axienet_ethtools_set_channels,
 	.get_pauseparam = axienet_ethtools_get_pauseparam,
 	.set_pauseparam = axienet_ethtools_set_pauseparam,
 	.get_coalesce   = axienet_ethtools_get_coalesce,
@@ -2646,6 +4484,10 @@ static const struct ethtool_ops axienet_ethtool_ops = {
 	.get_ethtool_stats = axienet_get_stats,
 	.get_strings = axienet_strings,
 #endif
+#if defined(CONFIG_AXIENET_HAS_MCDMA) && defined(CONFIG_XILINX_TSN_QBR)
+	.get_priv_flags	= axienet_preemption_get_priv_flags,
+	.set_priv_flags	= axienet_preemption_set_priv_flags,
+#endif
 };
 
 #ifdef CONFIG_AXIENET_HAS_MCDMA
@@ -2668,6 +4510,10 @@ static int __maybe_unused axienet_mcdma_probe(struct platform_device *pdev,
 
 		/* parent */
 		q->lp = lp;
+		q->index = i;
+		u64_stats_init(&q->tx_stats.syncp);
+		u64_stats_init(&q->tx_stats.xmit_syncp);
+		u64_stats_init(&q->rx_stats.syncp);
 		lp->dq[i] = q;
 		ret = of_property_read_string_index(pdev->dev.of_node,
 						    "xlnx,channel-ids", i,
@@ -2728,6 +4574,10 @@ static int __maybe_unused axienet_dma_probe(struct platform_device *pdev,
 
 		/* parent */
 		q->lp = lp;
+		q->index = i;
+		u64_stats_init(&q->tx_stats.syncp);
+		u64_stats_init(&q->tx_stats.xmit_syncp);
+		u64_stats_init(&q->rx_stats.syncp);
 
 		lp->dq[i] = q;
 	}
@@ -2803,6 +4653,11 @@ static int __maybe_unused axienet_dma_probe(struct platform_device *pdev,
 			       XAXIENET_NAPI_WEIGHT);
 	}
 
+	for_each_tx_dma_queue(lp, i) {
+		netif_tx_napi_add(ndev, &lp->napi_tx[i], xaxienet_tx_poll,
+				  XAXIENET_NAPI_WEIGHT);
+	}
+
 	return 0;
 }
 
@@ -3113,6 +4968,110 @@ static const struct of_device_id axienet_of_match[] = {
 
 MODULE_DEVICE_TABLE(of, axienet_of_match);
 
+static struct dentry *axienet_debugfs_root;
+
+/* Status word of BD @i of a ring, the layout depends on the DMA flavour */
+static u32 axienet_tx_bd_status(struct axienet_dma_q *q, u32 i)
+{
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	return READ_ONCE(q->txq_bd_v[i].status);
+#else
+	return READ_ONCE(q->tx_bd_v[i].status);
+#endif
+}
+
+static u32 axienet_rx_bd_status(struct axienet_dma_q *q, u32 i)
+{
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	return READ_ONCE(q->rxq_bd_v[i].status);
+#else
+	return READ_ONCE(q->rx_bd_v[i].status);
+#endif
+}
+
+/* Number of consecutive completed BDs of a ring from @ci on */
+static u32 axienet_ring_done(struct axienet_dma_q *q, u32 ci, u32 num,
+			     u32 (*status)(struct axienet_dma_q *q, u32 i))
+{
+	u32 n;
+
+	for (n = 0; n < num; n++)
+		if (!(status(q, (ci + n) % num) &
+		      XAXIDMA_BD_STS_COMPLETE_MASK))
+			break;
+
+	return n;
+}
+
+/**
+ * axienet_rings_show - Dump the state of the Tx and Rx rings
+ * @m:		seq_file to print to
+ * @unused:	Unused
+ *
+ * The indices are sampled without the ring locks, so the snapshot is only
+ * consistent while the rings are quiet.
+ *
+ * Return: 0, always.
+ */
+static int axienet_rings_show(struct seq_file *m, void *unused)
+{
+	struct axienet_local *lp = m->private;
+	struct axienet_dma_q *q;
+	u32 ci, tail;
+	off_t cur, last;
+	int i;
+
+	rtnl_lock();
+	if (!netif_running(lp->ndev)) {
+		seq_puts(m, "interface down\n");
+		goto out;
+	}
+
+	for_each_tx_dma_queue(lp, i) {
+		q = lp->dq[i];
+		ci = READ_ONCE(q->tx_bd_ci);
+		tail = READ_ONCE(q->tx_bd_tail);
+
+		seq_printf(m, "tx%d: bds %u ci %u tail %u used %u done %u",
+			   i, lp->tx_bd_num, ci, tail,
+			   (tail + lp->tx_bd_num - ci) % lp->tx_bd_num,
+			   axienet_ring_done(q, ci, lp->tx_bd_num,
+					     axienet_tx_bd_status));
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+		cur = XMCDMA_CHAN_CURDESC_OFFSET(q->chan_id);
+		last = XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id);
+#else
+		cur = XAXIDMA_TX_CDESC_OFFSET;
+		last = XAXIDMA_TX_TDESC_OFFSET;
+#endif
+		seq_printf(m, " curdesc 0x%08x taildesc 0x%08x\n",
+			   axienet_dma_in32(q, cur), axienet_dma_in32(q, last));
+	}
+
+	for_each_rx_dma_queue(lp, i) {
+		q = lp->dq[i];
+		ci = READ_ONCE(q->rx_bd_ci);
+
+		seq_printf(m, "rx%d: bds %u ci %u done %u", i, lp->rx_bd_num,
+			   ci, axienet_ring_done(q, ci, lp->rx_bd_num,
+						 axienet_rx_bd_status));
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+		cur = XMCDMA_CHAN_CURDESC_OFFSET(q->chan_id) + q->rx_offset;
+		last = XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id) + q->rx_offset;
+#else
+		cur = XAXIDMA_RX_CDESC_OFFSET;
+		last = XAXIDMA_RX_TDESC_OFFSET;
+#endif
+		seq_printf(m, " curdesc 0x%08x taildesc 0x%08x\n",
+			   axienet_dma_in32(q, cur), axienet_dma_in32(q, last));
+	}
+out:
+	rtnl_unlock();
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(axienet_rings);
+
 /**
  * axienet_probe - Axi Ethernet probe function.
  * @pdev:	Pointer to platform device structure.
@@ -3180,6 +5139,7 @@ static int axienet_probe(struct platform_device *pdev)
 	lp->options = XAE_OPTION_DEFAULTS;
 	lp->num_tx_queues = num_queues;
 	lp->num_rx_queues = num_queues;
+	lp->max_queues = num_queues;
 	lp->is_tsn = is_tsn;
 	lp->rx_bd_num = RX_BD_NUM_DEFAULT;
 	lp->tx_bd_num = TX_BD_NUM_DEFAULT;
@@ -3376,6 +5336,9 @@ static int axienet_probe(struct platform_device *pdev)
 	if (!lp->is_tsn) {
 		struct resource txtsres, rxtsres;
 
+		skb_queue_head_init(&lp->tx_hwts_skbq);
+		INIT_WORK(&lp->tx_hwts_work, axienet_tx_hwtstamp_work);
+
 		/* Find AXI Stream FIFO */
 		np = of_parse_phandle(pdev->dev.of_node, "axififo-connected",
 				      0);
@@ -3459,6 +5422,8 @@ static int axienet_probe(struct platform_device *pdev)
 				dev_err(&pdev->dev, "DMA clock init failed %d\n", ret);
 			goto free_netdev;
 		}
+
+		axienet_tso_init(lp);
 	}
 
 	ret = axienet_clk_init(pdev, &lp->aclk, &lp->eth_sclk,
@@ -3524,6 +5489,10 @@ static int axienet_probe(struct platform_device *pdev)
 	}
 #endif
 
+#ifdef CONFIG_XILINX_TSN_QBV
+	spin_lock_init(&lp->qbv_lock);
+#endif
+
 	ret = register_netdev(lp->ndev);
 	if (ret) {
 		dev_err(lp->dev, "register_netdev() error (%i)\n", ret);
@@ -3558,6 +5527,16 @@ static int axienet_probe(struct platform_device *pdev)
 		}
 	}
 #endif
+#ifdef CONFIG_XILINX_TSN_SWITCH
+	if (lp->is_tsn)
+		tsn_switchdev_port_register(ndev);
+#endif
+
+	lp->debugfs = debugfs_create_dir(dev_name(lp->dev),
+					 axienet_debugfs_root);
+	debugfs_create_file("rings", 0444, lp->debugfs, lp,
+			    &axienet_rings_fops);
+
 	return 0;
 
 err_disable_clk:
@@ -3574,10 +5553,21 @@ static int axienet_remove(struct platform_device *pdev)
 	struct axienet_local *lp = netdev_priv(ndev);
 	int i;
 
+	debugfs_remove_recursive(lp->debugfs);
+
 	if (!lp->is_tsn || lp->temac_no == XAE_TEMAC1) {
-		for_each_rx_dma_queue(lp, i)
+		/* NAPI contexts exist for every hardware queue, including the
+		 * ones disabled through ethtool -L.
+		 */
+		for (i = 0; i < lp->max_queues; i++) {
 			netif_napi_del(&lp->napi[i]);
+			netif_napi_del(&lp->napi_tx[i]);
+		}
 	}
+#ifdef CONFIG_XILINX_TSN_SWITCH
+	if (lp->is_tsn)
+		tsn_switchdev_port_unregister(ndev);
+#endif
 #ifdef CONFIG_XILINX_TSN_PTP
 		axienet_ptp_timer_remove(lp->timer_priv);
 #ifdef CONFIG_XILINX_TSN_QBV
@@ -3624,10 +5614,30 @@ static struct platform_driver axienet_driver = {
 	.driver = {
 		 .name = "xilinx_axienet",
 		 .of_match_table = axienet_of_match,
+		 .probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 };
 
-module_platform_driver(axienet_driver);
+static int __init axienet_init(void)
+{
+	int ret;
+
+	axienet_debugfs_root = debugfs_create_dir("xilinx_axienet", NULL);
+
+	ret = platform_driver_register(&axienet_driver);
+	if (ret)
+		debugfs_remove_recursive(axienet_debugfs_root);
+
+	return ret;
+}
+module_init(axienet_init);
+
+static void __exit axienet_exit(void)
+{
+	platform_driver_unregister(&axienet_driver);
+	debugfs_remove_recursive(axienet_debugfs_root);
+}
+module_exit(axienet_exit);
 
 MODULE_DESCRIPTION("Xilinx Axi Ethernet driver");
 MODULE_AUTHOR("Xilinx");
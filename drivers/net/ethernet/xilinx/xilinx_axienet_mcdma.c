@@ -19,6 +19,7 @@
 #include <linux/of_irq.h>
 #include <linux/of_address.h>
 #include <linux/of_net.h>
+#include <net/xdp_sock.h>
 
 #include "xilinx_axienet.h"
 
@@ -26,74 +27,19 @@ struct axienet_stat {
 	const char *name;
 };
 
-static struct axienet_stat axienet_get_tx_strings_stats[] = {
-	{ "txq0_packets" },
-	{ "txq0_bytes"   },
-	{ "txq1_packets" },
-	{ "txq1_bytes"   },
-	{ "txq2_packets" },
-	{ "txq2_bytes"   },
-	{ "txq3_packets" },
-	{ "txq3_bytes"   },
-	{ "txq4_packets" },
-	{ "txq4_bytes"   },
-	{ "txq5_packets" },
-	{ "txq5_bytes"   },
-	{ "txq6_packets" },
-	{ "txq6_bytes"   },
-	{ "txq7_packets" },
-	{ "txq7_bytes"   },
-	{ "txq8_packets" },
-	{ "txq8_bytes"   },
-	{ "txq9_packets" },
-	{ "txq9_bytes"   },
-	{ "txq10_packets" },
-	{ "txq10_bytes"   },
-	{ "txq11_packets" },
-	{ "txq11_bytes"   },
-	{ "txq12_packets" },
-	{ "txq12_bytes"   },
-	{ "txq13_packets" },
-	{ "txq13_bytes"   },
-	{ "txq14_packets" },
-	{ "txq14_bytes"   },
-	{ "txq15_packets" },
-	{ "txq15_bytes"   },
+/* Per queue counters, in the order filled in by axienet_get_stats() */
+static const struct axienet_stat axienet_get_tx_strings_stats[] = {
+	{ "packets" },
+	{ "bytes" },
+	{ "ring_full" },
+	{ "budget_exhausted" },
 };
 
-static struct axienet_stat axienet_get_rx_strings_stats[] = {
-	{ "rxq0_packets" },
-	{ "rxq0_bytes"   },
-	{ "rxq1_packets" },
-	{ "rxq1_bytes"   },
-	{ "rxq2_packets" },
-	{ "rxq2_bytes"   },
-	{ "rxq3_packets" },
-	{ "rxq3_bytes"   },
-	{ "rxq4_packets" },
-	{ "rxq4_bytes"   },
-	{ "rxq5_packets" },
-	{ "rxq5_bytes"   },
-	{ "rxq6_packets" },
-	{ "rxq6_bytes"   },
-	{ "rxq7_packets" },
-	{ "rxq7_bytes"   },
-	{ "rxq8_packets" },
-	{ "rxq8_bytes"   },
-	{ "rxq9_packets" },
-	{ "rxq9_bytes"   },
-	{ "rxq10_packets" },
-	{ "rxq10_bytes"   },
-	{ "rxq11_packets" },
-	{ "rxq11_bytes"   },
-	{ "rxq12_packets" },
-	{ "rxq12_bytes"   },
-	{ "rxq13_packets" },
-	{ "rxq13_bytes"   },
-	{ "rxq14_packets" },
-	{ "rxq14_bytes"   },
-	{ "rxq15_packets" },
-	{ "rxq15_bytes"   },
+static const struct axienet_stat axienet_get_rx_strings_stats[] = {
+	{ "packets" },
+	{ "bytes" },
+	{ "refill_failures" },
+	{ "budget_exhausted" },
 };
 
 /**
@@ -114,12 +60,14 @@ void __maybe_unused axienet_mcdma_tx_bd_free(struct net_device *ndev,
 				  sizeof(*q->txq_bd_v) * lp->tx_bd_num,
 				  q->txq_bd_v,
 				  q->tx_bd_p);
+		q->txq_bd_v = NULL;
 	}
 	if (q->tx_bufs) {
 		dma_free_coherent(ndev->dev.parent,
 				  XAE_MAX_PKT_LEN * lp->tx_bd_num,
 				  q->tx_bufs,
 				  q->tx_bufs_dma);
+		q->tx_bufs = NULL;
 	}
 }
 
@@ -137,19 +85,20 @@ void __maybe_unused axienet_mcdma_rx_bd_free(struct net_device *ndev,
 	int i;
 	struct axienet_local *lp = netdev_priv(ndev);
 
-	for (i = 0; i < lp->rx_bd_num; i++) {
-		dma_unmap_single(ndev->dev.parent, q->rxq_bd_v[i].phys,
-				 lp->max_frm_size, DMA_FROM_DEVICE);
-		dev_kfree_skb((struct sk_buff *)
-			      (q->rxq_bd_v[i].sw_id_offset));
-	}
+	if (!q->rxq_bd_v)
+		return;
 
-	if (q->rxq_bd_v) {
-		dma_free_coherent(ndev->dev.parent,
-				  sizeof(*q->rxq_bd_v) * lp->rx_bd_num,
-				  q->rxq_bd_v,
-				  q->rx_bd_p);
-	}
+	if (axienet_xsk_umem(q))
+		axienet_xsk_rx_ring_free(q);
+	else
+		for (i = 0; i < lp->rx_bd_num; i++)
+			axienet_rx_buf_free(q, q->rxq_bd_v[i].sw_id_offset);
+
+	dma_free_coherent(ndev->dev.parent,
+			  sizeof(*q->rxq_bd_v) * lp->rx_bd_num,
+			  q->rxq_bd_v,
+			  q->rx_bd_p);
+	q->rxq_bd_v = NULL;
 }
 
 /**
@@ -171,6 +120,8 @@ int __maybe_unused axienet_mcdma_tx_q_init(struct net_device *ndev,
 
 	q->tx_bd_ci = 0;
 	q->tx_bd_tail = 0;
+	q->tx_db_pending = false;
+	netdev_tx_reset_queue(axienet_dma_q_txq(q));
 
 	q->txq_bd_v = dma_alloc_coherent(ndev->dev.parent,
 					 sizeof(*q->txq_bd_v) * lp->tx_bd_num,
@@ -248,7 +199,6 @@ int __maybe_unused axienet_mcdma_rx_q_init(struct net_device *ndev,
 {
 	u32 cr, chan_en;
 	int i;
-	struct sk_buff *skb;
 	struct axienet_local *lp = netdev_priv(ndev);
 
 	q->rx_bd_ci = 0;
@@ -260,25 +210,22 @@ int __maybe_unused axienet_mcdma_rx_q_init(struct net_device *ndev,
 	if (!q->rxq_bd_v)
 		goto out;
 
+	q->xsk_rx_next = 0;
+	q->xsk_rx_count = 0;
+
 	for (i = 0; i < lp->rx_bd_num; i++) {
 		q->rxq_bd_v[i].next = q->rx_bd_p +
 				      sizeof(*q->rxq_bd_v) *
 				      ((i + 1) % lp->rx_bd_num);
 
-		skb = netdev_alloc_skb(ndev, lp->max_frm_size);
-		if (!skb)
-			goto out;
+		/* Zero-copy buffers come from the UMEM fill queue */
+		if (axienet_xsk_umem(q))
+			continue;
 
-		/* Ensure that the skb is completely updated
-		 * prio to mapping the DMA
-		 */
-		wmb();
+		if (axienet_rx_buf_alloc(q, &q->rxq_bd_v[i].phys,
+					 &q->rxq_bd_v[i].sw_id_offset))
+			goto out;
 
-		q->rxq_bd_v[i].sw_id_offset = (phys_addr_t)skb;
-		q->rxq_bd_v[i].phys = dma_map_single(ndev->dev.parent,
-						     skb->data,
-						     lp->max_frm_size,
-						     DMA_FROM_DEVICE);
 		q->rxq_bd_v[i].cntrl = lp->max_frm_size;
 	}
 
@@ -309,9 +256,12 @@ int __maybe_unused axienet_mcdma_rx_q_init(struct net_device *ndev,
 				q->rx_offset);
 	axienet_dma_out32(q, XMCDMA_CHAN_CR_OFFSET(q->chan_id) + q->rx_offset,
 			  cr | XMCDMA_CR_RUNSTOP_MASK);
-	axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id) +
-			    q->rx_offset, q->rx_bd_p + (sizeof(*q->rxq_bd_v) *
-			    (lp->rx_bd_num - 1)));
+	if (axienet_xsk_umem(q))
+		axienet_xsk_rx_refill(q);
+	else
+		axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id) +
+				  q->rx_offset, q->rx_bd_p +
+				  (sizeof(*q->rxq_bd_v) * (lp->rx_bd_num - 1)));
 	chan_en = axienet_dma_in32(q, XMCDMA_CHEN_OFFSET + q->rx_offset);
 	chan_en |= (1 << (q->chan_id - 1));
 	axienet_dma_out32(q, XMCDMA_CHEN_OFFSET + q->rx_offset, chan_en);
@@ -384,7 +334,10 @@ irqreturn_t __maybe_unused axienet_mcdma_tx_irq(int irq, void *_ndev)
 	status = axienet_dma_in32(q, XMCDMA_CHAN_SR_OFFSET(q->chan_id));
 	if (status & (XMCDMA_IRQ_IOC_MASK | XMCDMA_IRQ_DELAY_MASK)) {
 		axienet_dma_out32(q, XMCDMA_CHAN_SR_OFFSET(q->chan_id), status);
-		axienet_start_xmit_done(lp->ndev, q);
+		cr = axienet_dma_in32(q, XMCDMA_CHAN_CR_OFFSET(q->chan_id));
+		cr &= ~(XMCDMA_IRQ_IOC_MASK | XMCDMA_IRQ_DELAY_MASK);
+		axienet_dma_out32(q, XMCDMA_CHAN_CR_OFFSET(q->chan_id), cr);
+		napi_schedule(&lp->napi_tx[i]);
 		goto out;
 	}
 	if (!(status & XMCDMA_IRQ_ALL_MASK))
@@ -494,40 +447,39 @@ void axienet_strings(struct net_device *ndev, u32 sset, u8 *data)
 {
 	struct axienet_local *lp = netdev_priv(ndev);
 	struct axienet_dma_q *q;
-	int i, j, k = 0;
-
-	for (i = 0, j = 0; i < AXIENET_TX_SSTATS_LEN(lp);) {
-		if (j >= lp->num_tx_queues)
-			break;
-		q = lp->dq[j];
-		if (i % 2 == 0)
-			k = (q->chan_id - 1) * 2;
-		if (sset == ETH_SS_STATS)
-			memcpy(data + i * ETH_GSTRING_LEN,
-			       axienet_get_tx_strings_stats[k].name,
-			       ETH_GSTRING_LEN);
-		++i;
-		k++;
-		if (i % 2 == 0)
-			++j;
+	int i, k;
+
+#ifdef CONFIG_XILINX_TSN_QBR
+	if (sset == ETH_SS_PRIV_FLAGS) {
+		axienet_preemption_strings(ndev, sset, data);
+		return;
 	}
-	k = 0;
-	for (j = 0; i < AXIENET_TX_SSTATS_LEN(lp) +
-			AXIENET_RX_SSTATS_LEN(lp);) {
-		if (j >= lp->num_rx_queues)
-			break;
-		q = lp->dq[j];
-		if (i % 2 == 0)
-			k = (q->chan_id - 1) * 2;
-		if (sset == ETH_SS_STATS)
-			memcpy(data + i * ETH_GSTRING_LEN,
-			       axienet_get_rx_strings_stats[k].name,
-			       ETH_GSTRING_LEN);
-		++i;
-		k++;
-		if (i % 2 == 0)
-			++j;
+#endif
+	if (sset != ETH_SS_STATS)
+		return;
+
+	/* The queues are named after their MCDMA channel */
+	for (i = 0; i < lp->num_tx_queues; i++) {
+		q = lp->dq[i];
+		for (k = 0; k < AXIENET_TX_QSTATS_LEN; k++) {
+			snprintf(data, ETH_GSTRING_LEN, "txq%d_%s",
+				 q->chan_id - 1,
+				 axienet_get_tx_strings_stats[k].name);
+			data += ETH_GSTRING_LEN;
+		}
 	}
+	for (i = 0; i < lp->num_rx_queues; i++) {
+		q = lp->dq[i];
+		for (k = 0; k < AXIENET_RX_QSTATS_LEN; k++) {
+			snprintf(data, ETH_GSTRING_LEN, "rxq%d_%s",
+				 q->chan_id - 1,
+				 axienet_get_rx_strings_stats[k].name);
+			data += ETH_GSTRING_LEN;
+		}
+	}
+#ifdef CONFIG_XILINX_TSN_QBR
+	axienet_preemption_strings(ndev, sset, data);
+#endif
 }
 
 int axienet_sset_count(struct net_device *ndev, int sset)
@@ -536,39 +488,67 @@ int axienet_sset_count(struct net_device *ndev, int sset)
 
 	switch (sset) {
 	case ETH_SS_STATS:
-		return (AXIENET_TX_SSTATS_LEN(lp) + AXIENET_RX_SSTATS_LEN(lp));
+		return (AXIENET_TX_SSTATS_LEN(lp) + AXIENET_RX_SSTATS_LEN(lp)
+#ifdef CONFIG_XILINX_TSN_QBR
+			+ axienet_preemption_sset_count(ndev, sset)
+#endif
+			);
+#ifdef CONFIG_XILINX_TSN_QBR
+	case ETH_SS_PRIV_FLAGS:
+		return axienet_preemption_sset_count(ndev, sset);
+#endif
 	default:
 		return -EOPNOTSUPP;
 	}
 }
 
+/**
+ * axienet_get_stats - Report the per queue counters to ethtool
+ * @ndev:	Pointer to net_device structure
+ * @stats:	Pointer to ethtool_stats structure
+ * @data:	Counter values, in the order of axienet_strings()
+ *
+ * The counters are kept per queue without atomics, reading them only
+ * retries when a 32 bit writer was caught in the middle of an update.
+ */
 void axienet_get_stats(struct net_device *ndev,
 		       struct ethtool_stats *stats,
 		       u64 *data)
 {
 	struct axienet_local *lp = netdev_priv(ndev);
-	struct axienet_dma_q *q;
-	unsigned int i = 0, j;
-
-	for (i = 0, j = 0; i < AXIENET_TX_SSTATS_LEN(lp);) {
-		if (j >= lp->num_tx_queues)
-			break;
+	struct axienet_tx_stats *tx;
+	struct axienet_rx_stats *rx;
+	unsigned int start;
+	int i;
 
-		q = lp->dq[j];
-		data[i++] = q->tx_packets;
-		data[i++] = q->tx_bytes;
-		++j;
+	for (i = 0; i < lp->num_tx_queues; i++) {
+		tx = &lp->dq[i]->tx_stats;
+		do {
+			start = u64_stats_fetch_begin_irq(&tx->syncp);
+			data[0] = tx->packets;
+			data[1] = tx->bytes;
+			data[3] = tx->budget_exhausted;
+		} while (u64_stats_fetch_retry_irq(&tx->syncp, start));
+		do {
+			start = u64_stats_fetch_begin_irq(&tx->xmit_syncp);
+			data[2] = tx->ring_full;
+		} while (u64_stats_fetch_retry_irq(&tx->xmit_syncp, start));
+		data += AXIENET_TX_QSTATS_LEN;
 	}
-	for (j = 0; i < AXIENET_TX_SSTATS_LEN(lp) +
-			AXIENET_RX_SSTATS_LEN(lp);) {
-		if (j >= lp->num_rx_queues)
-			break;
-
-		q = lp->dq[j];
-		data[i++] = q->rx_packets;
-		data[i++] = q->rx_bytes;
-		++j;
+	for (i = 0; i < lp->num_rx_queues; i++) {
+		rx = &lp->dq[i]->rx_stats;
+		do {
+			start = u64_stats_fetch_begin_irq(&rx->syncp);
+			data[0] = rx->packets;
+			data[1] = rx->bytes;
+			data[2] = rx->refill_failures;
+			data[3] = rx->budget_exhausted;
+		} while (u64_stats_fetch_retry_irq(&rx->syncp, start));
+		data += AXIENET_RX_QSTATS_LEN;
 	}
+#ifdef CONFIG_XILINX_TSN_QBR
+	axienet_preemption_stats(ndev, data);
+#endif
 }
 
 /**
@@ -586,6 +566,7 @@ void __maybe_unused axienet_mcdma_err_handler(unsigned long data)
 	struct axienet_local *lp = q->lp;
 	struct net_device *ndev = lp->ndev;
 	struct aximcdma_bd *cur_p;
+	u32 xsk_frames = 0;
 
 	lp->axienet_config->setoptions(ndev, lp->options &
 				       ~(XAE_OPTION_TXEN | XAE_OPTION_RXEN));
@@ -612,15 +593,24 @@ void __maybe_unused axienet_mcdma_err_handler(unsigned long data)
 		mutex_unlock(&lp->mii_bus->mdio_lock);
 	}
 
+	/* Hand the outstanding zero-copy frames back to the AF_XDP socket */
+	for (i = q->tx_bd_ci; i != q->tx_bd_tail; i = (i + 1) % lp->tx_bd_num)
+		if (q->txq_bd_v[i].tx_desc_mapping == DESC_DMA_MAP_XSK)
+			xsk_frames++;
+
 	for (i = 0; i < lp->tx_bd_num; i++) {
 		cur_p = &q->txq_bd_v[i];
-		if (cur_p->phys)
+		if (cur_p->phys &&
+		    cur_p->tx_desc_mapping != DESC_DMA_MAP_NONE &&
+		    cur_p->tx_desc_mapping != DESC_DMA_MAP_XSK)
 			dma_unmap_single(ndev->dev.parent, cur_p->phys,
 					 (cur_p->cntrl &
 					  XAXIDMA_BD_CTRL_LENGTH_MASK),
 					 DMA_TO_DEVICE);
 		if (cur_p->tx_skb)
 			dev_kfree_skb_irq((struct sk_buff *)cur_p->tx_skb);
+		if (cur_p->tx_xdpf)
+			xdp_return_frame((struct xdp_frame *)cur_p->tx_xdpf);
 		cur_p->phys = 0;
 		cur_p->cntrl = 0;
 		cur_p->status = 0;
@@ -631,8 +621,16 @@ void __maybe_unused axienet_mcdma_err_handler(unsigned long data)
 		cur_p->app4 = 0;
 		cur_p->sw_id_offset = 0;
 		cur_p->tx_skb = 0;
+		cur_p->tx_xdpf = 0;
+		cur_p->tx_desc_mapping = DESC_DMA_MAP_SINGLE;
 	}
 
+	if (xsk_frames)
+		xsk_umem_complete_tx(q->xsk_umem, xsk_frames);
+
+	if (axienet_xsk_umem(q))
+		axienet_xsk_rx_ring_free(q);
+
 	for (i = 0; i < lp->rx_bd_num; i++) {
 		cur_p = &q->rxq_bd_v[i];
 		cur_p->status = 0;
@@ -645,7 +643,10 @@ void __maybe_unused axienet_mcdma_err_handler(unsigned long data)
 
 	q->tx_bd_ci = 0;
 	q->tx_bd_tail = 0;
+	q->tx_db_pending = false;
+	netdev_tx_reset_queue(axienet_dma_q_txq(q));
 	q->rx_bd_ci = 0;
+	q->xsk_rx_next = 0;
 
 	/* Start updating the Rx channel control register */
 	cr = axienet_dma_in32(q, XMCDMA_CHAN_CR_OFFSET(q->chan_id) +
@@ -687,9 +688,12 @@ void __maybe_unused axienet_mcdma_err_handler(unsigned long data)
 				q->rx_offset);
 	axienet_dma_out32(q, XMCDMA_CHAN_CR_OFFSET(q->chan_id) + q->rx_offset,
 			  cr | XMCDMA_CR_RUNSTOP_MASK);
-	axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id) +
-			    q->rx_offset, q->rx_bd_p + (sizeof(*q->rxq_bd_v) *
-			    (lp->rx_bd_num - 1)));
+	if (axienet_xsk_umem(q))
+		axienet_xsk_rx_refill(q);
+	else
+		axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id) +
+				  q->rx_offset, q->rx_bd_p +
+				  (sizeof(*q->rxq_bd_v) * (lp->rx_bd_num - 1)));
 	chan_en = axienet_dma_in32(q, XMCDMA_CHEN_OFFSET + q->rx_offset);
 	chan_en |= (1 << (q->chan_id - 1));
 	axienet_dma_out32(q, XMCDMA_CHEN_OFFSET + q->rx_offset, chan_en);
@@ -767,6 +771,9 @@ int __maybe_unused axienet_mcdma_tx_probe(struct platform_device *pdev,
 		q->eth_hasdre = of_property_read_bool(np,
 						      "xlnx,include-dre");
 		spin_lock_init(&q->tx_lock);
+
+		netif_tx_napi_add(lp->ndev, &lp->napi_tx[i], xaxienet_tx_poll,
+				  XAXIENET_NAPI_WEIGHT);
 	}
 	of_node_put(np);
 
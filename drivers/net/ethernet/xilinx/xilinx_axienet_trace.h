@@ -0,0 +1,159 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Xilinx AXI Ethernet fast path tracepoints
+ *
+ * Every event carries the interface, the DMA queue and the index of the
+ * buffer descriptor in the ring of that queue, so the Tx and Rx rings can be
+ * followed BD by BD with ftrace or bpftrace.
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM xilinx_axienet
+
+#if !defined(_XILINX_AXIENET_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _XILINX_AXIENET_TRACE_H
+
+#include <linux/netdevice.h>
+#include <linux/tracepoint.h>
+
+#include "xilinx_axienet.h"
+
+DECLARE_EVENT_CLASS(axienet_bd,
+
+	TP_PROTO(struct axienet_dma_q *q, u32 bd, u32 len),
+
+	TP_ARGS(q, bd, len),
+
+	TP_STRUCT__entry(
+		__string(dev, q->lp->ndev->name)
+		__field(u16, queue)
+		__field(u32, bd)
+		__field(u32, len)
+	),
+
+	TP_fast_assign(
+		__assign_str(dev, q->lp->ndev->name)
+		__entry->queue = q->index;
+		__entry->bd = bd;
+		__entry->len = len;
+	),
+
+	TP_printk("dev=%s queue=%u bd=%u len=%u", __get_str(dev),
+		  __entry->queue, __entry->bd, __entry->len)
+);
+
+/*
+ * A frame of @len bytes was queued from BD @bd on, @used is the number of Tx
+ * BDs owned by the hardware or not reclaimed yet once it is queued.
+ */
+TRACE_EVENT(axienet_xmit,
+
+	TP_PROTO(struct axienet_dma_q *q, u32 bd, u32 len),
+
+	TP_ARGS(q, bd, len),
+
+	TP_STRUCT__entry(
+		__string(dev, q->lp->ndev->name)
+		__field(u16, queue)
+		__field(u32, bd)
+		__field(u32, len)
+		__field(u32, used)
+	),
+
+	TP_fast_assign(
+		__assign_str(dev, q->lp->ndev->name)
+		__entry->queue = q->index;
+		__entry->bd = bd;
+		__entry->len = len;
+		__entry->used = (q->tx_bd_tail + q->lp->tx_bd_num -
+				 READ_ONCE(q->tx_bd_ci)) % q->lp->tx_bd_num;
+	),
+
+	TP_printk("dev=%s queue=%u bd=%u len=%u used=%u", __get_str(dev),
+		  __entry->queue, __entry->bd, __entry->len, __entry->used)
+);
+
+/* The hardware completed a Tx BD of @len bytes */
+DEFINE_EVENT(axienet_bd, axienet_tx_done,
+
+	TP_PROTO(struct axienet_dma_q *q, u32 bd, u32 len),
+
+	TP_ARGS(q, bd, len)
+);
+
+/* A frame of @len bytes was received in a Rx BD */
+DEFINE_EVENT(axienet_bd, axienet_rx,
+
+	TP_PROTO(struct axienet_dma_q *q, u32 bd, u32 len),
+
+	TP_ARGS(q, bd, len)
+);
+
+/* No buffer to refill a Rx BD, its frame of @len bytes waits for a retry */
+DEFINE_EVENT(axienet_bd, axienet_rx_refill_fail,
+
+	TP_PROTO(struct axienet_dma_q *q, u32 bd, u32 len),
+
+	TP_ARGS(q, bd, len)
+);
+
+TRACE_EVENT(axienet_tx_ring_full,
+
+	TP_PROTO(struct axienet_dma_q *q, u32 needed),
+
+	TP_ARGS(q, needed),
+
+	TP_STRUCT__entry(
+		__string(dev, q->lp->ndev->name)
+		__field(u16, queue)
+		__field(u32, ci)
+		__field(u32, tail)
+		__field(u32, needed)
+	),
+
+	TP_fast_assign(
+		__assign_str(dev, q->lp->ndev->name)
+		__entry->queue = q->index;
+		__entry->ci = q->tx_bd_ci;
+		__entry->tail = q->tx_bd_tail;
+		__entry->needed = needed;
+	),
+
+	TP_printk("dev=%s queue=%u ci=%u tail=%u needed=%u", __get_str(dev),
+		  __entry->queue, __entry->ci, __entry->tail, __entry->needed)
+);
+
+TRACE_EVENT(axienet_rx_poll,
+
+	TP_PROTO(struct axienet_dma_q *q, int work_done, int quota),
+
+	TP_ARGS(q, work_done, quota),
+
+	TP_STRUCT__entry(
+		__string(dev, q->lp->ndev->name)
+		__field(u16, queue)
+		__field(u32, ci)
+		__field(int, work_done)
+		__field(int, quota)
+	),
+
+	TP_fast_assign(
+		__assign_str(dev, q->lp->ndev->name)
+		__entry->queue = q->index;
+		__entry->ci = q->rx_bd_ci;
+		__entry->work_done = work_done;
+		__entry->quota = quota;
+	),
+
+	TP_printk("dev=%s queue=%u ci=%u work_done=%d quota=%d",
+		  __get_str(dev), __entry->queue, __entry->ci,
+		  __entry->work_done, __entry->quota)
+);
+
+#endif /* _XILINX_AXIENET_TRACE_H */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE xilinx_axienet_trace
+#include <trace/define_trace.h>
@@ -0,0 +1,398 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/* Xilinx AXI Ethernet (AF_XDP zero-copy on MCDMA channels)
+ *
+ * Copyright (C) 2018 Xilinx, Inc. All rights reserved.
+ *
+ * This file contains the helper functions which let an AF_XDP UMEM back the
+ * Rx and Tx descriptor rings of an individual AXI MCDMA channel.
+ */
+
+#include <linux/bpf_trace.h>
+#include <linux/etherdevice.h>
+#include <linux/filter.h>
+#include <net/xdp_sock.h>
+
+#include "xilinx_axienet.h"
+
+#define XAE_XSK_DMA_ATTR	DMA_ATTR_SKIP_CPU_SYNC
+
+/**
+ * axienet_xsk_umem_dma_map - DMA map the pages of a UMEM
+ * @lp:		Pointer to axienet local structure
+ * @umem:	UMEM to be mapped
+ *
+ * Return: 0, on success -ENOMEM, on failure
+ */
+int axienet_xsk_umem_dma_map(struct axienet_local *lp, struct xdp_umem *umem)
+{
+	struct device *dev = lp->ndev->dev.parent;
+	unsigned int i, j;
+	dma_addr_t dma;
+
+	for (i = 0; i < umem->npgs; i++) {
+		dma = dma_map_page_attrs(dev, umem->pgs[i], 0, PAGE_SIZE,
+					 DMA_BIDIRECTIONAL, XAE_XSK_DMA_ATTR);
+		if (dma_mapping_error(dev, dma))
+			goto out_unmap;
+
+		umem->pages[i].dma = dma;
+	}
+
+	return 0;
+
+out_unmap:
+	for (j = 0; j < i; j++) {
+		dma_unmap_page_attrs(dev, umem->pages[j].dma, PAGE_SIZE,
+				     DMA_BIDIRECTIONAL, XAE_XSK_DMA_ATTR);
+		umem->pages[j].dma = 0;
+	}
+
+	return -ENOMEM;
+}
+
+/**
+ * axienet_xsk_umem_dma_unmap - DMA unmap the pages of a UMEM
+ * @lp:		Pointer to axienet local structure
+ * @umem:	UMEM to be unmapped
+ */
+void axienet_xsk_umem_dma_unmap(struct axienet_local *lp,
+				struct xdp_umem *umem)
+{
+	struct device *dev = lp->ndev->dev.parent;
+	unsigned int i;
+
+	for (i = 0; i < umem->npgs; i++) {
+		dma_unmap_page_attrs(dev, umem->pages[i].dma, PAGE_SIZE,
+				     DMA_BIDIRECTIONAL, XAE_XSK_DMA_ATTR);
+		umem->pages[i].dma = 0;
+	}
+}
+
+/**
+ * axienet_xsk_zca_free - Return a UMEM Rx buffer dropped by XDP
+ * @zca:	Zero-copy allocator of the DMA queue
+ * @handle:	UMEM handle of the buffer
+ *
+ * The buffer is put on the UMEM reuse queue, which is drained first by
+ * axienet_xsk_rx_refill().
+ */
+void axienet_xsk_zca_free(struct zero_copy_allocator *zca,
+			  unsigned long handle)
+{
+	struct axienet_dma_q *q = container_of(zca, struct axienet_dma_q, zca);
+
+	xsk_umem_fq_reuse(q->xsk_umem, handle & q->xsk_umem->chunk_mask);
+}
+
+/**
+ * axienet_xsk_rx_refill - Refill the Rx BDs from the UMEM fill queue
+ * @q:		Pointer to DMA queue structure
+ *
+ * Unlike the page pool rings the UMEM may not provide a buffer for every
+ * BD, so only the BDs holding a buffer are handed to the DMA by advancing
+ * the tail descriptor behind the last refilled one.
+ */
+void axienet_xsk_rx_refill(struct axienet_dma_q *q)
+{
+	struct axienet_local *lp = q->lp;
+	struct device *dev = lp->ndev->dev.parent;
+	struct xdp_umem *umem = q->xsk_umem;
+	struct aximcdma_bd *cur_p;
+	dma_addr_t addr, tail_p;
+	u32 count = 0;
+	u64 handle;
+
+	while (q->xsk_rx_count < lp->rx_bd_num) {
+		if (!xsk_umem_peek_addr_rq(umem, &handle))
+			break;
+
+		handle &= umem->chunk_mask;
+		addr = xdp_umem_get_dma(umem, handle) + umem->headroom +
+		       XDP_PACKET_HEADROOM;
+		/* Userspace may have left dirty lines in the frame */
+		dma_sync_single_for_device(dev, addr, lp->max_frm_size,
+					   DMA_BIDIRECTIONAL);
+
+		cur_p = &q->rxq_bd_v[q->xsk_rx_next];
+		cur_p->phys = addr;
+		cur_p->cntrl = lp->max_frm_size;
+		cur_p->status = 0;
+		cur_p->sw_id_offset = xsk_umem_adjust_offset(umem, handle,
+							     umem->headroom);
+		xsk_umem_discard_addr_rq(umem);
+
+		if (++q->xsk_rx_next >= lp->rx_bd_num)
+			q->xsk_rx_next = 0;
+		q->xsk_rx_count++;
+		count++;
+	}
+
+	if (xsk_umem_uses_need_wakeup(umem)) {
+		if (q->xsk_rx_count < lp->rx_bd_num)
+			xsk_set_rx_need_wakeup(umem);
+		else
+			xsk_clear_rx_need_wakeup(umem);
+	}
+
+	if (!count)
+		return;
+
+	tail_p = q->rx_bd_p + sizeof(*q->rxq_bd_v) *
+		 (q->xsk_rx_next ? q->xsk_rx_next - 1 : lp->rx_bd_num - 1);
+
+	/* Ensure BD write before handing them to the DMA */
+	wmb();
+	axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id) +
+			  q->rx_offset, tail_p);
+}
+
+/**
+ * axienet_xsk_rx_ring_free - Give the UMEM Rx buffers of the BDs back
+ * @q:		Pointer to DMA queue structure
+ *
+ * The DMA must be stopped. The buffers are put on the UMEM reuse queue so
+ * that they are used again when the ring is refilled.
+ */
+void axienet_xsk_rx_ring_free(struct axienet_dma_q *q)
+{
+	struct axienet_local *lp = q->lp;
+	u32 i = q->rx_bd_ci;
+
+	while (q->xsk_rx_count) {
+		xsk_umem_fq_reuse(q->xsk_umem, q->rxq_bd_v[i].sw_id_offset);
+		q->rxq_bd_v[i].sw_id_offset = 0;
+		if (++i >= lp->rx_bd_num)
+			i = 0;
+		q->xsk_rx_count--;
+	}
+
+	q->xsk_rx_next = q->rx_bd_ci;
+}
+
+/**
+ * axienet_xsk_construct_skb - Copy a zero-copy frame passed by XDP to an skb
+ * @q:		Pointer to DMA queue structure
+ * @xdp:	XDP buffer describing the frame
+ *
+ * Return: skb to hand to the stack, NULL on allocation failure
+ */
+static struct sk_buff *axienet_xsk_construct_skb(struct axienet_dma_q *q,
+						 struct xdp_buff *xdp)
+{
+	unsigned int len = xdp->data_end - xdp->data;
+	struct sk_buff *skb;
+
+	skb = netdev_alloc_skb(q->lp->ndev, len);
+	if (!skb)
+		return NULL;
+
+	skb_put_data(skb, xdp->data, len);
+
+	return skb;
+}
+
+/**
+ * axienet_xsk_recv - Process the Rx BDs of a zero-copy DMA queue
+ * @ndev:	Pointer to net_device structure.
+ * @budget:	NAPI budget
+ * @q:		Pointer to axienet DMA queue structure
+ *
+ * Every frame is handed to the attached XDP program. Frames redirected to
+ * the AF_XDP socket stay in the UMEM, XDP_PASS frames are copied to an skb
+ * and do not carry any offload information.
+ *
+ * Return: Number of BD's processed.
+ */
+int axienet_xsk_recv(struct net_device *ndev, int budget,
+		     struct axienet_dma_q *q)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	struct bpf_prog *xdp_prog = READ_ONCE(lp->xdp_prog);
+	struct xdp_umem *umem = q->xsk_umem;
+	struct aximcdma_bd *cur_p;
+	struct axienet_dma_q *txq;
+	struct sk_buff *skb;
+	struct xdp_buff xdp;
+	unsigned long flags;
+	u32 length, act;
+	u32 xdp_act = 0;
+	u32 size = 0;
+	u32 packets = 0;
+	int numbdfree = 0;
+
+	xdp.rxq = &q->xdp_rxq;
+
+	/* Get relevat BD status value */
+	rmb();
+	cur_p = &q->rxq_bd_v[q->rx_bd_ci];
+
+	while ((numbdfree < budget) && q->xsk_rx_count &&
+	       (cur_p->status & XAXIDMA_BD_STS_COMPLETE_MASK)) {
+		if (lp->eth_hasnobuf ||
+		    (lp->axienet_config->mactype != XAXIENET_1G))
+			length = cur_p->status & XAXIDMA_BD_STS_ACTUAL_LEN_MASK;
+		else
+			length = cur_p->app4 & 0x0000FFFF;
+
+		dma_sync_single_for_cpu(ndev->dev.parent, cur_p->phys, length,
+					DMA_BIDIRECTIONAL);
+
+		xdp.handle = cur_p->sw_id_offset;
+		xdp.data = xdp_umem_get_data(umem, xdp.handle) +
+			   XDP_PACKET_HEADROOM;
+		xdp.data_hard_start = xdp.data - XDP_PACKET_HEADROOM;
+		xdp_set_data_meta_invalid(&xdp);
+		xdp.data_end = xdp.data + length;
+
+		act = axienet_run_xdp(q, xdp_prog, &xdp);
+		xdp_act |= act;
+		if (act == XAE_XDP_PASS) {
+			skb = axienet_xsk_construct_skb(q, &xdp);
+			xdp_return_buff(&xdp);
+			if (skb) {
+				skb->protocol = eth_type_trans(skb, ndev);
+				skb->ip_summed = CHECKSUM_NONE;
+				netif_receive_skb(skb);
+			} else {
+				ndev->stats.rx_dropped++;
+			}
+		}
+
+		size += length;
+		packets++;
+
+		cur_p->status = 0;
+		cur_p->sw_id_offset = 0;
+
+		if (++q->rx_bd_ci >= lp->rx_bd_num)
+			q->rx_bd_ci = 0;
+		q->xsk_rx_count--;
+
+		/* Get relevat BD status value */
+		rmb();
+		cur_p = &q->rxq_bd_v[q->rx_bd_ci];
+		numbdfree++;
+	}
+
+	u64_stats_update_begin(&q->rx_stats.syncp);
+	q->rx_stats.packets += packets;
+	q->rx_stats.bytes += size;
+	u64_stats_update_end(&q->rx_stats.syncp);
+
+	if (xdp_act & XAE_XDP_REDIR)
+		xdp_do_flush_map();
+
+	if (xdp_act & XAE_XDP_TX) {
+		txq = axienet_xdp_txq(lp, q->xdp_rxq.queue_index);
+		spin_lock_irqsave(&txq->tx_lock, flags);
+		axienet_xdp_ring_tx_db(txq);
+		spin_unlock_irqrestore(&txq->tx_lock, flags);
+	}
+
+	axienet_xsk_rx_refill(q);
+
+	return numbdfree;
+}
+
+/**
+ * axienet_xsk_xmit - Queue the frames of the AF_XDP Tx ring on a DMA queue
+ * @q:		Pointer to DMA queue structure
+ * @budget:	Max number of frames to queue
+ *
+ * Return: true if the budget was not exhausted
+ */
+bool axienet_xsk_xmit(struct axienet_dma_q *q, unsigned int budget)
+{
+	struct axienet_local *lp = q->lp;
+	struct device *dev = lp->ndev->dev.parent;
+	struct xdp_umem *umem = q->xsk_umem;
+	struct aximcdma_bd *cur_p;
+	struct xdp_desc desc;
+	unsigned int sent = 0;
+	unsigned long flags;
+	dma_addr_t dma;
+	u32 len;
+
+	spin_lock_irqsave(&q->tx_lock, flags);
+	while (sent < budget) {
+		/* A full ring is restarted by the Tx completion interrupt */
+		if (axienet_check_tx_bd_space(q, 0) ||
+		    !xsk_umem_consume_tx(umem, &desc))
+			break;
+
+		len = desc.len;
+		/* The XXV MAC does not pad short frames, send the minimum
+		 * length out of the UMEM chunk instead.
+		 */
+		if ((lp->axienet_config->mactype == XAXIENET_10G_25G ||
+		     lp->axienet_config->mactype == XAXIENET_MRMAC) &&
+		    len < ETH_ZLEN)
+			len = ETH_ZLEN;
+
+		cur_p = &q->txq_bd_v[q->tx_bd_tail];
+		dma = xdp_umem_get_dma(umem, desc.addr);
+		if (!q->eth_hasdre && (dma & 0x3)) {
+			memcpy(q->tx_buf[q->tx_bd_tail],
+			       xdp_umem_get_data(umem, desc.addr), len);
+			cur_p->phys = q->tx_bufs_dma +
+				      (q->tx_buf[q->tx_bd_tail] - q->tx_bufs);
+		} else {
+			dma_sync_single_for_device(dev, dma, len,
+						   DMA_BIDIRECTIONAL);
+			cur_p->phys = dma;
+		}
+
+		cur_p->cntrl = len | XMCDMA_BD_CTRL_TXSOF_MASK |
+			       XMCDMA_BD_CTRL_TXEOF_MASK;
+		cur_p->app0 = 0;
+		cur_p->app1 = 0;
+		cur_p->tx_skb = 0;
+		cur_p->tx_xdpf = 0;
+		cur_p->tx_desc_mapping = DESC_DMA_MAP_XSK;
+
+		if (++q->tx_bd_tail >= lp->tx_bd_num)
+			q->tx_bd_tail = 0;
+		sent++;
+	}
+
+	if (sent) {
+		axienet_xdp_ring_tx_db(q);
+		xsk_umem_consume_tx_done(umem);
+	}
+	spin_unlock_irqrestore(&q->tx_lock, flags);
+
+	return sent < budget;
+}
+
+/**
+ * axienet_xsk_wakeup - ndo_xsk_wakeup handler
+ * @ndev:	Pointer to net_device structure
+ * @qid:	DMA queue the AF_XDP socket is bound to
+ * @flags:	XDP_WAKEUP_* flags
+ *
+ * Return: 0, on success
+ *	    Non-zero error value on failure
+ */
+int axienet_xsk_wakeup(struct net_device *ndev, u32 qid, u32 flags)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+
+	if (!netif_running(ndev))
+		return -ENETDOWN;
+
+	if (qid >= lp->num_rx_queues || qid >= lp->num_tx_queues)
+		return -ENXIO;
+
+	if (!axienet_xsk_umem(lp->dq[qid]))
+		return -ENXIO;
+
+	local_bh_disable();
+	if (flags & XDP_WAKEUP_RX)
+		napi_schedule(&lp->napi[qid]);
+	if (flags & XDP_WAKEUP_TX)
+		napi_schedule(&lp->napi_tx[qid]);
+	local_bh_enable();
+
+	return 0;
+}
@@ -91,6 +91,7 @@
 #define XEL_HEADER_IP_LENGTH_OFFSET	16	/* IP Length Offset */
 
 #define TX_TIMEOUT		(60 * HZ)	/* Tx timeout is 60 seconds. */
+#define XEL_NAPI_WEIGHT		NAPI_POLL_WEIGHT
 #define ALIGNMENT		4
 
 /* BUFFER_ALIGN(adr) calculates the number of bytes to the next alignment. */
@@ -112,9 +113,10 @@
  * @next_tx_buf_to_use:	next Tx buffer to write to
  * @next_rx_buf_to_use:	next Rx buffer to read from
  * @base_addr:		base address of the Emaclite device
- * @reset_lock:		lock to serialize xmit and tx_timeout execution
+ * @reset_lock:		lock to serialize xmit, tx_timeout and Tx completion
  * @deferred_skb:	holds an skb (for transmission at a later time) when the
  *			Tx buffer is not free
+ * @napi:		NAPI context, polls the Rx and Tx completion
  * @phy_dev:		pointer to the PHY device
  * @phy_node:		pointer to the PHY device node
  * @mii_bus:		pointer to the MII bus
@@ -131,6 +133,7 @@ struct net_local {
 
 	spinlock_t reset_lock; /* serialize xmit and tx_timeout execution */
 	struct sk_buff *deferred_skb;
+	struct napi_struct napi;
 
 	struct phy_device *phy_dev;
 	struct device_node *phy_node;
@@ -550,22 +553,24 @@ static void xemaclite_tx_timeout(struct net_device *dev)
 	spin_unlock_irqrestore(&lp->reset_lock, flags);
 }
 
-/**********************/
-/* Interrupt Handlers */
-/**********************/
+/*****************************/
+/* Interrupt and NAPI poll   */
+/*****************************/
 
 /**
- * xemaclite_tx_handler - Interrupt handler for frames sent
+ * xemaclite_tx_handler - Handle the frames sent
  * @dev:	Pointer to the network device
+ * @sent:	Number of Tx buffers that completed
  *
  * This function updates the number of packets transmitted and handles the
- * deferred skb, if there is one.
+ * deferred skb, if there is one. Called from the NAPI poll with the
+ * reset_lock held.
  */
-static void xemaclite_tx_handler(struct net_device *dev)
+static void xemaclite_tx_handler(struct net_device *dev, unsigned int sent)
 {
 	struct net_local *lp = netdev_priv(dev);
 
-	dev->stats.tx_packets++;
+	dev->stats.tx_packets += sent;
 
 	if (!lp->deferred_skb)
 		return;
@@ -575,18 +580,103 @@ static void xemaclite_tx_handler(struct net_device *dev)
 		return;
 
 	dev->stats.tx_bytes += lp->deferred_skb->len;
-	dev_consume_skb_irq(lp->deferred_skb);
+	dev_consume_skb_any(lp->deferred_skb);
 	lp->deferred_skb = NULL;
 	netif_trans_update(dev); /* prevent tx timeout */
 	netif_wake_queue(dev);
 }
 
 /**
- * xemaclite_rx_handler- Interrupt handler for frames received
+ * xemaclite_tx_buf_done - Acknowledge the completion of a Tx buffer
+ * @addr:	Address of the Tx buffer status register
+ *
+ * Return:	true if the buffer held a frame that has now been sent
+ */
+static bool xemaclite_tx_buf_done(void __iomem *addr)
+{
+	u32 tx_status = xemaclite_readl(addr);
+
+	if (((tx_status & XEL_TSR_XMIT_BUSY_MASK) == 0) &&
+	    (tx_status & XEL_TSR_XMIT_ACTIVE_MASK) != 0) {
+		tx_status &= ~XEL_TSR_XMIT_ACTIVE_MASK;
+		xemaclite_writel(tx_status, addr);
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * xemaclite_tx_complete - Reclaim the sent Tx buffers
+ * @dev:	Pointer to the network device
+ */
+static void xemaclite_tx_complete(struct net_device *dev)
+{
+	struct net_local *lp = netdev_priv(dev);
+	void __iomem *base_addr = lp->base_addr;
+	unsigned int sent = 0;
+	unsigned long flags;
+
+	spin_lock_irqsave(&lp->reset_lock, flags);
+
+	/* Check if the Transmission for the first buffer is completed */
+	if (xemaclite_tx_buf_done(base_addr + XEL_TSR_OFFSET))
+		sent++;
+
+	/* Check if the Transmission for the second buffer is completed */
+	if (xemaclite_tx_buf_done(base_addr + XEL_BUFFER_OFFSET +
+				  XEL_TSR_OFFSET))
+		sent++;
+
+	if (sent)
+		xemaclite_tx_handler(dev, sent);
+
+	spin_unlock_irqrestore(&lp->reset_lock, flags);
+}
+
+/**
+ * xemaclite_rx_pending - Check whether a received frame is waiting
+ * @lp:		Pointer to the Emaclite device private data
+ *
+ * Return:	true if one of the Rx buffers holds a frame
+ */
+static bool xemaclite_rx_pending(struct net_local *lp)
+{
+	void __iomem *base_addr = lp->base_addr;
+
+	return (xemaclite_readl(base_addr + XEL_RSR_OFFSET) &
+		XEL_RSR_RECV_DONE_MASK) ||
+	       (xemaclite_readl(base_addr + XEL_BUFFER_OFFSET +
+				XEL_RSR_OFFSET) & XEL_RSR_RECV_DONE_MASK);
+}
+
+/**
+ * xemaclite_tx_pending - Check whether a Tx buffer completion is waiting
+ * @lp:		Pointer to the Emaclite device private data
+ *
+ * Return:	true if one of the Tx buffers was sent but not reclaimed
+ */
+static bool xemaclite_tx_pending(struct net_local *lp)
+{
+	void __iomem *base_addr = lp->base_addr;
+	u32 first, second;
+
+	first = xemaclite_readl(base_addr + XEL_TSR_OFFSET);
+	second = xemaclite_readl(base_addr + XEL_BUFFER_OFFSET +
+				 XEL_TSR_OFFSET);
+
+	return ((first & (XEL_TSR_XMIT_BUSY_MASK | XEL_TSR_XMIT_ACTIVE_MASK)) ==
+		XEL_TSR_XMIT_ACTIVE_MASK) ||
+	       ((second & (XEL_TSR_XMIT_BUSY_MASK | XEL_TSR_XMIT_ACTIVE_MASK)) ==
+		XEL_TSR_XMIT_ACTIVE_MASK);
+}
+
+/**
+ * xemaclite_rx_handler - Handle a received frame
  * @dev:	Pointer to the network device
  *
  * This function allocates memory for a socket buffer, fills it with data
- * received and hands it over to the TCP/IP stack.
+ * received and hands it over to the TCP/IP stack. Called from the NAPI poll.
  */
 static void xemaclite_rx_handler(struct net_device *dev)
 {
@@ -619,7 +709,7 @@ static void xemaclite_rx_handler(struct net_device *dev)
 
 	if (!len) {
 		dev->stats.rx_errors++;
-		dev_kfree_skb_irq(skb);
+		dev_kfree_skb(skb);
 		return;
 	}
 
@@ -632,59 +722,66 @@ static void xemaclite_rx_handler(struct net_device *dev)
 	dev->stats.rx_bytes += len;
 
 	if (!skb_defer_rx_timestamp(skb))
-		netif_rx(skb);	/* Send the packet upstream */
+		napi_gro_receive(&lp->napi, skb); /* Send the packet upstream */
 }
 
 /**
- * xemaclite_interrupt - Interrupt handler for this driver
- * @irq:	Irq of the Emaclite device
- * @dev_id:	Void pointer to the network device instance used as callback
- *		reference
+ * xemaclite_poll - NAPI poll handler
+ * @napi:	Pointer to the NAPI context
+ * @budget:	Maximum number of frames to receive
  *
- * Return:	IRQ_HANDLED
+ * Reclaims the sent Tx buffers and receives up to @budget frames. The
+ * device interrupt stays masked until both are drained, so a busy link
+ * costs one interrupt per poll instead of one per frame.
  *
- * This function handles the Tx and Rx interrupts of the EmacLite device.
+ * Return:	Number of frames received
  */
-static irqreturn_t xemaclite_interrupt(int irq, void *dev_id)
+static int xemaclite_poll(struct napi_struct *napi, int budget)
 {
-	bool tx_complete = false;
-	struct net_device *dev = dev_id;
-	struct net_local *lp = netdev_priv(dev);
-	void __iomem *base_addr = lp->base_addr;
-	u32 tx_status;
+	struct net_local *lp = container_of(napi, struct net_local, napi);
+	struct net_device *dev = lp->ndev;
+	int work_done = 0;
 
-	/* Check if there is Rx Data available */
-	if ((xemaclite_readl(base_addr + XEL_RSR_OFFSET) &
-			 XEL_RSR_RECV_DONE_MASK) ||
-	    (xemaclite_readl(base_addr + XEL_BUFFER_OFFSET + XEL_RSR_OFFSET)
-			 & XEL_RSR_RECV_DONE_MASK))
+	xemaclite_tx_complete(dev);
 
+	while (work_done < budget && xemaclite_rx_pending(lp)) {
 		xemaclite_rx_handler(dev);
+		work_done++;
+	}
 
-	/* Check if the Transmission for the first buffer is completed */
-	tx_status = xemaclite_readl(base_addr + XEL_TSR_OFFSET);
-	if (((tx_status & XEL_TSR_XMIT_BUSY_MASK) == 0) &&
-	    (tx_status & XEL_TSR_XMIT_ACTIVE_MASK) != 0) {
-		tx_status &= ~XEL_TSR_XMIT_ACTIVE_MASK;
-		xemaclite_writel(tx_status, base_addr + XEL_TSR_OFFSET);
+	if (work_done < budget && napi_complete_done(napi, work_done)) {
+		xemaclite_writel(XEL_GIER_GIE_MASK,
+				 lp->base_addr + XEL_GIER_OFFSET);
 
-		tx_complete = true;
+		/* Events that came in while the interrupt was masked may not
+		 * raise a new one
+		 */
+		if (xemaclite_rx_pending(lp) || xemaclite_tx_pending(lp))
+			napi_schedule(napi);
 	}
 
-	/* Check if the Transmission for the second buffer is completed */
-	tx_status = xemaclite_readl(base_addr + XEL_BUFFER_OFFSET + XEL_TSR_OFFSET);
-	if (((tx_status & XEL_TSR_XMIT_BUSY_MASK) == 0) &&
-	    (tx_status & XEL_TSR_XMIT_ACTIVE_MASK) != 0) {
-		tx_status &= ~XEL_TSR_XMIT_ACTIVE_MASK;
-		xemaclite_writel(tx_status, base_addr + XEL_BUFFER_OFFSET +
-				 XEL_TSR_OFFSET);
+	return work_done;
+}
 
-		tx_complete = true;
-	}
+/**
+ * xemaclite_interrupt - Interrupt handler for this driver
+ * @irq:	Irq of the Emaclite device
+ * @dev_id:	Void pointer to the network device instance used as callback
+ *		reference
+ *
+ * Return:	IRQ_HANDLED
+ *
+ * This function masks the EmacLite interrupt and defers the Tx and Rx
+ * handling to the NAPI poll.
+ */
+static irqreturn_t xemaclite_interrupt(int irq, void *dev_id)
+{
+	struct net_device *dev = dev_id;
+	struct net_local *lp = netdev_priv(dev);
 
-	/* If there was a Tx interrupt, call the Tx Handler */
-	if (tx_complete != 0)
-		xemaclite_tx_handler(dev);
+	/* Mask the device until the poll has drained it */
+	xemaclite_writel(0, lp->base_addr + XEL_GIER_OFFSET);
+	napi_schedule(&lp->napi);
 
 	return IRQ_HANDLED;
 }
@@ -975,6 +1072,7 @@ static int xemaclite_open(struct net_device *dev)
 	}
 
 	/* Enable Interrupts */
+	napi_enable(&lp->napi);
 	xemaclite_enable_interrupts(lp);
 
 	/* We're ready to go */
@@ -1000,6 +1098,12 @@ static int xemaclite_close(struct net_device *dev)
 	netif_stop_queue(dev);
 	xemaclite_disable_interrupts(lp);
 	free_irq(dev->irq, dev);
+	napi_disable(&lp->napi);
+
+	if (lp->deferred_skb) {
+		dev_kfree_skb(lp->deferred_skb);
+		lp->deferred_skb = NULL;
+	}
 
 	if (lp->phy_dev)
 		phy_disconnect(lp->phy_dev);
@@ -1189,6 +1293,7 @@ static int xemaclite_of_probe(struct platform_device *ofdev)
 	ndev->ethtool_ops = &xemaclite_ethtool_ops;
 	ndev->flags &= ~IFF_MULTICAST;
 	ndev->watchdog_timeo = TX_TIMEOUT;
+	netif_napi_add(ndev, &lp->napi, xemaclite_poll, XEL_NAPI_WEIGHT);
 
 	/* Finally, register the device */
 	rc = register_netdev(ndev);
@@ -1233,6 +1338,7 @@ static int xemaclite_of_remove(struct platform_device *of_dev)
 	}
 
 	unregister_netdev(ndev);
+	netif_napi_del(&lp->napi);
 
 	of_node_put(lp->phy_node);
 	lp->phy_node = NULL;
@@ -14,6 +14,10 @@
  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
  * GNU General Public License for more details.
  */
+#include <linux/etherdevice.h>
+#include <linux/rtnetlink.h>
+#include <net/genetlink.h>
+#include <uapi/linux/xlnx-tsn-frer.h>
 #include "xilinx_tsn_switch.h"
 
 #define IN_PORTID_MASK				0x3
@@ -37,6 +41,38 @@
 #define WR_OP_TYPE_MASK				0x3
 #define FRER_EN_CONTROL_MASK			0x1
 
+/* FRER control write operations */
+#define FRER_WR_OP_INGRESS			0x0
+#define FRER_WR_OP_MEMBER			0x1
+#define FRER_OP_WRITE				1
+
+/* One stream handle for each gate ID */
+#define FRER_MAX_STREAMS			256
+
+/**
+ * struct frer_stream - Stream handle programmed through generic netlink
+ * @valid:	The handle is in use
+ * @cam:	The stream is identified in the switch CAM by @addr and @vid
+ * @ctrl:	FRER control of the handle
+ * @in_fltr:	Ingress filter of the handle
+ * @memb:	Member stream configuration of the handle
+ * @addr:	Destination MAC address identifying the stream
+ * @vid:	VLAN ID identifying the stream
+ */
+struct frer_stream {
+	bool valid;
+	bool cam;
+	struct frer_ctrl ctrl;
+	struct in_fltr in_fltr;
+	struct frer_memb_config memb;
+	u8 addr[ETH_ALEN];
+	u16 vid;
+};
+
+/* protected by rtnl, the switch CAM helpers need it anyway */
+static struct frer_stream frer_streams[FRER_MAX_STREAMS];
+static struct genl_family frer_genl_family;
+
 /**
  * frer_control - Configure thr control for frer
  * @data:	Value to be programmed
@@ -175,3 +211,333 @@ void get_frer_static_counter(struct frer_static_counter *data)
 	data->seq_recv_rst.msb = axienet_ior(&lp,
 					     SEQ_RECV_RESETS_OFFSET + offset + 0x4);
 }
+
+static void frer_stream_write(struct frer_stream *st)
+{
+	struct frer_ctrl ctrl = st->ctrl;
+
+	config_ingress_filter(st->in_fltr);
+	ctrl.wr_op_type = FRER_WR_OP_INGRESS;
+	frer_control(ctrl);
+
+	program_member_reg(st->memb);
+	ctrl.wr_op_type = FRER_WR_OP_MEMBER;
+	frer_control(ctrl);
+}
+
+static int frer_stream_set(struct sk_buff *skb, struct genl_info *info)
+{
+	struct nlattr **tb = info->attrs;
+	struct frer_stream new = {};
+	struct frer_stream *st;
+	u8 handle;
+	int ret;
+
+	if (!tb[XLNX_TSN_FRER_A_HANDLE]) {
+		GENL_SET_ERR_MSG(info, "A stream handle is required");
+		return -EINVAL;
+	}
+	handle = nla_get_u8(tb[XLNX_TSN_FRER_A_HANDLE]);
+
+	new.valid = true;
+	new.ctrl.gate_id = handle;
+	new.ctrl.gate_state = true;
+	new.ctrl.frer_valid = true;
+	new.ctrl.op_type = FRER_OP_WRITE;
+	new.ctrl.rcvry_tmout =
+		nla_get_flag(tb[XLNX_TSN_FRER_A_RECOVERY_TIMEOUT]);
+	if (tb[XLNX_TSN_FRER_A_MEMBER])
+		new.ctrl.memb_id = nla_get_u8(tb[XLNX_TSN_FRER_A_MEMBER]);
+	if (tb[XLNX_TSN_FRER_A_IN_PORT])
+		new.in_fltr.in_port_id =
+			nla_get_u8(tb[XLNX_TSN_FRER_A_IN_PORT]);
+	if (tb[XLNX_TSN_FRER_A_MAX_SEQ_ID])
+		new.in_fltr.max_seq_id =
+			nla_get_u16(tb[XLNX_TSN_FRER_A_MAX_SEQ_ID]);
+	if (tb[XLNX_TSN_FRER_A_HIST_LEN])
+		new.memb.seq_rec_hist_len =
+			nla_get_u8(tb[XLNX_TSN_FRER_A_HIST_LEN]);
+	if (tb[XLNX_TSN_FRER_A_RESET_TICKS])
+		new.memb.rem_ticks =
+			nla_get_u32(tb[XLNX_TSN_FRER_A_RESET_TICKS]);
+	if (tb[XLNX_TSN_FRER_A_SPLIT_PORT])
+		new.memb.split_strm_egport_id =
+			nla_get_u8(tb[XLNX_TSN_FRER_A_SPLIT_PORT]);
+	if (tb[XLNX_TSN_FRER_A_SPLIT_VID])
+		new.memb.split_strm_vlan_id =
+			nla_get_u16(tb[XLNX_TSN_FRER_A_SPLIT_VID]);
+	if (tb[XLNX_TSN_FRER_A_DST_ADDR]) {
+		new.cam = true;
+		nla_memcpy(new.addr, tb[XLNX_TSN_FRER_A_DST_ADDR], ETH_ALEN);
+		if (tb[XLNX_TSN_FRER_A_VID])
+			new.vid = nla_get_u16(tb[XLNX_TSN_FRER_A_VID]);
+	}
+
+	rtnl_lock();
+	st = &frer_streams[handle];
+
+	if (st->cam && (!new.cam || !ether_addr_equal(st->addr, new.addr) ||
+			st->vid != new.vid)) {
+		tsn_switch_stream_del(st->addr, st->vid);
+		st->cam = false;
+	}
+	if (new.cam && !st->cam) {
+		ret = tsn_switch_stream_add(new.addr, new.vid, handle);
+		if (ret) {
+			GENL_SET_ERR_MSG(info, "The stream already has a gate");
+			goto out;
+		}
+	}
+
+	frer_stream_write(&new);
+	*st = new;
+	ret = 0;
+out:
+	rtnl_unlock();
+	return ret;
+}
+
+static int frer_stream_get_handle(struct genl_info *info,
+				  struct frer_stream **st)
+{
+	u8 handle;
+
+	if (!info->attrs[XLNX_TSN_FRER_A_HANDLE]) {
+		GENL_SET_ERR_MSG(info, "A stream handle is required");
+		return -EINVAL;
+	}
+	handle = nla_get_u8(info->attrs[XLNX_TSN_FRER_A_HANDLE]);
+
+	*st = &frer_streams[handle];
+	if (!(*st)->valid) {
+		GENL_SET_ERR_MSG(info, "The stream handle is not configured");
+		return -ENOENT;
+	}
+
+	return 0;
+}
+
+static int frer_stream_del(struct sk_buff *skb, struct genl_info *info)
+{
+	struct frer_stream *st;
+	struct frer_ctrl ctrl;
+	int ret;
+
+	rtnl_lock();
+	ret = frer_stream_get_handle(info, &st);
+	if (ret)
+		goto out;
+
+	if (st->cam)
+		tsn_switch_stream_del(st->addr, st->vid);
+
+	ctrl = st->ctrl;
+	ctrl.gate_state = false;
+	ctrl.frer_valid = false;
+	ctrl.wr_op_type = FRER_WR_OP_MEMBER;
+	frer_control(ctrl);
+
+	memset(st, 0, sizeof(*st));
+out:
+	rtnl_unlock();
+	return ret;
+}
+
+static int frer_stream_reset(struct sk_buff *skb, struct genl_info *info)
+{
+	struct frer_stream *st;
+	struct frer_ctrl ctrl;
+	int ret;
+
+	rtnl_lock();
+	ret = frer_stream_get_handle(info, &st);
+	if (!ret) {
+		ctrl = st->ctrl;
+		ctrl.seq_reset = true;
+		ctrl.wr_op_type = FRER_WR_OP_MEMBER;
+		frer_control(ctrl);
+	}
+	rtnl_unlock();
+
+	return ret;
+}
+
+static int frer_put_cntr(struct sk_buff *msg, int attr,
+			 struct static_cntr *cntr)
+{
+	return nla_put_u64_64bit(msg, attr,
+				 ((u64)cntr->msb << 32) | cntr->lsb,
+				 XLNX_TSN_FRER_A_PAD);
+}
+
+static int frer_stream_fill(struct sk_buff *msg, u32 portid, u32 seq,
+			    int flags, struct frer_stream *st)
+{
+	struct frer_static_counter cnt = { .num = st->ctrl.gate_id };
+	void *hdr;
+
+	hdr = genlmsg_put(msg, portid, seq, &frer_genl_family, flags,
+			  XLNX_TSN_FRER_CMD_STREAM_GET);
+	if (!hdr)
+		return -EMSGSIZE;
+
+	get_frer_static_counter(&cnt);
+
+	if (nla_put_u8(msg, XLNX_TSN_FRER_A_HANDLE, st->ctrl.gate_id) ||
+	    nla_put_u8(msg, XLNX_TSN_FRER_A_MEMBER, st->ctrl.memb_id) ||
+	    nla_put_u8(msg, XLNX_TSN_FRER_A_IN_PORT, st->in_fltr.in_port_id) ||
+	    nla_put_u16(msg, XLNX_TSN_FRER_A_MAX_SEQ_ID,
+			st->in_fltr.max_seq_id) ||
+	    nla_put_u8(msg, XLNX_TSN_FRER_A_HIST_LEN,
+		       st->memb.seq_rec_hist_len) ||
+	    nla_put_u32(msg, XLNX_TSN_FRER_A_RESET_TICKS, st->memb.rem_ticks) ||
+	    nla_put_u8(msg, XLNX_TSN_FRER_A_SPLIT_PORT,
+		       st->memb.split_strm_egport_id) ||
+	    nla_put_u16(msg, XLNX_TSN_FRER_A_SPLIT_VID,
+			st->memb.split_strm_vlan_id))
+		goto nla_put_failure;
+
+	if (st->ctrl.rcvry_tmout &&
+	    nla_put_flag(msg, XLNX_TSN_FRER_A_RECOVERY_TIMEOUT))
+		goto nla_put_failure;
+
+	if (st->cam &&
+	    (nla_put(msg, XLNX_TSN_FRER_A_DST_ADDR, ETH_ALEN, st->addr) ||
+	     nla_put_u16(msg, XLNX_TSN_FRER_A_VID, st->vid)))
+		goto nla_put_failure;
+
+	if (frer_put_cntr(msg, XLNX_TSN_FRER_A_CNT_FRAMES,
+			  &cnt.frer_fr_count) ||
+	    frer_put_cntr(msg, XLNX_TSN_FRER_A_CNT_DISC_IN_PORT,
+			  &cnt.disc_frames_in_portid) ||
+	    frer_put_cntr(msg, XLNX_TSN_FRER_A_CNT_PASS_SEQ,
+			  &cnt.pass_frames_seq_recv) ||
+	    frer_put_cntr(msg, XLNX_TSN_FRER_A_CNT_DISC_SEQ,
+			  &cnt.disc_frames_seq_recv) ||
+	    frer_put_cntr(msg, XLNX_TSN_FRER_A_CNT_ROGUE_SEQ,
+			  &cnt.rogue_frames_seq_recv) ||
+	    frer_put_cntr(msg, XLNX_TSN_FRER_A_CNT_PASS_IND,
+			  &cnt.pass_frames_ind_recv) ||
+	    frer_put_cntr(msg, XLNX_TSN_FRER_A_CNT_DISC_IND,
+			  &cnt.disc_frames_ind_recv) ||
+	    frer_put_cntr(msg, XLNX_TSN_FRER_A_CNT_SEQ_RESETS,
+			  &cnt.seq_recv_rst))
+		goto nla_put_failure;
+
+	genlmsg_end(msg, hdr);
+	return 0;
+
+nla_put_failure:
+	genlmsg_cancel(msg, hdr);
+	return -EMSGSIZE;
+}
+
+static int frer_stream_get(struct sk_buff *skb, struct genl_info *info)
+{
+	struct frer_stream *st;
+	struct sk_buff *msg;
+	int ret;
+
+	msg = nlmsg_new(NLMSG_DEFAULT_SIZE, GFP_KERNEL);
+	if (!msg)
+		return -ENOMEM;
+
+	rtnl_lock();
+	ret = frer_stream_get_handle(info, &st);
+	if (!ret)
+		ret = frer_stream_fill(msg, info->snd_portid, info->snd_seq, 0,
+				       st);
+	rtnl_unlock();
+
+	if (ret) {
+		nlmsg_free(msg);
+		return ret;
+	}
+
+	return genlmsg_reply(msg, info);
+}
+
+static int frer_stream_dump(struct sk_buff *skb, struct netlink_callback *cb)
+{
+	int i;
+
+	rtnl_lock();
+	for (i = cb->args[0]; i < FRER_MAX_STREAMS; i++) {
+		if (!frer_streams[i].valid)
+			continue;
+		if (frer_stream_fill(skb, NETLINK_CB(cb->skb).portid,
+				     cb->nlh->nlmsg_seq, NLM_F_MULTI,
+				     &frer_streams[i]))
+			break;
+	}
+	rtnl_unlock();
+
+	cb->args[0] = i;
+	return skb->len;
+}
+
+static const struct nla_policy frer_genl_policy[XLNX_TSN_FRER_A_MAX + 1] = {
+	[XLNX_TSN_FRER_A_HANDLE]		= { .type = NLA_U8 },
+	[XLNX_TSN_FRER_A_MEMBER]		= { .type = NLA_U8 },
+	[XLNX_TSN_FRER_A_IN_PORT]		= { .type = NLA_U8 },
+	[XLNX_TSN_FRER_A_MAX_SEQ_ID]		= { .type = NLA_U16 },
+	[XLNX_TSN_FRER_A_HIST_LEN]		= { .type = NLA_U8 },
+	[XLNX_TSN_FRER_A_RESET_TICKS]		= { .type = NLA_U32 },
+	[XLNX_TSN_FRER_A_SPLIT_PORT]		= { .type = NLA_U8 },
+	[XLNX_TSN_FRER_A_SPLIT_VID]		= { .type = NLA_U16 },
+	[XLNX_TSN_FRER_A_RECOVERY_TIMEOUT]	= { .type = NLA_FLAG },
+	[XLNX_TSN_FRER_A_DST_ADDR]		= { .type = NLA_EXACT_LEN,
+						    .len = ETH_ALEN },
+	[XLNX_TSN_FRER_A_VID]			= { .type = NLA_U16 },
+};
+
+static const struct genl_ops frer_genl_ops[] = {
+	{
+		.cmd = XLNX_TSN_FRER_CMD_STREAM_SET,
+		.doit = frer_stream_set,
+		.flags = GENL_ADMIN_PERM,
+	},
+	{
+		.cmd = XLNX_TSN_FRER_CMD_STREAM_DEL,
+		.doit = frer_stream_del,
+		.flags = GENL_ADMIN_PERM,
+	},
+	{
+		.cmd = XLNX_TSN_FRER_CMD_STREAM_GET,
+		.doit = frer_stream_get,
+		.dumpit = frer_stream_dump,
+	},
+	{
+		.cmd = XLNX_TSN_FRER_CMD_STREAM_RESET,
+		.doit = frer_stream_reset,
+		.flags = GENL_ADMIN_PERM,
+	},
+};
+
+static struct genl_family frer_genl_family = {
+	.name = XLNX_TSN_FRER_GENL_NAME,
+	.version = XLNX_TSN_FRER_GENL_VERSION,
+	.maxattr = XLNX_TSN_FRER_A_MAX,
+	.policy = frer_genl_policy,
+	.module = THIS_MODULE,
+	.ops = frer_genl_ops,
+	.n_ops = ARRAY_SIZE(frer_genl_ops),
+};
+
+/**
+ * frer_genl_register - Register the FRER generic netlink family
+ *
+ * Return: 0 on success or the error of genl_register_family().
+ */
+int frer_genl_register(void)
+{
+	return genl_register_family(&frer_genl_family);
+}
+
+/**
+ * frer_genl_unregister - Unregister the FRER generic netlink family
+ */
+void frer_genl_unregister(void)
+{
+	genl_unregister_family(&frer_genl_family);
+}
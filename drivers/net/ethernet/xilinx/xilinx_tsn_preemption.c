@@ -221,3 +221,158 @@ int axienet_qbu_sts(struct net_device *ndev, void __user *useraddr)
 		return -EFAULT;
 	return 0;
 }
+
+/* MAC merge counters, in register order from TX_HOLD_REG */
+static const char axienet_mm_stats_strings[][ETH_GSTRING_LEN] = {
+	"mm_tx_hold",
+	"mm_tx_frag",
+	"mm_rx_assembly_ok",
+	"mm_rx_assembly_err",
+	"mm_rx_smd_err",
+	"mm_rx_frag",
+	"mm_tx_active",
+	"mm_verify_status",
+};
+
+#define AXIENET_MM_CNT_LEN \
+	(sizeof(struct mac_merge_counters) / sizeof(union static_cntr))
+
+static const char axienet_preemption_priv_flags[][ETH_GSTRING_LEN] = {
+	"preemption",
+	"preemption-verify",
+};
+
+#define AXIENET_PRIV_FLAG_PREEMPTION		BIT(0)
+#define AXIENET_PRIV_FLAG_PREEMPTION_VERIFY	BIT(1)
+
+/**
+ * axienet_preemption_sset_count - Number of frame preemption ethtool items
+ * @ndev: Pointer to the net_device structure
+ * @sset: ETH_SS_STATS or ETH_SS_PRIV_FLAGS
+ * Return: Number of items added to @sset, 0 on a non TSN port
+ */
+int axienet_preemption_sset_count(struct net_device *ndev, int sset)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+
+	if (!lp->is_tsn)
+		return 0;
+
+	switch (sset) {
+	case ETH_SS_STATS:
+		return ARRAY_SIZE(axienet_mm_stats_strings);
+	case ETH_SS_PRIV_FLAGS:
+		return ARRAY_SIZE(axienet_preemption_priv_flags);
+	default:
+		return 0;
+	}
+}
+
+/**
+ * axienet_preemption_strings - Names of the frame preemption ethtool items
+ * @ndev: Pointer to the net_device structure
+ * @sset: ETH_SS_STATS or ETH_SS_PRIV_FLAGS
+ * @data: Buffer to copy the names to
+ */
+void axienet_preemption_strings(struct net_device *ndev, u32 sset, u8 *data)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+
+	if (!lp->is_tsn)
+		return;
+
+	switch (sset) {
+	case ETH_SS_STATS:
+		memcpy(data, axienet_mm_stats_strings,
+		       sizeof(axienet_mm_stats_strings));
+		break;
+	case ETH_SS_PRIV_FLAGS:
+		memcpy(data, axienet_preemption_priv_flags,
+		       sizeof(axienet_preemption_priv_flags));
+		break;
+	}
+}
+
+/**
+ * axienet_preemption_stats - Read the MAC merge counters and status
+ * @ndev: Pointer to the net_device structure
+ * @data: Counter values, in the order of axienet_mm_stats_strings
+ *
+ * mm_verify_status is the 802.3br verify state of the core: 0 init,
+ * 1 verifying, 2 succeeded, 3 failed, 4 disabled.
+ */
+void axienet_preemption_stats(struct net_device *ndev, u64 *data)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	u32 off = TX_HOLD_REG;
+	u32 value;
+	int i;
+
+	if (!lp->is_tsn)
+		return;
+
+	for (i = 0; i < AXIENET_MM_CNT_LEN; i++, off += 8)
+		data[i] = axienet_ior(lp, off) |
+			  (u64)axienet_ior(lp, off + 4) << 32;
+
+	value = axienet_ior(lp, PREEMPTION_CTRL_STS_REG);
+	data[i++] = !!(value & TX_PREEMPTION_STS);
+	data[i] = (value >> MAC_MERGE_TX_VERIFY_STS_SHIFT) &
+		  MAC_MERGE_TX_VERIFY_STS_MASK;
+}
+
+/**
+ * axienet_preemption_get_priv_flags - Report the preemption configuration
+ * @ndev: Pointer to the net_device structure
+ * Return: AXIENET_PRIV_FLAG_* bits
+ */
+u32 axienet_preemption_get_priv_flags(struct net_device *ndev)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	u32 flags = 0;
+
+	if (!lp->is_tsn)
+		return 0;
+
+	if (axienet_ior(lp, PREEMPTION_ENABLE_REG) & PREEMPTION_ENABLE)
+		flags |= AXIENET_PRIV_FLAG_PREEMPTION;
+	if (!(axienet_ior(lp, PREEMPTION_CTRL_STS_REG) &
+	      DISABLE_PREEMPTION_VERIFY))
+		flags |= AXIENET_PRIV_FLAG_PREEMPTION_VERIFY;
+
+	return flags;
+}
+
+/**
+ * axienet_preemption_set_priv_flags - Enable preemption and verification
+ * @ndev: Pointer to the net_device structure
+ * @flags: AXIENET_PRIV_FLAG_* bits
+ *
+ * With verification enabled the core only starts preempting once the
+ * link partner has answered the verify handshake, mm_verify_status tells
+ * how far it got.
+ *
+ * Return: 0 on success, -EOPNOTSUPP on a non TSN port
+ */
+int axienet_preemption_set_priv_flags(struct net_device *ndev, u32 flags)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	u32 value;
+
+	if (!lp->is_tsn)
+		return flags ? -EOPNOTSUPP : 0;
+
+	/* program the verification before preemption may start */
+	value = axienet_ior(lp, PREEMPTION_CTRL_STS_REG);
+	if (flags & AXIENET_PRIV_FLAG_PREEMPTION_VERIFY)
+		value &= ~DISABLE_PREEMPTION_VERIFY;
+	else
+		value |= DISABLE_PREEMPTION_VERIFY;
+	axienet_iow(lp, PREEMPTION_CTRL_STS_REG, value);
+
+	axienet_iow(lp, PREEMPTION_ENABLE_REG,
+		    (flags & AXIENET_PRIV_FLAG_PREEMPTION) ?
+		    PREEMPTION_ENABLE : 0);
+
+	return 0;
+}
@@ -36,13 +36,18 @@ struct xlnx_ptp_timer {
 	int                    irq;
 	int                    pps_enable;
 	int                    countpulse;
+	u32                    incval; /* nominal RTC increment */
 };
 
-static void xlnx_tod_read(struct xlnx_ptp_timer *timer, struct timespec64 *ts)
+static void xlnx_tod_read(struct xlnx_ptp_timer *timer, struct timespec64 *ts,
+			  struct ptp_system_timestamp *sts)
 {
 	u32 sec, nsec;
 
+	/* Reading the nanoseconds latches the seconds */
+	ptp_read_system_prets(sts);
 	nsec = in_be32(timer->baseaddr + XTIMER1588_CURRENT_RTC_NS);
+	ptp_read_system_postts(sts);
 	sec = in_be32(timer->baseaddr + XTIMER1588_CURRENT_RTC_SEC_L);
 
 	ts->tv_sec = sec;
@@ -69,31 +74,35 @@ static void xlnx_rtc_offset_read(struct xlnx_ptp_timer *timer,
 
 /* PTP clock operations
  */
-static int xlnx_ptp_adjfreq(struct ptp_clock_info *ptp, s32 ppb)
+
+/**
+ * xlnx_ptp_adjfine - Adjust the frequency of the hardware clock
+ * @ptp: ptp clock structure
+ * @scaled_ppm: frequency offset in ppm with a 16 bit binary fraction
+ *
+ * The increment register holds the nanoseconds added per RTC clock with
+ * a 20 bit fraction, which steers the clock well below one ppb.
+ *
+ * Return: 0 in all cases.
+ */
+static int xlnx_ptp_adjfine(struct ptp_clock_info *ptp, long scaled_ppm)
 {
 	struct xlnx_ptp_timer *timer = container_of(ptp, struct xlnx_ptp_timer,
 						    ptp_clock_info);
-
-	int neg_adj = 0;
-	u64 freq;
+	bool neg_adj = false;
 	u32 diff, incval;
+	u64 adj;
 
-	/* This number should be replaced by a call to get the frequency
-	 * from the device-tree. Currently assumes 125MHz
-	 */
-	incval = 0x800000;
-	/* for 156.25 MHZ Ref clk the value is  incval = 0x800000; */
-
-	if (ppb < 0) {
-		neg_adj = 1;
-		ppb = -ppb;
+	if (scaled_ppm < 0) {
+		neg_adj = true;
+		scaled_ppm = -scaled_ppm;
 	}
 
-	freq = incval;
-	freq *= ppb;
-	diff = div_u64(freq, 1000000000ULL);
+	incval = timer->incval;
+	adj = (u64)incval * scaled_ppm;
+	diff = div_u64(adj, 1000000ULL << 16);
 
-	pr_debug("%s: adj: %d ppb: %d\n", __func__, diff, ppb);
+	pr_debug("%s: adj: %u scaled_ppm: %ld\n", __func__, diff, scaled_ppm);
 
 	incval = neg_adj ? (incval - diff) : (incval + diff);
 	out_be32((timer->baseaddr + XTIMER1588_RTC_INCREMENT), incval);
@@ -119,14 +128,26 @@ static int xlnx_ptp_adjtime(struct ptp_clock_info *ptp, s64 delta)
 	return 0;
 }
 
-static int xlnx_ptp_gettime(struct ptp_clock_info *ptp, struct timespec64 *ts)
+/**
+ * xlnx_ptp_gettimex - Get the time of the hardware clock
+ * @ptp: ptp clock structure
+ * @ts: timespec64 to fill with the hardware time
+ * @sts: system timestamps taken around the latching register read
+ *
+ * The system timestamps bracket only the nanoseconds register read, which
+ * keeps the window phc2sys has to account for as short as the bus allows.
+ *
+ * Return: 0 in all cases.
+ */
+static int xlnx_ptp_gettimex(struct ptp_clock_info *ptp, struct timespec64 *ts,
+			     struct ptp_system_timestamp *sts)
 {
 	unsigned long flags;
 	struct xlnx_ptp_timer *timer = container_of(ptp, struct xlnx_ptp_timer,
 						    ptp_clock_info);
 	spin_lock_irqsave(&timer->reg_lock, flags);
 
-	xlnx_tod_read(timer, ts);
+	xlnx_tod_read(timer, ts, sts);
 
 	spin_unlock_irqrestore(&timer->reg_lock, flags);
 	return 0;
@@ -160,7 +181,7 @@ static int xlnx_ptp_settime(struct ptp_clock_info *ptp,
 	xlnx_rtc_offset_write(timer, &offset);
 
 	/* Get the current timer value */
-	xlnx_tod_read(timer, &tod);
+	xlnx_tod_read(timer, &tod, NULL);
 
 	/* Subtract the current reported time from our desired time */
 	delta = timespec64_sub(*ts, tod);
@@ -185,7 +206,7 @@ static int xlnx_ptp_enable(struct ptp_clock_info *ptp,
 
 	switch (rq->type) {
 	case PTP_CLK_REQ_PPS:
-		timer->pps_enable = 1;
+		timer->pps_enable = !!on;
 		return 0;
 	default:
 		break;
@@ -200,9 +221,9 @@ static struct ptp_clock_info xlnx_ptp_clock_info = {
 	.max_adj  = 999999999,
 	.n_ext_ts	= 0,
 	.pps      = 1,
-	.adjfreq  = xlnx_ptp_adjfreq,
+	.adjfine  = xlnx_ptp_adjfine,
 	.adjtime  = xlnx_ptp_adjtime,
-	.gettime64  = xlnx_ptp_gettime,
+	.gettimex64 = xlnx_ptp_gettimex,
 	.settime64 = xlnx_ptp_settime,
 	.enable   = xlnx_ptp_enable,
 };
@@ -273,6 +294,10 @@ void *axienet_ptp_timer_probe(void __iomem *base, struct platform_device *pdev)
 		return NULL;
 
 	timer->baseaddr = base;
+	/* This number should be replaced by a call to get the frequency
+	 * from the device-tree. Currently assumes 125MHz
+	 */
+	timer->incval = 0x800000;
 
 	timer->irq = platform_get_irq_byname(pdev, "interrupt_ptp_timer");
 
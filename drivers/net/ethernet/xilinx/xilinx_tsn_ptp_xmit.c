@@ -361,7 +361,7 @@ irqreturn_t axienet_ptp_tx_irq(int irq, void *_ndev)
 	/* read ctrl register to clear the interrupt */
 	axienet_ior(lp, PTP_TX_CONTROL_OFFSET);
 
-	schedule_work(&lp->tx_tstamp_work);
+	queue_work(system_unbound_wq, &lp->tx_tstamp_work);
 
 	netif_wake_queue(ndev);
 
@@ -15,6 +15,9 @@
  * GNU General Public License for more details.
  */
 
+#include <linux/etherdevice.h>
+#include <linux/rtnetlink.h>
+#include <net/flow_offload.h>
 #include "xilinx_tsn_switch.h"
 
 #define SMC_MODE_SHIFT				28
@@ -34,6 +37,33 @@
 #define OP_TYPE_SHIFT				1
 #define PSFP_EN_CONTROL_MASK			0x1
 
+/* PSFP control write operations */
+#define PSFP_WR_OP_FILTER			0x0
+#define PSFP_WR_OP_METER			0x1
+#define PSFP_OP_WRITE				1
+
+/* Streams offloaded through tc flower, each one owns the gate and meter
+ * with the ID of its slot.
+ */
+#define QCI_MAX_STREAMS				16
+
+/**
+ * struct qci_stream - Qci stream offloaded from a flower rule
+ * @cookie:	Flower rule cookie, 0 for a free slot
+ * @addr:	Destination MAC address identifying the stream
+ * @vid:	VLAN ID identifying the stream
+ * @frames:	PSFP frame counter at the last stats update
+ */
+struct qci_stream {
+	unsigned long cookie;
+	u8 addr[ETH_ALEN];
+	u16 vid;
+	u64 frames;
+};
+
+/* protected by rtnl */
+static struct qci_stream qci_streams[QCI_MAX_STREAMS];
+
 /**
  * psfp_control - Configure thr control for PSFP
  * @data:	Value to be programmed
@@ -149,3 +179,229 @@ void get_psfp_static_counter(struct psfp_static_counter *data)
 	data->err_meter.lsb = axienet_ior(&lp, METER_ERR_OFFSET + offset);
 	data->err_meter.msb = axienet_ior(&lp, METER_ERR_OFFSET + offset + 0x4);
 }
+
+static struct qci_stream *qci_stream_find(unsigned long cookie)
+{
+	int i;
+
+	for (i = 0; i < QCI_MAX_STREAMS; i++)
+		if (qci_streams[i].cookie == cookie)
+			return &qci_streams[i];
+
+	return NULL;
+}
+
+static u64 qci_stream_frames(u8 gate_id)
+{
+	struct psfp_static_counter cnt = { .num = gate_id };
+
+	get_psfp_static_counter(&cnt);
+
+	return ((u64)cnt.psfp_fr_count.msb << 32) | cnt.psfp_fr_count.lsb;
+}
+
+static int qci_flower_parse(struct flow_cls_offload *f, struct qci_stream *st,
+			    struct meter_config *meter, bool *en_meter,
+			    bool *allow)
+{
+	struct flow_rule *rule = flow_cls_offload_flow_rule(f);
+	struct netlink_ext_ack *extack = f->common.extack;
+	struct flow_dissector *dissector = rule->match.dissector;
+	struct flow_match_eth_addrs match_eth;
+	const struct flow_action_entry *act;
+	int i;
+
+	if (dissector->used_keys &
+	    ~(BIT(FLOW_DISSECTOR_KEY_CONTROL) |
+	      BIT(FLOW_DISSECTOR_KEY_BASIC) |
+	      BIT(FLOW_DISSECTOR_KEY_ETH_ADDRS) |
+	      BIT(FLOW_DISSECTOR_KEY_VLAN))) {
+		NL_SET_ERR_MSG_MOD(extack,
+				   "Streams are identified by dst MAC and VLAN only");
+		return -EOPNOTSUPP;
+	}
+
+	if (!flow_rule_match_key(rule, FLOW_DISSECTOR_KEY_ETH_ADDRS)) {
+		NL_SET_ERR_MSG_MOD(extack, "A destination MAC match is required");
+		return -EOPNOTSUPP;
+	}
+
+	flow_rule_match_eth_addrs(rule, &match_eth);
+	if (!is_broadcast_ether_addr(match_eth.mask->dst) ||
+	    !is_zero_ether_addr(match_eth.mask->src)) {
+		NL_SET_ERR_MSG_MOD(extack,
+				   "Only an exact destination MAC match is supported");
+		return -EOPNOTSUPP;
+	}
+	ether_addr_copy(st->addr, match_eth.key->dst);
+
+	st->vid = 0;
+	if (flow_rule_match_key(rule, FLOW_DISSECTOR_KEY_VLAN)) {
+		struct flow_match_vlan match_vlan;
+
+		flow_rule_match_vlan(rule, &match_vlan);
+		if (match_vlan.mask->vlan_id != VLAN_VID_MASK ||
+		    match_vlan.mask->vlan_priority) {
+			NL_SET_ERR_MSG_MOD(extack,
+					   "Only an exact VLAN ID match is supported");
+			return -EOPNOTSUPP;
+		}
+		st->vid = match_vlan.key->vlan_id;
+	}
+
+	*en_meter = false;
+	*allow = true;
+	flow_action_for_each(i, act, &rule->action) {
+		switch (act->id) {
+		case FLOW_ACTION_DROP:
+			*allow = false;
+			break;
+		case FLOW_ACTION_POLICE:
+			if (act->police.rate_bytes_ps > U32_MAX ||
+			    act->police.burst > SMC_CBR_MASK) {
+				NL_SET_ERR_MSG_MOD(extack,
+						   "Police rate or burst out of range");
+				return -ERANGE;
+			}
+			/* single rate meter, excess traffic is dropped */
+			memset(meter, 0, sizeof(*meter));
+			meter->cir = act->police.rate_bytes_ps;
+			meter->cbr = act->police.burst;
+			*en_meter = true;
+			break;
+		default:
+			NL_SET_ERR_MSG_MOD(extack,
+					   "Only police and drop actions are supported");
+			return -EOPNOTSUPP;
+		}
+	}
+
+	return 0;
+}
+
+static void qci_stream_psfp(u8 id, bool en_psfp, bool en_meter, bool allow,
+			    u8 wr_op_type)
+{
+	struct psfp_config psfp = {};
+
+	psfp.gate_id = id;
+	psfp.meter_id = id;
+	psfp.en_meter = en_meter;
+	psfp.allow_stream = allow;
+	psfp.en_psfp = en_psfp;
+	psfp.wr_op_type = wr_op_type;
+	psfp.op_type = PSFP_OP_WRITE;
+	psfp_control(psfp);
+}
+
+static int qci_flower_replace(struct net_device *ndev,
+			      struct flow_cls_offload *f)
+{
+	struct axienet_local *plp = netdev_priv(ndev);
+	struct stream_filter filter = {};
+	struct meter_config meter;
+	struct qci_stream *st;
+	bool en_meter, allow;
+	u8 id;
+	int ret;
+
+	if (qci_stream_find(f->cookie))
+		return -EEXIST;
+
+	st = qci_stream_find(0);
+	if (!st) {
+		NL_SET_ERR_MSG_MOD(f->common.extack, "No free Qci stream");
+		return -ENOSPC;
+	}
+	id = st - qci_streams;
+
+	ret = qci_flower_parse(f, st, &meter, &en_meter, &allow);
+	if (ret)
+		return ret;
+
+	/* only frames received on this MAC port belong to the stream */
+	filter.in_pid = plp->temac_no + 1;
+	filter.max_fr_size = MAX_FR_SIZE_MASK;
+	config_stream_filter(filter);
+	qci_stream_psfp(id, true, en_meter, allow, PSFP_WR_OP_FILTER);
+
+	if (en_meter) {
+		program_meter_reg(meter);
+		qci_stream_psfp(id, true, en_meter, allow, PSFP_WR_OP_METER);
+	}
+
+	ret = tsn_switch_stream_add(st->addr, st->vid, id);
+	if (ret) {
+		NL_SET_ERR_MSG_MOD(f->common.extack,
+				   "The stream is already offloaded");
+		qci_stream_psfp(id, false, false, true, PSFP_WR_OP_FILTER);
+		return ret;
+	}
+
+	st->cookie = f->cookie;
+	st->frames = qci_stream_frames(id);
+
+	return 0;
+}
+
+static int qci_flower_destroy(struct flow_cls_offload *f)
+{
+	struct qci_stream *st = qci_stream_find(f->cookie);
+
+	if (!st)
+		return -ENOENT;
+
+	tsn_switch_stream_del(st->addr, st->vid);
+	qci_stream_psfp(st - qci_streams, false, false, true,
+			PSFP_WR_OP_FILTER);
+	st->cookie = 0;
+
+	return 0;
+}
+
+static int qci_flower_stats(struct flow_cls_offload *f)
+{
+	struct qci_stream *st = qci_stream_find(f->cookie);
+	u64 frames;
+
+	if (!st)
+		return -ENOENT;
+
+	/* the PSFP counters do not count bytes */
+	frames = qci_stream_frames(st - qci_streams);
+	flow_stats_update(&f->stats, 0, frames - st->frames, jiffies);
+	st->frames = frames;
+
+	return 0;
+}
+
+/**
+ * tsn_qci_flower - Offload a flower rule to the Qci stream filters
+ * @ndev:	Pointer to the MAC port net_device structure
+ * @f:		Flower offload request
+ *
+ * A rule with an exact destination MAC match, optionally with a VLAN ID,
+ * identifies a stream in the switch CAM. A police action meters the
+ * stream and a drop action blocks it, in hardware, before the frames
+ * reach the DMA.
+ *
+ * Return: 0 on success or a negative error code.
+ */
+int tsn_qci_flower(struct net_device *ndev, struct flow_cls_offload *f)
+{
+	ASSERT_RTNL();
+
+	if (f->common.chain_index)
+		return -EOPNOTSUPP;
+
+	switch (f->command) {
+	case FLOW_CLS_REPLACE:
+		return qci_flower_replace(ndev, f);
+	case FLOW_CLS_DESTROY:
+		return qci_flower_destroy(f);
+	case FLOW_CLS_STATS:
+		return qci_flower_stats(f);
+	default:
+		return -EOPNOTSUPP;
+	}
+}
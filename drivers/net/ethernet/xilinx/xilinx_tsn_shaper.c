@@ -15,6 +15,7 @@
  * GNU General Public License for more details.
  */
 
+#include <linux/math64.h>
 #include "xilinx_axienet.h"
 #include "xilinx_tsn_shaper.h"
 
@@ -38,33 +39,23 @@ static inline int axienet_map_gs_to_hw(struct axienet_local *lp, u32 gs)
 	return acl_bit_map;
 }
 
-static int __axienet_set_schedule(struct net_device *ndev, struct qbv_info *qbv)
+/**
+ * axienet_qbv_write_admin - Program an admin list and request its start
+ * @lp:		Pointer to axienet local structure
+ * @qbv:	Schedule to program
+ *
+ * The gate enable bit is left set, so a running operational list keeps
+ * controlling the gates until the core swaps in the admin list at its
+ * config change time.
+ */
+static void axienet_qbv_write_admin(struct axienet_local *lp,
+				    struct qbv_info *qbv)
 {
-	struct axienet_local *lp = netdev_priv(ndev);
 	u16 i;
 	unsigned int acl_bit_map = 0;
 	u32 u_config_change = 0;
 	u8 port = qbv->port;
 
-	if (qbv->cycle_time == 0) {
-		/* clear the gate enable bit */
-		u_config_change &= ~CC_ADMIN_GATE_ENABLE_BIT;
-		/* open all the gates */
-		u_config_change |= CC_ADMIN_GATE_STATE_SHIFT;
-
-		axienet_iow(lp, CONFIG_CHANGE(port), u_config_change);
-
-		return 0;
-	}
-
-	if (axienet_ior(lp, PORT_STATUS(port)) & 1) {
-		if (qbv->force) {
-			u_config_change &= ~CC_ADMIN_GATE_ENABLE_BIT;
-			axienet_iow(lp, CONFIG_CHANGE(port), u_config_change);
-		} else {
-			return -EALREADY;
-		}
-	}
 	/* write admin time */
 	axienet_iow(lp, ADMIN_CYCLE_TIME_DENOMINATOR(port),
 		    qbv->cycle_time & CYCLE_TIME_DENOMINATOR_MASK);
@@ -106,6 +97,35 @@ static int __axienet_set_schedule(struct net_device *ndev, struct qbv_info *qbv)
 
 	/* start */
 	axienet_iow(lp, CONFIG_CHANGE(port), u_config_change);
+}
+
+static int __axienet_set_schedule(struct net_device *ndev, struct qbv_info *qbv)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	u32 u_config_change = 0;
+	u8 port = qbv->port;
+
+	if (qbv->cycle_time == 0) {
+		/* clear the gate enable bit */
+		u_config_change &= ~CC_ADMIN_GATE_ENABLE_BIT;
+		/* open all the gates */
+		u_config_change |= CC_ADMIN_GATE_STATE_SHIFT;
+
+		axienet_iow(lp, CONFIG_CHANGE(port), u_config_change);
+
+		return 0;
+	}
+
+	if (axienet_ior(lp, PORT_STATUS(port)) & PORT_STATUS_CONFIG_PENDING) {
+		if (qbv->force) {
+			u_config_change &= ~CC_ADMIN_GATE_ENABLE_BIT;
+			axienet_iow(lp, CONFIG_CHANGE(port), u_config_change);
+		} else {
+			return -EALREADY;
+		}
+	}
+
+	axienet_qbv_write_admin(lp, qbv);
 
 	return 0;
 }
@@ -199,15 +219,167 @@ int axienet_get_schedule(struct net_device *ndev, void __user *useraddr)
 	return ret;
 }
 
+static inline u8 axienet_qbv_port(struct axienet_local *lp)
+{
+	return lp->temac_no == XAE_TEMAC2 ? PORT_TEMAC_2 : PORT_TEMAC_1;
+}
+
+/* Map a taprio gate mask, one bit per traffic class, to GS_* gate states */
+static inline u32 axienet_tc_to_gs(struct axienet_local *lp, u32 gate_mask)
+{
+	u32 gs = 0;
+
+	if (gate_mask & BIT(0))
+		gs |= GS_BE_OPEN;
+	if (lp->num_tc == 2) {
+		if (gate_mask & BIT(1))
+			gs |= GS_ST_OPEN;
+	} else {
+		if (gate_mask & BIT(1))
+			gs |= GS_RE_OPEN;
+		if (gate_mask & BIT(2))
+			gs |= GS_ST_OPEN;
+	}
+
+	return gs;
+}
+
+static int axienet_taprio_to_qbv(struct axienet_local *lp,
+				 struct tc_taprio_qopt_offload *qopt,
+				 struct qbv_info *qbv)
+{
+	u32 tick, nsec;
+	size_t i;
+
+	/* The core has no register for the cycle time extension, an admin
+	 * list always takes over exactly at its config change time.
+	 */
+	if (qopt->cycle_time_extension)
+		return -EOPNOTSUPP;
+
+	if (!qopt->num_entries || qopt->num_entries > QBV_MAX_ENTRIES ||
+	    qopt->num_entries > CC_ADMIN_CTRL_LIST_LENGTH_MASK)
+		return -ERANGE;
+
+	if (qopt->base_time < 0 || !qopt->cycle_time ||
+	    qopt->cycle_time > CYCLE_TIME_DENOMINATOR_MASK)
+		return -ERANGE;
+
+	tick = (axienet_ior(lp, GATE_STATE(qbv->port)) >>
+		GS_TICK_GRANULARITY_SHIFT) & GS_TICK_GRANULARITY_MASK;
+	if (!tick)
+		tick = 1;
+
+	for (i = 0; i < qopt->num_entries; i++) {
+		struct tc_taprio_sched_entry *entry = &qopt->entries[i];
+
+		/* HOLD and RELEASE belong to frame preemption */
+		if (entry->command != TC_TAPRIO_CMD_SET_GATES)
+			return -EOPNOTSUPP;
+
+		if (entry->gate_mask & ~GENMASK(lp->num_tc - 1, 0))
+			return -EINVAL;
+
+		if (entry->interval % tick ||
+		    entry->interval / tick > CTRL_LIST_TIME_INTERVAL_MASK)
+			return -ERANGE;
+
+		qbv->acl_gate_state[i] = axienet_tc_to_gs(lp, entry->gate_mask);
+		qbv->acl_gate_time[i] = entry->interval / tick;
+	}
+
+	qbv->list_length = qopt->num_entries;
+	qbv->cycle_time = qopt->cycle_time;
+	qbv->ptp_time_sec = div_u64_rem(qopt->base_time, NSEC_PER_SEC, &nsec);
+	qbv->ptp_time_ns = nsec;
+
+	return 0;
+}
+
+/**
+ * axienet_taprio_setup - Offload a taprio schedule to the Qbv shaper
+ * @ndev:	Pointer to the net_device structure
+ * @qopt:	taprio offload request
+ *
+ * A new schedule is written to the admin list while the operational list
+ * keeps running, and the core swaps the two at the admin base time. The
+ * admin list can only be written while no other change is pending, so a
+ * schedule that arrives while one is pending is parked in
+ * lp->qbv_pending and programmed from axienet_qbv_irq() once the core
+ * reports the swap. A later schedule replaces a parked one.
+ *
+ * Return: 0 on success, -EOPNOTSUPP or -ERANGE for a schedule the core
+ * cannot run, -EBUSY when a change is pending on a port without the Qbv
+ * interrupt, or -ENOMEM.
+ */
+int axienet_taprio_setup(struct net_device *ndev,
+			 struct tc_taprio_qopt_offload *qopt)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	struct qbv_info *qbv, *old;
+	unsigned long flags;
+	int ret = 0;
+
+	qbv = kzalloc(sizeof(*qbv), GFP_KERNEL);
+	if (!qbv)
+		return -ENOMEM;
+
+	qbv->port = axienet_qbv_port(lp);
+
+	if (qopt->enable) {
+		ret = axienet_taprio_to_qbv(lp, qopt, qbv);
+		if (ret) {
+			kfree(qbv);
+			return ret;
+		}
+	}
+
+	spin_lock_irqsave(&lp->qbv_lock, flags);
+	old = lp->qbv_pending;
+	lp->qbv_pending = NULL;
+
+	if (!qopt->enable) {
+		/* cycle_time 0 disables the gates and opens all of them */
+		__axienet_set_schedule(ndev, qbv);
+	} else if (!(axienet_ior(lp, PORT_STATUS(qbv->port)) &
+		     PORT_STATUS_CONFIG_PENDING)) {
+		axienet_qbv_write_admin(lp, qbv);
+	} else if (lp->temac_no == XAE_TEMAC1) {
+		lp->qbv_pending = qbv;
+		qbv = NULL;
+	} else {
+		ret = -EBUSY;
+	}
+	spin_unlock_irqrestore(&lp->qbv_lock, flags);
+
+	kfree(old);
+	kfree(qbv);
+
+	return ret;
+}
+
 static irqreturn_t axienet_qbv_irq(int irq, void *_ndev)
 {
 	struct net_device *ndev = _ndev;
 	struct axienet_local *lp = netdev_priv(ndev);
-	u8  port = 0; /* TODO */
+	/* The Qbv interrupt is only wired up for TEMAC1 */
+	u8  port = PORT_TEMAC_1;
+	struct qbv_info *qbv = NULL;
 
 	/* clear status */
 	axienet_iow(lp, INT_CLEAR(port), 0);
 
+	spin_lock(&lp->qbv_lock);
+	if (lp->qbv_pending && !(axienet_ior(lp, PORT_STATUS(port)) &
+				 PORT_STATUS_CONFIG_PENDING)) {
+		qbv = lp->qbv_pending;
+		lp->qbv_pending = NULL;
+		axienet_qbv_write_admin(lp, qbv);
+	}
+	spin_unlock(&lp->qbv_lock);
+
+	kfree(qbv);
+
 	return IRQ_HANDLED;
 }
 
@@ -220,6 +392,8 @@ int axienet_qbv_init(struct net_device *ndev)
 	if (rc)
 		goto err_qbv_irq;
 
+	axienet_iow(lp, INT_ENABLE(PORT_TEMAC_1), INT_CONFIG_CHANGE);
+
 err_qbv_irq:
 	return rc;
 }
@@ -228,5 +402,9 @@ void axienet_qbv_remove(struct net_device *ndev)
 {
 	struct axienet_local *lp = netdev_priv(ndev);
 
+	axienet_iow(lp, INT_ENABLE(PORT_TEMAC_1), 0);
 	free_irq(lp->qbv_irq, ndev);
+
+	kfree(lp->qbv_pending);
+	lp->qbv_pending = NULL;
 }
@@ -105,6 +105,10 @@ static u32 qbv_reg_map[3] = { 0x0,   0x14000,     0x14000 };
 #define INT_ENABLE(port)			(TIME_SCHED_BASE(port) + 0x34)
 #define INT_CLEAR(port)				(TIME_SCHED_BASE(port) + 0x38)
 #define PORT_STATUS(port)			(TIME_SCHED_BASE(port) + 0x3c)
+/* Set while an admin list is waiting for its config change time */
+#define PORT_STATUS_CONFIG_PENDING		BIT(0)
+/* Raised when the admin list has become the operational list */
+#define INT_CONFIG_CHANGE			BIT(0)
 
 /* Config Change time is valid after Config Pending bit is set. */
 #define CONFIG_CHANGE_TIME_NS(port)		(TIME_SCHED_BASE((port)) + 0x40)
@@ -19,10 +19,73 @@
 #include <linux/of_platform.h>
 #include <linux/module.h>
 #include <linux/miscdevice.h>
+#include <linux/etherdevice.h>
+#include <linux/if_bridge.h>
+#include <linux/rtnetlink.h>
+#include <linux/workqueue.h>
+#include <net/switchdev.h>
 
 static struct miscdevice switch_dev;
 struct axienet_local lp;
 
+/* Serialises the CAM programming sequence */
+static DEFINE_MUTEX(cam_lock);
+
+/**
+ * struct tsn_switch_port - switchdev state of a TSN MAC port
+ * @ndev:	Port net device, NULL until the MAC driver registers it
+ * @bridge:	Bridge the port is enslaved to, NULL when standalone
+ * @fwd_port:	SDL_CAM_FWD_TO_PORT_* bit of the port
+ * @stp_state:	STP state set by the bridge, BR_STATE_*
+ */
+struct tsn_switch_port {
+	struct net_device *ndev;
+	struct net_device *bridge;
+	u8 fwd_port;
+	u8 stp_state;
+};
+
+/**
+ * struct tsn_fdb_entry - CAM line shared by the bridge FDB and Qci
+ * @list:	Entry in tsn_fdb_list
+ * @addr:	Destination MAC address
+ * @vid:	VLAN ID used as CAM key
+ * @port:	Port the address was learned or configured on, NULL when the
+ *		bridge has no FDB entry for it
+ * @stream:	The line identifies a Qci stream
+ * @gate_id:	PSFP gate of the stream
+ */
+struct tsn_fdb_entry {
+	struct list_head list;
+	u8 addr[ETH_ALEN];
+	u16 vid;
+	struct tsn_switch_port *port;
+	bool stream;
+	u8 gate_id;
+};
+
+/**
+ * struct tsn_fdb_work - deferred FDB notification
+ * @work:	Work item on tsn_switchdev_wq
+ * @ndev:	Port net device, held until the work has run
+ * @event:	SWITCHDEV_FDB_ADD_TO_DEVICE or SWITCHDEV_FDB_DEL_TO_DEVICE
+ * @addr:	Destination MAC address
+ * @vid:	VLAN ID of the bridge FDB entry
+ */
+struct tsn_fdb_work {
+	struct work_struct work;
+	struct net_device *ndev;
+	unsigned long event;
+	u8 addr[ETH_ALEN];
+	u16 vid;
+};
+
+/* Indexed by temac_no. The ports and tsn_fdb_list are protected by rtnl. */
+static struct tsn_switch_port tsn_ports[2];
+static LIST_HEAD(tsn_fdb_list);
+static struct netdev_phys_item_id tsn_switch_id;
+static struct workqueue_struct *tsn_switchdev_wq;
+
 #define ADD					1
 #define DELETE					0
 
@@ -407,6 +470,8 @@ static void add_delete_cam_entry(struct cam_struct data, u8 add)
 	u32 tv2 = 0;
 	u32 timeout = 20000;
 
+	mutex_lock(&cam_lock);
+
 	/* wait for cam init done */
 	while (!(axienet_ior(&lp, XAS_SDL_CAM_STATUS_OFFSET) &
 		SDL_CAM_WR_ENABLE) && timeout)
@@ -462,6 +527,8 @@ static void add_delete_cam_entry(struct cam_struct data, u8 add)
 
 	if (!timeout)
 		pr_warn("CAM write took longer time!!");
+
+	mutex_unlock(&cam_lock);
 }
 
 static void port_vlan_mem_ctrl(u32 port_vlan_mem)
@@ -469,6 +536,423 @@ static void port_vlan_mem_ctrl(u32 port_vlan_mem)
 		axienet_iow(&lp, XAS_VLAN_MEMB_CTRL_REG, port_vlan_mem);
 }
 
+static struct tsn_switch_port *tsn_switchdev_port(const struct net_device *ndev)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(tsn_ports); i++)
+		if (tsn_ports[i].ndev == ndev)
+			return &tsn_ports[i];
+
+	return NULL;
+}
+
+static bool tsn_switchdev_is_port(const struct net_device *ndev)
+{
+	return !!tsn_switchdev_port(ndev);
+}
+
+/* A CAM line exists for an entry while the bridge forwards to its port, or
+ * while it identifies a Qci stream. A stream whose port is blocked keeps
+ * its line with an empty port list, so the frames are still policed.
+ */
+static bool tsn_fdb_in_cam(struct tsn_fdb_entry *fdb, bool port_fwd)
+{
+	return fdb->stream || (fdb->port && port_fwd);
+}
+
+static bool tsn_fdb_port_fwd(struct tsn_fdb_entry *fdb)
+{
+	return fdb->port && fdb->port->stp_state == BR_STATE_FORWARDING;
+}
+
+static void tsn_fdb_cam_write(struct tsn_fdb_entry *fdb, u8 add)
+{
+	struct cam_struct cam = {};
+
+	ether_addr_copy(cam.dest_addr, fdb->addr);
+	cam.vlanid = fdb->vid;
+	if (!fdb->port)
+		cam.fwd_port = SDL_CAM_FWD_TO_EP;
+	else if (tsn_fdb_port_fwd(fdb))
+		cam.fwd_port = fdb->port->fwd_port;
+	cam.gate_id = fdb->gate_id;
+
+	add_delete_cam_entry(cam, add);
+}
+
+/* Rewrite the CAM line of @fdb after a change, @was tells whether the line
+ * existed before. The entry is freed once nothing refers to it any more.
+ */
+static void tsn_fdb_sync(struct tsn_fdb_entry *fdb, bool was)
+{
+	if (was)
+		tsn_fdb_cam_write(fdb, DELETE);
+	if (tsn_fdb_in_cam(fdb, tsn_fdb_port_fwd(fdb)))
+		tsn_fdb_cam_write(fdb, ADD);
+
+	if (!fdb->port && !fdb->stream) {
+		list_del(&fdb->list);
+		kfree(fdb);
+	}
+}
+
+/* The CAM is always keyed by a VLAN, untagged frames are looked up with the
+ * port VLAN ID the switch assigns to them.
+ */
+static u16 tsn_fdb_vid(u16 vid)
+{
+	if (vid)
+		return vid;
+
+	return axienet_ior(&lp, XAS_MAC_PORT_VLAN_OFFSET) & SDL_CAM_VLAN_MASK;
+}
+
+static struct tsn_fdb_entry *tsn_fdb_find(const u8 *addr, u16 vid)
+{
+	struct tsn_fdb_entry *fdb;
+
+	list_for_each_entry(fdb, &tsn_fdb_list, list)
+		if (ether_addr_equal(fdb->addr, addr) && fdb->vid == vid)
+			return fdb;
+
+	return NULL;
+}
+
+static struct tsn_fdb_entry *tsn_fdb_get(const u8 *addr, u16 vid)
+{
+	struct tsn_fdb_entry *fdb;
+
+	fdb = tsn_fdb_find(addr, vid);
+	if (fdb)
+		return fdb;
+
+	fdb = kzalloc(sizeof(*fdb), GFP_KERNEL);
+	if (!fdb)
+		return NULL;
+
+	ether_addr_copy(fdb->addr, addr);
+	fdb->vid = vid;
+	list_add_tail(&fdb->list, &tsn_fdb_list);
+
+	return fdb;
+}
+
+/* Only a forwarding port has its addresses in the CAM, so that the switch
+ * does not send frames to a port the bridge has blocked.
+ */
+static int tsn_fdb_add(struct tsn_switch_port *port, const u8 *addr, u16 vid)
+{
+	struct tsn_fdb_entry *fdb;
+	bool was;
+
+	fdb = tsn_fdb_get(addr, vid);
+	if (!fdb)
+		return -ENOMEM;
+
+	if (fdb->port == port)
+		return 0;
+
+	/* a new address, or the station has moved to the other port */
+	was = tsn_fdb_in_cam(fdb, tsn_fdb_port_fwd(fdb));
+	fdb->port = port;
+	tsn_fdb_sync(fdb, was);
+
+	return 0;
+}
+
+static void tsn_fdb_del(struct tsn_switch_port *port, const u8 *addr, u16 vid)
+{
+	struct tsn_fdb_entry *fdb;
+	bool was;
+
+	fdb = tsn_fdb_find(addr, vid);
+	if (!fdb || fdb->port != port)
+		return;
+
+	was = tsn_fdb_in_cam(fdb, tsn_fdb_port_fwd(fdb));
+	fdb->port = NULL;
+	tsn_fdb_sync(fdb, was);
+}
+
+static void tsn_fdb_flush(struct tsn_switch_port *port)
+{
+	struct tsn_fdb_entry *fdb, *tmp;
+
+	list_for_each_entry_safe(fdb, tmp, &tsn_fdb_list, list)
+		if (fdb->port == port)
+			tsn_fdb_del(port, fdb->addr, fdb->vid);
+}
+
+static void tsn_switchdev_set_stp_state(struct tsn_switch_port *port, u8 state)
+{
+	struct tsn_fdb_entry *fdb;
+	bool was_fwd = port->stp_state == BR_STATE_FORWARDING;
+	bool is_fwd = state == BR_STATE_FORWARDING;
+
+	port->stp_state = state;
+	if (was_fwd == is_fwd)
+		return;
+
+	list_for_each_entry(fdb, &tsn_fdb_list, list)
+		if (fdb->port == port)
+			tsn_fdb_sync(fdb, tsn_fdb_in_cam(fdb, was_fwd));
+}
+
+/**
+ * tsn_switch_stream_add - Tag the CAM line of a stream with a Qci gate
+ * @addr:	Destination MAC address of the stream
+ * @vid:	VLAN ID of the stream, 0 for untagged frames
+ * @gate_id:	PSFP gate the switch applies to the stream
+ *
+ * The stream keeps the forwarding the bridge has set up for its address.
+ * Without a bridge FDB entry it is forwarded to the endpoint.
+ *
+ * Return: 0 on success, -EEXIST when the stream already has a gate, or
+ * -ENOMEM.
+ */
+int tsn_switch_stream_add(const u8 *addr, u16 vid, u8 gate_id)
+{
+	struct tsn_fdb_entry *fdb;
+	bool was;
+
+	ASSERT_RTNL();
+
+	fdb = tsn_fdb_get(addr, tsn_fdb_vid(vid));
+	if (!fdb)
+		return -ENOMEM;
+
+	if (fdb->stream)
+		return -EEXIST;
+
+	was = tsn_fdb_in_cam(fdb, tsn_fdb_port_fwd(fdb));
+	fdb->stream = true;
+	fdb->gate_id = gate_id;
+	tsn_fdb_sync(fdb, was);
+
+	return 0;
+}
+
+/**
+ * tsn_switch_stream_del - Remove the Qci gate from the CAM line of a stream
+ * @addr:	Destination MAC address of the stream
+ * @vid:	VLAN ID of the stream, 0 for untagged frames
+ */
+void tsn_switch_stream_del(const u8 *addr, u16 vid)
+{
+	struct tsn_fdb_entry *fdb;
+
+	ASSERT_RTNL();
+
+	fdb = tsn_fdb_find(addr, tsn_fdb_vid(vid));
+	if (!fdb || !fdb->stream)
+		return;
+
+	fdb->stream = false;
+	fdb->gate_id = 0;
+	tsn_fdb_sync(fdb, true);
+}
+
+static void tsn_switchdev_fdb_work(struct work_struct *work)
+{
+	struct tsn_fdb_work *w = container_of(work, struct tsn_fdb_work, work);
+	struct switchdev_notifier_fdb_info info = {};
+	struct tsn_switch_port *port;
+	u16 vid = tsn_fdb_vid(w->vid);
+
+	rtnl_lock();
+	port = tsn_switchdev_port(w->ndev);
+	if (!port || !port->bridge)
+		goto out;
+
+	if (w->event == SWITCHDEV_FDB_ADD_TO_DEVICE) {
+		if (tsn_fdb_add(port, w->addr, vid))
+			goto out;
+		info.addr = w->addr;
+		info.vid = w->vid;
+		info.offloaded = 1;
+		call_switchdev_notifiers(SWITCHDEV_FDB_OFFLOADED, w->ndev,
+					 &info.info, NULL);
+	} else {
+		tsn_fdb_del(port, w->addr, vid);
+	}
+out:
+	rtnl_unlock();
+	dev_put(w->ndev);
+	kfree(w);
+}
+
+static int tsn_switchdev_attr_set(struct net_device *ndev,
+				  const struct switchdev_attr *attr,
+				  struct switchdev_trans *trans)
+{
+	struct tsn_switch_port *port = tsn_switchdev_port(ndev);
+
+	switch (attr->id) {
+	case SWITCHDEV_ATTR_ID_PORT_STP_STATE:
+		if (switchdev_trans_ph_prepare(trans))
+			return 0;
+		tsn_switchdev_set_stp_state(port, attr->u.stp_state);
+		return 0;
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+static int tsn_switchdev_event(struct notifier_block *nb,
+			       unsigned long event, void *ptr)
+{
+	struct net_device *ndev = switchdev_notifier_info_to_dev(ptr);
+	struct switchdev_notifier_fdb_info *fdb_info = ptr;
+	struct tsn_fdb_work *w;
+	int err;
+
+	switch (event) {
+	case SWITCHDEV_PORT_ATTR_SET:
+		err = switchdev_handle_port_attr_set(ndev, ptr,
+						     tsn_switchdev_is_port,
+						     tsn_switchdev_attr_set);
+		return notifier_from_errno(err);
+	case SWITCHDEV_FDB_ADD_TO_DEVICE:
+	case SWITCHDEV_FDB_DEL_TO_DEVICE:
+		if (!tsn_switchdev_is_port(ndev))
+			return NOTIFY_DONE;
+
+		/* Called in atomic context, the CAM is written from a work */
+		w = kzalloc(sizeof(*w), GFP_ATOMIC);
+		if (!w)
+			return NOTIFY_BAD;
+
+		INIT_WORK(&w->work, tsn_switchdev_fdb_work);
+		w->ndev = ndev;
+		w->event = event;
+		ether_addr_copy(w->addr, fdb_info->addr);
+		w->vid = fdb_info->vid;
+		dev_hold(ndev);
+		queue_work(tsn_switchdev_wq, &w->work);
+		return NOTIFY_OK;
+	}
+
+	return NOTIFY_DONE;
+}
+
+static struct notifier_block tsn_switchdev_nb = {
+	.notifier_call = tsn_switchdev_event,
+};
+
+static void tsn_switchdev_port_leave(struct tsn_switch_port *port)
+{
+	struct axienet_local *plp = netdev_priv(port->ndev);
+
+	tsn_fdb_flush(port);
+	port->bridge = NULL;
+	/* a standalone port is always forwarding */
+	port->stp_state = BR_STATE_FORWARDING;
+	plp->offload_fwd_mark = false;
+}
+
+static int tsn_switchdev_netdevice_event(struct notifier_block *nb,
+					 unsigned long event, void *ptr)
+{
+	struct net_device *ndev = netdev_notifier_info_to_dev(ptr);
+	struct netdev_notifier_changeupper_info *info = ptr;
+	struct tsn_switch_port *port;
+	struct axienet_local *plp;
+	int i;
+
+	if (event != NETDEV_PRECHANGEUPPER && event != NETDEV_CHANGEUPPER)
+		return NOTIFY_DONE;
+
+	port = tsn_switchdev_port(ndev);
+	if (!port || !netif_is_bridge_master(info->upper_dev))
+		return NOTIFY_DONE;
+
+	switch (event) {
+	case NETDEV_PRECHANGEUPPER:
+		if (!info->linking)
+			break;
+		/* The switch has one forwarding domain for both MAC ports */
+		for (i = 0; i < ARRAY_SIZE(tsn_ports); i++) {
+			if (tsn_ports[i].bridge &&
+			    tsn_ports[i].bridge != info->upper_dev) {
+				NL_SET_ERR_MSG_MOD(info->info.extack,
+						   "TSN ports must share a bridge");
+				return notifier_from_errno(-EOPNOTSUPP);
+			}
+		}
+		break;
+	case NETDEV_CHANGEUPPER:
+		if (info->linking) {
+			plp = netdev_priv(ndev);
+			port->bridge = info->upper_dev;
+			port->stp_state = BR_STATE_DISABLED;
+			plp->offload_fwd_mark = true;
+		} else {
+			tsn_switchdev_port_leave(port);
+		}
+		break;
+	}
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block tsn_switchdev_netdevice_nb = {
+	.notifier_call = tsn_switchdev_netdevice_event,
+};
+
+/**
+ * tsn_switchdev_port_register - Make a TSN MAC port a switchdev port
+ * @ndev:	Pointer to the MAC port net_device structure
+ *
+ * Bridge FDB entries on the port are offloaded to the CAM from then on.
+ */
+void tsn_switchdev_port_register(struct net_device *ndev)
+{
+	struct axienet_local *plp = netdev_priv(ndev);
+	struct tsn_switch_port *port = &tsn_ports[plp->temac_no];
+
+	rtnl_lock();
+	port->ndev = ndev;
+	port->bridge = NULL;
+	port->fwd_port = plp->temac_no == XAE_TEMAC1 ? SDL_CAM_FWD_TO_PORT_1 :
+						       SDL_CAM_FWD_TO_PORT_2;
+	port->stp_state = BR_STATE_FORWARDING;
+	rtnl_unlock();
+}
+
+/**
+ * tsn_switchdev_port_unregister - Stop offloading a TSN MAC port
+ * @ndev:	Pointer to the MAC port net_device structure
+ */
+void tsn_switchdev_port_unregister(struct net_device *ndev)
+{
+	struct tsn_switch_port *port;
+
+	rtnl_lock();
+	port = tsn_switchdev_port(ndev);
+	if (port) {
+		if (port->bridge)
+			tsn_switchdev_port_leave(port);
+		port->ndev = NULL;
+	}
+	rtnl_unlock();
+}
+
+/**
+ * tsn_switch_get_port_parent_id - Get the switch ID shared by the MAC ports
+ * @ppid:	Pointer to the ID to fill in
+ *
+ * Return: 0 on success, -EOPNOTSUPP when the switch is not probed.
+ */
+int tsn_switch_get_port_parent_id(struct netdev_phys_item_id *ppid)
+{
+	if (!tsn_switch_id.id_len)
+		return -EOPNOTSUPP;
+
+	*ppid = tsn_switch_id;
+	return 0;
+}
+
 static long switch_ioctl(struct file *file, unsigned int cmd,
 			 unsigned long arg)
 {
@@ -781,12 +1265,66 @@ static int tsnswitch_probe(struct platform_device *pdev)
 		return ret;
 	pr_info("TSN CAM Initializing ....\n");
 	ret = tsn_switch_cam_init(num_tc);
+	if (ret)
+		goto err_misc;
 
+	tsn_switchdev_wq = alloc_ordered_workqueue("tsn_switchdev", 0);
+	if (!tsn_switchdev_wq) {
+		ret = -ENOMEM;
+		goto err_misc;
+	}
+
+	ret = register_netdevice_notifier(&tsn_switchdev_netdevice_nb);
+	if (ret)
+		goto err_wq;
+
+	ret = register_switchdev_notifier(&tsn_switchdev_nb);
+	if (ret)
+		goto err_netdevice_nb;
+
+#if IS_ENABLED(CONFIG_XILINX_TSN_CB)
+	ret = frer_genl_register();
+	if (ret)
+		goto err_switchdev_nb;
+#endif
+
+	/* Both MAC ports report the switch registers as their parent */
+	tsn_switch_id.id_len = sizeof(swt->start);
+	memcpy(tsn_switch_id.id, &swt->start, sizeof(swt->start));
+
+	return 0;
+
+#if IS_ENABLED(CONFIG_XILINX_TSN_CB)
+err_switchdev_nb:
+	unregister_switchdev_notifier(&tsn_switchdev_nb);
+#endif
+err_netdevice_nb:
+	unregister_netdevice_notifier(&tsn_switchdev_netdevice_nb);
+err_wq:
+	destroy_workqueue(tsn_switchdev_wq);
+err_misc:
+	misc_deregister(&switch_dev);
 	return ret;
 }
 
 static int tsnswitch_remove(struct platform_device *pdev)
 {
+	int i;
+
+	tsn_switch_id.id_len = 0;
+#if IS_ENABLED(CONFIG_XILINX_TSN_CB)
+	frer_genl_unregister();
+#endif
+	unregister_switchdev_notifier(&tsn_switchdev_nb);
+	unregister_netdevice_notifier(&tsn_switchdev_netdevice_nb);
+	destroy_workqueue(tsn_switchdev_wq);
+
+	rtnl_lock();
+	for (i = 0; i < ARRAY_SIZE(tsn_ports); i++)
+		if (tsn_ports[i].bridge)
+			tsn_switchdev_port_leave(&tsn_ports[i]);
+	rtnl_unlock();
+
 	misc_deregister(&switch_dev);
 	return 0;
 }
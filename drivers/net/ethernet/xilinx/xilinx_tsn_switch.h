@@ -354,6 +354,10 @@ void get_psfp_static_counter(struct psfp_static_counter *data);
 void get_meter_reg(struct meter_config *data);
 void get_stream_filter_config(struct stream_filter *data);
 
+/********* switch CAM helpers for qci ********/
+int tsn_switch_stream_add(const u8 *addr, u16 vid, u8 gate_id);
+void tsn_switch_stream_del(const u8 *addr, u16 vid);
+
 /********* cb function declararions ********/
 void frer_control(struct frer_ctrl data);
 void get_ingress_filter_config(struct in_fltr *data);
@@ -361,4 +365,6 @@ void config_ingress_filter(struct in_fltr data);
 void get_member_reg(struct frer_memb_config *data);
 void program_member_reg(struct frer_memb_config data);
 void get_frer_static_counter(struct frer_static_counter *data);
+int frer_genl_register(void);
+void frer_genl_unregister(void);
 #endif /* XILINX_TSN_SWITCH_H */
@@ -5,6 +5,7 @@
 
 #include <linux/dma-mapping.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
 #include <linux/nvmem-provider.h>
 #include <linux/of.h>
 #include <linux/platform_device.h>
@@ -44,11 +45,33 @@ struct xilinx_efuse {
 	u32 fullmap;
 };
 
-static int zynqmp_efuse_access(void *context, unsigned int offset,
+/**
+ * struct zynqmp_nvmem_data - read cache of the firmware backed nvmem
+ * @dev:		device the nvmem is registered for
+ * @lock:		serializes firmware calls and cache updates
+ * @soc_version:	silicon revision, valid if @soc_version_cached
+ * @soc_version_cached:	@soc_version has been read
+ * @efuse:		eFUSE contents, valid if @efuse_cached
+ * @efuse_cached:	@efuse holds the whole eFUSE range
+ *
+ * The silicon revision and the eFUSEs only change through this driver, so
+ * they are read from the firmware once, the eFUSEs in a single call, and
+ * nvmem reads are then served from memory. An eFUSE write drops the eFUSE
+ * copy.
+ */
+struct zynqmp_nvmem_data {
+	struct device *dev;
+	struct mutex lock;
+	u32 soc_version;
+	bool soc_version_cached;
+	u8 efuse[EFUSE_MEMORY_SIZE];
+	bool efuse_cached;
+};
+
+static int zynqmp_efuse_access(struct device *dev, unsigned int offset,
 			       void *val, size_t bytes, unsigned int flag)
 {
 	size_t words = bytes / WORD_INBYTES;
-	struct device *dev = context;
 	dma_addr_t dma_addr, dma_buf;
 	struct xilinx_efuse *efuse;
 	char *data;
@@ -73,8 +96,7 @@ static int zynqmp_efuse_access(void *context, unsigned int offset,
 	if (!efuse)
 		return -ENOMEM;
 
-	data = dma_alloc_coherent(dev, sizeof(bytes),
-				  &dma_buf, GFP_KERNEL);
+	data = dma_alloc_coherent(dev, bytes, &dma_buf, GFP_KERNEL);
 	if (!data) {
 		dma_free_coherent(dev, sizeof(struct xilinx_efuse),
 				  efuse, dma_addr);
@@ -110,38 +132,68 @@ static int zynqmp_efuse_access(void *context, unsigned int offset,
 
 	dma_free_coherent(dev, sizeof(struct xilinx_efuse),
 			  efuse, dma_addr);
-	dma_free_coherent(dev, sizeof(bytes),
-			  data, dma_buf);
+	dma_free_coherent(dev, bytes, data, dma_buf);
 
 	return ret;
 }
 
+static int zynqmp_efuse_read(struct zynqmp_nvmem_data *priv,
+			     unsigned int offset, void *val, size_t bytes)
+{
+	int ret;
+
+	if (!priv->efuse_cached) {
+		ret = zynqmp_efuse_access(priv->dev, EFUSE_START_OFFSET,
+					  priv->efuse, EFUSE_MEMORY_SIZE,
+					  EFUSE_READ);
+		/* Firmware refusing the whole range still gets single reads */
+		if (ret)
+			return zynqmp_efuse_access(priv->dev, offset, val,
+						   bytes, EFUSE_READ);
+		priv->efuse_cached = true;
+	}
+
+	memcpy(val, priv->efuse + offset - EFUSE_START_OFFSET, bytes);
+
+	return 0;
+}
+
 static int zynqmp_nvmem_read(void *context, unsigned int offset,
 					void *val, size_t bytes)
 {
+	struct zynqmp_nvmem_data *priv = context;
 	int ret;
 	int idcode, version;
 
 	if (!eemi_ops->get_chipid)
 		return -ENXIO;
 
+	mutex_lock(&priv->lock);
+
 	switch (offset) {
 	/* Soc version offset is zero */
 	case SOC_VERSION_OFFSET:
-		if (bytes != SOC_VER_SIZE)
-			return -ENOTSUPP;
+		if (bytes != SOC_VER_SIZE) {
+			ret = -ENOTSUPP;
+			break;
+		}
 
-		ret = eemi_ops->get_chipid(&idcode, &version);
-		if (ret < 0)
-			return ret;
+		if (!priv->soc_version_cached) {
+			ret = eemi_ops->get_chipid(&idcode, &version);
+			if (ret < 0)
+				break;
 
-		pr_debug("Read chipid val %x %x\n", idcode, version);
-		*(int *)val = version & SILICON_REVISION_MASK;
+			pr_debug("Read chipid val %x %x\n", idcode, version);
+			priv->soc_version = version & SILICON_REVISION_MASK;
+			priv->soc_version_cached = true;
+		}
+
+		*(int *)val = priv->soc_version;
+		ret = 0;
 		break;
 	/* Efuse offset starts from 0xc */
 	case EFUSE_START_OFFSET ... EFUSE_END_OFFSET:
-		ret = zynqmp_efuse_access(context, offset, val,
-					  bytes, EFUSE_READ);
+		ret = zynqmp_efuse_read(priv, offset, val, bytes);
 		break;
 	default:
 		*(u32 *)val = 0xDEADBEEF;
@@ -149,18 +201,27 @@ static int zynqmp_nvmem_read(void *context, unsigned int offset,
 		break;
 	}
 
+	mutex_unlock(&priv->lock);
+
 	return ret;
 }
 
 static int zynqmp_nvmem_write(void *context,
 			      unsigned int offset, void *val, size_t bytes)
 {
+	struct zynqmp_nvmem_data *priv = context;
+	int ret;
+
 	/* Efuse offset starts from 0xc */
 	if (offset < EFUSE_START_OFFSET)
 		return -ENOTSUPP;
 
-	return(zynqmp_efuse_access(context, offset,
-				   val, bytes, EFUSE_WRITE));
+	mutex_lock(&priv->lock);
+	ret = zynqmp_efuse_access(priv->dev, offset, val, bytes, EFUSE_WRITE);
+	priv->efuse_cached = false;
+	mutex_unlock(&priv->lock);
+
+	return ret;
 }
 
 static struct nvmem_config econfig = {
@@ -178,14 +239,22 @@ MODULE_DEVICE_TABLE(of, zynqmp_nvmem_match);
 
 static int zynqmp_nvmem_probe(struct platform_device *pdev)
 {
+	struct zynqmp_nvmem_data *priv;
 	struct nvmem_device *nvmem;
 
 	eemi_ops = zynqmp_pm_get_eemi_ops();
 	if (IS_ERR(eemi_ops))
 		return PTR_ERR(eemi_ops);
 
+	priv = devm_kzalloc(&pdev->dev, sizeof(*priv), GFP_KERNEL);
+	if (!priv)
+		return -ENOMEM;
+
+	priv->dev = &pdev->dev;
+	mutex_init(&priv->lock);
+
 	econfig.dev = &pdev->dev;
-	econfig.priv = &pdev->dev;
+	econfig.priv = priv;
 	econfig.reg_read = zynqmp_nvmem_read;
 	econfig.reg_write = zynqmp_nvmem_write;
 
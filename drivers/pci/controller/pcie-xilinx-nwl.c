@@ -131,7 +131,8 @@
 
 #define CFG_DMA_REG_BAR			GENMASK(2, 0)
 
-#define INT_PCI_MSI_NR			(2 * 32)
+#define MSI_GROUP_NR			32
+#define INT_PCI_MSI_NR			(2 * MSI_GROUP_NR)
 
 /* Readin the PS_LINKUP */
 #define PS_LINKUP_OFFSET		0x00000238
@@ -343,7 +344,8 @@ static void nwl_pcie_leg_handler(struct irq_desc *desc)
 	chained_irq_exit(chip, desc);
 }
 
-static void nwl_pcie_handle_msi_irq(struct nwl_pcie *pcie, u32 status_reg)
+static void nwl_pcie_handle_msi_irq(struct nwl_pcie *pcie, u32 status_reg,
+				    u32 hwirq_base)
 {
 	struct nwl_msi *msi;
 	unsigned long status;
@@ -353,9 +355,10 @@ static void nwl_pcie_handle_msi_irq(struct nwl_pcie *pcie, u32 status_reg)
 	msi = &pcie->msi;
 
 	while ((status = nwl_bridge_readl(pcie, status_reg)) != 0) {
-		for_each_set_bit(bit, &status, 32) {
+		for_each_set_bit(bit, &status, MSI_GROUP_NR) {
 			nwl_bridge_writel(pcie, 1 << bit, status_reg);
-			virq = irq_find_mapping(msi->dev_domain, bit);
+			virq = irq_find_mapping(msi->dev_domain,
+						hwirq_base + bit);
 			if (virq)
 				generic_handle_irq(virq);
 		}
@@ -368,7 +371,7 @@ static void nwl_pcie_msi_handler_high(struct irq_desc *desc)
 	struct nwl_pcie *pcie = irq_desc_get_handler_data(desc);
 
 	chained_irq_enter(chip, desc);
-	nwl_pcie_handle_msi_irq(pcie, MSGF_MSI_STATUS_HI);
+	nwl_pcie_handle_msi_irq(pcie, MSGF_MSI_STATUS_HI, MSI_GROUP_NR);
 	chained_irq_exit(chip, desc);
 }
 
@@ -378,7 +381,7 @@ static void nwl_pcie_msi_handler_low(struct irq_desc *desc)
 	struct nwl_pcie *pcie = irq_desc_get_handler_data(desc);
 
 	chained_irq_enter(chip, desc);
-	nwl_pcie_handle_msi_irq(pcie, MSGF_MSI_STATUS_LO);
+	nwl_pcie_handle_msi_irq(pcie, MSGF_MSI_STATUS_LO, 0);
 	chained_irq_exit(chip, desc);
 }
 
@@ -448,7 +451,7 @@ static struct irq_chip nwl_msi_irq_chip = {
 
 static struct msi_domain_info nwl_msi_domain_info = {
 	.flags = (MSI_FLAG_USE_DEF_DOM_OPS | MSI_FLAG_USE_DEF_CHIP_OPS |
-		  MSI_FLAG_MULTI_PCI_MSI),
+		  MSI_FLAG_MULTI_PCI_MSI | MSI_FLAG_PCI_MSIX),
 	.chip = &nwl_msi_irq_chip,
 };
 #endif
@@ -475,6 +478,36 @@ static struct irq_chip nwl_irq_chip = {
 	.irq_set_affinity = nwl_msi_set_affinity,
 };
 
+/*
+ * Single vectors, as used by MSI-X and most multi-queue devices, go to the
+ * less loaded of the MSI groups so that the queues are spread over the msi0
+ * and msi1 lines, which are steered to different CPUs.
+ */
+static int nwl_msi_alloc_bit(struct nwl_msi *msi, unsigned int nr_irqs)
+{
+	unsigned int start, lo, bit;
+
+	if (nr_irqs > 1)
+		return bitmap_find_free_region(msi->bitmap, INT_PCI_MSI_NR,
+					       get_count_order(nr_irqs));
+
+	lo = bitmap_weight(msi->bitmap, MSI_GROUP_NR);
+	start = (bitmap_weight(msi->bitmap, INT_PCI_MSI_NR) - lo < lo) ?
+		MSI_GROUP_NR : 0;
+
+	bit = find_next_zero_bit(msi->bitmap, start + MSI_GROUP_NR, start);
+	if (bit >= start + MSI_GROUP_NR) {
+		start = MSI_GROUP_NR - start;
+		bit = find_next_zero_bit(msi->bitmap, start + MSI_GROUP_NR,
+					 start);
+		if (bit >= start + MSI_GROUP_NR)
+			return -ENOSPC;
+	}
+
+	set_bit(bit, msi->bitmap);
+	return bit;
+}
+
 static int nwl_irq_domain_alloc(struct irq_domain *domain, unsigned int virq,
 				unsigned int nr_irqs, void *args)
 {
@@ -484,8 +517,7 @@ static int nwl_irq_domain_alloc(struct irq_domain *domain, unsigned int virq,
 	int i;
 
 	mutex_lock(&msi->lock);
-	bit = bitmap_find_free_region(msi->bitmap, INT_PCI_MSI_NR,
-				      get_count_order(nr_irqs));
+	bit = nwl_msi_alloc_bit(msi, nr_irqs);
 	if (bit < 0) {
 		mutex_unlock(&msi->lock);
 		return -ENOSPC;
@@ -576,6 +608,7 @@ static int nwl_pcie_enable_msi(struct nwl_pcie *pcie)
 	struct platform_device *pdev = to_platform_device(dev);
 	struct nwl_msi *msi = &pcie->msi;
 	unsigned long base;
+	unsigned int cpu;
 	int ret;
 	int size = BITS_TO_LONGS(INT_PCI_MSI_NR) * sizeof(long);
 
@@ -607,6 +640,11 @@ static int nwl_pcie_enable_msi(struct nwl_pcie *pcie)
 	irq_set_chained_handler_and_data(msi->irq_msi0,
 					 nwl_pcie_msi_handler_low, pcie);
 
+	/* Demux the two MSI groups on different CPUs when possible */
+	cpu = cpumask_next(cpumask_first(cpu_online_mask), cpu_online_mask);
+	if (cpu < nr_cpu_ids)
+		irq_set_affinity(msi->irq_msi1, cpumask_of(cpu));
+
 	/* Check for msii_present bit */
 	ret = nwl_bridge_readl(pcie, I_MSII_CAPABILITIES) & MSII_PRESENT;
 	if (!ret) {
@@ -821,6 +859,7 @@ static int nwl_pcie_probe(struct platform_device *pdev)
 	struct pci_bus *bus;
 	struct pci_bus *child;
 	struct pci_host_bridge *bridge;
+	struct resource_entry *win;
 	int err;
 	resource_size_t iobase = 0;
 	LIST_HEAD(res);
@@ -858,6 +897,20 @@ static int nwl_pcie_probe(struct platform_device *pdev)
 		return err;
 	}
 
+	/*
+	 * The egress translation apertures are left disabled, so AXI addresses
+	 * reach the link untranslated and every memory window, including
+	 * 64-bit prefetchable ones, has to be identity mapped.
+	 */
+	resource_list_for_each_entry(win, &res) {
+		if (resource_type(win->res) == IORESOURCE_MEM && win->offset) {
+			dev_err(dev, "window %pR is not identity mapped\n",
+				win->res);
+			err = -EINVAL;
+			goto error;
+		}
+	}
+
 	err = devm_request_pci_bus_resources(dev, &res);
 	if (err)
 		goto error;
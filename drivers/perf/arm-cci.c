@@ -1661,7 +1661,7 @@ static int cci_pmu_probe(struct platform_device *pdev)
 	 */
 	cci_pmu->nr_irqs = 0;
 	for (i = 0; i < CCI_PMU_MAX_HW_CNTRS(cci_pmu->model); i++) {
-		irq = platform_get_irq(pdev, i);
+		irq = platform_get_irq_optional(pdev, i);
 		if (irq < 0)
 			break;
 
@@ -1673,9 +1673,10 @@ static int cci_pmu_probe(struct platform_device *pdev)
 
 	/*
 	 * Ensure that the device tree has as many interrupts as the number
-	 * of counters.
+	 * of counters, or a single one when the counters share a combined
+	 * overflow interrupt, as on ZynqMP.
 	 */
-	if (i < CCI_PMU_MAX_HW_CNTRS(cci_pmu->model)) {
+	if (i != 1 && i < CCI_PMU_MAX_HW_CNTRS(cci_pmu->model)) {
 		dev_warn(&pdev->dev, "In-correct number of interrupts: %d, should be %d\n",
 			i, CCI_PMU_MAX_HW_CNTRS(cci_pmu->model));
 		return -EINVAL;
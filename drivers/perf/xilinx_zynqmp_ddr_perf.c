@@ -0,0 +1,485 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Xilinx ZynqMP DDR performance monitor
+ *
+ * The DDR controller of ZynqMP has no event counters of its own. Its six AXI
+ * ports are watched by a hardened AXI Performance Monitor (APM) in the FPD,
+ * with one monitor slot per port:
+ *
+ *   port 0:	RPU and LPD masters
+ *   port 1, 2:	CCI-400, i.e. the APU and the coherent masters
+ *   port 3:	DisplayPort and S_AXI_HP0_FPD
+ *   port 4:	S_AXI_HP1_FPD and S_AXI_HP2_FPD
+ *   port 5:	S_AXI_HP3_FPD and FPD DMA
+ *
+ * This driver exposes that monitor as the zynqmp_ddr<n> uncore PMU. An event
+ * is an APM metric and the DDR port it applies to, so that for instance
+ *
+ *   perf stat -a -e zynqmp_ddr0/read-bytes,port=1/ \
+ *		  -e zynqmp_ddr0/read-bytes,port=3/ -- sleep 1
+ *
+ * compares the DDR read traffic of the APU to the one of the PL through HP0.
+ * The cycles event counts the global clock counter of the monitor.
+ *
+ * The counters are 32bit and free running. The PMU only accumulates deltas
+ * and a 100ms hrtimer folds them in before they can wrap.
+ *
+ * The monitor is described with "xlnx,zynqmp-ddr-pmu" in place of
+ * "xlnx,axi-perf-monitor", which binds it to the UIO driver instead.
+ */
+
+#include <linux/hrtimer.h>
+#include <linux/idr.h>
+#include <linux/io.h>
+#include <linux/module.h>
+#include <linux/of.h>
+#include <linux/perf_event.h>
+#include <linux/platform_device.h>
+
+#define ZYNQMP_DDR_APM_GCC_LSW		0x0004 /* Global clock counter */
+#define ZYNQMP_DDR_APM_MSR(n)		(0x0044 + ((n) / 4) * 4)
+#define ZYNQMP_DDR_APM_MC(n)		(0x0100 + (n) * 0x10)
+#define ZYNQMP_DDR_APM_CTL		0x0300
+#define ZYNQMP_DDR_APM_CTL_MCNTR_EN	BIT(0)
+#define ZYNQMP_DDR_APM_CTL_GCC_EN	BIT(16)
+#define ZYNQMP_DDR_APM_MSR_FIELD_WIDTH	8
+
+#define ZYNQMP_DDR_NUM_COUNTERS		10
+#define ZYNQMP_DDR_CYCLES_COUNTER	ZYNQMP_DDR_NUM_COUNTERS
+#define ZYNQMP_DDR_NUM_PORTS		6
+#define ZYNQMP_DDR_MAX_METRIC		0x0b
+#define ZYNQMP_DDR_CYCLES_ID		0x1f
+#define ZYNQMP_DDR_EVENT_MASK		GENMASK(4, 0)
+#define ZYNQMP_DDR_PORT_SHIFT		5
+#define ZYNQMP_DDR_PORT_MASK		GENMASK(2, 0)
+#define ZYNQMP_DDR_POLL_PERIOD_NS	(100 * NSEC_PER_MSEC)
+
+#define ZYNQMP_DDR_PERF_DEV_NAME	"zynqmp_ddr"
+#define ZYNQMP_DDR_CPUHP_CB_NAME	ZYNQMP_DDR_PERF_DEV_NAME "_perf_pmu"
+
+#define to_zynqmp_ddr_pmu(p)	container_of(p, struct zynqmp_ddr_pmu, pmu)
+
+static DEFINE_IDA(zynqmp_ddr_ida);
+
+/**
+ * struct zynqmp_ddr_pmu - ZynqMP DDR performance monitor
+ * @pmu: perf PMU
+ * @base: Base address of the APM registers
+ * @dev: Device of the monitor
+ * @events: perf events bound to the metric counters and the clock counter
+ * @hrtimer: Timer folding the counters before they wrap
+ * @node: CPU hotplug instance
+ * @cpuhp_state: CPU hotplug state
+ * @num_active: Number of counters in use
+ * @cpu: CPU the perf events are bound to
+ * @id: Instance number of the PMU
+ */
+struct zynqmp_ddr_pmu {
+	struct pmu pmu;
+	void __iomem *base;
+	struct device *dev;
+	struct perf_event *events[ZYNQMP_DDR_NUM_COUNTERS + 1];
+	struct hrtimer hrtimer;
+	struct hlist_node node;
+	enum cpuhp_state cpuhp_state;
+	unsigned int num_active;
+	unsigned int cpu;
+	int id;
+};
+
+static ssize_t zynqmp_ddr_perf_cpumask_show(struct device *dev,
+					    struct device_attribute *attr,
+					    char *buf)
+{
+	struct zynqmp_ddr_pmu *pmu = dev_get_drvdata(dev);
+
+	return cpumap_print_to_pagebuf(true, buf, cpumask_of(pmu->cpu));
+}
+
+static struct device_attribute zynqmp_ddr_perf_cpumask_attr =
+	__ATTR(cpumask, 0444, zynqmp_ddr_perf_cpumask_show, NULL);
+
+static struct attribute *zynqmp_ddr_perf_cpumask_attrs[] = {
+	&zynqmp_ddr_perf_cpumask_attr.attr,
+	NULL,
+};
+
+static struct attribute_group zynqmp_ddr_perf_cpumask_attr_group = {
+	.attrs = zynqmp_ddr_perf_cpumask_attrs,
+};
+
+static ssize_t zynqmp_ddr_perf_event_show(struct device *dev,
+					  struct device_attribute *attr,
+					  char *page)
+{
+	struct perf_pmu_events_attr *pmu_attr;
+
+	pmu_attr = container_of(attr, struct perf_pmu_events_attr, attr);
+	return sprintf(page, "event=0x%02llx\n", pmu_attr->id);
+}
+
+#define ZYNQMP_DDR_PMU_EVENT_ATTR(_name, _id)				\
+	(&((struct perf_pmu_events_attr[]) {				\
+		{ .attr = __ATTR(_name, 0444, zynqmp_ddr_perf_event_show,\
+				 NULL),					\
+		  .id = _id, }						\
+	})[0].attr.attr)
+
+static struct attribute *zynqmp_ddr_perf_events_attrs[] = {
+	ZYNQMP_DDR_PMU_EVENT_ATTR(write-transactions, 0x00),
+	ZYNQMP_DDR_PMU_EVENT_ATTR(read-transactions, 0x01),
+	ZYNQMP_DDR_PMU_EVENT_ATTR(write-bytes, 0x02),
+	ZYNQMP_DDR_PMU_EVENT_ATTR(read-bytes, 0x03),
+	ZYNQMP_DDR_PMU_EVENT_ATTR(write-beats, 0x04),
+	ZYNQMP_DDR_PMU_EVENT_ATTR(read-latency, 0x05),
+	ZYNQMP_DDR_PMU_EVENT_ATTR(write-latency, 0x06),
+	ZYNQMP_DDR_PMU_EVENT_ATTR(write-idle-cycles, 0x07),
+	ZYNQMP_DDR_PMU_EVENT_ATTR(read-idle-cycles, 0x08),
+	ZYNQMP_DDR_PMU_EVENT_ATTR(write-responses, 0x09),
+	ZYNQMP_DDR_PMU_EVENT_ATTR(write-lasts, 0x0a),
+	ZYNQMP_DDR_PMU_EVENT_ATTR(read-lasts, 0x0b),
+	ZYNQMP_DDR_PMU_EVENT_ATTR(cycles, ZYNQMP_DDR_CYCLES_ID),
+	NULL,
+};
+
+static struct attribute_group zynqmp_ddr_perf_events_attr_group = {
+	.name = "events",
+	.attrs = zynqmp_ddr_perf_events_attrs,
+};
+
+PMU_FORMAT_ATTR(event, "config:0-4");
+PMU_FORMAT_ATTR(port, "config:5-7");
+
+static struct attribute *zynqmp_ddr_perf_format_attrs[] = {
+	&format_attr_event.attr,
+	&format_attr_port.attr,
+	NULL,
+};
+
+static struct attribute_group zynqmp_ddr_perf_format_attr_group = {
+	.name = "format",
+	.attrs = zynqmp_ddr_perf_format_attrs,
+};
+
+static const struct attribute_group *zynqmp_ddr_perf_attr_groups[] = {
+	&zynqmp_ddr_perf_events_attr_group,
+	&zynqmp_ddr_perf_format_attr_group,
+	&zynqmp_ddr_perf_cpumask_attr_group,
+	NULL,
+};
+
+static u32 zynqmp_ddr_perf_read_counter(struct zynqmp_ddr_pmu *pmu,
+					int counter)
+{
+	if (counter == ZYNQMP_DDR_CYCLES_COUNTER)
+		return readl(pmu->base + ZYNQMP_DDR_APM_GCC_LSW);
+
+	return readl(pmu->base + ZYNQMP_DDR_APM_MC(counter));
+}
+
+/**
+ * zynqmp_ddr_perf_event_update - Accumulate the counter delta into an event
+ * @event: perf event
+ */
+static void zynqmp_ddr_perf_event_update(struct perf_event *event)
+{
+	struct zynqmp_ddr_pmu *pmu = to_zynqmp_ddr_pmu(event->pmu);
+	struct hw_perf_event *hwc = &event->hw;
+	u64 prev, now;
+
+	do {
+		prev = local64_read(&hwc->prev_count);
+		now = zynqmp_ddr_perf_read_counter(pmu, hwc->idx);
+	} while (local64_cmpxchg(&hwc->prev_count, prev, now) != prev);
+
+	local64_add((now - prev) & 0xffffffff, &event->count);
+}
+
+static int zynqmp_ddr_perf_event_init(struct perf_event *event)
+{
+	struct zynqmp_ddr_pmu *pmu = to_zynqmp_ddr_pmu(event->pmu);
+	struct perf_event *sibling;
+	u32 metric, port;
+
+	if (event->attr.type != event->pmu->type)
+		return -ENOENT;
+
+	/* There is no CPU context to sample on an interconnect counter */
+	if (is_sampling_event(event) || event->attach_state & PERF_ATTACH_TASK)
+		return -EOPNOTSUPP;
+
+	if (event->cpu < 0) {
+		dev_warn(pmu->dev, "Can't provide per-task data!\n");
+		return -EOPNOTSUPP;
+	}
+
+	metric = event->attr.config & ZYNQMP_DDR_EVENT_MASK;
+	port = (event->attr.config >> ZYNQMP_DDR_PORT_SHIFT) &
+	       ZYNQMP_DDR_PORT_MASK;
+	if (event->attr.config & ~GENMASK(7, 0) ||
+	    port >= ZYNQMP_DDR_NUM_PORTS ||
+	    (metric > ZYNQMP_DDR_MAX_METRIC && metric != ZYNQMP_DDR_CYCLES_ID))
+		return -EINVAL;
+
+	if (event->group_leader->pmu != event->pmu &&
+	    !is_software_event(event->group_leader))
+		return -EINVAL;
+
+	for_each_sibling_event(sibling, event->group_leader) {
+		if (sibling->pmu != event->pmu && !is_software_event(sibling))
+			return -EINVAL;
+	}
+
+	event->cpu = pmu->cpu;
+	event->hw.idx = -1;
+
+	return 0;
+}
+
+static void zynqmp_ddr_perf_event_start(struct perf_event *event, int flags)
+{
+	struct zynqmp_ddr_pmu *pmu = to_zynqmp_ddr_pmu(event->pmu);
+	struct hw_perf_event *hwc = &event->hw;
+
+	local64_set(&hwc->prev_count,
+		    zynqmp_ddr_perf_read_counter(pmu, hwc->idx));
+	hwc->state = 0;
+}
+
+static void zynqmp_ddr_perf_event_stop(struct perf_event *event, int flags)
+{
+	struct hw_perf_event *hwc = &event->hw;
+
+	if (hwc->state & PERF_HES_STOPPED)
+		return;
+
+	zynqmp_ddr_perf_event_update(event);
+	hwc->state |= PERF_HES_STOPPED | PERF_HES_UPTODATE;
+}
+
+/**
+ * zynqmp_ddr_perf_alloc_counter - Pick a free counter for an event
+ * @pmu: DDR PMU
+ * @config: Event configuration
+ *
+ * The cycles event always uses the global clock counter, the metrics share
+ * the metric counters.
+ *
+ * Return: the counter index, or -EAGAIN when none is free.
+ */
+static int zynqmp_ddr_perf_alloc_counter(struct zynqmp_ddr_pmu *pmu,
+					 u64 config)
+{
+	int i;
+
+	if ((config & ZYNQMP_DDR_EVENT_MASK) == ZYNQMP_DDR_CYCLES_ID) {
+		if (pmu->events[ZYNQMP_DDR_CYCLES_COUNTER])
+			return -EAGAIN;
+		return ZYNQMP_DDR_CYCLES_COUNTER;
+	}
+
+	for (i = 0; i < ZYNQMP_DDR_NUM_COUNTERS; i++)
+		if (!pmu->events[i])
+			return i;
+
+	return -EAGAIN;
+}
+
+static int zynqmp_ddr_perf_event_add(struct perf_event *event, int flags)
+{
+	struct zynqmp_ddr_pmu *pmu = to_zynqmp_ddr_pmu(event->pmu);
+	struct hw_perf_event *hwc = &event->hw;
+	u32 shift, msr;
+	int counter;
+
+	counter = zynqmp_ddr_perf_alloc_counter(pmu, event->attr.config);
+	if (counter < 0) {
+		dev_dbg(pmu->dev, "There are not enough counters\n");
+		return counter;
+	}
+
+	if (counter != ZYNQMP_DDR_CYCLES_COUNTER) {
+		shift = (counter % 4) * ZYNQMP_DDR_APM_MSR_FIELD_WIDTH;
+		msr = readl(pmu->base + ZYNQMP_DDR_APM_MSR(counter));
+		msr &= ~(GENMASK(ZYNQMP_DDR_APM_MSR_FIELD_WIDTH - 1, 0) <<
+			 shift);
+		msr |= (event->attr.config & GENMASK(7, 0)) << shift;
+		writel(msr, pmu->base + ZYNQMP_DDR_APM_MSR(counter));
+	}
+
+	pmu->events[counter] = event;
+	hwc->idx = counter;
+	hwc->state = PERF_HES_STOPPED | PERF_HES_UPTODATE;
+
+	if (flags & PERF_EF_START)
+		zynqmp_ddr_perf_event_start(event, flags);
+
+	if (!pmu->num_active++)
+		hrtimer_start(&pmu->hrtimer,
+			      ns_to_ktime(ZYNQMP_DDR_POLL_PERIOD_NS),
+			      HRTIMER_MODE_REL_PINNED);
+
+	return 0;
+}
+
+static void zynqmp_ddr_perf_event_del(struct perf_event *event, int flags)
+{
+	struct zynqmp_ddr_pmu *pmu = to_zynqmp_ddr_pmu(event->pmu);
+	struct hw_perf_event *hwc = &event->hw;
+
+	zynqmp_ddr_perf_event_stop(event, PERF_EF_UPDATE);
+
+	if (!--pmu->num_active)
+		hrtimer_cancel(&pmu->hrtimer);
+
+	pmu->events[hwc->idx] = NULL;
+	hwc->idx = -1;
+}
+
+static enum hrtimer_restart zynqmp_ddr_perf_poll(struct hrtimer *hrtimer)
+{
+	struct zynqmp_ddr_pmu *pmu = container_of(hrtimer,
+						  struct zynqmp_ddr_pmu,
+						  hrtimer);
+	unsigned long flags;
+	int i;
+
+	local_irq_save(flags);
+	for (i = 0; i <= ZYNQMP_DDR_CYCLES_COUNTER; i++) {
+		struct perf_event *event = pmu->events[i];
+
+		if (event && !(event->hw.state & PERF_HES_STOPPED))
+			zynqmp_ddr_perf_event_update(event);
+	}
+	local_irq_restore(flags);
+
+	hrtimer_forward_now(hrtimer, ns_to_ktime(ZYNQMP_DDR_POLL_PERIOD_NS));
+
+	return HRTIMER_RESTART;
+}
+
+static int zynqmp_ddr_perf_offline_cpu(unsigned int cpu,
+				       struct hlist_node *node)
+{
+	struct zynqmp_ddr_pmu *pmu = hlist_entry_safe(node,
+						      struct zynqmp_ddr_pmu,
+						      node);
+	int target;
+
+	if (cpu != pmu->cpu)
+		return 0;
+
+	target = cpumask_any_but(cpu_online_mask, cpu);
+	if (target >= nr_cpu_ids)
+		return 0;
+
+	perf_pmu_migrate_context(&pmu->pmu, cpu, target);
+	pmu->cpu = target;
+
+	return 0;
+}
+
+static int zynqmp_ddr_perf_probe(struct platform_device *pdev)
+{
+	struct zynqmp_ddr_pmu *pmu;
+	char *name;
+	int ret;
+
+	pmu = devm_kzalloc(&pdev->dev, sizeof(*pmu), GFP_KERNEL);
+	if (!pmu)
+		return -ENOMEM;
+
+	pmu->base = devm_platform_ioremap_resource(pdev, 0);
+	if (IS_ERR(pmu->base))
+		return PTR_ERR(pmu->base);
+
+	pmu->dev = &pdev->dev;
+	pmu->pmu = (struct pmu) {
+		.module = THIS_MODULE,
+		.capabilities = PERF_PMU_CAP_NO_EXCLUDE,
+		.task_ctx_nr = perf_invalid_context,
+		.attr_groups = zynqmp_ddr_perf_attr_groups,
+		.event_init = zynqmp_ddr_perf_event_init,
+		.add = zynqmp_ddr_perf_event_add,
+		.del = zynqmp_ddr_perf_event_del,
+		.start = zynqmp_ddr_perf_event_start,
+		.stop = zynqmp_ddr_perf_event_stop,
+		.read = zynqmp_ddr_perf_event_update,
+	};
+	platform_set_drvdata(pdev, pmu);
+
+	pmu->id = ida_simple_get(&zynqmp_ddr_ida, 0, 0, GFP_KERNEL);
+	if (pmu->id < 0)
+		return pmu->id;
+
+	name = devm_kasprintf(&pdev->dev, GFP_KERNEL,
+			      ZYNQMP_DDR_PERF_DEV_NAME "%d", pmu->id);
+	if (!name) {
+		ret = -ENOMEM;
+		goto err_ida;
+	}
+
+	hrtimer_init(&pmu->hrtimer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	pmu->hrtimer.function = zynqmp_ddr_perf_poll;
+
+	/* The counters run freely, perf only ever looks at their deltas */
+	writel(readl(pmu->base + ZYNQMP_DDR_APM_CTL) |
+	       ZYNQMP_DDR_APM_CTL_MCNTR_EN | ZYNQMP_DDR_APM_CTL_GCC_EN,
+	       pmu->base + ZYNQMP_DDR_APM_CTL);
+
+	pmu->cpu = raw_smp_processor_id();
+	ret = cpuhp_setup_state_multi(CPUHP_AP_ONLINE_DYN,
+				      ZYNQMP_DDR_CPUHP_CB_NAME, NULL,
+				      zynqmp_ddr_perf_offline_cpu);
+	if (ret < 0) {
+		dev_err(&pdev->dev, "cpuhp_setup_state_multi failed\n");
+		goto err_ida;
+	}
+	pmu->cpuhp_state = ret;
+
+	cpuhp_state_add_instance_nocalls(pmu->cpuhp_state, &pmu->node);
+
+	ret = perf_pmu_register(&pmu->pmu, name, -1);
+	if (ret)
+		goto err_cpuhp;
+
+	return 0;
+
+err_cpuhp:
+	cpuhp_state_remove_instance_nocalls(pmu->cpuhp_state, &pmu->node);
+err_ida:
+	ida_simple_remove(&zynqmp_ddr_ida, pmu->id);
+	dev_warn(&pdev->dev, "ZynqMP DDR perf PMU failed (%d), disabled\n",
+		 ret);
+	return ret;
+}
+
+static int zynqmp_ddr_perf_remove(struct platform_device *pdev)
+{
+	struct zynqmp_ddr_pmu *pmu = platform_get_drvdata(pdev);
+
+	cpuhp_state_remove_instance_nocalls(pmu->cpuhp_state, &pmu->node);
+	perf_pmu_unregister(&pmu->pmu);
+	ida_simple_remove(&zynqmp_ddr_ida, pmu->id);
+
+	return 0;
+}
+
+static const struct of_device_id zynqmp_ddr_perf_of_match[] = {
+	{ .compatible = "xlnx,zynqmp-ddr-pmu", },
+	{ /* sentinel */ }
+};
+MODULE_DEVICE_TABLE(of, zynqmp_ddr_perf_of_match);
+
+static struct platform_driver zynqmp_ddr_perf_driver = {
+	.driver = {
+		.name = "zynqmp-ddr-pmu",
+		.of_match_table = zynqmp_ddr_perf_of_match,
+	},
+	.probe = zynqmp_ddr_perf_probe,
+	.remove = zynqmp_ddr_perf_remove,
+};
+module_platform_driver(zynqmp_ddr_perf_driver);
+
+MODULE_DESCRIPTION("Xilinx ZynqMP DDR performance monitor PMU");
+MODULE_LICENSE("GPL v2");
@@ -15,6 +15,7 @@
 #include <linux/clk.h>
 #include <linux/delay.h>
 #include <linux/io.h>
+#include <linux/iopoll.h>
 #include <linux/kernel.h>
 #include <linux/module.h>
 #include <linux/of.h>
@@ -63,6 +64,8 @@
 #define L0_PLL_STATUS_READ_1		0x23E4
 #define PLL_STATUS_READ_OFFSET		0x4000
 #define PLL_STATUS_LOCKED		0x10
+#define PLL_LOCK_POLL_US		10
+#define PLL_LOCK_TIMEOUT_US		1000
 
 #define L0_PLL_SS_STEP_SIZE_0_LSB	0x2370
 #define L0_PLL_SS_STEP_SIZE_1		0x2374
@@ -266,6 +269,8 @@ static struct xpsgtr_ssc ssc_lookup[] = {
  * @gtr_mutex: mutex for locking
  * @phys: pointer to all the lanes
  * @tx_term_fix: fix for GT issue
+ * @calibrated: the TX termination calibration of the fix was done
+ * @calib_nsw: NMOS code found by the TX termination calibration
  * @saved_icm_cfg0: stored value of ICM CFG0 register
  * @saved_icm_cfg1: stored value of ICM CFG1 register
  * @sata_rst: a reset control for SATA
@@ -288,6 +293,8 @@ struct xpsgtr_dev {
 	struct mutex gtr_mutex; /* mutex for locking */
 	struct xpsgtr_phy **phys;
 	bool tx_term_fix;
+	bool calibrated;
+	u32 calib_nsw;
 	unsigned int saved_icm_cfg0;
 	unsigned int saved_icm_cfg1;
 	struct reset_control *sata_rst;
@@ -763,32 +770,32 @@ int xpsgtr_usb_crst_release(struct phy *phy)
 }
 EXPORT_SYMBOL(xpsgtr_usb_crst_release);
 
+/**
+ * xpsgtr_wait_pll_lock - wait for the PLL of a lane to lock
+ * @phy: pointer to phy
+ *
+ * This sleeps and only reads the status of the lane, so it is called without
+ * gtr_mutex and the PLLs of lanes initialized concurrently lock in parallel.
+ *
+ * Return: 0 on success or -ETIMEDOUT
+ */
 int xpsgtr_wait_pll_lock(struct phy *phy)
 {
 	struct xpsgtr_phy *gtr_phy = phy_get_drvdata(phy);
 	struct xpsgtr_dev *gtr_dev = gtr_phy->data;
 	u32 offset, reg;
-	u32 timeout = 1000;
-	int ret = 0;
+	int ret;
 
 	/* Check pll is locked */
 	offset = gtr_phy->lane * PLL_STATUS_READ_OFFSET + L0_PLL_STATUS_READ_1;
 	dev_dbg(gtr_dev->dev, "Waiting for PLL lock...\n");
 
-	do {
-		reg = readl(gtr_dev->serdes + offset);
-		if ((reg & PLL_STATUS_LOCKED) == PLL_STATUS_LOCKED)
-			break;
-
-		if (!--timeout) {
-			dev_err(gtr_dev->dev, "PLL lock time out\n");
-			ret = -ETIMEDOUT;
-			break;
-		}
-		udelay(1);
-	} while (1);
-
-	if (ret == 0)
+	ret = readl_poll_timeout(gtr_dev->serdes + offset, reg,
+				 reg & PLL_STATUS_LOCKED, PLL_LOCK_POLL_US,
+				 PLL_LOCK_TIMEOUT_US);
+	if (ret)
+		dev_err(gtr_dev->dev, "PLL lock time out\n");
+	else
 		gtr_phy->pll_lock = true;
 
 	dev_info(gtr_dev->dev, "Lane:%d type:%d protocol:%d pll_locked:%s\n",
@@ -966,6 +973,34 @@ static int xpsgtr_set_sgmii_pcs(struct xpsgtr_phy *gtr_phy)
 	return ret;
 }
 
+/**
+ * xpsgtr_write_calib - write the TX termination calibration code
+ * @gtr_dev: pointer to phy controller context structure
+ * @nsw: NMOS code found by the calibration
+ */
+static void xpsgtr_write_calib(struct xpsgtr_dev *gtr_dev, u32 nsw)
+{
+	u32 reg;
+
+	/* Set Test Mode reset */
+	reg = readl(gtr_dev->serdes + TM_CMN_RST);
+	reg = (reg & ~TM_CMN_RST_MASK) | TM_CMN_RST_EN;
+	writel(reg, gtr_dev->serdes + TM_CMN_RST);
+
+	/* Writing NMOS register values back [5:3] */
+	reg = nsw >> DN_CALIB_SHIFT;
+	writel(reg, gtr_dev->serdes + L3_TM_CALIB_DIG19);
+
+	/* Writing NMOS register value [2:0] */
+	reg = ((nsw & 0x7) << NSW_SHIFT) | (1 << NSW_PIPE_SHIFT);
+	writel(reg, gtr_dev->serdes + L3_TM_CALIB_DIG18);
+
+	/* Clear Test Mode reset */
+	reg = readl(gtr_dev->serdes + TM_CMN_RST);
+	reg = (reg & ~TM_CMN_RST_MASK) | TM_CMN_RST_SET;
+	writel(reg, gtr_dev->serdes + TM_CMN_RST);
+}
+
 /**
  * xpsgtr_phyinit_required - check if phy_init for the lane can be skipped
  * @gtr_phy: pointer to the phy lane
@@ -1066,27 +1101,13 @@ static int xpsgtr_phy_init(struct phy *phy)
 
 		/* Reading NMOS Register Code */
 		nsw = readl(gtr_dev->serdes + L0_TXPMA_ST_3);
-
-		/* Set Test Mode reset */
-		reg = readl(gtr_dev->serdes + TM_CMN_RST);
-		reg = (reg & ~TM_CMN_RST_MASK) | TM_CMN_RST_EN;
-		writel(reg, gtr_dev->serdes + TM_CMN_RST);
-
 		nsw = nsw & DN_CALIB_CODE;
 
-		/* Writing NMOS register values back [5:3] */
-		reg = nsw >> DN_CALIB_SHIFT;
-		writel(reg, gtr_dev->serdes + L3_TM_CALIB_DIG19);
-
-		/* Writing NMOS register value [2:0] */
-		reg = ((nsw & 0x7) << NSW_SHIFT) | (1 << NSW_PIPE_SHIFT);
-		writel(reg, gtr_dev->serdes + L3_TM_CALIB_DIG18);
-
-		/* Clear Test Mode reset */
-		reg = readl(gtr_dev->serdes + TM_CMN_RST);
-		reg = (reg & ~TM_CMN_RST_MASK) | TM_CMN_RST_SET;
-		writel(reg, gtr_dev->serdes + TM_CMN_RST);
+		xpsgtr_write_calib(gtr_dev, nsw);
 
+		/* Keep the code to restore it on resume */
+		gtr_dev->calib_nsw = nsw;
+		gtr_dev->calibrated = true;
 		gtr_dev->tx_term_fix = false;
 	}
 
@@ -1111,10 +1132,14 @@ static int xpsgtr_phy_init(struct phy *phy)
 	}
 
 	/* Wait till pll is locked for all protocols except DP. For DP
-	 * pll locking function will be called from driver.
+	 * pll locking function will be called from driver, once all its
+	 * lanes are initialized. The wait only polls this lane, let the
+	 * other lanes be initialized meanwhile.
 	 */
 	if (gtr_phy->protocol != ICM_PROTOCOL_DP) {
+		mutex_unlock(&gtr_dev->gtr_mutex);
 		ret = xpsgtr_wait_pll_lock(phy);
+		mutex_lock(&gtr_dev->gtr_mutex);
 		if (ret != 0)
 			goto out;
 	} else {
@@ -1552,6 +1577,17 @@ static int xpsgtr_resume(struct device *dev)
 		gtr_phy->skip_phy_init = skip_phy_init;
 	}
 
+	/*
+	 * The GT lost its configuration, restore the TX termination code
+	 * found at boot instead of calibrating again: the code does not
+	 * change and the calibration needs the common block in reset.
+	 */
+	if (!skip_phy_init && gtr_dev->calibrated) {
+		mutex_lock(&gtr_dev->gtr_mutex);
+		xpsgtr_write_calib(gtr_dev, gtr_dev->calib_nsw);
+		mutex_unlock(&gtr_dev->gtr_mutex);
+	}
+
 	return 0;
 }
 
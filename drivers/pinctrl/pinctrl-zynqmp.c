@@ -48,6 +48,23 @@ struct zynqmp_pmux_function {
 	unsigned int ngroups;
 };
 
+/**
+ * struct zynqmp_pin_cache - pin settings last programmed into firmware
+ * @function:		Mux function, valid if @function_valid
+ * @function_valid:	@function is known
+ * @config:		Values of the PM_PINCTRL_CONFIG_* parameters
+ * @config_valid:	Bitmask of the known @config values
+ *
+ * Pin state switches mostly reapply the settings a pin already has, so
+ * the firmware is only called for the ones that change.
+ */
+struct zynqmp_pin_cache {
+	u32 function;
+	bool function_valid;
+	u32 config[PM_PINCTRL_CONFIG_MAX];
+	unsigned long config_valid;
+};
+
 /**
  * struct zynqmp_pinctrl - driver data
  * @pctrl:	Pinctrl device
@@ -55,6 +72,7 @@ struct zynqmp_pmux_function {
  * @ngroups:	Number of @groups
  * @funcs:	Pinmux functions
  * @nfuncs:	Number of @funcs
+ * @pin_cache:	Per pin settings last programmed into firmware
  *
  * This struct is stored as driver data and used to retrieve
  * information regarding pin control functions, groups and
@@ -66,6 +84,7 @@ struct zynqmp_pinctrl {
 	unsigned int ngroups;
 	const struct zynqmp_pmux_function *funcs;
 	unsigned int nfuncs;
+	struct zynqmp_pin_cache *pin_cache;
 };
 
 /**
@@ -110,6 +129,69 @@ pin_config_item zynqmp_conf_items[ARRAY_SIZE(zynqmp_dt_params)] = {
 static const struct zynqmp_eemi_ops *eemi_ops;
 static struct pinctrl_desc zynqmp_desc;
 
+static int zynqmp_pinctrl_set_function(struct zynqmp_pinctrl *pctrl,
+				       unsigned int pin, u32 function)
+{
+	struct zynqmp_pin_cache *cache = &pctrl->pin_cache[pin];
+	int ret;
+
+	if (cache->function_valid && cache->function == function)
+		return 0;
+
+	ret = eemi_ops->pinctrl_set_function(pin, function);
+	cache->function = function;
+	cache->function_valid = !ret;
+
+	return ret;
+}
+
+static int zynqmp_pinctrl_set_config(struct zynqmp_pinctrl *pctrl,
+				     unsigned int pin, u32 param, u32 value)
+{
+	struct zynqmp_pin_cache *cache = &pctrl->pin_cache[pin];
+	int ret;
+
+	if (test_bit(param, &cache->config_valid) &&
+	    cache->config[param] == value)
+		return 0;
+
+	ret = zynqmp_pinctrl_set_config(pctrl, pin, param, value);
+	cache->config[param] = value;
+	if (ret)
+		clear_bit(param, &cache->config_valid);
+	else
+		set_bit(param, &cache->config_valid);
+
+	return ret;
+}
+
+static int zynqmp_pinctrl_get_config(struct zynqmp_pinctrl *pctrl,
+				     unsigned int pin, u32 param, u32 *value)
+{
+	struct zynqmp_pin_cache *cache = &pctrl->pin_cache[pin];
+	int ret;
+
+	if (test_bit(param, &cache->config_valid)) {
+		*value = cache->config[param];
+		return 0;
+	}
+
+	ret = zynqmp_pinctrl_get_config(pctrl, pin, param, value);
+	if (!ret) {
+		cache->config[param] = *value;
+		set_bit(param, &cache->config_valid);
+	}
+
+	return ret;
+}
+
+static void zynqmp_pinctrl_invalidate_pin(struct zynqmp_pinctrl *pctrl,
+					  unsigned int pin)
+{
+	pctrl->pin_cache[pin].function_valid = false;
+	pctrl->pin_cache[pin].config_valid = 0;
+}
+
 /**
  * zynqmp_pctrl_get_groups_count() - get group count
  * @pctldev:	Pincontrol device pointer.
@@ -281,7 +363,7 @@ static int zynqmp_pinmux_set_mux(struct pinctrl_dev *pctldev,
 	for (i = 0; i < pgrp->npins; i++) {
 		unsigned int pin = pgrp->pins[i];
 
-		ret = eemi_ops->pinctrl_set_function(pin, function);
+		ret = zynqmp_pinctrl_set_function(pctrl, pin, function);
 		if (ret) {
 			dev_err(pctldev->dev, "set mux failed for pin %u\n",
 				pin);
@@ -304,11 +386,15 @@ static int zynqmp_pinmux_set_mux(struct pinctrl_dev *pctldev,
 static int zynqmp_pinmux_release_pin(struct pinctrl_dev *pctldev,
 				     unsigned int pin)
 {
+	struct zynqmp_pinctrl *pctrl = pinctrl_dev_get_drvdata(pctldev);
 	int ret;
 
 	if (!eemi_ops->pinctrl_release)
 		return -ENOTSUPP;
 
+	/* The next owner of the pin gets whatever the firmware has */
+	zynqmp_pinctrl_invalidate_pin(pctrl, pin);
+
 	ret = eemi_ops->pinctrl_release(pin);
 	if (ret) {
 		dev_err(pctldev->dev, "free pin failed for pin %u\n",
@@ -343,6 +429,7 @@ static int zynqmp_pinconf_cfg_get(struct pinctrl_dev *pctldev,
 				  unsigned int pin,
 				  unsigned long *config)
 {
+	struct zynqmp_pinctrl *pctrl = pinctrl_dev_get_drvdata(pctldev);
 	int ret;
 	unsigned int arg = 0, param = pinconf_to_config_param(*config);
 
@@ -354,12 +441,12 @@ static int zynqmp_pinconf_cfg_get(struct pinctrl_dev *pctldev,
 
 	switch (param) {
 	case PIN_CONFIG_SLEW_RATE:
-		ret = eemi_ops->pinctrl_get_config(pin,
+		ret = zynqmp_pinctrl_get_config(pctrl, pin,
 				PM_PINCTRL_CONFIG_SLEW_RATE,
 				&arg);
 		break;
 	case PIN_CONFIG_BIAS_PULL_UP:
-		ret = eemi_ops->pinctrl_get_config(pin,
+		ret = zynqmp_pinctrl_get_config(pctrl, pin,
 				PM_PINCTRL_CONFIG_PULL_CTRL,
 				&arg);
 		if (arg != PM_PINCTRL_BIAS_PULL_UP)
@@ -367,7 +454,7 @@ static int zynqmp_pinconf_cfg_get(struct pinctrl_dev *pctldev,
 		arg = 1;
 		break;
 	case PIN_CONFIG_BIAS_PULL_DOWN:
-		ret = eemi_ops->pinctrl_get_config(pin,
+		ret = zynqmp_pinctrl_get_config(pctrl, pin,
 				PM_PINCTRL_CONFIG_PULL_CTRL,
 				&arg);
 		if (arg != PM_PINCTRL_BIAS_PULL_DOWN)
@@ -375,7 +462,7 @@ static int zynqmp_pinconf_cfg_get(struct pinctrl_dev *pctldev,
 		arg = 1;
 		break;
 	case PIN_CONFIG_BIAS_DISABLE:
-		ret = eemi_ops->pinctrl_get_config(pin,
+		ret = zynqmp_pinctrl_get_config(pctrl, pin,
 				PM_PINCTRL_CONFIG_BIAS_STATUS,
 				&arg);
 		if (arg != PM_PINCTRL_BIAS_DISABLE)
@@ -383,17 +470,17 @@ static int zynqmp_pinconf_cfg_get(struct pinctrl_dev *pctldev,
 		arg = 1;
 		break;
 	case PIN_CONFIG_IOSTANDARD:
-		ret = eemi_ops->pinctrl_get_config(pin,
+		ret = zynqmp_pinctrl_get_config(pctrl, pin,
 				PM_PINCTRL_CONFIG_VOLTAGE_STATUS,
 				&arg);
 		break;
 	case PIN_CONFIG_SCHMITTCMOS:
-		ret = eemi_ops->pinctrl_get_config(pin,
+		ret = zynqmp_pinctrl_get_config(pctrl, pin,
 				PM_PINCTRL_CONFIG_SCHMITT_CMOS,
 				&arg);
 		break;
 	case PIN_CONFIG_DRIVE_STRENGTH:
-		ret = eemi_ops->pinctrl_get_config(pin,
+		ret = zynqmp_pinctrl_get_config(pctrl, pin,
 				PM_PINCTRL_CONFIG_DRIVE_STRENGTH,
 				&arg);
 		switch (arg) {
@@ -442,6 +529,7 @@ static int zynqmp_pinconf_cfg_set(struct pinctrl_dev *pctldev,
 				  unsigned int pin, unsigned long *configs,
 				  unsigned int num_configs)
 {
+	struct zynqmp_pinctrl *pctrl = pinctrl_dev_get_drvdata(pctldev);
 	int i, ret;
 
 	if (!eemi_ops->pinctrl_set_config)
@@ -457,27 +545,27 @@ static int zynqmp_pinconf_cfg_set(struct pinctrl_dev *pctldev,
 
 		switch (param) {
 		case PIN_CONFIG_SLEW_RATE:
-			ret = eemi_ops->pinctrl_set_config(pin,
+			ret = zynqmp_pinctrl_set_config(pctrl, pin,
 					PM_PINCTRL_CONFIG_SLEW_RATE,
 					arg);
 			break;
 		case PIN_CONFIG_BIAS_PULL_UP:
-			ret = eemi_ops->pinctrl_set_config(pin,
+			ret = zynqmp_pinctrl_set_config(pctrl, pin,
 					PM_PINCTRL_CONFIG_PULL_CTRL,
 					PM_PINCTRL_BIAS_PULL_UP);
 			break;
 		case PIN_CONFIG_BIAS_PULL_DOWN:
-			ret = eemi_ops->pinctrl_set_config(pin,
+			ret = zynqmp_pinctrl_set_config(pctrl, pin,
 					PM_PINCTRL_CONFIG_PULL_CTRL,
 					PM_PINCTRL_BIAS_PULL_DOWN);
 			break;
 		case PIN_CONFIG_BIAS_DISABLE:
-			ret = eemi_ops->pinctrl_set_config(pin,
+			ret = zynqmp_pinctrl_set_config(pctrl, pin,
 					PM_PINCTRL_CONFIG_BIAS_STATUS,
 					PM_PINCTRL_BIAS_DISABLE);
 			break;
 		case PIN_CONFIG_SCHMITTCMOS:
-			ret = eemi_ops->pinctrl_set_config(pin,
+			ret = zynqmp_pinctrl_set_config(pctrl, pin,
 					PM_PINCTRL_CONFIG_SCHMITT_CMOS,
 					arg);
 			break;
@@ -503,12 +591,12 @@ static int zynqmp_pinconf_cfg_set(struct pinctrl_dev *pctldev,
 				return -EINVAL;
 			}
 
-			ret = eemi_ops->pinctrl_set_config(pin,
+			ret = zynqmp_pinctrl_set_config(pctrl, pin,
 					PM_PINCTRL_CONFIG_DRIVE_STRENGTH,
 					value);
 			break;
 		case PIN_CONFIG_IOSTANDARD:
-			ret = eemi_ops->pinctrl_get_config(pin,
+			ret = zynqmp_pinctrl_get_config(pctrl, pin,
 					PM_PINCTRL_CONFIG_VOLTAGE_STATUS,
 					&value);
 
@@ -1025,6 +1113,13 @@ static int zynqmp_pinctrl_probe(struct platform_device *pdev)
 		goto err;
 	}
 
+	pctrl->pin_cache = devm_kcalloc(&pdev->dev, zynqmp_desc.npins,
+					sizeof(*pctrl->pin_cache), GFP_KERNEL);
+	if (!pctrl->pin_cache) {
+		ret = -ENOMEM;
+		goto err;
+	}
+
 	ret = zynqmp_pinctrl_prepare_function_info(&pdev->dev, pctrl);
 	if (ret) {
 		dev_err(&pdev->dev, "%s() function info prepare fail with %d\n",
@@ -1053,6 +1148,26 @@ static int zynqmp_pinctrl_remove(struct platform_device *pdev)
 	return 0;
 }
 
+/*
+ * Pin settings may not survive a system suspend. Forget them once the
+ * consumers have suspended so that their states are fully reapplied on
+ * resume.
+ */
+static int __maybe_unused zynqmp_pinctrl_suspend(struct device *dev)
+{
+	struct zynqmp_pinctrl *pctrl = dev_get_drvdata(dev);
+	unsigned int pin;
+
+	for (pin = 0; pin < zynqmp_desc.npins; pin++)
+		zynqmp_pinctrl_invalidate_pin(pctrl, pin);
+
+	return 0;
+}
+
+static const struct dev_pm_ops zynqmp_pinctrl_pm_ops = {
+	SET_LATE_SYSTEM_SLEEP_PM_OPS(zynqmp_pinctrl_suspend, NULL)
+};
+
 static const struct of_device_id zynqmp_pinctrl_of_match[] = {
 	{ .compatible = "xlnx,zynqmp-pinctrl" },
 	{ .compatible = "xlnx,pinctrl-zynqmp" },
@@ -1063,6 +1178,7 @@ static struct platform_driver zynqmp_pinctrl_driver = {
 	.driver = {
 		.name = "zynqmp-pinctrl",
 		.of_match_table = zynqmp_pinctrl_of_match,
+		.pm = &zynqmp_pinctrl_pm_ops,
 	},
 	.probe = zynqmp_pinctrl_probe,
 	.remove = zynqmp_pinctrl_remove,
@@ -90,16 +90,24 @@ static inline void xlnx_ptp_iow(struct xlnx_ptp_timer *timer, off_t reg,
 /*
  * Inline timer helpers
  */
+/*
+ * The snapshot write latches the whole ToD at once. It is posted, so it is
+ * only known to have reached the timer once the first snapshot register
+ * read returns: @sts brackets the write and that read.
+ */
 static inline void xlnx_tod_read(struct xlnx_ptp_timer *timer,
-				 struct timespec64 *ts)
+				 struct timespec64 *ts,
+				 struct ptp_system_timestamp *sts)
 {
 	u32 sech, secl, nsec;
 
+	ptp_read_system_prets(sts);
 	xlnx_ptp_iow(timer, XPTPTIMER_TOD_SNAPSHOT_OFFSET,
 		     XPTPTIMER_SNAPSHOT_MASK);
 
 	/* use TX port here */
 	nsec = xlnx_ptp_ior(timer, XPTPTIMER_PORT_TX_NS_SNAP_OFFSET);
+	ptp_read_system_postts(sts);
 	secl = xlnx_ptp_ior(timer, XPTPTIMER_PORT_TX_SEC_0_SNAP_OFFSET);
 	sech = xlnx_ptp_ior(timer, XPTPTIMER_PORT_TX_SEC_1_SNAP_OFFSET);
 
@@ -204,10 +212,12 @@ static int xlnx_ptp_adjtime(struct ptp_clock_info *ptp, s64 delta)
 						ptp_clock_info);
 	struct timespec64 offset;
 	u64 sign = 0;
-	s64 cumulative_delta = timer->timeoffset;
+	s64 cumulative_delta;
 
 	spin_lock(&timer->reg_lock);
 
+	cumulative_delta = timer->timeoffset;
+
 	/* Fixed offset between system and port timer */
 	delta += timer->static_delay;
 	cumulative_delta += delta;
@@ -227,22 +237,26 @@ static int xlnx_ptp_adjtime(struct ptp_clock_info *ptp, s64 delta)
 }
 
 /**
- * xlnx_ptp_gettime - Get the current time on the hardware clock
+ * xlnx_ptp_gettimex - Get the current time on the hardware clock
  * @ptp: ptp clock structure
  * @ts: timespec64 containing the current TX port timer time.
+ * @sts: system timestamps taken around the ToD snapshot, or NULL
  * Return: 0 on success
  * Since TX and RX ports are initialized and adjusted simultaneously,
  * they should be the same.
  *
  */
-static int xlnx_ptp_gettime(struct ptp_clock_info *ptp, struct timespec64 *ts)
+static int xlnx_ptp_gettimex(struct ptp_clock_info *ptp,
+			     struct timespec64 *ts,
+			     struct ptp_system_timestamp *sts)
 {
 	struct xlnx_ptp_timer *timer = container_of(ptp, struct xlnx_ptp_timer,
 						    ptp_clock_info);
+	unsigned long flags;
 
-	spin_lock(&timer->reg_lock);
-	xlnx_tod_read(timer, ts);
-	spin_unlock(&timer->reg_lock);
+	spin_lock_irqsave(&timer->reg_lock, flags);
+	xlnx_tod_read(timer, ts, sts);
+	spin_unlock_irqrestore(&timer->reg_lock, flags);
 
 	return 0;
 }
@@ -281,7 +295,7 @@ static struct ptp_clock_info xlnx_ptp_clock_info = {
 	.n_ext_ts	= 0,
 	.adjfine	= xlnx_ptp_adjfine,
 	.adjtime	= xlnx_ptp_adjtime,
-	.gettime64	= xlnx_ptp_gettime,
+	.gettimex64	= xlnx_ptp_gettimex,
 	.settime64	= xlnx_ptp_settime,
 	.enable		= xlnx_ptp_enable,
 };
@@ -1428,6 +1428,63 @@ static int rproc_fw_boot(struct rproc *rproc, const struct firmware *fw)
 	return ret;
 }
 
+/*
+ * Boot a remote processor with @fw, or with the image requested from
+ * rproc->firmware when @fw is NULL. The image is released before returning,
+ * unless it is kept for a warm restart.
+ */
+static int __rproc_boot(struct rproc *rproc, const struct firmware *fw)
+{
+	struct device *dev = &rproc->dev;
+	int ret;
+
+	ret = mutex_lock_interruptible(&rproc->lock);
+	if (ret) {
+		dev_err(dev, "can't lock rproc %s: %d\n", rproc->name, ret);
+		goto release_fw;
+	}
+
+	if (rproc->state == RPROC_DELETED) {
+		ret = -ENODEV;
+		dev_err(dev, "can't boot deleted rproc %s\n", rproc->name);
+		goto unlock_mutex;
+	}
+
+	/* skip the boot process if rproc is already powered up */
+	if (atomic_inc_return(&rproc->power) > 1) {
+		ret = 0;
+		goto unlock_mutex;
+	}
+
+	dev_info(dev, "powering up %s\n", rproc->name);
+
+	/* load firmware */
+	if (!fw) {
+		ret = request_firmware(&fw, rproc->firmware, dev);
+		if (ret < 0) {
+			dev_err(dev, "request_firmware failed: %d\n", ret);
+			goto downref_rproc;
+		}
+	}
+
+	ret = rproc_fw_boot(rproc, fw);
+
+	/* keep the image in memory for a fast recovery if requested */
+	if (!ret && rproc->warm_restart) {
+		rproc->warm_fw = fw;
+		fw = NULL;
+	}
+
+downref_rproc:
+	if (ret)
+		atomic_dec(&rproc->power);
+unlock_mutex:
+	mutex_unlock(&rproc->lock);
+release_fw:
+	release_firmware(fw);
+	return ret;
+}
+
 /*
  * take a firmware and boot it up.
  *
@@ -1440,9 +1497,8 @@ static void rproc_auto_boot_callback(const struct firmware *fw, void *context)
 {
 	struct rproc *rproc = context;
 
-	rproc_boot(rproc);
-
-	release_firmware(fw);
+	/* boot with the image already loaded instead of requesting it again */
+	__rproc_boot(rproc, fw);
 }
 
 static int rproc_trigger_auto_boot(struct rproc *rproc)
@@ -1667,17 +1723,22 @@ int rproc_trigger_recovery(struct rproc *rproc)
 	/* generate coredump */
 	rproc_coredump(rproc);
 
-	/* load firmware */
-	ret = request_firmware(&firmware_p, rproc->firmware, dev);
-	if (ret < 0) {
-		dev_err(dev, "request_firmware failed: %d\n", ret);
-		goto unlock_mutex;
+	/* reuse the image kept at boot, if any, instead of reloading it */
+	if (rproc->warm_fw) {
+		firmware_p = rproc->warm_fw;
+	} else {
+		ret = request_firmware(&firmware_p, rproc->firmware, dev);
+		if (ret < 0) {
+			dev_err(dev, "request_firmware failed: %d\n", ret);
+			goto unlock_mutex;
+		}
 	}
 
 	/* boot the remote processor up again */
 	ret = rproc_start(rproc, firmware_p);
 
-	release_firmware(firmware_p);
+	if (firmware_p != rproc->warm_fw)
+		release_firmware(firmware_p);
 
 unlock_mutex:
 	mutex_unlock(&rproc->lock);
@@ -1728,54 +1789,12 @@ static void rproc_crash_handler_work(struct work_struct *work)
  */
 int rproc_boot(struct rproc *rproc)
 {
-	const struct firmware *firmware_p;
-	struct device *dev;
-	int ret;
-
 	if (!rproc) {
 		pr_err("invalid rproc handle\n");
 		return -EINVAL;
 	}
 
-	dev = &rproc->dev;
-
-	ret = mutex_lock_interruptible(&rproc->lock);
-	if (ret) {
-		dev_err(dev, "can't lock rproc %s: %d\n", rproc->name, ret);
-		return ret;
-	}
-
-	if (rproc->state == RPROC_DELETED) {
-		ret = -ENODEV;
-		dev_err(dev, "can't boot deleted rproc %s\n", rproc->name);
-		goto unlock_mutex;
-	}
-
-	/* skip the boot process if rproc is already powered up */
-	if (atomic_inc_return(&rproc->power) > 1) {
-		ret = 0;
-		goto unlock_mutex;
-	}
-
-	dev_info(dev, "powering up %s\n", rproc->name);
-
-	/* load firmware */
-	ret = request_firmware(&firmware_p, rproc->firmware, dev);
-	if (ret < 0) {
-		dev_err(dev, "request_firmware failed: %d\n", ret);
-		goto downref_rproc;
-	}
-
-	ret = rproc_fw_boot(rproc, firmware_p);
-
-	release_firmware(firmware_p);
-
-downref_rproc:
-	if (ret)
-		atomic_dec(&rproc->power);
-unlock_mutex:
-	mutex_unlock(&rproc->lock);
-	return ret;
+	return __rproc_boot(rproc, NULL);
 }
 EXPORT_SYMBOL(rproc_boot);
 
@@ -1828,6 +1847,9 @@ void rproc_shutdown(struct rproc *rproc)
 	kfree(rproc->cached_table);
 	rproc->cached_table = NULL;
 	rproc->table_ptr = NULL;
+
+	release_firmware(rproc->warm_fw);
+	rproc->warm_fw = NULL;
 out:
 	mutex_unlock(&rproc->lock);
 }
@@ -1953,6 +1975,7 @@ static void rproc_type_release(struct device *dev)
 	if (rproc->index >= 0)
 		ida_simple_remove(&rproc_dev_index, rproc->index);
 
+	release_firmware(rproc->warm_fw);
 	kfree(rproc->firmware);
 	kfree(rproc->ops);
 	kfree(rproc);
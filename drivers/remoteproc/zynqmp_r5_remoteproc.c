@@ -26,7 +26,10 @@
 #include <linux/list.h>
 #include <linux/mailbox_client.h>
 #include <linux/mailbox/zynqmp-ipi-message.h>
+#include <linux/miscdevice.h>
+#include <linux/mm.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
 #include <linux/of_address.h>
 #include <linux/of_irq.h>
 #include <linux/of_platform.h>
@@ -56,6 +59,7 @@
 
 static bool autoboot __read_mostly;
 static bool allow_sysfs_kick __read_mostly;
+static bool warm_restart __read_mostly;
 
 static const struct zynqmp_eemi_ops *eemi_ops;
 
@@ -84,9 +88,14 @@ struct zynqmp_r5_mem {
  * @tx_chan: tx mailbox channel
  * @rx_chan: rx mailbox channel
  * @workqueue: workqueue for the RPU remoteproc
+ * @notify_wq: high priority unbound workqueue the notifications are
+ *	       handled on
  * @tx_mc_skbs: socket buffers for tx mailbox client
  * @rx_mc_buf: rx mailbox client buffer to save the rx message
  * @remote_kick: flag to indicate if there is a kick from remote
+ * @shm: shared memory pool resource
+ * @shm_misc: misc device to map the shared memory pool
+ * @shm_name: name of the shared memory pool misc device
  */
 struct zynqmp_r5_pdata {
 	struct device dev;
@@ -100,19 +109,25 @@ struct zynqmp_r5_pdata {
 	struct mbox_chan *tx_chan;
 	struct mbox_chan *rx_chan;
 	struct work_struct workqueue;
+	struct workqueue_struct *notify_wq;
 	struct sk_buff_head tx_mc_skbs;
 	unsigned char rx_mc_buf[RX_MBOX_CLIENT_BUF_MAX];
 	atomic_t remote_kick;
+	struct resource shm;
+	struct miscdevice shm_misc;
+	char shm_name[16];
 };
 
 /**
  * struct zynqmp_rpu_domain_pdata - zynqmp rpu platform data
  * @rpus: table of RPUs
  * @rpu_mode: RPU core configuration
+ * @mode_lock: serializes the RPU operation mode setup of the cores
  */
 struct zynqmp_rpu_domain_pdata {
 	struct zynqmp_r5_pdata rpus[MAX_RPROCS];
 	enum rpu_oper_mode rpu_mode;
+	struct mutex mode_lock;
 };
 
 /*
@@ -134,11 +149,14 @@ static int r5_set_mode(struct zynqmp_r5_pdata *pdata)
 		return 0;
 	parent = pdata->parent;
 	expect = (u32)parent->rpu_mode;
+
+	/* both cores of a split RPU can be started at the same time */
+	mutex_lock(&parent->mode_lock);
 	ret = eemi_ops->ioctl(pdata->pnode_id, IOCTL_GET_RPU_OPER_MODE,
 			  0, 0, val);
 	if (ret < 0) {
 		dev_err(dev, "failed to get RPU oper mode.\n");
-		return ret;
+		goto out;
 	}
 	if (val[0] == expect) {
 		dev_dbg(dev, "RPU mode matches: %x\n", val[0]);
@@ -149,7 +167,7 @@ static int r5_set_mode(struct zynqmp_r5_pdata *pdata)
 		if (ret < 0) {
 			dev_err(dev,
 				"failed to set RPU oper mode.\n");
-			return ret;
+			goto out;
 		}
 	}
 	if (expect == (u32)PM_RPU_MODE_LOCKSTEP)
@@ -161,10 +179,12 @@ static int r5_set_mode(struct zynqmp_r5_pdata *pdata)
 	if (ret < 0) {
 		dev_err(dev, "failed to config TCM to %x.\n",
 			expect);
-		return ret;
+		goto out;
 	}
 	pdata->is_r5_mode_set = true;
-	return 0;
+out:
+	mutex_unlock(&parent->mode_lock);
+	return ret;
 }
 
 /**
@@ -298,6 +318,9 @@ static int zynqmp_r5_parse_fw(struct rproc *rproc, const struct firmware *fw)
 			dev_err(dev, "unable to acquire memory-region\n");
 			return -EINVAL;
 		}
+		/* The shared memory pool is used by applications only */
+		if (strstr(node->name, "shm"))
+			continue;
 		if (strstr(node->name, "vdev") &&
 			strstr(node->name, "buffer")) {
 			int id;
@@ -598,6 +621,8 @@ static void zynqmp_r5_release(struct device *dev)
 		mbox_free_channel(pdata->tx_chan);
 	if (pdata->rx_chan)
 		mbox_free_channel(pdata->rx_chan);
+	if (pdata->notify_wq)
+		destroy_workqueue(pdata->notify_wq);
 	/* Discard all SKBs */
 	while (!skb_queue_empty(&pdata->tx_mc_skbs)) {
 		skb = skb_dequeue(&pdata->tx_mc_skbs);
@@ -630,21 +655,34 @@ static int event_notified_idr_cb(int id, void *ptr, void *data)
  * handle_event_notified() - remoteproc notification work funciton
  * @work: pointer to the work structure
  *
- * It checks each registered remoteproc notify IDs.
+ * If the remote passed a notify ID in the IPI buffer, only that vring is
+ * checked, otherwise each registered remoteproc notify IDs.
  */
 static void handle_event_notified(struct work_struct *work)
 {
+	struct zynqmp_ipi_message *msg;
 	struct rproc *rproc;
 	struct zynqmp_r5_pdata *local;
+	u32 notifyid = U32_MAX;
 
 	local = container_of(work, struct zynqmp_r5_pdata, workqueue);
 
+	/* Read the notify ID before the ack lets the remote overwrite it */
+	msg = (struct zynqmp_ipi_message *)local->rx_mc_buf;
+	if (msg->len >= sizeof(notifyid))
+		memcpy(&notifyid, msg->data, sizeof(notifyid));
+
 	(void)mbox_send_message(local->rx_chan, NULL);
 	rproc = local->rproc;
 	if (rproc->sysfs_kick) {
 		sysfs_notify(&rproc->dev.kobj, NULL, "remote_kick");
 		return;
 	}
+
+	if (notifyid != U32_MAX &&
+	    rproc_vq_interrupt(rproc, notifyid) == IRQ_HANDLED)
+		return;
+
 	/*
 	 * We only use IPI for interrupt. The firmware side may or may
 	 * not write the notifyid when it trigger IPI.
@@ -662,22 +700,25 @@ static void handle_event_notified(struct work_struct *work)
  */
 static void zynqmp_r5_mb_rx_cb(struct mbox_client *cl, void *mssg)
 {
+	struct zynqmp_ipi_message *buf_msg;
 	struct zynqmp_r5_pdata *local;
 
 	local = container_of(cl, struct zynqmp_r5_pdata, rx_mc);
+	buf_msg = (struct zynqmp_ipi_message *)local->rx_mc_buf;
 	if (mssg) {
-		struct zynqmp_ipi_message *ipi_msg, *buf_msg;
+		struct zynqmp_ipi_message *ipi_msg;
 		size_t len;
 
 		ipi_msg = (struct zynqmp_ipi_message *)mssg;
-		buf_msg = (struct zynqmp_ipi_message *)local->rx_mc_buf;
 		len = (ipi_msg->len >= IPI_BUF_LEN_MAX) ?
 		      IPI_BUF_LEN_MAX : ipi_msg->len;
 		buf_msg->len = len;
 		memcpy(buf_msg->data, ipi_msg->data, len);
+	} else {
+		buf_msg->len = 0;
 	}
 	atomic_set(&local->remote_kick, 1);
-	schedule_work(&local->workqueue);
+	queue_work(local->notify_wq, &local->workqueue);
 }
 
 /**
@@ -733,6 +774,18 @@ static int zynqmp_r5_setup_mbox(struct zynqmp_r5_pdata *pdata,
 
 	INIT_WORK(&pdata->workqueue, handle_event_notified);
 
+	/*
+	 * Don't share a workqueue with the rest of the system, so that the
+	 * notification latency is not affected by unrelated work items.
+	 * Unbound, so that the notifications are handled on the housekeeping
+	 * CPUs rather than on the CPU which took the IPI, which may be
+	 * isolated with isolcpus=.
+	 */
+	pdata->notify_wq = alloc_workqueue("%s", WQ_HIGHPRI | WQ_UNBOUND, 0,
+					   dev_name(dev));
+	if (!pdata->notify_wq)
+		return -ENOMEM;
+
 	atomic_set(&pdata->remote_kick, 0);
 	/* Request TX and RX channels */
 	pdata->tx_chan = mbox_request_channel_byname(&pdata->tx_mc, "tx");
@@ -751,6 +804,84 @@ static int zynqmp_r5_setup_mbox(struct zynqmp_r5_pdata *pdata,
 	return 0;
 }
 
+static int zynqmp_r5_shm_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct miscdevice *misc = file->private_data;
+	struct zynqmp_r5_pdata *pdata =
+		container_of(misc, struct zynqmp_r5_pdata, shm_misc);
+	unsigned long size = vma->vm_end - vma->vm_start;
+	resource_size_t pool_size = resource_size(&pdata->shm);
+
+	if (vma->vm_pgoff > PHYS_PFN(pool_size) ||
+	    size > pool_size - PFN_PHYS(vma->vm_pgoff))
+		return -EINVAL;
+
+	/* The remote processor isn't cache coherent with the APU */
+	vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
+
+	return remap_pfn_range(vma, vma->vm_start,
+			       PHYS_PFN(pdata->shm.start) + vma->vm_pgoff,
+			       size, vma->vm_page_prot);
+}
+
+static const struct file_operations zynqmp_r5_shm_fops = {
+	.owner = THIS_MODULE,
+	.mmap = zynqmp_r5_shm_mmap,
+};
+
+/**
+ * zynqmp_r5_shm_probe() - expose the shared memory pool of the RPU
+ * @pdata: Remote processor private data
+ *
+ * A "memory-region" whose node name contains "shm" is a pool shared with
+ * the RPU firmware for large payloads. It is exposed to user space through
+ * the /dev/rproc<index>-shm misc device, which can be mmap'ed. Applications
+ * hand buffers of the pool over by their offset in small RPMsg messages,
+ * instead of copying the payloads through the 512 bytes RPMsg buffers.
+ *
+ * Return: 0 for success, negative value for failure
+ */
+static int zynqmp_r5_shm_probe(struct zynqmp_r5_pdata *pdata)
+{
+	struct device *dev = &pdata->dev;
+	struct device_node *np = dev->of_node;
+	struct device_node *node;
+	int i, ret;
+
+	for (i = 0; ; i++) {
+		node = of_parse_phandle(np, "memory-region", i);
+		if (!node)
+			return 0;
+		if (strstr(node->name, "shm"))
+			break;
+		of_node_put(node);
+	}
+
+	ret = of_address_to_resource(node, 0, &pdata->shm);
+	of_node_put(node);
+	if (ret) {
+		dev_err(dev, "unable to resolve shared memory pool.\n");
+		return ret;
+	}
+
+	snprintf(pdata->shm_name, sizeof(pdata->shm_name), "rproc%d-shm",
+		 pdata->rproc->index);
+	pdata->shm_misc.minor = MISC_DYNAMIC_MINOR;
+	pdata->shm_misc.name = pdata->shm_name;
+	pdata->shm_misc.fops = &zynqmp_r5_shm_fops;
+	pdata->shm_misc.parent = dev;
+	ret = misc_register(&pdata->shm_misc);
+	if (ret) {
+		dev_err(dev, "failed to register shared memory device.\n");
+		pdata->shm_misc.name = NULL;
+		return ret;
+	}
+
+	dev_dbg(dev, "shared memory pool %pR\n", &pdata->shm);
+
+	return 0;
+}
+
 /**
  * zynqmp_r5_probe() - Probes ZynqMP R5 processor device node
  * @pdata: pointer to the ZynqMP R5 processor platform data
@@ -791,6 +922,7 @@ static int zynqmp_r5_probe(struct zynqmp_r5_pdata *pdata,
 		goto error;
 	}
 	rproc->auto_boot = autoboot;
+	rproc->warm_restart = warm_restart;
 	pdata->rproc = rproc;
 	rproc->priv = pdata;
 
@@ -854,6 +986,12 @@ static int zynqmp_r5_probe(struct zynqmp_r5_pdata *pdata,
 		goto error;
 	}
 
+	ret = zynqmp_r5_shm_probe(pdata);
+	if (ret) {
+		rproc_del(rproc);
+		goto error;
+	}
+
 	if (allow_sysfs_kick) {
 		dev_info(dev, "Trying to create remote sysfs entry.\n");
 		rproc->sysfs_kick = 1;
@@ -886,6 +1024,7 @@ static int zynqmp_r5_remoteproc_probe(struct platform_device *pdev)
 	if (!local)
 		return -ENOMEM;
 	platform_set_drvdata(pdev, local);
+	mutex_init(&local->mode_lock);
 
 	prop = of_get_property(dev->of_node, "core_conf", NULL);
 	if (!prop) {
@@ -929,6 +1068,11 @@ static int zynqmp_r5_remoteproc_remove(struct platform_device *pdev)
 		struct zynqmp_r5_pdata *rpu = &local->rpus[i];
 		struct rproc *rproc;
 
+		if (rpu->shm_misc.name) {
+			misc_deregister(&rpu->shm_misc);
+			rpu->shm_misc.name = NULL;
+		}
+
 		rproc = rpu->rproc;
 		if (rproc) {
 			rproc_del(rproc);
@@ -963,6 +1107,7 @@ static struct platform_driver zynqmp_r5_remoteproc_driver = {
 	.driver = {
 		.name = "zynqmp_r5_remoteproc",
 		.of_match_table = zynqmp_r5_remoteproc_match,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 };
 module_platform_driver(zynqmp_r5_remoteproc_driver);
@@ -973,6 +1118,9 @@ MODULE_PARM_DESC(autoboot,
 module_param_named(allow_sysfs_kick, allow_sysfs_kick, bool, 0444);
 MODULE_PARM_DESC(allow_sysfs_kick,
 		 "enable | disable allow kick from sysfs. (default: false)");
+module_param_named(warm_restart, warm_restart, bool, 0444);
+MODULE_PARM_DESC(warm_restart,
+		 "enable | disable keeping the firmware for recovery. (default: false)");
 
 MODULE_AUTHOR("Jason Wu <j.wu@xilinx.com>");
 MODULE_LICENSE("GPL v2");
@@ -62,6 +62,7 @@ struct rpmsg_ctrldev {
  * @queue_lock:	synchronization of @queue operations
  * @queue:	incoming message queue
  * @readq:	wait object for incoming queue
+ * @rx_batch:	number of queued messages waking up the readers
  */
 struct rpmsg_eptdev {
 	struct device dev;
@@ -76,8 +77,15 @@ struct rpmsg_eptdev {
 	spinlock_t queue_lock;
 	struct sk_buff_head queue;
 	wait_queue_head_t readq;
+	u32 rx_batch;
 };
 
+/* readers are woken up once rx_batch messages are queued */
+static bool rpmsg_eptdev_readable(struct rpmsg_eptdev *eptdev)
+{
+	return skb_queue_len(&eptdev->queue) >= READ_ONCE(eptdev->rx_batch);
+}
+
 static int rpmsg_eptdev_destroy(struct device *dev, void *data)
 {
 	struct rpmsg_eptdev *eptdev = dev_to_eptdev(dev);
@@ -115,7 +123,8 @@ static int rpmsg_ept_cb(struct rpmsg_device *rpdev, void *buf, int len,
 	spin_unlock(&eptdev->queue_lock);
 
 	/* wake up any blocking processes, waiting for new data */
-	wake_up_interruptible(&eptdev->readq);
+	if (rpmsg_eptdev_readable(eptdev))
+		wake_up_interruptible(&eptdev->readq);
 
 	return 0;
 }
@@ -129,6 +138,7 @@ static int rpmsg_eptdev_open(struct inode *inode, struct file *filp)
 
 	get_device(dev);
 
+	eptdev->rx_batch = 1;
 	ept = rpmsg_create_ept(rpdev, rpmsg_ept_cb, eptdev, eptdev->chinfo);
 	if (!ept) {
 		dev_err(dev, "failed to open %s\n", eptdev->chinfo.name);
@@ -189,7 +199,7 @@ static ssize_t rpmsg_eptdev_read_iter(struct kiocb *iocb, struct iov_iter *to)
 
 		/* Wait until we get data or the endpoint goes away */
 		if (wait_event_interruptible(eptdev->readq,
-					     !skb_queue_empty(&eptdev->queue) ||
+					     rpmsg_eptdev_readable(eptdev) ||
 					     !eptdev->ept))
 			return -ERESTARTSYS;
 
@@ -227,8 +237,10 @@ static ssize_t rpmsg_eptdev_write_iter(struct kiocb *iocb,
 	if (!kbuf)
 		return -ENOMEM;
 
-	if (!copy_from_iter_full(kbuf, len, from))
-		return -EFAULT;
+	if (!copy_from_iter_full(kbuf, len, from)) {
+		ret = -EFAULT;
+		goto free_kbuf;
+	}
 
 	if (mutex_lock_interruptible(&eptdev->ept_lock)) {
 		ret = -ERESTARTSYS;
@@ -263,7 +275,7 @@ static __poll_t rpmsg_eptdev_poll(struct file *filp, poll_table *wait)
 
 	poll_wait(filp, &eptdev->readq, wait);
 
-	if (!skb_queue_empty(&eptdev->queue))
+	if (rpmsg_eptdev_readable(eptdev))
 		mask |= EPOLLIN | EPOLLRDNORM;
 
 	mask |= rpmsg_poll(eptdev->ept, filp, wait);
@@ -271,15 +283,170 @@ static __poll_t rpmsg_eptdev_poll(struct file *filp, poll_table *wait)
 	return mask;
 }
 
+/*
+ * Receive up to batch.count queued messages, one per message buffer, with a
+ * single system call. Only the first message is waited for.
+ */
+static long rpmsg_eptdev_recv_batch(struct file *filp,
+				    struct rpmsg_batch __user *ubatch)
+{
+	struct rpmsg_eptdev *eptdev = filp->private_data;
+	struct rpmsg_msg_vec __user *uvec;
+	struct rpmsg_batch batch;
+	struct rpmsg_msg_vec vec;
+	unsigned long flags;
+	struct sk_buff *skb;
+	long ret = 0;
+	u32 i, use;
+
+	if (copy_from_user(&batch, ubatch, sizeof(batch)))
+		return -EFAULT;
+	if (batch.flags)
+		return -EINVAL;
+
+	if (!eptdev->ept)
+		return -EPIPE;
+
+	if (batch.count && skb_queue_empty(&eptdev->queue)) {
+		if (filp->f_flags & O_NONBLOCK)
+			return -EAGAIN;
+
+		/* Wait until we get data or the endpoint goes away */
+		if (wait_event_interruptible(eptdev->readq,
+					     rpmsg_eptdev_readable(eptdev) ||
+					     !eptdev->ept))
+			return -ERESTARTSYS;
+
+		/* We lost the endpoint while waiting */
+		if (!eptdev->ept)
+			return -EPIPE;
+	}
+
+	uvec = u64_to_user_ptr(batch.msgs);
+	for (i = 0; i < batch.count; i++) {
+		if (copy_from_user(&vec, &uvec[i], sizeof(vec))) {
+			ret = -EFAULT;
+			break;
+		}
+
+		spin_lock_irqsave(&eptdev->queue_lock, flags);
+		skb = skb_dequeue(&eptdev->queue);
+		spin_unlock_irqrestore(&eptdev->queue_lock, flags);
+		if (!skb)
+			break;
+
+		use = min_t(u32, vec.len, skb->len);
+		if (copy_to_user(u64_to_user_ptr(vec.buf), skb->data, use) ||
+		    put_user(use, &uvec[i].len))
+			ret = -EFAULT;
+
+		kfree_skb(skb);
+		if (ret)
+			break;
+	}
+
+	if (put_user(i, &ubatch->count))
+		return -EFAULT;
+
+	return i ? 0 : ret;
+}
+
+/*
+ * Send batch.count messages, one per message buffer, with a single system
+ * call taking the endpoint lock once.
+ */
+static long rpmsg_eptdev_send_batch(struct file *filp,
+				    struct rpmsg_batch __user *ubatch)
+{
+	struct rpmsg_eptdev *eptdev = filp->private_data;
+	struct rpmsg_msg_vec __user *uvec;
+	struct rpmsg_batch batch;
+	struct rpmsg_msg_vec vec;
+	void *kbuf = NULL, *tmp;
+	size_t size = 0;
+	long ret = 0;
+	u32 i;
+
+	if (copy_from_user(&batch, ubatch, sizeof(batch)))
+		return -EFAULT;
+	if (batch.flags)
+		return -EINVAL;
+
+	if (mutex_lock_interruptible(&eptdev->ept_lock))
+		return -ERESTARTSYS;
+
+	if (!eptdev->ept) {
+		mutex_unlock(&eptdev->ept_lock);
+		return -EPIPE;
+	}
+
+	uvec = u64_to_user_ptr(batch.msgs);
+	for (i = 0; i < batch.count; i++) {
+		if (copy_from_user(&vec, &uvec[i], sizeof(vec))) {
+			ret = -EFAULT;
+			break;
+		}
+
+		/* reuse the bounce buffer, growing it only when needed */
+		if (vec.len > size) {
+			tmp = krealloc(kbuf, vec.len, GFP_KERNEL);
+			if (!tmp) {
+				ret = -ENOMEM;
+				break;
+			}
+			kbuf = tmp;
+			size = vec.len;
+		}
+
+		if (copy_from_user(kbuf, u64_to_user_ptr(vec.buf), vec.len)) {
+			ret = -EFAULT;
+			break;
+		}
+
+		if (filp->f_flags & O_NONBLOCK)
+			ret = rpmsg_trysend(eptdev->ept, kbuf, vec.len);
+		else
+			ret = rpmsg_send(eptdev->ept, kbuf, vec.len);
+		if (ret)
+			break;
+	}
+
+	mutex_unlock(&eptdev->ept_lock);
+	kfree(kbuf);
+
+	if (put_user(i, &ubatch->count))
+		return -EFAULT;
+
+	return i ? 0 : ret;
+}
+
 static long rpmsg_eptdev_ioctl(struct file *fp, unsigned int cmd,
 			       unsigned long arg)
 {
 	struct rpmsg_eptdev *eptdev = fp->private_data;
-
-	if (cmd != RPMSG_DESTROY_EPT_IOCTL)
+	void __user *argp = (void __user *)arg;
+	u32 rx_batch;
+
+	switch (cmd) {
+	case RPMSG_DESTROY_EPT_IOCTL:
+		return rpmsg_eptdev_destroy(&eptdev->dev, NULL);
+	case RPMSG_RECV_BATCH_IOCTL:
+		return rpmsg_eptdev_recv_batch(fp, argp);
+	case RPMSG_SEND_BATCH_IOCTL:
+		return rpmsg_eptdev_send_batch(fp, argp);
+	case RPMSG_SET_RX_BATCH_IOCTL:
+		if (get_user(rx_batch, (u32 __user *)argp))
+			return -EFAULT;
+		if (!rx_batch)
+			return -EINVAL;
+
+		WRITE_ONCE(eptdev->rx_batch, rx_batch);
+		/* the messages already queued may now be enough */
+		wake_up_interruptible(&eptdev->readq);
+		return 0;
+	default:
 		return -EINVAL;
-
-	return rpmsg_eptdev_destroy(&eptdev->dev, NULL);
+	}
 }
 
 static const struct file_operations rpmsg_eptdev_fops = {
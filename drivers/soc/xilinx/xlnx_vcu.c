@@ -13,6 +13,7 @@
 #include <linux/module.h>
 #include <linux/of_platform.h>
 #include <linux/platform_device.h>
+#include <linux/pm_runtime.h>
 
 #include <soc/xilinx/xlnx_vcu.h>
 
@@ -45,6 +46,13 @@
 #define MHZ				1000000
 #define FRAC				100
 
+#define XVCU_AUTOSUSPEND_DELAY_MS	5000
+
+static bool pll_retention = true;
+module_param(pll_retention, bool, 0644);
+MODULE_PARM_DESC(pll_retention,
+		 "Keep the VCU PLL locked while runtime suspended (default: true)");
+
 /**
  * struct xvcu_priv - Xilinx VCU private data
  * @dev: Platform device
@@ -55,6 +63,7 @@
  * @mcu_dec: MCU decoder clock
  * @logicore_reg_ba: logicore reg base address
  * @vcu_slcr_ba: vcu_slcr Register base address
+ * @pll_retained: the PLL and MCU clocks were left running at runtime suspend
  */
 struct xvcu_priv {
 	struct device *dev;
@@ -65,6 +74,7 @@ struct xvcu_priv {
 	struct clk *mcu_dec;
 	void __iomem *logicore_reg_ba;
 	void __iomem *vcu_slcr_ba;
+	bool pll_retained;
 };
 
 /**
@@ -242,6 +252,30 @@ static int xvcu_set_vcu_pll(struct xvcu_priv *xvcu)
 	return ret;
 }
 
+/**
+ * xvcu_link_consumer - Link a VCU codec device to the VCU
+ * @dev:	Child device of the VCU core
+ * @data:	Pointer to the xvcu_priv structure
+ *
+ * The codec devices populated from the VCU node become runtime PM consumers
+ * of the VCU, so the VCU clocks follow the codec runtime PM state.
+ *
+ * Return:	Always 0
+ */
+static int xvcu_link_consumer(struct device *dev, void *data)
+{
+	struct xvcu_priv *xvcu = data;
+
+	if (dev == xvcu->dev || !dev->of_node)
+		return 0;
+
+	if (!device_link_add(dev, xvcu->dev, DL_FLAG_PM_RUNTIME |
+			     DL_FLAG_RPM_ACTIVE | DL_FLAG_AUTOREMOVE_SUPPLIER))
+		dev_warn(xvcu->dev, "failed to link %s\n", dev_name(dev));
+
+	return 0;
+}
+
 /**
  * xvcu_probe - Probe existence of the logicoreIP
  *			and initialize PLL
@@ -309,12 +343,26 @@ static int xvcu_probe(struct platform_device *pdev)
 
 	dev_set_drvdata(&pdev->dev, xvcu);
 
+	pm_runtime_get_noresume(&pdev->dev);
+	pm_runtime_set_active(&pdev->dev);
+	pm_runtime_set_autosuspend_delay(&pdev->dev, XVCU_AUTOSUSPEND_DELAY_MS);
+	pm_runtime_use_autosuspend(&pdev->dev);
+	pm_runtime_enable(&pdev->dev);
+
 	ret = devm_of_platform_populate(pdev->dev.parent);
 	if (ret) {
 		dev_err(&pdev->dev, "Failed to register allegro codecs\n");
+		pm_runtime_disable(&pdev->dev);
+		pm_runtime_set_suspended(&pdev->dev);
+		pm_runtime_put_noidle(&pdev->dev);
 		return ret;
 	}
 
+	device_for_each_child(pdev->dev.parent, xvcu, xvcu_link_consumer);
+
+	pm_runtime_mark_last_busy(&pdev->dev);
+	pm_runtime_put_autosuspend(&pdev->dev);
+
 	dev_info(&pdev->dev, "%s: Probed successfully\n", __func__);
 
 	return ret;
@@ -336,6 +384,11 @@ static int xvcu_remove(struct platform_device *pdev)
 	if (!xvcu)
 		return -ENODEV;
 
+	pm_runtime_get_sync(&pdev->dev);
+	pm_runtime_disable(&pdev->dev);
+	pm_runtime_set_suspended(&pdev->dev);
+	pm_runtime_put_noidle(&pdev->dev);
+
 	clk_disable_unprepare(xvcu->core_enc);
 	devm_clk_put(pdev->dev.parent, xvcu->core_enc);
 
@@ -354,9 +407,109 @@ static int xvcu_remove(struct platform_device *pdev)
 	return 0;
 }
 
+/**
+ * xvcu_runtime_suspend - Gate the VCU clocks
+ * @dev:	Pointer to the VCU device
+ *
+ * The core clocks are always gated. With PLL retention the MCU clocks are
+ * left running, which keeps the VCU PLL locked so that the next session
+ * resumes without a PLL relock.
+ *
+ * Return:	Always 0
+ */
+static int __maybe_unused xvcu_runtime_suspend(struct device *dev)
+{
+	struct xvcu_priv *xvcu = dev_get_drvdata(dev);
+
+	clk_disable_unprepare(xvcu->core_dec);
+	clk_disable_unprepare(xvcu->core_enc);
+
+	xvcu->pll_retained = pll_retention;
+	if (xvcu->pll_retained)
+		return 0;
+
+	clk_disable_unprepare(xvcu->mcu_dec);
+	clk_disable_unprepare(xvcu->mcu_enc);
+	clk_disable_unprepare(xvcu->pll_ref);
+
+	return 0;
+}
+
+/**
+ * xvcu_runtime_resume - Ungate the VCU clocks
+ * @dev:	Pointer to the VCU device
+ *
+ * The clock rates programmed at probe are kept by the clock framework, so
+ * only the clocks gated at runtime suspend are enabled again.
+ *
+ * Return:	Returns 0 on success
+ *		Negative error code otherwise
+ */
+static int __maybe_unused xvcu_runtime_resume(struct device *dev)
+{
+	struct xvcu_priv *xvcu = dev_get_drvdata(dev);
+	int ret;
+
+	if (!xvcu->pll_retained) {
+		ret = clk_prepare_enable(xvcu->pll_ref);
+		if (ret) {
+			dev_err(dev, "failed to enable pll_ref clock source %d\n",
+				ret);
+			return ret;
+		}
+
+		ret = clk_prepare_enable(xvcu->mcu_enc);
+		if (ret) {
+			dev_err(dev, "failed to enable mcu_enc %d\n", ret);
+			goto error_mcu_enc;
+		}
+
+		ret = clk_prepare_enable(xvcu->mcu_dec);
+		if (ret) {
+			dev_err(dev, "failed to enable mcu_dec %d\n", ret);
+			goto error_mcu_dec;
+		}
+	}
+
+	ret = clk_prepare_enable(xvcu->core_enc);
+	if (ret) {
+		dev_err(dev, "failed to enable core_enc %d\n", ret);
+		goto error_core_enc;
+	}
+
+	ret = clk_prepare_enable(xvcu->core_dec);
+	if (ret) {
+		dev_err(dev, "failed to enable core_dec %d\n", ret);
+		goto error_core_dec;
+	}
+
+	xvcu->pll_retained = false;
+
+	return 0;
+
+error_core_dec:
+	clk_disable_unprepare(xvcu->core_enc);
+error_core_enc:
+	if (xvcu->pll_retained)
+		return ret;
+	clk_disable_unprepare(xvcu->mcu_dec);
+error_mcu_dec:
+	clk_disable_unprepare(xvcu->mcu_enc);
+error_mcu_enc:
+	clk_disable_unprepare(xvcu->pll_ref);
+
+	return ret;
+}
+
+static const struct dev_pm_ops xvcu_pm_ops = {
+	SET_RUNTIME_PM_OPS(xvcu_runtime_suspend, xvcu_runtime_resume, NULL)
+};
+
 static struct platform_driver xvcu_driver = {
 	.driver = {
 		.name           = "xilinx-vcu",
+		.pm             = &xvcu_pm_ops,
+		.probe_type     = PROBE_PREFER_ASYNCHRONOUS,
 	},
 	.probe                  = xvcu_probe,
 	.remove                 = xvcu_remove,
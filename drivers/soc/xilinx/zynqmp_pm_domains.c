@@ -22,6 +22,8 @@
 #define ZYNQMP_NUM_DOMAINS		(100)
 /* Flag stating if PM nodes mapped to the PM domain has been requested */
 #define ZYNQMP_PM_DOMAIN_REQUESTED	BIT(0)
+/* Flag stating if the access requirement of the PM nodes is currently set */
+#define ZYNQMP_PM_DOMAIN_POWERED	BIT(1)
 
 static const struct zynqmp_eemi_ops *eemi_ops;
 
@@ -80,6 +82,14 @@ static int zynqmp_gpd_power_on(struct generic_pm_domain *domain)
 		return -ENXIO;
 
 	pd = container_of(domain, struct zynqmp_pm_domain, gpd);
+
+	/* The node may already be powered since it was requested */
+	if (pd->flags & ZYNQMP_PM_DOMAIN_POWERED) {
+		pr_debug("%s() %s domain is already powered\n",
+			 __func__, domain->name);
+		return 0;
+	}
+
 	ret = eemi_ops->set_requirement(pd->node_id,
 					ZYNQMP_PM_CAPABILITY_ACCESS,
 					ZYNQMP_PM_MAX_QOS,
@@ -90,6 +100,8 @@ static int zynqmp_gpd_power_on(struct generic_pm_domain *domain)
 		return ret;
 	}
 
+	pd->flags |= ZYNQMP_PM_DOMAIN_POWERED;
+
 	pr_debug("%s() Powered on %s domain\n", __func__, domain->name);
 	return 0;
 }
@@ -146,6 +158,8 @@ static int zynqmp_gpd_power_off(struct generic_pm_domain *domain)
 		return ret;
 	}
 
+	pd->flags &= ~ZYNQMP_PM_DOMAIN_POWERED;
+
 	pr_debug("%s() Powered off %s domain\n", __func__, domain->name);
 	return 0;
 }
@@ -168,11 +182,26 @@ static int zynqmp_gpd_attach_dev(struct generic_pm_domain *domain,
 
 	pd = container_of(domain, struct zynqmp_pm_domain, gpd);
 
+	/*
+	 * The firmware power domains have no dependencies between each other
+	 * that aren't already expressed by the device hierarchy, so let the
+	 * devices suspend and resume asynchronously. The domain transitions
+	 * of independent devices then no longer wait for each other.
+	 */
+	device_enable_async_suspend(dev);
+
 	/* If this is not the first device to attach there is nothing to do */
 	if (domain->device_count)
 		return 0;
 
-	ret = eemi_ops->request_node(pd->node_id, 0, 0,
+	/*
+	 * genpd powers the domain on right after the first device attaches,
+	 * so request the node with the access requirement already set. This
+	 * saves the set_requirement call in zynqmp_gpd_power_on().
+	 */
+	ret = eemi_ops->request_node(pd->node_id,
+				     ZYNQMP_PM_CAPABILITY_ACCESS,
+				     ZYNQMP_PM_MAX_QOS,
 				     ZYNQMP_PM_REQUEST_ACK_BLOCKING);
 	/* If requesting a node fails print and return the error */
 	if (ret) {
@@ -181,7 +210,7 @@ static int zynqmp_gpd_attach_dev(struct generic_pm_domain *domain,
 		return ret;
 	}
 
-	pd->flags |= ZYNQMP_PM_DOMAIN_REQUESTED;
+	pd->flags |= ZYNQMP_PM_DOMAIN_REQUESTED | ZYNQMP_PM_DOMAIN_POWERED;
 
 	pr_debug("%s() %s attached to %s domain\n", __func__,
 		 dev_name(dev), domain->name);
@@ -216,7 +245,7 @@ static void zynqmp_gpd_detach_dev(struct generic_pm_domain *domain,
 		return;
 	}
 
-	pd->flags &= ~ZYNQMP_PM_DOMAIN_REQUESTED;
+	pd->flags &= ~(ZYNQMP_PM_DOMAIN_REQUESTED | ZYNQMP_PM_DOMAIN_POWERED);
 
 	pr_debug("%s() %s detached from %s domain\n", __func__,
 		 dev_name(dev), domain->name);
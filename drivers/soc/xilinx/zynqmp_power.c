@@ -84,27 +84,29 @@ static irqreturn_t zynqmp_pm_isr(int irq, void *data)
 static void ipi_receive_callback(struct mbox_client *cl, void *data)
 {
 	struct zynqmp_ipi_message *msg = (struct zynqmp_ipi_message *)data;
-	u32 payload[CB_PAYLOAD_SIZE];
+	u32 payload[CB_PAYLOAD_SIZE] = {0};
 	int ret;
 
-	memcpy(payload, msg->data, sizeof(msg->len));
+	memcpy(payload, msg->data, min(msg->len, sizeof(payload)));
 	/* First element is callback API ID, others are callback arguments */
-	if (payload[0] == PM_INIT_SUSPEND_CB) {
-		if (work_pending(&zynqmp_pm_init_suspend_work->callback_work))
-			return;
-
+	if (payload[0] == PM_INIT_SUSPEND_CB &&
+	    !work_pending(&zynqmp_pm_init_suspend_work->callback_work)) {
 		/* Copy callback arguments into work's structure */
 		memcpy(zynqmp_pm_init_suspend_work->args, &payload[1],
 		       sizeof(zynqmp_pm_init_suspend_work->args));
 
 		queue_work(system_unbound_wq,
 			   &zynqmp_pm_init_suspend_work->callback_work);
-
-		/* Send NULL message to mbox controller to ack the message */
-		ret = mbox_send_message(rx_chan, NULL);
-		if (ret)
-			pr_err("IPI ack failed. Error %d\n", ret);
 	}
+
+	/*
+	 * Send NULL message to mbox controller to ack the message. Every
+	 * callback is acked right away, the firmware can't send the next
+	 * one before.
+	 */
+	ret = mbox_send_message(rx_chan, NULL);
+	if (ret < 0)
+		pr_err("IPI ack failed. Error %d\n", ret);
 }
 
 /**
@@ -249,7 +251,7 @@ static int zynqmp_pm_remove(struct platform_device *pdev)
 {
 	sysfs_remove_file(&pdev->dev.kobj, &dev_attr_suspend_mode.attr);
 
-	if (!rx_chan)
+	if (rx_chan)
 		mbox_free_channel(rx_chan);
 
 	return 0;
@@ -148,13 +148,13 @@ struct xilinx_spi {
 static void xspi_read_rx_fifo_##size(struct xilinx_spi *xqspi)		\
 {									\
 	int i;								\
-	int count = (xqspi->bytes_to_receive > xqspi->buffer_size) ?	\
-			xqspi->buffer_size : xqspi->bytes_to_receive;	\
+	u32 max = xqspi->buffer_size * (size / 8);			\
+	u32 count = min(xqspi->bytes_to_receive, max);			\
 	u32 data;							\
 	for (i = 0; i < count; i += (size / 8)) {			\
 		data = readl_relaxed(xqspi->regs + XSPI_RXD_OFFSET);	\
 		if (xqspi->rx_ptr)					\
-			((type *)xqspi->rx_ptr)[i] = (type)data;	\
+			*(type *)&xqspi->rx_ptr[i] = (type)data;	\
 	}								\
 	xqspi->bytes_to_receive -= count;				\
 	if (xqspi->rx_ptr)						\
@@ -173,8 +173,8 @@ static void xspi_read_rx_fifo_##size(struct xilinx_spi *xqspi)		\
 static void xspi_fill_tx_fifo_##size(struct xilinx_spi *xqspi)		\
 {									\
 	int i;								\
-	int count = (xqspi->bytes_to_transfer > xqspi->buffer_size) ?	\
-			xqspi->buffer_size : xqspi->bytes_to_transfer;	\
+	u32 max = xqspi->buffer_size * (size / 8);			\
+	u32 count = min(xqspi->bytes_to_transfer, max);			\
 	u32 data = 0;							\
 	for (i = 0; i < count; i += (size / 8)) {			\
 		if (xqspi->tx_ptr)					\
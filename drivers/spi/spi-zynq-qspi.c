@@ -15,7 +15,9 @@
 #include <linux/of_address.h>
 #include <linux/platform_device.h>
 #include <linux/spi/spi.h>
+#include <linux/spi/spi-mem.h>
 #include <linux/workqueue.h>
+#include <asm/unaligned.h>
 
 
 /* Register offset definitions */
@@ -99,11 +101,13 @@
  * It is named Linear Configuration but it controls other modes when not in
  * linear mode also.
  */
+#define ZYNQ_QSPI_LCFG_LQ_MODE_MASK	BIT(31) /* LQSPI Linear mode Mask */
 #define ZYNQ_QSPI_LCFG_TWO_MEM_MASK	BIT(30) /* LQSPI Two memories Mask */
 #define ZYNQ_QSPI_LCFG_SEP_BUS_MASK	BIT(29) /* LQSPI Separate bus Mask */
 #define ZYNQ_QSPI_LCFG_U_PAGE_MASK	BIT(28) /* LQSPI Upper Page Mask */
 
 #define ZYNQ_QSPI_LCFG_DUMMY_SHIFT	8
+#define ZYNQ_QSPI_LCFG_DUMMY_MAX	7 /* Max dummy bytes in linear mode */
 
 #define ZYNQ_QSPI_FAST_READ_QOUT_CODE	0x6B /* read instruction code */
 #define ZYNQ_QSPI_FIFO_DEPTH		63 /* FIFO depth in words */
@@ -132,6 +136,8 @@
  * @is_dual:		Flag to indicate whether dual flash memories are used
  * @is_instr:		Flag to indicate if transfer contains an instruction
  *			(Used in dual parallel configuration)
+ * @linear:		Virtual address of the linear read window
+ * @linear_size:	Size of the linear read window
  */
 struct zynq_qspi {
 	void __iomem *regs;
@@ -144,6 +150,8 @@ struct zynq_qspi {
 	int rx_bytes;
 	u32 is_dual;
 	u8 is_instr;
+	void __iomem *linear;
+	resource_size_t linear_size;
 };
 
 /*
@@ -642,6 +650,149 @@ static int zynq_qspi_start_transfer(struct spi_master *master,
 	return transfer->len;
 }
 
+/**
+ * zynq_qspi_linear_copy - Copy data from the linear read window
+ * @buf:	Destination buffer
+ * @src:	Source address in the linear window
+ * @len:	Number of bytes to copy
+ *
+ * memcpy_fromio() reads the window byte by byte on ARM, so the bulk of the
+ * data is read with 32 bit accesses, each one of them being a single AXI
+ * read burst of the linear adapter.
+ */
+static void zynq_qspi_linear_copy(u8 *buf, const void __iomem *src,
+				  size_t len)
+{
+	size_t head = min_t(size_t, len, -(uintptr_t)src & 3);
+
+	memcpy_fromio(buf, src, head);
+	buf += head;
+	src += head;
+	len -= head;
+
+	if (IS_ALIGNED((uintptr_t)buf, 4)) {
+		__ioread32_copy(buf, src, len / 4);
+		buf += len & ~3;
+		src += len & ~3;
+	} else {
+		for (; len >= 4; len -= 4, buf += 4, src += 4)
+			put_unaligned(__raw_readl(src), (u32 *)buf);
+	}
+
+	memcpy_fromio(buf, src, len & 3);
+}
+
+/**
+ * zynq_qspi_exec_op - Execute a spi-mem operation
+ * @mem:	Pointer to the spi_mem structure
+ * @op:		Memory operation to execute
+ *
+ * Only the direct mapped reads are accelerated, regular operations are
+ * left to the SPI core which runs them as IO mode transfers.
+ *
+ * Return:	Always -ENOTSUPP
+ */
+static int zynq_qspi_exec_op(struct spi_mem *mem, const struct spi_mem_op *op)
+{
+	return -ENOTSUPP;
+}
+
+/**
+ * zynq_qspi_dirmap_create - Check if a direct mapping can use linear mode
+ * @desc:	Direct mapping descriptor
+ *
+ * The linear adapter issues the read commands itself, with 3 address bytes
+ * and a mapping of at most the size of the linear window. The dual flash
+ * configurations are left to the IO mode, as they interleave or page the
+ * flash address space.
+ *
+ * Return:	0 if the linear window can be used, -ENOTSUPP otherwise
+ */
+static int zynq_qspi_dirmap_create(struct spi_mem_dirmap_desc *desc)
+{
+	struct spi_device *spi = desc->mem->spi;
+	struct zynq_qspi *xqspi = spi_master_get_devdata(spi->master);
+	const struct spi_mem_op *op = &desc->info.op_tmpl;
+
+	if (!xqspi->linear || xqspi->is_dual ||
+	    IS_ENABLED(CONFIG_SPI_ZYNQ_QSPI_DUAL_STACKED) ||
+	    spi->chip_select || gpio_is_valid(spi->cs_gpio))
+		return -ENOTSUPP;
+
+	if (op->data.dir != SPI_MEM_DATA_IN || op->addr.nbytes != 3 ||
+	    op->cmd.buswidth != 1 || op->addr.buswidth != 1 ||
+	    op->dummy.nbytes > ZYNQ_QSPI_LCFG_DUMMY_MAX)
+		return -ENOTSUPP;
+
+	if (desc->info.offset + desc->info.length > xqspi->linear_size)
+		return -ENOTSUPP;
+
+	return 0;
+}
+
+/**
+ * zynq_qspi_dirmap_read - Read through the linear read window
+ * @desc:	Direct mapping descriptor
+ * @offs:	Offset within the direct mapping
+ * @len:	Number of bytes to read
+ * @buf:	Destination buffer
+ *
+ * The controller is switched to linear mode for the duration of the read,
+ * and back to the IO mode used by the regular transfers afterwards.
+ *
+ * Return:	Number of bytes read, or error value
+ */
+static ssize_t zynq_qspi_dirmap_read(struct spi_mem_dirmap_desc *desc,
+				     u64 offs, size_t len, void *buf)
+{
+	struct spi_device *spi = desc->mem->spi;
+	struct spi_master *master = spi->master;
+	struct zynq_qspi *xqspi = spi_master_get_devdata(master);
+	const struct spi_mem_op *op = &desc->info.op_tmpl;
+	u64 addr = desc->info.offset + offs;
+	u32 config_reg, lcfg_reg;
+	int ret;
+
+	len = min_t(u64, len, xqspi->linear_size - addr);
+
+	ret = zynq_prepare_transfer_hardware(master);
+	if (ret)
+		return ret;
+
+	zynq_qspi_config_op(spi, NULL);
+
+	/* Let the linear adapter drive the chip select and the start */
+	zynq_qspi_write(xqspi, ZYNQ_QSPI_ENABLE_OFFSET, 0);
+	config_reg = zynq_qspi_read(xqspi, ZYNQ_QSPI_CONFIG_OFFSET);
+	lcfg_reg = zynq_qspi_read(xqspi, ZYNQ_QSPI_LINEAR_CFG_OFFSET);
+	zynq_qspi_write(xqspi, ZYNQ_QSPI_CONFIG_OFFSET,
+			config_reg & ~(ZYNQ_QSPI_CONFIG_SSFORCE_MASK |
+				       ZYNQ_QSPI_CONFIG_MANSRTEN_MASK |
+				       ZYNQ_QSPI_CONFIG_SSCTRL_MASK));
+	zynq_qspi_write(xqspi, ZYNQ_QSPI_LINEAR_CFG_OFFSET,
+			ZYNQ_QSPI_LCFG_LQ_MODE_MASK |
+			(op->dummy.nbytes << ZYNQ_QSPI_LCFG_DUMMY_SHIFT) |
+			op->cmd.opcode);
+	zynq_qspi_write(xqspi, ZYNQ_QSPI_ENABLE_OFFSET,
+			ZYNQ_QSPI_ENABLE_ENABLE_MASK);
+
+	zynq_qspi_linear_copy(buf, xqspi->linear + addr, len);
+
+	zynq_qspi_write(xqspi, ZYNQ_QSPI_ENABLE_OFFSET, 0);
+	zynq_qspi_write(xqspi, ZYNQ_QSPI_LINEAR_CFG_OFFSET, lcfg_reg);
+	zynq_qspi_write(xqspi, ZYNQ_QSPI_CONFIG_OFFSET, config_reg);
+
+	zynq_unprepare_transfer_hardware(master);
+
+	return len;
+}
+
+static const struct spi_controller_mem_ops zynq_qspi_mem_ops = {
+	.exec_op = zynq_qspi_exec_op,
+	.dirmap_create = zynq_qspi_dirmap_create,
+	.dirmap_read = zynq_qspi_dirmap_read,
+};
+
 /**
  * zynq_qspi_suspend - Suspend method for the QSPI driver
  * @_dev:	Address of the platform_device structure
@@ -731,6 +882,17 @@ static int zynq_qspi_probe(struct platform_device *pdev)
 		goto remove_master;
 	}
 
+	/* The linear read window is optional */
+	res = platform_get_resource(pdev, IORESOURCE_MEM, 1);
+	if (res) {
+		xqspi->linear = devm_ioremap_resource(&pdev->dev, res);
+		if (IS_ERR(xqspi->linear)) {
+			ret = PTR_ERR(xqspi->linear);
+			goto remove_master;
+		}
+		xqspi->linear_size = resource_size(res);
+	}
+
 	if (of_property_read_u32(pdev->dev.of_node, "is-dual",
 				 &xqspi->is_dual)) {
 		dev_warn(&pdev->dev, "couldn't determine configuration info");
@@ -787,6 +949,7 @@ static int zynq_qspi_probe(struct platform_device *pdev)
 	else
 		ctlr->num_chipselect = num_cs;
 
+	ctlr->mem_ops = &zynq_qspi_mem_ops;
 	ctlr->setup = zynq_qspi_setup_op;
 	ctlr->set_cs = zynq_qspi_chipselect;
 	ctlr->transfer_one = zynq_qspi_start_transfer;
@@ -7,6 +7,7 @@
  */
 
 #include <linux/clk.h>
+#include <linux/completion.h>
 #include <linux/delay.h>
 #include <linux/dma-mapping.h>
 #include <linux/dmaengine.h>
@@ -19,7 +20,9 @@
 #include <linux/of_device.h>
 #include <linux/platform_device.h>
 #include <linux/pm_runtime.h>
+#include <linux/sizes.h>
 #include <linux/spi/spi.h>
+#include <linux/spi/spi-mem.h>
 #include <linux/spinlock.h>
 #include <linux/workqueue.h>
 
@@ -162,6 +165,11 @@
 #define IOU_TAPDLY_BYPASS_MASK	0x7
 
 #define SPI_AUTOSUSPEND_TIMEOUT		3000
+
+/* Bounce buffer used to DMA reads into buffers the DMA can't reach */
+#define GQSPI_BOUNCE_SIZE		SZ_64K
+/* Max address and dummy bytes of a memory operation */
+#define GQSPI_MEM_OP_HDR_MAX		16
 enum mode_type {GQSPI_MODE_IO, GQSPI_MODE_DMA};
 static const struct zynqmp_eemi_ops *eemi_ops;
 
@@ -196,6 +204,9 @@ struct qspi_platform_data {
  * @speed_hz:		Current SPI bus clock speed in hz
  * @io_mode:		Defines the operating mode, either IO or dma
  * @has_tapdelay:	Used for tapdelay register available in qspi
+ * @mem_op:		Set while a spi-mem operation is running
+ * @data_completion:	Completion of a spi-mem operation phase
+ * @bounce_buf:		DMA bounce buffer of the spi-mem reads
  */
 struct zynqmp_qspi {
 	void __iomem *regs;
@@ -219,6 +230,9 @@ struct zynqmp_qspi {
 	u32 speed_hz;
 	bool io_mode;
 	bool has_tapdelay;
+	bool mem_op;
+	struct completion data_completion;
+	void *bounce_buf;
 };
 
 /**
@@ -829,7 +843,10 @@ static irqreturn_t zynqmp_qspi_irq(int irq, void *dev_id)
 			&& ((status & GQSPI_IRQ_MASK) == GQSPI_IRQ_MASK)) {
 		zynqmp_disable_intr(xqspi);
 		xqspi->isinstr = false;
-		spi_finalize_current_transfer(master);
+		if (xqspi->mem_op)
+			complete(&xqspi->data_completion);
+		else
+			spi_finalize_current_transfer(master);
 		ret = IRQ_HANDLED;
 	}
 
@@ -1091,6 +1108,161 @@ static int zynqmp_qspi_start_transfer(struct spi_master *master,
 	return transfer->len;
 }
 
+/**
+ * zynqmp_qspi_mem_xfer -	Run one phase of a spi-mem operation
+ * @master:	Pointer to the spi_master structure
+ * @qspi:	Pointer to the spi_device structure
+ * @transfer:	Transfer describing the phase
+ *
+ * Return:	0 on success, -ETIMEDOUT if the phase didn't complete
+ */
+static int zynqmp_qspi_mem_xfer(struct spi_master *master,
+				struct spi_device *qspi,
+				struct spi_transfer *transfer)
+{
+	struct zynqmp_qspi *xqspi = spi_master_get_devdata(master);
+	u64 ms;
+
+	if (!transfer->len)
+		return 0;
+
+	/* Same timeout as the SPI core uses for a transfer */
+	ms = div_u64(8ULL * MSEC_PER_SEC * transfer->len, transfer->speed_hz);
+	ms += ms + 200;
+
+	reinit_completion(&xqspi->data_completion);
+	zynqmp_qspi_start_transfer(master, qspi, transfer);
+	if (!wait_for_completion_timeout(&xqspi->data_completion,
+					 msecs_to_jiffies(ms))) {
+		zynqmp_disable_intr(xqspi);
+		dev_err(xqspi->dev, "spi-mem operation timed out\n");
+		return -ETIMEDOUT;
+	}
+
+	return 0;
+}
+
+/**
+ * zynqmp_qspi_mem_read -	Read a chunk of a memory array
+ * @mem:	Pointer to the spi_mem structure
+ * @op:		Memory read operation
+ * @addr:	Address of the chunk
+ * @buf:	Buffer to read the chunk into
+ * @len:	Size of the chunk
+ *
+ * The opcode, the address and dummy cycles, and the data are sent as three
+ * phases within a single chip select, as the SPI NOR layer would do with
+ * a message, without going through the SPI message queue.
+ *
+ * Return:	0 on success; error value otherwise
+ */
+static int zynqmp_qspi_mem_read(struct spi_mem *mem,
+				const struct spi_mem_op *op, u64 addr,
+				void *buf, u32 len)
+{
+	struct spi_device *qspi = mem->spi;
+	struct spi_master *master = qspi->master;
+	struct spi_transfer transfer[3] = { };
+	u8 hdr[GQSPI_MEM_OP_HDR_MAX];
+	u32 speed_hz = qspi->max_speed_hz ?: master->max_speed_hz;
+	u8 opcode = op->cmd.opcode;
+	int i, ret = 0;
+
+	for (i = 0; i < op->addr.nbytes; i++)
+		hdr[i] = addr >> (8 * (op->addr.nbytes - i - 1));
+	memset(hdr + op->addr.nbytes, 0xff, op->dummy.nbytes);
+
+	transfer[0].tx_buf = &opcode;
+	transfer[0].len = sizeof(opcode);
+	transfer[0].tx_nbits = op->cmd.buswidth;
+
+	transfer[1].tx_buf = hdr;
+	transfer[1].len = op->addr.nbytes + op->dummy.nbytes;
+	transfer[1].tx_nbits = op->addr.buswidth;
+	transfer[1].dummy = op->dummy.nbytes * 8;
+
+	transfer[2].rx_buf = buf;
+	transfer[2].len = len;
+	transfer[2].rx_nbits = op->data.buswidth;
+	transfer[2].stripe = !!(master->flags & SPI_MASTER_DATA_STRIPE);
+
+	for (i = 0; i < ARRAY_SIZE(transfer); i++)
+		transfer[i].speed_hz = speed_hz;
+
+	zynqmp_qspi_chipselect(qspi, false);
+	for (i = 0; i < ARRAY_SIZE(transfer) && !ret; i++)
+		ret = zynqmp_qspi_mem_xfer(master, qspi, &transfer[i]);
+	zynqmp_qspi_chipselect(qspi, true);
+
+	return ret;
+}
+
+/**
+ * zynqmp_qspi_exec_op -	Execute a spi-mem operation
+ * @mem:	Pointer to the spi_mem structure
+ * @op:		Memory operation to execute
+ *
+ * Memory array reads are run here, straight from the caller context. When
+ * the destination buffer can't be used for DMA (vmalloc or unaligned
+ * buffers, as used by UBI), the read goes through the bounce buffer chunk
+ * by chunk instead of falling back to the IO mode. In dual parallel mode
+ * the data is striped across both flashes, so each chunk moves the
+ * address of the flashes by half its size. The stacked mode chip select is
+ * handled by zynqmp_qspi_chipselect() as for the regular transfers.
+ *
+ * Return:	0 on success, -ENOTSUPP to let the SPI core run the operation
+ *		with regular transfers, error value otherwise
+ */
+static int zynqmp_qspi_exec_op(struct spi_mem *mem,
+			       const struct spi_mem_op *op)
+{
+	struct spi_master *master = mem->spi->master;
+	struct zynqmp_qspi *xqspi = spi_master_get_devdata(master);
+	bool stripe = master->flags & SPI_MASTER_DATA_STRIPE;
+	u32 len = op->data.nbytes, done = 0, chunk;
+	u8 *buf = op->data.buf.in;
+	bool bounce;
+	int ret = 0;
+
+	/* Only the memory array reads are worth optimizing */
+	if (op->data.dir != SPI_MEM_DATA_IN || !op->addr.nbytes ||
+	    op->addr.nbytes + op->dummy.nbytes > GQSPI_MEM_OP_HDR_MAX ||
+	    (op->dummy.nbytes && op->dummy.buswidth != op->addr.buswidth))
+		return -ENOTSUPP;
+
+	bounce = xqspi->bounce_buf && len >= 8 &&
+		 (is_vmalloc_addr(buf) ||
+		  ((uintptr_t)buf & GQSPI_DMA_UNALIGN));
+
+	xqspi->mem_op = true;
+	zynqmp_prepare_transfer_hardware(master);
+
+	while (done < len && !ret) {
+		u64 addr = op->addr.val + (stripe ? done / 2 : done);
+
+		if (!bounce) {
+			ret = zynqmp_qspi_mem_read(mem, op, addr, buf, len);
+			break;
+		}
+
+		chunk = min_t(u32, len - done, GQSPI_BOUNCE_SIZE);
+		ret = zynqmp_qspi_mem_read(mem, op, addr, xqspi->bounce_buf,
+					   chunk);
+		if (!ret)
+			memcpy(buf + done, xqspi->bounce_buf, chunk);
+		done += chunk;
+	}
+
+	zynqmp_unprepare_transfer_hardware(master);
+	xqspi->mem_op = false;
+
+	return ret;
+}
+
+static const struct spi_controller_mem_ops zynqmp_qspi_mem_ops = {
+	.exec_op = zynqmp_qspi_exec_op,
+};
+
 /**
  * zynqmp_qspi_suspend -	Suspend method for the QSPI driver
  * @dev:	Address of the platform_device structure
@@ -1357,6 +1529,18 @@ static int zynqmp_qspi_probe(struct platform_device *pdev)
 		master->num_chipselect = num_cs;
 
 	dma_set_mask(&pdev->dev, DMA_BIT_MASK(44));
+
+	init_completion(&xqspi->data_completion);
+	if (!xqspi->io_mode) {
+		xqspi->bounce_buf = devm_kmalloc(dev, GQSPI_BOUNCE_SIZE,
+						 GFP_KERNEL);
+		if (!xqspi->bounce_buf) {
+			ret = -ENOMEM;
+			goto clk_dis_all;
+		}
+	}
+
+	master->mem_ops = &zynqmp_qspi_mem_ops;
 	master->setup = zynqmp_qspi_setup;
 	master->set_cs = zynqmp_qspi_chipselect;
 	master->transfer_one = zynqmp_qspi_start_transfer;
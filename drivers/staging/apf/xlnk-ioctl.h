@@ -16,6 +16,8 @@
 #define XLNK_IOCDMASUBMIT	_IOWR(XLNK_IOC_MAGIC, 8, unsigned long)
 #define XLNK_IOCDMAWAIT		_IOWR(XLNK_IOC_MAGIC, 9, unsigned long)
 #define XLNK_IOCDMARELEASE	_IOWR(XLNK_IOC_MAGIC, 10, unsigned long)
+#define XLNK_IOCDMASUBMITBATCH	_IOWR(XLNK_IOC_MAGIC, 11, unsigned long)
+#define XLNK_IOCDMAWAITBATCH	_IOWR(XLNK_IOC_MAGIC, 12, unsigned long)
 
 #define XLNK_IOCMEMOP		_IOWR(XLNK_IOC_MAGIC, 25, unsigned long)
 #define XLNK_IOCDEVREGISTER	_IOWR(XLNK_IOC_MAGIC, 16, unsigned long)
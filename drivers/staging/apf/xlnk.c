@@ -26,14 +26,21 @@
 #include <linux/errno.h>
 #include <linux/fs.h>
 #include <linux/gfp.h>
+#include <linux/huge_mm.h>
+#include <linux/idr.h>
 #include <linux/io.h>
+#include <linux/io_uring.h>
 #include <linux/list.h>
 #include <linux/mm.h>
+#include <linux/mman.h>
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/pagemap.h>
+#include <linux/pfn_t.h>
 #include <linux/platform_device.h>
 #include <linux/pm.h>
+#include <linux/property.h>
+#include <linux/rbtree.h>
 #include <linux/sched.h>
 #include <linux/semaphore.h>
 #include <linux/slab.h>
@@ -74,6 +81,13 @@ static unsigned int xlnk_bufcacheable[XLNK_BUF_POOL_SIZE];
 static struct file *xlnk_buf_filp[XLNK_BUF_POOL_SIZE];
 static spinlock_t xlnk_buf_lock;
 
+/* buffer ids and address indexes, the trees are protected by xlnk_buf_lock */
+static DEFINE_IDA(xlnk_buf_ida);
+static struct rb_root xlnk_buf_phys_root = RB_ROOT;
+static struct rb_node xlnk_buf_phys_node[XLNK_BUF_POOL_SIZE];
+static struct rb_root xlnk_buf_user_root = RB_ROOT;
+static struct rb_node xlnk_buf_user_node[XLNK_BUF_POOL_SIZE];
+
 #define XLNK_IRQ_POOL_SIZE 256
 static struct xlnk_irq_control *xlnk_irq_set[XLNK_IRQ_POOL_SIZE];
 static spinlock_t xlnk_irq_lock;
@@ -182,26 +196,61 @@ static void xlnk_devpacks_free_all(void)
 	}
 }
 
-static int xlnk_buf_findnull(void)
+static void xlnk_buf_phys_insert(int id)
+{
+	struct rb_node **link = &xlnk_buf_phys_root.rb_node;
+	struct rb_node *parent = NULL;
+
+	while (*link) {
+		parent = *link;
+		if (xlnk_phyaddr[id] <
+		    xlnk_phyaddr[parent - xlnk_buf_phys_node])
+			link = &parent->rb_left;
+		else
+			link = &parent->rb_right;
+	}
+
+	rb_link_node(&xlnk_buf_phys_node[id], parent, link);
+	rb_insert_color(&xlnk_buf_phys_node[id], &xlnk_buf_phys_root);
+}
+
+static int xlnk_buf_find_by_phys_addr(xlnk_intptr_type addr)
 {
+	struct rb_node *node = xlnk_buf_phys_root.rb_node;
 	int i;
 
-	for (i = 1; i < XLNK_BUF_POOL_SIZE; i++) {
-		if (!xlnk_bufpool[i])
+	while (node) {
+		i = node - xlnk_buf_phys_node;
+		if (addr < xlnk_phyaddr[i])
+			node = node->rb_left;
+		else if (addr >= xlnk_phyaddr[i] + xlnk_buflen[i])
+			node = node->rb_right;
+		else
 			return i;
 	}
 
 	return 0;
 }
 
-static int xlnk_buf_find_by_phys_addr(xlnk_intptr_type addr)
+/*
+ * return the id of a buffer mapped by process pid which overlaps the user
+ * address range [start, end), the mappings of a process never overlap
+ */
+static int xlnk_buf_find_user_range(xlnk_intptr_type start,
+				    xlnk_intptr_type end, int pid)
 {
+	struct rb_node *node = xlnk_buf_user_root.rb_node;
 	int i;
 
-	for (i = 1; i < XLNK_BUF_POOL_SIZE; i++) {
-		if (xlnk_bufpool[i] &&
-		    xlnk_phyaddr[i] <= addr &&
-		    xlnk_phyaddr[i] + xlnk_buflen[i] > addr)
+	while (node) {
+		i = node - xlnk_buf_user_node;
+		if (pid < xlnk_buf_process[i] ||
+		    (pid == xlnk_buf_process[i] && end <= xlnk_userbuf[i]))
+			node = node->rb_left;
+		else if (pid != xlnk_buf_process[i] ||
+			 start >= xlnk_userbuf[i] + xlnk_buflen[i])
+			node = node->rb_right;
+		else
 			return i;
 	}
 
@@ -210,17 +259,48 @@ static int xlnk_buf_find_by_phys_addr(xlnk_intptr_type addr)
 
 static int xlnk_buf_find_by_user_addr(xlnk_intptr_type addr, int pid)
 {
+	return xlnk_buf_find_user_range(addr, addr + 1, pid);
+}
+
+static void xlnk_buf_user_erase(int id)
+{
+	if (RB_EMPTY_NODE(&xlnk_buf_user_node[id]))
+		return;
+
+	rb_erase(&xlnk_buf_user_node[id], &xlnk_buf_user_root);
+	RB_CLEAR_NODE(&xlnk_buf_user_node[id]);
+}
+
+/*
+ * index the user mapping of a buffer, mappings already indexed at the same
+ * addresses for the process are stale and get dropped
+ */
+static void xlnk_buf_user_insert(int id, xlnk_intptr_type vaddr, int pid)
+{
+	struct rb_node **link = &xlnk_buf_user_root.rb_node;
+	struct rb_node *parent = NULL;
 	int i;
 
-	for (i = 1; i < XLNK_BUF_POOL_SIZE; i++) {
-		if (xlnk_bufpool[i] &&
-		    xlnk_buf_process[i] == pid &&
-		    xlnk_userbuf[i] <= addr &&
-		    xlnk_userbuf[i] + xlnk_buflen[i] > addr)
-			return i;
+	xlnk_buf_user_erase(id);
+	while ((i = xlnk_buf_find_user_range(vaddr, vaddr + xlnk_buflen[id],
+					     pid)))
+		xlnk_buf_user_erase(i);
+
+	xlnk_userbuf[id] = vaddr;
+	xlnk_buf_process[id] = pid;
+
+	while (*link) {
+		parent = *link;
+		i = parent - xlnk_buf_user_node;
+		if (pid < xlnk_buf_process[i] ||
+		    (pid == xlnk_buf_process[i] && vaddr < xlnk_userbuf[i]))
+			link = &parent->rb_left;
+		else
+			link = &parent->rb_right;
 	}
 
-	return 0;
+	rb_link_node(&xlnk_buf_user_node[id], parent, link);
+	rb_insert_color(&xlnk_buf_user_node[id], &xlnk_buf_user_root);
 }
 
 /*
@@ -245,20 +325,22 @@ static int xlnk_allocbuf(struct file *filp, unsigned int len,
 	if (!kaddr)
 		return -ENOMEM;
 
-	spin_lock(&xlnk_buf_lock);
-	id = xlnk_buf_findnull();
-	if (id > 0 && id < XLNK_BUF_POOL_SIZE) {
-		xlnk_bufpool_alloc_point[id] = kaddr;
-		xlnk_bufpool[id] = kaddr;
-		xlnk_buflen[id] = len;
-		xlnk_bufcacheable[id] = cacheable;
-		xlnk_phyaddr[id] = phys_addr_anchor;
-		xlnk_buf_filp[id] = filp;
+	id = ida_alloc_range(&xlnk_buf_ida, 1, XLNK_BUF_POOL_SIZE - 1,
+			     GFP_KERNEL);
+	if (id < 0) {
+		dma_free_attrs(xlnk_dev, len, kaddr, phys_addr_anchor, attrs);
+		return -ENOMEM;
 	}
-	spin_unlock(&xlnk_buf_lock);
 
-	if (id <= 0 || id >= XLNK_BUF_POOL_SIZE)
-		return -ENOMEM;
+	spin_lock(&xlnk_buf_lock);
+	xlnk_bufpool_alloc_point[id] = kaddr;
+	xlnk_bufpool[id] = kaddr;
+	xlnk_buflen[id] = len;
+	xlnk_bufcacheable[id] = cacheable;
+	xlnk_phyaddr[id] = phys_addr_anchor;
+	xlnk_buf_filp[id] = filp;
+	xlnk_buf_phys_insert(id);
+	spin_unlock(&xlnk_buf_lock);
 
 	return id;
 }
@@ -476,10 +558,13 @@ static int xlnk_freebuf(int id)
 	if (id <= 0 || id >= XLNK_BUF_POOL_SIZE)
 		return -ENOMEM;
 
-	if (!xlnk_bufpool[id])
-		return -ENOMEM;
-
 	spin_lock(&xlnk_buf_lock);
+	if (!xlnk_bufpool[id]) {
+		spin_unlock(&xlnk_buf_lock);
+		return -ENOMEM;
+	}
+	rb_erase(&xlnk_buf_phys_node[id], &xlnk_buf_phys_root);
+	xlnk_buf_user_erase(id);
 	alloc_point = xlnk_bufpool_alloc_point[id];
 	p_addr = xlnk_phyaddr[id];
 	buf_len = xlnk_buflen[id];
@@ -491,6 +576,8 @@ static int xlnk_freebuf(int id)
 	xlnk_bufcacheable[id] = 0;
 	spin_unlock(&xlnk_buf_lock);
 
+	ida_free(&xlnk_buf_ida, id);
+
 	attrs = cacheable ? DMA_ATTR_NON_CONSISTENT : 0;
 
 	dma_free_attrs(xlnk_dev,
@@ -706,11 +793,10 @@ static int xlnk_dmasubmit_ioctl(struct file *filp, unsigned int code,
 					&dmahead,
 					cp);
 
-	temp_args.dmasubmit.dmahandle = (xlnk_intptr_type)dmahead;
-	temp_args.dmasubmit.last_bd_index =
-		(xlnk_intptr_type)dmahead->last_bd_index;
-
 	if (!status) {
+		temp_args.dmasubmit.dmahandle = (xlnk_intptr_type)dmahead;
+		temp_args.dmasubmit.last_bd_index =
+			(xlnk_intptr_type)dmahead->last_bd_index;
 		if (copy_to_user((void __user *)args,
 				 &temp_args,
 				 sizeof(union xlnk_args)))
@@ -758,6 +844,44 @@ static int xlnk_dmawait_ioctl(struct file *filp,
 	return status;
 }
 
+/*
+ * Submit or wait for a batch of transfers with one call, each entry of the
+ * user array is handled as by XLNK_IOCDMASUBMIT or XLNK_IOCDMAWAIT and the
+ * batch stops at the first entry which fails.
+ */
+static int xlnk_dmabatch_ioctl(struct file *filp, unsigned int code,
+			       unsigned long args)
+{
+	union xlnk_args temp_args;
+	union xlnk_args __user *uargs;
+	unsigned int i;
+	int status = 0;
+
+	if (copy_from_user(&temp_args, (void __user *)args,
+			   sizeof(union xlnk_args)))
+		return -EFAULT;
+
+	uargs = (union xlnk_args __user *)(uintptr_t)temp_args.dmabatch.args;
+	for (i = 0; i < temp_args.dmabatch.count; i++) {
+		if (code == XLNK_IOCDMASUBMITBATCH)
+			status = xlnk_dmasubmit_ioctl(filp, XLNK_IOCDMASUBMIT,
+						      (unsigned long)&uargs[i]);
+		else
+			status = xlnk_dmawait_ioctl(filp, XLNK_IOCDMAWAIT,
+						    (unsigned long)&uargs[i]);
+		if (status)
+			break;
+	}
+
+	temp_args.dmabatch.count = i;
+	if (copy_to_user((void __user *)args, &temp_args,
+			 sizeof(union xlnk_args)))
+		return -EFAULT;
+
+	/* a partial batch succeeds, the caller checks the returned count */
+	return i ? 0 : status;
+}
+
 static int xlnk_dmarelease_ioctl(struct file *filp, unsigned int code,
 				 unsigned long args)
 {
@@ -1136,7 +1260,8 @@ static int xlnk_memop_ioctl(struct file *filp, unsigned long arg_addr)
 
 	dmadir = (enum dma_data_direction)args.memop.dir;
 
-	if (args.memop.flags & XLNK_FLAG_COHERENT || !cacheable)
+	if (args.memop.flags & XLNK_FLAG_COHERENT || !cacheable ||
+	    device_get_dma_attr(xlnk_dev) == DEV_DMA_COHERENT)
 		attrs |= DMA_ATTR_SKIP_CPU_SYNC;
 
 	if (buf_id > 0) {
@@ -1242,6 +1367,9 @@ static long xlnk_ioctl(struct file *filp,
 		return xlnk_dmawait_ioctl(filp, code, args);
 	case XLNK_IOCDMARELEASE:
 		return xlnk_dmarelease_ioctl(filp, code, args);
+	case XLNK_IOCDMASUBMITBATCH:
+	case XLNK_IOCDMAWAITBATCH:
+		return xlnk_dmabatch_ioctl(filp, code, args);
 	case XLNK_IOCDEVREGISTER:
 		return xlnk_devregister_ioctl(filp, code, args);
 	case XLNK_IOCDMAREGISTER:
@@ -1267,6 +1395,129 @@ static long xlnk_ioctl(struct file *filp,
 	}
 }
 
+/*
+ * Waits, allocations and DMA channel requests are issued from an io_uring
+ * async worker, the others from the submitter.
+ */
+static long xlnk_uring_cmd(struct file *filp, unsigned int code,
+			   unsigned long args, unsigned int issue_flags)
+{
+	if (issue_flags & IO_URING_F_NONBLOCK) {
+		switch (code) {
+		case XLNK_IOCALLOCBUF:
+		case XLNK_IOCDMAREQUEST:
+		case XLNK_IOCDMAWAIT:
+		case XLNK_IOCDMAWAITBATCH:
+		case XLNK_IOCIRQWAIT:
+		case XLNK_IOCSHUTDOWN:
+		case XLNK_IOCRECRES:
+			return -EAGAIN;
+		default:
+			break;
+		}
+	}
+
+	return xlnk_ioctl(filp, code, args);
+}
+
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+/*
+ * Buffers of at least PMD_SIZE are mapped on fault, with PMD entries where
+ * the buffer is PMD aligned, instead of the PTEs of remap_pfn_range().
+ */
+static vm_fault_t xlnk_buf_huge_fault(struct vm_fault *vmf,
+				      enum page_entry_size pe_size)
+{
+	struct vm_area_struct *vma = vmf->vma;
+	int bufid = vma->vm_pgoff >> (16 - PAGE_SHIFT);
+	unsigned long addr = vmf->address;
+	unsigned long offset;
+	phys_addr_t phys;
+	size_t len;
+
+	if (pe_size == PE_SIZE_PMD)
+		addr &= PMD_MASK;
+	else if (pe_size != PE_SIZE_PTE)
+		return VM_FAULT_FALLBACK;
+
+	spin_lock(&xlnk_buf_lock);
+	phys = xlnk_phyaddr[bufid];
+	len = xlnk_buflen[bufid];
+	spin_unlock(&xlnk_buf_lock);
+
+	offset = addr - vma->vm_start;
+	if (!phys || offset >= len)
+		return VM_FAULT_SIGBUS;
+	phys += offset;
+
+	if (pe_size == PE_SIZE_PTE)
+		return vmf_insert_pfn(vma, addr, PHYS_PFN(phys));
+
+	if (addr < vma->vm_start || addr + PMD_SIZE > vma->vm_end ||
+	    offset + PMD_SIZE > len || (phys & ~PMD_MASK))
+		return VM_FAULT_FALLBACK;
+
+	return vmf_insert_pfn_pmd(vmf, phys_to_pfn_t(phys, PFN_DEV),
+				  vmf->flags & FAULT_FLAG_WRITE);
+}
+
+static vm_fault_t xlnk_buf_fault(struct vm_fault *vmf)
+{
+	return xlnk_buf_huge_fault(vmf, PE_SIZE_PTE);
+}
+
+static const struct vm_operations_struct xlnk_buf_huge_vm_ops = {
+	.fault = xlnk_buf_fault,
+	.huge_fault = xlnk_buf_huge_fault,
+};
+
+static bool xlnk_mmap_huge(struct vm_area_struct *vma, int bufid)
+{
+	/* PFN mappings that can be COWed must go through remap_pfn_range() */
+	return (vma->vm_flags & VM_SHARED || !(vma->vm_flags & VM_MAYWRITE)) &&
+	       xlnk_buflen[bufid] >= PMD_SIZE &&
+	       vma->vm_end - vma->vm_start <= xlnk_buflen[bufid];
+}
+
+/* Give the mapping of a large buffer the same offset in a PMD as the buffer */
+static unsigned long xlnk_get_unmapped_area(struct file *filp,
+					    unsigned long addr,
+					    unsigned long len,
+					    unsigned long pgoff,
+					    unsigned long flags)
+{
+	int bufid = pgoff >> (16 - PAGE_SHIFT);
+	phys_addr_t phys = 0;
+	unsigned long ret;
+
+	if (addr || (flags & MAP_FIXED) || len < PMD_SIZE ||
+	    bufid <= 0 || bufid >= XLNK_BUF_POOL_SIZE)
+		goto fallback;
+
+	spin_lock(&xlnk_buf_lock);
+	if (xlnk_buflen[bufid] >= PMD_SIZE)
+		phys = xlnk_phyaddr[bufid];
+	spin_unlock(&xlnk_buf_lock);
+	if (!phys || len + PMD_SIZE < len)
+		goto fallback;
+
+	ret = current->mm->get_unmapped_area(filp, 0, len + PMD_SIZE, pgoff,
+					     flags);
+	if (IS_ERR_VALUE(ret))
+		goto fallback;
+
+	return ret + ((phys - ret) & ~PMD_MASK);
+
+fallback:
+	return current->mm->get_unmapped_area(filp, addr, len, pgoff, flags);
+}
+#else
+static bool xlnk_mmap_huge(struct vm_area_struct *vma, int bufid)
+{
+	return false;
+}
+#endif
+
 /* This function maps kernel space memory to user space memory. */
 static int xlnk_mmap(struct file *filp, struct vm_area_struct *vma)
 {
@@ -1287,13 +1538,25 @@ static int xlnk_mmap(struct file *filp, struct vm_area_struct *vma)
 		if (xlnk_bufcacheable[bufid] == 0)
 			vma->vm_page_prot =
 				pgprot_noncached(vma->vm_page_prot);
-		status = remap_pfn_range(vma, vma->vm_start,
-					 xlnk_phyaddr[bufid]
-					 >> PAGE_SHIFT,
-					 vma->vm_end - vma->vm_start,
-					 vma->vm_page_prot);
-		xlnk_userbuf[bufid] = vma->vm_start;
-		xlnk_buf_process[bufid] = current->pid;
+		if (xlnk_mmap_huge(vma, bufid)) {
+			vma->vm_flags |= VM_PFNMAP | VM_IO | VM_DONTEXPAND |
+					 VM_DONTDUMP | VM_HUGEPAGE;
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+			vma->vm_ops = &xlnk_buf_huge_vm_ops;
+#endif
+			status = 0;
+		} else {
+			status = remap_pfn_range(vma, vma->vm_start,
+						 xlnk_phyaddr[bufid]
+						 >> PAGE_SHIFT,
+						 vma->vm_end - vma->vm_start,
+						 vma->vm_page_prot);
+		}
+		spin_lock(&xlnk_buf_lock);
+		if (!status && xlnk_bufpool[bufid])
+			xlnk_buf_user_insert(bufid, vma->vm_start,
+					     current->pid);
+		spin_unlock(&xlnk_buf_lock);
 	}
 	if (status) {
 		pr_err("%s failed with code %d\n", __func__, status);
@@ -1382,7 +1645,11 @@ static const struct file_operations xlnk_fops = {
 	.read = xlnk_read,
 	.write = xlnk_write,
 	.unlocked_ioctl = xlnk_ioctl,
+	.uring_cmd = xlnk_uring_cmd,
 	.mmap = xlnk_mmap,
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+	.get_unmapped_area = xlnk_get_unmapped_area,
+#endif
 };
 
 static int xlnk_remove(struct platform_device *pdev)
@@ -1420,8 +1687,10 @@ static int xlnk_init_bufpool(void)
 	}
 
 	xlnk_bufpool[0] = xlnk_dev_buf;
-	for (i = 1; i < XLNK_BUF_POOL_SIZE; i++)
+	for (i = 1; i < XLNK_BUF_POOL_SIZE; i++) {
 		xlnk_bufpool[i] = NULL;
+		RB_CLEAR_NODE(&xlnk_buf_user_node[i]);
+	}
 
 	return 0;
 }
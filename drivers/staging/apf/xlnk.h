@@ -111,6 +111,12 @@ union xlnk_args {
 	struct __attribute__ ((__packed__)) {
 		xlnk_intptr_type dmachan;
 	} dmarelease;
+	struct __attribute__ ((__packed__)) {
+		/* user array of dmasubmit or dmawait arguments */
+		xlnk_intptr_type args;
+		/* number of entries, returns the number processed */
+		xlnk_uint_type count;
+	} dmabatch;
 	struct __attribute__ ((__packed__))  {
 		xlnk_intptr_type base;
 		xlnk_uint_type size;
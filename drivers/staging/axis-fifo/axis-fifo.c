@@ -27,6 +27,7 @@
 #include <linux/interrupt.h>
 #include <linux/param.h>
 #include <linux/fs.h>
+#include <linux/poll.h>
 #include <linux/types.h>
 #include <linux/uaccess.h>
 #include <linux/jiffies.h>
@@ -346,7 +347,6 @@ static ssize_t axis_fifo_read(struct file *f, char __user *buf,
 	unsigned int words_available;
 	unsigned int copied;
 	unsigned int copy;
-	unsigned int i;
 	int ret;
 	u32 tmp_buf[READ_BUF_SIZE];
 
@@ -416,10 +416,8 @@ static ssize_t axis_fifo_read(struct file *f, char __user *buf,
 	while (words_available > 0) {
 		copy = min(words_available, READ_BUF_SIZE);
 
-		for (i = 0; i < copy; i++) {
-			tmp_buf[i] = ioread32(fifo->base_addr +
-					      XLLF_RDFD_OFFSET);
-		}
+		ioread32_rep(fifo->base_addr + XLLF_RDFD_OFFSET, tmp_buf,
+			     copy);
 
 		if (copy_to_user(buf + copied * sizeof(u32), tmp_buf,
 				 copy * sizeof(u32))) {
@@ -441,7 +439,6 @@ static ssize_t axis_fifo_write(struct file *f, const char __user *buf,
 	unsigned int words_to_write;
 	unsigned int copied;
 	unsigned int copy;
-	unsigned int i;
 	int ret;
 	u32 tmp_buf[WRITE_BUF_SIZE];
 
@@ -519,9 +516,8 @@ static ssize_t axis_fifo_write(struct file *f, const char __user *buf,
 			return -EFAULT;
 		}
 
-		for (i = 0; i < copy; i++)
-			iowrite32(tmp_buf[i], fifo->base_addr +
-				  XLLF_TDFD_OFFSET);
+		iowrite32_rep(fifo->base_addr + XLLF_TDFD_OFFSET, tmp_buf,
+			      copy);
 
 		copied += copy;
 		words_to_write -= copy;
@@ -533,6 +529,30 @@ static ssize_t axis_fifo_write(struct file *f, const char __user *buf,
 	return (ssize_t)copied * sizeof(u32);
 }
 
+/* a packet is readable when one is in the receive fifo and the
+ * device is writable when the transmit fifo has vacancy; a write of
+ * more words than the vacancy still returns -EAGAIN in non-blocking mode
+ */
+static __poll_t axis_fifo_poll(struct file *f, poll_table *wait)
+{
+	struct axis_fifo *fifo = (struct axis_fifo *)f->private_data;
+	__poll_t mask = 0;
+
+	if (fifo->has_rx_fifo) {
+		poll_wait(f, &fifo->read_queue, wait);
+		if (ioread32(fifo->base_addr + XLLF_RDFO_OFFSET))
+			mask |= EPOLLIN | EPOLLRDNORM;
+	}
+
+	if (fifo->has_tx_fifo) {
+		poll_wait(f, &fifo->write_queue, wait);
+		if (ioread32(fifo->base_addr + XLLF_TDFV_OFFSET))
+			mask |= EPOLLOUT | EPOLLWRNORM;
+	}
+
+	return mask;
+}
+
 static irqreturn_t axis_fifo_irq(int irq, void *dw)
 {
 	struct axis_fifo *fifo = (struct axis_fifo *)dw;
@@ -680,7 +700,8 @@ static const struct file_operations fops = {
 	.open = axis_fifo_open,
 	.release = axis_fifo_close,
 	.read = axis_fifo_read,
-	.write = axis_fifo_write
+	.write = axis_fifo_write,
+	.poll = axis_fifo_poll
 };
 
 /* read named property from the device tree */
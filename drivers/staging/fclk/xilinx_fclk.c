@@ -6,15 +6,25 @@
 
 #include <linux/clk.h>
 #include <linux/clk-provider.h>
+#include <linux/devfreq.h>
+#include <linux/devfreq-event.h>
 #include <linux/errno.h>
 #include <linux/io.h>
 #include <linux/module.h>
 #include <linux/of_device.h>
 #include <linux/platform_device.h>
+#include <linux/pm_opp.h>
 
 struct fclk_state {
 	struct device	*dev;
 	struct clk	*pl;
+#ifdef CONFIG_XILINX_FCLK_DEVFREQ
+	struct devfreq	*devfreq;
+	struct devfreq_dev_profile profile;
+	struct devfreq_simple_ondemand_data ondemand;
+	struct devfreq_event_dev **edev;
+	int		num_edev;
+#endif
 };
 
 /* Match table for of_platform binding */
@@ -40,6 +50,12 @@ static ssize_t set_rate_store(struct device *dev,
 	unsigned long rate;
 	struct fclk_state *st = dev_get_drvdata(dev);
 
+#ifdef CONFIG_XILINX_FCLK_DEVFREQ
+	/* The rate is owned by devfreq, use its userspace governor */
+	if (st->devfreq)
+		return -EBUSY;
+#endif
+
 	ret = kstrtoul(buf, 0, &rate);
 	if (ret)
 		return -EINVAL;
@@ -61,6 +77,185 @@ static const struct attribute_group fclk_ctrl_attr_grp = {
 	.attrs = (struct attribute **)fclk_ctrl_attrs,
 };
 
+#ifdef CONFIG_XILINX_FCLK_DEVFREQ
+/*
+ * With an OPP table and "devfreq-events", the PL clock is scaled by the
+ * simple_ondemand governor on the load reported by the devfreq-event
+ * devices, e.g. an AXI Performance Monitor slot in front of an
+ * accelerator. With several events the busiest one drives the rate.
+ */
+static int fclk_devfreq_target(struct device *dev, unsigned long *freq,
+			       u32 flags)
+{
+	struct fclk_state *st = dev_get_drvdata(dev);
+	struct dev_pm_opp *opp;
+	unsigned long rate;
+	int ret;
+
+	opp = devfreq_recommended_opp(dev, freq, flags);
+	if (IS_ERR(opp))
+		return PTR_ERR(opp);
+	rate = dev_pm_opp_get_freq(opp);
+	dev_pm_opp_put(opp);
+
+	if (rate == clk_get_rate(st->pl))
+		return 0;
+
+	ret = clk_set_rate(st->pl, clk_round_rate(st->pl, rate));
+	if (ret)
+		return ret;
+
+	*freq = clk_get_rate(st->pl);
+
+	return 0;
+}
+
+static int fclk_devfreq_get_dev_status(struct device *dev,
+				       struct devfreq_dev_status *stat)
+{
+	struct fclk_state *st = dev_get_drvdata(dev);
+	struct devfreq_event_data edata;
+	int i, ret;
+
+	stat->current_frequency = clk_get_rate(st->pl);
+	stat->busy_time = 0;
+	stat->total_time = 1;
+
+	for (i = 0; i < st->num_edev; i++) {
+		ret = devfreq_event_get_event(st->edev[i], &edata);
+		if (ret)
+			return ret;
+
+		if (!edata.total_count)
+			continue;
+
+		/* Keep the highest busy_time / total_time */
+		if ((u64)edata.load_count * stat->total_time >
+		    (u64)stat->busy_time * edata.total_count) {
+			stat->busy_time = edata.load_count;
+			stat->total_time = edata.total_count;
+		}
+	}
+
+	return 0;
+}
+
+static int fclk_devfreq_get_cur_freq(struct device *dev, unsigned long *freq)
+{
+	struct fclk_state *st = dev_get_drvdata(dev);
+
+	*freq = clk_get_rate(st->pl);
+
+	return 0;
+}
+
+static void fclk_devfreq_disable_edev(struct fclk_state *st)
+{
+	int i;
+
+	for (i = 0; i < st->num_edev; i++)
+		devfreq_event_disable_edev(st->edev[i]);
+}
+
+/**
+ * fclk_devfreq_init - Scale the PL clock with the load of the fabric
+ * @st: Driver state
+ *
+ * Return: 0 when devfreq is set up or not requested, error code otherwise
+ */
+static int fclk_devfreq_init(struct fclk_state *st)
+{
+	struct device *dev = st->dev;
+	struct device_node *np = dev->of_node;
+	int i, ret;
+
+	if (!of_find_property(np, "operating-points-v2", NULL))
+		return 0;
+
+	st->num_edev = devfreq_event_get_edev_count(dev);
+	if (st->num_edev <= 0) {
+		dev_err(dev, "devfreq-events are required with an OPP table\n");
+		return -EINVAL;
+	}
+
+	st->edev = devm_kcalloc(dev, st->num_edev, sizeof(*st->edev),
+				GFP_KERNEL);
+	if (!st->edev)
+		return -ENOMEM;
+
+	for (i = 0; i < st->num_edev; i++) {
+		st->edev[i] = devfreq_event_get_edev_by_phandle(dev, i);
+		if (IS_ERR(st->edev[i]))
+			return -EPROBE_DEFER;
+	}
+
+	ret = dev_pm_opp_of_add_table(dev);
+	if (ret) {
+		dev_err(dev, "invalid operating-points-v2\n");
+		return ret;
+	}
+
+	for (i = 0; i < st->num_edev; i++) {
+		ret = devfreq_event_enable_edev(st->edev[i]);
+		if (!ret)
+			ret = devfreq_event_set_event(st->edev[i]);
+		if (ret) {
+			st->num_edev = i + 1;
+			goto err_edev;
+		}
+	}
+
+	of_property_read_u32(np, "upthreshold", &st->ondemand.upthreshold);
+	of_property_read_u32(np, "downdifferential",
+			     &st->ondemand.downdifferential);
+
+	st->profile.initial_freq = clk_get_rate(st->pl);
+	st->profile.polling_ms = 100;
+	st->profile.target = fclk_devfreq_target;
+	st->profile.get_dev_status = fclk_devfreq_get_dev_status;
+	st->profile.get_cur_freq = fclk_devfreq_get_cur_freq;
+	st->devfreq = devm_devfreq_add_device(dev, &st->profile,
+					      DEVFREQ_GOV_SIMPLE_ONDEMAND,
+					      &st->ondemand);
+	if (IS_ERR(st->devfreq)) {
+		ret = PTR_ERR(st->devfreq);
+		st->devfreq = NULL;
+		goto err_edev;
+	}
+
+	return 0;
+
+err_edev:
+	fclk_devfreq_disable_edev(st);
+	dev_pm_opp_of_remove_table(dev);
+	return ret;
+}
+
+/**
+ * fclk_devfreq_exit - Stop scaling the PL clock
+ * @st: Driver state
+ */
+static void fclk_devfreq_exit(struct fclk_state *st)
+{
+	if (!st->devfreq)
+		return;
+
+	devm_devfreq_remove_device(st->dev, st->devfreq);
+	st->devfreq = NULL;
+	fclk_devfreq_disable_edev(st);
+	dev_pm_opp_of_remove_table(st->dev);
+}
+#else
+static int fclk_devfreq_init(struct fclk_state *st)
+{
+	return 0;
+}
+
+static void fclk_devfreq_exit(struct fclk_state *st)
+{
+}
+#endif
+
 static int fclk_probe(struct platform_device *pdev)
 {
 	struct fclk_state *st;
@@ -84,6 +279,12 @@ static int fclk_probe(struct platform_device *pdev)
 		return ret;
 	}
 
+	ret = fclk_devfreq_init(st);
+	if (ret) {
+		clk_disable_unprepare(st->pl);
+		return ret;
+	}
+
 	ret = sysfs_create_group(&dev->kobj, &fclk_ctrl_attr_grp);
 	if (ret)
 		return ret;
@@ -95,6 +296,7 @@ static int fclk_remove(struct platform_device *pdev)
 {
 	struct fclk_state *st = platform_get_drvdata(pdev);
 
+	fclk_devfreq_exit(st);
 	clk_disable_unprepare(st->pl);
 	return 0;
 }
@@ -17,6 +17,7 @@
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/of_irq.h>
+#include <linux/overflow.h>
 #include <linux/platform_device.h>
 #include <linux/poll.h>
 #include <uapi/linux/xlnx_mpg2tsmux_interface.h>
@@ -730,6 +731,8 @@ static int xlnx_tsmux_enqueue_stream_context(struct xlnx_tsmux *mpgmuxts,
 		if (i == XTSMUX_MAXIN_STRM) {
 			dev_err(mpgmuxts->dev, "No DMA buffer with %d",
 				stream_data->srcbuf_id);
+			dma_pool_free(mpgmuxts->strm_ctx_pool, kaddr_strm_node,
+				      strm_phy_addr);
 			return -ENOMEM;
 		}
 	}
@@ -799,6 +802,56 @@ static int xlnx_tsmux_ioctl_set_stream_context(struct xlnx_tsmux *mpgmuxts,
 	return 0;
 }
 
+static int xlnx_tsmux_ioctl_set_stream_batch(struct xlnx_tsmux *mpgmuxts,
+					     void __user *arg)
+{
+	struct stream_context_batch batch;
+	struct stream_context_in *stream_data;
+	u32 i;
+	int ret = 0;
+
+	if (copy_from_user(&batch, arg, sizeof(batch))) {
+		dev_err(mpgmuxts->dev, "Failed to copy stream batch from user");
+		return -EFAULT;
+	}
+
+	if (!batch.num_strms || batch.num_strms > XTSMUX_MAXIN_TLSTRM) {
+		dev_err(mpgmuxts->dev, "Invalid number of stream contexts %u",
+			batch.num_strms);
+		return -EINVAL;
+	}
+
+	stream_data = memdup_user(u64_to_user_ptr(batch.strms),
+				  array_size(batch.num_strms,
+					     sizeof(*stream_data)));
+	if (IS_ERR(stream_data)) {
+		dev_err(mpgmuxts->dev, "Failed to copy stream data from user");
+		return PTR_ERR(stream_data);
+	}
+
+	/*
+	 * Stream contexts are chained to the descriptor list in order, so
+	 * stop at the first failure and report how many were enqueued.
+	 */
+	for (i = 0; i < batch.num_strms; i++) {
+		ret = xlnx_tsmux_enqueue_stream_context(mpgmuxts,
+							&stream_data[i]);
+		if (ret < 0) {
+			dev_err(mpgmuxts->dev,
+				"Setting stream descripter %u failed", i);
+			break;
+		}
+	}
+
+	kfree(stream_data);
+
+	batch.num_strms = i;
+	if (copy_to_user(arg, &batch, sizeof(batch)))
+		return -EFAULT;
+
+	return ret;
+}
+
 static enum xlnx_tsmux_status xlnx_tsmux_get_device_status(struct xlnx_tsmux *
 							   mpgmuxts)
 {
@@ -1183,6 +1236,9 @@ static long xlnx_tsmux_ioctl(struct file *fptr,
 	case MPG2MUX_SETSTRM:
 		ret = xlnx_tsmux_ioctl_set_stream_context(mpgmuxts, arg);
 		break;
+	case MPG2MUX_SETSTRMS:
+		ret = xlnx_tsmux_ioctl_set_stream_batch(mpgmuxts, arg);
+		break;
 	case MPG2MUX_START:
 		ret = xlnx_tsmux_ioctl_start(mpgmuxts);
 		break;
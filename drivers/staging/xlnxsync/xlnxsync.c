@@ -24,6 +24,7 @@
 #include <linux/of_irq.h>
 #include <linux/platform_device.h>
 #include <linux/poll.h>
+#include <linux/sched/isolation.h>
 #include <linux/uaccess.h>
 #include <linux/xlnxsync.h>
 
@@ -1233,6 +1234,13 @@ static int xlnxsync_clk_setup(struct xlnxsync_device *xlnxsync)
 	return ret;
 }
 
+static void xlnxsync_clear_irq_affinity(void *data)
+{
+	struct xlnxsync_device *xlnxsync = data;
+
+	irq_set_affinity_hint(xlnxsync->irq, NULL);
+}
+
 static int xlnxsync_probe(struct platform_device *pdev)
 {
 	struct xlnxsync_device *xlnxsync;
@@ -1288,6 +1296,17 @@ static int xlnxsync_probe(struct platform_device *pdev)
 		return ret;
 	}
 
+	/* The irq thread follows the interrupt off the isolated CPUs */
+	if (housekeeping_enabled(HK_FLAG_DOMAIN)) {
+		irq_set_affinity_hint(xlnxsync->irq,
+				      housekeeping_cpumask(HK_FLAG_DOMAIN));
+		ret = devm_add_action_or_reset(xlnxsync->dev,
+					       xlnxsync_clear_irq_affinity,
+					       xlnxsync);
+		if (ret)
+			return ret;
+	}
+
 	ret = xlnxsync_clk_setup(xlnxsync);
 	if (ret) {
 		dev_err(xlnxsync->dev, "clock setup failed!\n");
@@ -66,6 +66,11 @@ static int framer_probe(struct platform_device *pdev)
 
 	dev_set_drvdata(dev, lp);
 	xroe_sysfs_init();
+	rc = xroe_genl_register();
+	if (rc) {
+		dev_err(dev, "Could not register the generic netlink family\n");
+		return rc;
+	}
 	/* Get IRQ for the device */
 	/*
 	 * TODO: No IRQ *yet* in the DT from the framer block, as it's still
@@ -124,6 +129,7 @@ static int __init framer_init(void)
  */
 static void __exit framer_exit(void)
 {
+	xroe_genl_unregister();
 	xroe_sysfs_exit();
 	platform_driver_unregister(&framer_driver);
 	pr_info("XROE Framer exit\n");
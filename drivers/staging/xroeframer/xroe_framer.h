@@ -54,6 +54,8 @@ void xroe_sysfs_ipv4_exit(void);
 void xroe_sysfs_ipv6_exit(void);
 void xroe_sysfs_udp_exit(void);
 void xroe_sysfs_stats_exit(void);
+int xroe_genl_register(void);
+void xroe_genl_unregister(void);
 int utils_write32withmask(void __iomem *working_address, u32 value,
 			  u32 mask, u32 offset);
 int utils_check_address_offset(u32 offset, size_t device_size);
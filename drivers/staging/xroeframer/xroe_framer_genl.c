@@ -0,0 +1,436 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (C) 2020 Xilinx, Inc.
+ */
+
+#include <linux/etherdevice.h>
+#include <linux/in6.h>
+#include <linux/mutex.h>
+#include <net/genetlink.h>
+#include <asm/unaligned.h>
+#include <uapi/linux/xlnx-roe-framer.h>
+#include "xroe_framer.h"
+
+/* Address stride of the per Ethernet port registers */
+#define XROE_ETH_PORT_STRIDE	0x100
+
+/* Address, offset and mask of a register field of roe_framer_ctrl.h */
+#define XROE_FIELD(name)	name##_ADDR, name##_OFFSET, name##_MASK
+
+static struct genl_family xroe_genl_family;
+/* Serialises the flow updates so that each one is applied as a whole */
+static DEFINE_MUTEX(xroe_genl_lock);
+
+static void xroe_genl_write(u8 port, u32 address, u32 offset, u32 mask,
+			    u32 value)
+{
+	utils_write32withmask(lp->base_addr + address +
+			      XROE_ETH_PORT_STRIDE * port, value, mask, offset);
+}
+
+static u32 xroe_genl_read(u8 port, u32 address, u32 offset, u32 mask)
+{
+	u32 value = ioread32(lp->base_addr + address +
+			     XROE_ETH_PORT_STRIDE * port);
+
+	return (value & mask) >> offset;
+}
+
+/*
+ * The MAC and IPv6 addresses are split in 32 bit registers, the most
+ * significant part of the address in the lowest register.
+ */
+static void xroe_genl_write_mac(u8 port, u32 lo_address, u32 hi_address,
+				const u8 *addr)
+{
+	xroe_genl_write(port, hi_address, 0, 0xffff, addr[0] << 8 | addr[1]);
+	xroe_genl_write(port, lo_address, 0, 0xffffffff,
+			get_unaligned_be32(addr + 2));
+}
+
+static void xroe_genl_read_mac(u8 port, u32 lo_address, u32 hi_address,
+			       u8 *addr)
+{
+	u32 hi = xroe_genl_read(port, hi_address, 0, 0xffff);
+
+	addr[0] = hi >> 8;
+	addr[1] = hi;
+	put_unaligned_be32(xroe_genl_read(port, lo_address, 0, 0xffffffff),
+			   addr + 2);
+}
+
+static void xroe_genl_write_ipv6(u8 port, u32 address,
+				 const struct in6_addr *addr)
+{
+	int i;
+
+	for (i = 0; i < 4; i++)
+		xroe_genl_write(port, address + 4 * i, 0, 0xffffffff,
+				be32_to_cpu(addr->s6_addr32[i]));
+}
+
+static void xroe_genl_read_ipv6(u8 port, u32 address, struct in6_addr *addr)
+{
+	int i;
+
+	for (i = 0; i < 4; i++)
+		addr->s6_addr32[i] =
+			cpu_to_be32(xroe_genl_read(port, address + 4 * i, 0,
+						   0xffffffff));
+}
+
+static int xroe_genl_get_port(struct genl_info *info, u8 *port)
+{
+	if (!info->attrs[XLNX_ROE_FRAMER_A_PORT]) {
+		GENL_SET_ERR_MSG(info, "An Ethernet port is required");
+		return -EINVAL;
+	}
+	*port = nla_get_u8(info->attrs[XLNX_ROE_FRAMER_A_PORT]);
+
+	return 0;
+}
+
+static int xroe_genl_flow_set(struct sk_buff *skb, struct genl_info *info)
+{
+	struct nlattr **tb = info->attrs;
+	struct in6_addr addr6;
+	u8 addr[ETH_ALEN];
+	__be32 addr4;
+	u8 port;
+	int ret;
+
+	ret = xroe_genl_get_port(info, &port);
+	if (ret)
+		return ret;
+
+	if (tb[XLNX_ROE_FRAMER_A_IPV6_FLOW_LABEL] &&
+	    nla_get_u32(tb[XLNX_ROE_FRAMER_A_IPV6_FLOW_LABEL]) >
+	    (ETH_IPV6_FLOW_LABEL_MASK >> ETH_IPV6_FLOW_LABEL_OFFSET)) {
+		GENL_SET_ERR_MSG(info, "The IPv6 flow label is out of range");
+		return -EINVAL;
+	}
+
+	mutex_lock(&xroe_genl_lock);
+
+	if (tb[XLNX_ROE_FRAMER_A_ETH_DST_ADDR]) {
+		nla_memcpy(addr, tb[XLNX_ROE_FRAMER_A_ETH_DST_ADDR], ETH_ALEN);
+		xroe_genl_write_mac(port, ETH_DEST_ADDR_31_0_ADDR,
+				    ETH_DEST_ADDR_47_32_ADDR, addr);
+	}
+	if (tb[XLNX_ROE_FRAMER_A_ETH_SRC_ADDR]) {
+		nla_memcpy(addr, tb[XLNX_ROE_FRAMER_A_ETH_SRC_ADDR], ETH_ALEN);
+		xroe_genl_write_mac(port, ETH_SRC_ADDR_31_0_ADDR,
+				    ETH_SRC_ADDR_47_32_ADDR, addr);
+	}
+	if (tb[XLNX_ROE_FRAMER_A_VLAN_ID])
+		xroe_genl_write(port, XROE_FIELD(ETH_VLAN_ID),
+				nla_get_u16(tb[XLNX_ROE_FRAMER_A_VLAN_ID]));
+	if (tb[XLNX_ROE_FRAMER_A_VLAN_DEI])
+		xroe_genl_write(port, XROE_FIELD(ETH_VLAN_DEI),
+				nla_get_u8(tb[XLNX_ROE_FRAMER_A_VLAN_DEI]));
+	if (tb[XLNX_ROE_FRAMER_A_VLAN_PCP])
+		xroe_genl_write(port, XROE_FIELD(ETH_VLAN_PCP),
+				nla_get_u8(tb[XLNX_ROE_FRAMER_A_VLAN_PCP]));
+
+	if (tb[XLNX_ROE_FRAMER_A_IPV4_SRC_ADDR]) {
+		addr4 = nla_get_in_addr(tb[XLNX_ROE_FRAMER_A_IPV4_SRC_ADDR]);
+		xroe_genl_write(port, XROE_FIELD(ETH_IPV4_SOURCE_ADD),
+				be32_to_cpu(addr4));
+	}
+	if (tb[XLNX_ROE_FRAMER_A_IPV4_DST_ADDR]) {
+		addr4 = nla_get_in_addr(tb[XLNX_ROE_FRAMER_A_IPV4_DST_ADDR]);
+		xroe_genl_write(port, XROE_FIELD(ETH_IPV4_DESTINATION_ADD),
+				be32_to_cpu(addr4));
+	}
+	if (tb[XLNX_ROE_FRAMER_A_IPV4_DSCP])
+		xroe_genl_write(port, XROE_FIELD(ETH_IPV4_DSCP),
+				nla_get_u8(tb[XLNX_ROE_FRAMER_A_IPV4_DSCP]));
+	if (tb[XLNX_ROE_FRAMER_A_IPV4_ECN])
+		xroe_genl_write(port, XROE_FIELD(ETH_IPV4_ECN),
+				nla_get_u8(tb[XLNX_ROE_FRAMER_A_IPV4_ECN]));
+	if (tb[XLNX_ROE_FRAMER_A_IPV4_TTL])
+		xroe_genl_write(port, XROE_FIELD(ETH_IPV4_TIME_TO_LIVE),
+				nla_get_u8(tb[XLNX_ROE_FRAMER_A_IPV4_TTL]));
+
+	if (tb[XLNX_ROE_FRAMER_A_IPV6_SRC_ADDR]) {
+		addr6 = nla_get_in6_addr(tb[XLNX_ROE_FRAMER_A_IPV6_SRC_ADDR]);
+		xroe_genl_write_ipv6(port, ETH_IPV6_SOURCE_ADD_31_0_ADDR,
+				     &addr6);
+	}
+	if (tb[XLNX_ROE_FRAMER_A_IPV6_DST_ADDR]) {
+		addr6 = nla_get_in6_addr(tb[XLNX_ROE_FRAMER_A_IPV6_DST_ADDR]);
+		xroe_genl_write_ipv6(port, ETH_IPV6_DEST_ADD_31_0_ADDR,
+				     &addr6);
+	}
+	if (tb[XLNX_ROE_FRAMER_A_IPV6_TRAFFIC_CLASS])
+		xroe_genl_write(port, XROE_FIELD(ETH_IPV6_TRAFFIC_CLASS),
+				nla_get_u8(tb[XLNX_ROE_FRAMER_A_IPV6_TRAFFIC_CLASS]));
+	if (tb[XLNX_ROE_FRAMER_A_IPV6_FLOW_LABEL])
+		xroe_genl_write(port, XROE_FIELD(ETH_IPV6_FLOW_LABEL),
+				nla_get_u32(tb[XLNX_ROE_FRAMER_A_IPV6_FLOW_LABEL]));
+	if (tb[XLNX_ROE_FRAMER_A_IPV6_HOP_LIMIT])
+		xroe_genl_write(port, XROE_FIELD(ETH_IPV6_HOP_LIMIT),
+				nla_get_u8(tb[XLNX_ROE_FRAMER_A_IPV6_HOP_LIMIT]));
+
+	if (tb[XLNX_ROE_FRAMER_A_UDP_SRC_PORT])
+		xroe_genl_write(port, XROE_FIELD(ETH_UDP_SOURCE_PORT),
+				nla_get_u16(tb[XLNX_ROE_FRAMER_A_UDP_SRC_PORT]));
+	if (tb[XLNX_ROE_FRAMER_A_UDP_DST_PORT])
+		xroe_genl_write(port, XROE_FIELD(ETH_UDP_DESTINATION_PORT),
+				nla_get_u16(tb[XLNX_ROE_FRAMER_A_UDP_DST_PORT]));
+
+	mutex_unlock(&xroe_genl_lock);
+
+	return 0;
+}
+
+static int xroe_genl_flow_fill(struct sk_buff *msg, u32 portid, u32 seq,
+			       int flags, u8 port)
+{
+	struct in6_addr src6, dst6;
+	u8 dst[ETH_ALEN], src[ETH_ALEN];
+	void *hdr;
+
+	hdr = genlmsg_put(msg, portid, seq, &xroe_genl_family, flags,
+			  XLNX_ROE_FRAMER_CMD_FLOW_GET);
+	if (!hdr)
+		return -EMSGSIZE;
+
+	xroe_genl_read_mac(port, ETH_DEST_ADDR_31_0_ADDR,
+			   ETH_DEST_ADDR_47_32_ADDR, dst);
+	xroe_genl_read_mac(port, ETH_SRC_ADDR_31_0_ADDR,
+			   ETH_SRC_ADDR_47_32_ADDR, src);
+	xroe_genl_read_ipv6(port, ETH_IPV6_SOURCE_ADD_31_0_ADDR, &src6);
+	xroe_genl_read_ipv6(port, ETH_IPV6_DEST_ADD_31_0_ADDR, &dst6);
+
+	if (nla_put_u8(msg, XLNX_ROE_FRAMER_A_PORT, port) ||
+	    nla_put(msg, XLNX_ROE_FRAMER_A_ETH_DST_ADDR, ETH_ALEN, dst) ||
+	    nla_put(msg, XLNX_ROE_FRAMER_A_ETH_SRC_ADDR, ETH_ALEN, src) ||
+	    nla_put_u16(msg, XLNX_ROE_FRAMER_A_VLAN_ID,
+			xroe_genl_read(port, XROE_FIELD(ETH_VLAN_ID))) ||
+	    nla_put_u8(msg, XLNX_ROE_FRAMER_A_VLAN_DEI,
+		       xroe_genl_read(port, XROE_FIELD(ETH_VLAN_DEI))) ||
+	    nla_put_u8(msg, XLNX_ROE_FRAMER_A_VLAN_PCP,
+		       xroe_genl_read(port, XROE_FIELD(ETH_VLAN_PCP))) ||
+	    nla_put_in_addr(msg, XLNX_ROE_FRAMER_A_IPV4_SRC_ADDR,
+			    cpu_to_be32(xroe_genl_read(port,
+					XROE_FIELD(ETH_IPV4_SOURCE_ADD)))) ||
+	    nla_put_in_addr(msg, XLNX_ROE_FRAMER_A_IPV4_DST_ADDR,
+			    cpu_to_be32(xroe_genl_read(port,
+					XROE_FIELD(ETH_IPV4_DESTINATION_ADD)))) ||
+	    nla_put_u8(msg, XLNX_ROE_FRAMER_A_IPV4_DSCP,
+		       xroe_genl_read(port, XROE_FIELD(ETH_IPV4_DSCP))) ||
+	    nla_put_u8(msg, XLNX_ROE_FRAMER_A_IPV4_ECN,
+		       xroe_genl_read(port, XROE_FIELD(ETH_IPV4_ECN))) ||
+	    nla_put_u8(msg, XLNX_ROE_FRAMER_A_IPV4_TTL,
+		       xroe_genl_read(port,
+				      XROE_FIELD(ETH_IPV4_TIME_TO_LIVE))) ||
+	    nla_put_in6_addr(msg, XLNX_ROE_FRAMER_A_IPV6_SRC_ADDR, &src6) ||
+	    nla_put_in6_addr(msg, XLNX_ROE_FRAMER_A_IPV6_DST_ADDR, &dst6) ||
+	    nla_put_u8(msg, XLNX_ROE_FRAMER_A_IPV6_TRAFFIC_CLASS,
+		       xroe_genl_read(port,
+				      XROE_FIELD(ETH_IPV6_TRAFFIC_CLASS))) ||
+	    nla_put_u32(msg, XLNX_ROE_FRAMER_A_IPV6_FLOW_LABEL,
+			xroe_genl_read(port, XROE_FIELD(ETH_IPV6_FLOW_LABEL))) ||
+	    nla_put_u8(msg, XLNX_ROE_FRAMER_A_IPV6_HOP_LIMIT,
+		       xroe_genl_read(port, XROE_FIELD(ETH_IPV6_HOP_LIMIT))) ||
+	    nla_put_u16(msg, XLNX_ROE_FRAMER_A_UDP_SRC_PORT,
+			xroe_genl_read(port,
+				       XROE_FIELD(ETH_UDP_SOURCE_PORT))) ||
+	    nla_put_u16(msg, XLNX_ROE_FRAMER_A_UDP_DST_PORT,
+			xroe_genl_read(port,
+				       XROE_FIELD(ETH_UDP_DESTINATION_PORT))))
+		goto nla_put_failure;
+
+	genlmsg_end(msg, hdr);
+	return 0;
+
+nla_put_failure:
+	genlmsg_cancel(msg, hdr);
+	return -EMSGSIZE;
+}
+
+static int xroe_genl_flow_get(struct sk_buff *skb, struct genl_info *info)
+{
+	struct sk_buff *msg;
+	u8 port;
+	int ret;
+
+	ret = xroe_genl_get_port(info, &port);
+	if (ret)
+		return ret;
+
+	msg = nlmsg_new(NLMSG_DEFAULT_SIZE, GFP_KERNEL);
+	if (!msg)
+		return -ENOMEM;
+
+	mutex_lock(&xroe_genl_lock);
+	ret = xroe_genl_flow_fill(msg, info->snd_portid, info->snd_seq, 0,
+				  port);
+	mutex_unlock(&xroe_genl_lock);
+
+	if (ret) {
+		nlmsg_free(msg);
+		return ret;
+	}
+
+	return genlmsg_reply(msg, info);
+}
+
+static int xroe_genl_flow_dump(struct sk_buff *skb,
+			       struct netlink_callback *cb)
+{
+	int i;
+
+	mutex_lock(&xroe_genl_lock);
+	for (i = cb->args[0]; i < MAX_NUM_ETH_PORTS; i++) {
+		if (xroe_genl_flow_fill(skb, NETLINK_CB(cb->skb).portid,
+					cb->nlh->nlmsg_seq, NLM_F_MULTI, i))
+			break;
+	}
+	mutex_unlock(&xroe_genl_lock);
+
+	cb->args[0] = i;
+	return skb->len;
+}
+
+static const struct {
+	int attr;
+	u32 address;
+	u32 offset;
+	u32 mask;
+} xroe_genl_stats[] = {
+	{ XLNX_ROE_FRAMER_A_RX_GOOD_PKT,
+	  XROE_FIELD(STATS_TOTAL_RX_GOOD_PKT_CNT) },
+	{ XLNX_ROE_FRAMER_A_RX_BAD_PKT,
+	  XROE_FIELD(STATS_TOTAL_RX_BAD_PKT_CNT) },
+	{ XLNX_ROE_FRAMER_A_RX_BAD_FCS,
+	  XROE_FIELD(STATS_TOTAL_RX_BAD_FCS_CNT) },
+	{ XLNX_ROE_FRAMER_A_RX_USER_PKT,
+	  XROE_FIELD(STATS_USER_DATA_RX_PACKETS_CNT) },
+	{ XLNX_ROE_FRAMER_A_RX_GOOD_USER_PKT,
+	  XROE_FIELD(STATS_USER_DATA_RX_GOOD_PKT_CNT) },
+	{ XLNX_ROE_FRAMER_A_RX_BAD_USER_PKT,
+	  XROE_FIELD(STATS_USER_DATA_RX_BAD_PKT_CNT) },
+	{ XLNX_ROE_FRAMER_A_RX_BAD_USER_FCS,
+	  XROE_FIELD(STATS_USER_DATA_RX_BAD_FCS_CNT) },
+	{ XLNX_ROE_FRAMER_A_RX_USER_CTRL_PKT,
+	  XROE_FIELD(STATS_USER_CTRL_RX_PACKETS_CNT) },
+	{ XLNX_ROE_FRAMER_A_RX_GOOD_USER_CTRL_PKT,
+	  XROE_FIELD(STATS_USER_CTRL_RX_GOOD_PKT_CNT) },
+	{ XLNX_ROE_FRAMER_A_RX_BAD_USER_CTRL_PKT,
+	  XROE_FIELD(STATS_USER_CTRL_RX_BAD_PKT_CNT) },
+	{ XLNX_ROE_FRAMER_A_RX_BAD_USER_CTRL_FCS,
+	  XROE_FIELD(STATS_USER_CTRL_RX_BAD_FCS_CNT) },
+	{ XLNX_ROE_FRAMER_A_RX_USER_PKT_RATE,
+	  XROE_FIELD(STATS_USER_DATA_RX_PKTS_RATE) },
+	{ XLNX_ROE_FRAMER_A_RX_USER_CTRL_PKT_RATE,
+	  XROE_FIELD(STATS_USER_CTRL_RX_PKTS_RATE) },
+};
+
+static int xroe_genl_stats_get(struct sk_buff *skb, struct genl_info *info)
+{
+	u32 stats[ARRAY_SIZE(xroe_genl_stats)];
+	struct sk_buff *msg;
+	void *hdr;
+	int i;
+
+	msg = genlmsg_new(ARRAY_SIZE(xroe_genl_stats) * nla_total_size(4),
+			  GFP_KERNEL);
+	if (!msg)
+		return -ENOMEM;
+
+	hdr = genlmsg_put_reply(msg, info, &xroe_genl_family, 0,
+				XLNX_ROE_FRAMER_CMD_STATS_GET);
+	if (!hdr)
+		goto nla_put_failure;
+
+	/* Read back to back, the counters are as coherent as they can be */
+	for (i = 0; i < ARRAY_SIZE(xroe_genl_stats); i++)
+		stats[i] = xroe_genl_read(0, xroe_genl_stats[i].address,
+					  xroe_genl_stats[i].offset,
+					  xroe_genl_stats[i].mask);
+
+	for (i = 0; i < ARRAY_SIZE(xroe_genl_stats); i++)
+		if (nla_put_u32(msg, xroe_genl_stats[i].attr, stats[i]))
+			goto nla_put_failure;
+
+	genlmsg_end(msg, hdr);
+	return genlmsg_reply(msg, info);
+
+nla_put_failure:
+	nlmsg_free(msg);
+	return -EMSGSIZE;
+}
+
+static const struct nla_policy xroe_genl_policy[XLNX_ROE_FRAMER_A_MAX + 1] = {
+	[XLNX_ROE_FRAMER_A_PORT]		=
+		NLA_POLICY_MAX(NLA_U8, MAX_NUM_ETH_PORTS - 1),
+	[XLNX_ROE_FRAMER_A_ETH_DST_ADDR]	= { .type = NLA_EXACT_LEN,
+						    .len = ETH_ALEN },
+	[XLNX_ROE_FRAMER_A_ETH_SRC_ADDR]	= { .type = NLA_EXACT_LEN,
+						    .len = ETH_ALEN },
+	[XLNX_ROE_FRAMER_A_VLAN_ID]		=
+		NLA_POLICY_MAX(NLA_U16, ETH_VLAN_ID_MASK),
+	[XLNX_ROE_FRAMER_A_VLAN_DEI]		= NLA_POLICY_MAX(NLA_U8, 1),
+	[XLNX_ROE_FRAMER_A_VLAN_PCP]		= NLA_POLICY_MAX(NLA_U8, 7),
+	[XLNX_ROE_FRAMER_A_IPV4_SRC_ADDR]	= { .type = NLA_U32 },
+	[XLNX_ROE_FRAMER_A_IPV4_DST_ADDR]	= { .type = NLA_U32 },
+	[XLNX_ROE_FRAMER_A_IPV4_DSCP]		= NLA_POLICY_MAX(NLA_U8, 63),
+	[XLNX_ROE_FRAMER_A_IPV4_ECN]		= NLA_POLICY_MAX(NLA_U8, 3),
+	[XLNX_ROE_FRAMER_A_IPV4_TTL]		= { .type = NLA_U8 },
+	[XLNX_ROE_FRAMER_A_IPV6_SRC_ADDR]	=
+		{ .type = NLA_EXACT_LEN, .len = sizeof(struct in6_addr) },
+	[XLNX_ROE_FRAMER_A_IPV6_DST_ADDR]	=
+		{ .type = NLA_EXACT_LEN, .len = sizeof(struct in6_addr) },
+	[XLNX_ROE_FRAMER_A_IPV6_TRAFFIC_CLASS]	= { .type = NLA_U8 },
+	[XLNX_ROE_FRAMER_A_IPV6_FLOW_LABEL]	= { .type = NLA_U32 },
+	[XLNX_ROE_FRAMER_A_IPV6_HOP_LIMIT]	= { .type = NLA_U8 },
+	[XLNX_ROE_FRAMER_A_UDP_SRC_PORT]	= { .type = NLA_U16 },
+	[XLNX_ROE_FRAMER_A_UDP_DST_PORT]	= { .type = NLA_U16 },
+};
+
+static const struct genl_ops xroe_genl_ops[] = {
+	{
+		.cmd = XLNX_ROE_FRAMER_CMD_FLOW_SET,
+		.doit = xroe_genl_flow_set,
+		.flags = GENL_ADMIN_PERM,
+	},
+	{
+		.cmd = XLNX_ROE_FRAMER_CMD_FLOW_GET,
+		.doit = xroe_genl_flow_get,
+		.dumpit = xroe_genl_flow_dump,
+	},
+	{
+		.cmd = XLNX_ROE_FRAMER_CMD_STATS_GET,
+		.doit = xroe_genl_stats_get,
+	},
+};
+
+static struct genl_family xroe_genl_family = {
+	.name = XLNX_ROE_FRAMER_GENL_NAME,
+	.version = XLNX_ROE_FRAMER_GENL_VERSION,
+	.maxattr = XLNX_ROE_FRAMER_A_MAX,
+	.policy = xroe_genl_policy,
+	.module = THIS_MODULE,
+	.ops = xroe_genl_ops,
+	.n_ops = ARRAY_SIZE(xroe_genl_ops),
+};
+
+/**
+ * xroe_genl_register - Register the framer generic netlink family
+ *
+ * Return: 0 on success or the error of genl_register_family().
+ */
+int xroe_genl_register(void)
+{
+	return genl_register_family(&xroe_genl_family);
+}
+
+/**
+ * xroe_genl_unregister - Unregister the framer generic netlink family
+ */
+void xroe_genl_unregister(void)
+{
+	genl_unregister_family(&xroe_genl_family);
+}
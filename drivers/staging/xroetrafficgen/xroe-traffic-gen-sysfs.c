@@ -769,6 +769,40 @@ static ssize_t framer_pause_size_store(struct device *dev,
 }
 static DEVICE_ATTR_RW(framer_pause_size);
 
+/* Size of the roe_radio_cfg bank, from RADIO_ID to RADIO_CDC_STATUS_127_96 */
+#define XROE_SNAPSHOT_SIZE	(RADIO_CDC_STATUS_127_96_ADDR + sizeof(u32))
+
+/**
+ * snapshot_read - Returns a snapshot of all the status and error registers
+ * @filp:	The file of the entry
+ * @kobj:	The kernel object of the device
+ * @attr:	The binary attribute of the entry
+ * @buf:	The buffer the snapshot is copied to
+ * @off:	The offset in the snapshot
+ * @count:	The number of bytes requested
+ *
+ * Reads the whole roe_radio_cfg register bank back to back, so that a
+ * single read returns the radio, antenna, DIP switch and timeout status and
+ * errors sampled together. The snapshot follows the layout of the register
+ * bank in roe_radio_ctrl.h, each register in CPU byte order.
+ *
+ * Return: The number of bytes copied on success
+ */
+static ssize_t snapshot_read(struct file *filp, struct kobject *kobj,
+			     struct bin_attribute *attr, char *buf,
+			     loff_t off, size_t count)
+{
+	struct xroe_traffic_gen_local *lp = dev_get_drvdata(kobj_to_dev(kobj));
+	u32 regs[XROE_SNAPSHOT_SIZE / sizeof(u32)];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(regs); i++)
+		regs[i] = ioread32(lp->base_addr + i * sizeof(u32));
+
+	return memory_read_from_buffer(buf, count, &off, regs, sizeof(regs));
+}
+static BIN_ATTR_RO(snapshot, XROE_SNAPSHOT_SIZE);
+
 static struct attribute *xroe_traffic_gen_attrs[] = {
 	&dev_attr_radio_id.attr,
 	&dev_attr_timeout_enable.attr,
@@ -789,7 +823,17 @@ static struct attribute *xroe_traffic_gen_attrs[] = {
 	&dev_attr_framer_pause_size.attr,
 	NULL,
 };
-ATTRIBUTE_GROUPS(xroe_traffic_gen);
+
+static struct bin_attribute *xroe_traffic_gen_bin_attrs[] = {
+	&bin_attr_snapshot,
+	NULL,
+};
+
+static const struct attribute_group xroe_traffic_gen_group = {
+	.attrs = xroe_traffic_gen_attrs,
+	.bin_attrs = xroe_traffic_gen_bin_attrs,
+};
+__ATTRIBUTE_GROUPS(xroe_traffic_gen);
 
 /**
  * xroe_traffic_gen_sysfs_init - Creates the xroe sysfs directory and entries
@@ -227,6 +227,7 @@ static void cdns_uart_handle_rx(void *dev_id, unsigned int isrstatus)
 	unsigned int rxbs_status = 0;
 	unsigned int status_mask;
 	unsigned int framerrprocessed = 0;
+	unsigned int avail = 0;
 	char status = TTY_NORMAL;
 	bool is_rxbs_support;
 
@@ -239,8 +240,18 @@ static void cdns_uart_handle_rx(void *dev_id, unsigned int isrstatus)
 	if (readl(port->membase + CDNS_UART_CR) & CDNS_UART_CR_RX_DIS)
 		return;
 
-	while ((readl(port->membase + CDNS_UART_SR) &
-		CDNS_UART_SR_RXEMPTY) != CDNS_UART_SR_RXEMPTY) {
+	/*
+	 * Once the FIFO level has reached the trigger level, at least that
+	 * many bytes can be read without polling the status register for
+	 * each of them.
+	 */
+	if (readl(port->membase + CDNS_UART_SR) & CDNS_UART_SR_RXTRIG)
+		avail = readl(port->membase + CDNS_UART_RXWM);
+
+	while (avail || (readl(port->membase + CDNS_UART_SR) &
+			 CDNS_UART_SR_RXEMPTY) != CDNS_UART_SR_RXEMPTY) {
+		if (avail)
+			avail--;
 		if (is_rxbs_support)
 			rxbs_status = readl(port->membase + CDNS_UART_RXBS);
 		data = readl(port->membase + CDNS_UART_FIFO);
@@ -325,14 +336,21 @@ static void cdns_uart_handle_tx(void *dev_id)
 {
 	struct uart_port *port = (struct uart_port *)dev_id;
 	unsigned int numbytes;
+	bool poll_full;
 
 	if (uart_circ_empty(&port->state->xmit)) {
 		writel(CDNS_UART_IXR_TXEMPTY, port->membase + CDNS_UART_IDR);
 	} else {
+		/*
+		 * An empty FIFO takes a whole FIFO worth of bytes, only poll
+		 * the full flag when it was not empty.
+		 */
+		poll_full = !(readl(port->membase + CDNS_UART_SR) &
+			      CDNS_UART_SR_TXEMPTY);
 		numbytes = port->fifosize;
 		while (numbytes && !uart_circ_empty(&port->state->xmit) &&
-		       !(readl(port->membase + CDNS_UART_SR) &
-						CDNS_UART_SR_TXFULL)) {
+		       !(poll_full && (readl(port->membase + CDNS_UART_SR) &
+				       CDNS_UART_SR_TXFULL))) {
 			/*
 			 * Get the data from the UART circular buffer
 			 * and write it to the cdns_uart's TX_FIFO
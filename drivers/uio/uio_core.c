@@ -18,11 +18,15 @@
 #include <linux/device.h>
 #include <linux/slab.h>
 #include <linux/mm.h>
+#include <linux/mman.h>
+#include <linux/huge_mm.h>
+#include <linux/pfn_t.h>
 #include <linux/idr.h>
 #include <linux/sched/signal.h>
 #include <linux/string.h>
 #include <linux/kobject.h>
 #include <linux/cdev.h>
+#include <linux/eventfd.h>
 #include <linux/uio_driver.h>
 #include <linux/list.h>
 #include <linux/mutex.h>
@@ -426,6 +430,15 @@ static void uio_free_minor(struct uio_device *idev)
 	mutex_unlock(&minor_lock);
 }
 
+struct uio_listener {
+	struct uio_device *dev;
+	s32 event_count;
+	struct list_head dbufs;
+	struct mutex dbufs_lock; /* protect @dbufs */
+	struct eventfd_ctx *irqfd;
+	struct list_head irqfd_node; /* in uio_device.irqfds */
+};
+
 /**
  * uio_event_notify - trigger an interrupt event
  * @info: UIO device capabilities
@@ -433,10 +446,17 @@ static void uio_free_minor(struct uio_device *idev)
 void uio_event_notify(struct uio_info *info)
 {
 	struct uio_device *idev = info->uio_dev;
+	struct uio_listener *listener;
+	unsigned long flags;
 
 	atomic_inc(&idev->event);
 	wake_up_interruptible(&idev->wait);
 	kill_fasync(&idev->async_queue, SIGIO, POLL_IN);
+
+	spin_lock_irqsave(&idev->irqfd_lock, flags);
+	list_for_each_entry(listener, &idev->irqfds, irqfd_node)
+		eventfd_signal(listener->irqfd, 1);
+	spin_unlock_irqrestore(&idev->irqfd_lock, flags);
 }
 EXPORT_SYMBOL_GPL(uio_event_notify);
 
@@ -457,12 +477,53 @@ static irqreturn_t uio_interrupt(int irq, void *dev_id)
 	return ret;
 }
 
-struct uio_listener {
-	struct uio_device *dev;
-	s32 event_count;
-	struct list_head dbufs;
-	struct mutex dbufs_lock; /* protect @dbufs */
-};
+/*
+ * Replace the eventfd of @listener, which is signalled from
+ * uio_event_notify() in interrupt context. @irqfd may be NULL.
+ */
+static void uio_irqfd_set(struct uio_listener *listener,
+			  struct eventfd_ctx *irqfd)
+{
+	struct uio_device *idev = listener->dev;
+	struct eventfd_ctx *old;
+	unsigned long flags;
+
+	spin_lock_irqsave(&idev->irqfd_lock, flags);
+	old = listener->irqfd;
+	if (old)
+		list_del(&listener->irqfd_node);
+	listener->irqfd = irqfd;
+	if (irqfd)
+		list_add_tail(&listener->irqfd_node, &idev->irqfds);
+	spin_unlock_irqrestore(&idev->irqfd_lock, flags);
+
+	if (old)
+		eventfd_ctx_put(old);
+}
+
+static long uio_irqfd_ioctl(struct uio_listener *listener,
+			    void __user *user_args)
+{
+	struct uio_device *idev = listener->dev;
+	struct eventfd_ctx *irqfd = NULL;
+	s32 fd;
+
+	if (copy_from_user(&fd, user_args, sizeof(fd)))
+		return -EFAULT;
+
+	if (!idev->info->irq)
+		return -EIO;
+
+	if (fd >= 0) {
+		irqfd = eventfd_ctx_fdget(fd);
+		if (IS_ERR(irqfd))
+			return PTR_ERR(irqfd);
+	}
+
+	uio_irqfd_set(listener, irqfd);
+
+	return 0;
+}
 
 static int uio_open(struct inode *inode, struct file *filep)
 {
@@ -493,6 +554,7 @@ static int uio_open(struct inode *inode, struct file *filep)
 
 	listener->dev = idev;
 	listener->event_count = atomic_read(&idev->event);
+	listener->irqfd = NULL;
 	filep->private_data = listener;
 
 	mutex_lock(&idev->info_lock);
@@ -540,6 +602,8 @@ static int uio_release(struct inode *inode, struct file *filep)
 	struct uio_listener *listener = filep->private_data;
 	struct uio_device *idev = listener->dev;
 
+	uio_irqfd_set(listener, NULL);
+
 	ret = uio_dmabuf_cleanup(idev, &listener->dbufs, &listener->dbufs_lock);
 	if (ret)
 		dev_err(&idev->dev, "failed to clean up the dma bufs\n");
@@ -686,6 +750,9 @@ static long uio_ioctl(struct file *filep, unsigned int cmd, unsigned long arg)
 				       &listener->dbufs_lock,
 				       (void __user *)arg);
 		break;
+	case UIO_IOC_IRQ_EVENTFD:
+		ret = uio_irqfd_ioctl(listener, (void __user *)arg);
+		break;
 	default:
 		ret = -EINVAL;
 		break;
@@ -764,6 +831,111 @@ static const struct vm_operations_struct uio_physical_vm_ops = {
 #endif
 };
 
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+/*
+ * Shared mappings of regions of at least PMD_SIZE are filled on fault, with
+ * PMD entries where the region and the mapping are both PMD aligned, so
+ * that userspace streaming through a large buffer takes far fewer TLB
+ * misses than with the PTEs of remap_pfn_range().
+ */
+static vm_fault_t uio_physical_huge_fault(struct vm_fault *vmf,
+					  enum page_entry_size pe_size)
+{
+	struct vm_area_struct *vma = vmf->vma;
+	struct uio_device *idev = vma->vm_private_data;
+	unsigned long addr = vmf->address;
+	vm_fault_t ret = VM_FAULT_SIGBUS;
+	phys_addr_t phys;
+	int mi;
+
+	if (pe_size == PE_SIZE_PMD)
+		addr &= PMD_MASK;
+	else if (pe_size != PE_SIZE_PTE)
+		return VM_FAULT_FALLBACK;
+
+	mutex_lock(&idev->info_lock);
+	if (!idev->info)
+		goto out;
+
+	mi = uio_find_mem_index(vma);
+	if (mi < 0)
+		goto out;
+
+	phys = idev->info->mem[mi].addr + (addr - vma->vm_start);
+	if (pe_size == PE_SIZE_PTE) {
+		ret = vmf_insert_pfn(vma, addr, PHYS_PFN(phys));
+	} else if (addr < vma->vm_start || addr + PMD_SIZE > vma->vm_end ||
+		   (phys & ~PMD_MASK)) {
+		ret = VM_FAULT_FALLBACK;
+	} else {
+		ret = vmf_insert_pfn_pmd(vmf, phys_to_pfn_t(phys, PFN_DEV),
+					 vmf->flags & FAULT_FLAG_WRITE);
+	}
+
+out:
+	mutex_unlock(&idev->info_lock);
+	return ret;
+}
+
+static vm_fault_t uio_physical_fault(struct vm_fault *vmf)
+{
+	return uio_physical_huge_fault(vmf, PE_SIZE_PTE);
+}
+
+static const struct vm_operations_struct uio_physical_huge_vm_ops = {
+	.fault = uio_physical_fault,
+	.huge_fault = uio_physical_huge_fault,
+};
+
+static bool uio_mmap_huge(struct vm_area_struct *vma, struct uio_mem *mem)
+{
+	/* PFN mappings that can be COWed must go through remap_pfn_range() */
+	return (vma->vm_flags & VM_SHARED || !(vma->vm_flags & VM_MAYWRITE)) &&
+	       mem->size >= PMD_SIZE;
+}
+
+static unsigned long uio_get_unmapped_area(struct file *filep,
+					   unsigned long addr,
+					   unsigned long len,
+					   unsigned long pgoff,
+					   unsigned long flags)
+{
+	struct uio_listener *listener = filep->private_data;
+	struct uio_device *idev = listener->dev;
+	phys_addr_t phys = 0;
+	unsigned long ret;
+
+	if (addr || (flags & MAP_FIXED) || len < PMD_SIZE)
+		goto fallback;
+
+	mutex_lock(&idev->info_lock);
+	if (idev->info && pgoff < MAX_UIO_MAPS &&
+	    idev->info->mem[pgoff].size &&
+	    (idev->info->mem[pgoff].memtype == UIO_MEM_PHYS ||
+	     idev->info->mem[pgoff].memtype == UIO_MEM_IOVA))
+		phys = idev->info->mem[pgoff].addr;
+	mutex_unlock(&idev->info_lock);
+	if (!phys || len + PMD_SIZE < len)
+		goto fallback;
+
+	/* Give the mapping the same offset in a PMD as the region */
+	ret = current->mm->get_unmapped_area(filep, 0, len + PMD_SIZE, pgoff,
+					     flags);
+	if (IS_ERR_VALUE(ret))
+		goto fallback;
+
+	return ret + ((phys - ret) & ~PMD_MASK);
+
+fallback:
+	return current->mm->get_unmapped_area(filep, addr, len, pgoff, flags);
+}
+#else
+static bool uio_mmap_huge(struct vm_area_struct *vma, struct uio_mem *mem)
+{
+	return false;
+}
+#endif
+
 static int uio_mmap_physical(struct vm_area_struct *vma)
 {
 	struct uio_device *idev = vma->vm_private_data;
@@ -783,6 +955,15 @@ static int uio_mmap_physical(struct vm_area_struct *vma)
 	if (idev->info->mem[mi].memtype == UIO_MEM_PHYS)
 		vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
 
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+	if (uio_mmap_huge(vma, mem)) {
+		vma->vm_flags |= VM_PFNMAP | VM_IO | VM_DONTEXPAND |
+				 VM_DONTDUMP | VM_HUGEPAGE;
+		vma->vm_ops = &uio_physical_huge_vm_ops;
+		return 0;
+	}
+#endif
+
 	/*
 	 * We cannot use the vm_iomap_memory() helper here,
 	 * because vma->vm_pgoff is the map index we looked
@@ -862,6 +1043,9 @@ static const struct file_operations uio_fops = {
 	.read		= uio_read,
 	.write		= uio_write,
 	.mmap		= uio_mmap,
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+	.get_unmapped_area = uio_get_unmapped_area,
+#endif
 	.poll		= uio_poll,
 	.unlocked_ioctl	= uio_ioctl,
 	.fasync		= uio_fasync,
@@ -981,6 +1165,8 @@ int __uio_register_device(struct module *owner,
 	mutex_init(&idev->info_lock);
 	init_waitqueue_head(&idev->wait);
 	atomic_set(&idev->event, 0);
+	INIT_LIST_HEAD(&idev->irqfds);
+	spin_lock_init(&idev->irqfd_lock);
 
 	ret = uio_get_minor(idev);
 	if (ret) {
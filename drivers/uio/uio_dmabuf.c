@@ -9,6 +9,7 @@
  */
 
 #include <linux/dma-buf.h>
+#include <linux/dma-mapping.h>
 #include <linux/list.h>
 #include <linux/mutex.h>
 #include <linux/uaccess.h>
@@ -19,7 +20,25 @@
 
 #include "uio_dmabuf.h"
 
+/*
+ * Number of unmapped dma bufs kept attached and mapped per listener, so that
+ * mapping the same buffer again costs a cache sync instead of a full attach
+ * and map.
+ */
+#define UIO_DMABUF_MAX_IDLE	16
+
+/**
+ * struct uio_dmabuf_mem - dma buf mapping of a listener
+ * @users: number of outstanding UIO_IOC_MAP_DMABUF calls, 0 if idle
+ * @dbuf_fd: fd of the last UIO_IOC_MAP_DMABUF call
+ * @dbuf: the dma buf, the key of the cache together with @dir
+ * @dbuf_attach: attachment to the uio device
+ * @sgt: mapped scatterlist of @dbuf_attach
+ * @dir: direction of the mapping
+ * @list: entry in the listener list, most recently used first
+ */
 struct uio_dmabuf_mem {
+	unsigned int users;
 	int dbuf_fd;
 	struct dma_buf *dbuf;
 	struct dma_buf_attachment *dbuf_attach;
@@ -28,51 +47,62 @@ struct uio_dmabuf_mem {
 	struct list_head list;
 };
 
-long uio_dmabuf_map(struct uio_device *dev, struct list_head *dbufs,
-		    struct mutex *dbufs_lock, void __user *user_args)
+static void uio_dmabuf_release(struct uio_dmabuf_mem *dbuf_mem)
+{
+	list_del(&dbuf_mem->list);
+	dma_buf_unmap_attachment(dbuf_mem->dbuf_attach, dbuf_mem->sgt,
+				 dbuf_mem->dir);
+	dma_buf_detach(dbuf_mem->dbuf, dbuf_mem->dbuf_attach);
+	dma_buf_put(dbuf_mem->dbuf);
+	kfree(dbuf_mem);
+}
+
+static struct uio_dmabuf_mem *uio_dmabuf_find(struct list_head *dbufs,
+					      struct dma_buf *dbuf,
+					      enum dma_data_direction dir)
 {
-	struct uio_dmabuf_args args;
 	struct uio_dmabuf_mem *dbuf_mem;
-	struct dma_buf *dbuf;
-	struct dma_buf_attachment *dbuf_attach;
-	enum dma_data_direction dir;
-	struct sg_table *sgt;
-	long ret;
 
-	if (copy_from_user(&args, user_args, sizeof(args))) {
-		ret = -EFAULT;
-		dev_err(dev->dev.parent, "failed to copy from user\n");
-		goto err;
-	}
+	list_for_each_entry(dbuf_mem, dbufs, list)
+		if (dbuf_mem->dbuf == dbuf && dbuf_mem->dir == dir)
+			return dbuf_mem;
 
-	dbuf = dma_buf_get(args.dbuf_fd);
-	if (IS_ERR(dbuf)) {
-		dev_err(dev->dev.parent, "failed to get dmabuf\n");
-		return PTR_ERR(dbuf);
+	return NULL;
+}
+
+/* Drop the least recently used idle mappings beyond the cache size */
+static void uio_dmabuf_trim(struct list_head *dbufs)
+{
+	struct uio_dmabuf_mem *dbuf_mem, *prev;
+	unsigned int idle = 0;
+
+	list_for_each_entry(dbuf_mem, dbufs, list)
+		if (!dbuf_mem->users)
+			idle++;
+
+	list_for_each_entry_safe_reverse(dbuf_mem, prev, dbufs, list) {
+		if (idle <= UIO_DMABUF_MAX_IDLE)
+			break;
+		if (dbuf_mem->users)
+			continue;
+		uio_dmabuf_release(dbuf_mem);
+		idle--;
 	}
+}
+
+static struct uio_dmabuf_mem *uio_dmabuf_create(struct uio_device *dev,
+						struct dma_buf *dbuf,
+						enum dma_data_direction dir)
+{
+	struct uio_dmabuf_mem *dbuf_mem;
+	struct dma_buf_attachment *dbuf_attach;
+	struct sg_table *sgt;
+	long ret;
 
 	dbuf_attach = dma_buf_attach(dbuf, dev->dev.parent);
 	if (IS_ERR(dbuf_attach)) {
 		dev_err(dev->dev.parent, "failed to attach dmabuf\n");
-		ret = PTR_ERR(dbuf_attach);
-		goto err_put;
-	}
-
-	switch (args.dir) {
-	case UIO_DMABUF_DIR_BIDIR:
-		dir = DMA_BIDIRECTIONAL;
-		break;
-	case UIO_DMABUF_DIR_TO_DEV:
-		dir = DMA_TO_DEVICE;
-		break;
-	case UIO_DMABUF_DIR_FROM_DEV:
-		dir = DMA_FROM_DEVICE;
-		break;
-	default:
-		/* Not needed with check. Just here for any future change  */
-		dev_err(dev->dev.parent, "invalid direction\n");
-		ret = -EINVAL;
-		goto err_detach;
+		return ERR_CAST(dbuf_attach);
 	}
 
 	sgt = dma_buf_map_attachment(dbuf_attach, dir);
@@ -109,35 +139,95 @@ long uio_dmabuf_map(struct uio_device *dev, struct list_head *dbufs,
 		goto err_unmap;
 	}
 
-	dbuf_mem->dbuf_fd = args.dbuf_fd;
 	dbuf_mem->dbuf = dbuf;
 	dbuf_mem->dbuf_attach = dbuf_attach;
 	dbuf_mem->sgt = sgt;
 	dbuf_mem->dir = dir;
-	args.dma_addr = sg_dma_address(sgt->sgl);
-	args.size = dbuf->size;
 
-	if (copy_to_user(user_args, &args, sizeof(args))) {
-		ret = -EFAULT;
-		dev_err(dev->dev.parent, "failed to copy to user\n");
-		goto err_free;
+	return dbuf_mem;
+
+err_unmap:
+	dma_buf_unmap_attachment(dbuf_attach, sgt, dir);
+err_detach:
+	dma_buf_detach(dbuf, dbuf_attach);
+	return ERR_PTR(ret);
+}
+
+long uio_dmabuf_map(struct uio_device *dev, struct list_head *dbufs,
+		    struct mutex *dbufs_lock, void __user *user_args)
+{
+	struct uio_dmabuf_args args;
+	struct uio_dmabuf_mem *dbuf_mem;
+	struct dma_buf *dbuf;
+	enum dma_data_direction dir;
+	long ret;
+
+	if (copy_from_user(&args, user_args, sizeof(args))) {
+		dev_err(dev->dev.parent, "failed to copy from user\n");
+		return -EFAULT;
+	}
+
+	switch (args.dir) {
+	case UIO_DMABUF_DIR_BIDIR:
+		dir = DMA_BIDIRECTIONAL;
+		break;
+	case UIO_DMABUF_DIR_TO_DEV:
+		dir = DMA_TO_DEVICE;
+		break;
+	case UIO_DMABUF_DIR_FROM_DEV:
+		dir = DMA_FROM_DEVICE;
+		break;
+	default:
+		dev_err(dev->dev.parent, "invalid direction\n");
+		return -EINVAL;
+	}
+
+	dbuf = dma_buf_get(args.dbuf_fd);
+	if (IS_ERR(dbuf)) {
+		dev_err(dev->dev.parent, "failed to get dmabuf\n");
+		return PTR_ERR(dbuf);
 	}
 
 	mutex_lock(dbufs_lock);
-	list_add(&dbuf_mem->list, dbufs);
+
+	dbuf_mem = uio_dmabuf_find(dbufs, dbuf, dir);
+	if (dbuf_mem) {
+		/* The cached entry already holds a reference */
+		dma_buf_put(dbuf);
+
+		/* Hand an idle buffer back to the device */
+		if (!dbuf_mem->users && !dbuf_mem->dbuf_attach->coherent)
+			dma_sync_sg_for_device(dev->dev.parent,
+					       dbuf_mem->sgt->sgl,
+					       dbuf_mem->sgt->orig_nents, dir);
+		list_move(&dbuf_mem->list, dbufs);
+	} else {
+		dbuf_mem = uio_dmabuf_create(dev, dbuf, dir);
+		if (IS_ERR(dbuf_mem)) {
+			ret = PTR_ERR(dbuf_mem);
+			dma_buf_put(dbuf);
+			goto err_unlock;
+		}
+		list_add(&dbuf_mem->list, dbufs);
+	}
+	dbuf_mem->users++;
+	dbuf_mem->dbuf_fd = args.dbuf_fd;
+
+	args.dma_addr = sg_dma_address(dbuf_mem->sgt->sgl);
+	args.size = dbuf_mem->dbuf->size;
+
 	mutex_unlock(dbufs_lock);
 
+	if (copy_to_user(user_args, &args, sizeof(args))) {
+		dev_err(dev->dev.parent, "failed to copy to user\n");
+		/* Leave the mapping for uio_dmabuf_unmap() or the cleanup */
+		return -EFAULT;
+	}
+
 	return 0;
 
-err_free:
-	kfree(dbuf_mem);
-err_unmap:
-	dma_buf_unmap_attachment(dbuf_attach, sgt, dir);
-err_detach:
-	dma_buf_detach(dbuf, dbuf_attach);
-err_put:
-	dma_buf_put(dbuf);
-err:
+err_unlock:
+	mutex_unlock(dbufs_lock);
 	return ret;
 }
 
@@ -146,48 +236,53 @@ long uio_dmabuf_unmap(struct uio_device *dev, struct list_head *dbufs,
 
 {
 	struct uio_dmabuf_args args;
-	struct uio_dmabuf_mem *dbuf_mem;
-	long ret;
+	struct uio_dmabuf_mem *dbuf_mem, *found = NULL;
+	struct dma_buf *dbuf;
 
-	if (copy_from_user(&args, user_args, sizeof(args))) {
-		ret = -EFAULT;
-		goto err;
-	}
+	if (copy_from_user(&args, user_args, sizeof(args)))
+		return -EFAULT;
+
+	/* The fd may already be closed, then fall back to the fd number */
+	dbuf = dma_buf_get(args.dbuf_fd);
 
 	mutex_lock(dbufs_lock);
 	list_for_each_entry(dbuf_mem, dbufs, list) {
-		if (dbuf_mem->dbuf_fd == args.dbuf_fd)
+		if (!dbuf_mem->users)
+			continue;
+		if (IS_ERR(dbuf) ? dbuf_mem->dbuf_fd == args.dbuf_fd :
+		    dbuf_mem->dbuf == dbuf) {
+			found = dbuf_mem;
 			break;
+		}
 	}
+	if (!IS_ERR(dbuf))
+		dma_buf_put(dbuf);
 
-	if (dbuf_mem->dbuf_fd != args.dbuf_fd) {
+	if (!found) {
+		mutex_unlock(dbufs_lock);
 		dev_err(dev->dev.parent, "failed to find the dmabuf (%d)\n",
 			args.dbuf_fd);
-		ret = -EINVAL;
-		goto err_unlock;
+		return -EINVAL;
 	}
-	list_del(&dbuf_mem->list);
-	mutex_unlock(dbufs_lock);
 
-	dma_buf_unmap_attachment(dbuf_mem->dbuf_attach, dbuf_mem->sgt,
-				 dbuf_mem->dir);
-	dma_buf_detach(dbuf_mem->dbuf, dbuf_mem->dbuf_attach);
-	dma_buf_put(dbuf_mem->dbuf);
-	kfree(dbuf_mem);
+	/*
+	 * Keep the mapping cached for the next map of the same buffer, only
+	 * giving the buffer back to the CPU.
+	 */
+	if (!--found->users) {
+		if (!found->dbuf_attach->coherent)
+			dma_sync_sg_for_cpu(dev->dev.parent, found->sgt->sgl,
+					    found->sgt->orig_nents, found->dir);
+		uio_dmabuf_trim(dbufs);
+	}
+	mutex_unlock(dbufs_lock);
 
 	memset(&args, 0x0, sizeof(args));
 
-	if (copy_to_user(user_args, &args, sizeof(args))) {
-		ret = -EFAULT;
-		goto err;
-	}
+	if (copy_to_user(user_args, &args, sizeof(args)))
+		return -EFAULT;
 
 	return 0;
-
-err_unlock:
-	mutex_unlock(dbufs_lock);
-err:
-	return ret;
 }
 
 int uio_dmabuf_cleanup(struct uio_device *dev, struct list_head *dbufs,
@@ -196,14 +291,8 @@ int uio_dmabuf_cleanup(struct uio_device *dev, struct list_head *dbufs,
 	struct uio_dmabuf_mem *dbuf_mem, *next;
 
 	mutex_lock(dbufs_lock);
-	list_for_each_entry_safe(dbuf_mem, next, dbufs, list) {
-		list_del(&dbuf_mem->list);
-		dma_buf_unmap_attachment(dbuf_mem->dbuf_attach, dbuf_mem->sgt,
-					 dbuf_mem->dir);
-		dma_buf_detach(dbuf_mem->dbuf, dbuf_mem->dbuf_attach);
-		dma_buf_put(dbuf_mem->dbuf);
-		kfree(dbuf_mem);
-	}
+	list_for_each_entry_safe(dbuf_mem, next, dbufs, list)
+		uio_dmabuf_release(dbuf_mem);
 	mutex_unlock(dbufs_lock);
 
 	return 0;
@@ -13,15 +13,35 @@
  */
 
 #include <linux/clk.h>
+#include <linux/devfreq-event.h>
+#include <linux/hrtimer.h>
 #include <linux/io.h>
 #include <linux/module.h>
 #include <linux/of.h>
+#include <linux/perf_event.h>
 #include <linux/platform_device.h>
 #include <linux/pm_runtime.h>
 #include <linux/slab.h>
 #include <linux/uio_driver.h>
 
+#define XAPM_GCC_LSW_OFFSET	0x0004  /* Global Clock Counter */
 #define XAPM_IS_OFFSET		0x0038  /* Interrupt Status Register */
+#define XAPM_MSR_OFFSET(n)	(0x0044 + ((n) / 4) * 4) /* Metric Selector */
+#define XAPM_MC_OFFSET(n)	(0x0100 + (n) * 0x10) /* Metric Counter */
+#define XAPM_CTL_OFFSET		0x0300  /* Control Register */
+#define XAPM_CR_MCNTR_ENABLE	BIT(0)
+#define XAPM_CR_GCC_ENABLE	BIT(16)
+#define XAPM_MSR_METRIC_MASK	GENMASK(4, 0)
+#define XAPM_MSR_SLOT_SHIFT	5
+#define XAPM_MSR_SLOT_MASK	GENMASK(2, 0)
+#define XAPM_MSR_FIELD_WIDTH	8
+#define XAPM_MAX_COUNTERS	10
+#define XAPM_MAX_METRIC		11
+#define XAPM_METRIC_WRITE_BYTES	0x02
+#define XAPM_METRIC_READ_BYTES	0x03
+#define XAPM_DEVFREQ_COUNTERS	2
+#define XAPM_DEFAULT_DATA_WIDTH	128
+#define XAPM_POLL_PERIOD_NS	(100 * NSEC_PER_MSEC)
 #define DRV_NAME		"xilinxapm_uio"
 #define DRV_VERSION		"1.0"
 #define UIO_DUMMY_MEMSIZE	4096
@@ -66,11 +86,39 @@ struct xapm_param {
  * @info: uio_info structure
  * @param: xapm_param structure
  * @regs: IOmapped base address
+ * @pmu: perf PMU over the metric counters
+ * @events: perf events bound to the metric counters
+ * @hrtimer: timer folding the 32bit counters before they wrap
+ * @num_counters: number of metric counters usable by perf
+ * @num_active: number of counters in use by perf
+ * @cpu: CPU the perf events are bound to
+ * @pmu_registered: the PMU is registered
+ * @edev: devfreq-event device reporting the load of a slot
+ * @edev_desc: descriptor of @edev
+ * @edev_slot: monitor slot reported by @edev
+ * @edev_counter: first of the metric counters reserved for @edev
+ * @edev_width: data width of the slot in bytes
+ * @edev_bytes: bytes counted by the reserved counters at the last read
+ * @edev_cycles: global clock counter at the last read
  */
 struct xapm_dev {
 	struct uio_info info;
 	struct xapm_param param;
 	void __iomem *regs;
+	struct pmu pmu;
+	struct perf_event *events[XAPM_MAX_COUNTERS];
+	struct hrtimer hrtimer;
+	unsigned int num_counters;
+	unsigned int num_active;
+	unsigned int cpu;
+	bool pmu_registered;
+	struct devfreq_event_dev *edev;
+	struct devfreq_event_desc edev_desc;
+	u32 edev_slot;
+	unsigned int edev_counter;
+	u32 edev_width;
+	u32 edev_bytes;
+	u32 edev_cycles;
 };
 
 /**
@@ -94,6 +142,512 @@ static irqreturn_t xapm_handler(int irq, struct uio_info *info)
 	return IRQ_HANDLED;
 }
 
+#ifdef CONFIG_PERF_EVENTS
+/*
+ * In advanced mode the metric counters count a metric of a monitor slot
+ * selected through the metric selector registers. They are exposed as an
+ * uncore PMU, an event being the metric number and the slot it applies to.
+ * The counters are free running, the PMU never resets them and only
+ * accumulates deltas, so it can coexist with a UIO user reading them.
+ */
+#define to_xapm(p)	container_of(p, struct xapm_dev, pmu)
+
+static ssize_t xapm_pmu_cpumask_show(struct device *dev,
+				     struct device_attribute *attr, char *buf)
+{
+	struct xapm_dev *xapm = to_xapm(dev_get_drvdata(dev));
+
+	return cpumap_print_to_pagebuf(true, buf, cpumask_of(xapm->cpu));
+}
+
+static struct device_attribute xapm_pmu_cpumask_attr =
+	__ATTR(cpumask, 0444, xapm_pmu_cpumask_show, NULL);
+
+static struct attribute *xapm_pmu_cpumask_attrs[] = {
+	&xapm_pmu_cpumask_attr.attr,
+	NULL,
+};
+
+static struct attribute_group xapm_pmu_cpumask_attr_group = {
+	.attrs = xapm_pmu_cpumask_attrs,
+};
+
+static ssize_t xapm_pmu_event_show(struct device *dev,
+				   struct device_attribute *attr, char *page)
+{
+	struct perf_pmu_events_attr *pmu_attr;
+
+	pmu_attr = container_of(attr, struct perf_pmu_events_attr, attr);
+	return sprintf(page, "event=0x%02llx\n", pmu_attr->id);
+}
+
+#define XAPM_PMU_EVENT_ATTR(_name, _id)					\
+	(&((struct perf_pmu_events_attr[]) {				\
+		{ .attr = __ATTR(_name, 0444, xapm_pmu_event_show, NULL),\
+		  .id = _id, }						\
+	})[0].attr.attr)
+
+static struct attribute *xapm_pmu_events_attrs[] = {
+	XAPM_PMU_EVENT_ATTR(write-transactions, 0x00),
+	XAPM_PMU_EVENT_ATTR(read-transactions, 0x01),
+	XAPM_PMU_EVENT_ATTR(write-bytes, 0x02),
+	XAPM_PMU_EVENT_ATTR(read-bytes, 0x03),
+	XAPM_PMU_EVENT_ATTR(write-beats, 0x04),
+	XAPM_PMU_EVENT_ATTR(read-latency, 0x05),
+	XAPM_PMU_EVENT_ATTR(write-latency, 0x06),
+	XAPM_PMU_EVENT_ATTR(write-idle-cycles, 0x07),
+	XAPM_PMU_EVENT_ATTR(read-idle-cycles, 0x08),
+	XAPM_PMU_EVENT_ATTR(write-responses, 0x09),
+	XAPM_PMU_EVENT_ATTR(write-lasts, 0x0a),
+	XAPM_PMU_EVENT_ATTR(read-lasts, 0x0b),
+	NULL,
+};
+
+static struct attribute_group xapm_pmu_events_attr_group = {
+	.name = "events",
+	.attrs = xapm_pmu_events_attrs,
+};
+
+PMU_FORMAT_ATTR(event, "config:0-4");
+PMU_FORMAT_ATTR(slot, "config:5-7");
+
+static struct attribute *xapm_pmu_format_attrs[] = {
+	&format_attr_event.attr,
+	&format_attr_slot.attr,
+	NULL,
+};
+
+static struct attribute_group xapm_pmu_format_attr_group = {
+	.name = "format",
+	.attrs = xapm_pmu_format_attrs,
+};
+
+static const struct attribute_group *xapm_pmu_attr_groups[] = {
+	&xapm_pmu_events_attr_group,
+	&xapm_pmu_format_attr_group,
+	&xapm_pmu_cpumask_attr_group,
+	NULL,
+};
+
+/**
+ * xapm_pmu_event_update - Accumulate the counter delta into a perf event
+ * @event: Pointer to the perf event
+ */
+static void xapm_pmu_event_update(struct perf_event *event)
+{
+	struct xapm_dev *xapm = to_xapm(event->pmu);
+	struct hw_perf_event *hwc = &event->hw;
+	u64 prev, now;
+
+	do {
+		prev = local64_read(&hwc->prev_count);
+		now = readl(xapm->regs + XAPM_MC_OFFSET(hwc->idx));
+	} while (local64_cmpxchg(&hwc->prev_count, prev, now) != prev);
+
+	local64_add((now - prev) & 0xffffffff, &event->count);
+}
+
+/**
+ * xapm_pmu_event_init - Validate a new perf event
+ * @event: Pointer to the perf event
+ *
+ * Return: '0' on success and failure value on error
+ */
+static int xapm_pmu_event_init(struct perf_event *event)
+{
+	struct xapm_dev *xapm = to_xapm(event->pmu);
+	struct perf_event *sibling;
+	u32 metric, slot;
+
+	if (event->attr.type != event->pmu->type)
+		return -ENOENT;
+
+	/* There is no CPU context to sample on an interconnect counter */
+	if (is_sampling_event(event) || event->attach_state & PERF_ATTACH_TASK)
+		return -EOPNOTSUPP;
+
+	if (event->cpu < 0)
+		return -EOPNOTSUPP;
+
+	metric = event->attr.config & XAPM_MSR_METRIC_MASK;
+	slot = (event->attr.config >> XAPM_MSR_SLOT_SHIFT) &
+	       XAPM_MSR_SLOT_MASK;
+	if (event->attr.config & ~GENMASK(7, 0) || metric > XAPM_MAX_METRIC ||
+	    slot >= xapm->param.maxslots)
+		return -EINVAL;
+
+	if (event->group_leader->pmu != event->pmu &&
+	    !is_software_event(event->group_leader))
+		return -EINVAL;
+
+	for_each_sibling_event(sibling, event->group_leader) {
+		if (sibling->pmu != event->pmu && !is_software_event(sibling))
+			return -EINVAL;
+	}
+
+	event->cpu = xapm->cpu;
+	event->hw.idx = -1;
+
+	return 0;
+}
+
+/**
+ * xapm_pmu_event_start - Start counting a perf event
+ * @event: Pointer to the perf event
+ * @flags: Start flags
+ */
+static void xapm_pmu_event_start(struct perf_event *event, int flags)
+{
+	struct xapm_dev *xapm = to_xapm(event->pmu);
+	struct hw_perf_event *hwc = &event->hw;
+
+	local64_set(&hwc->prev_count,
+		    readl(xapm->regs + XAPM_MC_OFFSET(hwc->idx)));
+	hwc->state = 0;
+}
+
+/**
+ * xapm_pmu_event_stop - Stop counting a perf event
+ * @event: Pointer to the perf event
+ * @flags: Stop flags
+ */
+static void xapm_pmu_event_stop(struct perf_event *event, int flags)
+{
+	struct hw_perf_event *hwc = &event->hw;
+
+	if (hwc->state & PERF_HES_STOPPED)
+		return;
+
+	xapm_pmu_event_update(event);
+	hwc->state |= PERF_HES_STOPPED | PERF_HES_UPTODATE;
+}
+
+/**
+ * xapm_pmu_event_add - Bind a perf event to a metric counter
+ * @event: Pointer to the perf event
+ * @flags: Add flags
+ *
+ * Return: '0' on success and failure value on error
+ */
+static int xapm_pmu_event_add(struct perf_event *event, int flags)
+{
+	struct xapm_dev *xapm = to_xapm(event->pmu);
+	struct hw_perf_event *hwc = &event->hw;
+	u32 shift, msr;
+	int i;
+
+	for (i = 0; i < xapm->num_counters; i++)
+		if (!xapm->events[i])
+			break;
+	if (i == xapm->num_counters)
+		return -EAGAIN;
+
+	shift = (i % 4) * XAPM_MSR_FIELD_WIDTH;
+	msr = readl(xapm->regs + XAPM_MSR_OFFSET(i));
+	msr &= ~(GENMASK(XAPM_MSR_FIELD_WIDTH - 1, 0) << shift);
+	msr |= (event->attr.config & GENMASK(7, 0)) << shift;
+	writel(msr, xapm->regs + XAPM_MSR_OFFSET(i));
+	writel(readl(xapm->regs + XAPM_CTL_OFFSET) | XAPM_CR_MCNTR_ENABLE,
+	       xapm->regs + XAPM_CTL_OFFSET);
+
+	xapm->events[i] = event;
+	hwc->idx = i;
+	hwc->state = PERF_HES_STOPPED | PERF_HES_UPTODATE;
+
+	if (flags & PERF_EF_START)
+		xapm_pmu_event_start(event, flags);
+
+	if (!xapm->num_active++)
+		hrtimer_start(&xapm->hrtimer, ns_to_ktime(XAPM_POLL_PERIOD_NS),
+			      HRTIMER_MODE_REL_PINNED);
+
+	return 0;
+}
+
+/**
+ * xapm_pmu_event_del - Release the metric counter of a perf event
+ * @event: Pointer to the perf event
+ * @flags: Delete flags
+ */
+static void xapm_pmu_event_del(struct perf_event *event, int flags)
+{
+	struct xapm_dev *xapm = to_xapm(event->pmu);
+	struct hw_perf_event *hwc = &event->hw;
+
+	xapm_pmu_event_stop(event, PERF_EF_UPDATE);
+
+	if (!--xapm->num_active)
+		hrtimer_cancel(&xapm->hrtimer);
+
+	xapm->events[hwc->idx] = NULL;
+	hwc->idx = -1;
+}
+
+/**
+ * xapm_pmu_poll - Fold the counters into the perf events before they wrap
+ * @hrtimer: Pointer to the hrtimer
+ *
+ * Return: Always returns HRTIMER_RESTART
+ */
+static enum hrtimer_restart xapm_pmu_poll(struct hrtimer *hrtimer)
+{
+	struct xapm_dev *xapm = container_of(hrtimer, struct xapm_dev, hrtimer);
+	unsigned long flags;
+	int i;
+
+	local_irq_save(flags);
+	for (i = 0; i < xapm->num_counters; i++) {
+		struct perf_event *event = xapm->events[i];
+
+		if (event && !(event->hw.state & PERF_HES_STOPPED))
+			xapm_pmu_event_update(event);
+	}
+	local_irq_restore(flags);
+
+	hrtimer_forward_now(hrtimer, ns_to_ktime(XAPM_POLL_PERIOD_NS));
+
+	return HRTIMER_RESTART;
+}
+
+/**
+ * xapm_pmu_register - Register the metric counters of APM as a perf PMU
+ * @pdev: Pointer to the platform_device structure
+ * @xapm: Pointer to the xapm_dev structure
+ *
+ * Returns: '0' on success and failure value on error
+ */
+static int xapm_pmu_register(struct platform_device *pdev,
+			     struct xapm_dev *xapm)
+{
+	struct resource *res = platform_get_resource(pdev, IORESOURCE_MEM, 0);
+	const char *name;
+	int ret;
+
+	if (xapm->param.mode != XAPM_MODE_ADVANCED || !xapm->param.eventcnt ||
+	    !xapm->param.numcounters)
+		return 0;
+
+	name = devm_kasprintf(&pdev->dev, GFP_KERNEL, "xapm_%llx",
+			      (unsigned long long)res->start);
+	if (!name)
+		return -ENOMEM;
+
+	xapm->num_counters = min_t(u32, xapm->param.numcounters,
+				   XAPM_MAX_COUNTERS);
+	if (xapm->edev)
+		xapm->num_counters = xapm->edev_counter;
+	if (!xapm->num_counters)
+		return 0;
+
+	xapm->cpu = raw_smp_processor_id();
+	hrtimer_init(&xapm->hrtimer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	xapm->hrtimer.function = xapm_pmu_poll;
+
+	xapm->pmu = (struct pmu) {
+		.module = THIS_MODULE,
+		.capabilities = PERF_PMU_CAP_NO_EXCLUDE,
+		.task_ctx_nr = perf_invalid_context,
+		.attr_groups = xapm_pmu_attr_groups,
+		.event_init = xapm_pmu_event_init,
+		.add = xapm_pmu_event_add,
+		.del = xapm_pmu_event_del,
+		.start = xapm_pmu_event_start,
+		.stop = xapm_pmu_event_stop,
+		.read = xapm_pmu_event_update,
+	};
+
+	ret = perf_pmu_register(&xapm->pmu, name, -1);
+	if (ret)
+		return ret;
+
+	xapm->pmu_registered = true;
+
+	return 0;
+}
+
+/**
+ * xapm_pmu_unregister - Unregister the perf PMU of APM
+ * @xapm: Pointer to the xapm_dev structure
+ */
+static void xapm_pmu_unregister(struct xapm_dev *xapm)
+{
+	if (xapm->pmu_registered)
+		perf_pmu_unregister(&xapm->pmu);
+}
+#else
+static int xapm_pmu_register(struct platform_device *pdev,
+			     struct xapm_dev *xapm)
+{
+	return 0;
+}
+
+static void xapm_pmu_unregister(struct xapm_dev *xapm)
+{
+}
+#endif
+
+#ifdef CONFIG_PM_DEVFREQ_EVENT
+/*
+ * With "xlnx,devfreq-slot", the last two metric counters count the bytes
+ * written and read on that slot, and are reported through a devfreq-event
+ * device as a load against the bytes the slot could have carried in the
+ * meantime, for a devfreq driver to scale the clock of the fabric with.
+ * The counters are 32bit, the devfreq polling period must be short enough
+ * for them not to wrap twice in between.
+ */
+
+/**
+ * xapm_devfreq_read_bytes - Read the bytes counted on the devfreq slot
+ * @xapm: Pointer to the xapm_dev structure
+ *
+ * Return: Sum of the bytes written and read, modulo 2^32
+ */
+static u32 xapm_devfreq_read_bytes(struct xapm_dev *xapm)
+{
+	return readl(xapm->regs + XAPM_MC_OFFSET(xapm->edev_counter)) +
+	       readl(xapm->regs + XAPM_MC_OFFSET(xapm->edev_counter + 1));
+}
+
+/**
+ * xapm_devfreq_select - Select the metric a reserved counter counts
+ * @xapm: Pointer to the xapm_dev structure
+ * @counter: Metric counter index
+ * @metric: Metric counted on the devfreq slot
+ */
+static void xapm_devfreq_select(struct xapm_dev *xapm, unsigned int counter,
+				u32 metric)
+{
+	u32 shift = (counter % 4) * XAPM_MSR_FIELD_WIDTH;
+	u32 msr;
+
+	msr = readl(xapm->regs + XAPM_MSR_OFFSET(counter));
+	msr &= ~(GENMASK(XAPM_MSR_FIELD_WIDTH - 1, 0) << shift);
+	msr |= (metric | xapm->edev_slot << XAPM_MSR_SLOT_SHIFT) << shift;
+	writel(msr, xapm->regs + XAPM_MSR_OFFSET(counter));
+}
+
+/**
+ * xapm_devfreq_enable - Start the metric and global clock counters
+ * @edev: Pointer to the devfreq-event device
+ *
+ * Return: Always returns '0'
+ */
+static int xapm_devfreq_enable(struct devfreq_event_dev *edev)
+{
+	struct xapm_dev *xapm = devfreq_event_get_drvdata(edev);
+
+	writel(readl(xapm->regs + XAPM_CTL_OFFSET) | XAPM_CR_MCNTR_ENABLE |
+	       XAPM_CR_GCC_ENABLE, xapm->regs + XAPM_CTL_OFFSET);
+
+	return 0;
+}
+
+/**
+ * xapm_devfreq_set_event - Count the bytes transferred on the slot
+ * @edev: Pointer to the devfreq-event device
+ *
+ * Return: Always returns '0'
+ */
+static int xapm_devfreq_set_event(struct devfreq_event_dev *edev)
+{
+	struct xapm_dev *xapm = devfreq_event_get_drvdata(edev);
+
+	xapm_devfreq_select(xapm, xapm->edev_counter,
+			    XAPM_METRIC_WRITE_BYTES);
+	xapm_devfreq_select(xapm, xapm->edev_counter + 1,
+			    XAPM_METRIC_READ_BYTES);
+
+	xapm->edev_bytes = xapm_devfreq_read_bytes(xapm);
+	xapm->edev_cycles = readl(xapm->regs + XAPM_GCC_LSW_OFFSET);
+
+	return 0;
+}
+
+/**
+ * xapm_devfreq_get_event - Get the load of the slot since the last call
+ * @edev: Pointer to the devfreq-event device
+ * @edata: Bytes transferred, and bytes the slot could have transferred
+ *
+ * Return: Always returns '0'
+ */
+static int xapm_devfreq_get_event(struct devfreq_event_dev *edev,
+				  struct devfreq_event_data *edata)
+{
+	struct xapm_dev *xapm = devfreq_event_get_drvdata(edev);
+	u32 bytes, cycles;
+
+	bytes = xapm_devfreq_read_bytes(xapm);
+	cycles = readl(xapm->regs + XAPM_GCC_LSW_OFFSET);
+
+	edata->load_count = bytes - xapm->edev_bytes;
+	edata->total_count = (unsigned long)(cycles - xapm->edev_cycles) *
+			     xapm->edev_width;
+	edata->load_count = min(edata->load_count, edata->total_count);
+
+	xapm->edev_bytes = bytes;
+	xapm->edev_cycles = cycles;
+
+	return 0;
+}
+
+static const struct devfreq_event_ops xapm_devfreq_ops = {
+	.enable = xapm_devfreq_enable,
+	.set_event = xapm_devfreq_set_event,
+	.get_event = xapm_devfreq_get_event,
+};
+
+/**
+ * xapm_devfreq_register - Register the load of a slot as devfreq-event
+ * @pdev: Pointer to the platform_device structure
+ * @xapm: Pointer to the xapm_dev structure
+ *
+ * Returns: '0' on success and failure value on error
+ */
+static int xapm_devfreq_register(struct platform_device *pdev,
+				 struct xapm_dev *xapm)
+{
+	struct device_node *node = pdev->dev.of_node;
+	u32 num_counters, width = XAPM_DEFAULT_DATA_WIDTH;
+	char prop[32];
+
+	if (of_property_read_u32(node, "xlnx,devfreq-slot", &xapm->edev_slot))
+		return 0;
+
+	num_counters = min_t(u32, xapm->param.numcounters, XAPM_MAX_COUNTERS);
+	if (xapm->param.mode != XAPM_MODE_ADVANCED || !xapm->param.eventcnt ||
+	    num_counters < XAPM_DEVFREQ_COUNTERS ||
+	    xapm->edev_slot >= xapm->param.maxslots)
+		return -EINVAL;
+
+	snprintf(prop, sizeof(prop), "xlnx,slot-%u-axi-data-width",
+		 xapm->edev_slot);
+	of_property_read_u32(node, prop, &width);
+
+	xapm->edev_counter = num_counters - XAPM_DEVFREQ_COUNTERS;
+	xapm->edev_width = max_t(u32, width / BITS_PER_BYTE, 1);
+
+	xapm->edev_desc.name = dev_name(&pdev->dev);
+	xapm->edev_desc.driver_data = xapm;
+	xapm->edev_desc.ops = &xapm_devfreq_ops;
+
+	xapm->edev = devm_devfreq_event_add_edev(&pdev->dev, &xapm->edev_desc);
+	if (IS_ERR(xapm->edev)) {
+		int ret = PTR_ERR(xapm->edev);
+
+		xapm->edev = NULL;
+		return ret;
+	}
+
+	return 0;
+}
+#else
+static int xapm_devfreq_register(struct platform_device *pdev,
+				 struct xapm_dev *xapm)
+{
+	return 0;
+}
+#endif
+
 /**
  * xapm_getprop - Retrieves dts properties to param structure
  * @pdev: Pointer to platform device
@@ -276,6 +830,15 @@ static int xapm_probe(struct platform_device *pdev)
 
 	platform_set_drvdata(pdev, xapm);
 
+	ret = xapm_devfreq_register(pdev, xapm);
+	if (ret)
+		dev_warn(&pdev->dev, "unable to register devfreq-event: %d\n",
+			 ret);
+
+	ret = xapm_pmu_register(pdev, xapm);
+	if (ret)
+		dev_warn(&pdev->dev, "unable to register perf PMU: %d\n", ret);
+
 	dev_info(&pdev->dev, "Probed Xilinx APM\n");
 
 	return 0;
@@ -297,6 +860,7 @@ static int xapm_remove(struct platform_device *pdev)
 {
 	struct xapm_dev *xapm = platform_get_drvdata(pdev);
 
+	xapm_pmu_unregister(xapm);
 	uio_unregister_device(&xapm->info);
 	clk_disable_unprepare(xapm->param.clk);
 	pm_runtime_disable(&pdev->dev);
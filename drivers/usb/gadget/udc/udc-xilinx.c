@@ -383,10 +383,8 @@ static int xudc_dma_send(struct xusb_ep *ep, struct xusb_req *req,
 	dma_addr_t dst;
 	struct xusb_udc *udc = ep->udc;
 
+	/* the whole request was synced for the device when it was mapped */
 	src = req->usb_req.dma + req->usb_req.actual;
-	if (req->usb_req.length)
-		dma_sync_single_for_device(udc->dev, src,
-					   length, DMA_TO_DEVICE);
 	if (!ep->curbufnum && !ep->buffer0ready) {
 		/* Get the Buffer address and copy the transmit data.*/
 		eprambase = (u32 __force *)(udc->addr + ep->rambase);
@@ -633,13 +631,8 @@ static int xudc_read_fifo(struct xusb_ep *ep, struct xusb_req *req)
 			ep->ep_usb.name, count, is_short ? "/S" : "", req,
 			req->usb_req.actual, req->usb_req.length);
 
-		/* Completion */
+		/* Completion, xudc_done() unmaps the buffer for the CPU */
 		if ((req->usb_req.actual == req->usb_req.length) || is_short) {
-			if (udc->dma_enabled && req->usb_req.length)
-				dma_sync_single_for_cpu(udc->dev,
-							req->usb_req.dma,
-							req->usb_req.actual,
-							DMA_FROM_DEVICE);
 			xudc_done(ep, req, 0);
 			return 0;
 		}
@@ -1063,6 +1056,29 @@ static int xudc_ep0_queue(struct usb_ep *_ep, struct usb_request *_req,
 	return ret;
 }
 
+/**
+ * xudc_ep_process_queue - Moves queued requests through the endpoint buffers.
+ * @ep: pointer to the usb device endpoint structure.
+ *
+ * Keeps loading IN packets or unloading OUT packets while the next ping-pong
+ * buffer is available, moving on to the next queued request when one
+ * completes, so both buffers stay busy and a request that completes does not
+ * wait for another buffer interrupt before the next one gets started.
+ */
+static void xudc_ep_process_queue(struct xusb_ep *ep)
+{
+	struct xusb_req *req;
+
+	while (!list_empty(&ep->queue) &&
+	       !(ep->curbufnum ? ep->buffer1ready : ep->buffer0ready)) {
+		req = list_first_entry(&ep->queue, struct xusb_req, queue);
+		if (ep->is_in)
+			xudc_write_fifo(ep, req);
+		else
+			xudc_read_fifo(ep, req);
+	}
+}
+
 /**
  * xudc_ep_queue - Adds the request to endpoint queue.
  * @_ep: pointer to the usb endpoint structure.
@@ -1107,20 +1123,9 @@ static int xudc_ep_queue(struct usb_ep *_ep, struct usb_request *_req,
 		}
 	}
 
-	if (list_empty(&ep->queue)) {
-		if (ep->is_in) {
-			dev_dbg(udc->dev, "xudc_write_fifo from ep_queue\n");
-			if (!xudc_write_fifo(ep, req))
-				req = NULL;
-		} else {
-			dev_dbg(udc->dev, "xudc_read_fifo from ep_queue\n");
-			if (!xudc_read_fifo(ep, req))
-				req = NULL;
-		}
-	}
-
-	if (req != NULL)
-		list_add_tail(&req->queue, &ep->queue);
+	list_add_tail(&req->queue, &ep->queue);
+	if (list_is_singular(&ep->queue))
+		xudc_ep_process_queue(ep);
 
 	spin_unlock_irqrestore(&udc->lock, flags);
 	return 0;
@@ -1948,7 +1953,6 @@ static void xudc_nonctrl_ep_handler(struct xusb_udc *udc, u8 epnum,
 				    u32 intrstatus)
 {
 
-	struct xusb_req *req;
 	struct xusb_ep *ep;
 
 	ep = &udc->ep[epnum];
@@ -1961,12 +1965,7 @@ static void xudc_nonctrl_ep_handler(struct xusb_udc *udc, u8 epnum,
 	if (list_empty(&ep->queue))
 		return;
 
-	req = list_first_entry(&ep->queue, struct xusb_req, queue);
-
-	if (ep->is_in)
-		xudc_write_fifo(ep, req);
-	else
-		xudc_read_fifo(ep, req);
+	xudc_ep_process_queue(ep);
 }
 
 /**
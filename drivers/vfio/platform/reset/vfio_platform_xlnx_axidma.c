@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * VFIO platform driver specialized for Xilinx AXI DMA and AXI CDMA reset
+ *
+ * Copyright (C) 2020 Xilinx, Inc.
+ */
+
+#include <linux/init.h>
+#include <linux/io.h>
+#include <linux/iopoll.h>
+#include <linux/kernel.h>
+#include <linux/module.h>
+
+#include "../vfio_platform_private.h"
+
+#define DRIVER_DESC	"Reset support for Xilinx AXI DMA vfio platform device"
+
+/* Channel control registers */
+#define XILINX_DMA_MM2S_CTRL_OFFSET	0x0000
+#define XILINX_DMA_S2MM_CTRL_OFFSET	0x0030
+#define XILINX_CDMA_CTRL_OFFSET		0x0000
+
+/* DMACR fields */
+#define XILINX_DMA_DMACR_RESET		BIT(2)
+
+#define XILINX_DMA_RESET_TIMEOUT_US	1000
+
+static void __iomem *vfio_platform_xlnx_ioaddr(struct vfio_platform_device *vdev)
+{
+	struct vfio_platform_region *reg = &vdev->regions[0];
+
+	if (!reg->ioaddr)
+		reg->ioaddr = ioremap_nocache(reg->addr, reg->size);
+
+	return reg->ioaddr;
+}
+
+/*
+ * A soft reset stops the channels, clears their interrupt enables and
+ * pending interrupts, and self-clears once the core is idle.
+ */
+static int vfio_platform_xlnx_dma_reset(void __iomem *ioaddr, u32 ctrl)
+{
+	u32 val;
+
+	writel(XILINX_DMA_DMACR_RESET, ioaddr + ctrl);
+
+	return readl_poll_timeout(ioaddr + ctrl, val,
+				  !(val & XILINX_DMA_DMACR_RESET), 10,
+				  XILINX_DMA_RESET_TIMEOUT_US);
+}
+
+static int vfio_platform_xlnx_axidma_reset(struct vfio_platform_device *vdev)
+{
+	void __iomem *ioaddr = vfio_platform_xlnx_ioaddr(vdev);
+	int ret;
+
+	if (!ioaddr)
+		return -ENOMEM;
+
+	/*
+	 * Resetting either channel resets the whole core, but a design may
+	 * have only one of them, so go through both.
+	 */
+	ret = vfio_platform_xlnx_dma_reset(ioaddr, XILINX_DMA_MM2S_CTRL_OFFSET);
+	if (!ret)
+		ret = vfio_platform_xlnx_dma_reset(ioaddr,
+						   XILINX_DMA_S2MM_CTRL_OFFSET);
+	if (ret)
+		dev_err(vdev->device, "AXI DMA reset timed out\n");
+
+	return ret;
+}
+
+static int vfio_platform_xlnx_axicdma_reset(struct vfio_platform_device *vdev)
+{
+	void __iomem *ioaddr = vfio_platform_xlnx_ioaddr(vdev);
+	int ret;
+
+	if (!ioaddr)
+		return -ENOMEM;
+
+	ret = vfio_platform_xlnx_dma_reset(ioaddr, XILINX_CDMA_CTRL_OFFSET);
+	if (ret)
+		dev_err(vdev->device, "AXI CDMA reset timed out\n");
+
+	return ret;
+}
+
+static int __init vfio_platform_xlnx_axidma_init(void)
+{
+	vfio_platform_register_reset("xlnx,axi-dma-1.00.a",
+				     vfio_platform_xlnx_axidma_reset);
+	vfio_platform_register_reset("xlnx,axi-cdma-1.00.a",
+				     vfio_platform_xlnx_axicdma_reset);
+
+	return 0;
+}
+
+static void __exit vfio_platform_xlnx_axidma_exit(void)
+{
+	vfio_platform_unregister_reset("xlnx,axi-cdma-1.00.a",
+				       vfio_platform_xlnx_axicdma_reset);
+	vfio_platform_unregister_reset("xlnx,axi-dma-1.00.a",
+				       vfio_platform_xlnx_axidma_reset);
+}
+
+module_init(vfio_platform_xlnx_axidma_init);
+module_exit(vfio_platform_xlnx_axidma_exit);
+
+MODULE_ALIAS("vfio-reset:xlnx,axi-dma-1.00.a");
+MODULE_ALIAS("vfio-reset:xlnx,axi-cdma-1.00.a");
+MODULE_LICENSE("GPL v2");
+MODULE_AUTHOR("Xilinx, Inc.");
+MODULE_DESCRIPTION(DRIVER_DESC);
@@ -70,6 +70,8 @@
 #include <linux/nospec.h>
 #include <linux/sizes.h>
 #include <linux/hugetlb.h>
+#include <linux/dma-buf.h>
+#include <linux/io_uring.h>
 
 #include <uapi/linux/io_uring.h>
 
@@ -159,6 +161,7 @@ struct io_mapped_ubuf {
 	size_t		len;
 	struct		bio_vec *bvec;
 	unsigned int	nr_bvecs;
+	struct file	*dmabuf;	/* dma-buf backing the buffer, if any */
 };
 
 struct async_list {
@@ -490,6 +493,7 @@ static inline void io_queue_async_work(struct io_ring_ctx *ctx,
 		switch (req->submit.sqe->opcode) {
 		case IORING_OP_WRITEV:
 		case IORING_OP_WRITE_FIXED:
+		case IORING_OP_WRITE:
 			rw = !(req->rw.ki_flags & IOCB_DIRECT);
 			break;
 		}
@@ -1261,6 +1265,14 @@ static ssize_t io_import_iovec(struct io_ring_ctx *ctx, int rw,
 	if (!s->has_user)
 		return -EFAULT;
 
+	if (opcode == IORING_OP_READ || opcode == IORING_OP_WRITE) {
+		ssize_t ret;
+
+		ret = import_single_range(rw, buf, sqe_len, *iovec, iter);
+		*iovec = NULL;
+		return ret < 0 ? ret : sqe_len;
+	}
+
 #ifdef CONFIG_COMPAT
 	if (ctx->compat)
 		return compat_import_iovec(rw, buf, sqe_len, UIO_FASTIOV,
@@ -1680,6 +1692,197 @@ static int io_recvmsg(struct io_kiocb *req, const struct io_uring_sqe *sqe,
 #endif
 }
 
+#if defined(CONFIG_NET)
+static int io_send_recv(struct io_kiocb *req, const struct io_uring_sqe *sqe,
+			bool force_nonblock, int rw)
+{
+	struct socket *sock;
+	int ret;
+
+	if (unlikely(req->ctx->flags & IORING_SETUP_IOPOLL))
+		return -EINVAL;
+
+	sock = sock_from_file(req->file, &ret);
+	if (sock) {
+		void __user *buf = u64_to_user_ptr(READ_ONCE(sqe->addr));
+		size_t len = READ_ONCE(sqe->len);
+		struct msghdr msg;
+		struct iovec iov;
+		unsigned flags;
+
+		ret = import_single_range(rw, buf, len, &iov, &msg.msg_iter);
+		if (ret)
+			goto out;
+
+		msg.msg_name = NULL;
+		msg.msg_namelen = 0;
+		msg.msg_control = NULL;
+		msg.msg_controllen = 0;
+		msg.msg_iocb = NULL;
+
+		flags = READ_ONCE(sqe->msg_flags);
+		if (req->file->f_flags & O_NONBLOCK)
+			flags |= MSG_DONTWAIT;
+		if (flags & MSG_DONTWAIT)
+			req->flags |= REQ_F_NOWAIT;
+		else if (force_nonblock)
+			flags |= MSG_DONTWAIT;
+
+		if (rw == WRITE) {
+			msg.msg_flags = flags;
+			ret = sock_sendmsg(sock, &msg);
+		} else {
+			msg.msg_flags = 0;
+			ret = sock_recvmsg(sock, &msg, flags);
+		}
+		if (force_nonblock && ret == -EAGAIN)
+			return ret;
+		if (ret == -ERESTARTSYS)
+			ret = -EINTR;
+	}
+
+out:
+	if (ret < 0 && (req->flags & REQ_F_LINK))
+		req->flags |= REQ_F_FAIL_LINK;
+	io_cqring_add_event(req->ctx, sqe->user_data, ret);
+	io_put_req(req);
+	return 0;
+}
+#endif
+
+static int io_send(struct io_kiocb *req, const struct io_uring_sqe *sqe,
+		   bool force_nonblock)
+{
+#if defined(CONFIG_NET)
+	return io_send_recv(req, sqe, force_nonblock, WRITE);
+#else
+	return -EOPNOTSUPP;
+#endif
+}
+
+static int io_recv(struct io_kiocb *req, const struct io_uring_sqe *sqe,
+		   bool force_nonblock)
+{
+#if defined(CONFIG_NET)
+	return io_send_recv(req, sqe, force_nonblock, READ);
+#else
+	return -EOPNOTSUPP;
+#endif
+}
+
+/*
+ * IORING_OP_URING_CMD passes an ioctl style command and argument to the
+ * file. It is first issued non-blocking from the submitter, commands that
+ * would block are then issued again from an async worker.
+ */
+static int io_uring_cmd(struct io_kiocb *req, const struct io_uring_sqe *sqe,
+			bool force_nonblock)
+{
+	struct file *file = req->file;
+	unsigned int issue_flags = 0;
+	long ret;
+
+	if (unlikely(req->ctx->flags & IORING_SETUP_IOPOLL))
+		return -EINVAL;
+	if (sqe->ioprio || sqe->len || sqe->buf_index || sqe->rw_flags)
+		return -EINVAL;
+	if (!file->f_op->uring_cmd)
+		return -EOPNOTSUPP;
+
+	if (force_nonblock)
+		issue_flags |= IO_URING_F_NONBLOCK;
+
+	ret = file->f_op->uring_cmd(file, READ_ONCE(sqe->cmd_op),
+				    READ_ONCE(sqe->addr), issue_flags);
+	if (ret == -EAGAIN && force_nonblock)
+		return -EAGAIN;
+	if (ret == -ERESTARTSYS)
+		ret = -EINTR;
+	if (ret < 0 && (req->flags & REQ_F_LINK))
+		req->flags |= REQ_F_FAIL_LINK;
+	io_cqring_add_event(req->ctx, sqe->user_data, ret);
+	io_put_req(req);
+	return 0;
+}
+
+/*
+ * The new fd has to be installed in the file table of the submitter, which
+ * the async workers and the SQ thread don't run with. Accept is therefore
+ * only issued inline and never blocks: when no connection is pending it
+ * completes with -EAGAIN, pair it with an IORING_OP_POLL_ADD for POLLIN.
+ */
+static int io_accept(struct io_kiocb *req, const struct sqe_submit *s)
+{
+#if defined(CONFIG_NET)
+	const struct io_uring_sqe *sqe = s->sqe;
+	struct sockaddr __user *addr;
+	int __user *addr_len;
+	int flags, ret;
+
+	if (unlikely(req->ctx->flags & (IORING_SETUP_IOPOLL |
+					IORING_SETUP_SQPOLL)))
+		return -EINVAL;
+	if (sqe->ioprio || sqe->len || sqe->buf_index)
+		return -EINVAL;
+	/* linked and drained requests are issued from the async workers */
+	if (s->needs_lock)
+		return -EINVAL;
+
+	addr = u64_to_user_ptr(READ_ONCE(sqe->addr));
+	addr_len = u64_to_user_ptr(READ_ONCE(sqe->addr2));
+	flags = READ_ONCE(sqe->accept_flags);
+
+	ret = __sys_accept4_file(req->file, O_NONBLOCK, addr, addr_len, flags);
+	if (ret == -ERESTARTSYS)
+		ret = -EINTR;
+	if (ret < 0 && (req->flags & REQ_F_LINK))
+		req->flags |= REQ_F_FAIL_LINK;
+	io_cqring_add_event(req->ctx, sqe->user_data, ret);
+	io_put_req(req);
+	return 0;
+#else
+	return -EOPNOTSUPP;
+#endif
+}
+
+static int io_connect(struct io_kiocb *req, const struct io_uring_sqe *sqe,
+		      bool force_nonblock)
+{
+#if defined(CONFIG_NET)
+	struct sockaddr __user *addr;
+	unsigned file_flags;
+	int addr_len, ret;
+
+	if (unlikely(req->ctx->flags & (IORING_SETUP_IOPOLL |
+					IORING_SETUP_SQPOLL)))
+		return -EINVAL;
+	if (sqe->ioprio || sqe->len || sqe->buf_index || sqe->rw_flags)
+		return -EINVAL;
+
+	addr = u64_to_user_ptr(READ_ONCE(sqe->addr));
+	addr_len = READ_ONCE(sqe->addr2);
+	file_flags = force_nonblock ? O_NONBLOCK : 0;
+
+	ret = __sys_connect_file(req->file, addr, addr_len, file_flags);
+	/*
+	 * A blocking connect from the async worker picks up the connection
+	 * attempt started here and waits for it to complete.
+	 */
+	if ((ret == -EAGAIN || ret == -EINPROGRESS) && force_nonblock &&
+	    !(req->file->f_flags & O_NONBLOCK))
+		return -EAGAIN;
+	if (ret == -ERESTARTSYS)
+		ret = -EINTR;
+	if (ret < 0 && (req->flags & REQ_F_LINK))
+		req->flags |= REQ_F_FAIL_LINK;
+	io_cqring_add_event(req->ctx, sqe->user_data, ret);
+	io_put_req(req);
+	return 0;
+#else
+	return -EOPNOTSUPP;
+#endif
+}
+
 static void io_poll_remove_one(struct io_kiocb *req)
 {
 	struct io_poll_iocb *poll = &req->poll;
@@ -2068,9 +2271,17 @@ static int __io_submit_sqe(struct io_ring_ctx *ctx, struct io_kiocb *req,
 			return -EINVAL;
 		ret = io_write(req, s, force_nonblock);
 		break;
+	case IORING_OP_READ:
+		if (unlikely(s->sqe->buf_index))
+			return -EINVAL;
+		/* fall through */
 	case IORING_OP_READ_FIXED:
 		ret = io_read(req, s, force_nonblock);
 		break;
+	case IORING_OP_WRITE:
+		if (unlikely(s->sqe->buf_index))
+			return -EINVAL;
+		/* fall through */
 	case IORING_OP_WRITE_FIXED:
 		ret = io_write(req, s, force_nonblock);
 		break;
@@ -2095,6 +2306,21 @@ static int __io_submit_sqe(struct io_ring_ctx *ctx, struct io_kiocb *req,
 	case IORING_OP_TIMEOUT:
 		ret = io_timeout(req, s->sqe);
 		break;
+	case IORING_OP_SEND:
+		ret = io_send(req, s->sqe, force_nonblock);
+		break;
+	case IORING_OP_RECV:
+		ret = io_recv(req, s->sqe, force_nonblock);
+		break;
+	case IORING_OP_ACCEPT:
+		ret = io_accept(req, s);
+		break;
+	case IORING_OP_CONNECT:
+		ret = io_connect(req, s->sqe, force_nonblock);
+		break;
+	case IORING_OP_URING_CMD:
+		ret = io_uring_cmd(req, s->sqe, force_nonblock);
+		break;
 	default:
 		ret = -EINVAL;
 		break;
@@ -2124,9 +2350,11 @@ static struct async_list *io_async_list_from_sqe(struct io_ring_ctx *ctx,
 	switch (sqe->opcode) {
 	case IORING_OP_READV:
 	case IORING_OP_READ_FIXED:
+	case IORING_OP_READ:
 		return &ctx->pending_async[READ];
 	case IORING_OP_WRITEV:
 	case IORING_OP_WRITE_FIXED:
+	case IORING_OP_WRITE:
 		return &ctx->pending_async[WRITE];
 	default:
 		return NULL;
@@ -3329,6 +3557,8 @@ static int io_sqe_buffer_unregister(struct io_ring_ctx *ctx)
 
 		for (j = 0; j < imu->nr_bvecs; j++)
 			put_user_page(imu->bvec[j].bv_page);
+		if (imu->dmabuf)
+			fput(imu->dmabuf);
 
 		if (ctx->account_mem)
 			io_unaccount_mem(ctx->user, imu->nr_bvecs);
@@ -3388,6 +3618,7 @@ static int io_sqe_buffer_register(struct io_ring_ctx *ctx, void __user *arg,
 	for (i = 0; i < nr_args; i++) {
 		struct io_mapped_ubuf *imu = &ctx->user_bufs[i];
 		unsigned long off, start, end, ubuf;
+		struct file *dmabuf = NULL;
 		int pret, nr_pages;
 		struct iovec iov;
 		size_t size;
@@ -3453,16 +3684,27 @@ static int io_sqe_buffer_register(struct io_ring_ctx *ctx, void __user *arg,
 				      FOLL_WRITE | FOLL_LONGTERM,
 				      pages, vmas);
 		if (pret == nr_pages) {
-			/* don't support file backed memory */
+			/*
+			 * don't support file backed memory, except for the
+			 * mapping of a single dma-buf, which is pinned by
+			 * holding its file
+			 */
 			for (j = 0; j < nr_pages; j++) {
 				struct vm_area_struct *vma = vmas[j];
 
-				if (vma->vm_file &&
-				    !is_file_hugepages(vma->vm_file)) {
+				if (!vma->vm_file ||
+				    is_file_hugepages(vma->vm_file))
+					continue;
+
+				if (!is_dma_buf_file(vma->vm_file) ||
+				    (dmabuf && dmabuf != vma->vm_file)) {
 					ret = -EOPNOTSUPP;
 					break;
 				}
+				dmabuf = vma->vm_file;
 			}
+			if (!ret && dmabuf)
+				get_file(dmabuf);
 		} else {
 			ret = pret < 0 ? pret : -EFAULT;
 		}
@@ -3496,6 +3738,7 @@ static int io_sqe_buffer_register(struct io_ring_ctx *ctx, void __user *arg,
 		imu->ubuf = ubuf;
 		imu->len = iov.iov_len;
 		imu->nr_bvecs = nr_pages;
+		imu->dmabuf = dmabuf;
 
 		ctx->nr_user_bufs++;
 	}
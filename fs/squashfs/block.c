@@ -156,8 +156,8 @@ int squashfs_read_data(struct super_block *sb, u64 index, int length,
 	if (compressed) {
 		if (!msblk->stream)
 			goto read_failure;
-		length = squashfs_decompress(msblk, bh, b, offset, length,
-			output);
+		length = msblk->thread_ops->decompress(msblk, bh, b, offset,
+			length, output);
 		if (length < 0)
 			goto read_failure;
 	} else {
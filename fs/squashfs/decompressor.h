@@ -22,6 +22,30 @@ struct squashfs_decompressor {
 	int	supported;
 };
 
+struct squashfs_decompressor_thread_ops {
+	void * (*create)(struct squashfs_sb_info *msblk, void *comp_opts);
+	void (*destroy)(struct squashfs_sb_info *msblk);
+	int (*decompress)(struct squashfs_sb_info *msblk,
+			  struct buffer_head **bh, int b, int offset,
+			  int length, struct squashfs_page_actor *output);
+	int (*max_decompressors)(void);
+};
+
+#ifdef CONFIG_SQUASHFS_DECOMP_SINGLE
+extern const struct squashfs_decompressor_thread_ops
+	squashfs_decompressor_single;
+#endif
+
+#ifdef CONFIG_SQUASHFS_DECOMP_MULTI
+extern const struct squashfs_decompressor_thread_ops
+	squashfs_decompressor_multi;
+#endif
+
+#ifdef CONFIG_SQUASHFS_DECOMP_MULTI_PERCPU
+extern const struct squashfs_decompressor_thread_ops
+	squashfs_decompressor_percpu;
+#endif
+
 static inline void *squashfs_comp_opts(struct squashfs_sb_info *msblk,
 							void *buff, int length)
 {
@@ -34,6 +34,7 @@
 #include <linux/string.h>
 #include <linux/pagemap.h>
 #include <linux/mutex.h>
+#include <linux/workqueue.h>
 
 #include "squashfs_fs.h"
 #include "squashfs_fs_sb.h"
@@ -495,6 +496,65 @@ static int squashfs_readpage(struct file *file, struct page *page)
 }
 
 
+struct squashfs_read_work {
+	struct work_struct	work;
+	struct page		*page;
+};
+
+static void squashfs_read_work_fn(struct work_struct *work)
+{
+	struct squashfs_read_work *rw =
+		container_of(work, struct squashfs_read_work, work);
+
+	squashfs_readpage(NULL, rw->page);
+	put_page(rw->page);
+	kfree(rw);
+}
+
+/*
+ * Readahead only needs one page per Squashfs block in the page cache:
+ * reading it decompresses the whole block and fills in the other pages
+ * of the block.  Those pages are dropped here so the decompression of
+ * every block can be queued on the read workqueue and run in parallel,
+ * rather than one block after the other in the caller's context.
+ */
+static int squashfs_readpages(struct file *file, struct address_space *mapping,
+	struct list_head *pages, unsigned int nr_pages)
+{
+	struct squashfs_sb_info *msblk = mapping->host->i_sb->s_fs_info;
+	int shift = msblk->block_log - PAGE_SHIFT;
+	gfp_t gfp = readahead_gfp_mask(mapping);
+	pgoff_t last = ULONG_MAX;
+
+	while (!list_empty(pages)) {
+		struct page *page = lru_to_page(pages);
+		struct squashfs_read_work *rw = NULL;
+
+		list_del(&page->lru);
+		if ((page->index >> shift) == last ||
+		    add_to_page_cache_lru(page, mapping, page->index, gfp)) {
+			put_page(page);
+			continue;
+		}
+		last = page->index >> shift;
+
+		if (msblk->read_wq)
+			rw = kmalloc(sizeof(*rw), GFP_KERNEL | __GFP_NOWARN);
+		if (rw) {
+			INIT_WORK(&rw->work, squashfs_read_work_fn);
+			rw->page = page;
+			queue_work(msblk->read_wq, &rw->work);
+		} else {
+			squashfs_readpage(file, page);
+			put_page(page);
+		}
+	}
+
+	return 0;
+}
+
+
 const struct address_space_operations squashfs_aops = {
-	.readpage = squashfs_readpage
+	.readpage = squashfs_readpage,
+	.readpages = squashfs_readpages
 };
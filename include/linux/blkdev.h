@@ -483,6 +483,10 @@ struct request_queue {
 
 	unsigned int		rq_timeout;
 	int			poll_nsec;
+	/* adaptive hybrid polling: sleep target in % of the mean */
+	unsigned int		poll_hybrid_pct;
+	/* adaptive hybrid polling: average hrtimer wakeup lateness */
+	unsigned int		poll_wake_lat_ns;
 
 	struct blk_stat_callback	*poll_cb;
 	struct blk_rq_stat	poll_stat[BLK_MQ_POLL_STATS_BKTS];
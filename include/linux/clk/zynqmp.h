@@ -0,0 +1,41 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Zynq UltraScale+ MPSoC clocks, direct divider control
+ *
+ * Copyright (C) 2020 Xilinx
+ */
+
+#ifndef __LINUX_CLK_XLNX_ZYNQMP_H_
+#define __LINUX_CLK_XLNX_ZYNQMP_H_
+
+#include <linux/err.h>
+#include <linux/types.h>
+
+struct clk;
+struct clk_hw;
+
+#ifdef CONFIG_COMMON_CLK_ZYNQMP
+struct clk_hw *zynqmp_clk_get_divider(struct clk *clk);
+unsigned long zynqmp_clk_divider_round_fast(struct clk_hw *hw,
+					    unsigned long rate, u32 *div);
+int zynqmp_clk_divider_set_fast(struct clk_hw *hw, u32 div);
+#else
+static inline struct clk_hw *zynqmp_clk_get_divider(struct clk *clk)
+{
+	return ERR_PTR(-ENODEV);
+}
+
+static inline unsigned long zynqmp_clk_divider_round_fast(struct clk_hw *hw,
+							  unsigned long rate,
+							  u32 *div)
+{
+	return 0;
+}
+
+static inline int zynqmp_clk_divider_set_fast(struct clk_hw *hw, u32 div)
+{
+	return -ENODEV;
+}
+#endif
+
+#endif
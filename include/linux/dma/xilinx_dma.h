@@ -39,7 +39,31 @@ struct xilinx_vdma_config {
 	bool vflip_en;
 };
 
+/**
+ * struct xilinx_mcdma_config - MCDMA channel scheduling configuration
+ * @weight: MM2S weighted round robin weight, 0 to 15
+ */
+struct xilinx_mcdma_config {
+	u8 weight;
+};
+
+/**
+ * enum xilinx_dma_poll_mode - Descriptor completion mode
+ * @XILINX_DMA_POLL_NONE: Complete from the interrupt and the tasklet
+ * @XILINX_DMA_POLL_ONLY: Complete from dmaengine_tx_status() only
+ * @XILINX_DMA_POLL_HYBRID: Interrupt, then poll while transfers complete
+ */
+enum xilinx_dma_poll_mode {
+	XILINX_DMA_POLL_NONE = 0,
+	XILINX_DMA_POLL_ONLY,
+	XILINX_DMA_POLL_HYBRID,
+};
+
 int xilinx_vdma_channel_set_config(struct dma_chan *dchan,
 					struct xilinx_vdma_config *cfg);
+int xilinx_dma_channel_set_poll_mode(struct dma_chan *dchan,
+				     enum xilinx_dma_poll_mode mode);
+int xilinx_mcdma_channel_set_config(struct dma_chan *dchan,
+				    struct xilinx_mcdma_config *cfg);
 
 #endif
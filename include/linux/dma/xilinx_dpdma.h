@@ -0,0 +1,25 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Xilinx ZynqMP DPDMA support header file
+ *
+ * Copyright (C) 2017 Xilinx, Inc. All rights reserved.
+ */
+
+#ifndef __XILINX_DPDMA_H
+#define __XILINX_DPDMA_H
+
+#include <linux/dma-fence.h>
+#include <linux/dmaengine.h>
+#include <linux/err.h>
+
+#if IS_ENABLED(CONFIG_XILINX_DPDMA)
+struct dma_fence *xilinx_dpdma_get_fence(struct dma_async_tx_descriptor *tx);
+#else
+static inline struct dma_fence *
+xilinx_dpdma_get_fence(struct dma_async_tx_descriptor *tx)
+{
+	return ERR_PTR(-ENODEV);
+}
+#endif
+
+#endif /* __XILINX_DPDMA_H */
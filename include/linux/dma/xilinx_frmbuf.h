@@ -12,6 +12,7 @@
 #ifndef __XILINX_FRMBUF_DMA_H
 #define __XILINX_FRMBUF_DMA_H
 
+#include <linux/dma-fence.h>
 #include <linux/dmaengine.h>
 
 /* Modes to enable early callback */
@@ -92,6 +93,19 @@ void xilinx_xdma_v4l2_config(struct dma_chan *chan, u32 v4l2_fourcc);
 int xilinx_xdma_get_drm_vid_fmts(struct dma_chan *chan, u32 *fmt_cnt,
 				 u32 **fmts);
 
+/**
+ * xilinx_xdma_get_drm_vid_fmt_modifiers - obtain list of supported DRM format
+ * modifiers
+ * @chan: dma channel instance
+ * @modifiers: Output param - pointer to array of DRM format modifiers
+ * terminated by DRM_FORMAT_MOD_INVALID (not a copy)
+ *
+ * Return: 0 on success, or a negative error code if @chan isn't a Video
+ * Framebuffer channel
+ */
+int xilinx_xdma_get_drm_vid_fmt_modifiers(struct dma_chan *chan,
+					  const u64 **modifiers);
+
 /**
  * xilinx_xdma_get_v4l2_vid_fmts - obtain list of supported V4L2 mem formats
  * @chan: dma channel instance
@@ -153,6 +167,23 @@ int xilinx_xdma_get_earlycb(struct dma_chan *chan,
 int xilinx_xdma_set_earlycb(struct dma_chan *chan,
 			    struct dma_async_tx_descriptor *async_tx,
 			    u32 earlycb);
+
+/**
+ * xilinx_xdma_get_fence - Get the fence signalled when a frame is done
+ * @chan: dma channel instance
+ * @async_tx: dma async tx descriptor for the buffer
+ *
+ * The fence is signalled from the interrupt handler as soon as the frame
+ * is done, before the descriptor callback runs. It is signalled with
+ * -ECANCELED if the channel is terminated first. Fences of a channel
+ * share one context and signal in submission order, so this must be
+ * called after dmaengine_submit(). The caller owns the returned reference.
+ *
+ * Return: The fence on success, an ERR_PTR() in case of invalid chan
+ */
+struct dma_fence *
+xilinx_xdma_get_fence(struct dma_chan *chan,
+		      struct dma_async_tx_descriptor *async_tx);
 #else
 static inline void xilinx_xdma_set_mode(struct dma_chan *chan,
 					enum operation_mode mode)
@@ -171,6 +202,13 @@ static inline int xilinx_xdma_get_drm_vid_fmts(struct dma_chan *chan,
 	return -ENODEV;
 }
 
+static inline int
+xilinx_xdma_get_drm_vid_fmt_modifiers(struct dma_chan *chan,
+				      const u64 **modifiers)
+{
+	return -ENODEV;
+}
+
 static inline int xilinx_xdma_get_v4l2_vid_fmts(struct dma_chan *chan,
 						u32 *fmt_cnt,u32 **fmts)
 {
@@ -204,6 +242,13 @@ static inline int xilinx_xdma_set_earlycb(struct dma_chan *chan,
 {
 	return -ENODEV;
 }
+
+static inline struct dma_fence *
+xilinx_xdma_get_fence(struct dma_chan *chan,
+		      struct dma_async_tx_descriptor *atx)
+{
+	return ERR_PTR(-ENODEV);
+}
 #endif
 
 #endif /*__XILINX_FRMBUF_DMA_H*/
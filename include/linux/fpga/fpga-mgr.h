@@ -132,6 +132,7 @@ struct fpga_image_info {
  * @write_sg: write the scatter list of configuration data to the FPGA
  * @write_complete: set FPGA to operating state after writing is done
  * @read: optional: read FPGA configuration information
+ * @read_size: optional: returns the number of bytes @read outputs, 0 if unknown
  * @fpga_remove: optional: Set FPGA into a specific state during driver remove
  * @groups: optional attribute groups.
  *
@@ -151,6 +152,7 @@ struct fpga_manager_ops {
 	int (*write_complete)(struct fpga_manager *mgr,
 			      struct fpga_image_info *info);
 	int (*read)(struct fpga_manager *mgr, struct seq_file *s);
+	size_t (*read_size)(struct fpga_manager *mgr);
 	void (*fpga_remove)(struct fpga_manager *mgr);
 	const struct attribute_group **groups;
 };
@@ -190,6 +192,8 @@ struct fpga_compat_id {
  * @compat_id: FPGA manager id for compatibility check.
  * @mops: pointer to struct of fpga manager ops
  * @priv: low level driver private date
+ * @images: images staged in memory by fpga_mgr_image_cache()
+ * @images_lock: protects @images
  * @dir: debugfs image directory
  */
 struct fpga_manager {
@@ -204,6 +208,8 @@ struct fpga_manager {
 	struct fpga_compat_id *compat_id;
 	const struct fpga_manager_ops *mops;
 	void *priv;
+	struct list_head images;
+	struct mutex images_lock;
 #ifdef CONFIG_FPGA_MGR_DEBUG_FS
 	struct dentry *dir;
 #endif
@@ -217,6 +223,9 @@ void fpga_image_info_free(struct fpga_image_info *info);
 
 int fpga_mgr_load(struct fpga_manager *mgr, struct fpga_image_info *info);
 
+int fpga_mgr_image_cache(struct fpga_manager *mgr, const char *image_name);
+int fpga_mgr_image_uncache(struct fpga_manager *mgr, const char *image_name);
+
 int fpga_mgr_lock(struct fpga_manager *mgr);
 void fpga_mgr_unlock(struct fpga_manager *mgr);
 
@@ -3,7 +3,9 @@
 #ifndef _FPGA_REGION_H
 #define _FPGA_REGION_H
 
+#include <linux/atomic.h>
 #include <linux/device.h>
+#include <linux/workqueue.h>
 #include <linux/fpga/fpga-mgr.h>
 #include <linux/fpga/fpga-bridge.h>
 
@@ -17,6 +19,10 @@
  * @compat_id: FPGA region id for compatibility check.
  * @priv: private data
  * @get_bridges: optional function to get bridges to a list
+ * @program_work: work programming the region asynchronously
+ * @program_complete: completion callback of the asynchronous programming
+ * @program_data: data passed to @program_complete
+ * @programming: non-zero while an asynchronous programming is pending
  */
 struct fpga_region {
 	struct device dev;
@@ -27,6 +33,11 @@ struct fpga_region {
 	struct fpga_compat_id *compat_id;
 	void *priv;
 	int (*get_bridges)(struct fpga_region *region);
+	struct work_struct program_work;
+	void (*program_complete)(struct fpga_region *region, int ret,
+				 void *data);
+	void *program_data;
+	atomic_t programming;
 };
 
 #define to_fpga_region(d) container_of(d, struct fpga_region, dev)
@@ -36,6 +47,10 @@ struct fpga_region *fpga_region_class_find(
 	int (*match)(struct device *, const void *));
 
 int fpga_region_program_fpga(struct fpga_region *region);
+int fpga_region_program_fpga_async(struct fpga_region *region,
+				   void (*complete)(struct fpga_region *region,
+						    int ret, void *data),
+				   void *data);
 
 struct fpga_region
 *fpga_region_create(struct device *dev, struct fpga_manager *mgr,
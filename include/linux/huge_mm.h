@@ -7,6 +7,17 @@
 
 #include <linux/fs.h> /* only for vma_is_dax() */
 
+/*
+ * Huge entries of DAX and of file backed VM_PFNMAP/VM_MIXEDMAP mappings
+ * (vmf_insert_pfn_pmd() from a driver's huge_fault) have no THP behind
+ * them: they are zapped or split by just clearing the entry.
+ */
+static inline bool vma_is_special_huge(const struct vm_area_struct *vma)
+{
+	return vma_is_dax(vma) || (vma->vm_file &&
+				   (vma->vm_flags & (VM_PFNMAP | VM_MIXEDMAP)));
+}
+
 extern vm_fault_t do_huge_pmd_anonymous_page(struct vm_fault *vmf);
 extern int copy_huge_pmd(struct mm_struct *dst_mm, struct mm_struct *src_mm,
 			 pmd_t *dst_pmd, pmd_t *src_pmd, unsigned long addr,
@@ -0,0 +1,13 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _LINUX_IO_URING_H
+#define _LINUX_IO_URING_H
+
+/*
+ * Issue flags of file_operations->uring_cmd(). With IO_URING_F_NONBLOCK
+ * the command is issued from the submitting context and must not block,
+ * return -EAGAIN to have it issued again without the flag from an async
+ * worker.
+ */
+#define IO_URING_F_NONBLOCK	(1U << 0)
+
+#endif
@@ -486,6 +486,8 @@ struct rproc_dump_segment {
  * @dump_segments: list of segments in the firmware
  * @nb_vdev: number of vdev currently handled by rproc
  * @sysfs_kick: allow kick remoteproc from sysfs
+ * @warm_restart: flag to keep the firmware image in memory for recovery
+ * @warm_fw: firmware image kept since boot, used to recover the rproc
  */
 struct rproc {
 	struct list_head node;
@@ -520,6 +522,8 @@ struct rproc {
 	struct list_head dump_segments;
 	int nb_vdev;
 	int sysfs_kick;
+	bool warm_restart;
+	const struct firmware *warm_fw;
 };
 
 /**
@@ -518,7 +518,10 @@ struct skb_shared_info {
 	struct sk_buff	*frag_list;
 	struct skb_shared_hwtstamps hwtstamps;
 	unsigned int	gso_type;
-	u32		tskey;
+	union {
+		u32	tskey;
+		u32	xdp_frags_size;	/* only used while in an xdp_buff */
+	};
 
 	/*
 	 * Warning : all fields before dataref are cleared in __alloc_skb()
@@ -77,6 +77,8 @@ struct uio_device {
 	struct mutex		info_lock;
         struct kobject          *map_dir;
         struct kobject          *portio_dir;
+	struct list_head	irqfds;
+	spinlock_t		irqfd_lock;
 };
 
 /**
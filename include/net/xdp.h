@@ -6,6 +6,8 @@
 #ifndef __LINUX_NET_XDP_H__
 #define __LINUX_NET_XDP_H__
 
+#include <linux/skbuff.h> /* skb_shared_info */
+
 /**
  * DOC: XDP RX-queue information
  *
@@ -61,8 +63,30 @@ struct xdp_rxq_info {
 	u32 queue_index;
 	u32 reg_state;
 	struct xdp_mem_info mem;
+	u32 frag_size; /* non-zero if the queue builds multi-buffer frames */
 } ____cacheline_aligned; /* perf critical, avoid false-sharing */
 
+enum xdp_buff_flags {
+	XDP_FLAGS_HAS_FRAGS		= BIT(0), /* non-linear xdp buff */
+};
+
+/**
+ * DOC: XDP multi-buffer
+ *
+ * A frame that does not fit the buffer of a single Rx descriptor, e.g. a
+ * jumbo frame, is described by an xdp_buff for its first buffer plus a
+ * skb_shared_info placed in the tailroom of that first buffer, at
+ * xdp_data_hard_end().  The remaining buffers are attached there as
+ * fragments, in the same layout build_skb() expects, so the skb built on
+ * XDP_PASS inherits them without copying.
+ *
+ * Only a queue registered with a non-zero fragment size can produce such
+ * frames, and such a driver must initialise its buffers with
+ * xdp_init_buff().  The flags of the buffers of any other queue are never
+ * looked at.  A program only sees the first buffer between data and
+ * data_end and must be loaded with BPF_F_XDP_HAS_FRAGS to be attached to a
+ * device whose MTU needs more than one buffer.
+ */
 struct xdp_buff {
 	void *data;
 	void *data_end;
@@ -70,13 +94,77 @@ struct xdp_buff {
 	void *data_hard_start;
 	unsigned long handle;
 	struct xdp_rxq_info *rxq;
+	u32 frame_sz; /* frame size to deduce data_hard_end/reserved tailroom */
+	u32 flags; /* supported values defined in xdp_buff_flags */
 };
 
+static __always_inline bool xdp_buff_has_frags(struct xdp_buff *xdp)
+{
+	return unlikely(xdp->rxq->frag_size &&
+			(xdp->flags & XDP_FLAGS_HAS_FRAGS));
+}
+
+static __always_inline void xdp_buff_set_frags_flag(struct xdp_buff *xdp)
+{
+	xdp->flags |= XDP_FLAGS_HAS_FRAGS;
+}
+
+static __always_inline void xdp_buff_clear_frags_flag(struct xdp_buff *xdp)
+{
+	xdp->flags &= ~XDP_FLAGS_HAS_FRAGS;
+}
+
+static __always_inline void
+xdp_init_buff(struct xdp_buff *xdp, u32 frame_sz, struct xdp_rxq_info *rxq)
+{
+	xdp->frame_sz = frame_sz;
+	xdp->rxq = rxq;
+	xdp->flags = 0;
+}
+
+/* Reserve memory area at end-of data area.
+ *
+ * This macro reserves tailroom in the XDP buffer by limiting the
+ * XDP/BPF data access to data_hard_end.  Notice same area (and size)
+ * is used for XDP_PASS, when constructing the SKB via build_skb().
+ */
+#define xdp_data_hard_end(xdp)				\
+	((xdp)->data_hard_start + (xdp)->frame_sz -	\
+	 SKB_DATA_ALIGN(sizeof(struct skb_shared_info)))
+
+static inline struct skb_shared_info *
+xdp_get_shared_info_from_buff(struct xdp_buff *xdp)
+{
+	return (struct skb_shared_info *)xdp_data_hard_end(xdp);
+}
+
+/**
+ * xdp_get_buff_len - Get the length of a possibly multi-buffer frame
+ * @xdp: XDP buffer of the frame
+ *
+ * Return: length of the first buffer plus that of all the fragments
+ */
+static __always_inline unsigned int xdp_get_buff_len(struct xdp_buff *xdp)
+{
+	unsigned int len = xdp->data_end - xdp->data;
+	struct skb_shared_info *sinfo;
+
+	if (likely(!xdp_buff_has_frags(xdp)))
+		goto out;
+
+	sinfo = xdp_get_shared_info_from_buff(xdp);
+	len += sinfo->xdp_frags_size;
+out:
+	return len;
+}
+
 struct xdp_frame {
 	void *data;
 	u16 len;
 	u16 headroom;
 	u16 metasize;
+	u32 frame_sz;
+	u32 flags; /* supported values defined in xdp_buff_flags */
 	/* Lifetime of xdp_rxq_info is limited to NAPI/enqueue time,
 	 * while mem info is valid on remote CPU.
 	 */
@@ -84,6 +172,45 @@ struct xdp_frame {
 	struct net_device *dev_rx; /* used by cpumap */
 };
 
+static __always_inline bool xdp_frame_has_frags(struct xdp_frame *frame)
+{
+	return unlikely(frame->flags & XDP_FLAGS_HAS_FRAGS);
+}
+
+static inline struct skb_shared_info *
+xdp_get_shared_info_from_frame(struct xdp_frame *frame)
+{
+	void *data_hard_start = frame->data - frame->headroom - sizeof(*frame);
+
+	return (struct skb_shared_info *)(data_hard_start + frame->frame_sz -
+				SKB_DATA_ALIGN(sizeof(struct skb_shared_info)));
+}
+
+/**
+ * xdp_update_skb_shared_info - Account the fragments of an XDP frame in a skb
+ * @skb: skb built with build_skb() over the first buffer of the frame
+ * @nr_frags: number of fragments
+ * @size: total length of the fragments
+ * @truesize: total memory used by the fragments
+ * @pfmemalloc: whether any fragment came from the pfmemalloc reserves
+ *
+ * The fragments are already in place in skb_shinfo(@skb), build_skb() only
+ * cleared their count, so the caller reads @nr_frags and @size from the
+ * XDP buffer before building the skb.
+ */
+static inline void xdp_update_skb_shared_info(struct sk_buff *skb, u8 nr_frags,
+					      unsigned int size,
+					      unsigned int truesize,
+					      bool pfmemalloc)
+{
+	skb_shinfo(skb)->nr_frags = nr_frags;
+
+	skb->len += size;
+	skb->data_len += size;
+	skb->truesize += truesize;
+	skb->pfmemalloc |= pfmemalloc;
+}
+
 /* Clear kernel pointers in xdp_frame */
 static inline void xdp_scrub_frame(struct xdp_frame *frame)
 {
@@ -118,6 +245,8 @@ struct xdp_frame *convert_to_xdp_frame(struct xdp_buff *xdp)
 	xdp_frame->len  = xdp->data_end - xdp->data;
 	xdp_frame->headroom = headroom - sizeof(*xdp_frame);
 	xdp_frame->metasize = metasize;
+	xdp_frame->frame_sz = xdp->frame_sz;
+	xdp_frame->flags = xdp_buff_has_frags(xdp) ? XDP_FLAGS_HAS_FRAGS : 0;
 
 	/* rxq only valid until napi_schedule ends, convert to xdp_mem_info */
 	xdp_frame->mem = xdp->rxq->mem;
@@ -144,8 +273,13 @@ static inline void xdp_release_frame(struct xdp_frame *xdpf)
 		__xdp_release_frame(xdpf->data, mem);
 }
 
-int xdp_rxq_info_reg(struct xdp_rxq_info *xdp_rxq,
-		     struct net_device *dev, u32 queue_index);
+int __xdp_rxq_info_reg(struct xdp_rxq_info *xdp_rxq,
+		       struct net_device *dev, u32 queue_index, u32 frag_size);
+static inline int xdp_rxq_info_reg(struct xdp_rxq_info *xdp_rxq,
+				   struct net_device *dev, u32 queue_index)
+{
+	return __xdp_rxq_info_reg(xdp_rxq, dev, queue_index, 0);
+}
 void xdp_rxq_info_unreg(struct xdp_rxq_info *xdp_rxq);
 void xdp_rxq_info_unused(struct xdp_rxq_info *xdp_rxq);
 bool xdp_rxq_info_is_reg(struct xdp_rxq_info *xdp_rxq);
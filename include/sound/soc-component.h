@@ -381,6 +381,10 @@ struct page *snd_soc_pcm_component_page(struct snd_pcm_substream *substream,
 					unsigned long offset);
 int snd_soc_pcm_component_mmap(struct snd_pcm_substream *substream,
 			       struct vm_area_struct *vma);
+int snd_soc_pcm_component_get_time_info(struct snd_pcm_substream *substream,
+		struct timespec *system_ts, struct timespec *audio_ts,
+		struct snd_pcm_audio_tstamp_config *audio_tstamp_config,
+		struct snd_pcm_audio_tstamp_report *audio_tstamp_report);
 int snd_soc_pcm_component_new(struct snd_pcm *pcm);
 void snd_soc_pcm_component_free(struct snd_pcm *pcm);
 
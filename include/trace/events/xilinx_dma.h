@@ -0,0 +1,106 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Tracepoints of the Xilinx DMA engines
+ *
+ * A descriptor goes through submit, start (handed to the hardware), complete
+ * (reaped from the hardware) and callback. The irq and cleanup events mark
+ * the entry of the interrupt handler and of the cleanup tasklet or thread.
+ * The cookie ties the events of one descriptor together, the channel name
+ * the ones of one channel.
+ */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM xilinx_dma
+
+#if !defined(_TRACE_XILINX_DMA_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_XILINX_DMA_H
+
+#include <linux/dmaengine.h>
+#include <linux/tracepoint.h>
+
+DECLARE_EVENT_CLASS(xilinx_dma_desc,
+
+	TP_PROTO(struct dma_chan *chan, dma_cookie_t cookie),
+
+	TP_ARGS(chan, cookie),
+
+	TP_STRUCT__entry(
+		__string(chan, dma_chan_name(chan))
+		__field(dma_cookie_t, cookie)
+	),
+
+	TP_fast_assign(
+		__assign_str(chan, dma_chan_name(chan))
+		__entry->cookie = cookie;
+	),
+
+	TP_printk("chan=%s cookie=%d", __get_str(chan), __entry->cookie)
+);
+
+DEFINE_EVENT(xilinx_dma_desc, xilinx_dma_submit,
+
+	TP_PROTO(struct dma_chan *chan, dma_cookie_t cookie),
+
+	TP_ARGS(chan, cookie)
+);
+
+DEFINE_EVENT(xilinx_dma_desc, xilinx_dma_start,
+
+	TP_PROTO(struct dma_chan *chan, dma_cookie_t cookie),
+
+	TP_ARGS(chan, cookie)
+);
+
+DEFINE_EVENT(xilinx_dma_desc, xilinx_dma_complete,
+
+	TP_PROTO(struct dma_chan *chan, dma_cookie_t cookie),
+
+	TP_ARGS(chan, cookie)
+);
+
+DEFINE_EVENT(xilinx_dma_desc, xilinx_dma_callback,
+
+	TP_PROTO(struct dma_chan *chan, dma_cookie_t cookie),
+
+	TP_ARGS(chan, cookie)
+);
+
+TRACE_EVENT(xilinx_dma_irq,
+
+	TP_PROTO(struct dma_chan *chan, u32 status),
+
+	TP_ARGS(chan, status),
+
+	TP_STRUCT__entry(
+		__string(chan, dma_chan_name(chan))
+		__field(u32, status)
+	),
+
+	TP_fast_assign(
+		__assign_str(chan, dma_chan_name(chan))
+		__entry->status = status;
+	),
+
+	TP_printk("chan=%s status=0x%08x", __get_str(chan), __entry->status)
+);
+
+TRACE_EVENT(xilinx_dma_cleanup,
+
+	TP_PROTO(struct dma_chan *chan),
+
+	TP_ARGS(chan),
+
+	TP_STRUCT__entry(
+		__string(chan, dma_chan_name(chan))
+	),
+
+	TP_fast_assign(
+		__assign_str(chan, dma_chan_name(chan))
+	),
+
+	TP_printk("chan=%s", __get_str(chan))
+);
+
+#endif /* _TRACE_XILINX_DMA_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
@@ -21,7 +21,35 @@ struct rpmsg_endpoint_info {
 	__u32 dst;
 };
 
+/**
+ * struct rpmsg_msg_vec - message buffer of a batch
+ * @buf: user buffer of the message
+ * @len: size of @buf, updated with the length of the received message
+ * @reserved: must be zero
+ */
+struct rpmsg_msg_vec {
+	__u64 buf;
+	__u32 len;
+	__u32 reserved;
+};
+
+/**
+ * struct rpmsg_batch - batch of messages to send or receive
+ * @msgs: user pointer to an array of struct rpmsg_msg_vec
+ * @count: number of entries in @msgs, updated with the number of messages
+ *	   transferred
+ * @flags: must be zero
+ */
+struct rpmsg_batch {
+	__u64 msgs;
+	__u32 count;
+	__u32 flags;
+};
+
 #define RPMSG_CREATE_EPT_IOCTL	_IOW(0xb5, 0x1, struct rpmsg_endpoint_info)
 #define RPMSG_DESTROY_EPT_IOCTL	_IO(0xb5, 0x2)
+#define RPMSG_RECV_BATCH_IOCTL	_IOWR(0xb5, 0x3, struct rpmsg_batch)
+#define RPMSG_SEND_BATCH_IOCTL	_IOWR(0xb5, 0x4, struct rpmsg_batch)
+#define RPMSG_SET_RX_BATCH_IOCTL	_IOW(0xb5, 0x5, __u32)
 
 #endif
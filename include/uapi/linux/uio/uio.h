@@ -62,4 +62,17 @@ struct uio_dmabuf_args {
  */
 #define	UIO_IOC_UNMAP_DMABUF	_IOWR(UIO_IOC_BASE, 0x2, struct uio_dmabuf_args)
 
+/**
+ * DOC: UIO_IOC_IRQ_EVENTFD - Signal interrupts through an eventfd
+ *
+ * This takes a __s32 eventfd, which is signalled on every interrupt of the
+ * device instead of waking up the readers of the device file only. Interrupts
+ * raised before the eventfd is read are coalesced into its counter, so one
+ * read returns the number of interrupts since the last one. Pass -1 to stop
+ * signalling the eventfd. The eventfd is released with the device file.
+ * FIXME: This is experimental and may change at any time. Don't consider this
+ * as stable ABI.
+ */
+#define	UIO_IOC_IRQ_EVENTFD	_IOW(UIO_IOC_BASE, 0x3, __s32)
+
 #endif
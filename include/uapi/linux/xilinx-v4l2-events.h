@@ -18,6 +18,13 @@
  * Events
  *
  * V4L2_EVENT_XLNXSCD: Scene Change Detection
+ *
+ * The event data carries one result per processed frame as an array of
+ * 32-bit words:
+ *
+ * - word 0: 1 if a scene change was detected, 0 otherwise
+ * - word 1: the normalized SAD the decision was made on, compared to the
+ *   V4L2_CID_XILINX_SCD_THRESHOLD control
  */
 #define V4L2_EVENT_XLNXSCD_CLASS	(V4L2_EVENT_PRIVATE_START | 0x300)
 #define V4L2_EVENT_XLNXSCD		(V4L2_EVENT_XLNXSCD_CLASS | 0x1)
@@ -15,6 +15,8 @@
 
 enum aie_reg_op {
 	AIE_REG_WRITE,
+	AIE_REG_READ,
+	AIE_REG_POLL,
 };
 
 /* AI engine partition is in use */
@@ -77,9 +79,10 @@ struct aie_mem_args {
 /**
  * struct aie_reg_args - AIE access register arguments
  * @op: if this request is to read, write or poll register
- * @mask: mask for mask write, 0 for not mask write
+ * @mask: mask for mask write, 0 for not mask write. For poll, bits of the
+ *	  register to compare with @val, 0 to compare all bits.
  * @offset: offset of register to the start of an AI engine partition
- * @val: value to write or get
+ * @val: value to write, value read, or value to poll for
  */
 struct aie_reg_args {
 	enum aie_reg_op op;
@@ -88,6 +91,30 @@ struct aie_reg_args {
 	__u32 val;
 };
 
+/**
+ * struct aie_reg_cmdbuf - AIE register access command buffer
+ * @cmds: array of register access requests, executed in order. The @val of
+ *	  AIE_REG_READ requests is updated with the value read.
+ * @num_cmds: number of requests in @cmds
+ * @poll_timeout_us: timeout of each AIE_REG_POLL request in microseconds,
+ *		     0 for the driver default
+ */
+struct aie_reg_cmdbuf {
+	struct aie_reg_args *cmds;
+	__u32 num_cmds;
+	__u32 poll_timeout_us;
+};
+
+/**
+ * struct aie_pdi_args - AIE PDI load arguments
+ * @pdi: buffer holding the PDI image
+ * @size: size of the PDI image in bytes
+ */
+struct aie_pdi_args {
+	__u8 *pdi;
+	__u32 size;
+};
+
 /**
  * struct aie_range_args - AIE range request arguments
  * @partition_id: partition id. It is used to identify the
@@ -160,6 +187,124 @@ struct aie_dmabuf_bd_args {
 	__u32 bd_id;
 };
 
+/* Chain the last buffer of a SHIM DMA ring back to the first one */
+#define AIE_DMA_RING_CYCLIC	(1U << 0)
+
+/* mmap() offset of the partition error status page */
+#define AIE_ERROR_STATUS_MMAP_OFFSET	0x80000000U
+
+/**
+ * struct aie_error_status - AIE partition aggregated error counters
+ * @seqno: incremented after each update of the counters
+ * @num_backtracks: number of error interrupts backtracking runs
+ * @num_core_errors: number of core module errors asserted
+ * @num_mem_errors: number of memory module errors asserted
+ * @num_shim_errors: number of shim tile errors asserted
+ *
+ * The counters are cumulative since the partition was requested. They are
+ * read from the page mmapped at AIE_ERROR_STATUS_MMAP_OFFSET of the
+ * partition fd, without a system call.
+ */
+struct aie_error_status {
+	__u32 seqno;
+	__u32 num_backtracks;
+	__u32 num_core_errors;
+	__u32 num_mem_errors;
+	__u32 num_shim_errors;
+};
+
+/* Performance counter modules */
+#define AIE_PERFCNT_MOD_MEM	0U
+#define AIE_PERFCNT_MOD_CORE	1U
+#define AIE_PERFCNT_MOD_PL	2U
+
+/**
+ * struct aie_perfcnt_args - AIE performance counter information
+ * @loc: tile location relative to the start of a partition
+ * @module: module of the counter, AIE_PERFCNT_MOD_*
+ * @cnt: counter index within the module
+ * @start_event: event which starts the counter
+ * @stop_event: event which stops the counter
+ * @reset_event: event which resets the counter
+ * @reserved: reserved, must be 0
+ * @value: counter value, the initial value when setting the counter, and
+ *	   the current value when reading the counter
+ */
+struct aie_perfcnt_args {
+	struct aie_location loc;
+	__u32 module;
+	__u32 cnt;
+	__u8 start_event;
+	__u8 stop_event;
+	__u8 reset_event;
+	__u8 reserved;
+	__u32 value;
+};
+
+/**
+ * struct aie_perfcnt_array - AIE performance counters array
+ * @cnts: array of performance counters
+ * @num_cnts: number of performance counters
+ */
+struct aie_perfcnt_array {
+	struct aie_perfcnt_args *cnts;
+	__u32 num_cnts;
+};
+
+/**
+ * struct aie_dmabuf_ring_buf - AIE SHIM DMA ring buffer
+ * @off: offset of the buffer to the start of the dmabuf
+ * @buf_fd: dmabuf file descriptor, the dmabuf has to be attached to the
+ *	    partition
+ * @len: buffer length
+ * @lock_id: lock of the buffer descriptor, e.g. to ping-pong the buffers
+ * @reserved: reserved, must be 0
+ */
+struct aie_dmabuf_ring_buf {
+	__u64 off;
+	int buf_fd;
+	__u32 len;
+	__u32 lock_id;
+	__u32 reserved;
+};
+
+/**
+ * struct aie_dmabuf_ring_args - AIE SHIM DMA dmabuf ring information
+ * @bd: DMA buffer descriptor template used for all the buffers of the ring,
+ *	the address, length, lock ID and chaining fields are set by the driver
+ * @bufs: array of ring buffers
+ * @loc: SHIM tile location relative to the start of a partition
+ * @chan: DMA channel, 0 and 1 for the S2MM channels, 2 and 3 for the MM2S
+ *	  channels
+ * @bd_id: buffer descriptor ID of the first buffer, the ring buffers use
+ *	   the consecutive buffer descriptors starting from it
+ * @num_bufs: number of ring buffers, 0 to release the ring
+ * @flags: AIE_DMA_RING_* flags
+ */
+struct aie_dmabuf_ring_args {
+	__u32 *bd;
+	struct aie_dmabuf_ring_buf *bufs;
+	struct aie_location loc;
+	__u32 chan;
+	__u32 bd_id;
+	__u32 num_bufs;
+	__u32 flags;
+};
+
+/**
+ * struct aie_dma_eventfd_args - AIE SHIM DMA completion eventfd arguments
+ * @loc: SHIM tile location relative to the start of a partition
+ * @chan: DMA channel, 0 and 1 for the S2MM channels, 2 and 3 for the MM2S
+ *	  channels
+ * @fd: eventfd to signal when a buffer descriptor of the channel finishes,
+ *	negative value to stop the notifications
+ */
+struct aie_dma_eventfd_args {
+	struct aie_location loc;
+	__u32 chan;
+	int fd;
+};
+
 /**
  * struct aie_tiles_array - AIE tiles array
  * @locs: tiles locations array
@@ -258,4 +403,100 @@ struct aie_tiles_array {
 #define AIE_SET_SHIMDMA_DMABUF_BD_IOCTL	_IOW(AIE_IOCTL_BASE, 0x10, \
 					     struct aie_dmabuf_bd_args)
 
+/**
+ * DOC: AIE_REG_CMDBUF_IOCTL - execute a buffer of register access requests
+ *
+ * This ioctl is used to execute many register writes, mask writes, reads and
+ * polls with one call, e.g. to configure a graph. The requests are executed in
+ * order and the execution stops at the first failing request.
+ */
+#define AIE_REG_CMDBUF_IOCTL		_IOWR(AIE_IOCTL_BASE, 0x11, \
+					      struct aie_reg_cmdbuf)
+
+/**
+ * DOC: AIE_LOAD_PDI_IOCTL - load a PDI to the AI engine partition
+ *
+ * This ioctl is used to configure the AI engine partition with a PDI holding
+ * the configuration data objects (CDO) of the partition, e.g. the program
+ * memories and tiles configuration. The platform management firmware loads
+ * the PDI with DMA.
+ */
+#define AIE_LOAD_PDI_IOCTL		_IOW(AIE_IOCTL_BASE, 0x12, \
+					     struct aie_pdi_args)
+
+/**
+ * DOC: AIE_SET_SHIMDMA_EVENTFD_IOCTL - set SHIM DMA completion eventfd
+ *
+ * This ioctl is used to get notified through an eventfd when a buffer
+ * descriptor of a SHIM DMA channel finishes, instead of polling the DMA
+ * status registers. The eventfd counter is incremented for each finished
+ * buffer descriptor reported by the AI engine interrupt. It relies on the
+ * level 1 to level 2 interrupt routing set up by the application CDOs.
+ */
+#define AIE_SET_SHIMDMA_EVENTFD_IOCTL	_IOW(AIE_IOCTL_BASE, 0x13, \
+					     struct aie_dma_eventfd_args)
+
+/**
+ * DOC: AIE_SET_SHIMDMA_DMABUF_RING_IOCTL - set a ring of dmabuf buffers to a
+ *					    SHIM DMA channel
+ *
+ * This ioctl is used to program a batch of dmabuf buffers to a SHIM DMA
+ * channel with one call. The driver programs one buffer descriptor per
+ * buffer, chains them in order and starts the channel from the first one.
+ * With AIE_DMA_RING_CYCLIC, the last buffer descriptor is chained back to
+ * the first one, and the hardware keeps rotating the buffers, synchronized
+ * with the buffers locks, without further setup. The channel must be idle
+ * when the ring is set. The dmabufs are kept attached until the ring is
+ * released or replaced.
+ */
+#define AIE_SET_SHIMDMA_DMABUF_RING_IOCTL	_IOW(AIE_IOCTL_BASE, 0x14, \
+						struct aie_dmabuf_ring_args)
+
+/**
+ * DOC: AIE_SAVE_CONTEXT_IOCTL - save the AI engine partition context
+ *
+ * This ioctl is used to snapshot the memories and the configuration of the
+ * clock enabled tiles of the partition into a kernel buffer, to time share
+ * the partition between applications without reloading and reconfiguring
+ * it. It returns the ID of the saved context. The cores and the DMAs are
+ * expected to be stopped.
+ */
+#define AIE_SAVE_CONTEXT_IOCTL		_IOR(AIE_IOCTL_BASE, 0x15, __u32)
+
+/**
+ * DOC: AIE_RESTORE_CONTEXT_IOCTL - restore a saved AI engine partition
+ *				    context
+ *
+ * This ioctl is used to restore a context by its ID. The context is kept
+ * and can be restored again. The DMA channels and the cores have to be
+ * restarted after the context is restored.
+ */
+#define AIE_RESTORE_CONTEXT_IOCTL	_IOW(AIE_IOCTL_BASE, 0x16, __u32)
+
+/**
+ * DOC: AIE_FREE_CONTEXT_IOCTL - free a saved AI engine partition context
+ *
+ * This ioctl is used to free a saved context by its ID.
+ */
+#define AIE_FREE_CONTEXT_IOCTL		_IOW(AIE_IOCTL_BASE, 0x17, __u32)
+
+/**
+ * DOC: AIE_SET_PERFCNT_IOCTL - set an AI engine performance counter
+ *
+ * This ioctl is used to set the start, stop and reset events and the initial
+ * value of a performance counter of a tile module, e.g. to count the stall
+ * cycles of a core or the active cycles of a DMA channel.
+ */
+#define AIE_SET_PERFCNT_IOCTL		_IOW(AIE_IOCTL_BASE, 0x18, \
+					     struct aie_perfcnt_args)
+
+/**
+ * DOC: AIE_GET_PERFCNTS_IOCTL - read AI engine performance counters
+ *
+ * This ioctl is used to read the values of many performance counters with
+ * one call. The values are returned in the value field of each counter.
+ */
+#define AIE_GET_PERFCNTS_IOCTL		_IOW(AIE_IOCTL_BASE, 0x19, \
+					     struct aie_perfcnt_array)
+
 #endif
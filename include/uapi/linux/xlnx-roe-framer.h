@@ -0,0 +1,112 @@
+/* SPDX-License-Identifier: GPL-2.0 WITH Linux-syscall-note */
+/*
+ * Generic netlink interface of the Xilinx Radio over Ethernet framer.
+ */
+
+#ifndef __XLNX_ROE_FRAMER_H__
+#define __XLNX_ROE_FRAMER_H__
+
+#define XLNX_ROE_FRAMER_GENL_NAME	"xlnx_roe_framer"
+#define XLNX_ROE_FRAMER_GENL_VERSION	1
+
+/**
+ * enum xlnx_roe_framer_cmd - RoE framer generic netlink commands
+ * @XLNX_ROE_FRAMER_CMD_UNSPEC: Unused
+ * @XLNX_ROE_FRAMER_CMD_FLOW_SET: Program the packet headers of the flow of
+ *	an Ethernet port. Needs XLNX_ROE_FRAMER_A_PORT, the headers without an
+ *	attribute are left unchanged. All the attributes are validated before
+ *	any register is written.
+ * @XLNX_ROE_FRAMER_CMD_FLOW_GET: Get the packet headers of the flow of one
+ *	Ethernet port, or dump all of them
+ * @XLNX_ROE_FRAMER_CMD_STATS_GET: Get all the framer statistics counters
+ * @__XLNX_ROE_FRAMER_CMD_MAX: Number of commands
+ */
+enum xlnx_roe_framer_cmd {
+	XLNX_ROE_FRAMER_CMD_UNSPEC,
+	XLNX_ROE_FRAMER_CMD_FLOW_SET,
+	XLNX_ROE_FRAMER_CMD_FLOW_GET,
+	XLNX_ROE_FRAMER_CMD_STATS_GET,
+	__XLNX_ROE_FRAMER_CMD_MAX,
+};
+
+#define XLNX_ROE_FRAMER_CMD_MAX	(__XLNX_ROE_FRAMER_CMD_MAX - 1)
+
+/**
+ * enum xlnx_roe_framer_attr - RoE framer generic netlink attributes
+ * @XLNX_ROE_FRAMER_A_UNSPEC: Unused
+ * @XLNX_ROE_FRAMER_A_PORT: u8, Ethernet port of the flow
+ * @XLNX_ROE_FRAMER_A_ETH_DST_ADDR: binary, destination MAC address
+ * @XLNX_ROE_FRAMER_A_ETH_SRC_ADDR: binary, source MAC address
+ * @XLNX_ROE_FRAMER_A_VLAN_ID: u16, VLAN ID
+ * @XLNX_ROE_FRAMER_A_VLAN_DEI: u8, VLAN drop eligible indicator
+ * @XLNX_ROE_FRAMER_A_VLAN_PCP: u8, VLAN priority code point
+ * @XLNX_ROE_FRAMER_A_IPV4_SRC_ADDR: be32, IPv4 source address
+ * @XLNX_ROE_FRAMER_A_IPV4_DST_ADDR: be32, IPv4 destination address
+ * @XLNX_ROE_FRAMER_A_IPV4_DSCP: u8, IPv4 differentiated services code point
+ * @XLNX_ROE_FRAMER_A_IPV4_ECN: u8, IPv4 explicit congestion notification
+ * @XLNX_ROE_FRAMER_A_IPV4_TTL: u8, IPv4 time to live
+ * @XLNX_ROE_FRAMER_A_IPV6_SRC_ADDR: binary, IPv6 source address
+ * @XLNX_ROE_FRAMER_A_IPV6_DST_ADDR: binary, IPv6 destination address
+ * @XLNX_ROE_FRAMER_A_IPV6_TRAFFIC_CLASS: u8, IPv6 traffic class
+ * @XLNX_ROE_FRAMER_A_IPV6_FLOW_LABEL: u32, IPv6 flow label
+ * @XLNX_ROE_FRAMER_A_IPV6_HOP_LIMIT: u8, IPv6 hop limit
+ * @XLNX_ROE_FRAMER_A_UDP_SRC_PORT: u16, UDP source port
+ * @XLNX_ROE_FRAMER_A_UDP_DST_PORT: u16, UDP destination port
+ * @XLNX_ROE_FRAMER_A_RX_GOOD_PKT: u32, good packets received
+ * @XLNX_ROE_FRAMER_A_RX_BAD_PKT: u32, bad packets received
+ * @XLNX_ROE_FRAMER_A_RX_BAD_FCS: u32, packets received with a bad FCS
+ * @XLNX_ROE_FRAMER_A_RX_USER_PKT: u32, user data packets received
+ * @XLNX_ROE_FRAMER_A_RX_GOOD_USER_PKT: u32, good user data packets received
+ * @XLNX_ROE_FRAMER_A_RX_BAD_USER_PKT: u32, bad user data packets received
+ * @XLNX_ROE_FRAMER_A_RX_BAD_USER_FCS: u32, user data packets received with
+ *	a bad FCS
+ * @XLNX_ROE_FRAMER_A_RX_USER_CTRL_PKT: u32, user control packets received
+ * @XLNX_ROE_FRAMER_A_RX_GOOD_USER_CTRL_PKT: u32, good user control packets
+ *	received
+ * @XLNX_ROE_FRAMER_A_RX_BAD_USER_CTRL_PKT: u32, bad user control packets
+ *	received
+ * @XLNX_ROE_FRAMER_A_RX_BAD_USER_CTRL_FCS: u32, user control packets
+ *	received with a bad FCS
+ * @XLNX_ROE_FRAMER_A_RX_USER_PKT_RATE: u32, user data packet rate
+ * @XLNX_ROE_FRAMER_A_RX_USER_CTRL_PKT_RATE: u32, user control packet rate
+ * @__XLNX_ROE_FRAMER_A_MAX: Number of attributes
+ */
+enum xlnx_roe_framer_attr {
+	XLNX_ROE_FRAMER_A_UNSPEC,
+	XLNX_ROE_FRAMER_A_PORT,
+	XLNX_ROE_FRAMER_A_ETH_DST_ADDR,
+	XLNX_ROE_FRAMER_A_ETH_SRC_ADDR,
+	XLNX_ROE_FRAMER_A_VLAN_ID,
+	XLNX_ROE_FRAMER_A_VLAN_DEI,
+	XLNX_ROE_FRAMER_A_VLAN_PCP,
+	XLNX_ROE_FRAMER_A_IPV4_SRC_ADDR,
+	XLNX_ROE_FRAMER_A_IPV4_DST_ADDR,
+	XLNX_ROE_FRAMER_A_IPV4_DSCP,
+	XLNX_ROE_FRAMER_A_IPV4_ECN,
+	XLNX_ROE_FRAMER_A_IPV4_TTL,
+	XLNX_ROE_FRAMER_A_IPV6_SRC_ADDR,
+	XLNX_ROE_FRAMER_A_IPV6_DST_ADDR,
+	XLNX_ROE_FRAMER_A_IPV6_TRAFFIC_CLASS,
+	XLNX_ROE_FRAMER_A_IPV6_FLOW_LABEL,
+	XLNX_ROE_FRAMER_A_IPV6_HOP_LIMIT,
+	XLNX_ROE_FRAMER_A_UDP_SRC_PORT,
+	XLNX_ROE_FRAMER_A_UDP_DST_PORT,
+	XLNX_ROE_FRAMER_A_RX_GOOD_PKT,
+	XLNX_ROE_FRAMER_A_RX_BAD_PKT,
+	XLNX_ROE_FRAMER_A_RX_BAD_FCS,
+	XLNX_ROE_FRAMER_A_RX_USER_PKT,
+	XLNX_ROE_FRAMER_A_RX_GOOD_USER_PKT,
+	XLNX_ROE_FRAMER_A_RX_BAD_USER_PKT,
+	XLNX_ROE_FRAMER_A_RX_BAD_USER_FCS,
+	XLNX_ROE_FRAMER_A_RX_USER_CTRL_PKT,
+	XLNX_ROE_FRAMER_A_RX_GOOD_USER_CTRL_PKT,
+	XLNX_ROE_FRAMER_A_RX_BAD_USER_CTRL_PKT,
+	XLNX_ROE_FRAMER_A_RX_BAD_USER_CTRL_FCS,
+	XLNX_ROE_FRAMER_A_RX_USER_PKT_RATE,
+	XLNX_ROE_FRAMER_A_RX_USER_CTRL_PKT_RATE,
+	__XLNX_ROE_FRAMER_A_MAX,
+};
+
+#define XLNX_ROE_FRAMER_A_MAX	(__XLNX_ROE_FRAMER_A_MAX - 1)
+
+#endif /* __XLNX_ROE_FRAMER_H__ */
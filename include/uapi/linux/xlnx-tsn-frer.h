@@ -0,0 +1,96 @@
+/* SPDX-License-Identifier: GPL-2.0 WITH Linux-syscall-note */
+/*
+ * Generic netlink interface of the Xilinx TSN switch frame replication
+ * and elimination for reliability (IEEE 802.1CB) block.
+ */
+
+#ifndef __XLNX_TSN_FRER_H__
+#define __XLNX_TSN_FRER_H__
+
+#define XLNX_TSN_FRER_GENL_NAME		"xlnx_tsn_frer"
+#define XLNX_TSN_FRER_GENL_VERSION	1
+
+/**
+ * enum xlnx_tsn_frer_cmd - FRER generic netlink commands
+ * @XLNX_TSN_FRER_CMD_UNSPEC: Unused
+ * @XLNX_TSN_FRER_CMD_STREAM_SET: Program a stream handle. Needs
+ *	XLNX_TSN_FRER_A_HANDLE, the other configuration attributes default to
+ *	zero. With XLNX_TSN_FRER_A_DST_ADDR the stream is also identified in
+ *	the switch CAM.
+ * @XLNX_TSN_FRER_CMD_STREAM_DEL: Disable a stream handle
+ * @XLNX_TSN_FRER_CMD_STREAM_GET: Get the configuration and the sequence
+ *	recovery counters of one stream handle, or dump all of them
+ * @XLNX_TSN_FRER_CMD_STREAM_RESET: Reset the sequence recovery of a stream
+ *	handle
+ * @__XLNX_TSN_FRER_CMD_MAX: Number of commands
+ */
+enum xlnx_tsn_frer_cmd {
+	XLNX_TSN_FRER_CMD_UNSPEC,
+	XLNX_TSN_FRER_CMD_STREAM_SET,
+	XLNX_TSN_FRER_CMD_STREAM_DEL,
+	XLNX_TSN_FRER_CMD_STREAM_GET,
+	XLNX_TSN_FRER_CMD_STREAM_RESET,
+	__XLNX_TSN_FRER_CMD_MAX,
+};
+
+#define XLNX_TSN_FRER_CMD_MAX	(__XLNX_TSN_FRER_CMD_MAX - 1)
+
+/**
+ * enum xlnx_tsn_frer_attr - FRER generic netlink attributes
+ * @XLNX_TSN_FRER_A_UNSPEC: Unused
+ * @XLNX_TSN_FRER_A_HANDLE: u8, stream handle, the gate ID of the stream
+ * @XLNX_TSN_FRER_A_MEMBER: u8, member stream ID
+ * @XLNX_TSN_FRER_A_IN_PORT: u8, ingress port of the member stream
+ * @XLNX_TSN_FRER_A_MAX_SEQ_ID: u16, largest sequence number of the stream
+ * @XLNX_TSN_FRER_A_HIST_LEN: u8, sequence recovery history length
+ * @XLNX_TSN_FRER_A_RESET_TICKS: u32, sequence recovery reset timeout
+ * @XLNX_TSN_FRER_A_SPLIT_PORT: u8, egress port of the replicated stream
+ * @XLNX_TSN_FRER_A_SPLIT_VID: u16, VLAN ID of the replicated stream
+ * @XLNX_TSN_FRER_A_RECOVERY_TIMEOUT: flag, reset the sequence recovery
+ *	when XLNX_TSN_FRER_A_RESET_TICKS elapse without a frame
+ * @XLNX_TSN_FRER_A_DST_ADDR: binary, destination MAC address identifying
+ *	the stream
+ * @XLNX_TSN_FRER_A_VID: u16, VLAN ID identifying the stream
+ * @XLNX_TSN_FRER_A_PAD: Padding of the 64 bit counters
+ * @XLNX_TSN_FRER_A_CNT_FRAMES: u64, frames received
+ * @XLNX_TSN_FRER_A_CNT_DISC_IN_PORT: u64, frames discarded by the ingress
+ *	filter
+ * @XLNX_TSN_FRER_A_CNT_PASS_SEQ: u64, frames passed by sequence recovery
+ * @XLNX_TSN_FRER_A_CNT_DISC_SEQ: u64, duplicates discarded by sequence
+ *	recovery
+ * @XLNX_TSN_FRER_A_CNT_ROGUE_SEQ: u64, rogue frames seen by sequence
+ *	recovery
+ * @XLNX_TSN_FRER_A_CNT_PASS_IND: u64, frames passed by individual recovery
+ * @XLNX_TSN_FRER_A_CNT_DISC_IND: u64, frames discarded by individual
+ *	recovery
+ * @XLNX_TSN_FRER_A_CNT_SEQ_RESETS: u64, sequence recovery resets
+ * @__XLNX_TSN_FRER_A_MAX: Number of attributes
+ */
+enum xlnx_tsn_frer_attr {
+	XLNX_TSN_FRER_A_UNSPEC,
+	XLNX_TSN_FRER_A_HANDLE,
+	XLNX_TSN_FRER_A_MEMBER,
+	XLNX_TSN_FRER_A_IN_PORT,
+	XLNX_TSN_FRER_A_MAX_SEQ_ID,
+	XLNX_TSN_FRER_A_HIST_LEN,
+	XLNX_TSN_FRER_A_RESET_TICKS,
+	XLNX_TSN_FRER_A_SPLIT_PORT,
+	XLNX_TSN_FRER_A_SPLIT_VID,
+	XLNX_TSN_FRER_A_RECOVERY_TIMEOUT,
+	XLNX_TSN_FRER_A_DST_ADDR,
+	XLNX_TSN_FRER_A_VID,
+	XLNX_TSN_FRER_A_PAD,
+	XLNX_TSN_FRER_A_CNT_FRAMES,
+	XLNX_TSN_FRER_A_CNT_DISC_IN_PORT,
+	XLNX_TSN_FRER_A_CNT_PASS_SEQ,
+	XLNX_TSN_FRER_A_CNT_DISC_SEQ,
+	XLNX_TSN_FRER_A_CNT_ROGUE_SEQ,
+	XLNX_TSN_FRER_A_CNT_PASS_IND,
+	XLNX_TSN_FRER_A_CNT_DISC_IND,
+	XLNX_TSN_FRER_A_CNT_SEQ_RESETS,
+	__XLNX_TSN_FRER_A_MAX,
+};
+
+#define XLNX_TSN_FRER_A_MAX	(__XLNX_TSN_FRER_A_MAX - 1)
+
+#endif /* __XLNX_TSN_FRER_H__ */
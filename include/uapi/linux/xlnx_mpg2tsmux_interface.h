@@ -71,6 +71,17 @@ struct stream_context_in {
 	u64 pcr_base;
 };
 
+/**
+ * struct stream_context_batch - struct to enqueue stream context descriptors
+ * @num_strms: number of stream contexts in @strms, updated with the number of
+ *	       stream contexts enqueued
+ * @strms: user pointer to an array of struct stream_context_in
+ */
+struct stream_context_batch {
+	u32 num_strms;
+	u64 strms;
+};
+
 /**
  * struct mux_context_in - struct to enqueue a mux context descriptor
  * @is_dmabuf: flag to set if external src buffer is DMA allocated
@@ -249,4 +260,10 @@ struct xlnx_tsmux_dmabuf_info {
  */
 #define MPG2MUX_VDBUF _IOWR(MPG2MUX_MAGIC, 14, struct xlnx_tsmux_dmabuf_info *)
 
+/**
+ * MPG2MUX_SETSTRMS - enqueue a batch of stream descriptors with src buf
+ * address
+ */
+#define MPG2MUX_SETSTRMS _IOWR(MPG2MUX_MAGIC, 15, struct stream_context_batch *)
+
 #endif
@@ -0,0 +1,98 @@
+/* SPDX-License-Identifier: GPL-2.0+ WITH Linux-syscall-note */
+/*
+ * Xilinx HLS kernel job ring
+ *
+ * Copyright (C) 2020 Xilinx, Inc.
+ *
+ * Description:
+ * The driver runs an HLS kernel with an ap_ctrl_hs or ap_ctrl_chain block
+ * interface from a ring of jobs, each job being the values of the argument
+ * registers of the kernel. The ring is shared with user space by mmap() of
+ * the device: user space writes jobs and moves the tail, the driver starts
+ * them one after the other from the kernel interrupt and moves the head as
+ * they complete.
+ *
+ * While &struct xhls_ring.running is set, the driver picks the new jobs up
+ * without being told. User space only issues XHLS_KICK when it is clear,
+ * after moving the tail and with a full barrier in between:
+ *
+ *	write the job at args[(tail % XHLS_RING_JOBS) * num_args]
+ *	store-release tail + 1 to tail
+ *	full barrier
+ *	if (!running)
+ *		ioctl(fd, XHLS_KICK)
+ */
+#ifndef __XILINX_HLS_KERNEL_H__
+#define __XILINX_HLS_KERNEL_H__
+
+#include <linux/types.h>
+
+/* Jobs in the ring, the tail can't be more than this ahead of the head */
+#define XHLS_RING_JOBS	256
+
+/**
+ * struct xhls_ring - Job ring shared with the driver
+ * @tail: Jobs queued, free running, written by user space
+ * @head: Jobs completed, free running, written by the driver
+ * @running: Set by the driver while it picks new jobs up by itself
+ * @num_args: Argument registers of a job
+ * @args: The jobs, @num_args values each
+ */
+struct xhls_ring {
+	__u32 tail;
+	__u32 head;
+	__u32 running;
+	__u32 num_args;
+	__u32 args[];
+};
+
+/**
+ * struct xhls_info - Job ring information
+ * @num_args: Argument registers of a job
+ * @ring_jobs: Jobs in the ring
+ * @ring_size: Size of the ring to mmap()
+ */
+struct xhls_info {
+	__u32 num_args;
+	__u32 ring_jobs;
+	__u32 ring_size;
+};
+
+/*
+ * XHLS IOCTL List
+ */
+#define XHLS_MAGIC 'h'
+/**
+ * DOC: XHLS_KICK
+ *
+ * @Description
+ *
+ * ioctl to start the queued jobs when the driver is not running
+ */
+#define XHLS_KICK _IO(XHLS_MAGIC, 0)
+/**
+ * DOC: XHLS_WAIT
+ * @Parameters
+ *
+ * @__u32 *
+ *	Pointer to the job count to wait for
+ *
+ * @Description
+ *
+ * ioctl that waits until the head reaches the job count
+ */
+#define XHLS_WAIT _IOW(XHLS_MAGIC, 1, __u32)
+/**
+ * DOC: XHLS_GET_INFO
+ * @Parameters
+ *
+ * @struct xhls_info *
+ *	Pointer to the &struct xhls_info where the information is returned
+ *
+ * @Description
+ *
+ * ioctl that returns the layout of the job ring
+ */
+#define XHLS_GET_INFO _IOR(XHLS_MAGIC, 2, struct xhls_info)
+
+#endif /* __XILINX_HLS_KERNEL_H__ */
@@ -23,6 +23,8 @@
 #include <linux/sizes.h>
 #include <linux/dma-contiguous.h>
 #include <linux/cma.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
 
 #ifdef CONFIG_CMA_SIZE_MBYTES
 #define CMA_SIZE_MBYTES CONFIG_CMA_SIZE_MBYTES
@@ -214,6 +216,168 @@ bool dma_release_from_contiguous(struct device *dev, struct page *pages,
 	return cma_release(dev_get_cma_area(dev), pages, count);
 }
 
+#ifdef CONFIG_OF_RESERVED_MEM
+#define CMA_POOL_MAX_CLASSES	4
+
+/*
+ * A CMA area declared in the device tree with "linux,cma-pool-sizes" keeps
+ * up to @depth buffers of each size class allocated ahead of time, so that
+ * its devices do not wait for page migration when they start streaming.
+ * The pool is topped up in the background once a class drops below half
+ * of its depth.
+ */
+struct cma_pool_class {
+	size_t			count;
+	unsigned int		align;
+	unsigned int		nr_free;
+	struct list_head	free;
+};
+
+struct cma_pool {
+	struct cma		*cma;
+	spinlock_t		lock;
+	unsigned int		depth;
+	unsigned int		nr_classes;
+	struct cma_pool_class	classes[CMA_POOL_MAX_CLASSES];
+	struct work_struct	refill;
+};
+
+static struct cma_pool cma_pools[MAX_CMA_AREAS];
+static unsigned int cma_pool_count;
+
+static struct cma_pool *cma_pool_get(struct cma *cma)
+{
+	unsigned int i;
+
+	for (i = 0; i < cma_pool_count; i++)
+		if (cma_pools[i].cma == cma)
+			return &cma_pools[i];
+
+	return NULL;
+}
+
+static struct cma_pool_class *cma_pool_class_get(struct cma_pool *pool,
+						 size_t count)
+{
+	unsigned int i;
+
+	/* Classes are sorted by size, pick the smallest one that fits */
+	for (i = 0; i < pool->nr_classes; i++)
+		if (pool->classes[i].count >= count)
+			return &pool->classes[i];
+
+	return NULL;
+}
+
+static void cma_pool_refill(struct work_struct *work)
+{
+	struct cma_pool *pool = container_of(work, struct cma_pool, refill);
+	unsigned int i;
+
+	for (i = 0; i < pool->nr_classes; i++) {
+		struct cma_pool_class *class = &pool->classes[i];
+		struct page *page;
+
+		while (READ_ONCE(class->nr_free) < pool->depth) {
+			page = cma_alloc(pool->cma, class->count, class->align,
+					 true);
+			if (!page)
+				break;
+
+			spin_lock_irq(&pool->lock);
+			list_add_tail(&page->lru, &class->free);
+			class->nr_free++;
+			spin_unlock_irq(&pool->lock);
+		}
+	}
+}
+
+static struct page *cma_pool_alloc(struct cma_pool *pool, size_t count,
+				   gfp_t gfp)
+{
+	struct cma_pool_class *class = cma_pool_class_get(pool, count);
+	struct page *page = NULL;
+	unsigned long flags;
+	bool refill;
+
+	if (!class) {
+		if (!gfpflags_allow_blocking(gfp))
+			return NULL;
+		return cma_alloc(pool->cma, count,
+				 min_t(size_t, get_order(count << PAGE_SHIFT),
+				       CONFIG_CMA_ALIGNMENT),
+				 gfp & __GFP_NOWARN);
+	}
+
+	spin_lock_irqsave(&pool->lock, flags);
+	if (!list_empty(&class->free)) {
+		page = list_first_entry(&class->free, struct page, lru);
+		list_del(&page->lru);
+		class->nr_free--;
+	}
+	refill = class->nr_free < pool->depth / 2 + 1;
+	spin_unlock_irqrestore(&pool->lock, flags);
+
+	if (refill)
+		queue_work(system_unbound_wq, &pool->refill);
+
+	/*
+	 * Buffers of a class are always class sized, so that they can go
+	 * back to the free list whatever size they were handed out for.
+	 */
+	if (!page && gfpflags_allow_blocking(gfp))
+		page = cma_alloc(pool->cma, class->count, class->align,
+				 gfp & __GFP_NOWARN);
+
+	return page;
+}
+
+static bool cma_pool_free(struct cma_pool *pool, struct page *page,
+			  size_t count)
+{
+	struct cma_pool_class *class = cma_pool_class_get(pool, count);
+	unsigned long pfn = page_to_pfn(page);
+	unsigned long base_pfn = PFN_DOWN(cma_get_base(pool->cma));
+	unsigned long flags;
+
+	if (!class || pfn < base_pfn ||
+	    pfn >= base_pfn + (cma_get_size(pool->cma) >> PAGE_SHIFT))
+		return false;
+
+	spin_lock_irqsave(&pool->lock, flags);
+	if (class->nr_free < pool->depth) {
+		list_add(&page->lru, &class->free);
+		class->nr_free++;
+		page = NULL;
+	}
+	spin_unlock_irqrestore(&pool->lock, flags);
+
+	if (page)
+		cma_release(pool->cma, page, class->count);
+
+	return true;
+}
+#else
+struct cma_pool;
+
+static inline struct cma_pool *cma_pool_get(struct cma *cma)
+{
+	return NULL;
+}
+
+static inline struct page *cma_pool_alloc(struct cma_pool *pool,
+					  size_t count, gfp_t gfp)
+{
+	return NULL;
+}
+
+static inline bool cma_pool_free(struct cma_pool *pool, struct page *page,
+				 size_t count)
+{
+	return false;
+}
+#endif
+
 /**
  * dma_alloc_contiguous() - allocate contiguous pages
  * @dev:   Pointer to device for which the allocation is performed.
@@ -227,17 +391,25 @@ bool dma_release_from_contiguous(struct device *dev, struct page *pages,
  * Note that it byapss one-page size of allocations from the global area as
  * the addresses within one page are always contiguous, so there is no need
  * to waste CMA pages for that kind; it also helps reduce fragmentations.
+ *
+ * A device area with a pool hands out buffers from the pool instead, which
+ * also works from a context that cannot sleep.
  */
 struct page *dma_alloc_contiguous(struct device *dev, size_t size, gfp_t gfp)
 {
 	size_t count = size >> PAGE_SHIFT;
 	struct page *page = NULL;
 	struct cma *cma = NULL;
+	struct cma_pool *pool;
 
-	if (dev && dev->cma_area)
+	if (dev && dev->cma_area) {
 		cma = dev->cma_area;
-	else if (count > 1)
+		pool = cma_pool_get(cma);
+		if (pool)
+			return cma_pool_alloc(pool, count, gfp);
+	} else if (count > 1) {
 		cma = dma_contiguous_default_area;
+	}
 
 	/* CMA can be used only in the context which permits sleeping */
 	if (cma && gfpflags_allow_blocking(gfp)) {
@@ -263,6 +435,11 @@ struct page *dma_alloc_contiguous(struct device *dev, size_t size, gfp_t gfp)
  */
 void dma_free_contiguous(struct device *dev, struct page *page, size_t size)
 {
+	struct cma_pool *pool = cma_pool_get(dev_get_cma_area(dev));
+
+	if (pool && cma_pool_free(pool, page, PAGE_ALIGN(size) >> PAGE_SHIFT))
+		return;
+
 	if (!cma_release(dev_get_cma_area(dev), page,
 			 PAGE_ALIGN(size) >> PAGE_SHIFT))
 		__free_pages(page, get_order(size));
@@ -281,7 +458,11 @@ void dma_free_contiguous(struct device *dev, struct page *page, size_t size)
 
 static int rmem_cma_device_init(struct reserved_mem *rmem, struct device *dev)
 {
+	struct cma_pool *pool = cma_pool_get(rmem->priv);
+
 	dev_set_cma_area(dev, rmem->priv);
+	if (pool)
+		queue_work(system_unbound_wq, &pool->refill);
 	return 0;
 }
 
@@ -296,6 +477,65 @@ static const struct reserved_mem_ops rmem_cma_ops = {
 	.device_release = rmem_cma_device_release,
 };
 
+static void __init rmem_cma_pool_setup(struct reserved_mem *rmem,
+				       struct cma *cma)
+{
+	unsigned long node = rmem->fdt_node;
+	struct cma_pool *pool;
+	const __be32 *prop, *depth;
+	unsigned int i, j;
+	int len;
+
+	prop = of_get_flat_dt_prop(node, "linux,cma-pool-sizes", &len);
+	if (!prop)
+		return;
+
+	if (cma_pool_count == ARRAY_SIZE(cma_pools) || len <= 0 ||
+	    len > CMA_POOL_MAX_CLASSES * sizeof(__be32)) {
+		pr_err("Reserved memory: invalid CMA pool for %s\n", rmem->name);
+		return;
+	}
+
+	pool = &cma_pools[cma_pool_count];
+	depth = of_get_flat_dt_prop(node, "linux,cma-pool-depth", NULL);
+	pool->depth = depth ? be32_to_cpup(depth) : 2;
+	if (!pool->depth)
+		return;
+
+	pool->nr_classes = len / sizeof(__be32);
+	for (i = 0; i < pool->nr_classes; i++) {
+		size_t size = PAGE_ALIGN(be32_to_cpup(&prop[i]));
+		struct cma_pool_class *class;
+
+		if (!size) {
+			pr_err("Reserved memory: invalid CMA pool for %s\n",
+			       rmem->name);
+			return;
+		}
+
+		/* Insertion sort, there are at most CMA_POOL_MAX_CLASSES */
+		for (j = i; j > 0 && pool->classes[j - 1].count >
+		     size >> PAGE_SHIFT; j--)
+			pool->classes[j] = pool->classes[j - 1];
+
+		class = &pool->classes[j];
+		class->count = size >> PAGE_SHIFT;
+		class->align = min_t(unsigned int, get_order(size),
+				     CONFIG_CMA_ALIGNMENT);
+		class->nr_free = 0;
+	}
+
+	for (i = 0; i < pool->nr_classes; i++)
+		INIT_LIST_HEAD(&pool->classes[i].free);
+	spin_lock_init(&pool->lock);
+	INIT_WORK(&pool->refill, cma_pool_refill);
+	pool->cma = cma;
+	cma_pool_count++;
+
+	pr_info("Reserved memory: %u-deep buffer pool of %u size classes in %s\n",
+		pool->depth, pool->nr_classes, rmem->name);
+}
+
 static int __init rmem_cma_setup(struct reserved_mem *rmem)
 {
 	phys_addr_t align = PAGE_SIZE << max(MAX_ORDER - 1, pageblock_order);
@@ -323,6 +563,8 @@ static int __init rmem_cma_setup(struct reserved_mem *rmem)
 
 	if (of_get_flat_dt_prop(node, "linux,cma-default", NULL))
 		dma_contiguous_set_default(cma);
+	else
+		rmem_cma_pool_setup(rmem, cma);
 
 	rmem->ops = &rmem_cma_ops;
 	rmem->priv = cma;
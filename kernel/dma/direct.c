@@ -220,6 +220,49 @@ void dma_direct_free(struct device *dev, size_t size,
 		dma_direct_free_pages(dev, size, cpu_addr, dma_addr, attrs);
 }
 
+static inline void dma_direct_sync_range(struct device *dev,
+		phys_addr_t paddr, size_t size, enum dma_data_direction dir,
+		bool for_cpu)
+{
+	if (for_cpu)
+		arch_sync_dma_for_cpu(dev, paddr, size, dir);
+	else
+		arch_sync_dma_for_device(dev, paddr, size, dir);
+}
+
+/*
+ * Do the cache maintenance of a non-coherent scatterlist once per run of
+ * physically contiguous segments instead of once per segment, lists of
+ * many small adjacent buffers are common and the per call overhead then
+ * dominates.
+ */
+static void dma_direct_sync_sg_arch(struct device *dev,
+		struct scatterlist *sgl, int nents, enum dma_data_direction dir,
+		bool for_cpu)
+{
+	struct scatterlist *sg;
+	phys_addr_t start = 0;
+	size_t len = 0;
+	int i;
+
+	for_each_sg(sgl, sg, nents, i) {
+		phys_addr_t paddr = dma_to_phys(dev, sg_dma_address(sg));
+
+		if (len && paddr == start + len) {
+			len += sg->length;
+			continue;
+		}
+
+		if (len)
+			dma_direct_sync_range(dev, start, len, dir, for_cpu);
+		start = paddr;
+		len = sg->length;
+	}
+
+	if (len)
+		dma_direct_sync_range(dev, start, len, dir, for_cpu);
+}
+
 #if defined(CONFIG_ARCH_HAS_SYNC_DMA_FOR_DEVICE) || \
     defined(CONFIG_SWIOTLB)
 void dma_direct_sync_single_for_device(struct device *dev,
@@ -247,11 +290,10 @@ void dma_direct_sync_sg_for_device(struct device *dev,
 		if (unlikely(is_swiotlb_buffer(paddr)))
 			swiotlb_tbl_sync_single(dev, paddr, sg->length,
 					dir, SYNC_FOR_DEVICE);
-
-		if (!dev_is_dma_coherent(dev))
-			arch_sync_dma_for_device(dev, paddr, sg->length,
-					dir);
 	}
+
+	if (!dev_is_dma_coherent(dev))
+		dma_direct_sync_sg_arch(dev, sgl, nents, dir, false);
 }
 EXPORT_SYMBOL(dma_direct_sync_sg_for_device);
 #endif
@@ -280,12 +322,12 @@ void dma_direct_sync_sg_for_cpu(struct device *dev,
 	struct scatterlist *sg;
 	int i;
 
+	if (!dev_is_dma_coherent(dev))
+		dma_direct_sync_sg_arch(dev, sgl, nents, dir, true);
+
 	for_each_sg(sgl, sg, nents, i) {
 		phys_addr_t paddr = dma_to_phys(dev, sg_dma_address(sg));
 
-		if (!dev_is_dma_coherent(dev))
-			arch_sync_dma_for_cpu(dev, paddr, sg->length, dir);
-
 		if (unlikely(is_swiotlb_buffer(paddr)))
 			swiotlb_tbl_sync_single(dev, paddr, sg->length, dir,
 					SYNC_FOR_CPU);
@@ -315,9 +357,18 @@ void dma_direct_unmap_sg(struct device *dev, struct scatterlist *sgl,
 	struct scatterlist *sg;
 	int i;
 
-	for_each_sg(sgl, sg, nents, i)
-		dma_direct_unmap_page(dev, sg->dma_address, sg_dma_len(sg), dir,
-			     attrs);
+	if (!(attrs & DMA_ATTR_SKIP_CPU_SYNC) && !dev_is_dma_coherent(dev)) {
+		dma_direct_sync_sg_arch(dev, sgl, nents, dir, true);
+		arch_sync_dma_for_cpu_all(dev);
+	}
+
+	for_each_sg(sgl, sg, nents, i) {
+		phys_addr_t phys = dma_to_phys(dev, sg->dma_address);
+
+		if (unlikely(is_swiotlb_buffer(phys)))
+			swiotlb_tbl_unmap_single(dev, phys, sg_dma_len(sg),
+					sg_dma_len(sg), dir, attrs);
+	}
 }
 EXPORT_SYMBOL(dma_direct_unmap_sg);
 #endif
@@ -329,19 +380,32 @@ static inline bool dma_direct_possible(struct device *dev, dma_addr_t dma_addr,
 		dma_capable(dev, dma_addr, size);
 }
 
-dma_addr_t dma_direct_map_page(struct device *dev, struct page *page,
-		unsigned long offset, size_t size, enum dma_data_direction dir,
+static dma_addr_t __dma_direct_map_page(struct device *dev,
+		phys_addr_t *phys, size_t size, enum dma_data_direction dir,
 		unsigned long attrs)
 {
-	phys_addr_t phys = page_to_phys(page) + offset;
-	dma_addr_t dma_addr = phys_to_dma(dev, phys);
+	dma_addr_t dma_addr = phys_to_dma(dev, *phys);
 
 	if (unlikely(!dma_direct_possible(dev, dma_addr, size)) &&
-	    !swiotlb_map(dev, &phys, &dma_addr, size, dir, attrs)) {
+	    !swiotlb_map(dev, phys, &dma_addr, size, dir, attrs)) {
 		report_addr(dev, dma_addr, size);
 		return DMA_MAPPING_ERROR;
 	}
 
+	return dma_addr;
+}
+
+dma_addr_t dma_direct_map_page(struct device *dev, struct page *page,
+		unsigned long offset, size_t size, enum dma_data_direction dir,
+		unsigned long attrs)
+{
+	phys_addr_t phys = page_to_phys(page) + offset;
+	dma_addr_t dma_addr;
+
+	dma_addr = __dma_direct_map_page(dev, &phys, size, dir, attrs);
+	if (dma_addr == DMA_MAPPING_ERROR)
+		return dma_addr;
+
 	if (!dev_is_dma_coherent(dev) && !(attrs & DMA_ATTR_SKIP_CPU_SYNC))
 		arch_sync_dma_for_device(dev, phys, size, dir);
 	return dma_addr;
@@ -355,13 +419,18 @@ int dma_direct_map_sg(struct device *dev, struct scatterlist *sgl, int nents,
 	struct scatterlist *sg;
 
 	for_each_sg(sgl, sg, nents, i) {
-		sg->dma_address = dma_direct_map_page(dev, sg_page(sg),
-				sg->offset, sg->length, dir, attrs);
+		phys_addr_t phys = sg_phys(sg);
+
+		sg->dma_address = __dma_direct_map_page(dev, &phys, sg->length,
+				dir, attrs);
 		if (sg->dma_address == DMA_MAPPING_ERROR)
 			goto out_unmap;
 		sg_dma_len(sg) = sg->length;
 	}
 
+	if (!dev_is_dma_coherent(dev) && !(attrs & DMA_ATTR_SKIP_CPU_SYNC))
+		dma_direct_sync_sg_arch(dev, sgl, nents, dir, false);
+
 	return nents;
 
 out_unmap:
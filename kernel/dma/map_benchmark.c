@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Scatterlist streaming DMA mapping benchmark.
+ *
+ * Bind a device to the "dma_map_benchmark" driver through driver_override,
+ * set the list shape in /sys/kernel/debug/dma_map_benchmark/ and read
+ * "results" to run it with the DMA ops of that device.
+ */
+
+#define pr_fmt(fmt)	KBUILD_MODNAME ": " fmt
+
+#include <linux/debugfs.h>
+#include <linux/dma-mapping.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+#include <linux/platform_device.h>
+#include <linux/scatterlist.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+
+#define DMA_MAP_BENCHMARK_MAX_NENTS	4096
+
+struct map_benchmark {
+	struct device *dev;
+	struct dentry *debugfs;
+	struct mutex lock;
+	u32 nents;
+	u32 seg_size;
+	u32 iterations;
+	bool contiguous;
+};
+
+static int map_benchmark_run(struct seq_file *m, void *unused)
+{
+	struct map_benchmark *mb = m->private;
+	u64 map_ns = 0, sync_cpu_ns = 0, sync_dev_ns = 0, unmap_ns = 0;
+	struct scatterlist *sgl, *sg;
+	unsigned int order, stride;
+	struct page *pages;
+	ktime_t t0, t1, t2, t3, t4;
+	int i, nents, ret = 0;
+	u32 iter;
+
+	mutex_lock(&mb->lock);
+
+	if (!mb->nents || mb->nents > DMA_MAP_BENCHMARK_MAX_NENTS ||
+	    !mb->seg_size || mb->seg_size > PAGE_SIZE || !mb->iterations) {
+		ret = -EINVAL;
+		goto out_unlock;
+	}
+
+	/*
+	 * Segments are either packed back to back or spread one per page,
+	 * to compare lists that can be merged with lists that cannot.
+	 */
+	stride = mb->contiguous ? mb->seg_size : PAGE_SIZE;
+	order = get_order(mb->nents * stride);
+	if (order >= MAX_ORDER) {
+		ret = -EINVAL;
+		goto out_unlock;
+	}
+
+	pages = alloc_pages(GFP_KERNEL, order);
+	if (!pages) {
+		ret = -ENOMEM;
+		goto out_unlock;
+	}
+
+	sgl = kmalloc_array(mb->nents, sizeof(*sgl), GFP_KERNEL);
+	if (!sgl) {
+		ret = -ENOMEM;
+		goto out_free_pages;
+	}
+
+	sg_init_table(sgl, mb->nents);
+	for_each_sg(sgl, sg, mb->nents, i)
+		sg_set_buf(sg, page_address(pages) + i * stride, mb->seg_size);
+
+	for (iter = 0; iter < mb->iterations; iter++) {
+		t0 = ktime_get();
+		nents = dma_map_sg(mb->dev, sgl, mb->nents, DMA_BIDIRECTIONAL);
+		t1 = ktime_get();
+		if (!nents) {
+			ret = -ENOMEM;
+			break;
+		}
+
+		dma_sync_sg_for_cpu(mb->dev, sgl, mb->nents, DMA_BIDIRECTIONAL);
+		t2 = ktime_get();
+		dma_sync_sg_for_device(mb->dev, sgl, mb->nents,
+				       DMA_BIDIRECTIONAL);
+		t3 = ktime_get();
+		dma_unmap_sg(mb->dev, sgl, mb->nents, DMA_BIDIRECTIONAL);
+		t4 = ktime_get();
+
+		map_ns += ktime_to_ns(ktime_sub(t1, t0));
+		sync_cpu_ns += ktime_to_ns(ktime_sub(t2, t1));
+		sync_dev_ns += ktime_to_ns(ktime_sub(t3, t2));
+		unmap_ns += ktime_to_ns(ktime_sub(t4, t3));
+
+		cond_resched();
+	}
+
+	if (!ret) {
+		seq_printf(m, "nents %u seg_size %u %s iterations %u\n",
+			   mb->nents, mb->seg_size,
+			   mb->contiguous ? "contiguous" : "scattered",
+			   mb->iterations);
+		seq_printf(m, "map_sg:             %llu ns\n",
+			   div_u64(map_ns, mb->iterations));
+		seq_printf(m, "sync_sg_for_cpu:    %llu ns\n",
+			   div_u64(sync_cpu_ns, mb->iterations));
+		seq_printf(m, "sync_sg_for_device: %llu ns\n",
+			   div_u64(sync_dev_ns, mb->iterations));
+		seq_printf(m, "unmap_sg:           %llu ns\n",
+			   div_u64(unmap_ns, mb->iterations));
+	}
+
+	kfree(sgl);
+out_free_pages:
+	__free_pages(pages, order);
+out_unlock:
+	mutex_unlock(&mb->lock);
+	return ret;
+}
+
+static int map_benchmark_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, map_benchmark_run, inode->i_private);
+}
+
+static const struct file_operations map_benchmark_fops = {
+	.owner		= THIS_MODULE,
+	.open		= map_benchmark_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int map_benchmark_probe(struct platform_device *pdev)
+{
+	struct map_benchmark *mb;
+
+	mb = devm_kzalloc(&pdev->dev, sizeof(*mb), GFP_KERNEL);
+	if (!mb)
+		return -ENOMEM;
+
+	mb->dev = &pdev->dev;
+	mb->nents = 256;
+	mb->seg_size = 128;
+	mb->iterations = 1000;
+	mutex_init(&mb->lock);
+
+	mb->debugfs = debugfs_create_dir(KBUILD_MODNAME, NULL);
+	debugfs_create_u32("nents", 0600, mb->debugfs, &mb->nents);
+	debugfs_create_u32("seg_size", 0600, mb->debugfs, &mb->seg_size);
+	debugfs_create_u32("iterations", 0600, mb->debugfs, &mb->iterations);
+	debugfs_create_bool("contiguous", 0600, mb->debugfs, &mb->contiguous);
+	debugfs_create_file("results", 0400, mb->debugfs, mb,
+			    &map_benchmark_fops);
+
+	platform_set_drvdata(pdev, mb);
+	return 0;
+}
+
+static int map_benchmark_remove(struct platform_device *pdev)
+{
+	struct map_benchmark *mb = platform_get_drvdata(pdev);
+
+	debugfs_remove_recursive(mb->debugfs);
+	return 0;
+}
+
+static struct platform_driver map_benchmark_driver = {
+	.driver		= {
+		.name	= "dma_map_benchmark",
+	},
+	.probe		= map_benchmark_probe,
+	.remove		= map_benchmark_remove,
+};
+module_platform_driver(map_benchmark_driver);
+
+MODULE_DESCRIPTION("Scatterlist streaming DMA mapping benchmark");
+MODULE_LICENSE("GPL v2");
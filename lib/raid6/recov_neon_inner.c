@@ -46,6 +46,52 @@ void __raid6_2data_recov_neon(int bytes, uint8_t *p, uint8_t *q, uint8_t *dp,
 	 * }
 	 */
 
+	/*
+	 * Two independent 16 byte lanes per iteration, so that the table
+	 * lookups of one lane fill the load latency of the other on in-order
+	 * cores such as the Cortex-A53.
+	 */
+	while (bytes >= 32) {
+		uint8x16_t vx0, vy0, px0, qx0, db0;
+		uint8x16_t vx1, vy1, px1, qx1, db1;
+
+		px0 = veorq_u8(vld1q_u8(p), vld1q_u8(dp));
+		px1 = veorq_u8(vld1q_u8(p + 16), vld1q_u8(dp + 16));
+		vx0 = veorq_u8(vld1q_u8(q), vld1q_u8(dq));
+		vx1 = veorq_u8(vld1q_u8(q + 16), vld1q_u8(dq + 16));
+
+		vy0 = vshrq_n_u8(vx0, 4);
+		vy1 = vshrq_n_u8(vx1, 4);
+		vx0 = vqtbl1q_u8(qm0, vandq_u8(vx0, x0f));
+		vx1 = vqtbl1q_u8(qm0, vandq_u8(vx1, x0f));
+		vy0 = vqtbl1q_u8(qm1, vy0);
+		vy1 = vqtbl1q_u8(qm1, vy1);
+		qx0 = veorq_u8(vx0, vy0);
+		qx1 = veorq_u8(vx1, vy1);
+
+		vy0 = vshrq_n_u8(px0, 4);
+		vy1 = vshrq_n_u8(px1, 4);
+		vx0 = vqtbl1q_u8(pm0, vandq_u8(px0, x0f));
+		vx1 = vqtbl1q_u8(pm0, vandq_u8(px1, x0f));
+		vy0 = vqtbl1q_u8(pm1, vy0);
+		vy1 = vqtbl1q_u8(pm1, vy1);
+		vx0 = veorq_u8(vx0, vy0);
+		vx1 = veorq_u8(vx1, vy1);
+		db0 = veorq_u8(vx0, qx0);
+		db1 = veorq_u8(vx1, qx1);
+
+		vst1q_u8(dq, db0);
+		vst1q_u8(dq + 16, db1);
+		vst1q_u8(dp, veorq_u8(db0, px0));
+		vst1q_u8(dp + 16, veorq_u8(db1, px1));
+
+		bytes -= 32;
+		p += 32;
+		q += 32;
+		dp += 32;
+		dq += 32;
+	}
+
 	while (bytes) {
 		uint8x16_t vx, vy, px, qx, db;
 
@@ -88,6 +134,34 @@ void __raid6_datap_recov_neon(int bytes, uint8_t *p, uint8_t *q, uint8_t *dq,
 	 * }
 	 */
 
+	while (bytes >= 32) {
+		uint8x16_t vx0, vy0, vx1, vy1;
+
+		vx0 = veorq_u8(vld1q_u8(q), vld1q_u8(dq));
+		vx1 = veorq_u8(vld1q_u8(q + 16), vld1q_u8(dq + 16));
+
+		vy0 = vshrq_n_u8(vx0, 4);
+		vy1 = vshrq_n_u8(vx1, 4);
+		vx0 = vqtbl1q_u8(qm0, vandq_u8(vx0, x0f));
+		vx1 = vqtbl1q_u8(qm0, vandq_u8(vx1, x0f));
+		vy0 = vqtbl1q_u8(qm1, vy0);
+		vy1 = vqtbl1q_u8(qm1, vy1);
+		vx0 = veorq_u8(vx0, vy0);
+		vx1 = veorq_u8(vx1, vy1);
+		vy0 = veorq_u8(vx0, vld1q_u8(p));
+		vy1 = veorq_u8(vx1, vld1q_u8(p + 16));
+
+		vst1q_u8(dq, vx0);
+		vst1q_u8(dq + 16, vx1);
+		vst1q_u8(p, vy0);
+		vst1q_u8(p + 16, vy1);
+
+		bytes -= 32;
+		p += 32;
+		q += 32;
+		dq += 32;
+	}
+
 	while (bytes) {
 		uint8x16_t vx, vy;
 
@@ -3413,6 +3413,10 @@ BPF_CALL_2(bpf_xdp_adjust_tail, struct xdp_buff *, xdp, int, offset)
 	if (unlikely(offset >= 0))
 		return -EINVAL;
 
+	/* The tail of a multi-buffer frame is in its last fragment */
+	if (xdp_buff_has_frags(xdp))
+		return -EOPNOTSUPP;
+
 	if (unlikely(data_end < xdp->data + ETH_HLEN))
 		return -EINVAL;
 
@@ -3637,6 +3641,14 @@ int xdp_do_redirect(struct net_device *dev, struct xdp_buff *xdp,
 	struct bpf_redirect_info *ri = this_cpu_ptr(&bpf_redirect_info);
 	struct bpf_map *map = READ_ONCE(ri->map);
 
+	/* None of the redirect targets transmit or copy fragments yet */
+	if (xdp_buff_has_frags(xdp)) {
+		ri->tgt_index = 0;
+		ri->tgt_value = NULL;
+		WRITE_ONCE(ri->map, NULL);
+		return -EOPNOTSUPP;
+	}
+
 	if (likely(map))
 		return xdp_do_redirect_map(dev, xdp, xdp_prog, map, ri);
 
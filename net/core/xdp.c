@@ -209,9 +209,11 @@ static void xdp_rxq_info_init(struct xdp_rxq_info *xdp_rxq)
 	memset(xdp_rxq, 0, sizeof(*xdp_rxq));
 }
 
-/* Returns 0 on success, negative on failure */
-int xdp_rxq_info_reg(struct xdp_rxq_info *xdp_rxq,
-		     struct net_device *dev, u32 queue_index)
+/* Returns 0 on success, negative on failure. A non-zero @frag_size lets
+ * the queue build multi-buffer frames out of buffers of that size.
+ */
+int __xdp_rxq_info_reg(struct xdp_rxq_info *xdp_rxq,
+		       struct net_device *dev, u32 queue_index, u32 frag_size)
 {
 	if (xdp_rxq->reg_state == REG_STATE_UNUSED) {
 		WARN(1, "Driver promised not to register this");
@@ -232,11 +234,12 @@ int xdp_rxq_info_reg(struct xdp_rxq_info *xdp_rxq,
 	xdp_rxq_info_init(xdp_rxq);
 	xdp_rxq->dev = dev;
 	xdp_rxq->queue_index = queue_index;
+	xdp_rxq->frag_size = frag_size;
 
 	xdp_rxq->reg_state = REG_STATE_REGISTERED;
 	return 0;
 }
-EXPORT_SYMBOL_GPL(xdp_rxq_info_reg);
+EXPORT_SYMBOL_GPL(__xdp_rxq_info_reg);
 
 void xdp_rxq_info_unused(struct xdp_rxq_info *xdp_rxq)
 {
@@ -433,20 +436,45 @@ static void __xdp_return(void *data, struct xdp_mem_info *mem, bool napi_direct,
 	}
 }
 
+/* The fragments of a multi-buffer frame come from the same allocator as
+ * its first buffer, and go back there before it.
+ */
+static void xdp_return_frags(struct skb_shared_info *sinfo,
+			     struct xdp_mem_info *mem, bool napi_direct)
+{
+	int i;
+
+	for (i = 0; i < sinfo->nr_frags; i++)
+		__xdp_return(skb_frag_address(&sinfo->frags[i]), mem,
+			     napi_direct, 0);
+}
+
 void xdp_return_frame(struct xdp_frame *xdpf)
 {
+	if (xdp_frame_has_frags(xdpf))
+		xdp_return_frags(xdp_get_shared_info_from_frame(xdpf),
+				 &xdpf->mem, false);
+
 	__xdp_return(xdpf->data, &xdpf->mem, false, 0);
 }
 EXPORT_SYMBOL_GPL(xdp_return_frame);
 
 void xdp_return_frame_rx_napi(struct xdp_frame *xdpf)
 {
+	if (xdp_frame_has_frags(xdpf))
+		xdp_return_frags(xdp_get_shared_info_from_frame(xdpf),
+				 &xdpf->mem, true);
+
 	__xdp_return(xdpf->data, &xdpf->mem, true, 0);
 }
 EXPORT_SYMBOL_GPL(xdp_return_frame_rx_napi);
 
 void xdp_return_buff(struct xdp_buff *xdp)
 {
+	if (xdp_buff_has_frags(xdp))
+		xdp_return_frags(xdp_get_shared_info_from_buff(xdp),
+				 &xdp->rxq->mem, true);
+
 	__xdp_return(xdp->data, &xdp->rxq->mem, true, xdp->handle);
 }
 EXPORT_SYMBOL_GPL(xdp_return_buff);
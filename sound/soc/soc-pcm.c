@@ -2947,6 +2947,9 @@ int soc_new_pcm(struct snd_soc_pcm_runtime *rtd, int num)
 			rtd->ops.page		= snd_soc_pcm_component_page;
 		if (ops->mmap)
 			rtd->ops.mmap		= snd_soc_pcm_component_mmap;
+		if (ops->get_time_info)
+			rtd->ops.get_time_info	=
+				snd_soc_pcm_component_get_time_info;
 	}
 
 	if (playback)
@@ -8,6 +8,7 @@
 
 #include <linux/clk.h>
 #include <linux/io.h>
+#include <linux/math64.h>
 #include <linux/module.h>
 #include <linux/of_address.h>
 #include <linux/of_irq.h>
@@ -72,9 +73,10 @@
 #define XLNX_PARAM_UNKNOWN	0
 
 static const struct snd_pcm_hardware xlnx_pcm_hardware = {
-	.info = SNDRV_PCM_INFO_INTERLEAVED | SNDRV_PCM_INFO_BLOCK_TRANSFER |
-		SNDRV_PCM_INFO_BATCH | SNDRV_PCM_INFO_PAUSE |
-		SNDRV_PCM_INFO_RESUME,
+	.info = SNDRV_PCM_INFO_MMAP | SNDRV_PCM_INFO_MMAP_VALID |
+		SNDRV_PCM_INFO_INTERLEAVED | SNDRV_PCM_INFO_BLOCK_TRANSFER |
+		SNDRV_PCM_INFO_PAUSE | SNDRV_PCM_INFO_RESUME |
+		SNDRV_PCM_INFO_NO_PERIOD_WAKEUP | SNDRV_PCM_INFO_HAS_LINK_ATIME,
 	.formats = SNDRV_PCM_FMTBIT_S8 | SNDRV_PCM_FMTBIT_S16_LE |
 		   SNDRV_PCM_FMTBIT_S24_LE,
 	.channels_min = 2,
@@ -387,6 +389,19 @@ static int xlnx_formatter_pcm_open(struct snd_pcm_substream *substream)
 	snd_soc_set_runtime_hwparams(substream, &xlnx_pcm_hardware);
 	runtime->private_data = stream_data;
 
+	/*
+	 * The DAI may have more channels than a formatter stream carries,
+	 * e.g. aggregated I2S instances, keep to the ones of the formatter.
+	 */
+	err = snd_pcm_hw_constraint_minmax(runtime,
+					   SNDRV_PCM_HW_PARAM_CHANNELS, 1,
+					   stream_data->ch_limit);
+	if (err < 0) {
+		dev_err(component->dev,
+			"unable to set constraint on channels\n");
+		return err;
+	}
+
 	/* Resize the period size divisible by 64 */
 	err = snd_pcm_hw_constraint_step(runtime, 0,
 					 SNDRV_PCM_HW_PARAM_PERIOD_BYTES, 64);
@@ -443,6 +458,54 @@ xlnx_formatter_pcm_pointer(struct snd_pcm_substream *substream)
 	return bytes_to_frames(runtime, pos);
 }
 
+/*
+ * Report the link time from the formatter transfer count, sampled back to
+ * back with the system time so that the audio position can be correlated
+ * with the video frame timestamps of the same system clock.
+ */
+static int
+xlnx_formatter_pcm_get_time_info(struct snd_pcm_substream *substream,
+			struct timespec *system_ts, struct timespec *audio_ts,
+			struct snd_pcm_audio_tstamp_config *audio_tstamp_config,
+			struct snd_pcm_audio_tstamp_report *audio_tstamp_report)
+{
+	u32 pos;
+	u64 frames, nsec;
+	unsigned long flags;
+	snd_pcm_uframes_t hw_pos;
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	struct xlnx_pcm_stream_param *stream_data = runtime->private_data;
+
+	if (audio_tstamp_config->type_requested !=
+	    SNDRV_PCM_AUDIO_TSTAMP_TYPE_LINK) {
+		audio_tstamp_report->actual_type =
+			SNDRV_PCM_AUDIO_TSTAMP_TYPE_DEFAULT;
+		return 0;
+	}
+
+	local_irq_save(flags);
+	pos = ioread32(stream_data->mmio + XLNX_AUD_XFER_COUNT);
+	snd_pcm_gettime(runtime, system_ts);
+	local_irq_restore(flags);
+
+	if (pos >= stream_data->buffer_size)
+		pos = 0;
+
+	/* the hw_ptr is only updated after this callback, catch the wrap */
+	hw_pos = bytes_to_frames(runtime, pos);
+	frames = runtime->hw_ptr_wrap + runtime->hw_ptr_base + hw_pos;
+	if (hw_pos < runtime->status->hw_ptr - runtime->hw_ptr_base)
+		frames += runtime->buffer_size;
+
+	nsec = mul_u64_u32_div(frames, NSEC_PER_SEC, runtime->rate);
+	*audio_ts = ns_to_timespec(nsec);
+
+	audio_tstamp_report->actual_type = SNDRV_PCM_AUDIO_TSTAMP_TYPE_LINK;
+	audio_tstamp_report->accuracy_report = 0;
+
+	return 0;
+}
+
 static int xlnx_formatter_pcm_hw_params(struct snd_pcm_substream *substream,
 					struct snd_pcm_hw_params *params)
 {
@@ -549,14 +612,22 @@ static int xlnx_formatter_pcm_trigger(struct snd_pcm_substream *substream,
 				      int cmd)
 {
 	u32 val;
-	struct xlnx_pcm_stream_param *stream_data =
-			substream->runtime->private_data;
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	struct xlnx_pcm_stream_param *stream_data = runtime->private_data;
 
 	switch (cmd) {
 	case SNDRV_PCM_TRIGGER_START:
 	case SNDRV_PCM_TRIGGER_PAUSE_RELEASE:
 	case SNDRV_PCM_TRIGGER_RESUME:
 		val = ioread32(stream_data->mmio + XLNX_AUD_CTRL);
+		/*
+		 * Without period wakeups the application tracks the transfer
+		 * count through .pointer, so keep the IOC interrupt masked.
+		 */
+		if (runtime->no_period_wakeup)
+			val &= ~AUD_CTRL_IOC_IRQ_MASK;
+		else
+			val |= AUD_CTRL_IOC_IRQ_MASK;
 		val |= AUD_CTRL_DMA_EN_MASK;
 		iowrite32(val, stream_data->mmio + XLNX_AUD_CTRL);
 		break;
@@ -595,6 +666,7 @@ static const struct snd_pcm_ops xlnx_formatter_pcm_ops = {
 	.hw_free = xlnx_formatter_pcm_hw_free,
 	.trigger = xlnx_formatter_pcm_trigger,
 	.pointer = xlnx_formatter_pcm_pointer,
+	.get_time_info = xlnx_formatter_pcm_get_time_info,
 };
 
 static struct snd_soc_component_driver xlnx_asoc_component = {
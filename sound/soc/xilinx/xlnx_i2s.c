@@ -23,40 +23,83 @@
 #define I2S_CH0_OFFSET			0x30
 #define I2S_I2STIM_VALID_MASK		GENMASK(7, 0)
 
+/*
+ * struct xlnx_i2s_dev_data - I2S instance data
+ * @base: base address of the registers
+ * @axi_clk: AXI4-Lite clock
+ * @axis_clk: AXI4-Stream clock
+ * @aud_mclk: audio master clock
+ * @ch_pairs: channel pairs, i.e. I2S data lines, of the instance
+ * @members: instances aggregated into the DAI of this one
+ * @num_members: number of aggregated instances
+ * @aggregated: the instance is a member of another one's DAI
+ *
+ * The instances listed in "xlnx,aggregate" take the channel pairs following
+ * the ones of this instance from the same AXI4-Stream, which the design
+ * broadcasts to all of them. The DAI of this instance then has the channels
+ * of all of them, so a single formatter DMA and period interrupt serve all
+ * the channels in one interleaved buffer.
+ */
 struct xlnx_i2s_dev_data {
 	void __iomem *base;
 	struct clk *axi_clk;
 	struct clk *axis_clk;
 	struct clk *aud_mclk;
+	u32 ch_pairs;
+	struct xlnx_i2s_dev_data **members;
+	unsigned int num_members;
+	bool aggregated;
 };
 
 static int xlnx_i2s_set_sclkout_div(struct snd_soc_dai *cpu_dai,
 				    int div_id, int div)
 {
 	struct xlnx_i2s_dev_data *dev_data = snd_soc_dai_get_drvdata(cpu_dai);
+	unsigned int i;
 
 	if (!div || (div & ~I2S_I2STIM_VALID_MASK))
 		return -EINVAL;
 
 	writel(div, dev_data->base + I2S_I2STIM_OFFSET);
+	for (i = 0; i < dev_data->num_members; i++)
+		writel(div, dev_data->members[i]->base + I2S_I2STIM_OFFSET);
 
 	return 0;
 }
 
+/*
+ * Route the channel pairs from @first on of the stream to the data lines of
+ * an instance, stopping at @last, the last pair of the stream.
+ */
+static u32 xlnx_i2s_set_ch_mux(struct xlnx_i2s_dev_data *dev_data,
+			       u32 first, u32 last)
+{
+	u32 reg_off, chan_id;
+
+	for (chan_id = first;
+	     chan_id < first + dev_data->ch_pairs && chan_id <= last;
+	     chan_id++) {
+		reg_off = I2S_CH0_OFFSET + ((chan_id - first) * 4);
+		writel(chan_id, dev_data->base + reg_off);
+	}
+
+	return chan_id;
+}
+
 static int xlnx_i2s_hw_params(struct snd_pcm_substream *substream,
 			      struct snd_pcm_hw_params *params,
 			      struct snd_soc_dai *i2s_dai)
 {
-	u32 reg_off, chan_id;
 	struct xlnx_i2s_dev_data *dev_data = snd_soc_dai_get_drvdata(i2s_dai);
+	u32 chan_id, last;
+	unsigned int i;
 
-	chan_id = params_channels(params) / 2;
+	last = params_channels(params) / 2;
 
-	while (chan_id > 0) {
-		reg_off = I2S_CH0_OFFSET + ((chan_id - 1) * 4);
-		writel(chan_id, dev_data->base + reg_off);
-		chan_id--;
-	}
+	chan_id = xlnx_i2s_set_ch_mux(dev_data, 1, last);
+	for (i = 0; i < dev_data->num_members; i++)
+		chan_id = xlnx_i2s_set_ch_mux(dev_data->members[i], chan_id,
+					      last);
 
 	return 0;
 }
@@ -65,26 +108,117 @@ static int xlnx_i2s_trigger(struct snd_pcm_substream *substream, int cmd,
 			    struct snd_soc_dai *i2s_dai)
 {
 	struct xlnx_i2s_dev_data *dev_data = snd_soc_dai_get_drvdata(i2s_dai);
+	unsigned int i;
+	u32 val;
 
 	switch (cmd) {
 	case SNDRV_PCM_TRIGGER_START:
 	case SNDRV_PCM_TRIGGER_RESUME:
 	case SNDRV_PCM_TRIGGER_PAUSE_RELEASE:
-		writel(1, dev_data->base + I2S_CORE_CTRL_OFFSET);
+		val = 1;
 		break;
 	case SNDRV_PCM_TRIGGER_STOP:
 	case SNDRV_PCM_TRIGGER_SUSPEND:
 	case SNDRV_PCM_TRIGGER_PAUSE_PUSH:
-		writel(0, dev_data->base + I2S_CORE_CTRL_OFFSET);
+		val = 0;
 		break;
 	default:
 		return -EINVAL;
 	}
 
+	/* The members first, so that they take the stream from its start */
+	for (i = 0; i < dev_data->num_members; i++)
+		writel(val, dev_data->members[i]->base + I2S_CORE_CTRL_OFFSET);
+	writel(val, dev_data->base + I2S_CORE_CTRL_OFFSET);
+
 	return 0;
 }
 
+static int xlnx_i2s_startup(struct snd_pcm_substream *substream,
+			    struct snd_soc_dai *i2s_dai)
+{
+	struct xlnx_i2s_dev_data *dev_data = snd_soc_dai_get_drvdata(i2s_dai);
+
+	/* The lines of an aggregated instance belong to another DAI */
+	if (dev_data->aggregated)
+		return -EBUSY;
+
+	return 0;
+}
+
+/**
+ * xlnx_i2s_get_members - Get the instances aggregated into this one
+ * @dev: device of the instance
+ * @dev_data: instance data
+ * @compat: compatible of the instance, the members have the same direction
+ * @data_width: sample width of the instance, the members have the same
+ *
+ * Return: the total number of channel pairs on success, else error code
+ */
+static int xlnx_i2s_get_members(struct device *dev,
+				struct xlnx_i2s_dev_data *dev_data,
+				const char *compat, u32 data_width)
+{
+	struct device_node *node = dev->of_node;
+	struct xlnx_i2s_dev_data *member;
+	struct platform_device *pdev;
+	struct device_node *np;
+	struct device_link *link;
+	int i, count;
+	u32 ch_pairs = dev_data->ch_pairs;
+	u32 width = 0;
+
+	count = of_count_phandle_with_args(node, "xlnx,aggregate", NULL);
+	if (count <= 0)
+		return ch_pairs;
+
+	dev_data->members = devm_kcalloc(dev, count,
+					 sizeof(*dev_data->members),
+					 GFP_KERNEL);
+	if (!dev_data->members)
+		return -ENOMEM;
+
+	for (i = 0; i < count; i++) {
+		np = of_parse_phandle(node, "xlnx,aggregate", i);
+		if (!np)
+			return -EINVAL;
+
+		of_property_read_u32(np, "xlnx,dwidth", &width);
+		if (!of_device_is_compatible(np, compat) ||
+		    width != data_width) {
+			dev_err(dev, "%pOF can't be aggregated\n", np);
+			of_node_put(np);
+			return -EINVAL;
+		}
+
+		pdev = of_find_device_by_node(np);
+		of_node_put(np);
+		if (!pdev)
+			return -EPROBE_DEFER;
+
+		member = platform_get_drvdata(pdev);
+		if (!member) {
+			put_device(&pdev->dev);
+			return -EPROBE_DEFER;
+		}
+
+		/* Go away with any of the members */
+		link = device_link_add(dev, &pdev->dev,
+				       DL_FLAG_AUTOREMOVE_CONSUMER);
+		put_device(&pdev->dev);
+		if (!link)
+			return -EINVAL;
+
+		member->aggregated = true;
+		dev_data->members[dev_data->num_members++] = member;
+		ch_pairs += member->ch_pairs;
+	}
+
+	return ch_pairs;
+}
+
 static const struct snd_soc_dai_ops xlnx_i2s_dai_ops = {
+	.startup = xlnx_i2s_startup,
 	.trigger = xlnx_i2s_trigger,
 	.set_clkdiv = xlnx_i2s_set_sclkout_div,
 	.hw_params = xlnx_i2s_hw_params
@@ -109,6 +243,7 @@ static int xlnx_i2s_probe(struct platform_device *pdev)
 	u32 ch = 0, format, data_width = 0;
 	struct device *dev = &pdev->dev;
 	struct device_node *node = dev->of_node;
+	const char *compat;
 
 	dai_drv = devm_kzalloc(&pdev->dev, sizeof(*dai_drv), GFP_KERNEL);
 	if (!dai_drv)
@@ -130,7 +265,7 @@ static int xlnx_i2s_probe(struct platform_device *pdev)
 		dev_err(dev, "cannot get supported channels\n");
 		return ret;
 	}
-	ch = ch * 2;
+	dev_data->ch_pairs = ch;
 
 	ret = of_property_read_u32(node, "xlnx,dwidth", &data_width);
 	if (ret < 0) {
@@ -148,6 +283,16 @@ static int xlnx_i2s_probe(struct platform_device *pdev)
 		return -EINVAL;
 	}
 
+	if (of_device_is_compatible(node, "xlnx,i2s-transmitter-1.0"))
+		compat = "xlnx,i2s-transmitter-1.0";
+	else
+		compat = "xlnx,i2s-receiver-1.0";
+
+	ret = xlnx_i2s_get_members(dev, dev_data, compat, data_width);
+	if (ret < 0)
+		return ret;
+	ch = ret * 2;
+
 	if (of_device_is_compatible(node, "xlnx,i2s-transmitter-1.0")) {
 		dai_drv->name = "xlnx_i2s_playback";
 		dai_drv->playback.stream_name = "Playback";
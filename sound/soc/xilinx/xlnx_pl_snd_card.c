@@ -114,8 +114,8 @@ static int xlnx_i2s_card_hw_params(struct snd_pcm_substream *substream,
 	data_width = params_width(params);
 	sample_rate = params_rate(params);
 
-	/* only 2 channels supported */
-	if (ch != 2)
+	/* channels come in pairs, one per I2S data line */
+	if (!ch || ch % 2)
 		return -EINVAL;
 
 	prv = snd_soc_card_get_drvdata(rtd->card);
@@ -157,7 +157,8 @@ static int xlnx_i2s_card_hw_params(struct snd_pcm_substream *substream,
 	}
 
 	prv->mclk_val = prv->mclk_ratio * sample_rate;
-	clk_div = DIV_ROUND_UP(prv->mclk_ratio, 2 * ch * data_width);
+	/* the bit clock of a line carries one pair, whatever the lines */
+	clk_div = DIV_ROUND_UP(prv->mclk_ratio, 2 * 2 * data_width);
 	ret = snd_soc_dai_set_clkdiv(cpu_dai, 0, clk_div);
 	if (ret)
 		return ret;
@@ -0,0 +1,160 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * AI engine register access throughput
+ *
+ * Requests the first free partition of an AI engine device and times single
+ * register writes and reads with AIE_REG_IOCTL and batches of them with
+ * AIE_REG_CMDBUF_IOCTL, on the data memory of the first core tile of the
+ * partition. The partition is reset when it is released. The results are
+ * printed as "result <metric> <value> <unit>" lines.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/ioctl.h>
+#include <linux/xlnx-ai-engine.h>
+
+#include "../../kselftest.h"
+
+/* AIE tile address of the data memory of the first core tile */
+#define AIE_ROW_SHIFT	18
+#define AIE_DATA_MEM	(1UL << AIE_ROW_SHIFT)
+#define AIE_DATA_WORDS	1024
+
+#define BATCH		256
+
+static double now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int request_partition(int devfd)
+{
+	struct aie_partition_query query = { 0 };
+	struct aie_partition_req req = { 0 };
+	struct aie_range_args *parts;
+	unsigned int i;
+	int fd = -1;
+
+	if (ioctl(devfd, AIE_ENQUIRE_PART_IOCTL, &query) ||
+	    !query.partition_cnt)
+		return -1;
+
+	parts = calloc(query.partition_cnt, sizeof(*parts));
+	if (!parts)
+		return -1;
+
+	query.partitions = parts;
+	if (ioctl(devfd, AIE_ENQUIRE_PART_IOCTL, &query))
+		goto out;
+
+	for (i = 0; i < query.partition_cnt; i++) {
+		if (parts[i].status & XAIE_PART_STATUS_INUSE)
+			continue;
+
+		req.partition_id = parts[i].partition_id;
+		fd = ioctl(devfd, AIE_REQUEST_PART_IOCTL, &req);
+		if (fd >= 0)
+			break;
+	}
+out:
+	free(parts);
+	return fd;
+}
+
+static int bench_single(int fd, enum aie_reg_op op, unsigned int iterations)
+{
+	struct aie_reg_args reg = { .op = op };
+	double start, elapsed;
+	unsigned int i;
+
+	start = now_us();
+	for (i = 0; i < iterations; i++) {
+		reg.offset = AIE_DATA_MEM + (i % AIE_DATA_WORDS) * 4;
+		reg.val = i;
+		if (ioctl(fd, AIE_REG_IOCTL, &reg)) {
+			printf("# AIE_REG_IOCTL: %s\n", strerror(errno));
+			return -1;
+		}
+	}
+	elapsed = now_us() - start;
+
+	printf("result reg_%s %.0f ops/s\n",
+	       op == AIE_REG_WRITE ? "write" : "read",
+	       iterations * 1e6 / elapsed);
+	return 0;
+}
+
+static int bench_cmdbuf(int fd, enum aie_reg_op op, unsigned int iterations)
+{
+	struct aie_reg_args cmds[BATCH] = { 0 };
+	struct aie_reg_cmdbuf cmdbuf = {
+		.cmds = cmds,
+		.num_cmds = BATCH,
+	};
+	double start, elapsed;
+	unsigned int i, batches = (iterations + BATCH - 1) / BATCH;
+
+	for (i = 0; i < BATCH; i++) {
+		cmds[i].op = op;
+		cmds[i].offset = AIE_DATA_MEM + (i % AIE_DATA_WORDS) * 4;
+		cmds[i].val = i;
+	}
+
+	start = now_us();
+	for (i = 0; i < batches; i++) {
+		if (ioctl(fd, AIE_REG_CMDBUF_IOCTL, &cmdbuf)) {
+			printf("# AIE_REG_CMDBUF_IOCTL: %s\n", strerror(errno));
+			return -1;
+		}
+	}
+	elapsed = now_us() - start;
+
+	printf("result cmdbuf_%s %.0f ops/s\n",
+	       op == AIE_REG_WRITE ? "write" : "read",
+	       batches * BATCH * 1e6 / elapsed);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *dev = argc > 1 ? argv[1] : "/dev/aie0";
+	unsigned int iterations = 10000;
+	int devfd, fd, ret = KSFT_FAIL;
+
+	if (argc > 2)
+		iterations = strtoul(argv[2], NULL, 0);
+	if (!iterations)
+		iterations = 1;
+
+	devfd = open(dev, O_RDWR);
+	if (devfd < 0) {
+		printf("# %s: %s\n", dev, strerror(errno));
+		return KSFT_SKIP;
+	}
+
+	fd = request_partition(devfd);
+	if (fd < 0) {
+		printf("# %s: no free partition\n", dev);
+		close(devfd);
+		return KSFT_SKIP;
+	}
+
+	if (!bench_single(fd, AIE_REG_WRITE, iterations) &&
+	    !bench_single(fd, AIE_REG_READ, iterations) &&
+	    !bench_cmdbuf(fd, AIE_REG_WRITE, iterations) &&
+	    !bench_cmdbuf(fd, AIE_REG_READ, iterations))
+		ret = KSFT_PASS;
+
+	close(fd);
+	close(devfd);
+	return ret;
+}
@@ -0,0 +1,282 @@
+#!/bin/bash
+# SPDX-License-Identifier: GPL-2.0
+#
+# Performance regression suite of the Xilinx platform drivers
+#
+# Runs the benchmarks supported by the hardware of the board and appends
+# their results to a file of JSON lines, one per metric, to compare runs on
+# different kernels:
+#
+#   {"test":"dma","name":"dma0chan0/65536/throughput","value":812345,
+#    "unit":"KB/s","kernel":"5.4.0-xilinx"}
+#
+# The benchmarks without the hardware or configuration they need are
+# skipped:
+#
+#   dma    xilinx_dmabench on the memcpy channels and the AXI DMA loopback
+#          pairs of the device tree
+#   net    pktgen transmit rate of the axienet interfaces with a carrier
+#   video  capture frame rate of the xilinx-vipp capture nodes, whose
+#          pipelines are configured beforehand, e.g. with a TPG
+#   aie    AI engine register access throughput
+#   fpga   bitstream load time through the FPGA manager
+#
+# Environment:
+#
+#   XLNX_PERF_OUT        results file (default ./xilinx_perf.jsonl)
+#   XLNX_PERF_TESTS      benchmarks to run (default "dma net video aie fpga")
+#   XLNX_PERF_NET_DST    pktgen destination IPv4 address (default 198.18.0.1)
+#   XLNX_PERF_NET_MAC    pktgen destination MAC address (default broadcast)
+#   XLNX_PERF_NET_COUNT  packets sent per size (default 1000000)
+#   XLNX_PERF_FRAMES     frames captured per video node (default 300)
+#   XLNX_PERF_BITSTREAM  bitstream in /lib/firmware for the fpga benchmark
+
+ksft_skip=4
+
+DIR=$(dirname "$0")
+OUT=${XLNX_PERF_OUT:-./xilinx_perf.jsonl}
+TESTS=${XLNX_PERF_TESTS:-"dma net video aie fpga"}
+KERNEL=$(uname -r)
+
+# record <test> <name> <value> <unit>
+record()
+{
+	local fmt='{"test":"%s","name":"%s","value":%s,'
+
+	fmt+='"unit":"%s","kernel":"%s"}'
+	printf "$fmt\n" "$1" "$2" "$3" "$4" "$KERNEL" >> "$OUT"
+	echo "# $1 $2: $3 $4"
+}
+
+# Record the "result <metric> <value> <unit>" lines of a helper program
+# record_helper <test> <prefix>
+record_helper()
+{
+	local line tag metric value unit
+
+	while read -r line; do
+		read -r tag metric value unit <<< "$line"
+		if [ "$tag" = result ]; then
+			record "$1" "$2/$metric" "$value" "$unit"
+		else
+			echo "$line"
+		fi
+	done
+}
+
+# Merge the result of one run into the result of a benchmark: a failure
+# fails it, a pass passes it unless something failed, a skip changes nothing.
+# merge <result so far> <result of the run>
+merge()
+{
+	if [ "$1" = 1 ] || [ "$2" = "$ksft_skip" ]; then
+		echo "$1"
+	elif [ "$2" = 0 ]; then
+		echo 0
+	else
+		echo 1
+	fi
+}
+
+perf_dma()
+{
+	local max_size=1048576 prev=-1 stable=0 t=0 lines
+
+	if ! modprobe -q -n xilinx_dmabench; then
+		echo "# xilinx_dmabench is not available"
+		return $ksft_skip
+	fi
+
+	modprobe -q -r xilinx_dmabench
+	echo "xilinx_perf: dma start" > /dev/kmsg
+	modprobe xilinx_dmabench duration_ms=500 max_size=$max_size \
+		map_iterations=0 || return 1
+
+	# The channels run their size sweeps in threads, wait for the log
+	# to stop growing.
+	while [ $t -lt 600 ] && [ $stable -lt 3 ]; do
+		sleep 1
+		t=$((t + 1))
+		lines=$(dmesg | sed -n '/xilinx_perf: dma start/,$p' |
+			grep -c -e ' KB/s ' -e 'no memcpy channel')
+		if [ "$lines" = "$prev" ]; then
+			stable=$((stable + 1))
+		else
+			stable=0
+		fi
+		prev=$lines
+	done
+	modprobe -r xilinx_dmabench
+
+	dmesg | sed -n '/xilinx_perf: dma start/,$p' | sed 's/^\[[^]]*\] //' |
+		grep ' KB/s ' > /tmp/xilinx_perf_dma.$$
+	if [ ! -s /tmp/xilinx_perf_dma.$$ ]; then
+		rm -f /tmp/xilinx_perf_dma.$$
+		echo "# no DMA channel to benchmark"
+		return $ksft_skip
+	fi
+
+	# <chan>: size <size> threads <n> depth <n>: <rate> KB/s <n> xfers/s
+	# lat avg <avg> us max <max> us cpu <cpu>% errors <errors>
+	while read -r name _ size _ _ _ _ kbs _ xfers _ _ _ lat _ _ max _ _ \
+		   cpu _ errors; do
+		name=${name%:}
+		record dma "$name/$size/throughput" "$kbs" KB/s
+		record dma "$name/$size/rate" "$xfers" xfers/s
+		record dma "$name/$size/latency_avg" "$lat" us
+		record dma "$name/$size/latency_max" "$max" us
+		record dma "$name/$size/cpu" "${cpu%\%}" %
+		record dma "$name/$size/errors" "$errors" errors
+	done < /tmp/xilinx_perf_dma.$$
+
+	if grep -q 'errors [1-9]' /tmp/xilinx_perf_dma.$$; then
+		rm -f /tmp/xilinx_perf_dma.$$
+		return 1
+	fi
+	rm -f /tmp/xilinx_perf_dma.$$
+	return 0
+}
+
+perf_net()
+{
+	local dst=${XLNX_PERF_NET_DST:-198.18.0.1}
+	local mac=${XLNX_PERF_NET_MAC:-ff:ff:ff:ff:ff:ff}
+	local count=${XLNX_PERF_NET_COUNT:-1000000}
+	local pg=/proc/net/pktgen ret=$ksft_skip
+	local dev ifname drv size res
+	# "<pps>pps <rate>Mb/sec (<bps>bps) errors: <errors>"
+	local pg_result='s/.* \([0-9]*\)pps \([0-9]*\)Mb\/sec'
+	pg_result+='.*errors: \([0-9]*\).*/\1 \2 \3/p'
+
+	if ! modprobe -q pktgen && [ ! -d $pg ]; then
+		echo "# pktgen is not available"
+		return $ksft_skip
+	fi
+
+	for dev in /sys/class/net/*; do
+		ifname=${dev##*/}
+		drv=$(readlink -f "$dev/device/driver" 2>/dev/null)
+		[ "${drv##*/}" = xilinx_axienet ] || continue
+		if [ "$(cat "$dev/carrier" 2>/dev/null)" != 1 ]; then
+			echo "# $ifname has no carrier"
+			continue
+		fi
+
+		for size in 64 1514; do
+			echo "rem_device_all" > $pg/kpktgend_0
+			echo "add_device $ifname" > $pg/kpktgend_0
+			echo "count $count" > "$pg/$ifname"
+			echo "pkt_size $size" > "$pg/$ifname"
+			echo "delay 0" > "$pg/$ifname"
+			echo "dst $dst" > "$pg/$ifname"
+			echo "dst_mac $mac" > "$pg/$ifname"
+			echo "start" > $pg/pgctrl
+
+			res=$(sed -n "$pg_result" "$pg/$ifname")
+			if [ -z "$res" ]; then
+				echo "# $ifname: no pktgen result"
+				ret=1
+				continue
+			fi
+			set -- $res
+			record net "$ifname/tx/$size/rate" "$1" pps
+			record net "$ifname/tx/$size/throughput" "$2" Mb/s
+			record net "$ifname/tx/$size/errors" "$3" errors
+			ret=$(merge $ret 0)
+		done
+		echo "rem_device_all" > $pg/kpktgend_0
+	done
+
+	return $ret
+}
+
+perf_video()
+{
+	local frames=${XLNX_PERF_FRAMES:-300} ret=$ksft_skip node
+
+	for node in /dev/video*; do
+		[ -c "$node" ] || continue
+		"$DIR/xvip_fps" "$node" "$frames" |
+			record_helper video "${node##*/}"
+		ret=$(merge $ret ${PIPESTATUS[0]})
+	done
+
+	return $ret
+}
+
+perf_aie()
+{
+	local ret=$ksft_skip node
+
+	for node in /dev/aie[0-9]*; do
+		[ -c "$node" ] || continue
+		"$DIR/aie_reg_bench" "$node" | record_helper aie "${node##*/}"
+		ret=$(merge $ret ${PIPESTATUS[0]})
+	done
+
+	return $ret
+}
+
+perf_fpga()
+{
+	local mgr=/sys/class/fpga_manager/fpga0 start end
+
+	if [ -z "$XLNX_PERF_BITSTREAM" ]; then
+		echo "# XLNX_PERF_BITSTREAM is not set"
+		return $ksft_skip
+	fi
+	if [ ! -e $mgr/firmware ]; then
+		echo "# no FPGA manager"
+		return $ksft_skip
+	fi
+
+	start=$(date +%s%N)
+	echo "$XLNX_PERF_BITSTREAM" > $mgr/firmware || return 1
+	end=$(date +%s%N)
+
+	if ! grep -q operating $mgr/state; then
+		echo "# ${mgr##*/} state: $(cat $mgr/state)"
+		return 1
+	fi
+	record fpga "${mgr##*/}/load_time" $(((end - start) / 1000)) us
+	return 0
+}
+
+num=0
+failed=0
+
+set -- $TESTS
+echo "TAP version 13"
+echo "1..$#"
+
+if [ "$(id -u)" != 0 ]; then
+	for test in $TESTS; do
+		echo "ok $((++num)) $test # SKIP must be run as root"
+	done
+	exit $ksft_skip
+fi
+
+for test in $TESTS; do
+	num=$((num + 1))
+	if ! type "perf_$test" > /dev/null 2>&1; then
+		echo "not ok $num $test # unknown benchmark"
+		failed=1
+		continue
+	fi
+
+	"perf_$test"
+	case $? in
+	0)
+		echo "ok $num $test"
+		;;
+	$ksft_skip)
+		echo "ok $num $test # SKIP"
+		;;
+	*)
+		echo "not ok $num $test"
+		failed=1
+		;;
+	esac
+done
+
+exit $failed
@@ -0,0 +1,168 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Capture frame rate of a Xilinx video pipeline DMA node
+ *
+ * The pipeline behind the node, e.g. a TPG, is configured beforehand with
+ * media-ctl. The node is streamed with MMAP buffers which are not touched,
+ * and the frame rate and the longest interval between two frames are
+ * printed as "result <metric> <value> <unit>" lines.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/ioctl.h>
+#include <linux/videodev2.h>
+
+#include "../../kselftest.h"
+
+#define NUM_BUFS	4
+#define TIMEOUT_MS	2000
+
+static int xioctl(int fd, unsigned long req, void *arg)
+{
+	int ret;
+
+	do {
+		ret = ioctl(fd, req, arg);
+	} while (ret == -1 && errno == EINTR);
+
+	return ret;
+}
+
+static double now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void init_buf(struct v4l2_buffer *buf, struct v4l2_plane *planes,
+		     enum v4l2_buf_type type, unsigned int index)
+{
+	memset(buf, 0, sizeof(*buf));
+	buf->type = type;
+	buf->memory = V4L2_MEMORY_MMAP;
+	buf->index = index;
+	if (type == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE) {
+		memset(planes, 0, sizeof(*planes) * VIDEO_MAX_PLANES);
+		buf->m.planes = planes;
+		buf->length = VIDEO_MAX_PLANES;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	struct v4l2_plane planes[VIDEO_MAX_PLANES];
+	double first = 0, prev = 0, t, max_gap = 0;
+	struct v4l2_requestbuffers req;
+	struct v4l2_capability cap;
+	unsigned int frames = 100, i;
+	struct v4l2_buffer buf;
+	enum v4l2_buf_type type;
+	struct pollfd pfd;
+	__u32 caps;
+	int fd, ret = KSFT_FAIL;
+
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s <video device> [frames]\n", argv[0]);
+		return KSFT_FAIL;
+	}
+	if (argc > 2)
+		frames = strtoul(argv[2], NULL, 0);
+	if (frames < 2)
+		frames = 2;
+
+	fd = open(argv[1], O_RDWR);
+	if (fd < 0) {
+		printf("# %s: %s\n", argv[1], strerror(errno));
+		return KSFT_SKIP;
+	}
+
+	if (xioctl(fd, VIDIOC_QUERYCAP, &cap) ||
+	    strcmp((char *)cap.driver, "xilinx-vipp")) {
+		printf("# %s: not a Xilinx video pipeline node\n", argv[1]);
+		ret = KSFT_SKIP;
+		goto out;
+	}
+
+	caps = cap.capabilities & V4L2_CAP_DEVICE_CAPS ? cap.device_caps :
+							   cap.capabilities;
+	if (caps & V4L2_CAP_VIDEO_CAPTURE_MPLANE) {
+		type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+	} else if (caps & V4L2_CAP_VIDEO_CAPTURE) {
+		type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	} else {
+		printf("# %s: not a capture node\n", argv[1]);
+		ret = KSFT_SKIP;
+		goto out;
+	}
+
+	memset(&req, 0, sizeof(req));
+	req.count = NUM_BUFS;
+	req.type = type;
+	req.memory = V4L2_MEMORY_MMAP;
+	if (xioctl(fd, VIDIOC_REQBUFS, &req) || !req.count) {
+		printf("# REQBUFS: %s\n", strerror(errno));
+		goto out;
+	}
+
+	for (i = 0; i < req.count; i++) {
+		init_buf(&buf, planes, type, i);
+		if (xioctl(fd, VIDIOC_QBUF, &buf)) {
+			printf("# QBUF: %s\n", strerror(errno));
+			goto out;
+		}
+	}
+
+	if (xioctl(fd, VIDIOC_STREAMON, &type)) {
+		printf("# STREAMON: %s, is the pipeline configured?\n",
+		       strerror(errno));
+		ret = KSFT_SKIP;
+		goto out;
+	}
+
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	for (i = 0; i < frames; i++) {
+		if (poll(&pfd, 1, TIMEOUT_MS) <= 0) {
+			printf("# no frame after %u ms\n", TIMEOUT_MS);
+			goto stop;
+		}
+
+		init_buf(&buf, planes, type, 0);
+		if (xioctl(fd, VIDIOC_DQBUF, &buf)) {
+			printf("# DQBUF: %s\n", strerror(errno));
+			goto stop;
+		}
+
+		/* The first frame includes the pipeline start */
+		t = now_us();
+		if (!i)
+			first = t;
+		else if (t - prev > max_gap)
+			max_gap = t - prev;
+		prev = t;
+
+		if (xioctl(fd, VIDIOC_QBUF, &buf)) {
+			printf("# QBUF: %s\n", strerror(errno));
+			goto stop;
+		}
+	}
+
+	printf("result fps %.2f fps\n", (frames - 1) * 1e6 / (prev - first));
+	printf("result max_frame_interval %.0f us\n", max_gap);
+	ret = KSFT_PASS;
+
+stop:
+	xioctl(fd, VIDIOC_STREAMOFF, &type);
+out:
+	close(fd);
+	return ret;
+}